@@ -0,0 +1,491 @@
+/**
+ * @file bpf.c
+ * @brief Classic BPF packet filter
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A filter program is a sequence of classic BPF instructions operating on
+ * an accumulator, an index register and a small scratch memory. It is run
+ * against each received packet and returns the number of bytes of the
+ * packet that should be accepted (0 meaning that the packet is dropped)
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL RAW_SOCKET_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "core/bpf.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (SOCKET_FILTER_SUPPORT == ENABLED)
+
+
+/**
+ * @brief Check whether a filter program is safe to run
+ *
+ * The program must end with a return instruction, every opcode must be
+ * known, jumps must land inside the program and scratch memory accesses
+ * must stay within bounds. Loops are impossible since jumps are forward
+ * only
+ *
+ * @param[in] insns Pointer to the filter program
+ * @param[in] count Number of instructions
+ * @return Error code
+ **/
+
+error_t bpfCheckProgram(const BpfInsn *insns, uint_t count)
+{
+   uint_t pc;
+   const BpfInsn *insn;
+
+   //Check parameters
+   if(insns == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Check the length of the program
+   if(count == 0 || count > BPF_MAX_INSNS)
+      return ERROR_INVALID_LENGTH;
+
+   //Loop through the instructions
+   for(pc = 0; pc < count; pc++)
+   {
+      //Point to the current instruction
+      insn = &insns[pc];
+
+      //Check opcode
+      switch(insn->code)
+      {
+      //Packet loads and register operations
+      case BPF_LD | BPF_W | BPF_ABS:
+      case BPF_LD | BPF_H | BPF_ABS:
+      case BPF_LD | BPF_B | BPF_ABS:
+      case BPF_LD | BPF_W | BPF_IND:
+      case BPF_LD | BPF_H | BPF_IND:
+      case BPF_LD | BPF_B | BPF_IND:
+      case BPF_LD | BPF_W | BPF_LEN:
+      case BPF_LD | BPF_IMM:
+      case BPF_LDX | BPF_W | BPF_IMM:
+      case BPF_LDX | BPF_W | BPF_LEN:
+      case BPF_LDX | BPF_B | BPF_MSH:
+      case BPF_ALU | BPF_ADD | BPF_K:
+      case BPF_ALU | BPF_SUB | BPF_K:
+      case BPF_ALU | BPF_MUL | BPF_K:
+      case BPF_ALU | BPF_OR | BPF_K:
+      case BPF_ALU | BPF_AND | BPF_K:
+      case BPF_ALU | BPF_XOR | BPF_K:
+      case BPF_ALU | BPF_ADD | BPF_X:
+      case BPF_ALU | BPF_SUB | BPF_X:
+      case BPF_ALU | BPF_MUL | BPF_X:
+      case BPF_ALU | BPF_DIV | BPF_X:
+      case BPF_ALU | BPF_MOD | BPF_X:
+      case BPF_ALU | BPF_OR | BPF_X:
+      case BPF_ALU | BPF_AND | BPF_X:
+      case BPF_ALU | BPF_XOR | BPF_X:
+      case BPF_ALU | BPF_LSH | BPF_X:
+      case BPF_ALU | BPF_RSH | BPF_X:
+      case BPF_ALU | BPF_NEG:
+      case BPF_RET | BPF_K:
+      case BPF_RET | BPF_A:
+      case BPF_MISC | BPF_TAX:
+      case BPF_MISC | BPF_TXA:
+         break;
+
+      //Scratch memory accesses
+      case BPF_LD | BPF_MEM:
+      case BPF_LDX | BPF_W | BPF_MEM:
+      case BPF_ST:
+      case BPF_STX:
+         //The index must refer to a valid memory word
+         if(insn->k >= BPF_MEMWORDS)
+            return ERROR_INVALID_PARAMETER;
+         break;
+
+      //Division by a constant
+      case BPF_ALU | BPF_DIV | BPF_K:
+      case BPF_ALU | BPF_MOD | BPF_K:
+         //Division by zero is rejected up front
+         if(insn->k == 0)
+            return ERROR_INVALID_PARAMETER;
+         break;
+
+      //Shift by a constant
+      case BPF_ALU | BPF_LSH | BPF_K:
+      case BPF_ALU | BPF_RSH | BPF_K:
+         //The shift count must be less than the register width
+         if(insn->k >= 32)
+            return ERROR_INVALID_PARAMETER;
+         break;
+
+      //Unconditional jump
+      case BPF_JMP | BPF_JA:
+         //The target must lie within the program
+         if(insn->k >= (count - pc - 1))
+            return ERROR_INVALID_PARAMETER;
+         break;
+
+      //Conditional jumps
+      case BPF_JMP | BPF_JEQ | BPF_K:
+      case BPF_JMP | BPF_JGT | BPF_K:
+      case BPF_JMP | BPF_JGE | BPF_K:
+      case BPF_JMP | BPF_JSET | BPF_K:
+      case BPF_JMP | BPF_JEQ | BPF_X:
+      case BPF_JMP | BPF_JGT | BPF_X:
+      case BPF_JMP | BPF_JGE | BPF_X:
+      case BPF_JMP | BPF_JSET | BPF_X:
+         //Both targets must lie within the program
+         if(insn->jt >= (count - pc - 1) || insn->jf >= (count - pc - 1))
+            return ERROR_INVALID_PARAMETER;
+         break;
+
+      //Unknown opcode
+      default:
+         return ERROR_INVALID_PARAMETER;
+      }
+   }
+
+   //The last instruction must be a return instruction
+   if(BPF_CLASS(insns[count - 1].code) != BPF_RET)
+      return ERROR_INVALID_PARAMETER;
+
+   //The filter program is valid
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Load a word, half-word or byte from the packet
+ * @param[in] buffer Multi-part buffer containing the packet
+ * @param[in] offset Offset to the first byte of the packet
+ * @param[in] length Length of the packet, in bytes
+ * @param[in] pos Position of the data within the packet
+ * @param[in] size Number of bytes to load (1, 2 or 4)
+ * @param[out] value Value read from the packet, in host byte order
+ * @return TRUE if the data lies within the packet, else FALSE
+ **/
+
+bool_t bpfLoad(const NetBuffer *buffer, size_t offset, size_t length,
+   uint32_t pos, uint_t size, uint32_t *value)
+{
+   uint8_t temp[4];
+
+   //Out-of-bounds accesses cause the packet to be rejected
+   if(pos >= length || size > (length - pos))
+      return FALSE;
+
+   //Copy the data, which may straddle two chunks
+   netBufferRead(temp, buffer, offset + pos, size);
+
+   //Convert the value from network byte order
+   if(size == sizeof(uint32_t))
+   {
+      *value = LOAD32BE(temp);
+   }
+   else if(size == sizeof(uint16_t))
+   {
+      *value = LOAD16BE(temp);
+   }
+   else
+   {
+      *value = temp[0];
+   }
+
+   //Successful processing
+   return TRUE;
+}
+
+
+/**
+ * @brief Run a filter program against a packet
+ *
+ * The program must have been validated with bpfCheckProgram() beforehand
+ *
+ * @param[in] insns Pointer to the filter program
+ * @param[in] buffer Multi-part buffer containing the packet
+ * @param[in] offset Offset to the first byte of the packet
+ * @param[in] length Length of the packet, in bytes
+ * @return Number of bytes to accept (0 if the packet is to be dropped)
+ **/
+
+uint32_t bpfRunProgram(const BpfInsn *insns, const NetBuffer *buffer,
+   size_t offset, size_t length)
+{
+   uint_t pc;
+   uint_t size;
+   uint32_t a;
+   uint32_t x;
+   uint32_t pos;
+   uint32_t mem[BPF_MEMWORDS];
+   const BpfInsn *insn;
+
+   //Initialize registers
+   a = 0;
+   x = 0;
+
+   //Clear scratch memory
+   osMemset(mem, 0, sizeof(mem));
+
+   //Execute the program until a return instruction is reached
+   for(pc = 0; ; pc++)
+   {
+      //Point to the current instruction
+      insn = &insns[pc];
+
+      //Check opcode
+      switch(insn->code)
+      {
+      case BPF_LD | BPF_W | BPF_ABS:
+      case BPF_LD | BPF_H | BPF_ABS:
+      case BPF_LD | BPF_B | BPF_ABS:
+      case BPF_LD | BPF_W | BPF_IND:
+      case BPF_LD | BPF_H | BPF_IND:
+      case BPF_LD | BPF_B | BPF_IND:
+         //Determine the size of the operand
+         if(BPF_SIZE(insn->code) == BPF_W)
+         {
+            size = sizeof(uint32_t);
+         }
+         else if(BPF_SIZE(insn->code) == BPF_H)
+         {
+            size = sizeof(uint16_t);
+         }
+         else
+         {
+            size = sizeof(uint8_t);
+         }
+
+         //Compute the position of the operand
+         if(BPF_MODE(insn->code) == BPF_IND)
+         {
+            pos = x + insn->k;
+
+            //Reject arithmetic overflows
+            if(pos < x)
+               return 0;
+         }
+         else
+         {
+            pos = insn->k;
+         }
+
+         //Load the operand from the packet
+         if(!bpfLoad(buffer, offset, length, pos, size, &a))
+            return 0;
+         break;
+
+      case BPF_LD | BPF_W | BPF_LEN:
+         a = (uint32_t) length;
+         break;
+
+      case BPF_LD | BPF_IMM:
+         a = insn->k;
+         break;
+
+      case BPF_LD | BPF_MEM:
+         a = mem[insn->k];
+         break;
+
+      case BPF_LDX | BPF_W | BPF_IMM:
+         x = insn->k;
+         break;
+
+      case BPF_LDX | BPF_W | BPF_LEN:
+         x = (uint32_t) length;
+         break;
+
+      case BPF_LDX | BPF_W | BPF_MEM:
+         x = mem[insn->k];
+         break;
+
+      case BPF_LDX | BPF_B | BPF_MSH:
+         //Retrieve the length of the IPv4 header
+         if(!bpfLoad(buffer, offset, length, insn->k, sizeof(uint8_t), &x))
+            return 0;
+
+         x = (x & 0x0F) * 4;
+         break;
+
+      case BPF_ST:
+         mem[insn->k] = a;
+         break;
+
+      case BPF_STX:
+         mem[insn->k] = x;
+         break;
+
+      case BPF_ALU | BPF_ADD | BPF_K:
+         a += insn->k;
+         break;
+
+      case BPF_ALU | BPF_SUB | BPF_K:
+         a -= insn->k;
+         break;
+
+      case BPF_ALU | BPF_MUL | BPF_K:
+         a *= insn->k;
+         break;
+
+      case BPF_ALU | BPF_DIV | BPF_K:
+         a /= insn->k;
+         break;
+
+      case BPF_ALU | BPF_MOD | BPF_K:
+         a %= insn->k;
+         break;
+
+      case BPF_ALU | BPF_OR | BPF_K:
+         a |= insn->k;
+         break;
+
+      case BPF_ALU | BPF_AND | BPF_K:
+         a &= insn->k;
+         break;
+
+      case BPF_ALU | BPF_XOR | BPF_K:
+         a ^= insn->k;
+         break;
+
+      case BPF_ALU | BPF_LSH | BPF_K:
+         a <<= insn->k;
+         break;
+
+      case BPF_ALU | BPF_RSH | BPF_K:
+         a >>= insn->k;
+         break;
+
+      case BPF_ALU | BPF_ADD | BPF_X:
+         a += x;
+         break;
+
+      case BPF_ALU | BPF_SUB | BPF_X:
+         a -= x;
+         break;
+
+      case BPF_ALU | BPF_MUL | BPF_X:
+         a *= x;
+         break;
+
+      case BPF_ALU | BPF_DIV | BPF_X:
+         //Division by zero causes the packet to be rejected
+         if(x == 0)
+            return 0;
+
+         a /= x;
+         break;
+
+      case BPF_ALU | BPF_MOD | BPF_X:
+         //Division by zero causes the packet to be rejected
+         if(x == 0)
+            return 0;
+
+         a %= x;
+         break;
+
+      case BPF_ALU | BPF_OR | BPF_X:
+         a |= x;
+         break;
+
+      case BPF_ALU | BPF_AND | BPF_X:
+         a &= x;
+         break;
+
+      case BPF_ALU | BPF_XOR | BPF_X:
+         a ^= x;
+         break;
+
+      case BPF_ALU | BPF_LSH | BPF_X:
+         a = (x < 32) ? (a << x) : 0;
+         break;
+
+      case BPF_ALU | BPF_RSH | BPF_X:
+         a = (x < 32) ? (a >> x) : 0;
+         break;
+
+      case BPF_ALU | BPF_NEG:
+         a = (uint32_t) -(int32_t) a;
+         break;
+
+      case BPF_JMP | BPF_JA:
+         pc += insn->k;
+         break;
+
+      case BPF_JMP | BPF_JEQ | BPF_K:
+         pc += (a == insn->k) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_JMP | BPF_JGT | BPF_K:
+         pc += (a > insn->k) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_JMP | BPF_JGE | BPF_K:
+         pc += (a >= insn->k) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_JMP | BPF_JSET | BPF_K:
+         pc += ((a & insn->k) != 0) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_JMP | BPF_JEQ | BPF_X:
+         pc += (a == x) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_JMP | BPF_JGT | BPF_X:
+         pc += (a > x) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_JMP | BPF_JGE | BPF_X:
+         pc += (a >= x) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_JMP | BPF_JSET | BPF_X:
+         pc += ((a & x) != 0) ? insn->jt : insn->jf;
+         break;
+
+      case BPF_RET | BPF_K:
+         return insn->k;
+
+      case BPF_RET | BPF_A:
+         return a;
+
+      case BPF_MISC | BPF_TAX:
+         x = a;
+         break;
+
+      case BPF_MISC | BPF_TXA:
+         a = x;
+         break;
+
+      default:
+         //This should never occur with a validated program...
+         return 0;
+      }
+   }
+}
+
+#endif
@@ -1696,6 +1696,11 @@ int_t setsockopt(int_t s, int_t level, int_t optname, const void *optval,
             //Set SO_REUSEADDR option
             ret = socketSetSoReuseAddrOption(sock, optval, optlen);
          }
+         else if(optname == SO_REUSEPORT)
+         {
+            //Set SO_REUSEPORT option
+            ret = socketSetSoReusePortOption(sock, optval, optlen);
+         }
          else if(optname == SO_BROADCAST)
          {
             //Set SO_BROADCAST option
@@ -1731,6 +1736,16 @@ int_t setsockopt(int_t s, int_t level, int_t optname, const void *optval,
             //Set SO_NO_CHECK option
             ret = socketSetSoNoCheckOption(sock, optval, optlen);
          }
+         else if(optname == SO_ATTACH_FILTER)
+         {
+            //Set SO_ATTACH_FILTER option
+            ret = socketSetSoAttachFilterOption(sock, optval, optlen);
+         }
+         else if(optname == SO_DETACH_FILTER)
+         {
+            //Set SO_DETACH_FILTER option
+            ret = socketSetSoDetachFilterOption(sock, optval, optlen);
+         }
          else
          {
             //Unknown option
@@ -1982,6 +1997,16 @@ int_t setsockopt(int_t s, int_t level, int_t optname, const void *optval,
             //Set TCP_KEEPCNT option
             ret = socketSetTcpKeepCntOption(sock, optval, optlen);
          }
+         else if(optname == TCP_QUICKACK)
+         {
+            //Set TCP_QUICKACK option
+            ret = socketSetTcpQuickAckOption(sock, optval, optlen);
+         }
+         else if(optname == TCP_FASTOPEN)
+         {
+            //Set TCP_FASTOPEN option
+            ret = socketSetTcpFastOpenOption(sock, optval, optlen);
+         }
          else
          {
             //Unknown option
@@ -2051,6 +2076,11 @@ int_t getsockopt(int_t s, int_t level, int_t optname, void *optval,
             //Get SO_REUSEADDR option
             ret = socketGetSoReuseAddrOption(sock, optval, optlen);
          }
+         else if(optname == SO_REUSEPORT)
+         {
+            //Get SO_REUSEPORT option
+            ret = socketGetSoReusePortOption(sock, optval, optlen);
+         }
          else if(optname == SO_TYPE)
          {
             //Get SO_TYPE option
@@ -2268,6 +2298,16 @@ int_t getsockopt(int_t s, int_t level, int_t optname, void *optval,
             //Get TCP_KEEPCNT option
             ret = socketGetTcpKeepCntOption(sock, optval, optlen);
          }
+         else if(optname == TCP_QUICKACK)
+         {
+            //Get TCP_QUICKACK option
+            ret = socketGetTcpQuickAckOption(sock, optval, optlen);
+         }
+         else if(optname == TCP_FASTOPEN)
+         {
+            //Get TCP_FASTOPEN option
+            ret = socketGetTcpFastOpenOption(sock, optval, optlen);
+         }
          else
          {
             //Unknown option
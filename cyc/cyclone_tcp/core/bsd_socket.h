@@ -144,9 +144,12 @@
 #define SO_KEEPALIVE    9
 #define SO_NO_CHECK     11
 #define SO_LINGER       13
+#define SO_REUSEPORT    15
 #define SO_SNDTIMEO     20
 #define SO_RCVTIMEO     21
 #define SO_BINDTODEVICE 25
+#define SO_ATTACH_FILTER 26
+#define SO_DETACH_FILTER 27
 #define SO_ACCEPTCONN   30
 
 //IP level options
@@ -194,6 +197,8 @@
 #define TCP_KEEPIDLE  4
 #define TCP_KEEPINTVL 5
 #define TCP_KEEPCNT   6
+#define TCP_QUICKACK  12
+#define TCP_FASTOPEN  23
 
 //IP TOS option
 #define IPTOS_LOWDELAY    0x10
@@ -461,6 +466,17 @@ typedef struct linger
 } LINGER, *PLINGER;
 
 
+/**
+ * @brief Packet filter program
+ **/
+
+typedef struct sock_fprog
+{
+   uint16_t len;
+   BpfInsn *filter;
+} SOCK_FPROG, *PSOCK_FPROG;
+
+
 /**
  * @brief Scatter/gather array
  **/
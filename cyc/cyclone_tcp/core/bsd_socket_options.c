@@ -94,6 +94,62 @@ int_t socketSetSoReuseAddrOption(Socket *socket, const int_t *optval,
 }
 
 
+/**
+ * @brief Set SO_REUSEPORT option
+ * @param[in] socket Handle referencing the socket
+ * @param[in] optval A pointer to the buffer in which the value for the
+ *   requested option is specified
+ * @param[in] optlen The size, in bytes, of the buffer pointed to by the optval
+ *   parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketSetSoReusePortOption(Socket *socket, const int_t *optval,
+   socklen_t optlen)
+{
+   int_t ret;
+
+#if (TCP_SUPPORT == ENABLED && TCP_REUSE_PORT_SUPPORT == ENABLED)
+   //Check the length of the option
+   if(optlen >= (socklen_t) sizeof(int_t))
+   {
+      //Get exclusive access
+      osAcquireMutex(&netMutex);
+
+      //This option specifies whether several listening sockets can share
+      //the same port
+      if(*optval != 0)
+      {
+         socket->options |= SOCKET_OPTION_REUSE_PORT;
+      }
+      else
+      {
+         socket->options &= ~SOCKET_OPTION_REUSE_PORT;
+      }
+
+      //Release exclusive access
+      osReleaseMutex(&netMutex);
+
+      //Successful processing
+      ret = SOCKET_SUCCESS;
+   }
+   else
+   {
+      //The option length is not valid
+      socketSetErrnoCode(socket, EFAULT);
+      ret = SOCKET_ERROR;
+   }
+#else
+   //Listening socket groups are not supported
+   socketSetErrnoCode(socket, ENOPROTOOPT);
+   ret = SOCKET_ERROR;
+#endif
+
+   //Return status code
+   return ret;
+}
+
+
 /**
  * @brief Set SO_BROADCAST option
  * @param[in] socket Handle referencing the socket
@@ -395,6 +451,104 @@ int_t socketSetSoNoCheckOption(Socket *socket, const int_t *optval,
 }
 
 
+/**
+ * @brief Set SO_ATTACH_FILTER option
+ * @param[in] socket Handle referencing the socket
+ * @param[in] optval A pointer to the buffer in which the value for the
+ *   requested option is specified
+ * @param[in] optlen The size, in bytes, of the buffer pointed to by the optval
+ *   parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketSetSoAttachFilterOption(Socket *socket,
+   const struct sock_fprog *optval, socklen_t optlen)
+{
+   int_t ret;
+
+#if (RAW_SOCKET_SUPPORT == ENABLED && SOCKET_FILTER_SUPPORT == ENABLED)
+   error_t error;
+
+   //Check the length of the option
+   if(optlen >= (socklen_t) sizeof(struct sock_fprog))
+   {
+      //Attach the filter program to the socket
+      error = socketAttachFilter(socket, optval->filter, optval->len);
+
+      //Check status code
+      if(!error)
+      {
+         //Successful processing
+         ret = SOCKET_SUCCESS;
+      }
+      else
+      {
+         //The filter program is not valid
+         socketSetErrnoCode(socket, EINVAL);
+         ret = SOCKET_ERROR;
+      }
+   }
+   else
+   {
+      //The option length is not valid
+      socketSetErrnoCode(socket, EFAULT);
+      ret = SOCKET_ERROR;
+   }
+#else
+   //Packet filters are not supported
+   socketSetErrnoCode(socket, ENOPROTOOPT);
+   ret = SOCKET_ERROR;
+#endif
+
+   //Return status code
+   return ret;
+}
+
+
+/**
+ * @brief Set SO_DETACH_FILTER option
+ * @param[in] socket Handle referencing the socket
+ * @param[in] optval A pointer to the buffer in which the value for the
+ *   requested option is specified (ignored)
+ * @param[in] optlen The size, in bytes, of the buffer pointed to by the optval
+ *   parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketSetSoDetachFilterOption(Socket *socket, const void *optval,
+   socklen_t optlen)
+{
+   int_t ret;
+
+#if (RAW_SOCKET_SUPPORT == ENABLED && SOCKET_FILTER_SUPPORT == ENABLED)
+   error_t error;
+
+   //Remove the filter program attached to the socket
+   error = socketDetachFilter(socket);
+
+   //Check status code
+   if(!error)
+   {
+      //Successful processing
+      ret = SOCKET_SUCCESS;
+   }
+   else
+   {
+      //No filter is attached to the socket
+      socketSetErrnoCode(socket, EINVAL);
+      ret = SOCKET_ERROR;
+   }
+#else
+   //Packet filters are not supported
+   socketSetErrnoCode(socket, ENOPROTOOPT);
+   ret = SOCKET_ERROR;
+#endif
+
+   //Return status code
+   return ret;
+}
+
+
 /**
  * @brief Set IP_TOS option
  * @param[in] socket Handle referencing the socket
@@ -2516,6 +2670,116 @@ int_t socketSetTcpKeepCntOption(Socket *socket, const int_t *optval,
 }
 
 
+/**
+ * @brief Set TCP_QUICKACK option
+ * @param[in] socket Handle referencing the socket
+ * @param[in] optval A pointer to the buffer in which the value for the
+ *   requested option is specified
+ * @param[in] optlen The size, in bytes, of the buffer pointed to by the optval
+ *   parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketSetTcpQuickAckOption(Socket *socket, const int_t *optval,
+   socklen_t optlen)
+{
+   int_t ret;
+
+#if (TCP_SUPPORT == ENABLED)
+   //Check the length of the option
+   if(optlen >= (socklen_t) sizeof(int_t))
+   {
+      //Get exclusive access
+      osAcquireMutex(&netMutex);
+
+      //The option enables or disables the quick ACK mode for TCP sockets
+      if(*optval != 0)
+      {
+         socket->options |= SOCKET_OPTION_TCP_QUICK_ACK;
+      }
+      else
+      {
+         socket->options &= ~SOCKET_OPTION_TCP_QUICK_ACK;
+      }
+
+      //Release exclusive access
+      osReleaseMutex(&netMutex);
+
+      //Successful processing
+      ret = SOCKET_SUCCESS;
+   }
+   else
+   {
+      //The option length is not valid
+      socketSetErrnoCode(socket, EFAULT);
+      ret = SOCKET_ERROR;
+   }
+#else
+   //TCP is not supported
+   socketSetErrnoCode(socket, ENOPROTOOPT);
+   ret = SOCKET_ERROR;
+#endif
+
+   //Return status code
+   return ret;
+}
+
+
+/**
+ * @brief Set TCP_FASTOPEN option
+ * @param[in] socket Handle referencing the socket
+ * @param[in] optval A pointer to the buffer in which the value for the
+ *   requested option is specified
+ * @param[in] optlen The size, in bytes, of the buffer pointed to by the optval
+ *   parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketSetTcpFastOpenOption(Socket *socket, const int_t *optval,
+   socklen_t optlen)
+{
+   int_t ret;
+
+#if (TCP_SUPPORT == ENABLED && TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //Check the length of the option
+   if(optlen >= (socklen_t) sizeof(int_t))
+   {
+      //Get exclusive access
+      osAcquireMutex(&netMutex);
+
+      //The option enables or disables TCP Fast Open for TCP sockets
+      if(*optval != 0)
+      {
+         socket->options |= SOCKET_OPTION_TCP_FAST_OPEN;
+      }
+      else
+      {
+         socket->options &= ~SOCKET_OPTION_TCP_FAST_OPEN;
+      }
+
+      //Release exclusive access
+      osReleaseMutex(&netMutex);
+
+      //Successful processing
+      ret = SOCKET_SUCCESS;
+   }
+   else
+   {
+      //The option length is not valid
+      socketSetErrnoCode(socket, EFAULT);
+      ret = SOCKET_ERROR;
+   }
+#else
+   //TCP Fast Open is not supported
+   socketSetErrnoCode(socket, ENOPROTOOPT);
+   ret = SOCKET_ERROR;
+#endif
+
+   //Return status code
+   return ret;
+}
+
+
 /**
  * @brief Get SO_REUSEADDR option
  * @param[in] socket Handle referencing the socket
@@ -2563,6 +2827,53 @@ int_t socketGetSoReuseAddrOption(Socket *socket, int_t *optval,
 }
 
 
+/**
+ * @brief Get SO_REUSEPORT option
+ * @param[in] socket Handle referencing the socket
+ * @param[out] optval A pointer to the buffer in which the value for the
+ *   requested option is to be returned
+ * @param[in,out] optlen The size, in bytes, of the buffer pointed to by the
+ *   optval parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketGetSoReusePortOption(Socket *socket, int_t *optval,
+   socklen_t *optlen)
+{
+   int_t ret;
+
+   //Check the length of the option
+   if(*optlen >= (socklen_t) sizeof(int_t))
+   {
+      //This option specifies whether several listening sockets can share
+      //the same port
+      if((socket->options & SOCKET_OPTION_REUSE_PORT) != 0)
+      {
+         *optval = TRUE;
+      }
+      else
+      {
+         *optval = FALSE;
+      }
+
+      //Return the actual length of the option
+      *optlen = sizeof(int_t);
+
+      //Successful processing
+      ret = SOCKET_SUCCESS;
+   }
+   else
+   {
+      //The option length is not valid
+      socketSetErrnoCode(socket, EFAULT);
+      ret = SOCKET_ERROR;
+   }
+
+   //Return status code
+   return ret;
+}
+
+
 /**
  * @brief Get SO_TYPE option
  * @param[in] socket Handle referencing the socket
@@ -4058,4 +4369,108 @@ int_t socketGetTcpKeepCntOption(Socket *socket, int_t *optval,
    return ret;
 }
 
+
+/**
+ * @brief Get TCP_QUICKACK option
+ * @param[in] socket Handle referencing the socket
+ * @param[out] optval A pointer to the buffer in which the value for the
+ *   requested option is to be returned
+ * @param[in,out] optlen The size, in bytes, of the buffer pointed to by the
+ *   optval parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketGetTcpQuickAckOption(Socket *socket, int_t *optval,
+   socklen_t *optlen)
+{
+   int_t ret;
+
+#if (TCP_SUPPORT == ENABLED)
+   //Check the length of the option
+   if(*optlen >= (socklen_t) sizeof(int_t))
+   {
+      //The option enables or disables the quick ACK mode for TCP sockets
+      if((socket->options & SOCKET_OPTION_TCP_QUICK_ACK) != 0)
+      {
+         *optval = TRUE;
+      }
+      else
+      {
+         *optval = FALSE;
+      }
+
+      //Return the actual length of the option
+      *optlen = sizeof(int_t);
+
+      //Successful processing
+      ret = SOCKET_SUCCESS;
+   }
+   else
+   {
+      //The option length is not valid
+      socketSetErrnoCode(socket, EFAULT);
+      ret = SOCKET_ERROR;
+   }
+#else
+   //TCP is not supported
+   socketSetErrnoCode(socket, ENOPROTOOPT);
+   ret = SOCKET_ERROR;
+#endif
+
+   //Return status code
+   return ret;
+}
+
+
+/**
+ * @brief Get TCP_FASTOPEN option
+ * @param[in] socket Handle referencing the socket
+ * @param[out] optval A pointer to the buffer in which the value for the
+ *   requested option is to be returned
+ * @param[in,out] optlen The size, in bytes, of the buffer pointed to by the
+ *   optval parameter
+ * @return Error code (SOCKET_SUCCESS or SOCKET_ERROR)
+ **/
+
+int_t socketGetTcpFastOpenOption(Socket *socket, int_t *optval,
+   socklen_t *optlen)
+{
+   int_t ret;
+
+#if (TCP_SUPPORT == ENABLED && TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //Check the length of the option
+   if(*optlen >= (socklen_t) sizeof(int_t))
+   {
+      //The option enables or disables TCP Fast Open for TCP sockets
+      if((socket->options & SOCKET_OPTION_TCP_FAST_OPEN) != 0)
+      {
+         *optval = TRUE;
+      }
+      else
+      {
+         *optval = FALSE;
+      }
+
+      //Return the actual length of the option
+      *optlen = sizeof(int_t);
+
+      //Successful processing
+      ret = SOCKET_SUCCESS;
+   }
+   else
+   {
+      //The option length is not valid
+      socketSetErrnoCode(socket, EFAULT);
+      ret = SOCKET_ERROR;
+   }
+#else
+   //TCP Fast Open is not supported
+   socketSetErrnoCode(socket, ENOPROTOOPT);
+   ret = SOCKET_ERROR;
+#endif
+
+   //Return status code
+   return ret;
+}
+
 #endif
@@ -44,6 +44,9 @@ extern "C" {
 int_t socketSetSoReuseAddrOption(Socket *socket, const int_t *optval,
    socklen_t optlen);
 
+int_t socketSetSoReusePortOption(Socket *socket, const int_t *optval,
+   socklen_t optlen);
+
 int_t socketSetSoBroadcastOption(Socket *socket, const int_t *optval,
    socklen_t optlen);
 
@@ -65,6 +68,12 @@ int_t socketSetSoKeepAliveOption(Socket *socket, const int_t *optval,
 int_t socketSetSoNoCheckOption(Socket *socket, const int_t *optval,
    socklen_t optlen);
 
+int_t socketSetSoAttachFilterOption(Socket *socket,
+   const struct sock_fprog *optval, socklen_t optlen);
+
+int_t socketSetSoDetachFilterOption(Socket *socket, const void *optval,
+   socklen_t optlen);
+
 int_t socketSetIpTosOption(Socket *socket, const int_t *optval,
    socklen_t optlen);
 
@@ -179,9 +188,18 @@ int_t socketSetTcpKeepIntvlOption(Socket *socket, const int_t *optval,
 int_t socketSetTcpKeepCntOption(Socket *socket, const int_t *optval,
    socklen_t optlen);
 
+int_t socketSetTcpQuickAckOption(Socket *socket, const int_t *optval,
+   socklen_t optlen);
+
+int_t socketSetTcpFastOpenOption(Socket *socket, const int_t *optval,
+   socklen_t optlen);
+
 int_t socketGetSoReuseAddrOption(Socket *socket, int_t *optval,
    socklen_t *optlen);
 
+int_t socketGetSoReusePortOption(Socket *socket, int_t *optval,
+   socklen_t *optlen);
+
 int_t socketGetSoTypeOption(Socket *socket, int_t *optval,
    socklen_t *optlen);
 
@@ -275,6 +293,12 @@ int_t socketGetTcpKeepIntvlOption(Socket *socket, int_t *optval,
 int_t socketGetTcpKeepCntOption(Socket *socket, int_t *optval,
    socklen_t *optlen);
 
+int_t socketGetTcpQuickAckOption(Socket *socket, int_t *optval,
+   socklen_t *optlen);
+
+int_t socketGetTcpFastOpenOption(Socket *socket, int_t *optval,
+   socklen_t *optlen);
+
 //C++ guard
 #ifdef __cplusplus
 }
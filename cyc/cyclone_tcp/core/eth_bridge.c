@@ -0,0 +1,585 @@
+/**
+ * @file eth_bridge.c
+ * @brief Software Ethernet bridge
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * The bridge relays frames between several physical interfaces that have
+ * no hardware switch in between. Source addresses are learned in a hashed
+ * filtering database, known unicast destinations are forwarded to a single
+ * port and other frames are flooded. Refer to IEEE 802.1D for more details
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL ETH_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "core/ethernet.h"
+#include "core/ethernet_misc.h"
+#include "core/eth_bridge.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (ETH_SUPPORT == ENABLED && ETH_BRIDGE_SUPPORT == ENABLED)
+
+//Bridge filtered MAC group addresses (01-80-C2-00-00-00 to 01-80-C2-00-00-0F)
+const MacAddr ETH_BRIDGE_RESERVED_ADDR = {{{0x01, 0x80, 0xC2, 0x00, 0x00, 0x00}}};
+
+
+/**
+ * @brief Initialize settings with default values
+ * @param[out] settings Structure that contains bridge settings
+ **/
+
+void ethBridgeGetDefaultSettings(EthBridgeSettings *settings)
+{
+   //Number of ports
+   settings->numPorts = 0;
+   //Ports
+   settings->ports = NULL;
+
+   //Size of the filtering database
+   settings->numFdbEntries = 0;
+   //Filtering database
+   settings->fdbEntries = NULL;
+
+   //Aging time for dynamic entries
+   settings->agingTime = ETH_BRIDGE_DEFAULT_AGING_TIME;
+}
+
+
+/**
+ * @brief Bridge initialization
+ *
+ * The ports must be physical interfaces. They should be placed in
+ * promiscuous mode (refer to netEnablePromiscuousMode) before they are
+ * configured, so that frames destined to other stations are received
+ *
+ * @param[in] context Pointer to the bridge context
+ * @param[in] settings Bridge specific settings
+ * @return Error code
+ **/
+
+error_t ethBridgeInit(EthBridgeContext *context,
+   const EthBridgeSettings *settings)
+{
+   uint_t i;
+
+   //Debug message
+   TRACE_INFO("Initializing Ethernet bridge...\r\n");
+
+   //Ensure the parameters are valid
+   if(context == NULL || settings == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //A bridge needs at least two ports
+   if(settings->numPorts < 2 || settings->numPorts > UINT8_MAX ||
+      settings->ports == NULL)
+   {
+      return ERROR_INVALID_PARAMETER;
+   }
+
+   //Sanity check
+   if(settings->numFdbEntries < 1 || settings->fdbEntries == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Loop through the ports
+   for(i = 0; i < settings->numPorts; i++)
+   {
+      //Frames are sent directly to the NIC driver of each port
+      if(settings->ports[i] == NULL || settings->ports[i]->nicDriver == NULL)
+         return ERROR_INVALID_INTERFACE;
+
+      //Only Ethernet controllers can be bridged
+      if(settings->ports[i]->nicDriver->type != NIC_TYPE_ETHERNET)
+         return ERROR_INVALID_INTERFACE;
+   }
+
+   //Clear the bridge context
+   osMemset(context, 0, sizeof(EthBridgeContext));
+
+   //Initialize bridge context
+   context->numPorts = settings->numPorts;
+   context->ports = settings->ports;
+   context->numFdbEntries = settings->numFdbEntries;
+   context->fdbEntries = settings->fdbEntries;
+   context->agingTime = settings->agingTime;
+
+   //Clear the filtering database
+   osMemset(context->fdbEntries, 0, context->numFdbEntries *
+      sizeof(EthBridgeFdbEntry));
+
+   //Attach the bridge to its ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      context->ports[i]->bridgeContext = context;
+   }
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Start the bridge
+ * @param[in] context Pointer to the bridge context
+ * @return Error code
+ **/
+
+error_t ethBridgeStart(EthBridgeContext *context)
+{
+   //Make sure the bridge context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_INFO("Starting Ethernet bridge...\r\n");
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //The bridge is now running
+   context->running = TRUE;
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Stop the bridge
+ * @param[in] context Pointer to the bridge context
+ * @return Error code
+ **/
+
+error_t ethBridgeStop(EthBridgeContext *context)
+{
+   //Make sure the bridge context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_INFO("Stopping Ethernet bridge...\r\n");
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //The bridge is not running anymore
+   context->running = FALSE;
+   //Learned addresses are meaningless once forwarding has stopped
+   ethBridgeFlushFdb(context);
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Relay an incoming frame to the other ports of the bridge
+ *
+ * The frame is forwarded as is, without being copied, to the port where
+ * the destination address was learned. Frames with a group or an unknown
+ * destination address are flooded to all the other ports
+ *
+ * @param[in] context Pointer to the bridge context
+ * @param[in] interface Port on which the frame was received
+ * @param[in] frame Incoming Ethernet frame (CRC excluded)
+ * @param[in] length Length of the frame, in bytes
+ * @return TRUE if the frame should also be processed by the local host,
+ *   FALSE if it has been entirely handled by the bridge
+ **/
+
+bool_t ethBridgeProcessFrame(EthBridgeContext *context,
+   NetInterface *interface, const uint8_t *frame, size_t length)
+{
+   uint_t i;
+   uint_t port;
+   systime_t time;
+   EthHeader *header;
+   EthBridgeFdbEntry *entry;
+
+   //Forwarding is disabled while the bridge is stopped
+   if(!context->running)
+      return TRUE;
+
+   //Retrieve the number of the port on which the frame was received
+   port = ethBridgeGetPort(context, interface);
+   //Unknown port?
+   if(port == 0)
+      return TRUE;
+
+   //Point to the Ethernet header
+   header = (EthHeader *) frame;
+
+   //Frames sent to the bridge filtered group addresses (STP, LLDP, PAUSE)
+   //must never be relayed
+   if(osMemcmp(header->destAddr.b, ETH_BRIDGE_RESERVED_ADDR.b, 5) == 0 &&
+      (header->destAddr.b[5] & 0xF0) == 0)
+   {
+      return TRUE;
+   }
+
+   //Learn the source address, unless it is a group address
+   if(!macIsMulticastAddr(&header->srcAddr))
+   {
+      ethBridgeLearnAddr(context, &header->srcAddr, port);
+   }
+
+   //Frame destined to the local host?
+   if(macCompAddr(&header->destAddr, &interface->macAddr))
+      return TRUE;
+
+   //Individual destination address?
+   if(!macIsMulticastAddr(&header->destAddr))
+   {
+      //Get current time
+      time = osGetSystemTime();
+
+      //Search the filtering database for the destination address
+      entry = ethBridgeFindFdbEntry(context, &header->destAddr);
+
+      //Dynamic entries that have not been refreshed are ignored
+      if(entry != NULL && timeCompare(time, entry->timestamp +
+         context->agingTime) < 0)
+      {
+         //The destination is located on the same segment as the source?
+         if(entry->port != port)
+         {
+            //Forward the frame to the relevant port only
+            ethBridgeSendFrame(context->ports[entry->port - 1], frame, length);
+         }
+
+         //The frame is not destined to the local host
+         return FALSE;
+      }
+   }
+
+   //Flood the frame to all the other ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Skip the ingress port and the ports whose link is down
+      if((i + 1) != port && context->ports[i]->linkState)
+      {
+         ethBridgeSendFrame(context->ports[i], frame, length);
+      }
+   }
+
+   //Group frames and frames with an unknown destination may be of interest
+   //to the local host
+   return TRUE;
+}
+
+
+/**
+ * @brief Retrieve the port number associated with an interface
+ * @param[in] context Pointer to the bridge context
+ * @param[in] interface Underlying network interface
+ * @return Port number (0 if the interface is not a port of the bridge)
+ **/
+
+uint_t ethBridgeGetPort(EthBridgeContext *context, NetInterface *interface)
+{
+   uint_t i;
+
+   //Loop through the ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Matching interface?
+      if(context->ports[i] == interface)
+         return i + 1;
+   }
+
+   //The interface is not a port of the bridge
+   return 0;
+}
+
+
+/**
+ * @brief Learn the location of a station
+ * @param[in] context Pointer to the bridge context
+ * @param[in] macAddr Source MAC address of a received frame
+ * @param[in] port Port on which the frame was received
+ **/
+
+void ethBridgeLearnAddr(EthBridgeContext *context, const MacAddr *macAddr,
+   uint_t port)
+{
+   uint_t i;
+   systime_t time;
+   EthBridgeFdbEntry *entry;
+   EthBridgeFdbEntry *oldestEntry;
+   EthBridgeFdbEntry **p;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Search the filtering database for the specified address
+   entry = ethBridgeFindFdbEntry(context, macAddr);
+
+   //Address already known?
+   if(entry != NULL)
+   {
+      //The station may have moved to another segment
+      entry->port = (uint8_t) port;
+      //Refresh the entry
+      entry->timestamp = time;
+      return;
+   }
+
+   //Keep track of the oldest entry
+   oldestEntry = NULL;
+
+   //Look for a free entry, or else an entry that can be recycled
+   for(i = 0; i < context->numFdbEntries; i++)
+   {
+      //Point to the current entry
+      entry = &context->fdbEntries[i];
+
+      //Free entry?
+      if(entry->port == 0)
+         break;
+
+      //Keep track of the oldest entry
+      if(oldestEntry == NULL ||
+         timeCompare(entry->timestamp, oldestEntry->timestamp) < 0)
+      {
+         oldestEntry = entry;
+      }
+   }
+
+   //The database is full?
+   if(i >= context->numFdbEntries)
+   {
+      //Expired entries are necessarily the oldest ones, so recycling the
+      //oldest entry also implements aging
+      entry = oldestEntry;
+
+      //Unlink the entry from its hash bucket
+      for(p = &context->fdbHashTable[ethBridgeGetHashIndex(&entry->macAddr)];
+         *p != NULL; p = &(*p)->next)
+      {
+         if(*p == entry)
+         {
+            *p = entry->next;
+            break;
+         }
+      }
+   }
+
+   //Record the location of the station
+   entry->macAddr = *macAddr;
+   entry->port = (uint8_t) port;
+   entry->timestamp = time;
+
+   //Add the entry to the hash table
+   i = ethBridgeGetHashIndex(macAddr);
+   entry->next = context->fdbHashTable[i];
+   context->fdbHashTable[i] = entry;
+}
+
+
+/**
+ * @brief Search the filtering database for a given MAC address
+ * @param[in] context Pointer to the bridge context
+ * @param[in] macAddr MAC address
+ * @return A pointer to the matching entry is returned. NULL is returned if
+ *   the specified address could not be found
+ **/
+
+EthBridgeFdbEntry *ethBridgeFindFdbEntry(EthBridgeContext *context,
+   const MacAddr *macAddr)
+{
+   EthBridgeFdbEntry *entry;
+
+   //Walk the relevant hash bucket
+   for(entry = context->fdbHashTable[ethBridgeGetHashIndex(macAddr)];
+      entry != NULL; entry = entry->next)
+   {
+      //Matching address?
+      if(macCompAddr(&entry->macAddr, macAddr))
+         break;
+   }
+
+   //Return a pointer to the matching entry, if any
+   return entry;
+}
+
+
+/**
+ * @brief Remove all the entries of the filtering database
+ * @param[in] context Pointer to the bridge context
+ **/
+
+void ethBridgeFlushFdb(EthBridgeContext *context)
+{
+   //Release all entries
+   osMemset(context->fdbEntries, 0, context->numFdbEntries *
+      sizeof(EthBridgeFdbEntry));
+
+   //Clear the hash table
+   osMemset(context->fdbHashTable, 0, sizeof(context->fdbHashTable));
+}
+
+
+/**
+ * @brief Calculate the hash index of a MAC address
+ * @param[in] macAddr MAC address
+ * @return Index of the hash bucket
+ **/
+
+uint_t ethBridgeGetHashIndex(const MacAddr *macAddr)
+{
+   uint32_t h;
+
+   //The low-order bytes are assigned by the manufacturer and vary the most
+   h = LOAD32BE(macAddr->b + 2);
+
+   //Fold the value
+   h ^= h >> 16;
+   h ^= h >> 8;
+
+   //Return the index of the hash bucket
+   return h % ETH_BRIDGE_HASH_TABLE_SIZE;
+}
+
+
+/**
+ * @brief Send a frame through a port of the bridge
+ *
+ * The frame is handed over to the NIC driver without being copied whenever
+ * the controller computes the CRC itself and no padding is needed. When
+ * egress QoS is enabled on the port, the frame is scheduled like the frames
+ * sent by the TCP/IP stack
+ *
+ * @param[in] interface Egress port
+ * @param[in] frame Ethernet frame to be sent (CRC excluded)
+ * @param[in] length Length of the frame, in bytes
+ * @return Error code
+ **/
+
+error_t ethBridgeSendFrame(NetInterface *interface, const uint8_t *frame,
+   size_t length)
+{
+   error_t error;
+   uint32_t crc;
+   NetBuffer *buffer;
+   NetBuffer1 frameBuffer;
+   NetTxAncillary ancillary;
+
+   //Additional options passed to the stack along with the packet
+   ancillary = NET_DEFAULT_TX_ANCILLARY;
+
+   //Update Ethernet statistics
+   ethUpdateOutStats(interface, &((EthHeader *) frame)->destAddr, length);
+
+   //Check whether the frame can be sent in place
+   if(interface->nicDriver->autoCrcCalc &&
+      (interface->nicDriver->autoPadding ||
+      length >= (ETH_MIN_FRAME_SIZE - ETH_CRC_SIZE)))
+   {
+      //The frame fits in a single chunk
+      frameBuffer.chunkCount = 1;
+      frameBuffer.maxChunkCount = 1;
+      frameBuffer.chunk[0].address = (void *) frame;
+      frameBuffer.chunk[0].length = (uint16_t) length;
+      frameBuffer.chunk[0].size = 0;
+
+      //Point to the frame
+      buffer = (NetBuffer *) &frameBuffer;
+      error = NO_ERROR;
+   }
+   else
+   {
+      //Allocate a buffer that can be padded and extended with the CRC
+      buffer = netBufferAlloc(length);
+      //Failed to allocate memory?
+      if(buffer == NULL)
+         return ERROR_OUT_OF_MEMORY;
+
+      //Copy the frame
+      netBufferWrite(buffer, 0, frame, length);
+
+      //Automatic padding not supported by hardware?
+      if(!interface->nicDriver->autoPadding)
+      {
+         //Add padding as necessary
+         error = ethPadFrame(buffer, &length);
+      }
+      else
+      {
+         //No padding needed
+         error = NO_ERROR;
+      }
+
+      //CRC calculation not supported by hardware?
+      if(!error && !interface->nicDriver->autoCrcCalc)
+      {
+         //Compute CRC over the header and payload
+         crc = ethCalcCrcEx(buffer, 0, length);
+         //Convert from host byte order to little-endian byte order
+         crc = htole32(crc);
+
+         //Append the calculated CRC value
+         error = netBufferAppend(buffer, &crc, sizeof(crc));
+      }
+   }
+
+   //Check status code
+   if(!error)
+   {
+#if (ETH_QOS_SUPPORT == ENABLED)
+      //Egress QoS enabled on the port?
+      if(interface->qosContext != NULL && interface->qosContext->running)
+      {
+         //The frame is classified and copied if it has to be queued
+         error = ethQosSendFrame(interface->qosContext, buffer, 0, &ancillary);
+      }
+      else
+#endif
+      {
+         //Forward the frame to the NIC driver
+         error = nicSendPacket(interface, buffer, 0, &ancillary);
+      }
+   }
+
+   //Free the buffer allocated to pad the frame, if any
+   if(buffer != (NetBuffer *) &frameBuffer)
+   {
+      netBufferFree(buffer);
+   }
+
+   //Return status code
+   return error;
+}
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * @file eth_bridge.h
+ * @brief Software Ethernet bridge
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+#ifndef _ETH_BRIDGE_H
+#define _ETH_BRIDGE_H
+
+//Dependencies
+#include "core/net.h"
+
+//Software bridge support
+#ifndef ETH_BRIDGE_SUPPORT
+   #define ETH_BRIDGE_SUPPORT DISABLED
+#elif (ETH_BRIDGE_SUPPORT != ENABLED && ETH_BRIDGE_SUPPORT != DISABLED)
+   #error ETH_BRIDGE_SUPPORT parameter is not valid
+#endif
+
+//Size of the hash table used to search the filtering database
+#ifndef ETH_BRIDGE_HASH_TABLE_SIZE
+   #define ETH_BRIDGE_HASH_TABLE_SIZE 16
+#elif (ETH_BRIDGE_HASH_TABLE_SIZE < 1)
+   #error ETH_BRIDGE_HASH_TABLE_SIZE parameter is not valid
+#endif
+
+//Default aging time for dynamic entries
+#ifndef ETH_BRIDGE_DEFAULT_AGING_TIME
+   #define ETH_BRIDGE_DEFAULT_AGING_TIME 300000
+#elif (ETH_BRIDGE_DEFAULT_AGING_TIME < 1000)
+   #error ETH_BRIDGE_DEFAULT_AGING_TIME parameter is not valid
+#endif
+
+//C++ guard
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Filtering database entry
+ **/
+
+typedef struct _EthBridgeFdbEntry
+{
+   MacAddr macAddr;                 ///<Learned MAC address
+   uint8_t port;                    ///<Port number (0 if the entry is free)
+   systime_t timestamp;             ///<Time at which the address was last seen
+   struct _EthBridgeFdbEntry *next; ///<Next entry in the same hash bucket
+} EthBridgeFdbEntry;
+
+
+/**
+ * @brief Bridge settings
+ **/
+
+typedef struct
+{
+   uint_t numPorts;                ///<Number of ports
+   NetInterface **ports;           ///<Physical interfaces acting as bridge ports
+   uint_t numFdbEntries;           ///<Size of the filtering database
+   EthBridgeFdbEntry *fdbEntries;  ///<Filtering database
+   systime_t agingTime;            ///<Aging time for dynamic entries
+} EthBridgeSettings;
+
+
+/**
+ * @brief Bridge context
+ **/
+
+typedef struct _EthBridgeContext
+{
+   bool_t running;                 ///<The bridge is forwarding frames
+   uint_t numPorts;                ///<Number of ports
+   NetInterface **ports;           ///<Physical interfaces acting as bridge ports
+   uint_t numFdbEntries;           ///<Size of the filtering database
+   EthBridgeFdbEntry *fdbEntries;  ///<Filtering database
+   EthBridgeFdbEntry *fdbHashTable[ETH_BRIDGE_HASH_TABLE_SIZE]; ///<Hash table used to search the filtering database
+   systime_t agingTime;            ///<Aging time for dynamic entries
+} EthBridgeContext;
+
+
+//Bridge filtered MAC group addresses
+extern const MacAddr ETH_BRIDGE_RESERVED_ADDR;
+
+//Software bridge related functions
+void ethBridgeGetDefaultSettings(EthBridgeSettings *settings);
+
+error_t ethBridgeInit(EthBridgeContext *context,
+   const EthBridgeSettings *settings);
+
+error_t ethBridgeStart(EthBridgeContext *context);
+error_t ethBridgeStop(EthBridgeContext *context);
+
+bool_t ethBridgeProcessFrame(EthBridgeContext *context,
+   NetInterface *interface, const uint8_t *frame, size_t length);
+
+uint_t ethBridgeGetPort(EthBridgeContext *context, NetInterface *interface);
+
+void ethBridgeLearnAddr(EthBridgeContext *context, const MacAddr *macAddr,
+   uint_t port);
+
+EthBridgeFdbEntry *ethBridgeFindFdbEntry(EthBridgeContext *context,
+   const MacAddr *macAddr);
+
+void ethBridgeFlushFdb(EthBridgeContext *context);
+
+uint_t ethBridgeGetHashIndex(const MacAddr *macAddr);
+
+error_t ethBridgeSendFrame(NetInterface *interface, const uint8_t *frame,
+   size_t length);
+
+//C++ guard
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,818 @@
+/**
+ * @file eth_qos.c
+ * @brief Egress QoS scheduler
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Outgoing frames are classified from their PCP or DSCP and held in per-class
+ * queues while the NIC transmitter is busy. Strict priority classes are
+ * always served first, the remaining bandwidth is shared among weighted
+ * classes using deficit round robin. Each class may also be rate-limited by
+ * a token bucket shaper
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL ETH_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "core/nic.h"
+#include "core/ethernet.h"
+#include "core/eth_qos.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (ETH_SUPPORT == ENABLED && ETH_QOS_SUPPORT == ENABLED)
+
+//Frames are held in the egress queues
+bool_t ethQosPending;
+
+
+/**
+ * @brief Initialize settings with default values
+ * @param[out] settings Structure that contains egress QoS settings
+ **/
+
+void ethQosGetDefaultSettings(EthQosSettings *settings)
+{
+   uint_t i;
+
+   //Physical interface
+   settings->interface = NULL;
+   //Number of traffic classes
+   settings->numClasses = ETH_QOS_MAX_CLASSES;
+
+   //Loop through the traffic classes
+   for(i = 0; i < ETH_QOS_MAX_CLASSES; i++)
+   {
+      //The first class is reserved for latency-sensitive traffic, the others
+      //share the bandwidth in proportion to their precedence
+      if(i == 0)
+      {
+         settings->classes[i].mode = ETH_QOS_SCHED_MODE_STRICT;
+         settings->classes[i].weight = 0;
+      }
+      else
+      {
+         settings->classes[i].mode = ETH_QOS_SCHED_MODE_WEIGHTED;
+         settings->classes[i].weight = ETH_QOS_MAX_CLASSES - i;
+      }
+
+      //Queue depth
+      settings->classes[i].queueDepth = ETH_QOS_DEFAULT_QUEUE_DEPTH;
+      //The shaper is disabled
+      settings->classes[i].rate = 0;
+      settings->classes[i].burst = 0;
+   }
+
+   //Frames that carry neither a PCP nor a DSCP (ARP for instance)
+   settings->defaultClass = 0;
+}
+
+
+/**
+ * @brief Egress QoS initialization
+ * @param[in] context Pointer to the egress QoS context
+ * @param[in] settings Egress QoS specific settings
+ * @return Error code
+ **/
+
+error_t ethQosInit(EthQosContext *context, const EthQosSettings *settings)
+{
+   uint_t i;
+   uint_t rank;
+   systime_t time;
+   EthQosClass *qosClass;
+
+   //Debug message
+   TRACE_INFO("Initializing egress QoS...\r\n");
+
+   //Ensure the parameters are valid
+   if(context == NULL || settings == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Frames are scheduled right before they are handed to the NIC driver
+   if(settings->interface == NULL || settings->interface->nicDriver == NULL)
+      return ERROR_INVALID_INTERFACE;
+
+   //Only Ethernet controllers are supported
+   if(settings->interface->nicDriver->type != NIC_TYPE_ETHERNET)
+      return ERROR_INVALID_INTERFACE;
+
+   //Check the number of traffic classes
+   if(settings->numClasses < 1 || settings->numClasses > ETH_QOS_MAX_CLASSES)
+      return ERROR_INVALID_PARAMETER;
+
+   //Check the default class
+   if(settings->defaultClass >= settings->numClasses)
+      return ERROR_INVALID_PARAMETER;
+
+   //Loop through the traffic classes
+   for(i = 0; i < settings->numClasses; i++)
+   {
+      //Check scheduling mode
+      if(settings->classes[i].mode != ETH_QOS_SCHED_MODE_STRICT &&
+         settings->classes[i].mode != ETH_QOS_SCHED_MODE_WEIGHTED)
+      {
+         return ERROR_INVALID_PARAMETER;
+      }
+
+      //A weighted class must be given a share of the bandwidth
+      if(settings->classes[i].mode == ETH_QOS_SCHED_MODE_WEIGHTED &&
+         settings->classes[i].weight == 0)
+      {
+         return ERROR_INVALID_PARAMETER;
+      }
+
+      //Check queue depth
+      if(settings->classes[i].queueDepth == 0)
+         return ERROR_INVALID_PARAMETER;
+
+      //A shaped class needs a non-empty bucket
+      if(settings->classes[i].rate != 0 && (settings->classes[i].burst == 0 ||
+         settings->classes[i].burst > INT32_MAX))
+      {
+         return ERROR_INVALID_PARAMETER;
+      }
+   }
+
+   //Clear the egress QoS context
+   osMemset(context, 0, sizeof(EthQosContext));
+
+   //Initialize egress QoS context
+   context->interface = settings->interface;
+   context->numClasses = settings->numClasses;
+   context->defaultClass = settings->defaultClass;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Initialize traffic classes
+   for(i = 0; i < context->numClasses; i++)
+   {
+      //Point to the current traffic class
+      qosClass = &context->classes[i];
+
+      //Save class settings
+      qosClass->mode = settings->classes[i].mode;
+      qosClass->weight = settings->classes[i].weight;
+      qosClass->queueDepth = settings->classes[i].queueDepth;
+      qosClass->rate = settings->classes[i].rate;
+      qosClass->burst = settings->classes[i].burst;
+
+      //The bucket is initially full
+      qosClass->credit = (int32_t) qosClass->burst;
+      qosClass->timestamp = time;
+   }
+
+   //Map priority code points to classes, following the traffic type order
+   //of IEEE 802.1Q (PCP 1 is the lowest priority, then PCP 0, 2, 3 and so on)
+   for(i = 0; i < 8; i++)
+   {
+      //Get the precedence of the priority code point
+      rank = (i == 0) ? 1 : (i == 1) ? 0 : i;
+      //Class 0 has the highest priority
+      context->pcpMap[i] = (7 - rank) * context->numClasses / 8;
+   }
+
+   //Map DSCP values to classes using the class selector bits (refer to
+   //RFC 2474, section 4.2.2.2)
+   for(i = 0; i < 64; i++)
+   {
+      context->dscpMap[i] = context->pcpMap[i >> 3];
+   }
+
+   //Attach the scheduler to the interface
+   context->interface->qosContext = context;
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Start egress QoS
+ * @param[in] context Pointer to the egress QoS context
+ * @return Error code
+ **/
+
+error_t ethQosStart(EthQosContext *context)
+{
+   //Make sure the egress QoS context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_INFO("Starting egress QoS...\r\n");
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //Outgoing frames are now scheduled
+   context->running = TRUE;
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Stop egress QoS
+ * @param[in] context Pointer to the egress QoS context
+ * @return Error code
+ **/
+
+error_t ethQosStop(EthQosContext *context)
+{
+   //Make sure the egress QoS context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_INFO("Stopping egress QoS...\r\n");
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Outgoing frames are handed directly to the NIC driver
+   context->running = FALSE;
+   //Discard the frames that are still queued
+   ethQosFlushQueues(context);
+   ethQosUpdatePending();
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Map a DSCP value to a traffic class
+ * @param[in] context Pointer to the egress QoS context
+ * @param[in] dscp Differentiated services codepoint
+ * @param[in] classIndex Traffic class
+ * @return Error code
+ **/
+
+error_t ethQosSetDscpMapping(EthQosContext *context, uint8_t dscp,
+   uint_t classIndex)
+{
+   //Check parameters
+   if(context == NULL || dscp >= 64 || classIndex >= context->numClasses)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //Update DSCP mapping
+   context->dscpMap[dscp] = (uint8_t) classIndex;
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Map a priority code point to a traffic class
+ * @param[in] context Pointer to the egress QoS context
+ * @param[in] pcp Priority code point
+ * @param[in] classIndex Traffic class
+ * @return Error code
+ **/
+
+error_t ethQosSetPcpMapping(EthQosContext *context, uint8_t pcp,
+   uint_t classIndex)
+{
+   //Check parameters
+   if(context == NULL || pcp >= 8 || classIndex >= context->numClasses)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //Update PCP mapping
+   context->pcpMap[pcp] = (uint8_t) classIndex;
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Retrieve the statistics of a traffic class
+ * @param[in] context Pointer to the egress QoS context
+ * @param[in] classIndex Traffic class
+ * @param[out] stats Statistics of the traffic class
+ * @return Error code
+ **/
+
+error_t ethQosGetClassStats(EthQosContext *context, uint_t classIndex,
+   EthQosClassStats *stats)
+{
+   //Check parameters
+   if(context == NULL || classIndex >= context->numClasses || stats == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //Copy statistics
+   *stats = context->classes[classIndex].stats;
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Schedule an outgoing frame
+ * @param[in] context Pointer to the egress QoS context
+ * @param[in] buffer Multi-part buffer containing the frame
+ * @param[in] offset Offset to the first byte of the frame
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the frame
+ * @return Error code
+ **/
+
+error_t ethQosSendFrame(EthQosContext *context, const NetBuffer *buffer,
+   size_t offset, NetTxAncillary *ancillary)
+{
+   error_t error;
+   size_t length;
+   NetBuffer *p;
+   EthQosClass *qosClass;
+   EthQosQueueItem *item;
+
+   //Retrieve the length of the frame
+   length = netBufferGetLength(buffer) - offset;
+   //Select the traffic class the frame belongs to
+   qosClass = &context->classes[ethQosClassifyFrame(context, buffer, offset)];
+
+   //If no frame is waiting and the transmitter is ready, then the frame can
+   //be sent right away without being copied
+   if(context->numPending == 0 && ethQosCheckShaper(qosClass) &&
+      osWaitForEvent(&context->interface->nicTxEvent, 0))
+   {
+      //Send the frame
+      error = nicTransmitPacket(context->interface, buffer, offset, ancillary);
+      //Update the shaper and the statistics of the class
+      ethQosUpdateClass(qosClass, length);
+
+      //Return status code
+      return error;
+   }
+
+   //Tail drop when the queue is full
+   if(qosClass->stats.queueDepth >= qosClass->queueDepth)
+   {
+      //Debug message
+      TRACE_DEBUG("Egress queue full, dropping frame...\r\n");
+
+      //Update statistics
+      qosClass->stats.dropPackets++;
+
+      //Try to make room in the queues
+      ethQosTransmit(context);
+
+      //The frame is silently dropped, as with a busy transmitter
+      return NO_ERROR;
+   }
+
+   //Allocate a memory buffer to hold the frame
+   p = netBufferAlloc(sizeof(EthQosQueueItem) + length);
+   //Failed to allocate memory?
+   if(p == NULL)
+   {
+      //Update statistics
+      qosClass->stats.dropPackets++;
+      //Report an error
+      return ERROR_OUT_OF_MEMORY;
+   }
+
+   //Point to the newly created item
+   item = netBufferAt(p, 0, 0);
+   item->next = NULL;
+   item->buffer = p;
+   item->offset = sizeof(EthQosQueueItem);
+   item->length = length;
+   item->ancillary = *ancillary;
+
+   //Copy the frame
+   error = netBufferCopy(p, item->offset, buffer, offset, length);
+   //Any error to report?
+   if(error)
+   {
+      //Clean up side effects
+      netBufferFree(p);
+      //Update statistics
+      qosClass->stats.dropPackets++;
+      //Exit immediately
+      return error;
+   }
+
+   //Append the frame to the queue of the class
+   if(qosClass->tail != NULL)
+   {
+      qosClass->tail->next = item;
+   }
+   else
+   {
+      qosClass->head = item;
+   }
+
+   qosClass->tail = item;
+
+   //Update queue statistics
+   qosClass->stats.queueDepth++;
+   qosClass->stats.maxQueueDepth = MAX(qosClass->stats.maxQueueDepth,
+      qosClass->stats.queueDepth);
+
+   //Total number of queued frames
+   context->numPending++;
+
+   //Send as many frames as possible
+   ethQosTransmit(context);
+
+   //The remaining frames are released by the TCP/IP stack task
+   if(context->numPending > 0)
+   {
+      ethQosPending = TRUE;
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Release queued frames
+ *
+ * This function is called by the TCP/IP stack task while frames are held in
+ * the egress queues, since NIC drivers do not notify the stack when the
+ * transmitter becomes ready
+ *
+ **/
+
+void ethQosTick(void)
+{
+   uint_t i;
+   EthQosContext *context;
+
+   //Loop through network interfaces
+   for(i = 0; i < NET_INTERFACE_COUNT; i++)
+   {
+      //Point to the scheduler attached to the interface
+      context = netInterface[i].qosContext;
+
+      //Any frame waiting?
+      if(context != NULL && context->running && context->numPending > 0)
+      {
+         //Send as many frames as possible
+         ethQosTransmit(context);
+      }
+   }
+
+   //Check whether frames are still queued
+   ethQosUpdatePending();
+}
+
+
+/**
+ * @brief Send queued frames while the transmitter is ready
+ * @param[in] context Pointer to the egress QoS context
+ **/
+
+void ethQosTransmit(EthQosContext *context)
+{
+   EthQosClass *qosClass;
+   EthQosQueueItem *item;
+
+   //Send as many frames as possible
+   while(context->numPending > 0)
+   {
+      //Select the class to be served
+      qosClass = ethQosSelectClass(context);
+      //All the non-empty classes are held back by their shaper?
+      if(qosClass == NULL)
+         break;
+
+      //Check whether the transmitter is ready to send
+      if(!osWaitForEvent(&context->interface->nicTxEvent, 0))
+         break;
+
+      //Remove the first frame from the queue
+      item = qosClass->head;
+      qosClass->head = item->next;
+
+      //Last frame of the queue?
+      if(qosClass->head == NULL)
+      {
+         qosClass->tail = NULL;
+      }
+
+      //Update queue statistics
+      qosClass->stats.queueDepth--;
+      context->numPending--;
+
+      //Weighted class?
+      if(qosClass->mode == ETH_QOS_SCHED_MODE_WEIGHTED)
+      {
+         //Consume the deficit counter
+         qosClass->deficit -= item->length;
+      }
+
+      //Send the frame
+      nicTransmitPacket(context->interface, item->buffer, item->offset,
+         &item->ancillary);
+
+      //Update the shaper and the statistics of the class
+      ethQosUpdateClass(qosClass, item->length);
+
+      //Release the frame
+      netBufferFree(item->buffer);
+   }
+}
+
+
+/**
+ * @brief Select the traffic class of an outgoing frame
+ * @param[in] context Pointer to the egress QoS context
+ * @param[in] buffer Multi-part buffer containing the frame
+ * @param[in] offset Offset to the first byte of the frame
+ * @return Traffic class
+ **/
+
+uint_t ethQosClassifyFrame(EthQosContext *context, const NetBuffer *buffer,
+   size_t offset)
+{
+   size_t n;
+   uint16_t type;
+   uint8_t dscp;
+   uint8_t data[sizeof(EthHeader) + 2];
+
+   //Read the Ethernet header and the first bytes of the payload
+   n = netBufferRead(data, buffer, offset, sizeof(data));
+
+   //Malformed frame?
+   if(n < sizeof(data))
+      return context->defaultClass;
+
+   //Retrieve the EtherType
+   type = LOAD16BE(data + 12);
+
+   //Tagged frame?
+   if(type == ETH_TYPE_VLAN || type == ETH_TYPE_VMAN)
+   {
+      //The PCP field of the outermost tag determines the class
+      return context->pcpMap[data[14] >> 5];
+   }
+   else if(type == ETH_TYPE_IPV4)
+   {
+      //The DSCP occupies the upper 6 bits of the type of service field
+      dscp = data[15] >> 2;
+   }
+   else if(type == ETH_TYPE_IPV6)
+   {
+      //The DSCP occupies the upper 6 bits of the traffic class field
+      dscp = ((data[14] & 0x0F) << 2) | (data[15] >> 6);
+   }
+   else
+   {
+      //The frame carries no priority information
+      return context->defaultClass;
+   }
+
+   //Map the DSCP value to a class
+   return context->dscpMap[dscp];
+}
+
+
+/**
+ * @brief Select the traffic class to be served
+ * @param[in] context Pointer to the egress QoS context
+ * @return Traffic class (NULL if no frame can be sent)
+ **/
+
+EthQosClass *ethQosSelectClass(EthQosContext *context)
+{
+   uint_t i;
+   EthQosClass *qosClass;
+
+   //Strict priority classes are served first, in order of precedence
+   for(i = 0; i < context->numClasses; i++)
+   {
+      //Point to the current traffic class
+      qosClass = &context->classes[i];
+
+      //Any frame that the shaper lets through?
+      if(qosClass->mode == ETH_QOS_SCHED_MODE_STRICT &&
+         qosClass->head != NULL && ethQosCheckShaper(qosClass))
+      {
+         return qosClass;
+      }
+   }
+
+   //The remaining bandwidth is shared among weighted classes using deficit
+   //round robin. Since the quantum is larger than any frame, two rounds are
+   //enough to find an eligible class
+   for(i = 0; i < (2 * context->numClasses); i++)
+   {
+      //Point to the class currently served
+      qosClass = &context->classes[context->drrIndex];
+
+      //Weighted class with frames waiting?
+      if(qosClass->mode == ETH_QOS_SCHED_MODE_WEIGHTED &&
+         qosClass->head != NULL)
+      {
+         //Check whether the shaper lets the class send
+         if(ethQosCheckShaper(qosClass))
+         {
+            //Grant the quantum once per round
+            if(!qosClass->visited)
+            {
+               qosClass->deficit += qosClass->weight * ETH_QOS_QUANTUM;
+               qosClass->visited = TRUE;
+            }
+
+            //The first frame fits in the deficit counter?
+            if(qosClass->head->length <= qosClass->deficit)
+               return qosClass;
+         }
+      }
+      else
+      {
+         //An idle class does not accumulate credit
+         qosClass->deficit = 0;
+      }
+
+      //Move on to the next class
+      qosClass->visited = FALSE;
+      context->drrIndex = (context->drrIndex + 1) % context->numClasses;
+   }
+
+   //No frame can be sent for the moment
+   return NULL;
+}
+
+
+/**
+ * @brief Check whether the shaper of a traffic class lets a frame through
+ * @param[in] qosClass Pointer to the traffic class
+ * @return TRUE if a frame can be sent, else FALSE
+ **/
+
+bool_t ethQosCheckShaper(EthQosClass *qosClass)
+{
+   int64_t credit;
+   uint32_t delta;
+   systime_t time;
+
+   //Shaper disabled?
+   if(qosClass->rate == 0)
+      return TRUE;
+
+   //Get current time
+   time = osGetSystemTime();
+   //Time elapsed since the bucket was last refilled
+   delta = (uint32_t) (time - qosClass->timestamp);
+
+   //Number of tokens earned in the meantime
+   credit = (int64_t) ((uint64_t) delta * qosClass->rate / 1000);
+
+   //Partial tokens are kept until they amount to at least one byte
+   if(credit > 0)
+   {
+      //The bucket cannot hold more than its burst size
+      credit = MIN(qosClass->credit + credit, (int64_t) qosClass->burst);
+
+      //Refill the bucket
+      qosClass->credit = (int32_t) credit;
+      qosClass->timestamp = time;
+   }
+
+   //A frame may be sent as long as the bucket is not empty. The bucket goes
+   //negative when the frame is larger than the remaining tokens
+   return (qosClass->credit > 0) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Account for a frame sent by a traffic class
+ * @param[in] qosClass Pointer to the traffic class
+ * @param[in] length Length of the frame
+ **/
+
+void ethQosUpdateClass(EthQosClass *qosClass, size_t length)
+{
+   //Shaper enabled?
+   if(qosClass->rate != 0)
+   {
+      //Consume tokens
+      qosClass->credit -= (int32_t) length;
+   }
+
+   //Update statistics
+   qosClass->stats.txPackets++;
+   qosClass->stats.txBytes += length;
+}
+
+
+/**
+ * @brief Discard all the queued frames
+ * @param[in] context Pointer to the egress QoS context
+ **/
+
+void ethQosFlushQueues(EthQosContext *context)
+{
+   uint_t i;
+   EthQosClass *qosClass;
+   EthQosQueueItem *item;
+
+   //Loop through the traffic classes
+   for(i = 0; i < context->numClasses; i++)
+   {
+      //Point to the current traffic class
+      qosClass = &context->classes[i];
+
+      //Release queued frames
+      while(qosClass->head != NULL)
+      {
+         item = qosClass->head;
+         qosClass->head = item->next;
+         netBufferFree(item->buffer);
+      }
+
+      //The queue is now empty
+      qosClass->tail = NULL;
+      qosClass->stats.queueDepth = 0;
+      qosClass->deficit = 0;
+      qosClass->visited = FALSE;
+   }
+
+   //No frame is waiting
+   context->numPending = 0;
+}
+
+
+/**
+ * @brief Check whether frames are held in any egress queue
+ **/
+
+void ethQosUpdatePending(void)
+{
+   uint_t i;
+   bool_t pending;
+   EthQosContext *context;
+
+   //Clear flag
+   pending = FALSE;
+
+   //Loop through network interfaces
+   for(i = 0; i < NET_INTERFACE_COUNT; i++)
+   {
+      //Point to the scheduler attached to the interface
+      context = netInterface[i].qosContext;
+
+      //Any frame waiting?
+      if(context != NULL && context->running && context->numPending > 0)
+      {
+         pending = TRUE;
+      }
+   }
+
+   //The TCP/IP stack task polls the queues as long as the flag is set
+   ethQosPending = pending;
+}
+
+#endif
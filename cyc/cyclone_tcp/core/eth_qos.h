@@ -0,0 +1,222 @@
+/**
+ * @file eth_qos.h
+ * @brief Egress QoS scheduler
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+#ifndef _ETH_QOS_H
+#define _ETH_QOS_H
+
+//Dependencies
+#include "core/net.h"
+
+//Egress QoS support
+#ifndef ETH_QOS_SUPPORT
+   #define ETH_QOS_SUPPORT DISABLED
+#elif (ETH_QOS_SUPPORT != ENABLED && ETH_QOS_SUPPORT != DISABLED)
+   #error ETH_QOS_SUPPORT parameter is not valid
+#endif
+
+//Maximum number of traffic classes per interface
+#ifndef ETH_QOS_MAX_CLASSES
+   #define ETH_QOS_MAX_CLASSES 4
+#elif (ETH_QOS_MAX_CLASSES < 1 || ETH_QOS_MAX_CLASSES > 8)
+   #error ETH_QOS_MAX_CLASSES parameter is not valid
+#endif
+
+//Default depth of the class queues
+#ifndef ETH_QOS_DEFAULT_QUEUE_DEPTH
+   #define ETH_QOS_DEFAULT_QUEUE_DEPTH 16
+#elif (ETH_QOS_DEFAULT_QUEUE_DEPTH < 1)
+   #error ETH_QOS_DEFAULT_QUEUE_DEPTH parameter is not valid
+#endif
+
+//Number of bytes a weighted class may send per unit of weight and per round
+#ifndef ETH_QOS_QUANTUM
+   #define ETH_QOS_QUANTUM 1536
+#elif (ETH_QOS_QUANTUM < 1536)
+   #error ETH_QOS_QUANTUM parameter is not valid
+#endif
+
+//Polling interval while frames are queued
+#ifndef ETH_QOS_TICK_INTERVAL
+   #define ETH_QOS_TICK_INTERVAL 2
+#elif (ETH_QOS_TICK_INTERVAL < 1)
+   #error ETH_QOS_TICK_INTERVAL parameter is not valid
+#endif
+
+//C++ guard
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Scheduling modes
+ **/
+
+typedef enum
+{
+   ETH_QOS_SCHED_MODE_STRICT   = 0, ///<Served before any weighted class
+   ETH_QOS_SCHED_MODE_WEIGHTED = 1  ///<Shares the remaining bandwidth (deficit round robin)
+} EthQosSchedMode;
+
+
+/**
+ * @brief Traffic class settings
+ **/
+
+typedef struct
+{
+   EthQosSchedMode mode; ///<Scheduling mode
+   uint_t weight;        ///<Relative weight (weighted classes only)
+   uint_t queueDepth;    ///<Maximum number of queued frames
+   uint32_t rate;        ///<Shaping rate, in bytes per second (0 to disable the shaper)
+   uint32_t burst;       ///<Bucket size, in bytes
+} EthQosClassSettings;
+
+
+/**
+ * @brief Egress QoS settings
+ **/
+
+typedef struct
+{
+   NetInterface *interface;                          ///<Physical interface
+   uint_t numClasses;                                ///<Number of traffic classes
+   EthQosClassSettings classes[ETH_QOS_MAX_CLASSES]; ///<Traffic classes (class 0 has the highest priority)
+   uint_t defaultClass;                              ///<Class of the frames that carry neither a PCP nor a DSCP
+} EthQosSettings;
+
+
+/**
+ * @brief Queued frame
+ **/
+
+typedef struct _EthQosQueueItem
+{
+   struct _EthQosQueueItem *next; ///<Next frame in the same queue
+   NetBuffer *buffer;             ///<Buffer holding the frame
+   size_t offset;                 ///<Offset to the first byte of the frame
+   size_t length;                 ///<Length of the frame
+   NetTxAncillary ancillary;      ///<Additional options passed to the NIC driver
+} EthQosQueueItem;
+
+
+/**
+ * @brief Traffic class statistics
+ **/
+
+typedef struct
+{
+   uint32_t txPackets;     ///<Number of frames sent
+   uint32_t txBytes;       ///<Number of bytes sent
+   uint32_t dropPackets;   ///<Number of frames dropped (queue full or out of memory)
+   uint_t queueDepth;      ///<Current number of queued frames
+   uint_t maxQueueDepth;   ///<Highest number of queued frames
+} EthQosClassStats;
+
+
+/**
+ * @brief Traffic class
+ **/
+
+typedef struct
+{
+   EthQosSchedMode mode;      ///<Scheduling mode
+   uint_t weight;             ///<Relative weight
+   uint_t queueDepth;         ///<Maximum number of queued frames
+   uint32_t rate;             ///<Shaping rate, in bytes per second
+   uint32_t burst;            ///<Bucket size, in bytes
+   int32_t credit;            ///<Number of bytes the shaper lets through
+   systime_t timestamp;       ///<Time at which the bucket was last refilled
+   uint32_t deficit;          ///<Deficit counter
+   bool_t visited;            ///<The class has received its quantum for the current round
+   EthQosQueueItem *head;     ///<First queued frame
+   EthQosQueueItem *tail;     ///<Last queued frame
+   EthQosClassStats stats;    ///<Statistics
+} EthQosClass;
+
+
+/**
+ * @brief Egress QoS context
+ **/
+
+typedef struct _EthQosContext
+{
+   bool_t running;                           ///<The scheduler is operational
+   NetInterface *interface;                  ///<Physical interface
+   uint_t numClasses;                        ///<Number of traffic classes
+   EthQosClass classes[ETH_QOS_MAX_CLASSES]; ///<Traffic classes
+   uint8_t dscpMap[64];                      ///<DSCP to class mapping
+   uint8_t pcpMap[8];                        ///<PCP to class mapping
+   uint_t defaultClass;                      ///<Class of the frames that carry neither a PCP nor a DSCP
+   uint_t drrIndex;                          ///<Weighted class currently served
+   uint_t numPending;                        ///<Total number of queued frames
+} EthQosContext;
+
+
+//Frames are held in the egress queues
+extern bool_t ethQosPending;
+
+//Egress QoS related functions
+void ethQosGetDefaultSettings(EthQosSettings *settings);
+error_t ethQosInit(EthQosContext *context, const EthQosSettings *settings);
+
+error_t ethQosStart(EthQosContext *context);
+error_t ethQosStop(EthQosContext *context);
+
+error_t ethQosSetDscpMapping(EthQosContext *context, uint8_t dscp,
+   uint_t classIndex);
+
+error_t ethQosSetPcpMapping(EthQosContext *context, uint8_t pcp,
+   uint_t classIndex);
+
+error_t ethQosGetClassStats(EthQosContext *context, uint_t classIndex,
+   EthQosClassStats *stats);
+
+error_t ethQosSendFrame(EthQosContext *context, const NetBuffer *buffer,
+   size_t offset, NetTxAncillary *ancillary);
+
+void ethQosTick(void);
+void ethQosTransmit(EthQosContext *context);
+
+uint_t ethQosClassifyFrame(EthQosContext *context, const NetBuffer *buffer,
+   size_t offset);
+
+EthQosClass *ethQosSelectClass(EthQosContext *context);
+bool_t ethQosCheckShaper(EthQosClass *qosClass);
+void ethQosUpdateClass(EthQosClass *qosClass, size_t length);
+void ethQosFlushQueues(EthQosContext *context);
+void ethQosUpdatePending(void);
+
+//C++ guard
+#ifdef __cplusplus
+}
+#endif
+
+#endif
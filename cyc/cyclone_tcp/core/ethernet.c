@@ -167,6 +167,32 @@ void ethProcessFrame(NetInterface *interface, uint8_t *frame, size_t length,
       ETH_FRAME_FORWARD_HOOK(interface, header, length);
 #endif
 
+#if (LAG_SUPPORT == ENABLED)
+      //Check whether the interface is a member of a link aggregation group
+      if(interface->lagContext != NULL &&
+         interface->lagContext->interface != interface)
+      {
+         //The frame is processed on behalf of the aggregator
+         lagProcessFrame(interface->lagContext, interface, frame, length,
+            ancillary);
+         return;
+      }
+#endif
+
+#if (ETH_BRIDGE_SUPPORT == ENABLED)
+      //Check whether the interface is a port of a software bridge
+      if(interface->bridgeContext != NULL)
+      {
+         //Relay the frame to the other ports of the bridge
+         if(!ethBridgeProcessFrame(interface->bridgeContext, interface, frame,
+            length))
+         {
+            //The frame is not destined to the local host
+            return;
+         }
+      }
+#endif
+
       //Retrieve the value of the EtherType field
       type = ntohs(header->type);
 
@@ -576,8 +602,21 @@ error_t ethSendFrame(NetInterface *interface, const MacAddr *destAddr,
       }
    }
 
-   //Forward the frame to the physical interface
-   error = nicSendPacket(physicalInterface, buffer, offset, ancillary);
+#if (ETH_QOS_SUPPORT == ENABLED)
+   //Egress QoS enabled on the physical interface?
+   if(physicalInterface->qosContext != NULL &&
+      physicalInterface->qosContext->running)
+   {
+      //The frame is classified and queued until the transmitter is ready
+      error = ethQosSendFrame(physicalInterface->qosContext, buffer, offset,
+         ancillary);
+   }
+   else
+#endif
+   {
+      //Forward the frame to the physical interface
+      error = nicSendPacket(physicalInterface, buffer, offset, ancillary);
+   }
 
    //Return status code
    return error;
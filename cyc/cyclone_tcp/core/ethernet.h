@@ -166,6 +166,7 @@ typedef enum
    ETH_TYPE_RARP  = 0x8035,
    ETH_TYPE_VLAN  = 0x8100,
    ETH_TYPE_IPV6  = 0x86DD,
+   ETH_TYPE_SLOW  = 0x8809,
    ETH_TYPE_EAPOL = 0x888E,
    ETH_TYPE_VMAN  = 0x88A8,
    ETH_TYPE_LLDP  = 0x88CC,
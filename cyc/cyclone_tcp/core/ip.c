@@ -38,9 +38,11 @@
 #include "ipv4/ipv4.h"
 #include "ipv4/ipv4_multicast.h"
 #include "ipv4/ipv4_misc.h"
+#include "ipv4/ipv4_pmtu.h"
 #include "ipv6/ipv6.h"
 #include "ipv6/ipv6_multicast.h"
 #include "ipv6/ipv6_misc.h"
+#include "ipv6/ipv6_pmtu.h"
 #include "debug.h"
 
 //IPsec supported?
@@ -158,6 +160,58 @@ error_t ipSelectSourceAddr(NetInterface **interface, const IpAddr *destAddr,
 }
 
 
+/**
+ * @brief Retrieve the PMTU for the specified destination address
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IP address
+ * @return PMTU value, or zero if the address is not valid
+ **/
+
+size_t ipGetPathMtu(NetInterface *interface, const IpAddr *destAddr)
+{
+   size_t pathMtu;
+
+#if (IPV4_SUPPORT == ENABLED)
+   //The destination address is an IPv4 address?
+   if(destAddr->length == sizeof(Ipv4Addr))
+   {
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+      //Retrieve the PMTU from the cache
+      pathMtu = ipv4GetPathMtu(interface, destAddr->ipv4Addr);
+#else
+      //The PMTU is assumed to be the MTU of the first-hop link
+      pathMtu = interface->ipv4Context.linkMtu;
+#endif
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //The destination address is an IPv6 address?
+   if(destAddr->length == sizeof(Ipv6Addr))
+   {
+#if (IPV6_PMTU_SUPPORT == ENABLED)
+      //Retrieve the PMTU from the cache
+      pathMtu = ipv6GetPathMtu(interface, &destAddr->ipv6Addr);
+
+      //The PMTU should not exceed the MTU of the first-hop link
+      pathMtu = MIN(pathMtu, interface->ipv6Context.linkMtu);
+#else
+      //The PMTU is assumed to be the MTU of the first-hop link
+      pathMtu = interface->ipv6Context.linkMtu;
+#endif
+   }
+   else
+#endif
+   //The destination address is not valid?
+   {
+      pathMtu = 0;
+   }
+
+   //Return the PMTU value
+   return pathMtu;
+}
+
+
 /**
  * @brief Compare an IP address against the unspecified address
  * @param[in] ipAddr IP address
@@ -134,6 +134,8 @@ error_t ipSendDatagram(NetInterface *interface,
 error_t ipSelectSourceAddr(NetInterface **interface, const IpAddr *destAddr,
    IpAddr *srcAddr);
 
+size_t ipGetPathMtu(NetInterface *interface, const IpAddr *destAddr);
+
 bool_t ipIsUnspecifiedAddr(const IpAddr *ipAddr);
 bool_t ipIsLinkLocalAddr(const IpAddr *ipAddr);
 bool_t ipIsMulticastAddr(const IpAddr *ipAddr);
@@ -1581,6 +1581,24 @@ void netTaskEx(NetContext *context)
          timeout = 0;
       }
 
+#if (TCP_SUPPORT == ENABLED && TCP_PACING_SUPPORT == ENABLED)
+      //Segments held back by TCP pacing are released at a finer granularity
+      //than the TCP tick
+      if(tcpPacingPending)
+      {
+         timeout = MIN(timeout, TCP_PACING_TICK_INTERVAL);
+      }
+#endif
+
+#if (ETH_SUPPORT == ENABLED && ETH_QOS_SUPPORT == ENABLED)
+      //Frames held in the egress queues are released as soon as the NIC
+      //transmitter becomes ready
+      if(ethQosPending)
+      {
+         timeout = MIN(timeout, ETH_QOS_TICK_INTERVAL);
+      }
+#endif
+
       //Receive notifications when a frame has been received, or the
       //link state of any network interfaces has changed
       status = osWaitForEvent(&netEvent, timeout);
@@ -1671,6 +1689,32 @@ void netTaskEx(NetContext *context)
          //Next event
          netTimestamp = time + NET_TICK_INTERVAL;
       }
+
+#if (TCP_SUPPORT == ENABLED && TCP_PACING_SUPPORT == ENABLED)
+      //Any segment held back by TCP pacing?
+      if(tcpPacingPending)
+      {
+         //Get exclusive access
+         osAcquireMutex(&netMutex);
+         //Release the segments that can be sent
+         tcpPacingTick();
+         //Release exclusive access
+         osReleaseMutex(&netMutex);
+      }
+#endif
+
+#if (ETH_SUPPORT == ENABLED && ETH_QOS_SUPPORT == ENABLED)
+      //Any frame held in the egress queues?
+      if(ethQosPending)
+      {
+         //Get exclusive access
+         osAcquireMutex(&netMutex);
+         //Send the frames the scheduler lets through
+         ethQosTick();
+         //Release exclusive access
+         osReleaseMutex(&netMutex);
+      }
+#endif
 #if (NET_RTOS_SUPPORT == ENABLED)
    }
 #endif
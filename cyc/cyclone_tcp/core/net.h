@@ -43,6 +43,9 @@ struct _NetInterface;
 #include "core/net_misc.h"
 #include "core/nic.h"
 #include "core/ethernet.h"
+#include "core/eth_bridge.h"
+#include "core/eth_qos.h"
+#include "lag/lag.h"
 #include "ipv4/ipv4.h"
 #include "ipv4/ipv4_frag.h"
 #include "ipv4/auto_ip.h"
@@ -224,6 +227,15 @@ struct _NetInterface
    bool_t promiscuous;                            ///<Promiscuous mode
    bool_t acceptAllMulticast;                     ///<Accept all frames with a multicast destination address
 #endif
+#if (ETH_SUPPORT == ENABLED && ETH_BRIDGE_SUPPORT == ENABLED)
+   EthBridgeContext *bridgeContext;               ///<Software bridge the interface is a port of
+#endif
+#if (ETH_SUPPORT == ENABLED && LAG_SUPPORT == ENABLED)
+   LagContext *lagContext;                        ///<Link aggregation group the interface belongs to
+#endif
+#if (ETH_SUPPORT == ENABLED && ETH_QOS_SUPPORT == ENABLED)
+   EthQosContext *qosContext;                     ///<Egress QoS scheduler
+#endif
 #if (ETH_VLAN_SUPPORT == ENABLED)
    uint16_t vlanId;                               ///<VLAN identifier (802.1Q)
 #endif
@@ -247,6 +259,9 @@ struct _NetInterface
 #if (ETH_SUPPORT == ENABLED)
    bool_t enableArp;                              ///<Enable address resolution using ARP
    ArpCacheEntry arpCache[ARP_CACHE_SIZE];        ///<ARP cache
+   ArpCacheEntry *arpHashTable[ARP_HASH_TABLE_SIZE]; ///<Hash table used to search the ARP cache
+   ArpCacheEntry *arpLruHead;                     ///<Most recently used ARP cache entry
+   ArpCacheEntry *arpLruTail;                     ///<Least recently used ARP cache entry
 #endif
 #if (IGMP_HOST_SUPPORT == ENABLED)
    IgmpHostContext igmpHostContext;               ///<IGMP host context
@@ -329,6 +344,7 @@ typedef struct
    NetInterface interfaces[NET_INTERFACE_COUNT]; ///<Network interfaces
    NetLinkChangeCallbackEntry linkChangeCallbacks[NET_MAX_LINK_CHANGE_CALLBACKS];
    NetTimerCallbackEntry timerCallbacks[NET_MAX_TIMER_CALLBACKS];
+   uint_t routeCacheGeneration;                  ///<Bumped whenever cached routes become stale
 #if (IPV4_IPSEC_SUPPORT == ENABLED)
    void *ipsecContext;                           ///<IPsec context
    void *ikeContext;                             ///<IKE context
@@ -101,6 +101,14 @@ typedef struct
 } NetBuffer1;
 
 
+typedef struct
+{
+   uint_t chunkCount;
+   uint_t maxChunkCount;
+   ChunkDesc chunk[2];
+} NetBuffer2;
+
+
 //Memory management functions
 error_t memPoolInit(void);
 void *memPoolAlloc(size_t size);
@@ -302,6 +302,9 @@ void netProcessLinkChange(NetInterface *interface)
       }
    }
 
+   //The routes cached by the sockets may no longer be valid
+   netInvalidateRouteCache();
+
    //Loop through opened sockets
    for(i = 0; i < SOCKET_MAX_COUNT; i++)
    {
@@ -336,6 +339,20 @@ void netProcessLinkChange(NetInterface *interface)
 }
 
 
+/**
+ * @brief Invalidate the routes cached by the sockets
+ *
+ * This function must be called whenever a route, an address or a neighbor
+ * cache entry changes
+ **/
+
+void netInvalidateRouteCache(void)
+{
+   //Cached entries filled with a different value are considered stale
+   netContext.routeCacheGeneration++;
+}
+
+
 /**
  * @brief Register timer callback
  * @param[in] period Timer reload value, in milliseconds
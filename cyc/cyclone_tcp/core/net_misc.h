@@ -203,6 +203,8 @@ error_t netDetachLinkChangeCallback(NetInterface *interface,
 
 void netProcessLinkChange(NetInterface *interface);
 
+void netInvalidateRouteCache(void);
+
 error_t netAttachTimerCallback(systime_t period, NetTimerCallback callback,
    void *param);
 
@@ -284,18 +284,6 @@ error_t nicSendPacket(NetInterface *interface, const NetBuffer *buffer,
    error_t error;
    bool_t status;
 
-#if (TRACE_LEVEL >= TRACE_LEVEL_DEBUG)
-   //Retrieve the length of the packet
-   size_t length = netBufferGetLength(buffer) - offset;
-
-   //Debug message
-   TRACE_DEBUG("Sending packet (%" PRIuSIZE " bytes)...\r\n", length);
-   TRACE_DEBUG_NET_BUFFER("  ", buffer, offset, length);
-#endif
-
-   //Gather entropy
-   netContext.entropy += netGetSystemTickCount();
-
    //Check whether the interface is enabled for operation
    if(interface->configured && interface->nicDriver != NULL)
    {
@@ -314,18 +302,8 @@ error_t nicSendPacket(NetInterface *interface, const NetBuffer *buffer,
       //Check whether the specified event is in signaled state
       if(status)
       {
-         //Disable interrupts
-         interface->nicDriver->disableIrq(interface);
-
          //Send the packet
-         error = interface->nicDriver->sendPacket(interface, buffer, offset,
-            ancillary);
-
-         //Re-enable interrupts if necessary
-         if(interface->configured)
-         {
-            interface->nicDriver->enableIrq(interface);
-         }
+         error = nicTransmitPacket(interface, buffer, offset, ancillary);
       }
       else
       {
@@ -344,6 +322,63 @@ error_t nicSendPacket(NetInterface *interface, const NetBuffer *buffer,
 }
 
 
+/**
+ * @brief Hand a packet over to the network controller
+ *
+ * The caller must have checked that the transmitter is ready to send
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t nicTransmitPacket(NetInterface *interface, const NetBuffer *buffer,
+   size_t offset, NetTxAncillary *ancillary)
+{
+   error_t error;
+
+#if (TRACE_LEVEL >= TRACE_LEVEL_DEBUG)
+   //Retrieve the length of the packet
+   size_t length = netBufferGetLength(buffer) - offset;
+
+   //Debug message
+   TRACE_DEBUG("Sending packet (%" PRIuSIZE " bytes)...\r\n", length);
+   TRACE_DEBUG_NET_BUFFER("  ", buffer, offset, length);
+#endif
+
+   //Gather entropy
+   netContext.entropy += netGetSystemTickCount();
+
+   //Check whether the interface is enabled for operation
+   if(interface->configured && interface->nicDriver != NULL)
+   {
+      //Disable interrupts
+      interface->nicDriver->disableIrq(interface);
+
+      //Send the packet
+      error = interface->nicDriver->sendPacket(interface, buffer, offset,
+         ancillary);
+
+      //Re-enable interrupts if necessary
+      if(interface->configured)
+      {
+         interface->nicDriver->enableIrq(interface);
+      }
+   }
+   else
+   {
+      //Report an error
+      error = ERROR_INVALID_INTERFACE;
+   }
+
+   //Return status code
+   return error;
+}
+
+
 /**
  * @brief Configure MAC address filtering
  * @param[in] interface Underlying network interface
@@ -600,3 +635,49 @@ void nicNotifyLinkChange(NetInterface *interface)
    //Disable interrupts
    physicalInterface->nicDriver->disableIrq(physicalInterface);
 }
+
+
+/**
+ * @brief Transfer a block of data over the SPI bus
+ *
+ * The transfer is performed in a single call when the SPI driver implements
+ * the transferMultipleBytes callback. Drivers that queue the transfer until
+ * the CS pin is raised may defer the update of the receive buffer, so the
+ * received data must not be examined before deassertCs is called
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] txBuffer Data to be transmitted (may be NULL)
+ * @param[out] rxBuffer Buffer where to store the incoming data (may be NULL)
+ * @param[in] length Number of bytes to transfer
+ **/
+
+void nicSpiTransfer(NetInterface *interface, const uint8_t *txBuffer,
+   uint8_t *rxBuffer, size_t length)
+{
+   size_t i;
+   uint8_t data;
+
+   //Check whether the SPI driver supports block transfers
+   if(interface->spiDriver->transferMultipleBytes != NULL)
+   {
+      //Transfer the whole block at once
+      interface->spiDriver->transferMultipleBytes(txBuffer, rxBuffer, length);
+   }
+   else
+   {
+      //Transfer data one byte at a time
+      for(i = 0; i < length; i++)
+      {
+         //Send dummy data when no transmit buffer is specified
+         data = (txBuffer != NULL) ? txBuffer[i] : 0x00;
+         //Transfer a single byte
+         data = interface->spiDriver->transfer(data);
+
+         //Save the received byte, if necessary
+         if(rxBuffer != NULL)
+         {
+            rxBuffer[i] = data;
+         }
+      }
+   }
+}
@@ -419,6 +419,9 @@ void nicTick(NetInterface *interface);
 error_t nicSendPacket(NetInterface *interface, const NetBuffer *buffer,
    size_t offset, NetTxAncillary *ancillary);
 
+error_t nicTransmitPacket(NetInterface *interface, const NetBuffer *buffer,
+   size_t offset, NetTxAncillary *ancillary);
+
 error_t nicUpdateMacAddrFilter(NetInterface *interface);
 
 void nicProcessPacket(NetInterface *interface, uint8_t *packet, size_t length,
@@ -426,6 +429,9 @@ void nicProcessPacket(NetInterface *interface, uint8_t *packet, size_t length,
 
 void nicNotifyLinkChange(NetInterface *interface);
 
+void nicSpiTransfer(NetInterface *interface, const uint8_t *txBuffer,
+   uint8_t *rxBuffer, size_t length);
+
 //C++ guard
 #ifdef __cplusplus
 }
@@ -41,6 +41,7 @@
 #include "core/socket.h"
 #include "core/socket_misc.h"
 #include "core/raw_socket.h"
+#include "core/bpf.h"
 #include "core/ethernet_misc.h"
 #include "ipv4/ipv4.h"
 #include "ipv4/ipv4_misc.h"
@@ -74,6 +75,13 @@ error_t rawSocketProcessIpPacket(NetInterface *interface,
    Socket *socket;
    SocketQueueItem *queueItem;
    NetBuffer *p;
+#if (SOCKET_FILTER_SUPPORT == ENABLED)
+   size_t n;
+   bool_t filtered;
+
+   //No packet has been rejected by a filter yet
+   filtered = FALSE;
+#endif
 
    //Retrieve the length of the raw IP packet
    length = netBufferGetLength(buffer) - offset;
@@ -240,13 +248,41 @@ error_t rawSocketProcessIpPacket(NetInterface *interface,
          continue;
       }
 
+#if (SOCKET_FILTER_SUPPORT == ENABLED)
+      //Any packet filter attached to the socket?
+      if(socket->filter != NULL)
+      {
+         //Run the filter before any memory is allocated for the packet
+         n = bpfRunProgram(socket->filter, buffer, offset, length);
+
+         //Packet rejected by the filter?
+         if(n == 0)
+         {
+            filtered = TRUE;
+            continue;
+         }
+
+         //The filter may request the packet to be truncated
+         length = MIN(length, n);
+      }
+#endif
+
       //The current socket meets all the criteria
       break;
    }
 
-   //Drop incoming packet if no matching socket was found
+   //No matching socket found?
    if(i >= SOCKET_MAX_COUNT)
+   {
+#if (SOCKET_FILTER_SUPPORT == ENABLED)
+      //The protocol is reachable, but the packet was filtered out
+      if(filtered)
+         return ERROR_MESSAGE_DISCARDED;
+#endif
+
+      //Drop incoming packet
       return ERROR_PROTOCOL_UNREACHABLE;
+   }
 
    //Empty receive queue?
    if(socket->receiveQueue == NULL)
@@ -388,9 +424,31 @@ void rawSocketProcessEthPacket(NetInterface *interface, const uint8_t *data,
 #if (ETH_SUPPORT == ENABLED)
    uint_t i;
    uint_t j;
+   size_t n;
    Socket *socket;
    SocketQueueItem *queueItem;
    NetBuffer *p;
+#if (SOCKET_FILTER_SUPPORT == ENABLED)
+   uint32_t m;
+   EthHeader header;
+   NetBuffer2 frame;
+
+   //Filters see the frame as returned to the application, which means the
+   //Ethernet header is rebuilt in front of the payload
+   header.destAddr = ancillary->destMacAddr;
+   header.srcAddr = ancillary->srcMacAddr;
+   header.type = htons(ancillary->ethType);
+
+   //Describe the frame as a two-chunk buffer so that filters can be run
+   frame.chunkCount = 2;
+   frame.maxChunkCount = 2;
+   frame.chunk[0].address = &header;
+   frame.chunk[0].length = sizeof(EthHeader);
+   frame.chunk[0].size = 0;
+   frame.chunk[1].address = (void *) data;
+   frame.chunk[1].length = (uint16_t) length;
+   frame.chunk[1].size = 0;
+#endif
 
    //Loop through opened sockets
    for(i = 0; i < SOCKET_MAX_COUNT; i++)
@@ -424,12 +482,32 @@ void rawSocketProcessEthPacket(NetInterface *interface, const uint8_t *data,
             continue;
       }
 
+      //Number of bytes to be queued
+      n = length;
+
+#if (SOCKET_FILTER_SUPPORT == ENABLED)
+      //Any packet filter attached to the socket?
+      if(socket->filter != NULL)
+      {
+         //Run the filter before any memory is allocated for the frame
+         m = bpfRunProgram(socket->filter, (NetBuffer *) &frame, 0,
+            sizeof(EthHeader) + length);
+
+         //Frame rejected by the filter?
+         if(m == 0)
+            continue;
+
+         //The returned value includes the Ethernet header
+         n = MIN(n, m - MIN(m, sizeof(EthHeader)));
+      }
+#endif
+
       //Empty receive queue?
       if(socket->receiveQueue == NULL)
       {
          //Allocate a memory buffer to hold the data and the associated
          //descriptor
-         p = netBufferAlloc(sizeof(SocketQueueItem) + length);
+         p = netBufferAlloc(sizeof(SocketQueueItem) + n);
 
          //Successful memory allocation?
          if(p != NULL)
@@ -471,7 +549,7 @@ void rawSocketProcessEthPacket(NetInterface *interface, const uint8_t *data,
 
          //Allocate a memory buffer to hold the data and the associated
          //descriptor
-         p = netBufferAlloc(sizeof(SocketQueueItem) + length);
+         p = netBufferAlloc(sizeof(SocketQueueItem) + n);
 
          //Successful memory allocation?
          if(p != NULL)
@@ -515,7 +593,7 @@ void rawSocketProcessEthPacket(NetInterface *interface, const uint8_t *data,
       queueItem->offset = sizeof(SocketQueueItem);
 
       //Copy the payload
-      netBufferWrite(queueItem->buffer, queueItem->offset, data, length);
+      netBufferWrite(queueItem->buffer, queueItem->offset, data, n);
 
       //Additional options can be passed to the stack along with the packet
       queueItem->ancillary = *ancillary;
@@ -48,6 +48,11 @@
 //Socket table
 Socket socketTable[SOCKET_MAX_COUNT];
 
+#if (SOCKET_MAX_MULTICAST_GROUPS > 0)
+//Multicast group index (group address to subscribers)
+SocketMulticastGroup *socketMulticastIndex[SOCKET_MULTICAST_HASH_TABLE_SIZE];
+#endif
+
 //Default socket message
 const SocketMsg SOCKET_DEFAULT_MSG =
 {
@@ -90,6 +95,11 @@ error_t socketInit(void)
    //Initialize socket descriptors
    osMemset(socketTable, 0, sizeof(socketTable));
 
+#if (SOCKET_MAX_MULTICAST_GROUPS > 0)
+   //Clear the multicast group index
+   osMemset(socketMulticastIndex, 0, sizeof(socketMulticastIndex));
+#endif
+
    //Loop through socket descriptors
    for(i = 0; i < SOCKET_MAX_COUNT; i++)
    {
@@ -1191,6 +1201,288 @@ error_t socketSetMaxSegmentSize(Socket *socket, size_t mss)
 }
 
 
+/**
+ * @brief Enable TCP quick ACK mode
+ *
+ * In quick ACK mode, every incoming data segment is acknowledged immediately
+ * instead of being subject to the delayed ACK algorithm
+ *
+ * @param[in] socket Handle to a socket
+ * @param[in] enabled Specifies whether quick ACK mode is enabled
+ * @return Error code
+ **/
+
+error_t socketEnableTcpQuickAck(Socket *socket, bool_t enabled)
+{
+#if (TCP_SUPPORT == ENABLED)
+   //Make sure the socket handle is valid
+   if(socket == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Check whether quick ACK mode should be enabled
+   if(enabled)
+   {
+      socket->options |= SOCKET_OPTION_TCP_QUICK_ACK;
+   }
+   else
+   {
+      socket->options &= ~SOCKET_OPTION_TCP_QUICK_ACK;
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Not implemented
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Enable TCP Fast Open
+ *
+ * On a client socket, socketConnect() returns immediately and the SYN is sent
+ * along with the first data passed to socketSend(). On a listening socket,
+ * TFO cookies are issued and data carried by SYN segments are accepted
+ *
+ * @param[in] socket Handle to a socket
+ * @param[in] enabled Specifies whether TCP Fast Open is enabled
+ * @return Error code
+ **/
+
+error_t socketEnableTcpFastOpen(Socket *socket, bool_t enabled)
+{
+#if (TCP_SUPPORT == ENABLED && TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //Make sure the socket handle is valid
+   if(socket == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Check whether TCP Fast Open should be enabled
+   if(enabled)
+   {
+      socket->options |= SOCKET_OPTION_TCP_FAST_OPEN;
+   }
+   else
+   {
+      socket->options &= ~SOCKET_OPTION_TCP_FAST_OPEN;
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Not implemented
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Allow several listening sockets to share the same port
+ *
+ * Listening sockets bound to the same local address and port with this option
+ * set form a group. Incoming connection requests are spread across the members
+ * of the group by hashing the address and port of the remote host, so that
+ * each member can be served by its own task
+ *
+ * @param[in] socket Handle to a socket
+ * @param[in] enabled Specifies whether the port can be shared
+ * @return Error code
+ **/
+
+error_t socketEnableReusePort(Socket *socket, bool_t enabled)
+{
+#if (TCP_SUPPORT == ENABLED && TCP_REUSE_PORT_SUPPORT == ENABLED)
+   //Make sure the socket handle is valid
+   if(socket == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Check whether the port can be shared
+   if(enabled)
+   {
+      socket->options |= SOCKET_OPTION_REUSE_PORT;
+   }
+   else
+   {
+      socket->options &= ~SOCKET_OPTION_REUSE_PORT;
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Not implemented
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Attach a packet filter to a raw socket
+ *
+ * The filter program is run against every packet matching the socket before
+ * any memory is allocated for it. Its return value gives the number of bytes
+ * to be queued, 0 meaning that the packet is dropped. The program is copied,
+ * so the caller does not need to keep it around. Offsets are relative to the
+ * data returned by socketReceive(), i.e. the Ethernet header for raw Ethernet
+ * sockets and the IP payload for raw IP sockets
+ *
+ * @param[in] socket Handle to a socket
+ * @param[in] insns Pointer to the classic BPF program
+ * @param[in] count Number of instructions
+ * @return Error code
+ **/
+
+error_t socketAttachFilter(Socket *socket, const BpfInsn *insns,
+   uint_t count)
+{
+#if (RAW_SOCKET_SUPPORT == ENABLED && SOCKET_FILTER_SUPPORT == ENABLED)
+   error_t error;
+   BpfInsn *filter;
+   BpfInsn *prevFilter;
+
+   //Make sure the socket handle is valid
+   if(socket == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Packet filters apply to raw sockets only
+   if(socket->type != SOCKET_TYPE_RAW_IP &&
+      socket->type != SOCKET_TYPE_RAW_ETH)
+   {
+      return ERROR_INVALID_SOCKET;
+   }
+
+   //Reject programs that could misbehave at run time
+   error = bpfCheckProgram(insns, count);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //Allocate a memory block to hold a copy of the program
+   filter = osAllocMem(count * sizeof(BpfInsn));
+   //Failed to allocate memory?
+   if(filter == NULL)
+      return ERROR_OUT_OF_MEMORY;
+
+   //Copy the program
+   osMemcpy(filter, insns, count * sizeof(BpfInsn));
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Replace the previous filter, if any
+   prevFilter = socket->filter;
+   socket->filter = filter;
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Release the previous filter
+   if(prevFilter != NULL)
+   {
+      osFreeMem(prevFilter);
+   }
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Not implemented
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Remove the packet filter attached to a raw socket
+ * @param[in] socket Handle to a socket
+ * @return Error code
+ **/
+
+error_t socketDetachFilter(Socket *socket)
+{
+#if (RAW_SOCKET_SUPPORT == ENABLED && SOCKET_FILTER_SUPPORT == ENABLED)
+   BpfInsn *filter;
+
+   //Make sure the socket handle is valid
+   if(socket == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Detach the filter
+   filter = socket->filter;
+   socket->filter = NULL;
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //No filter attached to the socket?
+   if(filter == NULL)
+      return ERROR_NOT_FOUND;
+
+   //Release the filter
+   osFreeMem(filter);
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Not implemented
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
+/**
+ * @brief Retrieve TCP connection statistics
+ * @param[in] socket Handle to a socket
+ * @param[out] stats Statistics of the TCP connection
+ * @return Error code
+ **/
+
+error_t socketGetTcpStats(Socket *socket, TcpStats *stats)
+{
+#if (TCP_SUPPORT == ENABLED)
+   //Check parameters
+   if(socket == NULL || stats == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Make sure the socket is a TCP socket
+   if(socket->type != SOCKET_TYPE_STREAM)
+      return ERROR_INVALID_SOCKET;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //Copy statistics
+   *stats = socket->stats;
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   //Not implemented
+   return ERROR_NOT_IMPLEMENTED;
+#endif
+}
+
+
 /**
  * @brief Specify the size of the TCP send buffer
  * @param[in] socket Handle to a socket
@@ -1219,6 +1511,11 @@ error_t socketSetTxBufferSize(Socket *socket, size_t size)
 
    //Use the specified buffer size
    socket->txBufferSize = size;
+
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
+   //An explicit buffer size disables auto-tuning
+   socket->txBufferLocked = TRUE;
+#endif
    //No error to report
    return NO_ERROR;
 #else
@@ -1255,6 +1552,11 @@ error_t socketSetRxBufferSize(Socket *socket, size_t size)
 
    //Use the specified buffer size
    socket->rxBufferSize = size;
+
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
+   //An explicit buffer size disables auto-tuning
+   socket->rxBufferLocked = TRUE;
+#endif
    //No error to report
    return NO_ERROR;
 #else
@@ -1942,6 +2244,113 @@ error_t socketReceiveMsg(Socket *socket, SocketMsg *message, uint_t flags)
 }
 
 
+/**
+ * @brief Access data received on a connected socket without copying
+ *
+ * The function returns read-only views of the data held in the receive
+ * buffer. A circular buffer may require two views when the data wrap around.
+ * The views remain valid until the corresponding bytes are released with
+ * socketReleaseRef or socketClose is called. The receive buffer is neither
+ * enlarged nor freed while views are outstanding. socketReceive must not be
+ * used while views are outstanding
+ *
+ * @param[in] socket Handle that identifies a connected socket
+ * @param[out] ref Array of views describing contiguous blocks of data
+ * @param[in] maxRefs Maximum number of views
+ * @param[out] numRefs Number of views that have been filled
+ * @param[out] length Total number of bytes described by the views
+ * @param[in] flags Set of flags that influences the behavior of this function
+ * @return Error code
+ **/
+
+error_t socketReceiveRef(Socket *socket, TcpRxBufferRef *ref, uint_t maxRefs,
+   uint_t *numRefs, size_t *length, uint_t flags)
+{
+   error_t error;
+
+   //Check parameters
+   if(socket == NULL || ref == NULL || maxRefs == 0 || numRefs == NULL ||
+      length == NULL)
+   {
+      return ERROR_INVALID_PARAMETER;
+   }
+
+   //No data has been mapped yet
+   *numRefs = 0;
+   *length = 0;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+#if (TCP_SUPPORT == ENABLED)
+   //Connection-oriented socket?
+   if(socket->type == SOCKET_TYPE_STREAM)
+   {
+      //Map received data
+      error = tcpReceiveRef(socket, ref, maxRefs, numRefs, length, flags);
+   }
+   else
+#endif
+   //Invalid socket type?
+   {
+      //Report an error
+      error = ERROR_INVALID_SOCKET;
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Release data previously accessed with socketReceiveRef
+ *
+ * The released bytes are consumed and the receive window is reopened
+ * accordingly. The views of the bytes that have not been released yet remain
+ * valid
+ *
+ * @param[in] socket Handle that identifies a connected socket
+ * @param[in] length Number of bytes to consume
+ * @return Error code
+ **/
+
+error_t socketReleaseRef(Socket *socket, size_t length)
+{
+   error_t error;
+
+   //Make sure the socket handle is valid
+   if(socket == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+#if (TCP_SUPPORT == ENABLED)
+   //Connection-oriented socket?
+   if(socket->type == SOCKET_TYPE_STREAM)
+   {
+      //Consume data
+      error = tcpReleaseRef(socket, length);
+   }
+   else
+#endif
+   //Invalid socket type?
+   {
+      //Report an error
+      error = ERROR_INVALID_SOCKET;
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
 /**
  * @brief Retrieve the local address for a given socket
  * @param[in] socket Handle that identifies a socket
@@ -2086,7 +2495,7 @@ void socketClose(Socket *socket)
          if(groupAddr.length != 0)
          {
             //Delete entry
-            socket->multicastGroups[i].addr = IP_ADDR_UNSPECIFIED;
+            socketDeleteMulticastGroupEntry(&socket->multicastGroups[i]);
 
             //Update the multicast reception state of the interface
             ipUpdateMulticastFilter(socket->interface, &groupAddr);
@@ -2123,6 +2532,15 @@ void socketClose(Socket *socket)
          queueItem = nextQueueItem;
       }
 
+#if (RAW_SOCKET_SUPPORT == ENABLED && SOCKET_FILTER_SUPPORT == ENABLED)
+      //Release the packet filter, if any
+      if(socket->filter != NULL)
+      {
+         osFreeMem(socket->filter);
+         socket->filter = NULL;
+      }
+#endif
+
       //Mark the socket as closed
       socket->type = SOCKET_TYPE_UNUSED;
    }
@@ -40,6 +40,7 @@ struct _Socket;
 #include "core/ethernet.h"
 #include "core/ip.h"
 #include "core/tcp.h"
+#include "core/bpf.h"
 
 //Number of sockets that can be opened simultaneously
 #ifndef SOCKET_MAX_COUNT
@@ -62,6 +63,27 @@ struct _Socket;
    #error SOCKET_MAX_MULTICAST_SOURCES parameter is not valid
 #endif
 
+//Size of the multicast group index
+#ifndef SOCKET_MULTICAST_HASH_TABLE_SIZE
+   #define SOCKET_MULTICAST_HASH_TABLE_SIZE 8
+#elif (SOCKET_MULTICAST_HASH_TABLE_SIZE < 1)
+   #error SOCKET_MULTICAST_HASH_TABLE_SIZE parameter is not valid
+#endif
+
+//Per-socket route cache
+#ifndef SOCKET_ROUTE_CACHE_SUPPORT
+   #define SOCKET_ROUTE_CACHE_SUPPORT DISABLED
+#elif (SOCKET_ROUTE_CACHE_SUPPORT != ENABLED && SOCKET_ROUTE_CACHE_SUPPORT != DISABLED)
+   #error SOCKET_ROUTE_CACHE_SUPPORT parameter is not valid
+#endif
+
+//Packet filters on raw sockets
+#ifndef SOCKET_FILTER_SUPPORT
+   #define SOCKET_FILTER_SUPPORT DISABLED
+#elif (SOCKET_FILTER_SUPPORT != ENABLED && SOCKET_FILTER_SUPPORT != DISABLED)
+   #error SOCKET_FILTER_SUPPORT parameter is not valid
+#endif
+
 //Dynamic port range (lower limit)
 #ifndef SOCKET_EPHEMERAL_PORT_MIN
    #define SOCKET_EPHEMERAL_PORT_MIN 49152
@@ -203,7 +225,10 @@ typedef enum
    SOCKET_OPTION_IPV6_RECV_TRAFFIC_CLASS = 0x0800,
    SOCKET_OPTION_IPV6_RECV_HOP_LIMIT     = 0x1000,
    SOCKET_OPTION_TCP_NO_DELAY            = 0x2000,
-   SOCKET_OPTION_UDP_NO_CHECKSUM         = 0x4000
+   SOCKET_OPTION_UDP_NO_CHECKSUM         = 0x4000,
+   SOCKET_OPTION_TCP_QUICK_ACK           = 0x8000,
+   SOCKET_OPTION_TCP_FAST_OPEN           = 0x10000,
+   SOCKET_OPTION_REUSE_PORT              = 0x20000
 } SocketOptions;
 
 
@@ -269,7 +294,7 @@ typedef struct
  * @brief Multicast group
  **/
 
-typedef struct
+typedef struct _SocketMulticastGroup
 {
    IpAddr addr;                                  ///<Multicast address
 #if (SOCKET_MAX_MULTICAST_SOURCES > 0)
@@ -277,9 +302,27 @@ typedef struct
    uint_t numSources;                            ///<Number of source addresses
    IpAddr sources[SOCKET_MAX_MULTICAST_SOURCES]; ///<Source addresses
 #endif
+   Socket *socket;                               ///<Subscribing socket
+   struct _SocketMulticastGroup *next;           ///<Next subscriber in the same bucket
 } SocketMulticastGroup;
 
 
+/**
+ * @brief Route cache
+ **/
+
+typedef struct
+{
+   uint_t generation;       ///<Value of the route cache generation counter when the entry was filled
+   NetInterface *interface; ///<Outgoing network interface
+   IpAddr srcIpAddr;        ///<Source IP address
+   IpAddr destIpAddr;       ///<Destination IP address
+#if (ETH_SUPPORT == ENABLED)
+   MacAddr destMacAddr;     ///<MAC address of the next hop
+#endif
+} SocketRouteCache;
+
+
 /**
  * @brief Receive queue item
  **/
@@ -326,6 +369,12 @@ struct _Socket
 #if (ETH_VMAN_SUPPORT == ENABLED)
    int8_t vmanPcp;                ///<VMAN priority (802.1ad)
    int8_t vmanDei;                ///<Drop eligible indicator
+#endif
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+   SocketRouteCache routeCache;   ///<Route cache
+#endif
+#if (SOCKET_FILTER_SUPPORT == ENABLED)
+   BpfInsn *filter;               ///<Attached packet filter
 #endif
    int_t errnoCode;
    OsEvent event;
@@ -387,13 +436,57 @@ struct _Socket
    bool_t sackPermitted;          ///<SACK Permitted option received
 #endif
 
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+   bool_t wndScaleEnabled;        ///<Window scale option exchanged in both directions
+   uint8_t sndWndShift;           ///<Shift count applied to the windows advertised by the peer
+#endif
+
+#if (TCP_DELAYED_ACK_SUPPORT == ENABLED)
+   uint32_t rcvAckPending;        ///<Amount of data received but not yet acknowledged
+   NetTimer delayedAckTimer;      ///<Delayed ACK timer
+#endif
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   bool_t fastOpenPending;        ///<The SYN is deferred until data are sent (TCP Fast Open)
+   bool_t fastOpenAccepted;       ///<Data carried by the SYN have been accepted
+   bool_t fastOpenOption;         ///<Append a TFO option to the next SYN segment
+   uint8_t fastOpenCookie[TCP_FAST_OPEN_MAX_COOKIE_SIZE]; ///<TFO cookie
+   size_t fastOpenCookieLen;      ///<Length of the TFO cookie
+#endif
+
+#if (TCP_PACING_SUPPORT == ENABLED)
+   uint32_t pacingRate;           ///<Pacing rate, in bytes per second
+   int32_t pacingCredit;          ///<Number of bytes that can be sent without delay
+   systime_t pacingTimestamp;     ///<Time of the last credit update
+   bool_t pacingPending;          ///<Segments are held back by pacing
+   uint_t pacingFlags;            ///<Flags to be used when releasing held segments
+#endif
+
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+   size_t pmtuMaxMss;             ///<MSS negotiated during connection establishment
+   size_t pmtuSearchHigh;         ///<Largest MSS candidate that has not failed
+   size_t pmtuProbeSize;          ///<Size of the outstanding PMTU probe
+   uint32_t pmtuProbeSeqNum;      ///<Sequence number of the outstanding PMTU probe
+   systime_t pmtuProbeTimestamp;  ///<Time at which the next probe may be sent
+#endif
+
    TcpSackBlock sackBlock[TCP_MAX_SACK_BLOCKS]; ///<List of non-contiguous blocks that have been received
    uint_t sackBlockCount;                       ///<Number of non-contiguous blocks that have been received
 
    TcpTxBuffer txBuffer;          ///<Send buffer
    size_t txBufferSize;           ///<Size of the send buffer
+   uint32_t txBufferOffset;       ///<Offset applied to sequence numbers when addressing the send buffer
    TcpRxBuffer rxBuffer;          ///<Receive buffer
    size_t rxBufferSize;           ///<Size of the receive buffer
+   uint32_t rxBufferOffset;       ///<Offset applied to sequence numbers when addressing the receive buffer
+   size_t rxRefLength;            ///<Number of bytes of the receive buffer mapped by outstanding views
+
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
+   bool_t txBufferLocked;         ///<The size of the send buffer has been set by the user
+   bool_t rxBufferLocked;         ///<The size of the receive buffer has been set by the user
+   size_t rcvSpaceCopied;         ///<Number of bytes read by the application during the current RTT
+   systime_t rcvSpaceTimestamp;   ///<Start of the current measurement interval
+#endif
 
    TcpQueueItem *retransmitQueue; ///<Retransmission queue
    NetTimer retransmitTimer;      ///<Retransmission timer
@@ -409,6 +502,8 @@ struct _Socket
    NetTimer overrideTimer;        ///<Override timer
    NetTimer finWait2Timer;        ///<FIN-WAIT-2 timer
    NetTimer timeWaitTimer;        ///<2MSL timer
+
+   TcpStats stats;                ///<TCP connection statistics
 #endif
 
 //UDP specific variables
@@ -436,6 +531,10 @@ extern const SocketMsg SOCKET_DEFAULT_MSG;
 //Global variables
 extern Socket socketTable[SOCKET_MAX_COUNT];
 
+#if (SOCKET_MAX_MULTICAST_GROUPS > 0)
+extern SocketMulticastGroup *socketMulticastIndex[SOCKET_MULTICAST_HASH_TABLE_SIZE];
+#endif
+
 //Socket related functions
 error_t socketInit(void);
 
@@ -483,6 +582,17 @@ error_t socketSetKeepAliveParams(Socket *socket, systime_t idle,
 
 error_t socketSetMaxSegmentSize(Socket *socket, size_t mss);
 
+error_t socketEnableTcpQuickAck(Socket *socket, bool_t enabled);
+error_t socketEnableTcpFastOpen(Socket *socket, bool_t enabled);
+error_t socketEnableReusePort(Socket *socket, bool_t enabled);
+
+error_t socketAttachFilter(Socket *socket, const BpfInsn *insns,
+   uint_t count);
+
+error_t socketDetachFilter(Socket *socket);
+
+error_t socketGetTcpStats(Socket *socket, TcpStats *stats);
+
 error_t socketSetTxBufferSize(Socket *socket, size_t size);
 error_t socketSetRxBufferSize(Socket *socket, size_t size);
 
@@ -519,6 +629,11 @@ error_t socketReceiveEx(Socket *socket, IpAddr *srcIpAddr, uint16_t *srcPort,
 
 error_t socketReceiveMsg(Socket *socket, SocketMsg *message, uint_t flags);
 
+error_t socketReceiveRef(Socket *socket, TcpRxBufferRef *ref, uint_t maxRefs,
+   uint_t *numRefs, size_t *length, uint_t flags);
+
+error_t socketReleaseRef(Socket *socket, size_t length);
+
 error_t socketGetLocalAddr(Socket *socket, IpAddr *localIpAddr,
    uint16_t *localPort);
 
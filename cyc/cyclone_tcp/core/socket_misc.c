@@ -317,7 +317,7 @@ bool_t socketMulticastFilter(Socket *socket, const IpAddr *destAddr,
    acceptable = FALSE;
 
    //Loop through multicast groups
-   for(i = 0; i < SOCKET_MAX_MULTICAST_GROUPS; i++)
+   for(i = 0; i < SOCKET_MAX_MULTICAST_GROUPS && !acceptable; i++)
    {
       //Point to the current multicast group
       group = &socket->multicastGroups[i];
@@ -325,45 +325,8 @@ bool_t socketMulticastFilter(Socket *socket, const IpAddr *destAddr,
       //Matching multicast address?
       if(ipCompAddr(&group->addr, destAddr))
       {
-#if (SOCKET_MAX_MULTICAST_SOURCES > 0)
-         uint_t j;
-
-         //Check filter mode
-         if(group->filterMode == IP_FILTER_MODE_INCLUDE)
-         {
-            //In INCLUDE mode, reception of packets sent to the specified
-            //multicast address is requested only from those IP source
-            //addresses listed in the source list
-            for(j = 0; j < SOCKET_MAX_MULTICAST_SOURCES && !acceptable; j++)
-            {
-               //Compare source addresses
-               if(ipCompAddr(&group->sources[j], srcAddr))
-               {
-                  acceptable = TRUE;
-               }
-            }
-         }
-         else
-         {
-            //In EXCLUDE mode, reception of packets sent to the given multicast
-            //address is requested from all IP source addresses except those
-            //listed in the source list
-            acceptable = TRUE;
-
-            //Loop through the list of excluded source addresses
-            for(j = 0; j < group->numSources && acceptable; j++)
-            {
-               //Compare source addresses
-               if(ipCompAddr(&group->sources[j], srcAddr))
-               {
-                  acceptable = FALSE;
-               }
-            }
-         }
-#else
-         //The multicast address is acceptable
-         acceptable = TRUE;
-#endif
+         //Apply the source filter of the group
+         acceptable = socketMulticastSrcFilter(group, srcAddr);
       }
    }
 
@@ -376,6 +339,99 @@ bool_t socketMulticastFilter(Socket *socket, const IpAddr *destAddr,
 }
 
 
+/**
+ * @brief Apply the source filter of a multicast group
+ * @param[in] group Pointer to the multicast group
+ * @param[in] srcAddr Source IP address of the received packet
+ * @return Return TRUE if the multicast packet should be accepted, else FALSE
+ **/
+
+bool_t socketMulticastSrcFilter(const SocketMulticastGroup *group,
+   const IpAddr *srcAddr)
+{
+#if (SOCKET_MAX_MULTICAST_SOURCES > 0)
+   uint_t i;
+
+   //Check filter mode
+   if(group->filterMode == IP_FILTER_MODE_INCLUDE)
+   {
+      //In INCLUDE mode, reception of packets sent to the specified multicast
+      //address is requested only from those IP source addresses listed in
+      //the source list
+      for(i = 0; i < group->numSources; i++)
+      {
+         //Compare source addresses
+         if(ipCompAddr(&group->sources[i], srcAddr))
+            return TRUE;
+      }
+
+      //The source address is not listed
+      return FALSE;
+   }
+   else
+   {
+      //In EXCLUDE mode, reception of packets sent to the given multicast
+      //address is requested from all IP source addresses except those
+      //listed in the source list
+      for(i = 0; i < group->numSources; i++)
+      {
+         //Compare source addresses
+         if(ipCompAddr(&group->sources[i], srcAddr))
+            return FALSE;
+      }
+
+      //The source address is not excluded
+      return TRUE;
+   }
+#else
+   //No source filtering
+   return TRUE;
+#endif
+}
+
+
+/**
+ * @brief Calculate the index of a multicast group address in the group index
+ * @param[in] groupAddr IP address identifying a multicast group
+ * @return Index of the hash bucket
+ **/
+
+uint_t socketGetMulticastHashIndex(const IpAddr *groupAddr)
+{
+   uint32_t h;
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 multicast address?
+   if(groupAddr->length == sizeof(Ipv4Addr))
+   {
+      //The low-order bits identify the group within the class D space
+      h = ntohl(groupAddr->ipv4Addr);
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 multicast address?
+   if(groupAddr->length == sizeof(Ipv6Addr))
+   {
+      //The group ID is carried in the low-order 32 bits
+      h = ntohl(groupAddr->ipv6Addr.dw[3]);
+   }
+   else
+#endif
+   //Invalid multicast address?
+   {
+      h = 0;
+   }
+
+   //Fold the group identifier
+   h ^= h >> 16;
+   h ^= h >> 8;
+
+   //Return the index of the hash bucket
+   return h % SOCKET_MULTICAST_HASH_TABLE_SIZE;
+}
+
+
 /**
  * @brief Create a new multicast group
  * @param[in] socket Handle to a socket
@@ -410,6 +466,12 @@ SocketMulticastGroup *socketCreateMulticastGroupEntry(Socket *socket,
          group->filterMode = IP_FILTER_MODE_EXCLUDE;
          group->numSources = 0;
 #endif
+         //Register the socket as a subscriber of the group
+         group->socket = socket;
+         i = socketGetMulticastHashIndex(groupAddr);
+         group->next = socketMulticastIndex[i];
+         socketMulticastIndex[i] = group;
+
          //We are done
          break;
       }
@@ -470,8 +532,29 @@ SocketMulticastGroup *socketFindMulticastGroupEntry(Socket *socket,
 
 void socketDeleteMulticastGroupEntry(SocketMulticastGroup *group)
 {
+#if (SOCKET_MAX_MULTICAST_GROUPS > 0)
+   SocketMulticastGroup **p;
+
+   //Walk the bucket the group address hashes to
+   p = &socketMulticastIndex[socketGetMulticastHashIndex(&group->addr)];
+
+   //Unlink the entry from the multicast group index
+   while(*p != NULL)
+   {
+      if(*p == group)
+      {
+         *p = group->next;
+         break;
+      }
+
+      p = &(*p)->next;
+   }
+
    //Delete the specified entry
    group->addr = IP_ADDR_UNSPECIFIED;
+   group->socket = NULL;
+   group->next = NULL;
+#endif
 }
 
 
@@ -589,3 +672,126 @@ int_t socketFindMulticastSrcAddr(SocketMulticastGroup *group,
    return -1;
 #endif
 }
+
+
+/**
+ * @brief Retrieve the route information cached by a socket
+ *
+ * The cached entry is valid as long as no route, address or neighbor change
+ * has occurred since it was filled
+ *
+ * @param[in] socket Handle to a socket
+ * @param[in,out] interface Outgoing network interface (NULL if unspecified)
+ * @param[in,out] srcIpAddr Source IP address (zero-length address if the
+ *   source address has to be selected by the stack)
+ * @param[in] destIpAddr Destination IP address
+ * @param[in,out] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return TRUE if the route cache provided the information, else FALSE
+ **/
+
+bool_t socketGetRouteCache(Socket *socket, NetInterface **interface,
+   IpAddr *srcIpAddr, const IpAddr *destIpAddr, NetTxAncillary *ancillary)
+{
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+   bool_t valid;
+   SocketRouteCache *cache;
+
+   //Point to the route cache
+   cache = &socket->routeCache;
+
+   //Check whether the entry is still up-to-date
+   if(cache->interface != NULL &&
+      cache->generation == netContext.routeCacheGeneration)
+   {
+      //The entry must match the destination, the network interface and the
+      //source address of the packet
+      if(!ipCompAddr(&cache->destIpAddr, destIpAddr))
+      {
+         valid = FALSE;
+      }
+      else if(*interface != NULL && *interface != cache->interface)
+      {
+         valid = FALSE;
+      }
+      else if(srcIpAddr->length != 0 &&
+         !ipCompAddr(srcIpAddr, &cache->srcIpAddr))
+      {
+         valid = FALSE;
+      }
+      else
+      {
+         valid = TRUE;
+      }
+   }
+   else
+   {
+      valid = FALSE;
+   }
+
+   //Cache hit?
+   if(valid)
+   {
+      //Use the cached network interface and source address
+      *interface = cache->interface;
+      *srcIpAddr = cache->srcIpAddr;
+
+#if (ETH_SUPPORT == ENABLED)
+      //The next hop does not need to be resolved again
+      ancillary->destMacAddr = cache->destMacAddr;
+#endif
+   }
+   else
+   {
+      //Invalidate the entry. Changes that occur while the packet is being
+      //sent will not go unnoticed
+      cache->interface = NULL;
+      cache->generation = netContext.routeCacheGeneration;
+   }
+
+   //Return TRUE if the route cache provided the information
+   return valid;
+#else
+   //Not implemented
+   return FALSE;
+#endif
+}
+
+
+/**
+ * @brief Save the route information used to send a packet
+ * @param[in] socket Handle to a socket
+ * @param[in] interface Outgoing network interface
+ * @param[in] srcIpAddr Source IP address
+ * @param[in] destIpAddr Destination IP address
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet (the MAC address of the next hop is filled by the IP layer
+ *   when address resolution completes)
+ **/
+
+void socketUpdateRouteCache(Socket *socket, NetInterface *interface,
+   const IpAddr *srcIpAddr, const IpAddr *destIpAddr,
+   const NetTxAncillary *ancillary)
+{
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+   SocketRouteCache *cache;
+
+   //Point to the route cache
+   cache = &socket->routeCache;
+
+#if (ETH_SUPPORT == ENABLED)
+   //The entry is only worth caching once the next hop has been resolved
+   if(macCompAddr(&ancillary->destMacAddr, &MAC_UNSPECIFIED_ADDR))
+      return;
+
+   //Save the MAC address of the next hop
+   cache->destMacAddr = ancillary->destMacAddr;
+#endif
+
+   //Save the network interface and the addresses. The generation counter
+   //was sampled before the packet was sent
+   cache->interface = interface;
+   cache->srcIpAddr = *srcIpAddr;
+   cache->destIpAddr = *destIpAddr;
+#endif
+}
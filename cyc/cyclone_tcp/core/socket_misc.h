@@ -50,6 +50,11 @@ uint_t socketGetEvents(Socket *socket);
 bool_t socketMulticastFilter(Socket *socket, const IpAddr *destAddr,
    const IpAddr *srcAddr);
 
+bool_t socketMulticastSrcFilter(const SocketMulticastGroup *group,
+   const IpAddr *srcAddr);
+
+uint_t socketGetMulticastHashIndex(const IpAddr *groupAddr);
+
 SocketMulticastGroup *socketCreateMulticastGroupEntry(Socket *socket,
    const IpAddr *groupAddr);
 
@@ -67,6 +72,13 @@ void socketRemoveMulticastSrcAddr(SocketMulticastGroup *group,
 int_t socketFindMulticastSrcAddr(SocketMulticastGroup *group,
    const IpAddr *srcAddr);
 
+bool_t socketGetRouteCache(Socket *socket, NetInterface **interface,
+   IpAddr *srcIpAddr, const IpAddr *destIpAddr, NetTxAncillary *ancillary);
+
+void socketUpdateRouteCache(Socket *socket, NetInterface *interface,
+   const IpAddr *srcIpAddr, const IpAddr *destIpAddr,
+   const NetTxAncillary *ancillary);
+
 //C++ guard
 #ifdef __cplusplus
 }
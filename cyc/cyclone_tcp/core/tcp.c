@@ -51,6 +51,21 @@ systime_t tcpTickCounter;
 //Ephemeral ports are used for dynamic port assignment
 static uint16_t tcpDynamicPort;
 
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+//TIME-WAIT table
+TcpTimeWaitEntry tcpTimeWaitTable[TCP_TIME_WAIT_TABLE_SIZE];
+#endif
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+//TFO cookie cache
+TcpFastOpenCacheEntry tcpFastOpenCache[TCP_FAST_OPEN_CACHE_SIZE];
+#endif
+
+#if (TCP_PACING_SUPPORT == ENABLED)
+//Segments are held back by TCP pacing
+bool_t tcpPacingPending;
+#endif
+
 
 /**
  * @brief TCP related initialization
@@ -62,6 +77,21 @@ error_t tcpInit(void)
    //Reset ephemeral port number
    tcpDynamicPort = 0;
 
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+   //Clear the TIME-WAIT table
+   osMemset(tcpTimeWaitTable, 0, sizeof(tcpTimeWaitTable));
+#endif
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //Clear the TFO cookie cache
+   osMemset(tcpFastOpenCache, 0, sizeof(tcpFastOpenCache));
+#endif
+
+#if (TCP_PACING_SUPPORT == ENABLED)
+   //No segment is held back by TCP pacing
+   tcpPacingPending = FALSE;
+#endif
+
    //Successful initialization
    return NO_ERROR;
 }
@@ -242,11 +272,23 @@ error_t tcpConnect(Socket *socket, const IpAddr *remoteIpAddr,
       socket->recover = socket->iss;
 #endif
 
-      //Send a SYN segment
-      error = tcpSendSegment(socket, TCP_FLAG_SYN, socket->iss, 0, 0, TRUE);
-      //Failed to send TCP segment?
-      if(error)
-         return error;
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //TCP Fast Open enabled?
+      if((socket->options & SOCKET_OPTION_TCP_FAST_OPEN) != 0)
+      {
+         //Defer the transmission of the SYN until the first data are
+         //available, so that they can be carried by the SYN
+         socket->fastOpenPending = TRUE;
+      }
+      else
+#endif
+      {
+         //Send a SYN segment
+         error = tcpSendSegment(socket, TCP_FLAG_SYN, socket->iss, 0, 0, TRUE);
+         //Failed to send TCP segment?
+         if(error)
+            return error;
+      }
 
       //Switch to the SYN-SENT state
       tcpChangeState(socket, TCP_STATE_SYN_SENT);
@@ -257,6 +299,12 @@ error_t tcpConnect(Socket *socket, const IpAddr *remoteIpAddr,
       TCP_MIB_INC_COUNTER32(tcpActiveOpens, 1);
    }
 
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //The connection is completed by the first call to tcpSend or tcpReceive
+   if(socket->state == TCP_STATE_SYN_SENT && socket->fastOpenPending)
+      return NO_ERROR;
+#endif
+
    //Wait for the connection to be established
    event = tcpWaitForEvents(socket, SOCKET_EVENT_CONNECTED |
       SOCKET_EVENT_CLOSED, socket->timeout);
@@ -388,6 +436,12 @@ Socket *tcpAccept(Socket *socket, IpAddr *clientIpAddr, uint16_t *clientPort)
          newSocket->txBufferSize = socket->txBufferSize;
          newSocket->rxBufferSize = socket->rxBufferSize;
 
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
+         //Inherit auto-tuning settings from the listening socket
+         newSocket->txBufferLocked = socket->txBufferLocked;
+         newSocket->rxBufferLocked = socket->rxBufferLocked;
+#endif
+
 #if (TCP_KEEP_ALIVE_SUPPORT == ENABLED)
          //Inherit keep-alive parameters from the listening socket
          newSocket->keepAliveEnabled = socket->keepAliveEnabled;
@@ -429,14 +483,30 @@ Socket *tcpAccept(Socket *socket, IpAddr *clientIpAddr, uint16_t *clientPort)
             //transmit
             newSocket->smss = queueItem->mss;
 
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+            //The MSS cannot exceed the PMTU
+            tcpInitPathMtu(newSocket);
+#endif
+
             //The RMSS is the size of the largest segment the receiver is
             //willing to accept
             newSocket->rmss = MIN(newSocket->mss, newSocket->rxBufferSize);
 
-            //Generate the initial sequence number
-            newSocket->iss = tcpGenerateInitialSeqNum(&newSocket->localIpAddr,
-               newSocket->localPort, &newSocket->remoteIpAddr,
-               newSocket->remotePort);
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+            //Connection reconstructed from a SYN cookie?
+            if(queueItem->synCookie)
+            {
+               //The SYN cookie was used as initial sequence number
+               newSocket->iss = queueItem->iss;
+            }
+            else
+#endif
+            {
+               //Generate the initial sequence number
+               newSocket->iss = tcpGenerateInitialSeqNum(&newSocket->localIpAddr,
+                  newSocket->localPort, &newSocket->remoteIpAddr,
+                  newSocket->remotePort);
+            }
 
             //Initialize TCP control block
             newSocket->irs = queueItem->isn;
@@ -469,17 +539,88 @@ Socket *tcpAccept(Socket *socket, IpAddr *clientIpAddr, uint16_t *clientPort)
             //is established
             newSocket->sackPermitted = queueItem->sackPermitted;
 #endif
-            //The connection state should be changed to SYN-RECEIVED
-            tcpChangeState(newSocket, TCP_STATE_SYN_RECEIVED);
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+            //Windows are scaled once the option has been exchanged in both
+            //directions (refer to RFC 7323, section 2.2)
+            newSocket->wndScaleEnabled = queueItem->wndScaleEnabled;
+            newSocket->sndWndShift = queueItem->sndWndShift;
+#endif
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+            //Did the SYN carry data along with a valid TFO cookie?
+            if(queueItem->fastOpenDataLen > 0)
+            {
+               //Copy the data to the receive buffer
+               netBufferWrite((NetBuffer *) &newSocket->rxBuffer, 0,
+                  queueItem->fastOpenData, queueItem->fastOpenDataLen);
+
+               //The data will be acknowledged by the SYN ACK
+               newSocket->rcvNxt += queueItem->fastOpenDataLen;
+               newSocket->rcvUser = queueItem->fastOpenDataLen;
+               newSocket->rcvWnd -= queueItem->fastOpenDataLen;
+
+               //The server may send data before the handshake is complete
+               newSocket->sndWnd = queueItem->window;
+               newSocket->sndWl1 = newSocket->rcvNxt;
+               newSocket->sndWl2 = newSocket->sndUna;
+               newSocket->maxSndWnd = queueItem->window;
+
+               //The connection is usable as soon as it has been accepted
+               newSocket->fastOpenAccepted = TRUE;
+               //Number of SYN segments whose data have been accepted
+               socket->stats.fastOpenAccepted++;
+            }
+            else if(queueItem->fastOpenCookieRequest)
+            {
+               //Return a cookie in the SYN ACK (refer to RFC 7413,
+               //section 4.1.2)
+               tcpGenerateFastOpenCookie(&newSocket->remoteIpAddr,
+                  newSocket->fastOpenCookie);
+
+               newSocket->fastOpenCookieLen = TCP_FAST_OPEN_COOKIE_SIZE;
+               newSocket->fastOpenOption = TRUE;
+            }
+            else
+            {
+               //Regular connection
+            }
+#endif
 
             //Number of times TCP connections have made a direct transition to
             //the SYN-RECEIVED state from the LISTEN state
             MIB2_TCP_INC_COUNTER32(tcpPassiveOpens, 1);
             TCP_MIB_INC_COUNTER32(tcpPassiveOpens, 1);
 
-            //Send a SYN ACK control segment
-            error = tcpSendSegment(newSocket, TCP_FLAG_SYN | TCP_FLAG_ACK,
-               newSocket->iss, newSocket->rcvNxt, 0, TRUE);
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+            //Connection reconstructed from a SYN cookie?
+            if(queueItem->synCookie)
+            {
+               //The SYN ACK has already been acknowledged by the remote host
+               newSocket->sndUna = newSocket->sndNxt;
+
+               //Update the send window before entering ESTABLISHED state
+               newSocket->sndWnd = queueItem->window;
+               newSocket->sndWl1 = newSocket->rcvNxt;
+               newSocket->sndWl2 = newSocket->sndNxt;
+
+               //Maximum send window it has seen so far on the connection
+               newSocket->maxSndWnd = queueItem->window;
+
+               //The three-way handshake is already complete
+               tcpChangeState(newSocket, TCP_STATE_ESTABLISHED);
+
+               //Successful processing
+               error = NO_ERROR;
+            }
+            else
+#endif
+            {
+               //The connection state should be changed to SYN-RECEIVED
+               tcpChangeState(newSocket, TCP_STATE_SYN_RECEIVED);
+
+               //Send a SYN ACK control segment
+               error = tcpSendSegment(newSocket, TCP_FLAG_SYN | TCP_FLAG_ACK,
+                  newSocket->iss, newSocket->rcvNxt, 0, TRUE);
+            }
 
             //TCP segment successfully sent?
             if(!error)
@@ -543,6 +684,37 @@ error_t tcpSend(Socket *socket, const uint8_t *data, size_t length,
    //Actual number of bytes written
    totalLength = 0;
 
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //The SYN has been deferred by a TFO connection attempt?
+   if(socket->state == TCP_STATE_SYN_SENT && socket->fastOpenPending)
+   {
+      error_t error;
+      size_t k;
+
+      //Send the SYN along with the first bytes of data
+      error = tcpSendFastOpenSyn(socket, data, length, &k);
+      //Failed to send TCP segment?
+      if(error)
+         return error;
+
+      //Advance data pointer
+      data += k;
+      //Update byte counter
+      totalLength += k;
+
+      //Total number of data that have been written
+      if(written != NULL)
+         *written = totalLength;
+
+      //Update TX events
+      tcpUpdateEvents(socket);
+
+      //Remaining data will be sent once the connection is established
+      if(totalLength >= length && (flags & SOCKET_FLAG_WAIT_ACK) == 0)
+         return NO_ERROR;
+   }
+#endif
+
    //Send as much data as possible
    do
    {
@@ -562,6 +734,15 @@ error_t tcpSend(Socket *socket, const uint8_t *data, size_t length,
          //The send buffer is now available for writing
          break;
 
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //SYN-RECEIVED state?
+      case TCP_STATE_SYN_RECEIVED:
+         //A TFO server may send data before the handshake is complete
+         if(!socket->fastOpenAccepted)
+            return ERROR_NOT_CONNECTED;
+         break;
+#endif
+
       //LAST-ACK, FIN-WAIT-1, FIN-WAIT-2, CLOSING or TIME-WAIT state?
       case TCP_STATE_LAST_ACK:
       case TCP_STATE_FIN_WAIT_1:
@@ -577,6 +758,11 @@ error_t tcpSend(Socket *socket, const uint8_t *data, size_t length,
          return (socket->resetFlag) ? ERROR_CONNECTION_RESET : ERROR_NOT_CONNECTED;
       }
 
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
+      //Enlarge the send buffer when it limits the throughput
+      tcpAutoTuneTxBuffer(socket, length - totalLength);
+#endif
+
       //Determine the actual number of bytes in the send buffer
       n = socket->sndUser + socket->sndNxt - socket->sndUna;
       //Exit immediately if the transmission buffer is full (sanity check)
@@ -674,6 +860,23 @@ error_t tcpReceive(Socket *socket, uint8_t *data, size_t size,
    if(socket->state == TCP_STATE_LISTEN)
       return ERROR_NOT_CONNECTED;
 
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //The SYN has been deferred by a TFO connection attempt?
+   if(socket->state == TCP_STATE_SYN_SENT && socket->fastOpenPending)
+   {
+      error_t error;
+
+      //No data is available, so the SYN requests a cookie only
+      error = tcpSendFastOpenSyn(socket, NULL, 0, NULL);
+      //Failed to send TCP segment?
+      if(error)
+         return error;
+
+      //Update events
+      tcpUpdateEvents(socket);
+   }
+#endif
+
    //Read as much data as possible
    while(*received < size)
    {
@@ -686,9 +889,20 @@ error_t tcpReceive(Socket *socket, uint8_t *data, size_t size,
       if(event != SOCKET_EVENT_RX_READY)
          return ERROR_TIMEOUT;
 
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //Data carried by the SYN can be read before the handshake is complete,
+      //provided that the Fast Open cookie has been accepted
+      if(socket->state == TCP_STATE_SYN_RECEIVED && !socket->fastOpenAccepted)
+         return ERROR_NOT_CONNECTED;
+#endif
+
       //Check current TCP state
       switch(socket->state)
       {
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //SYN-RECEIVED state?
+      case TCP_STATE_SYN_RECEIVED:
+#endif
       //ESTABLISHED, FIN-WAIT-1 or FIN-WAIT-2 state?
       case TCP_STATE_ESTABLISHED:
       case TCP_STATE_FIN_WAIT_1:
@@ -776,6 +990,11 @@ error_t tcpReceive(Socket *socket, uint8_t *data, size_t size,
       //Remaining data still available in the receive buffer
       socket->rcvUser -= n;
 
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
+      //Measure the rate at which the application drains the receive buffer
+      tcpAutoTuneRxBuffer(socket, n);
+#endif
+
       //Update the receive window
       tcpUpdateReceiveWindow(socket);
       //Update RX event state
@@ -805,6 +1024,187 @@ error_t tcpReceive(Socket *socket, uint8_t *data, size_t size,
 }
 
 
+/**
+ * @brief Access received data in place
+ *
+ * The returned views point directly to the receive buffer. The data remain
+ * valid until they are released by tcpReleaseRef
+ *
+ * @param[in] socket Handle that identifies a connected socket
+ * @param[out] ref Array of views describing contiguous blocks of data
+ * @param[in] maxRefs Maximum number of views
+ * @param[out] numRefs Number of views that have been filled
+ * @param[out] length Total number of bytes described by the views
+ * @param[in] flags Set of flags that influences the behavior of this function
+ * @return Error code
+ **/
+
+error_t tcpReceiveRef(Socket *socket, TcpRxBufferRef *ref, uint_t maxRefs,
+   uint_t *numRefs, size_t *length, uint_t flags)
+{
+   uint_t i;
+   uint_t event;
+   uint32_t seqNum;
+   systime_t timeout;
+
+   //No data has been mapped yet
+   *numRefs = 0;
+   *length = 0;
+
+   //Check whether the socket is in the listening state
+   if(socket->state == TCP_STATE_LISTEN)
+      return ERROR_NOT_CONNECTED;
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //The SYN has been deferred by a TFO connection attempt?
+   if(socket->state == TCP_STATE_SYN_SENT && socket->fastOpenPending)
+   {
+      error_t error;
+
+      //No data is available, so the SYN requests a cookie only
+      error = tcpSendFastOpenSyn(socket, NULL, 0, NULL);
+      //Failed to send TCP segment?
+      if(error)
+         return error;
+
+      //Update events
+      tcpUpdateEvents(socket);
+   }
+#endif
+
+   //The SOCKET_FLAG_DONT_WAIT enables non-blocking operation
+   timeout = (flags & SOCKET_FLAG_DONT_WAIT) ? 0 : socket->timeout;
+   //Wait for data to be available for reading
+   event = tcpWaitForEvents(socket, SOCKET_EVENT_RX_READY, timeout);
+
+   //A timeout exception occurred?
+   if(event != SOCKET_EVENT_RX_READY)
+      return ERROR_TIMEOUT;
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //Data carried by the SYN can be read before the handshake is complete,
+   //provided that the Fast Open cookie has been accepted
+   if(socket->state == TCP_STATE_SYN_RECEIVED && !socket->fastOpenAccepted)
+      return ERROR_NOT_CONNECTED;
+#endif
+
+   //Check current TCP state
+   switch(socket->state)
+   {
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //SYN-RECEIVED state?
+   case TCP_STATE_SYN_RECEIVED:
+#endif
+   //ESTABLISHED, FIN-WAIT-1 or FIN-WAIT-2 state?
+   case TCP_STATE_ESTABLISHED:
+   case TCP_STATE_FIN_WAIT_1:
+   case TCP_STATE_FIN_WAIT_2:
+      //Sequence number of the first byte to read
+      seqNum = socket->rcvNxt - socket->rcvUser;
+      break;
+
+   //CLOSE-WAIT, LAST-ACK, CLOSING or TIME-WAIT state?
+   case TCP_STATE_CLOSE_WAIT:
+   case TCP_STATE_LAST_ACK:
+   case TCP_STATE_CLOSING:
+   case TCP_STATE_TIME_WAIT:
+      //The user must be satisfied with data already on hand
+      if(socket->rcvUser == 0)
+         return ERROR_END_OF_STREAM;
+
+      //Sequence number of the first byte to read
+      seqNum = (socket->rcvNxt - 1) - socket->rcvUser;
+      break;
+
+   //CLOSED state?
+   default:
+      //The connection was reset by remote side?
+      if(socket->resetFlag)
+         return ERROR_CONNECTION_RESET;
+
+      //The connection has not yet been established?
+      if(!socket->closedFlag)
+         return ERROR_NOT_CONNECTED;
+
+      //The user must be satisfied with data already on hand
+      if(socket->rcvUser == 0)
+         return ERROR_END_OF_STREAM;
+
+      //Sequence number of the first byte to read
+      seqNum = (socket->rcvNxt - 1) - socket->rcvUser;
+      break;
+   }
+
+   //Sanity check
+   if(socket->rcvUser == 0)
+      return ERROR_FAILURE;
+
+   //Map the data held in the receive buffer
+   *numRefs = tcpGetRxBufferRef(socket, seqNum, socket->rcvUser, ref, maxRefs);
+
+   //Total number of bytes described by the views
+   for(i = 0; i < *numRefs; i++)
+   {
+      *length += ref[i].length;
+   }
+
+   //The receive buffer must not be moved or released while the views are
+   //outstanding
+   socket->rxRefLength = *length;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Release data previously accessed with tcpReceiveRef
+ *
+ * The released data are consumed and the corresponding space is returned to
+ * the receive window. The views of the data that have not been released yet
+ * remain valid
+ *
+ * @param[in] socket Handle that identifies a connected socket
+ * @param[in] length Number of bytes to consume
+ * @return Error code
+ **/
+
+error_t tcpReleaseRef(Socket *socket, size_t length)
+{
+   //Make sure the length is acceptable
+   if(length > socket->rcvUser)
+      return ERROR_INVALID_LENGTH;
+
+   //Consume the data
+   socket->rcvUser -= length;
+   //Update the number of bytes mapped by outstanding views
+   socket->rxRefLength -= MIN(length, socket->rxRefLength);
+
+   //The release of the receive buffer has been deferred? The buffer must be
+   //kept as long as unread data remain (refer to tcpReceiveRef)
+   if(socket->rxRefLength == 0 && socket->rcvUser == 0 &&
+      (socket->state == TCP_STATE_TIME_WAIT ||
+      socket->state == TCP_STATE_CLOSED))
+   {
+      //The TCB has already been deleted
+      netBufferSetLength((NetBuffer *) &socket->rxBuffer, 0);
+   }
+
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
+   //Measure the rate at which the application drains the receive buffer
+   tcpAutoTuneRxBuffer(socket, length);
+#endif
+
+   //Update the receive window
+   tcpUpdateReceiveWindow(socket);
+   //Update RX event state
+   tcpUpdateEvents(socket);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Shutdown gracefully reception, transmission, or both
  *
@@ -825,6 +1225,18 @@ error_t tcpShutdown(Socket *socket, uint_t how)
    //Initialize status code
    error = NO_ERROR;
 
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //The SYN has been deferred by a TFO connection attempt?
+   if(socket->state == TCP_STATE_SYN_SENT && socket->fastOpenPending)
+   {
+      //Complete the three-way handshake before closing the connection
+      error = tcpSendFastOpenSyn(socket, NULL, 0, NULL);
+      //Any error to report?
+      if(error)
+         return error;
+   }
+#endif
+
    //Check whether transmission should be disabled
    if(how == SOCKET_SD_SEND || how == SOCKET_SD_BOTH)
    {
@@ -959,6 +1371,9 @@ error_t tcpAbort(Socket *socket)
 {
    error_t error;
 
+   //The views of the receive buffer are invalidated when the socket is closed
+   socket->rxRefLength = 0;
+
    //Check current state
    switch(socket->state)
    {
@@ -1064,8 +1479,9 @@ Socket *tcpKillOldestConnection(void)
       //TCP connection found?
       if(socket->type == SOCKET_TYPE_STREAM)
       {
-         //Check current state
-         if(socket->state == TCP_STATE_TIME_WAIT)
+         //Check current state (the receive buffer of a connection must not
+         //be released while the user is still accessing it)
+         if(socket->state == TCP_STATE_TIME_WAIT && socket->rxRefLength == 0)
          {
             //Keep track of the oldest socket in the TIME-WAIT state
             if(oldestSocket == NULL)
@@ -91,6 +91,20 @@
    #error TCP_MAX_RX_BUFFER_SIZE parameter is not valid
 #endif
 
+//TCP buffer auto-tuning
+#ifndef TCP_AUTO_TUNING_SUPPORT
+   #define TCP_AUTO_TUNING_SUPPORT DISABLED
+#elif (TCP_AUTO_TUNING_SUPPORT != ENABLED && TCP_AUTO_TUNING_SUPPORT != DISABLED)
+   #error TCP_AUTO_TUNING_SUPPORT parameter is not valid
+#endif
+
+//Percentage of the memory pool that buffer auto-tuning leaves free
+#ifndef TCP_AUTO_TUNING_POOL_RESERVE
+   #define TCP_AUTO_TUNING_POOL_RESERVE 25
+#elif (TCP_AUTO_TUNING_POOL_RESERVE < 0 || TCP_AUTO_TUNING_POOL_RESERVE > 100)
+   #error TCP_AUTO_TUNING_POOL_RESERVE parameter is not valid
+#endif
+
 //Default SYN queue size for listening sockets
 #ifndef TCP_DEFAULT_SYN_QUEUE_SIZE
    #define TCP_DEFAULT_SYN_QUEUE_SIZE 4
@@ -245,10 +259,171 @@
    #error TCP_MAX_SACK_BLOCKS parameter is not valid
 #endif
 
+//Window scale option support
+#ifndef TCP_WINDOW_SCALE_SUPPORT
+   #define TCP_WINDOW_SCALE_SUPPORT DISABLED
+#elif (TCP_WINDOW_SCALE_SUPPORT != ENABLED && TCP_WINDOW_SCALE_SUPPORT != DISABLED)
+   #error TCP_WINDOW_SCALE_SUPPORT parameter is not valid
+#endif
+
+//Delayed ACK support
+#ifndef TCP_DELAYED_ACK_SUPPORT
+   #define TCP_DELAYED_ACK_SUPPORT DISABLED
+#elif (TCP_DELAYED_ACK_SUPPORT != ENABLED && TCP_DELAYED_ACK_SUPPORT != DISABLED)
+   #error TCP_DELAYED_ACK_SUPPORT parameter is not valid
+#endif
+
+//Delayed ACK timeout (must be less than 0.5 seconds)
+#ifndef TCP_DELAYED_ACK_TIMEOUT
+   #define TCP_DELAYED_ACK_TIMEOUT 200
+#elif (TCP_DELAYED_ACK_TIMEOUT < 10 || TCP_DELAYED_ACK_TIMEOUT > 500)
+   #error TCP_DELAYED_ACK_TIMEOUT parameter is not valid
+#endif
+
+//SYN cookie support
+#ifndef TCP_SYN_COOKIE_SUPPORT
+   #define TCP_SYN_COOKIE_SUPPORT DISABLED
+#elif (TCP_SYN_COOKIE_SUPPORT != ENABLED && TCP_SYN_COOKIE_SUPPORT != DISABLED)
+   #error TCP_SYN_COOKIE_SUPPORT parameter is not valid
+#endif
+
+//SYN cookie period (a cookie remains valid for up to two periods)
+#ifndef TCP_SYN_COOKIE_PERIOD
+   #define TCP_SYN_COOKIE_PERIOD 64000
+#elif (TCP_SYN_COOKIE_PERIOD < 1000)
+   #error TCP_SYN_COOKIE_PERIOD parameter is not valid
+#endif
+
+//Compact TIME-WAIT support
+#ifndef TCP_COMPACT_TIME_WAIT_SUPPORT
+   #define TCP_COMPACT_TIME_WAIT_SUPPORT DISABLED
+#elif (TCP_COMPACT_TIME_WAIT_SUPPORT != ENABLED && TCP_COMPACT_TIME_WAIT_SUPPORT != DISABLED)
+   #error TCP_COMPACT_TIME_WAIT_SUPPORT parameter is not valid
+#endif
+
+//Size of the TIME-WAIT table
+#ifndef TCP_TIME_WAIT_TABLE_SIZE
+   #define TCP_TIME_WAIT_TABLE_SIZE 32
+#elif (TCP_TIME_WAIT_TABLE_SIZE < 1)
+   #error TCP_TIME_WAIT_TABLE_SIZE parameter is not valid
+#endif
+
+//TCP Fast Open support
+#ifndef TCP_FAST_OPEN_SUPPORT
+   #define TCP_FAST_OPEN_SUPPORT DISABLED
+#elif (TCP_FAST_OPEN_SUPPORT != ENABLED && TCP_FAST_OPEN_SUPPORT != DISABLED)
+   #error TCP_FAST_OPEN_SUPPORT parameter is not valid
+#endif
+
+//Number of entries in the client-side TFO cookie cache
+#ifndef TCP_FAST_OPEN_CACHE_SIZE
+   #define TCP_FAST_OPEN_CACHE_SIZE 8
+#elif (TCP_FAST_OPEN_CACHE_SIZE < 1)
+   #error TCP_FAST_OPEN_CACHE_SIZE parameter is not valid
+#endif
+
+//Maximum amount of data that can be carried by a SYN segment
+#ifndef TCP_FAST_OPEN_MAX_SYN_DATA
+   #define TCP_FAST_OPEN_MAX_SYN_DATA 536
+#elif (TCP_FAST_OPEN_MAX_SYN_DATA < 1 || TCP_FAST_OPEN_MAX_SYN_DATA > 1220)
+   #error TCP_FAST_OPEN_MAX_SYN_DATA parameter is not valid
+#endif
+
+//TCP pacing support
+#ifndef TCP_PACING_SUPPORT
+   #define TCP_PACING_SUPPORT DISABLED
+#elif (TCP_PACING_SUPPORT != ENABLED && TCP_PACING_SUPPORT != DISABLED)
+   #error TCP_PACING_SUPPORT parameter is not valid
+#endif
+
+//Pacing timer interval
+#ifndef TCP_PACING_TICK_INTERVAL
+   #define TCP_PACING_TICK_INTERVAL 5
+#elif (TCP_PACING_TICK_INTERVAL < 1 || TCP_PACING_TICK_INTERVAL > TCP_TICK_INTERVAL)
+   #error TCP_PACING_TICK_INTERVAL parameter is not valid
+#endif
+
+//Pacing gain during slow start (percentage of cwnd/SRTT)
+#ifndef TCP_PACING_SS_GAIN
+   #define TCP_PACING_SS_GAIN 200
+#elif (TCP_PACING_SS_GAIN < 100)
+   #error TCP_PACING_SS_GAIN parameter is not valid
+#endif
+
+//Pacing gain during congestion avoidance (percentage of cwnd/SRTT)
+#ifndef TCP_PACING_CA_GAIN
+   #define TCP_PACING_CA_GAIN 120
+#elif (TCP_PACING_CA_GAIN < 100)
+   #error TCP_PACING_CA_GAIN parameter is not valid
+#endif
+
+//Maximum burst size, in segments
+#ifndef TCP_PACING_MAX_BURST
+   #define TCP_PACING_MAX_BURST 2
+#elif (TCP_PACING_MAX_BURST < 1)
+   #error TCP_PACING_MAX_BURST parameter is not valid
+#endif
+
+//Header prediction support
+#ifndef TCP_HEADER_PREDICTION_SUPPORT
+   #define TCP_HEADER_PREDICTION_SUPPORT DISABLED
+#elif (TCP_HEADER_PREDICTION_SUPPORT != ENABLED && TCP_HEADER_PREDICTION_SUPPORT != DISABLED)
+   #error TCP_HEADER_PREDICTION_SUPPORT parameter is not valid
+#endif
+
+//Listening socket groups (SO_REUSEPORT)
+#ifndef TCP_REUSE_PORT_SUPPORT
+   #define TCP_REUSE_PORT_SUPPORT DISABLED
+#elif (TCP_REUSE_PORT_SUPPORT != ENABLED && TCP_REUSE_PORT_SUPPORT != DISABLED)
+   #error TCP_REUSE_PORT_SUPPORT parameter is not valid
+#endif
+
+//Packetization-layer PMTU discovery support
+#ifndef TCP_PLPMTUD_SUPPORT
+   #define TCP_PLPMTUD_SUPPORT DISABLED
+#elif (TCP_PLPMTUD_SUPPORT != ENABLED && TCP_PLPMTUD_SUPPORT != DISABLED)
+   #error TCP_PLPMTUD_SUPPORT parameter is not valid
+#endif
+
+//MSS used when a PMTU black hole is detected
+#ifndef TCP_PLPMTUD_BASE_MSS
+   #define TCP_PLPMTUD_BASE_MSS 1024
+#elif (TCP_PLPMTUD_BASE_MSS < TCP_MIN_MSS)
+   #error TCP_PLPMTUD_BASE_MSS parameter is not valid
+#endif
+
+//Interval between two PMTU searches
+#ifndef TCP_PLPMTUD_PROBE_INTERVAL
+   #define TCP_PLPMTUD_PROBE_INTERVAL 600000
+#elif (TCP_PLPMTUD_PROBE_INTERVAL < 1000)
+   #error TCP_PLPMTUD_PROBE_INTERVAL parameter is not valid
+#endif
+
+//The search stops when the probed range is smaller than this value
+#ifndef TCP_PLPMTUD_SEARCH_THRESHOLD
+   #define TCP_PLPMTUD_SEARCH_THRESHOLD 32
+#elif (TCP_PLPMTUD_SEARCH_THRESHOLD < 1)
+   #error TCP_PLPMTUD_SEARCH_THRESHOLD parameter is not valid
+#endif
+
+//Number of retransmissions before the MSS falls back to the base MSS
+#ifndef TCP_PLPMTUD_BLACK_HOLE_RETRIES
+   #define TCP_PLPMTUD_BLACK_HOLE_RETRIES 2
+#elif (TCP_PLPMTUD_BLACK_HOLE_RETRIES < 1)
+   #error TCP_PLPMTUD_BLACK_HOLE_RETRIES parameter is not valid
+#endif
+
+//Size of the TFO cookies generated by the server
+#define TCP_FAST_OPEN_COOKIE_SIZE 8
+//Maximum size of a TFO cookie
+#define TCP_FAST_OPEN_MAX_COOKIE_SIZE 16
+
 //Maximum TCP header length
 #define TCP_MAX_HEADER_LENGTH 60
 //Default maximum segment size
 #define TCP_DEFAULT_MSS 536
+//Maximum shift count of the window scale option
+#define TCP_MAX_WINDOW_SCALE 14
 
 //Sequence number comparison macro
 #define TCP_CMP_SEQ(a, b) ((int32_t) ((a) - (b)))
@@ -318,7 +493,8 @@ typedef enum
    TCP_OPTION_WINDOW_SCALE_FACTOR = 3,
    TCP_OPTION_SACK_PERMITTED      = 4,
    TCP_OPTION_SACK                = 5,
-   TCP_OPTION_TIMESTAMP           = 8
+   TCP_OPTION_TIMESTAMP           = 8,
+   TCP_OPTION_FAST_OPEN_COOKIE    = 34
 } TcpOptionKind;
 
 
@@ -408,6 +584,22 @@ typedef struct _TcpSynQueueItem
 #if (TCP_SACK_SUPPORT == ENABLED)
    bool_t sackPermitted;
 #endif
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+   bool_t wndScaleEnabled;
+   uint8_t sndWndShift;
+#endif
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED || TCP_FAST_OPEN_SUPPORT == ENABLED)
+   uint16_t window;
+#endif
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+   bool_t synCookie;
+   uint32_t iss;
+#endif
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   bool_t fastOpenCookieRequest;
+   size_t fastOpenDataLen;
+   uint8_t fastOpenData[TCP_FAST_OPEN_MAX_SYN_DATA];
+#endif
 } TcpSynQueueItem;
 
 
@@ -422,6 +614,34 @@ typedef struct
 } TcpSackBlock;
 
 
+/**
+ * @brief TCP connection statistics
+ **/
+
+typedef struct
+{
+   uint32_t inDataSegs;       ///<Number of segments received carrying data
+   uint32_t outAckSegs;       ///<Number of pure ACK segments sent
+   uint32_t delayedAcks;      ///<Number of ACKs sent upon expiry of the delayed ACK timer
+   uint32_t quickAcks;        ///<Number of ACKs sent immediately (out-of-order data, PSH or quick ACK mode)
+   uint32_t synCookiesSent;   ///<Number of SYN ACK segments sent with a SYN cookie
+   uint32_t synCookiesValid;  ///<Number of connections reconstructed from a valid SYN cookie
+   uint32_t synCookiesFailed; ///<Number of ACK segments carrying an invalid SYN cookie
+   uint32_t fastOpenAccepted; ///<Number of SYN segments whose data have been accepted (TCP Fast Open)
+   uint32_t pacingRate;       ///<Current pacing rate, in bytes per second
+   uint32_t maxPacingRate;    ///<Highest pacing rate seen on the connection
+   uint32_t pacedSegs;        ///<Number of times a segment has been held back by pacing
+   uint32_t pmtuProbes;       ///<Number of PMTU probes sent
+   uint32_t pmtuProbesFailed; ///<Number of PMTU probes that have been lost
+   uint32_t pmtuBlackHoles;   ///<Number of times a PMTU black hole has been detected
+   uint32_t txBufferGrowths;  ///<Number of times the send buffer has been enlarged
+   uint32_t rxBufferGrowths;  ///<Number of times the receive buffer has been enlarged
+   uint32_t fastPathAcks;     ///<Number of pure ACK segments processed by header prediction
+   uint32_t fastPathData;     ///<Number of in-order data segments processed by header prediction
+   uint32_t slowPathSegs;     ///<Number of segments processed by the ESTABLISHED state handler
+} TcpStats;
+
+
 /**
  * @brief Transmit buffer
  **/
@@ -446,9 +666,73 @@ typedef struct
 } TcpRxBuffer;
 
 
+/**
+ * @brief Read-only view of data held in the receive buffer
+ **/
+
+typedef struct
+{
+   const uint8_t *data; ///<Pointer to the first byte
+   size_t length;       ///<Number of contiguous bytes
+} TcpRxBufferRef;
+
+
+/**
+ * @brief TIME-WAIT table entry
+ *
+ * Compact representation of a connection in the TIME-WAIT state. Only the
+ * information required to answer retransmitted FINs is kept
+ **/
+
+typedef struct
+{
+   bool_t used;
+   IpAddr localIpAddr;
+   uint16_t localPort;
+   IpAddr remoteIpAddr;
+   uint16_t remotePort;
+   uint32_t sndNxt;
+   uint32_t rcvNxt;
+   uint16_t rcvWnd;
+   systime_t expireTime;
+} TcpTimeWaitEntry;
+
+
+/**
+ * @brief TFO cookie cache entry
+ *
+ * Cookie received from a given server, as well as the MSS it advertised
+ * (refer to RFC 7413, section 4.1.3)
+ **/
+
+typedef struct
+{
+   IpAddr serverIpAddr;
+   uint16_t mss;
+   uint8_t cookie[TCP_FAST_OPEN_MAX_COOKIE_SIZE];
+   size_t cookieLen;
+   systime_t timestamp;
+} TcpFastOpenCacheEntry;
+
+
 //Tick counter to handle periodic operations
 extern systime_t tcpTickCounter;
 
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+//TIME-WAIT table
+extern TcpTimeWaitEntry tcpTimeWaitTable[TCP_TIME_WAIT_TABLE_SIZE];
+#endif
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+//TFO cookie cache
+extern TcpFastOpenCacheEntry tcpFastOpenCache[TCP_FAST_OPEN_CACHE_SIZE];
+#endif
+
+#if (TCP_PACING_SUPPORT == ENABLED)
+//Segments are held back by TCP pacing
+extern bool_t tcpPacingPending;
+#endif
+
 //TCP related functions
 error_t tcpInit(void);
 
@@ -468,6 +752,11 @@ error_t tcpSend(Socket *socket, const uint8_t *data, size_t length,
 error_t tcpReceive(Socket *socket, uint8_t *data, size_t size,
    size_t *received, uint_t flags);
 
+error_t tcpReceiveRef(Socket *socket, TcpRxBufferRef *ref, uint_t maxRefs,
+   uint_t *numRefs, size_t *length, uint_t flags);
+
+error_t tcpReleaseRef(Socket *socket, size_t length);
+
 error_t tcpShutdown(Socket *socket, uint_t how);
 error_t tcpAbort(Socket *socket);
 
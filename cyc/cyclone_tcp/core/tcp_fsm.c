@@ -282,6 +282,16 @@ void tcpProcessSegment(NetInterface *interface,
       break;
    }
 
+#if (TCP_REUSE_PORT_SUPPORT == ENABLED)
+   //Several listening sockets may share the same port. The listener is also
+   //needed when a SYN reopens a connection in the TIME-WAIT state
+   if(passiveSocket != NULL && (i >= SOCKET_MAX_COUNT ||
+      socket->state == TCP_STATE_CLOSED))
+   {
+      passiveSocket = tcpSelectListener(passiveSocket, pseudoHeader, segment);
+   }
+#endif
+
    //If no matching socket has been found then try to use the first matching
    //socket in the LISTEN state
    if(i >= SOCKET_MAX_COUNT)
@@ -316,6 +326,46 @@ void tcpProcessSegment(NetInterface *interface,
    segment->window = ntohs(segment->window);
    segment->urgentPointer = ntohs(segment->urgentPointer);
 
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+   //No open connection matches the incoming segment? (the socket of a
+   //connection moved to the TIME-WAIT table stays in the CLOSED state until
+   //it is released by the user)
+   if(i >= SOCKET_MAX_COUNT || socket->state == TCP_STATE_CLOSED)
+   {
+      TcpTimeWaitEntry *entry;
+
+      //Search the TIME-WAIT table for a matching connection
+      entry = tcpFindTimeWaitEntry(pseudoHeader, segment);
+
+      //Connection in the TIME-WAIT state?
+      if(entry != NULL)
+      {
+         //A new connection request may reopen the connection provided that
+         //its ISN is larger than the largest sequence number used on the
+         //previous incarnation (refer to RFC 1122, section 4.2.2.13)
+         if(passiveSocket != NULL &&
+            (segment->flags & (TCP_FLAG_SYN | TCP_FLAG_ACK | TCP_FLAG_RST)) == TCP_FLAG_SYN &&
+            TCP_CMP_SEQ(segment->seqNum, entry->rcvNxt) > 0)
+         {
+            //Release the entry
+            entry->used = FALSE;
+            //Let the listening socket process the SYN (the listener has been
+            //selected in the same way as for a new connection)
+            socket = passiveSocket;
+         }
+         else
+         {
+            //Process the segment on behalf of the connection
+            tcpStateTimeWaitEntry(entry, interface, pseudoHeader, segment,
+               length);
+
+            //We are done
+            return;
+         }
+      }
+   }
+#endif
+
    //Specified port unreachable?
    if(socket == NULL)
    {
@@ -330,6 +380,29 @@ void tcpProcessSegment(NetInterface *interface,
       return;
    }
 
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+   //The window field of a SYN segment is never scaled (refer to RFC 7323,
+   //section 2.2)
+   if(socket->wndScaleEnabled && (segment->flags & TCP_FLAG_SYN) == 0)
+   {
+      segment->window = tcpScaleWindow(segment->window, socket->sndWndShift);
+   }
+#endif
+
+#if (TCP_HEADER_PREDICTION_SUPPORT == ENABLED)
+   //In-order pure ACKs and in-order data segments received on an established
+   //connection bypass the generic processing
+   if(socket->state == TCP_STATE_ESTABLISHED)
+   {
+      //Try the fast path first
+      if(tcpProcessFastPath(socket, segment, buffer, offset, length))
+         return;
+
+      //Number of segments that require the generic processing
+      socket->stats.slowPathSegs++;
+   }
+#endif
+
    //Check current state
    switch(socket->state)
    {
@@ -344,7 +417,8 @@ void tcpProcessSegment(NetInterface *interface,
    case TCP_STATE_LISTEN:
       //A device (normally a server) is waiting to receive a synchronize (SYN)
       //message from a client. It has not yet sent its own SYN message
-      tcpStateListen(socket, interface, pseudoHeader, segment, length);
+      tcpStateListen(socket, interface, pseudoHeader, segment, buffer, offset,
+         length);
       break;
 
    //Process SYN_SENT state
@@ -424,6 +498,165 @@ void tcpProcessSegment(NetInterface *interface,
 }
 
 
+/**
+ * @brief Header prediction
+ *
+ * On an established connection, most segments are either pure ACKs that
+ * acknowledge new data or in-order data segments that acknowledge nothing
+ * new. Such segments are processed here with a handful of tests, skipping
+ * the option parsing and the generic state handling (Van Jacobson's header
+ * prediction)
+ *
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Incoming TCP segment
+ * @param[in] buffer Multi-part buffer containing the incoming TCP segment
+ * @param[in] offset Offset to the first data byte
+ * @param[in] length Length of the segment data
+ * @return TRUE if the segment has been processed, else FALSE
+ **/
+
+bool_t tcpProcessFastPath(Socket *socket, const TcpHeader *segment,
+   const NetBuffer *buffer, size_t offset, size_t length)
+{
+#if (TCP_HEADER_PREDICTION_SUPPORT == ENABLED)
+   bool_t updateFlag;
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   uint_t n;
+#endif
+
+   //Only the ACK and PSH flags may be set, and no option may be present
+   if((segment->flags & (TCP_FLAG_FIN | TCP_FLAG_SYN | TCP_FLAG_RST |
+      TCP_FLAG_ACK | TCP_FLAG_URG)) != TCP_FLAG_ACK ||
+      segment->dataOffset != (sizeof(TcpHeader) / 4))
+   {
+      return FALSE;
+   }
+
+   //The segment must be the next one expected and must not update the send
+   //window
+   if(segment->seqNum != socket->rcvNxt || segment->window != socket->sndWnd)
+      return FALSE;
+
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   //Loss recovery is handled by the slow path
+   if(socket->congestState != TCP_CONGEST_STATE_IDLE || socket->dupAckCount != 0)
+      return FALSE;
+#endif
+
+   //Pure ACK segment?
+   if(length == 0)
+   {
+      //The ACK must acknowledge new data
+      if(TCP_CMP_SEQ(segment->ackNum, socket->sndUna) <= 0 ||
+         TCP_CMP_SEQ(segment->ackNum, socket->sndNxt) > 0)
+      {
+         return FALSE;
+      }
+
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+      //Compute the number of bytes acknowledged by the incoming ACK
+      n = segment->ackNum - socket->sndUna;
+      //Total number of bytes acknowledged during the whole round-trip
+      socket->n += n;
+#endif
+
+      //Update SND.UNA pointer
+      socket->sndUna = segment->ackNum;
+   }
+   else
+   {
+      //The segment must not acknowledge new data
+      if(segment->ackNum != socket->sndUna)
+         return FALSE;
+
+      //The data must fit in the receive window and no data may be queued out
+      //of order
+      if(length > socket->rcvWnd || socket->sackBlockCount != 0)
+         return FALSE;
+   }
+
+#if (TCP_KEEP_ALIVE_SUPPORT == ENABLED)
+   //Check whether TCP keep-alive mechanism is enabled
+   if(socket->keepAliveEnabled)
+   {
+      //Reset keep-alive probe counter
+      socket->keepAliveProbeCount = 0;
+   }
+#endif
+
+   //Record the sequence number and the acknowledgment number of the last
+   //window update
+   socket->sndWl1 = segment->seqNum;
+   socket->sndWl2 = segment->ackNum;
+
+   //Pure ACK segment?
+   if(length == 0)
+   {
+      //Compute retransmission timeout
+      updateFlag = tcpComputeRto(socket);
+      (void) updateFlag;
+
+      //Any segments on the retransmission queue which are thereby entirely
+      //acknowledged are removed
+      tcpUpdateRetransmitQueue(socket);
+
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+      //Slow start algorithm is used when cwnd is lower than ssthresh
+      if(socket->cwnd < socket->ssthresh)
+      {
+         socket->cwnd += MIN(n, socket->smss);
+      }
+      else if(updateFlag)
+      {
+         socket->cwnd += MIN(socket->n, socket->smss);
+      }
+
+      //Limit the size of the congestion window
+      socket->cwnd = MIN(socket->cwnd, socket->txBufferSize);
+#endif
+
+      //Number of pure ACKs processed by header prediction
+      socket->stats.fastPathAcks++;
+
+      //Update TX events
+      tcpUpdateEvents(socket);
+
+      //Send queued data, if any
+      tcpNagleAlgo(socket, 0);
+   }
+   else
+   {
+      //Number of segments received carrying data
+      socket->stats.inDataSegs++;
+      //Number of data segments processed by header prediction
+      socket->stats.fastPathData++;
+
+      //Copy the incoming data to the receive buffer
+      tcpWriteRxBuffer(socket, segment->seqNum, buffer, offset, length);
+
+      //Next sequence number expected on incoming segments
+      socket->rcvNxt += length;
+      //Number of data available in the receive buffer
+      socket->rcvUser += length;
+      //Update the receive window
+      socket->rcvWnd -= length;
+
+      //Acknowledge the received data
+      tcpAcknowledgeData(socket, segment, length, FALSE);
+
+      //Notify user task that data is available
+      tcpUpdateEvents(socket);
+   }
+
+   //The segment has been processed
+   return TRUE;
+#else
+   //Header prediction is not implemented
+   return FALSE;
+#endif
+}
+
+
 /**
  * @brief CLOSED state
  *
@@ -461,11 +694,14 @@ void tcpStateClosed(NetInterface *interface, const IpPseudoHeader *pseudoHeader,
  * @param[in] interface Underlying network interface
  * @param[in] pseudoHeader TCP pseudo header
  * @param[in] segment Incoming TCP segment
+ * @param[in] buffer Multi-part buffer containing the incoming TCP segment
+ * @param[in] offset Offset to the first data byte
  * @param[in] length Length of the segment data
  **/
 
 void tcpStateListen(Socket *socket, NetInterface *interface,
-   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment, size_t length)
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment,
+   const NetBuffer *buffer, size_t offset, size_t length)
 {
    uint_t i;
    const TcpOption *option;
@@ -482,6 +718,23 @@ void tcpStateListen(Socket *socket, NetInterface *interface,
    //LISTEN state
    if((segment->flags & TCP_FLAG_ACK) != 0)
    {
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+      //The final ACK of a handshake that was answered with a SYN cookie?
+      if((segment->flags & TCP_FLAG_SYN) == 0)
+      {
+         //Further segments may arrive before the connection is accepted.
+         //Silently drop them (they will be retransmitted)
+         if(tcpIsDuplicateSyn(socket, pseudoHeader, segment))
+            return;
+
+         //Reconstruct the connection from the SYN cookie
+         if(tcpCheckSynCookie(socket, interface, pseudoHeader,
+            segment) != ERROR_WRONG_COOKIE)
+         {
+            return;
+         }
+      }
+#endif
       //A reset segment should be formed for any arriving ACK-bearing segment
       tcpRejectSegment(interface, pseudoHeader, segment, length);
       //Return immediately
@@ -510,11 +763,19 @@ void tcpStateListen(Socket *socket, NetInterface *interface,
          //Check whether the SYN queue is full
          if(i >= socket->synQueueSize)
          {
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+            //Answer the request with a SYN cookie rather than evicting a
+            //pending connection request (refer to RFC 4987, section 3.6)
+            tcpSendSynCookie(socket, interface, pseudoHeader, segment);
+            //No state is kept for this connection request
+            return;
+#else
             //Remove the first item if the SYN queue runs out of space
             queueItem = socket->synQueue;
             socket->synQueue = queueItem->next;
             //Deallocate memory buffer
             memPoolFree(queueItem);
+#endif
          }
       }
 
@@ -629,6 +890,74 @@ void tcpStateListen(Socket *socket, NetInterface *interface,
       }
 #endif
 
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+      //Get the Window Scale option
+      option = tcpGetOption(segment, TCP_OPTION_WINDOW_SCALE_FACTOR);
+
+      //The option is echoed in the SYN ACK only if it has been received in
+      //the SYN (refer to RFC 7323, section 2.2)
+      if(option != NULL && option->length == 3)
+      {
+         queueItem->wndScaleEnabled = TRUE;
+         queueItem->sndWndShift = MIN(option->value[0], TCP_MAX_WINDOW_SCALE);
+      }
+      else
+      {
+         queueItem->wndScaleEnabled = FALSE;
+         queueItem->sndWndShift = 0;
+      }
+#endif
+
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED || TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //Save the window advertised by the client
+      queueItem->window = segment->window;
+#endif
+
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+      //The SYN ACK will be sent when the connection is accepted
+      queueItem->synCookie = FALSE;
+#endif
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //No data carried by the SYN
+      queueItem->fastOpenCookieRequest = FALSE;
+      queueItem->fastOpenDataLen = 0;
+
+      //TCP Fast Open enabled on the listening socket?
+      if((socket->options & SOCKET_OPTION_TCP_FAST_OPEN) != 0)
+      {
+         //Get the Fast Open Cookie option
+         option = tcpGetOption(segment, TCP_OPTION_FAST_OPEN_COOKIE);
+
+         //Specified option found?
+         if(option != NULL && option->length >= 2)
+         {
+            //Check the cookie supplied by the client
+            if(tcpCheckFastOpenCookie(&queueItem->srcAddr, option->value,
+               option->length - 2))
+            {
+               //The data carried by the SYN can be delivered to the
+               //application before the three-way handshake is complete
+               queueItem->fastOpenDataLen = MIN(length,
+                  TCP_FAST_OPEN_MAX_SYN_DATA);
+
+               queueItem->fastOpenDataLen = MIN(queueItem->fastOpenDataLen,
+                  socket->rxBufferSize);
+
+               //Save the data
+               netBufferRead(queueItem->fastOpenData, buffer, offset,
+                  queueItem->fastOpenDataLen);
+            }
+            else
+            {
+               //An empty or invalid cookie is answered with a fresh cookie,
+               //and the data are ignored (refer to RFC 7413, section 4.2.2)
+               queueItem->fastOpenCookieRequest = TRUE;
+            }
+         }
+      }
+#endif
+
       //Notify user that a connection request is pending
       tcpUpdateEvents(socket);
 
@@ -659,8 +988,10 @@ void tcpStateSynSent(Socket *socket, const TcpHeader *segment, size_t length)
    //Check the ACK bit
    if((segment->flags & TCP_FLAG_ACK) != 0)
    {
-      //Make sure the acknowledgment number is valid
-      if(segment->ackNum != socket->sndNxt)
+      //Make sure the acknowledgment number is valid (SND.UNA < SEG.ACK =<
+      //SND.NXT). The data carried by a TFO SYN may not be acknowledged
+      if(TCP_CMP_SEQ(segment->ackNum, socket->iss) <= 0 ||
+         TCP_CMP_SEQ(segment->ackNum, socket->sndNxt) > 0)
       {
          //Send a reset segment unless the RST bit is set
          if((segment->flags & TCP_FLAG_RST) == 0)
@@ -730,6 +1061,11 @@ void tcpStateSynSent(Socket *socket, const TcpHeader *segment, size_t length)
          socket->smss = MAX(socket->smss, TCP_MIN_MSS);
       }
 
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+      //The MSS cannot exceed the PMTU
+      tcpInitPathMtu(socket);
+#endif
+
 #if (TCP_SACK_SUPPORT == ENABLED)
       //Get the SACK Permitted option
       option = tcpGetOption(segment, TCP_OPTION_SACK_PERMITTED);
@@ -744,6 +1080,51 @@ void tcpStateSynSent(Socket *socket, const TcpHeader *segment, size_t length)
       }
 #endif
 
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+      //Get the Window Scale option
+      option = tcpGetOption(segment, TCP_OPTION_WINDOW_SCALE_FACTOR);
+
+      //Specified option found?
+      if(option != NULL && option->length == 3)
+      {
+         //The windows advertised by the server are scaled from now on (a
+         //shift count greater than 14 is treated as 14)
+         socket->wndScaleEnabled = TRUE;
+         socket->sndWndShift = MIN(option->value[0], TCP_MAX_WINDOW_SCALE);
+      }
+#endif
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //TFO connection attempt?
+      if(socket->fastOpenOption)
+      {
+         //Get the Fast Open Cookie option
+         option = tcpGetOption(segment, TCP_OPTION_FAST_OPEN_COOKIE);
+
+         //The server has returned a cookie?
+         if(option != NULL && option->length > 2)
+         {
+            //Cache the cookie for subsequent connections to the same server
+            tcpSaveFastOpenCookie(&socket->remoteIpAddr, socket->smss,
+               option->value, option->length - 2);
+         }
+
+         //The data that have not been acknowledged by the SYN ACK must be
+         //sent again once the connection is established (refer to RFC 7413,
+         //section 4.2.2)
+         if(TCP_CMP_SEQ(socket->sndUna, socket->iss) > 0)
+         {
+            socket->sndUser += socket->sndNxt - socket->sndUna;
+            socket->sndNxt = socket->sndUna;
+         }
+         else
+         {
+            socket->sndUser += socket->sndNxt - (socket->iss + 1);
+            socket->sndNxt = socket->iss + 1;
+         }
+      }
+#endif
+
 #if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
       //Initial congestion window
       socket->cwnd = MIN(TCP_INITIAL_WINDOW * socket->smss,
@@ -768,6 +1149,14 @@ void tcpStateSynSent(Socket *socket, const TcpHeader *segment, size_t length)
 
          //Switch to the ESTABLISHED state
          tcpChangeState(socket, TCP_STATE_ESTABLISHED);
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+         //Send the data that have been queued by the user
+         if(socket->sndUser > 0)
+         {
+            tcpNagleAlgo(socket, SOCKET_FLAG_NO_DELAY);
+         }
+#endif
       }
       else
       {
@@ -857,8 +1246,10 @@ void tcpStateSynReceived(Socket *socket, const TcpHeader *segment,
    if((segment->flags & TCP_FLAG_ACK) == 0)
       return;
 
-   //Make sure the acknowledgment number is valid
-   if(segment->ackNum != socket->sndNxt)
+   //Make sure the acknowledgment number is valid (SND.UNA < SEG.ACK =<
+   //SND.NXT). A TFO server may already have sent data
+   if(TCP_CMP_SEQ(segment->ackNum, socket->sndUna) <= 0 ||
+      TCP_CMP_SEQ(segment->ackNum, socket->sndNxt) > 0)
    {
       //If the segment acknowledgment is not acceptable, form a reset segment
       //and send it
@@ -1152,12 +1543,8 @@ void tcpStateFinWait1(Socket *socket, const TcpHeader *segment,
          //Check if our FIN has been acknowledged
          if(segment->ackNum == socket->sndNxt)
          {
-            //Release previously allocated resources
-            tcpDeleteControlBlock(socket);
-            //Start the 2MSL timer
-            netStartTimer(&socket->timeWaitTimer, TCP_2MSL_TIMER);
             //Switch to the TIME-WAIT state
-            tcpChangeState(socket, TCP_STATE_TIME_WAIT);
+            tcpEnterTimeWait(socket);
          }
          else
          {
@@ -1229,12 +1616,8 @@ void tcpStateFinWait2(Socket *socket, const TcpHeader *segment,
          tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
             FALSE);
 
-         //Release previously allocated resources
-         tcpDeleteControlBlock(socket);
-         //Start the 2MSL timer
-         netStartTimer(&socket->timeWaitTimer, TCP_2MSL_TIMER);
-         //Switch to the TIME_WAIT state
-         tcpChangeState(socket, TCP_STATE_TIME_WAIT);
+         //Switch to the TIME-WAIT state
+         tcpEnterTimeWait(socket);
       }
    }
 }
@@ -1281,12 +1664,8 @@ void tcpStateClosing(Socket *socket, const TcpHeader *segment, size_t length)
    //ignore the segment
    if(segment->ackNum == socket->sndNxt)
    {
-      //Release previously allocated resources
-      tcpDeleteControlBlock(socket);
-      //Start the 2MSL timer
-      netStartTimer(&socket->timeWaitTimer, TCP_2MSL_TIMER);
       //Switch to the TIME-WAIT state
-      tcpChangeState(socket, TCP_STATE_TIME_WAIT);
+      tcpEnterTimeWait(socket);
    }
 }
 
@@ -1338,4 +1717,55 @@ void tcpStateTimeWait(Socket *socket, const TcpHeader *segment, size_t length)
    }
 }
 
+
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+
+/**
+ * @brief TIME-WAIT state (compact representation)
+ *
+ * Same processing as tcpStateTimeWait() for a connection that has been
+ * moved to the TIME-WAIT table
+ *
+ * @param[in] entry Pointer to the TIME-WAIT entry
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader TCP pseudo header
+ * @param[in] segment Incoming TCP segment
+ * @param[in] length Length of the segment data
+ **/
+
+void tcpStateTimeWaitEntry(TcpTimeWaitEntry *entry, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment, size_t length)
+{
+   //Debug message
+   TRACE_DEBUG("TCP FSM: TIME-WAIT state (compact)\r\n");
+
+   //Ignore RST segments in TIME-WAIT state (refer to RFC 1337, section 3)
+   if((segment->flags & TCP_FLAG_RST) != 0)
+      return;
+
+   //The only thing that can arrive in this state is a retransmission of the
+   //remote FIN. Acknowledge it and restart the 2 MSL timeout
+   if((segment->flags & TCP_FLAG_FIN) != 0)
+   {
+      //Send an acknowledgment for the FIN
+      tcpSendTimeWaitAck(entry, interface, pseudoHeader, segment);
+
+      //Restart the 2MSL timer
+      entry->expireTime = osGetSystemTime() + TCP_2MSL_TIMER;
+   }
+   else if((segment->flags & TCP_FLAG_SYN) != 0 || length > 0 ||
+      segment->seqNum != entry->rcvNxt)
+   {
+      //If an incoming segment is not acceptable, an acknowledgment should be
+      //sent in reply
+      tcpSendTimeWaitAck(entry, interface, pseudoHeader, segment);
+   }
+   else
+   {
+      //Silently discard duplicate ACKs
+   }
+}
+
+#endif
+
 #endif
@@ -44,11 +44,15 @@ void tcpProcessSegment(NetInterface *interface,
    const IpPseudoHeader *pseudoHeader, const NetBuffer *buffer, size_t offset,
    const NetRxAncillary *ancillary);
 
+bool_t tcpProcessFastPath(Socket *socket, const TcpHeader *segment,
+   const NetBuffer *buffer, size_t offset, size_t length);
+
 void tcpStateClosed(NetInterface *interface, const IpPseudoHeader *pseudoHeader,
    const TcpHeader *segment, size_t length);
 
 void tcpStateListen(Socket *socket, NetInterface *interface,
-   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment, size_t length);
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment,
+   const NetBuffer *buffer, size_t offset, size_t length);
 
 void tcpStateSynSent(Socket *socket, const TcpHeader *segment, size_t length);
 
@@ -72,6 +76,9 @@ void tcpStateClosing(Socket *socket, const TcpHeader *segment, size_t length);
 
 void tcpStateTimeWait(Socket *socket, const TcpHeader *segment, size_t length);
 
+void tcpStateTimeWaitEntry(TcpTimeWaitEntry *entry, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment, size_t length);
+
 //C++ guard
 #ifdef __cplusplus
 }
@@ -34,6 +34,7 @@
 //Dependencies
 #include "core/net.h"
 #include "core/socket.h"
+#include "core/socket_misc.h"
 #include "core/tcp.h"
 #include "core/tcp_misc.h"
 #include "core/tcp_timer.h"
@@ -45,14 +46,25 @@
 #include "date_time.h"
 #include "debug.h"
 
-//Secure initial sequence number generation?
-#if (TCP_SECURE_ISN_SUPPORT == ENABLED)
+//Secure initial sequence number generation, SYN cookies or TCP Fast Open?
+#if (TCP_SECURE_ISN_SUPPORT == ENABLED || TCP_SYN_COOKIE_SUPPORT == ENABLED || \
+   TCP_FAST_OPEN_SUPPORT == ENABLED)
    #include "hash/md5.h"
 #endif
 
 //Check TCP/IP stack configuration
 #if (TCP_SUPPORT == ENABLED)
 
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+
+//MSS values that can be encoded in a SYN cookie
+static const uint16_t tcpSynCookieMssTable[8] =
+{
+   64, 256, 536, 1024, 1220, 1300, 1440, 1460
+};
+
+#endif
+
 
 /**
  * @brief Send a TCP segment
@@ -110,6 +122,33 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
       tcpAddOption(segment, TCP_OPTION_MAX_SEGMENT_SIZE, &mss, sizeof(mss));
    }
 
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //SYN flag set?
+   if((flags & TCP_FLAG_SYN) != 0 && socket->fastOpenOption)
+   {
+      //Append TFO option (an empty cookie is a cookie request)
+      tcpAddOption(segment, TCP_OPTION_FAST_OPEN_COOKIE, socket->fastOpenCookie,
+         (uint8_t) socket->fastOpenCookieLen);
+   }
+#endif
+
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+   //The option is always sent in a SYN, but a SYN ACK only carries it when
+   //it was present in the SYN (refer to RFC 7323, section 2.2)
+   if((flags & TCP_FLAG_SYN) != 0 &&
+      ((flags & TCP_FLAG_ACK) == 0 || socket->wndScaleEnabled))
+   {
+      uint8_t shift;
+
+      //The receive window never exceeds 65535 bytes
+      shift = 0;
+
+      //Append Window Scale option
+      tcpAddOption(segment, TCP_OPTION_WINDOW_SCALE_FACTOR, &shift,
+         sizeof(shift));
+   }
+#endif
+
 #if (TCP_SACK_SUPPORT == ENABLED)
    //SYN flag set?
    if((flags & TCP_FLAG_SYN) != 0)
@@ -157,8 +196,16 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    //Any data to send?
    if(length > 0)
    {
-      //Copy data
-      error = tcpReadTxBuffer(socket, seqNum, buffer, length);
+      //Copy data (data carried by a SYN segment follow the SYN in the
+      //sequence space)
+      if((flags & TCP_FLAG_SYN) != 0)
+      {
+         error = tcpReadTxBuffer(socket, seqNum + 1, buffer, length);
+      }
+      else
+      {
+         error = tcpReadTxBuffer(socket, seqNum, buffer, length);
+      }
       //Any error to report?
       if(error)
       {
@@ -257,14 +304,32 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
 
       //Retransmission mechanism requires additional information
       queueItem->next = NULL;
-      queueItem->length = length;
       queueItem->sacked = FALSE;
 
+      //Data carried by a SYN segment are not retransmitted along with the
+      //SYN. They are sent again once the connection is established
+      if((flags & TCP_FLAG_SYN) != 0)
+      {
+         queueItem->length = 0;
+      }
+      else
+      {
+         queueItem->length = length;
+      }
+
       //Save TCP header
       osMemcpy(queueItem->header, segment, segment->dataOffset * 4);
       //Save pseudo header
       queueItem->pseudoHeader = pseudoHeader;
 
+      //The pseudo header of a retransmitted SYN must not account for the
+      //data carried by the original SYN
+      if((flags & TCP_FLAG_SYN) != 0 && length > 0)
+      {
+         tcpSetPseudoHeaderLength(&queueItem->pseudoHeader,
+            segment->dataOffset * 4);
+      }
+
       //Take one RTT measurement at a time
       if(!socket->rttBusy)
       {
@@ -310,6 +375,22 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    }
 #endif
 
+#if (TCP_DELAYED_ACK_SUPPORT == ENABLED)
+   //Any segment carrying an ACK acknowledges all the data received so far
+   if((flags & TCP_FLAG_ACK) != 0)
+   {
+      //Cancel the pending delayed ACK
+      socket->rcvAckPending = 0;
+      netStopTimer(&socket->delayedAckTimer);
+   }
+#endif
+
+   //Pure ACK segment?
+   if(flags == TCP_FLAG_ACK && length == 0)
+   {
+      socket->stats.outAckSegs++;
+   }
+
    //Total number of segments sent
    MIB2_TCP_INC_COUNTER32(tcpOutSegs, 1);
    TCP_MIB_INC_COUNTER32(tcpOutSegs, 1);
@@ -337,6 +418,16 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    //Set ToS field
    ancillary.tos = socket->tos;
 
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+   //Segments are sent with the DF bit set so that oversized packets are
+   //reported by the network. Data segments carrying options may exceed the
+   //SMSS and are left fragmentable
+   if(segment->dataOffset * 4 == sizeof(TcpHeader) || length == 0)
+   {
+      ancillary.dontFrag = TRUE;
+   }
+#endif
+
 #if (ETH_VLAN_SUPPORT == ENABLED)
    //Set VLAN PCP and DEI fields
    ancillary.vlanPcp = socket->vlanPcp;
@@ -349,10 +440,35 @@ error_t tcpSendSegment(Socket *socket, uint8_t flags, uint32_t seqNum,
    ancillary.vmanDei = socket->vmanDei;
 #endif
 
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+   //The route does not change as long as the connection is up. Reuse the
+   //next hop resolved for the previous segments
+   if(socket->interface != NULL)
+   {
+      NetInterface *interface;
+      IpAddr srcIpAddr;
+
+      //Look up the route cache
+      interface = socket->interface;
+      srcIpAddr = socket->localIpAddr;
+      socketGetRouteCache(socket, &interface, &srcIpAddr, &socket->remoteIpAddr,
+         &ancillary);
+   }
+#endif
+
    //Send TCP segment
    (void) ipSendDatagram(socket->interface, &pseudoHeader, buffer, offset,
       &ancillary);
 
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+   //Save the next hop for subsequent segments
+   if(socket->interface != NULL)
+   {
+      socketUpdateRouteCache(socket, socket->interface, &socket->localIpAddr,
+         &socket->remoteIpAddr, &ancillary);
+   }
+#endif
+
    //Free previously allocated memory
    netBufferFree(buffer);
 
@@ -671,6 +787,29 @@ const TcpOption *tcpGetOption(const TcpHeader *segment, uint8_t kind)
 }
 
 
+/**
+ * @brief Apply the shift count of the window scale option
+ *
+ * The send window is bounded by the size of the transmit buffer, so the
+ * scaled value is clamped to the range of the SND.WND variable
+ *
+ * @param[in] window Window field of the incoming segment
+ * @param[in] shift Shift count advertised by the remote host
+ * @return Scaled window
+ **/
+
+uint16_t tcpScaleWindow(uint16_t window, uint8_t shift)
+{
+   uint32_t n;
+
+   //Scale the window (refer to RFC 7323, section 2.3)
+   n = (uint32_t) window << shift;
+
+   //Return the scaled window
+   return (uint16_t) MIN(n, UINT16_MAX);
+}
+
+
 /**
  * @brief Initial sequence number generation
  * @param[in] localIpAddr Local IP address
@@ -708,1309 +847,3493 @@ uint32_t tcpGenerateInitialSeqNum(const IpAddr *localIpAddr,
 }
 
 
+#if (TCP_SYN_COOKIE_SUPPORT == ENABLED)
+
 /**
- * @brief Test the sequence number of an incoming segment
- * @param[in] socket Handle referencing the current socket
- * @param[in] segment Pointer to the TCP segment to check
- * @param[in] length Length of the segment data
- * @return NO_ERROR if the incoming segment is acceptable, ERROR_FAILURE otherwise
+ * @brief Compute the keyed hash that authenticates a SYN cookie
+ * @param[in] pseudoHeader TCP pseudo header of the incoming segment
+ * @param[in] segment Incoming TCP segment
+ * @param[in] isn Initial sequence number chosen by the remote host
+ * @param[in] counter Value of the time counter
+ * @param[in] data Encoded MSS index, SACK Permitted flag and window scale
+ * @return Hash value
  **/
 
-error_t tcpCheckSeqNum(Socket *socket, const TcpHeader *segment, size_t length)
+uint32_t tcpComputeSynCookieHash(const IpPseudoHeader *pseudoHeader,
+   const TcpHeader *segment, uint32_t isn, uint32_t counter, uint8_t data)
 {
-   bool_t acceptable;
+   Md5Context md5Context;
 
-   //Due to zero windows and zero length segments, we have four cases for the
-   //acceptability of an incoming segment (refer to RFC 793, section 3.3)
-   if(length == 0 && socket->rcvWnd == 0)
-   {
-      //If both segment length and receive window are zero, then test if
-      //SEG.SEQ = RCV.NXT
-      if(segment->seqNum == socket->rcvNxt)
-      {
-         acceptable = TRUE;
-      }
-      else
-      {
-         acceptable = FALSE;
-      }
-   }
-   else if(length == 0 && socket->rcvWnd != 0)
+   //Initialize MD5 context
+   md5Init(&md5Context);
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 segment?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
    {
-      //If segment length is zero and receive window is non zero, then test if
-      //RCV.NXT <= SEG.SEQ < RCV.NXT+RCV.WND
-      if(TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt) >= 0 &&
-         TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt + socket->rcvWnd) < 0)
-      {
-         acceptable = TRUE;
-      }
-      else
-      {
-         acceptable = FALSE;
-      }
+      //Digest source and destination addresses
+      md5Update(&md5Context, &pseudoHeader->ipv4Data.srcAddr, sizeof(Ipv4Addr));
+      md5Update(&md5Context, &pseudoHeader->ipv4Data.destAddr, sizeof(Ipv4Addr));
    }
-   else if(length != 0 && socket->rcvWnd == 0)
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 segment?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
    {
-      //If segment length is non zero and receive window is zero, then the
-      //sequence number is not acceptable
-      acceptable = FALSE;
+      //Digest source and destination addresses
+      md5Update(&md5Context, &pseudoHeader->ipv6Data.srcAddr, sizeof(Ipv6Addr));
+      md5Update(&md5Context, &pseudoHeader->ipv6Data.destAddr, sizeof(Ipv6Addr));
    }
    else
+#endif
    {
-      //If both segment length and receive window are non zero, then test if
-      //RCV.NXT <= SEG.SEQ < RCV.NXT+RCV.WND or
-      //RCV.NXT <= SEG.SEQ+SEG.LEN-1 < RCV.NXT+RCV.WND
-      if(TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt) >= 0 &&
-         TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt + socket->rcvWnd) < 0)
-      {
-         acceptable = TRUE;
-      }
-      else if(TCP_CMP_SEQ(segment->seqNum + length - 1, socket->rcvNxt) >= 0 &&
-         TCP_CMP_SEQ(segment->seqNum + length - 1, socket->rcvNxt + socket->rcvWnd) < 0)
-      {
-         acceptable = TRUE;
-      }
-      else
-      {
-         acceptable = FALSE;
-      }
+      //Just for sanity
    }
 
-   //Non acceptable sequence number?
-   if(!acceptable)
-   {
-      //Debug message
-      TRACE_WARNING("Sequence number is not acceptable!\r\n");
-
-      //If an incoming segment is not acceptable, an acknowledgment should
-      //be sent in reply (unless the RST bit is set)
-      if((segment->flags & TCP_FLAG_RST) == 0)
-      {
-         tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt,
-            0, FALSE);
-      }
-
-      //Return status code
-      return ERROR_FAILURE;
-   }
+   //The cookie is bound to the connection 4-tuple, the ISN of the remote
+   //host, the time counter and the encoded connection parameters
+   md5Update(&md5Context, &segment->srcPort, sizeof(uint16_t));
+   md5Update(&md5Context, &segment->destPort, sizeof(uint16_t));
+   md5Update(&md5Context, &isn, sizeof(uint32_t));
+   md5Update(&md5Context, &counter, sizeof(uint32_t));
+   md5Update(&md5Context, &data, sizeof(uint8_t));
+   md5Update(&md5Context, netContext.randSeed, NET_RAND_SEED_SIZE);
+   md5Final(&md5Context, NULL);
 
-   //Sequence number is acceptable
-   return NO_ERROR;
+   //Extract the first 32 bits from the digest value
+   return LOAD32BE(md5Context.digest);
 }
 
 
 /**
- * @brief Check the SYN bit of an incoming segment
- * @param[in] socket Handle referencing the current socket
- * @param[in] segment Pointer to the TCP segment to check
- * @param[in] length Length of the segment data
- * @return ERROR_FAILURE if the SYN is in the window, NO_ERROR otherwise
+ * @brief Answer a connection request with a SYN cookie
+ *
+ * When the SYN queue of a listening socket is full, the SYN ACK is sent
+ * immediately and no state is kept. The initial sequence number encodes
+ * a time counter, the MSS, the SACK Permitted option and the window scale
+ * of the remote host so that the connection can be reconstructed when the
+ * final ACK arrives
+ *
+ * @param[in] socket Handle referencing the listening socket
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader TCP pseudo header
+ * @param[in] segment Incoming SYN segment
+ * @return Error code
  **/
 
-error_t tcpCheckSyn(Socket *socket, const TcpHeader *segment, size_t length)
+error_t tcpSendSynCookie(Socket *socket, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment)
 {
-   //Check whether the SYN bit is set
-   if((segment->flags & TCP_FLAG_SYN) != 0)
-   {
-      //If this step is reached, the SYN is in the window. It is an error
-      //and a reset shall be sent in response
-      if((segment->flags & TCP_FLAG_ACK) != 0)
-      {
-         tcpSendResetSegment(socket, segment->ackNum);
-      }
-      else
-      {
-         tcpSendSegment(socket, TCP_FLAG_RST | TCP_FLAG_ACK, 0,
-            segment->seqNum + length + 1, 0, FALSE);
-      }
-
-      //Return immediately
-      return ERROR_FAILURE;
-   }
+   error_t error;
+   uint_t i;
+   uint8_t data;
+   uint16_t mss;
+   uint32_t counter;
+   uint32_t cookie;
+   size_t offset;
+   size_t length;
+   NetBuffer *buffer;
+   TcpHeader *segment2;
+   const TcpOption *option;
+   IpPseudoHeader pseudoHeader2;
+   NetTxAncillary ancillary;
 
-   //No error to report
-   return NO_ERROR;
-}
+   //Get the Maximum Segment Size option
+   option = tcpGetOption(segment, TCP_OPTION_MAX_SEGMENT_SIZE);
 
+   //Specified option found?
+   if(option != NULL && option->length == 4)
+   {
+      //Make sure that the MSS advertised by the peer is acceptable
+      mss = LOAD16BE(option->value);
+      mss = MIN(mss, socket->mss);
+      mss = MAX(mss, TCP_MIN_MSS);
+   }
+   else
+   {
+      //If the option is not received, TCP must assume the default MSS
+      mss = MIN(socket->mss, TCP_DEFAULT_MSS);
+   }
 
-/**
- * @brief Test the ACK field of an incoming segment
- * @param[in] socket Handle referencing the current socket
- * @param[in] segment Pointer to the TCP segment to check
- * @param[in] length Length of the segment data
- * @return NO_ERROR if the acknowledgment is acceptable, ERROR_FAILURE otherwise
- **/
+   //Select the largest encodable MSS that does not exceed the actual value
+   for(i = arraysize(tcpSynCookieMssTable) - 1; i > 0; i--)
+   {
+      if(tcpSynCookieMssTable[i] <= mss)
+         break;
+   }
 
-error_t tcpCheckAck(Socket *socket, const TcpHeader *segment, size_t length)
-{
-   bool_t duplicateFlag;
-   bool_t updateFlag;
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-   uint_t n;
-   uint_t ownd;
-   uint_t thresh;
-#endif
+   //The MSS index is encoded in the upper 3 bits
+   data = (uint8_t) (i << 5);
 
-   //If the ACK bit is off drop the segment and return
-   if((segment->flags & TCP_FLAG_ACK) == 0)
-      return ERROR_FAILURE;
+#if (TCP_SACK_SUPPORT == ENABLED)
+   //Get the SACK Permitted option
+   option = tcpGetOption(segment, TCP_OPTION_SACK_PERMITTED);
 
-#if (TCP_KEEP_ALIVE_SUPPORT == ENABLED)
-   //Check whether TCP keep-alive mechanism is enabled
-   if(socket->keepAliveEnabled)
+   //The SACK Permitted flag is encoded in the next bit
+   if(option != NULL && option->length == 2)
    {
-      //Reset keep-alive probe counter
-      socket->keepAliveProbeCount = 0;
+      data |= 0x10;
    }
 #endif
 
-   //Test the case where SEG.ACK < SND.UNA
-   if(TCP_CMP_SEQ(segment->ackNum, socket->sndUna) < 0)
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+   //Get the Window Scale option
+   option = tcpGetOption(segment, TCP_OPTION_WINDOW_SCALE_FACTOR);
+
+   //The shift count is encoded in the lower 4 bits
+   if(option != NULL && option->length == 3)
    {
-      //An old duplicate ACK has been received
-      return NO_ERROR;
+      data |= MIN(option->value[0], TCP_MAX_WINDOW_SCALE);
    }
-   //Test the case where SEG.ACK > SND.NXT
-   else if(TCP_CMP_SEQ(segment->ackNum, socket->sndNxt) > 0)
+   else
+#endif
    {
-      //Send an ACK segment indicating the current send sequence number
-      //and the acknowledgment number expected to be received
-      tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
-         FALSE);
-
-      //The ACK segment acknowledges something not yet sent
-      return ERROR_FAILURE;
+      //The value 15 means that the option has not been received
+      data |= 0x0F;
    }
 
-   //Check whether the ACK is a duplicate
-   duplicateFlag = tcpIsDuplicateAck(socket, segment, length);
-   (void) duplicateFlag;
+   //Get current value of the time counter
+   counter = netGetSystemTickCount() / TCP_SYN_COOKIE_PERIOD;
 
-   //The send window should be updated
-   tcpUpdateSendWindow(socket, segment);
+   //Format SYN cookie (2-bit counter, 8-bit data and 22-bit hash). The hash
+   //covers the whole counter, so that two bits are enough to tell the last
+   //two periods apart
+   cookie = (counter & 0x03) << 30;
+   cookie |= (uint32_t) data << 22;
+   cookie |= tcpComputeSynCookieHash(pseudoHeader, segment, segment->seqNum,
+      counter, data) & 0x003FFFFF;
 
-   //The incoming ACK segment acknowledges new data?
-   if(TCP_CMP_SEQ(segment->ackNum, socket->sndUna) > 0)
-   {
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-      //Compute the number of bytes acknowledged by the incoming ACK
-      n = segment->ackNum - socket->sndUna;
+   //The RMSS is the size of the largest segment the receiver is willing to
+   //accept
+   mss = htons(MIN(socket->mss, socket->rxBufferSize));
 
-      //Check whether the ACK segment acknowledges our SYN
-      if(socket->sndUna == socket->iss)
+   //Allocate a memory buffer to hold the SYN ACK segment
+   buffer = ipAllocBuffer(TCP_MAX_HEADER_LENGTH, &offset);
+   //Failed to allocate memory?
+   if(buffer == NULL)
+      return ERROR_OUT_OF_MEMORY;
+
+   //Point to the beginning of the TCP segment
+   segment2 = netBufferAt(buffer, offset, 0);
+
+   //Format TCP header
+   segment2->srcPort = htons(segment->destPort);
+   segment2->destPort = htons(segment->srcPort);
+   segment2->seqNum = htonl(cookie);
+   segment2->ackNum = htonl(segment->seqNum + 1);
+   segment2->reserved1 = 0;
+   segment2->dataOffset = sizeof(TcpHeader) / 4;
+   segment2->flags = TCP_FLAG_SYN | TCP_FLAG_ACK;
+   segment2->reserved2 = 0;
+   segment2->window = htons(MIN(socket->rxBufferSize, UINT16_MAX));
+   segment2->checksum = 0;
+   segment2->urgentPointer = 0;
+
+   //Append Maximum Segment Size option
+   tcpAddOption(segment2, TCP_OPTION_MAX_SEGMENT_SIZE, &mss, sizeof(mss));
+
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+   //The option is echoed only if it has been received in the SYN
+   if((data & 0x0F) <= TCP_MAX_WINDOW_SCALE)
+   {
+      uint8_t shift;
+
+      //The receive window never exceeds 65535 bytes
+      shift = 0;
+
+      //Append Window Scale option
+      tcpAddOption(segment2, TCP_OPTION_WINDOW_SCALE_FACTOR, &shift,
+         sizeof(shift));
+   }
+#endif
+
+#if (TCP_SACK_SUPPORT == ENABLED)
+   //Append SACK Permitted option
+   tcpAddOption(segment2, TCP_OPTION_SACK_PERMITTED, NULL, 0);
+#endif
+
+   //Calculate the length of the TCP header
+   length = segment2->dataOffset * 4;
+   //Adjust the length of the multi-part buffer
+   netBufferSetLength(buffer, offset + length);
+
+#if (IPV4_SUPPORT == ENABLED)
+   //Destination address is an IPv4 address?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+   {
+      //Format IPv4 pseudo header
+      pseudoHeader2.length = sizeof(Ipv4PseudoHeader);
+      pseudoHeader2.ipv4Data.srcAddr = pseudoHeader->ipv4Data.destAddr;
+      pseudoHeader2.ipv4Data.destAddr = pseudoHeader->ipv4Data.srcAddr;
+      pseudoHeader2.ipv4Data.reserved = 0;
+      pseudoHeader2.ipv4Data.protocol = IPV4_PROTOCOL_TCP;
+      pseudoHeader2.ipv4Data.length = htons(length);
+
+      //Calculate TCP header checksum
+      segment2->checksum = ipCalcUpperLayerChecksumEx(&pseudoHeader2.ipv4Data,
+         sizeof(Ipv4PseudoHeader), buffer, offset, length);
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //Destination address is an IPv6 address?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+   {
+      //Format IPv6 pseudo header
+      pseudoHeader2.length = sizeof(Ipv6PseudoHeader);
+      pseudoHeader2.ipv6Data.srcAddr = pseudoHeader->ipv6Data.destAddr;
+      pseudoHeader2.ipv6Data.destAddr = pseudoHeader->ipv6Data.srcAddr;
+      pseudoHeader2.ipv6Data.length = htonl(length);
+      pseudoHeader2.ipv6Data.reserved[0] = 0;
+      pseudoHeader2.ipv6Data.reserved[1] = 0;
+      pseudoHeader2.ipv6Data.reserved[2] = 0;
+      pseudoHeader2.ipv6Data.nextHeader = IPV6_TCP_HEADER;
+
+      //Calculate TCP header checksum
+      segment2->checksum = ipCalcUpperLayerChecksumEx(&pseudoHeader2.ipv6Data,
+         sizeof(Ipv6PseudoHeader), buffer, offset, length);
+   }
+   else
+#endif
+   //Destination address is not valid?
+   {
+      //Free previously allocated memory
+      netBufferFree(buffer);
+      //This should never occur...
+      return ERROR_INVALID_ADDRESS;
+   }
+
+   //Total number of segments sent
+   MIB2_TCP_INC_COUNTER32(tcpOutSegs, 1);
+   TCP_MIB_INC_COUNTER32(tcpOutSegs, 1);
+   TCP_MIB_INC_COUNTER64(tcpHCOutSegs, 1);
+
+   //Number of SYN ACK segments sent with a SYN cookie
+   socket->stats.synCookiesSent++;
+
+   //Debug message
+   TRACE_DEBUG("%s: Sending TCP SYN cookie...\r\n",
+      formatSystemTime(osGetSystemTime(), NULL));
+
+   //Dump TCP header contents for debugging purpose
+   tcpDumpHeader(segment2, 0, cookie, segment->seqNum);
+
+   //Additional options can be passed to the stack along with the packet
+   ancillary = NET_DEFAULT_TX_ANCILLARY;
+
+   //Send TCP segment
+   error = ipSendDatagram(interface, &pseudoHeader2, buffer, offset,
+      &ancillary);
+
+   //Free previously allocated memory
+   netBufferFree(buffer);
+
+   //Return error code
+   return error;
+}
+
+
+/**
+ * @brief Validate the SYN cookie echoed in the final ACK of a handshake
+ *
+ * On success, the connection is reconstructed from the cookie and queued
+ * so that socketAccept() returns it without sending another SYN ACK
+ *
+ * @param[in] socket Handle referencing the listening socket
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader TCP pseudo header
+ * @param[in] segment Incoming ACK segment
+ * @return NO_ERROR if the connection has been queued, ERROR_WRONG_COOKIE if
+ *   the cookie is invalid, or another error code if the segment must be
+ *   silently discarded
+ **/
+
+error_t tcpCheckSynCookie(Socket *socket, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment)
+{
+   uint_t n;
+   uint8_t data;
+   uint32_t isn;
+   uint32_t age;
+   uint32_t counter;
+   uint32_t cookie;
+   TcpSynQueueItem *queueItem;
+   TcpSynQueueItem *prevQueueItem;
+   TcpSynQueueItem *victimItem;
+   TcpSynQueueItem *prevVictimItem;
+
+   //The final ACK acknowledges the cookie and carries the ISN of the remote
+   //host plus one
+   cookie = segment->ackNum - 1;
+   isn = segment->seqNum - 1;
+
+   //Get current value of the time counter
+   counter = netGetSystemTickCount() / TCP_SYN_COOKIE_PERIOD;
+
+   //Cookies older than two periods are rejected
+   age = (counter - (cookie >> 30)) & 0x03;
+   //Retrieve the encoded MSS index, SACK Permitted flag and window scale
+   data = (cookie >> 22) & 0xFF;
+
+   //Check the time counter and the hash value
+   if(age > 1 || ((tcpComputeSynCookieHash(pseudoHeader, segment, isn,
+      counter - age, data) ^ cookie) & 0x003FFFFF) != 0)
+   {
+      //Number of ACK segments carrying an invalid SYN cookie
+      socket->stats.synCookiesFailed++;
+      //Report an error
+      return ERROR_WRONG_COOKIE;
+   }
+
+   //Count the number of items in the SYN queue and find the oldest request
+   //whose SYN has not been answered yet
+   n = 0;
+   prevQueueItem = NULL;
+   victimItem = NULL;
+   prevVictimItem = NULL;
+
+   //Loop through the SYN queue
+   for(queueItem = socket->synQueue; queueItem != NULL;
+      queueItem = queueItem->next)
+   {
+      //Half-open connection request?
+      if(!queueItem->synCookie && victimItem == NULL)
+      {
+         victimItem = queueItem;
+         prevVictimItem = prevQueueItem;
+      }
+
+      //Keep track of the last item
+      prevQueueItem = queueItem;
+      n++;
+   }
+
+   //Check whether the SYN queue is full
+   if(n >= socket->synQueueSize)
+   {
+      //The queue only holds completed connections waiting to be accepted?
+      if(victimItem == NULL)
+         return ERROR_OUT_OF_RESOURCES;
+
+      //Completed connections take precedence over half-open requests (a
+      //genuine client will retransmit its SYN)
+      if(prevVictimItem == NULL)
+      {
+         socket->synQueue = victimItem->next;
+      }
+      else
+      {
+         prevVictimItem->next = victimItem->next;
+      }
+
+      //Update the pointer to the last item
+      if(prevQueueItem == victimItem)
+      {
+         prevQueueItem = prevVictimItem;
+      }
+
+      //Deallocate memory buffer
+      memPoolFree(victimItem);
+   }
+
+   //Allocate memory to save the reconstructed connection
+   queueItem = memPoolAlloc(sizeof(TcpSynQueueItem));
+   //Failed to allocate memory?
+   if(queueItem == NULL)
+      return ERROR_OUT_OF_MEMORY;
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 is currently used?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+   {
+      //Save the source IPv4 address
+      queueItem->srcAddr.length = sizeof(Ipv4Addr);
+      queueItem->srcAddr.ipv4Addr = pseudoHeader->ipv4Data.srcAddr;
+
+      //Save the destination IPv4 address
+      queueItem->destAddr.length = sizeof(Ipv4Addr);
+      queueItem->destAddr.ipv4Addr = pseudoHeader->ipv4Data.destAddr;
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 is currently used?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+   {
+      //Save the source IPv6 address
+      queueItem->srcAddr.length = sizeof(Ipv6Addr);
+      queueItem->srcAddr.ipv6Addr = pseudoHeader->ipv6Data.srcAddr;
+
+      //Save the destination IPv6 address
+      queueItem->destAddr.length = sizeof(Ipv6Addr);
+      queueItem->destAddr.ipv6Addr = pseudoHeader->ipv6Data.destAddr;
+   }
+   else
+#endif
+   //Invalid pseudo header?
+   {
+      //Deallocate memory buffer
+      memPoolFree(queueItem);
+      //This should never occur...
+      return ERROR_INVALID_ADDRESS;
+   }
+
+   //Initialize next field
+   queueItem->next = NULL;
+   //Underlying network interface
+   queueItem->interface = interface;
+   //Save the port number of the client
+   queueItem->srcPort = segment->srcPort;
+   //Save the initial sequence number
+   queueItem->isn = isn;
+
+   //Decode the MSS value
+   queueItem->mss = tcpSynCookieMssTable[data >> 5];
+   queueItem->mss = MIN(queueItem->mss, socket->mss);
+   queueItem->mss = MAX(queueItem->mss, TCP_MIN_MSS);
+
+#if (TCP_SACK_SUPPORT == ENABLED)
+   //Decode the SACK Permitted flag
+   queueItem->sackPermitted = (data & 0x10) ? TRUE : FALSE;
+#endif
+
+   //The three-way handshake is already complete
+   queueItem->synCookie = TRUE;
+   queueItem->iss = cookie;
+   queueItem->window = segment->window;
+
+#if (TCP_WINDOW_SCALE_SUPPORT == ENABLED)
+   //Decode the window scale of the remote host
+   if((data & 0x0F) <= TCP_MAX_WINDOW_SCALE)
+   {
+      queueItem->wndScaleEnabled = TRUE;
+      queueItem->sndWndShift = data & 0x0F;
+
+      //Unlike the SYN, the final ACK carries a scaled window
+      queueItem->window = tcpScaleWindow(segment->window,
+         queueItem->sndWndShift);
+   }
+   else
+   {
+      queueItem->wndScaleEnabled = FALSE;
+      queueItem->sndWndShift = 0;
+   }
+#endif
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //No data carried by the SYN
+   queueItem->fastOpenCookieRequest = FALSE;
+   queueItem->fastOpenDataLen = 0;
+#endif
+
+   //Add the newly created item at the end of the queue
+   if(prevQueueItem == NULL)
+   {
+      socket->synQueue = queueItem;
+   }
+   else
+   {
+      prevQueueItem->next = queueItem;
+   }
+
+   //Number of connections reconstructed from a valid SYN cookie
+   socket->stats.synCookiesValid++;
+
+   //Notify user that a connection request is pending
+   tcpUpdateEvents(socket);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+#endif
+
+
+/**
+ * @brief Test the sequence number of an incoming segment
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Pointer to the TCP segment to check
+ * @param[in] length Length of the segment data
+ * @return NO_ERROR if the incoming segment is acceptable, ERROR_FAILURE otherwise
+ **/
+
+error_t tcpCheckSeqNum(Socket *socket, const TcpHeader *segment, size_t length)
+{
+   bool_t acceptable;
+
+   //Due to zero windows and zero length segments, we have four cases for the
+   //acceptability of an incoming segment (refer to RFC 793, section 3.3)
+   if(length == 0 && socket->rcvWnd == 0)
+   {
+      //If both segment length and receive window are zero, then test if
+      //SEG.SEQ = RCV.NXT
+      if(segment->seqNum == socket->rcvNxt)
+      {
+         acceptable = TRUE;
+      }
+      else
+      {
+         acceptable = FALSE;
+      }
+   }
+   else if(length == 0 && socket->rcvWnd != 0)
+   {
+      //If segment length is zero and receive window is non zero, then test if
+      //RCV.NXT <= SEG.SEQ < RCV.NXT+RCV.WND
+      if(TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt) >= 0 &&
+         TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt + socket->rcvWnd) < 0)
+      {
+         acceptable = TRUE;
+      }
+      else
+      {
+         acceptable = FALSE;
+      }
+   }
+   else if(length != 0 && socket->rcvWnd == 0)
+   {
+      //If segment length is non zero and receive window is zero, then the
+      //sequence number is not acceptable
+      acceptable = FALSE;
+   }
+   else
+   {
+      //If both segment length and receive window are non zero, then test if
+      //RCV.NXT <= SEG.SEQ < RCV.NXT+RCV.WND or
+      //RCV.NXT <= SEG.SEQ+SEG.LEN-1 < RCV.NXT+RCV.WND
+      if(TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt) >= 0 &&
+         TCP_CMP_SEQ(segment->seqNum, socket->rcvNxt + socket->rcvWnd) < 0)
+      {
+         acceptable = TRUE;
+      }
+      else if(TCP_CMP_SEQ(segment->seqNum + length - 1, socket->rcvNxt) >= 0 &&
+         TCP_CMP_SEQ(segment->seqNum + length - 1, socket->rcvNxt + socket->rcvWnd) < 0)
+      {
+         acceptable = TRUE;
+      }
+      else
+      {
+         acceptable = FALSE;
+      }
+   }
+
+   //Non acceptable sequence number?
+   if(!acceptable)
+   {
+      //Debug message
+      TRACE_WARNING("Sequence number is not acceptable!\r\n");
+
+      //If an incoming segment is not acceptable, an acknowledgment should
+      //be sent in reply (unless the RST bit is set)
+      if((segment->flags & TCP_FLAG_RST) == 0)
+      {
+         tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt,
+            0, FALSE);
+      }
+
+      //Return status code
+      return ERROR_FAILURE;
+   }
+
+   //Sequence number is acceptable
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Check the SYN bit of an incoming segment
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Pointer to the TCP segment to check
+ * @param[in] length Length of the segment data
+ * @return ERROR_FAILURE if the SYN is in the window, NO_ERROR otherwise
+ **/
+
+error_t tcpCheckSyn(Socket *socket, const TcpHeader *segment, size_t length)
+{
+   //Check whether the SYN bit is set
+   if((segment->flags & TCP_FLAG_SYN) != 0)
+   {
+      //If this step is reached, the SYN is in the window. It is an error
+      //and a reset shall be sent in response
+      if((segment->flags & TCP_FLAG_ACK) != 0)
+      {
+         tcpSendResetSegment(socket, segment->ackNum);
+      }
+      else
+      {
+         tcpSendSegment(socket, TCP_FLAG_RST | TCP_FLAG_ACK, 0,
+            segment->seqNum + length + 1, 0, FALSE);
+      }
+
+      //Return immediately
+      return ERROR_FAILURE;
+   }
+
+   //No error to report
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Test the ACK field of an incoming segment
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Pointer to the TCP segment to check
+ * @param[in] length Length of the segment data
+ * @return NO_ERROR if the acknowledgment is acceptable, ERROR_FAILURE otherwise
+ **/
+
+error_t tcpCheckAck(Socket *socket, const TcpHeader *segment, size_t length)
+{
+   bool_t duplicateFlag;
+   bool_t updateFlag;
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   uint_t n;
+   uint_t ownd;
+   uint_t thresh;
+#endif
+
+   //If the ACK bit is off drop the segment and return
+   if((segment->flags & TCP_FLAG_ACK) == 0)
+      return ERROR_FAILURE;
+
+#if (TCP_KEEP_ALIVE_SUPPORT == ENABLED)
+   //Check whether TCP keep-alive mechanism is enabled
+   if(socket->keepAliveEnabled)
+   {
+      //Reset keep-alive probe counter
+      socket->keepAliveProbeCount = 0;
+   }
+#endif
+
+   //Test the case where SEG.ACK < SND.UNA
+   if(TCP_CMP_SEQ(segment->ackNum, socket->sndUna) < 0)
+   {
+      //An old duplicate ACK has been received
+      return NO_ERROR;
+   }
+   //Test the case where SEG.ACK > SND.NXT
+   else if(TCP_CMP_SEQ(segment->ackNum, socket->sndNxt) > 0)
+   {
+      //Send an ACK segment indicating the current send sequence number
+      //and the acknowledgment number expected to be received
+      tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
+         FALSE);
+
+      //The ACK segment acknowledges something not yet sent
+      return ERROR_FAILURE;
+   }
+
+   //Check whether the ACK is a duplicate
+   duplicateFlag = tcpIsDuplicateAck(socket, segment, length);
+   (void) duplicateFlag;
+
+   //The send window should be updated
+   tcpUpdateSendWindow(socket, segment);
+
+   //The incoming ACK segment acknowledges new data?
+   if(TCP_CMP_SEQ(segment->ackNum, socket->sndUna) > 0)
+   {
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+      //Compute the number of bytes acknowledged by the incoming ACK
+      n = segment->ackNum - socket->sndUna;
+
+      //Check whether the ACK segment acknowledges our SYN
+      if(socket->sndUna == socket->iss)
+      {
+         n--;
+      }
+
+      //Total number of bytes acknowledged during the whole round-trip
+      socket->n += n;
+#endif
+      //Update SND.UNA pointer
+      socket->sndUna = segment->ackNum;
+
+      //Compute retransmission timeout
+      updateFlag = tcpComputeRto(socket);
+      (void) updateFlag;
+
+      //Any segments on the retransmission queue which are thereby entirely
+      //acknowledged are removed
+      tcpUpdateRetransmitQueue(socket);
+
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+      //Check congestion state
+      if(socket->congestState == TCP_CONGEST_STATE_RECOVERY)
+      {
+         //Invoke fast recovery (refer to RFC 6582)
+         tcpFastRecovery(socket, segment, n);
+      }
+      else
+      {
+         //Reset duplicate ACK counter
+         socket->dupAckCount = 0;
+
+         //Check congestion state
+         if(socket->congestState == TCP_CONGEST_STATE_LOSS_RECOVERY)
+         {
+            //Invoke fast loss recovery
+            tcpFastLossRecovery(socket, segment);
+         }
+
+         //Slow start algorithm is used when cwnd is lower than ssthresh
+         if(socket->cwnd < socket->ssthresh)
+         {
+            //During slow start, TCP increments cwnd by at most SMSS bytes
+            //for each ACK received that cumulatively acknowledges new data
+            socket->cwnd += MIN(n, socket->smss);
+         }
+         //Congestion avoidance algorithm is used when cwnd exceeds ssthres
+         else
+         {
+            //Congestion window is updated once per RTT
+            if(updateFlag)
+            {
+               //TCP must not increment cwnd by more than SMSS bytes
+               socket->cwnd += MIN(socket->n, socket->smss);
+            }
+         }
+      }
+
+      //Limit the size of the congestion window
+      socket->cwnd = MIN(socket->cwnd, socket->txBufferSize);
+#endif
+   }
+   //The incoming ACK segment does not acknowledge new data?
+   else
+   {
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+      //Check whether the acknowledgment is a duplicate
+      if(duplicateFlag)
+      {
+         //Increment duplicate ACK counter
+         socket->dupAckCount++;
+         //Debug message
+         TRACE_INFO("TCP duplicate ACK #%u\r\n", socket->dupAckCount);
+      }
+      else
+      {
+         //Reset duplicate ACK counter
+         socket->dupAckCount = 0;
+      }
+
+      //Check congestion state
+      if(socket->congestState == TCP_CONGEST_STATE_IDLE)
+      {
+         //Use default duplicate ACK threshold
+         thresh = TCP_FAST_RETRANSMIT_THRES;
+         //Amount of data sent but not yet acknowledged
+         ownd = socket->sndNxt - socket->sndUna;
+
+         //Test if there is either no unsent data ready for transmission at
+         //the sender, or the advertised receive window does not permit new
+         //segments to be transmitted (refer to RFC 5827 section 3.1)
+         if(socket->sndUser == 0 || socket->sndWnd <= (socket->sndNxt - socket->sndUna))
+         {
+            //Compute the duplicate ACK threshold used to trigger a
+            //retransmission
+            if(ownd <= (3 * socket->smss))
+            {
+               thresh = 1;
+            }
+            else if(ownd <= (4 * socket->smss))
+            {
+               thresh = 2;
+            }
+            else
+            {
+            }
+         }
+
+         //Check the number of duplicate ACKs that have been received
+         if(socket->dupAckCount >= thresh)
+         {
+            //The TCP sender first checks the value of recover to see if the
+            //cumulative acknowledgment field covers more than recover
+            if(TCP_CMP_SEQ(segment->ackNum, socket->recover + 1) > 0)
+            {
+               //Invoke Fast Retransmit (refer to RFC 6582)
+               tcpFastRetransmit(socket);
+            }
+            else
+            {
+               //If not, the TCP does not enter fast retransmit and does not
+               //reset ssthres...
+            }
+         }
+      }
+      else if(socket->congestState == TCP_CONGEST_STATE_RECOVERY)
+      {
+         //Duplicate ACK received?
+         if(duplicateFlag)
+         {
+            //For each additional duplicate ACK received (after the third),
+            //cwnd must be incremented by SMSS. This artificially inflates
+            //the congestion window in order to reflect the additional
+            //segment that has left the network
+            socket->cwnd += socket->smss;
+         }
+      }
+
+      //Limit the size of the congestion window
+      socket->cwnd = MIN(socket->cwnd, socket->txBufferSize);
+#endif
+   }
+
+   //Update TX events
+   tcpUpdateEvents(socket);
+
+   //No error to report
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Test whether the incoming SYN segment is a duplicate
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] pseudoHeader TCP pseudo header
+ * @param[in] segment Pointer to the TCP segment to check
+ * @return TRUE if the SYN segment is duplicate, else FALSE
+ **/
+
+bool_t tcpIsDuplicateSyn(Socket *socket, const IpPseudoHeader *pseudoHeader,
+   const TcpHeader *segment)
+{
+   bool_t flag;
+   TcpSynQueueItem *queueItem;
+
+   //Initialize flag
+   flag = FALSE;
+
+   //Point to the very first item
+   queueItem = socket->synQueue;
+
+   //Loop through the SYN queue
+   while(queueItem != NULL)
+   {
+#if (IPV4_SUPPORT == ENABLED)
+      //IPv4 packet received?
+      if(queueItem->srcAddr.length == sizeof(Ipv4Addr) &&
+         queueItem->destAddr.length == sizeof(Ipv4Addr) &&
+         pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+      {
+         //Check source and destination addresses
+         if(queueItem->srcAddr.ipv4Addr == pseudoHeader->ipv4Data.srcAddr &&
+            queueItem->destAddr.ipv4Addr == pseudoHeader->ipv4Data.destAddr)
+         {
+            //Check source port
+            if(queueItem->srcPort == segment->srcPort)
+            {
+               //Duplicate SYN
+               flag = TRUE;
+            }
+         }
+      }
+      else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+      //IPv6 packet received?
+      if(queueItem->srcAddr.length == sizeof(Ipv6Addr) &&
+         queueItem->destAddr.length == sizeof(Ipv6Addr) &&
+         pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+      {
+         //Check source and destination addresses
+         if(ipv6CompAddr(&queueItem->srcAddr.ipv6Addr, &pseudoHeader->ipv6Data.srcAddr) &&
+            ipv6CompAddr(&queueItem->destAddr.ipv6Addr, &pseudoHeader->ipv6Data.destAddr))
+         {
+            //Check source port
+            if(queueItem->srcPort == segment->srcPort)
+            {
+               //Duplicate SYN
+               flag = TRUE;
+            }
+         }
+      }
+      else
+#endif
+      {
+         //Just for sanity
+      }
+
+      //Next item
+      queueItem = queueItem->next;
+   }
+
+   //Return TRUE if the SYN segment is a duplicate
+   return flag;
+}
+
+
+/**
+ * @brief Test whether the incoming acknowledgment is a duplicate
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Pointer to the TCP segment to check
+ * @param[in] length Length of the segment data
+ * @return TRUE if the ACK is duplicate, else FALSE
+ **/
+
+bool_t tcpIsDuplicateAck(Socket *socket, const TcpHeader *segment,
+   size_t length)
+{
+   bool_t flag;
+
+   //An ACK is considered a duplicate when the following conditions are met
+   flag = FALSE;
+
+   //The receiver of the ACK has outstanding data
+   if(socket->retransmitQueue != NULL)
+   {
+      //The incoming acknowledgment carries no data
+      if(length == 0)
+      {
+         //The SYN and FIN bits are both off
+         if((segment->flags & (TCP_FLAG_SYN | TCP_FLAG_FIN)) == 0)
+         {
+            //The acknowledgment number is equal to the greatest acknowledgment
+            //received on the given connection
+            if(segment->ackNum == socket->sndUna)
+            {
+               //The advertised window in the incoming acknowledgment equals
+               //the advertised window in the last incoming acknowledgment
+               if(segment->window == socket->sndWnd)
+               {
+                  //Duplicate ACK
+                  flag = TRUE;
+               }
+            }
+         }
+      }
+   }
+
+   //Return TRUE if the acknowledgment is a duplicate
+   return flag;
+}
+
+
+/**
+ * @brief Fast retransmit procedure
+ * @param[in] socket Handle referencing the current socket
+ **/
+
+void tcpFastRetransmit(Socket *socket)
+{
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   uint32_t flightSize;
+
+   //Amount of data that has been sent but not yet acknowledged
+   flightSize = socket->sndNxt - socket->sndUna;
+   //After receiving 3 duplicate ACKs, ssthresh must be adjusted
+   socket->ssthresh = MAX(flightSize / 2, 2 * socket->smss);
+
+   //The value of recover is incremented to the value of the highest
+   //sequence number transmitted by the TCP so far
+   socket->recover = socket->sndNxt - 1;
+
+   //Debug message
+   TRACE_INFO("TCP fast retransmit...\r\n");
+
+   //TCP performs a retransmission of what appears to be the missing segment,
+   //without waiting for the retransmission timer to expire
+   tcpRetransmitSegment(socket);
+
+   //cwnd must set to ssthresh plus 3*SMSS. This artificially inflates the
+   //congestion window by the number of segments (three) that have left the
+   //network and which the receiver has buffered
+   socket->cwnd = socket->ssthresh + TCP_FAST_RETRANSMIT_THRES * socket->smss;
+
+   //Enter the fast recovery procedure
+   socket->congestState = TCP_CONGEST_STATE_RECOVERY;
+#endif
+}
+
+
+/**
+ * @brief Fast recovery procedure
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Pointer to the incoming TCP segment
+ * @param[in] n Number of bytes acknowledged by the incoming ACK
+ **/
+
+void tcpFastRecovery(Socket *socket, const TcpHeader *segment, uint_t n)
+{
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   //Check whether this ACK acknowledges all of the data up to and including
+   //recover
+   if(TCP_CMP_SEQ(segment->ackNum, socket->recover) > 0)
+   {
+      //This is a full acknowledgment
+      TRACE_INFO("TCP full acknowledgment\r\n");
+
+      //Set cwnd to ssthresh
+      socket->cwnd = socket->ssthresh;
+      //Exit the fast recovery procedure
+      socket->congestState = TCP_CONGEST_STATE_IDLE;
+   }
+   else
+   {
+      //If this ACK does not acknowledge all of the data up to and including
+      //recover, then this is a partial ACK
+      TRACE_INFO("TCP partial acknowledgment\r\n");
+
+      //Retransmit the first unacknowledged segment
+      tcpRetransmitSegment(socket);
+
+      //Deflate the congestion window by the amount of new data acknowledged
+      //by the cumulative acknowledgment field
+      if(socket->cwnd > n)
+         socket->cwnd -= n;
+
+      //If the partial ACK acknowledges at least one SMSS of new data, then
+      //add back SMSS bytes to the congestion window. This artificially
+      //inflates the congestion window in order to reflect the additional
+      //segment that has left the network
+      if(n >= socket->smss)
+         socket->cwnd += socket->smss;
+
+      //Do not exit the fast recovery procedure...
+      socket->congestState = TCP_CONGEST_STATE_RECOVERY;
+   }
+#endif
+}
+
+
+/**
+ * @brief Fast loss recovery procedure
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Pointer to the incoming TCP segment
+ **/
+
+void tcpFastLossRecovery(Socket *socket, const TcpHeader *segment)
+{
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   //Check whether this ACK acknowledges all of the data up to and
+   //including recover
+   if(TCP_CMP_SEQ(segment->ackNum, socket->recover) > 0)
+   {
+      //This is a full acknowledgment
+      TRACE_INFO("TCP full acknowledgment\r\n");
+
+      //Exit the fast loss recovery procedure
+      socket->congestState = TCP_CONGEST_STATE_IDLE;
+   }
+   else
+   {
+      //If this ACK does not acknowledge all of the data up to and including
+      //recover, then this is a partial ACK
+      TRACE_INFO("TCP partial acknowledgment\r\n");
+
+      //Retransmit the first unacknowledged segment
+      tcpRetransmitSegment(socket);
+
+      //Do not exit the fast loss recovery procedure...
+      socket->congestState = TCP_CONGEST_STATE_LOSS_RECOVERY;
+   }
+#endif
+}
+
+
+/**
+ * @brief Process the segment text
+ * @param[in] socket Handle referencing the current socket
+ * @param[in] segment Pointer to the TCP header
+ * @param[in] buffer Multi-part buffer containing the incoming TCP segment
+ * @param[in] offset Offset to the first data byte
+ * @param[in] length Length of the segment data
+ **/
+
+void tcpProcessSegmentData(Socket *socket, const TcpHeader *segment,
+   const NetBuffer *buffer, size_t offset, size_t length)
+{
+   bool_t gap;
+   uint_t n;
+   uint32_t leftEdge;
+   uint32_t rightEdge;
+
+   //Number of segments received carrying data
+   socket->stats.inDataSegs++;
+
+   //First sequence number occupied by the incoming segment
+   leftEdge = segment->seqNum;
+   //Sequence number immediately following the incoming segment
+   rightEdge = segment->seqNum + length;
+
+   //Check whether some data falls outside the receive window
+   if(TCP_CMP_SEQ(leftEdge, socket->rcvNxt) < 0)
+   {
+      //Position of the first byte to be read
+      offset += socket->rcvNxt - leftEdge;
+      //Ignore the data that falls outside the receive window
+      leftEdge = socket->rcvNxt;
+   }
+
+   if(TCP_CMP_SEQ(rightEdge, socket->rcvNxt + socket->rcvWnd) > 0)
+   {
+      //Ignore the data that falls outside the receive window
+      rightEdge = socket->rcvNxt + socket->rcvWnd;
+   }
+
+   //Copy the incoming data to the receive buffer
+   tcpWriteRxBuffer(socket, leftEdge, buffer, offset, rightEdge - leftEdge);
+
+   //Number of blocks of data that have been queued out of order
+   n = socket->sackBlockCount;
+
+   //Update the list of non-contiguous blocks of data that have been received
+   //and queued
+   tcpUpdateSackBlocks(socket, &leftEdge, &rightEdge);
+
+   //Check whether the segment was received out of order
+   if(TCP_CMP_SEQ(leftEdge, socket->rcvNxt) > 0)
+   {
+      //Out of order data segments should be acknowledged immediately, in order
+      //to accelerate loss recovery
+      tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
+         FALSE);
+
+      //Number of ACKs sent immediately
+      socket->stats.quickAcks++;
+   }
+   else
+   {
+      //The segment fills in a gap when it joins data that were previously
+      //queued out of order (refer to RFC 5681, section 4.2)
+      gap = (socket->sackBlockCount < n) ? TRUE : FALSE;
+
+      //Number of contiguous bytes that have been received
+      length = rightEdge - leftEdge;
+
+      //Next sequence number expected on incoming segments
+      socket->rcvNxt += length;
+      //Number of data available in the receive buffer
+      socket->rcvUser += length;
+      //Update the receive window
+      socket->rcvWnd -= length;
+
+      //Acknowledge the received data
+      tcpAcknowledgeData(socket, segment, length, gap);
+
+      //Notify user task that data is available
+      tcpUpdateEvents(socket);
+   }
+}
+
+
+/**
+ * @brief Acknowledge in-sequence data
+ *
+ * When delayed ACKs are enabled, an ACK is generated for at least every second
+ * full-sized segment, and within TCP_DELAYED_ACK_TIMEOUT of the arrival of the
+ * first unacknowledged segment (refer to RFC 1122, section 4.2.3.2 and
+ * RFC 5681, section 4.2)
+ *
+ * @param[in] socket Handle referencing the socket
+ * @param[in] segment Pointer to the TCP header
+ * @param[in] length Number of in-sequence bytes that have been received
+ * @param[in] gap The segment fills in a gap in the sequence space up to data
+ *   that were queued out of order
+ **/
+
+void tcpAcknowledgeData(Socket *socket, const TcpHeader *segment,
+   size_t length, bool_t gap)
+{
+#if (TCP_DELAYED_ACK_SUPPORT == ENABLED)
+   //Update the amount of data received but not yet acknowledged
+   socket->rcvAckPending += length;
+
+   //An immediate ACK should be generated when an incoming segment fills in
+   //a gap in the sequence space, when the PSH flag is set or when the quick
+   //ACK mode is enabled
+   if(gap || (segment->flags & TCP_FLAG_PSH) != 0 ||
+      (socket->options & SOCKET_OPTION_TCP_QUICK_ACK) != 0)
+   {
+      //Send an ACK segment
+      tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
+         FALSE);
+
+      //Number of ACKs sent immediately
+      socket->stats.quickAcks++;
+   }
+   else if(socket->rcvAckPending >= (2 * socket->rmss))
+   {
+      //An ACK should be generated for at least every second full-sized
+      //segment
+      tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
+         FALSE);
+   }
+   else
+   {
+      //Start the delayed ACK timer if necessary
+      if(!netTimerRunning(&socket->delayedAckTimer))
+      {
+         netStartTimer(&socket->delayedAckTimer, TCP_DELAYED_ACK_TIMEOUT);
+      }
+   }
+#else
+   //Acknowledge the received data
+   tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
+      FALSE);
+#endif
+}
+
+
+/**
+ * @brief Delete TCB structure
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpDeleteControlBlock(Socket *socket)
+{
+   //Delete retransmission queue
+   tcpFlushRetransmitQueue(socket);
+
+   //Delete SYN queue
+   tcpFlushSynQueue(socket);
+
+   //Release transmit buffer
+   netBufferSetLength((NetBuffer *) &socket->txBuffer, 0);
+
+   //The release of the receive buffer is deferred as long as the user
+   //accesses the data in place
+   if(socket->rxRefLength == 0)
+   {
+      //Release receive buffer
+      netBufferSetLength((NetBuffer *) &socket->rxBuffer, 0);
+   }
+}
+
+
+/**
+ * @brief Remove acknowledged segments from retransmission queue
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpUpdateRetransmitQueue(Socket *socket)
+{
+   size_t length;
+   TcpQueueItem *prevQueueItem;
+   TcpQueueItem *queueItem;
+   TcpHeader *header;
+
+   //Point to the first item of the retransmission queue
+   prevQueueItem = NULL;
+   queueItem = socket->retransmitQueue;
+
+   //Loop through retransmission queue
+   while(queueItem != NULL)
+   {
+      //Point to the TCP header
+      header = (TcpHeader *) queueItem->header;
+
+      //Calculate the length of the TCP segment
+      if(header->flags & TCP_FLAG_SYN)
+      {
+         length = 1;
+      }
+      else if(header->flags & TCP_FLAG_FIN)
+      {
+         length = queueItem->length + 1;
+      }
+      else
+      {
+         length = queueItem->length;
+      }
+
+      //If an acknowledgment is received for a segment before its timer
+      //expires, the segment is removed from the retransmission queue
+      if(TCP_CMP_SEQ(socket->sndUna, ntohl(header->seqNum) + length) >= 0)
+      {
+         //First item of the queue?
+         if(prevQueueItem == NULL)
+         {
+            //Remove the current item from the queue
+            socket->retransmitQueue = queueItem->next;
+            //The item can now be safely deleted
+            memPoolFree(queueItem);
+            //Point to the next item
+            queueItem = socket->retransmitQueue;
+         }
+         else
+         {
+            //Remove the current item from the queue
+            prevQueueItem->next = queueItem->next;
+            //The item can now be safely deleted
+            memPoolFree(queueItem);
+            //Point to the next item
+            queueItem = prevQueueItem->next;
+         }
+
+         //When an ACK is received that acknowledges new data, restart the
+         //retransmission timer so that it will expire after RTO seconds
+         netStartTimer(&socket->retransmitTimer, socket->rto);
+         //Reset retransmission counter
+         socket->retransmitCount = 0;
+      }
+      //No acknowledgment received for the current segment...
+      else
+      {
+         //Point to the next item
+         prevQueueItem = queueItem;
+         queueItem = queueItem->next;
+      }
+   }
+
+   //When all outstanding data has been acknowledged,
+   //turn off the retransmission timer
+   if(socket->retransmitQueue == NULL)
+      netStopTimer(&socket->retransmitTimer);
+
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+   //Outstanding PMTU probe?
+   if(socket->pmtuProbeSize != 0)
+   {
+      //The probe has been acknowledged?
+      if(TCP_CMP_SEQ(socket->sndUna, socket->pmtuProbeSeqNum +
+         socket->pmtuProbeSize) >= 0)
+      {
+         //Debug message
+         TRACE_INFO("TCP PMTU probe acknowledged (MSS = %" PRIuSIZE ")\r\n",
+            socket->pmtuProbeSize);
+
+         //The probe size becomes the new MSS
+         socket->smss = socket->pmtuProbeSize;
+         socket->pmtuProbeSize = 0;
+
+         //Continue the search immediately, or wait for the probe interval to
+         //elapse once the search has converged
+         if(socket->pmtuSearchHigh >= (socket->smss + TCP_PLPMTUD_SEARCH_THRESHOLD))
+         {
+            socket->pmtuProbeTimestamp = osGetSystemTime();
+         }
+         else
+         {
+            socket->pmtuProbeTimestamp = osGetSystemTime() +
+               TCP_PLPMTUD_PROBE_INTERVAL;
+         }
+      }
+   }
+#endif
+}
+
+
+/**
+ * @brief Flush retransmission queue
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpFlushRetransmitQueue(Socket *socket)
+{
+   //Point to the first item in the retransmission queue
+   TcpQueueItem *queueItem = socket->retransmitQueue;
+
+   //Loop through retransmission queue
+   while(queueItem != NULL)
+   {
+      //Keep track of the next item in the queue
+      TcpQueueItem *nextQueueItem = queueItem->next;
+      //Free previously allocated memory
+      memPoolFree(queueItem);
+      //Point to the next item
+      queueItem = nextQueueItem;
+   }
+
+   //The retransmission queue is now flushed
+   socket->retransmitQueue = NULL;
+
+   //Turn off the retransmission timer
+   netStopTimer(&socket->retransmitTimer);
+}
+
+
+/**
+ * @brief Flush SYN queue
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpFlushSynQueue(Socket *socket)
+{
+   //Point to the first item in the SYN queue
+   TcpSynQueueItem *queueItem = socket->synQueue;
+
+   //Loop through SYN queue
+   while(queueItem != NULL)
+   {
+      //Keep track of the next item in the queue
+      TcpSynQueueItem *nextQueueItem = queueItem->next;
+      //Free previously allocated memory
+      memPoolFree(queueItem);
+      //Point to the next item
+      queueItem = nextQueueItem;
+   }
+
+   //SYN queue was successfully flushed
+   socket->synQueue = NULL;
+}
+
+
+/**
+ * @brief Select the member of a listening group that handles a new connection
+ *
+ * The group is made of the listening sockets that share the same interface,
+ * local address and local port, with SO_REUSEPORT enabled. The hash of the
+ * remote address and port ensures that all the segments of a given connection
+ * attempt are delivered to the same listener
+ *
+ * @param[in] socket First matching socket in the LISTEN state
+ * @param[in] pseudoHeader TCP pseudo header
+ * @param[in] segment Incoming TCP segment
+ * @return Listening socket that handles the connection
+ **/
+
+Socket *tcpSelectListener(Socket *socket, const IpPseudoHeader *pseudoHeader,
+   const TcpHeader *segment)
+{
+   uint_t i;
+   uint_t n;
+   uint32_t h;
+   Socket *member;
+   Socket *group[SOCKET_MAX_COUNT];
+
+   //The socket does not belong to a listening group?
+   if((socket->options & SOCKET_OPTION_REUSE_PORT) == 0)
+      return socket;
+
+   //Hash the source port number
+   h = ntohs(segment->srcPort);
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 packet received?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+   {
+      //Hash the source IPv4 address
+      h ^= ntohl(pseudoHeader->ipv4Data.srcAddr);
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 packet received?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+   {
+      //Hash the source IPv6 address
+      for(i = 0; i < 4; i++)
+      {
+         h ^= ntohl(pseudoHeader->ipv6Data.srcAddr.dw[i]);
+      }
+   }
+   else
+#endif
+   //Invalid packet received?
+   {
+      //This should never occur...
+   }
+
+   //Mix the bits of the hash value
+   h *= 0x9E3779B1;
+   h ^= h >> 16;
+
+   //Loop through the socket table
+   for(n = 0, i = 0; i < SOCKET_MAX_COUNT; i++)
+   {
+      //Point to the current socket
+      member = &socketTable[i];
+
+      //Check whether the socket belongs to the same group
+      if(member->type != SOCKET_TYPE_STREAM ||
+         member->state != TCP_STATE_LISTEN ||
+         (member->options & SOCKET_OPTION_REUSE_PORT) == 0 ||
+         member->interface != socket->interface ||
+         member->localPort != socket->localPort ||
+         member->localIpAddr.length != socket->localIpAddr.length ||
+         (member->localIpAddr.length != 0 &&
+         !ipCompAddr(&member->localIpAddr, &socket->localIpAddr)))
+      {
+         continue;
+      }
+
+      //Save the member of the group
+      group[n++] = member;
+   }
+
+   //Select a listener
+   if(n > 0)
+   {
+      socket = group[h % n];
+   }
+
+   //Return the selected listener
+   return socket;
+}
+
+
+/**
+ * @brief Enter the TIME-WAIT state
+ *
+ * When compact TIME-WAIT support is enabled, the connection is moved to the
+ * TIME-WAIT table and the socket is released immediately
+ *
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpEnterTimeWait(Socket *socket)
+{
+   //Release previously allocated resources
+   tcpDeleteControlBlock(socket);
+
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED && TCP_2MSL_TIMER > 0)
+   //Keep track of the connection in the TIME-WAIT table
+   tcpAddTimeWaitEntry(socket);
+
+   //The connection has been closed properly
+   socket->closedFlag = TRUE;
+   //The socket itself does not need to linger in the TIME-WAIT state
+   socket->state = TCP_STATE_CLOSED;
+   //Update TCP related events
+   tcpUpdateEvents(socket);
+
+   //Dispose the socket if the user does not have the ownership anymore
+   if(!socket->ownedFlag)
+   {
+      //Mark the socket as closed
+      socket->type = SOCKET_TYPE_UNUSED;
+   }
+#else
+   //Start the 2MSL timer
+   netStartTimer(&socket->timeWaitTimer, TCP_2MSL_TIMER);
+   //Switch to the TIME-WAIT state
+   tcpChangeState(socket, TCP_STATE_TIME_WAIT);
+#endif
+}
+
+
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+
+/**
+ * @brief Add a connection to the TIME-WAIT table
+ *
+ * The oldest entry is reused when the table runs out of space
+ *
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpAddTimeWaitEntry(Socket *socket)
+{
+   uint_t i;
+   systime_t time;
+   TcpTimeWaitEntry *entry;
+   TcpTimeWaitEntry *oldestEntry;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Keep track of the oldest entry
+   oldestEntry = NULL;
+
+   //Loop through the TIME-WAIT table
+   for(i = 0; i < TCP_TIME_WAIT_TABLE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &tcpTimeWaitTable[i];
+
+      //Check whether the entry is available
+      if(!entry->used)
+      {
+         oldestEntry = entry;
+         break;
+      }
+
+      //Keep track of the entry that expires first
+      if(oldestEntry == NULL ||
+         timeCompare(entry->expireTime, oldestEntry->expireTime) < 0)
+      {
+         oldestEntry = entry;
+      }
+   }
+
+   //Point to the selected entry
+   entry = oldestEntry;
+
+   //Save the 4-tuple that identifies the connection
+   entry->localIpAddr = socket->localIpAddr;
+   entry->localPort = socket->localPort;
+   entry->remoteIpAddr = socket->remoteIpAddr;
+   entry->remotePort = socket->remotePort;
+
+   //Save sequence numbers
+   entry->sndNxt = socket->sndNxt;
+   entry->rcvNxt = socket->rcvNxt;
+   //Save the last advertised window
+   entry->rcvWnd = socket->rcvWnd;
+
+   //Start the 2MSL timer
+   entry->expireTime = time + TCP_2MSL_TIMER;
+   //The entry is now in use
+   entry->used = TRUE;
+}
+
+
+/**
+ * @brief Search the TIME-WAIT table for a given connection
+ * @param[in] pseudoHeader TCP pseudo header
+ * @param[in] segment Incoming TCP segment
+ * @return Pointer to the matching entry, if any
+ **/
+
+TcpTimeWaitEntry *tcpFindTimeWaitEntry(const IpPseudoHeader *pseudoHeader,
+   const TcpHeader *segment)
+{
+   uint_t i;
+   IpAddr srcIpAddr;
+   IpAddr destIpAddr;
+   TcpTimeWaitEntry *entry;
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 segment?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+   {
+      //Retrieve source and destination addresses
+      srcIpAddr.length = sizeof(Ipv4Addr);
+      srcIpAddr.ipv4Addr = pseudoHeader->ipv4Data.srcAddr;
+      destIpAddr.length = sizeof(Ipv4Addr);
+      destIpAddr.ipv4Addr = pseudoHeader->ipv4Data.destAddr;
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 segment?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+   {
+      //Retrieve source and destination addresses
+      srcIpAddr.length = sizeof(Ipv6Addr);
+      srcIpAddr.ipv6Addr = pseudoHeader->ipv6Data.srcAddr;
+      destIpAddr.length = sizeof(Ipv6Addr);
+      destIpAddr.ipv6Addr = pseudoHeader->ipv6Data.destAddr;
+   }
+   else
+#endif
+   //Invalid pseudo header?
+   {
+      //This should never occur...
+      return NULL;
+   }
+
+   //Loop through the TIME-WAIT table
+   for(i = 0; i < TCP_TIME_WAIT_TABLE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &tcpTimeWaitTable[i];
+
+      //Skip unused entries
+      if(!entry->used)
+         continue;
+
+      //Check port numbers
+      if(entry->localPort != segment->destPort ||
+         entry->remotePort != segment->srcPort)
+      {
+         continue;
+      }
+
+      //Check remote address
+      if(!ipCompAddr(&entry->remoteIpAddr, &srcIpAddr))
+         continue;
+
+      //Check local address
+      if(!ipIsUnspecifiedAddr(&entry->localIpAddr) &&
+         !ipCompAddr(&entry->localIpAddr, &destIpAddr))
+      {
+         continue;
+      }
+
+      //A matching entry has been found
+      return entry;
+   }
+
+   //No matching entry
+   return NULL;
+}
+
+
+/**
+ * @brief Send an ACK on behalf of a connection in the TIME-WAIT table
+ * @param[in] entry Pointer to the TIME-WAIT entry
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader TCP pseudo header of the incoming segment
+ * @param[in] segment Incoming TCP segment
+ * @return Error code
+ **/
+
+error_t tcpSendTimeWaitAck(TcpTimeWaitEntry *entry, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment)
+{
+   error_t error;
+   size_t offset;
+   NetBuffer *buffer;
+   TcpHeader *segment2;
+   IpPseudoHeader pseudoHeader2;
+   NetTxAncillary ancillary;
+
+   //Allocate a memory buffer to hold the ACK segment
+   buffer = ipAllocBuffer(sizeof(TcpHeader), &offset);
+   //Failed to allocate memory?
+   if(buffer == NULL)
+      return ERROR_OUT_OF_MEMORY;
+
+   //Point to the beginning of the TCP segment
+   segment2 = netBufferAt(buffer, offset, 0);
+
+   //Format TCP header
+   segment2->srcPort = htons(segment->destPort);
+   segment2->destPort = htons(segment->srcPort);
+   segment2->seqNum = htonl(entry->sndNxt);
+   segment2->ackNum = htonl(entry->rcvNxt);
+   segment2->reserved1 = 0;
+   segment2->dataOffset = 5;
+   segment2->flags = TCP_FLAG_ACK;
+   segment2->reserved2 = 0;
+   segment2->window = htons(entry->rcvWnd);
+   segment2->checksum = 0;
+   segment2->urgentPointer = 0;
+
+#if (IPV4_SUPPORT == ENABLED)
+   //Destination address is an IPv4 address?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+   {
+      //Format IPv4 pseudo header
+      pseudoHeader2.length = sizeof(Ipv4PseudoHeader);
+      pseudoHeader2.ipv4Data.srcAddr = pseudoHeader->ipv4Data.destAddr;
+      pseudoHeader2.ipv4Data.destAddr = pseudoHeader->ipv4Data.srcAddr;
+      pseudoHeader2.ipv4Data.reserved = 0;
+      pseudoHeader2.ipv4Data.protocol = IPV4_PROTOCOL_TCP;
+      pseudoHeader2.ipv4Data.length = HTONS(sizeof(TcpHeader));
+
+      //Calculate TCP header checksum
+      segment2->checksum = ipCalcUpperLayerChecksumEx(&pseudoHeader2.ipv4Data,
+         sizeof(Ipv4PseudoHeader), buffer, offset, sizeof(TcpHeader));
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //Destination address is an IPv6 address?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+   {
+      //Format IPv6 pseudo header
+      pseudoHeader2.length = sizeof(Ipv6PseudoHeader);
+      pseudoHeader2.ipv6Data.srcAddr = pseudoHeader->ipv6Data.destAddr;
+      pseudoHeader2.ipv6Data.destAddr = pseudoHeader->ipv6Data.srcAddr;
+      pseudoHeader2.ipv6Data.length = HTONL(sizeof(TcpHeader));
+      pseudoHeader2.ipv6Data.reserved[0] = 0;
+      pseudoHeader2.ipv6Data.reserved[1] = 0;
+      pseudoHeader2.ipv6Data.reserved[2] = 0;
+      pseudoHeader2.ipv6Data.nextHeader = IPV6_TCP_HEADER;
+
+      //Calculate TCP header checksum
+      segment2->checksum = ipCalcUpperLayerChecksumEx(&pseudoHeader2.ipv6Data,
+         sizeof(Ipv6PseudoHeader), buffer, offset, sizeof(TcpHeader));
+   }
+   else
+#endif
+   //Destination address is not valid?
+   {
+      //Free previously allocated memory
+      netBufferFree(buffer);
+      //This should never occur...
+      return ERROR_INVALID_ADDRESS;
+   }
+
+   //Total number of segments sent
+   MIB2_TCP_INC_COUNTER32(tcpOutSegs, 1);
+   TCP_MIB_INC_COUNTER32(tcpOutSegs, 1);
+   TCP_MIB_INC_COUNTER64(tcpHCOutSegs, 1);
+
+   //Debug message
+   TRACE_DEBUG("%s: Sending TCP segment (TIME-WAIT)...\r\n",
+      formatSystemTime(osGetSystemTime(), NULL));
+
+   //Dump TCP header contents for debugging purpose
+   tcpDumpHeader(segment2, 0, 0, 0);
+
+   //Additional options can be passed to the stack along with the packet
+   ancillary = NET_DEFAULT_TX_ANCILLARY;
+
+   //Send TCP segment
+   error = ipSendDatagram(interface, &pseudoHeader2, buffer, offset,
+      &ancillary);
+
+   //Free previously allocated memory
+   netBufferFree(buffer);
+
+   //Return error code
+   return error;
+}
+
+#endif
+
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+
+/**
+ * @brief Generate a TFO cookie for a given client
+ * @param[in] clientIpAddr IP address of the client
+ * @param[out] cookie Buffer where to store the cookie
+ **/
+
+void tcpGenerateFastOpenCookie(const IpAddr *clientIpAddr, uint8_t *cookie)
+{
+   Md5Context md5Context;
+
+   //The cookie is a MAC of the client IP address, keyed with a secret known
+   //only to the server (refer to RFC 7413, section 4.1.2)
+   md5Init(&md5Context);
+   md5Update(&md5Context, "TFO", 3);
+   //Only the significant bytes of the address are hashed, since the rest
+   //of the structure may not be initialized
+   md5Update(&md5Context, &clientIpAddr->length, sizeof(size_t));
+   md5Update(&md5Context, clientIpAddr->addr, clientIpAddr->length);
+   md5Update(&md5Context, netContext.randSeed, NET_RAND_SEED_SIZE);
+   md5Final(&md5Context, NULL);
+
+   //Truncate the digest value
+   osMemcpy(cookie, md5Context.digest, TCP_FAST_OPEN_COOKIE_SIZE);
+}
+
+
+/**
+ * @brief Check a TFO cookie received in a SYN segment
+ * @param[in] clientIpAddr IP address of the client
+ * @param[in] cookie Pointer to the cookie
+ * @param[in] length Length of the cookie, in bytes
+ * @return TRUE if the cookie is valid, else FALSE
+ **/
+
+bool_t tcpCheckFastOpenCookie(const IpAddr *clientIpAddr,
+   const uint8_t *cookie, size_t length)
+{
+   uint8_t expectedCookie[TCP_FAST_OPEN_COOKIE_SIZE];
+
+   //Check the length of the cookie
+   if(length != TCP_FAST_OPEN_COOKIE_SIZE)
+      return FALSE;
+
+   //Compute the cookie that is expected for this client
+   tcpGenerateFastOpenCookie(clientIpAddr, expectedCookie);
+
+   //Compare cookies
+   return (osMemcmp(cookie, expectedCookie, length) == 0) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Search the TFO cookie cache for a given server
+ * @param[in] serverIpAddr IP address of the server
+ * @return Pointer to the matching entry, if any
+ **/
+
+TcpFastOpenCacheEntry *tcpFindFastOpenCookie(const IpAddr *serverIpAddr)
+{
+   uint_t i;
+   TcpFastOpenCacheEntry *entry;
+
+   //Loop through the cache
+   for(i = 0; i < TCP_FAST_OPEN_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &tcpFastOpenCache[i];
+
+      //Matching entry?
+      if(entry->cookieLen > 0 && ipCompAddr(&entry->serverIpAddr, serverIpAddr))
+      {
+         //Refresh the entry
+         entry->timestamp = osGetSystemTime();
+         //Return a pointer to the entry
+         return entry;
+      }
+   }
+
+   //No cookie has been received from this server
+   return NULL;
+}
+
+
+/**
+ * @brief Save a TFO cookie received from a server
+ *
+ * The least recently used entry is replaced when the cache is full
+ *
+ * @param[in] serverIpAddr IP address of the server
+ * @param[in] mss MSS advertised by the server
+ * @param[in] cookie Pointer to the cookie
+ * @param[in] length Length of the cookie, in bytes
+ **/
+
+void tcpSaveFastOpenCookie(const IpAddr *serverIpAddr, uint16_t mss,
+   const uint8_t *cookie, size_t length)
+{
+   uint_t i;
+   systime_t time;
+   TcpFastOpenCacheEntry *entry;
+   TcpFastOpenCacheEntry *oldestEntry;
+
+   //Check the length of the cookie (refer to RFC 7413, section 4.1.1)
+   if(length < 4 || length > TCP_FAST_OPEN_MAX_COOKIE_SIZE)
+      return;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Keep track of the least recently used entry
+   oldestEntry = NULL;
+
+   //Loop through the cache
+   for(i = 0; i < TCP_FAST_OPEN_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &tcpFastOpenCache[i];
+
+      //Check whether the entry is available
+      if(entry->cookieLen == 0)
+      {
+         //Use this entry unless the server is already in the cache
+         if(oldestEntry == NULL || oldestEntry->cookieLen > 0)
+         {
+            oldestEntry = entry;
+         }
+      }
+      else if(ipCompAddr(&entry->serverIpAddr, serverIpAddr))
+      {
+         //Update the existing entry
+         oldestEntry = entry;
+         break;
+      }
+      else if(oldestEntry == NULL || (oldestEntry->cookieLen > 0 &&
+         timeCompare(entry->timestamp, oldestEntry->timestamp) < 0))
+      {
+         //Keep track of the least recently used entry
+         oldestEntry = entry;
+      }
+      else
+      {
+         //Just for sanity
+      }
+   }
+
+   //Point to the selected entry
+   entry = oldestEntry;
+
+   //Save the cookie along with the MSS of the server
+   entry->serverIpAddr = *serverIpAddr;
+   entry->mss = mss;
+   osMemcpy(entry->cookie, cookie, length);
+   entry->cookieLen = length;
+   entry->timestamp = time;
+}
+
+
+/**
+ * @brief Send the SYN segment of a TFO connection
+ *
+ * If a cookie has been cached for the server, the SYN carries the cookie
+ * and the first bytes of data. Otherwise the SYN requests a cookie and the
+ * data are sent once the connection is established
+ *
+ * @param[in] socket Handle referencing the socket
+ * @param[in] data Pointer to the data to be sent
+ * @param[in] length Number of bytes to be sent
+ * @param[out] written Number of bytes that have been queued
+ * @return Error code
+ **/
+
+error_t tcpSendFastOpenSyn(Socket *socket, const uint8_t *data, size_t length,
+   size_t *written)
+{
+   error_t error;
+   size_t n;
+   size_t m;
+   TcpFastOpenCacheEntry *entry;
+
+   //The SYN is no longer deferred
+   socket->fastOpenPending = FALSE;
+   //Append a TFO option to the SYN
+   socket->fastOpenOption = TRUE;
+
+   //Number of bytes that can be queued
+   n = MIN(length, socket->txBufferSize);
+
+   //Search the cache for a cookie previously received from the server
+   entry = tcpFindFastOpenCookie(&socket->remoteIpAddr);
+
+   //Cookie found?
+   if(entry != NULL)
+   {
+      //Include the cookie in the SYN
+      osMemcpy(socket->fastOpenCookie, entry->cookie, entry->cookieLen);
+      socket->fastOpenCookieLen = entry->cookieLen;
+
+      //The SYN and its options must fit within the MSS of the server
+      m = MIN(n, TCP_FAST_OPEN_MAX_SYN_DATA);
+
+      if(entry->mss > (TCP_MAX_HEADER_LENGTH - sizeof(TcpHeader)))
+      {
+         m = MIN(m, entry->mss - (TCP_MAX_HEADER_LENGTH - sizeof(TcpHeader)));
+      }
+      else
+      {
+         m = 0;
+      }
+   }
+   else
+   {
+      //An empty cookie requests a cookie from the server
+      socket->fastOpenCookieLen = 0;
+      //No data can be carried by the SYN
+      m = 0;
+   }
+
+   //Copy user data to the send buffer
+   if(n > 0)
+   {
+      tcpWriteTxBuffer(socket, socket->iss + 1, data, n);
+   }
+
+   //Send a SYN segment
+   error = tcpSendSegment(socket, TCP_FLAG_SYN, socket->iss, 0, m, TRUE);
+
+   //Check status code
+   if(!error)
+   {
+      //Data carried by the SYN have been sent
+      socket->sndNxt += m;
+      //The remaining data will be sent once the connection is established
+      socket->sndUser = n - m;
+
+      //Total number of data that have been queued
+      if(written != NULL)
+      {
+         *written = n;
+      }
+   }
+
+   //Return status code
+   return error;
+}
+
+#endif
+
+
+/**
+ * @brief Update the list of non-contiguous blocks that have been received
+ * @param[in] socket Handle referencing the socket
+ * @param[in,out] leftEdge First sequence number occupied by the incoming data
+ * @param[in,out] rightEdge Sequence number immediately following the incoming data
+ **/
+
+void tcpUpdateSackBlocks(Socket *socket, uint32_t *leftEdge, uint32_t *rightEdge)
+{
+   uint_t i = 0;
+
+   //Loop through the blocks
+   while(i < socket->sackBlockCount)
+   {
+      //Find each block that overlaps the specified one
+      if(TCP_CMP_SEQ(*rightEdge, socket->sackBlock[i].leftEdge) >= 0 &&
+         TCP_CMP_SEQ(*leftEdge, socket->sackBlock[i].rightEdge) <= 0)
+      {
+         //Merge blocks to form a contiguous one
+         *leftEdge = MIN(*leftEdge, socket->sackBlock[i].leftEdge);
+         *rightEdge = MAX(*rightEdge, socket->sackBlock[i].rightEdge);
+
+         //Delete current block
+         osMemmove(socket->sackBlock + i, socket->sackBlock + i + 1,
+            (TCP_MAX_SACK_BLOCKS - i - 1) * sizeof(TcpSackBlock));
+
+         //Decrement the number of non-contiguous blocks
+         socket->sackBlockCount--;
+      }
+      else
       {
-         n--;
+         //Point to the next block
+         i++;
       }
+   }
 
-      //Total number of bytes acknowledged during the whole round-trip
-      socket->n += n;
-#endif
-      //Update SND.UNA pointer
-      socket->sndUna = segment->ackNum;
-
-      //Compute retransmission timeout
-      updateFlag = tcpComputeRto(socket);
-      (void) updateFlag;
+   //Check whether the incoming segment was received out of order
+   if(TCP_CMP_SEQ(*leftEdge, socket->rcvNxt) > 0)
+   {
+      //Make room for the new non-contiguous block
+      osMemmove(socket->sackBlock + 1, socket->sackBlock,
+         (TCP_MAX_SACK_BLOCKS - 1) * sizeof(TcpSackBlock));
 
-      //Any segments on the retransmission queue which are thereby entirely
-      //acknowledged are removed
-      tcpUpdateRetransmitQueue(socket);
+      //Insert the element in the list
+      socket->sackBlock[0].leftEdge = *leftEdge;
+      socket->sackBlock[0].rightEdge = *rightEdge;
 
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-      //Check congestion state
-      if(socket->congestState == TCP_CONGEST_STATE_RECOVERY)
+      //Increment the number of non-contiguous blocks
+      if(socket->sackBlockCount < TCP_MAX_SACK_BLOCKS)
       {
-         //Invoke fast recovery (refer to RFC 6582)
-         tcpFastRecovery(socket, segment, n);
+         socket->sackBlockCount++;
       }
-      else
-      {
-         //Reset duplicate ACK counter
-         socket->dupAckCount = 0;
+   }
+}
 
-         //Check congestion state
-         if(socket->congestState == TCP_CONGEST_STATE_LOSS_RECOVERY)
-         {
-            //Invoke fast loss recovery
-            tcpFastLossRecovery(socket, segment);
-         }
 
-         //Slow start algorithm is used when cwnd is lower than ssthresh
-         if(socket->cwnd < socket->ssthresh)
-         {
-            //During slow start, TCP increments cwnd by at most SMSS bytes
-            //for each ACK received that cumulatively acknowledges new data
-            socket->cwnd += MIN(n, socket->smss);
-         }
-         //Congestion avoidance algorithm is used when cwnd exceeds ssthres
-         else
-         {
-            //Congestion window is updated once per RTT
-            if(updateFlag)
-            {
-               //TCP must not increment cwnd by more than SMSS bytes
-               socket->cwnd += MIN(socket->n, socket->smss);
-            }
-         }
+/**
+ * @brief Update send window
+ * @param[in] socket Handle referencing the socket
+ * @param[in] segment Pointer to the incoming TCP segment
+ **/
+
+void tcpUpdateSendWindow(Socket *socket, const TcpHeader *segment)
+{
+   //Case where neither the sequence nor the acknowledgment number is increased
+   if(segment->seqNum == socket->sndWl1 && segment->ackNum == socket->sndWl2)
+   {
+      //TCP may ignore a window update with a smaller window than previously
+      //offered if neither the sequence number nor the acknowledgment number
+      //is increased (refer to RFC 1122, section 4.2.2.16)
+      if(segment->window > socket->sndWnd)
+      {
+         //Update the send window and record the sequence number and the
+         //acknowledgment number used to update SND.WND
+         socket->sndWnd = segment->window;
+         socket->sndWl1 = segment->seqNum;
+         socket->sndWl2 = segment->ackNum;
+
+         //Maximum send window it has seen so far on the connection
+         socket->maxSndWnd = MAX(socket->maxSndWnd, segment->window);
+      }
+   }
+   //Case where the sequence or the acknowledgment number is increased
+   else if(TCP_CMP_SEQ(segment->seqNum, socket->sndWl1) >= 0 &&
+      TCP_CMP_SEQ(segment->ackNum, socket->sndWl2) >= 0)
+   {
+      //Check whether the remote host advertises a zero window
+      if(segment->window == 0 && socket->sndWnd != 0)
+      {
+         //Start the persist timer
+         socket->wndProbeCount = 0;
+         socket->wndProbeInterval = TCP_DEFAULT_PROBE_INTERVAL;
+         netStartTimer(&socket->persistTimer, socket->wndProbeInterval);
       }
 
-      //Limit the size of the congestion window
-      socket->cwnd = MIN(socket->cwnd, socket->txBufferSize);
-#endif
+      //Update the send window and record the sequence number and the
+      //acknowledgment number used to update SND.WND
+      socket->sndWnd = segment->window;
+      socket->sndWl1 = segment->seqNum;
+      socket->sndWl2 = segment->ackNum;
+
+      //Maximum send window it has seen so far on the connection
+      socket->maxSndWnd = MAX(socket->maxSndWnd, segment->window);
    }
-   //The incoming ACK segment does not acknowledge new data?
-   else
+}
+
+
+/**
+ * @brief Update receive window so as to avoid Silly Window Syndrome
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpUpdateReceiveWindow(Socket *socket)
+{
+   uint16_t reduction;
+
+   //Space available but not yet advertised
+   reduction = socket->rxBufferSize - socket->rcvUser - socket->rcvWnd;
+
+   //To avoid SWS, the receiver should not advertise small windows
+   if((socket->rcvWnd + reduction) >= MIN(socket->rmss, socket->rxBufferSize / 2))
    {
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-      //Check whether the acknowledgment is a duplicate
-      if(duplicateFlag)
+      //Check whether a window update should be sent
+      if(socket->rcvWnd < MIN(socket->rmss, socket->rxBufferSize / 2))
       {
-         //Increment duplicate ACK counter
-         socket->dupAckCount++;
          //Debug message
-         TRACE_INFO("TCP duplicate ACK #%u\r\n", socket->dupAckCount);
+         TRACE_INFO("%s: TCP sending window update...\r\n",
+            formatSystemTime(osGetSystemTime(), NULL));
+
+         //Update the receive window
+         socket->rcvWnd += reduction;
+
+         //Send an ACK segment to advertise the new window size
+         tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt,
+            0, FALSE);
       }
       else
       {
-         //Reset duplicate ACK counter
-         socket->dupAckCount = 0;
+         //The receive window can be updated
+         socket->rcvWnd += reduction;
       }
+   }
+}
 
-      //Check congestion state
-      if(socket->congestState == TCP_CONGEST_STATE_IDLE)
-      {
-         //Use default duplicate ACK threshold
-         thresh = TCP_FAST_RETRANSMIT_THRES;
-         //Amount of data sent but not yet acknowledged
-         ownd = socket->sndNxt - socket->sndUna;
 
-         //Test if there is either no unsent data ready for transmission at
-         //the sender, or the advertised receive window does not permit new
-         //segments to be transmitted (refer to RFC 5827 section 3.1)
-         if(socket->sndUser == 0 || socket->sndWnd <= (socket->sndNxt - socket->sndUna))
-         {
-            //Compute the duplicate ACK threshold used to trigger a
-            //retransmission
-            if(ownd <= (3 * socket->smss))
-            {
-               thresh = 1;
-            }
-            else if(ownd <= (4 * socket->smss))
-            {
-               thresh = 2;
-            }
-            else
-            {
-            }
-         }
+#if (TCP_AUTO_TUNING_SUPPORT == ENABLED)
 
-         //Check the number of duplicate ACKs that have been received
-         if(socket->dupAckCount >= thresh)
-         {
-            //The TCP sender first checks the value of recover to see if the
-            //cumulative acknowledgment field covers more than recover
-            if(TCP_CMP_SEQ(segment->ackNum, socket->recover + 1) > 0)
-            {
-               //Invoke Fast Retransmit (refer to RFC 6582)
-               tcpFastRetransmit(socket);
-            }
-            else
-            {
-               //If not, the TCP does not enter fast retransmit and does not
-               //reset ssthres...
-            }
-         }
-      }
-      else if(socket->congestState == TCP_CONGEST_STATE_RECOVERY)
+/**
+ * @brief Send buffer auto-tuning
+ *
+ * The send buffer is doubled when it limits the congestion window and the
+ * application has more data to write than the buffer can hold
+ *
+ * @param[in] socket Handle referencing the socket
+ * @param[in] length Number of bytes the application is trying to write
+ **/
+
+void tcpAutoTuneTxBuffer(Socket *socket, size_t length)
+{
+   error_t error;
+   size_t n;
+   size_t offset;
+   size_t newSize;
+
+   //The size of the buffer has been set by the user?
+   if(socket->txBufferLocked)
+      return;
+
+   //Check current TCP state
+   if(socket->state != TCP_STATE_ESTABLISHED &&
+      socket->state != TCP_STATE_CLOSE_WAIT)
+   {
+      return;
+   }
+
+   //Number of bytes in the send buffer
+   n = socket->sndUser + socket->sndNxt - socket->sndUna;
+
+   //Enough room for the data to write?
+   if((n + length) <= socket->txBufferSize)
+      return;
+
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   //The congestion window is capped to the size of the send buffer
+   if(socket->cwnd < socket->txBufferSize)
+      return;
+#endif
+
+   //A larger buffer is useless if the receiver cannot accept more data
+   if(socket->maxSndWnd <= socket->txBufferSize)
+      return;
+
+   //Double the size of the buffer
+   newSize = MIN(2 * socket->txBufferSize, TCP_MAX_TX_BUFFER_SIZE);
+   newSize = MIN(newSize, socket->maxSndWnd);
+
+   //Check whether the buffer can be enlarged
+   if(newSize <= socket->txBufferSize)
+      return;
+
+   //Make sure enough memory is left for other connections
+   if(!tcpCheckBufferMemory(socket->txBufferSize, newSize))
+      return;
+
+   //Position of the oldest unacknowledged byte
+   offset = (socket->sndUna - socket->iss - 1 + socket->txBufferOffset) %
+      socket->txBufferSize;
+
+   //Enlarge the circular buffer
+   error = tcpGrowBuffer((NetBuffer *) &socket->txBuffer, socket->txBufferSize,
+      newSize, offset, n);
+
+   //Check status code
+   if(!error)
+   {
+      //Debug message
+      TRACE_DEBUG("TCP send buffer enlarged to %" PRIuSIZE " bytes\r\n", newSize);
+
+      //Buffered data keep their position in the buffer
+      socket->txBufferOffset = offset - (socket->sndUna - socket->iss - 1);
+      socket->txBufferSize = newSize;
+
+      //Number of times the send buffer has been enlarged
+      socket->stats.txBufferGrowths++;
+   }
+}
+
+
+/**
+ * @brief Receive buffer auto-tuning
+ *
+ * The amount of data read by the application during one RTT is measured. The
+ * receive buffer is enlarged so as to hold twice this amount, which lets the
+ * sender keep the pipe full (dynamic right-sizing)
+ *
+ * @param[in] socket Handle referencing the socket
+ * @param[in] length Number of bytes that have just been read by the application
+ **/
+
+void tcpAutoTuneRxBuffer(Socket *socket, size_t length)
+{
+   error_t error;
+   uint_t i;
+   uint32_t seqNum;
+   size_t n;
+   size_t offset;
+   size_t newSize;
+   systime_t time;
+
+   //The size of the buffer has been set by the user?
+   if(socket->rxBufferLocked)
+      return;
+
+   //Check current TCP state
+   if(socket->state != TCP_STATE_ESTABLISHED &&
+      socket->state != TCP_STATE_FIN_WAIT_1 &&
+      socket->state != TCP_STATE_FIN_WAIT_2)
+   {
+      return;
+   }
+
+   //No RTT sample is available yet?
+   if(socket->srtt == 0)
+      return;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Number of bytes read during the current measurement interval
+   socket->rcvSpaceCopied += length;
+
+   //The measurement interval is one RTT
+   if(timeCompare(time, socket->rcvSpaceTimestamp + socket->srtt) < 0)
+      return;
+
+   //Size required to sustain the observed drain rate
+   newSize = 2 * socket->rcvSpaceCopied;
+   newSize = MIN(newSize, TCP_MAX_RX_BUFFER_SIZE);
+   newSize = MIN(newSize, UINT16_MAX);
+
+   //The buffer cannot be reorganized while the user holds views of the data.
+   //The measurement interval is extended until the views are released
+   if(socket->rxRefLength != 0 && newSize > socket->rxBufferSize)
+      return;
+
+   //Start a new measurement interval
+   socket->rcvSpaceCopied = 0;
+   socket->rcvSpaceTimestamp = time;
+
+   //Check whether the buffer must be enlarged
+   if(newSize <= socket->rxBufferSize)
+      return;
+
+   //Make sure enough memory is left for other connections
+   if(!tcpCheckBufferMemory(socket->rxBufferSize, newSize))
+      return;
+
+   //Data that have been received out of order must be preserved
+   seqNum = socket->rcvNxt;
+
+   for(i = 0; i < socket->sackBlockCount && i < TCP_MAX_SACK_BLOCKS; i++)
+   {
+      if(TCP_CMP_SEQ(socket->sackBlock[i].rightEdge, seqNum) > 0)
       {
-         //Duplicate ACK received?
-         if(duplicateFlag)
-         {
-            //For each additional duplicate ACK received (after the third),
-            //cwnd must be incremented by SMSS. This artificially inflates
-            //the congestion window in order to reflect the additional
-            //segment that has left the network
-            socket->cwnd += socket->smss;
-         }
+         seqNum = socket->sackBlock[i].rightEdge;
       }
-
-      //Limit the size of the congestion window
-      socket->cwnd = MIN(socket->cwnd, socket->txBufferSize);
-#endif
    }
 
-   //Update TX events
-   tcpUpdateEvents(socket);
+   //Number of bytes in the receive buffer
+   n = seqNum - (socket->rcvNxt - socket->rcvUser);
 
-   //No error to report
-   return NO_ERROR;
+   //Position of the first byte to be read by the application
+   offset = (socket->rcvNxt - socket->rcvUser - socket->irs - 1 +
+      socket->rxBufferOffset) % socket->rxBufferSize;
+
+   //Enlarge the circular buffer
+   error = tcpGrowBuffer((NetBuffer *) &socket->rxBuffer, socket->rxBufferSize,
+      newSize, offset, n);
+
+   //Check status code
+   if(!error)
+   {
+      //Debug message
+      TRACE_DEBUG("TCP receive buffer enlarged to %" PRIuSIZE " bytes\r\n",
+         newSize);
+
+      //Buffered data keep their position in the buffer
+      socket->rxBufferOffset = offset - (socket->rcvNxt - socket->rcvUser -
+         socket->irs - 1);
+      socket->rxBufferSize = newSize;
+
+      //Number of times the receive buffer has been enlarged
+      socket->stats.rxBufferGrowths++;
+   }
 }
 
 
 /**
- * @brief Test whether the incoming SYN segment is a duplicate
- * @param[in] socket Handle referencing the current socket
- * @param[in] pseudoHeader TCP pseudo header
- * @param[in] segment Pointer to the TCP segment to check
- * @return TRUE if the SYN segment is duplicate, else FALSE
+ * @brief Enlarge a circular buffer
+ *
+ * Data that wrap around to the beginning of the buffer are moved right after
+ * the end of the former buffer, so that valid data remain contiguous
+ *
+ * @param[in] buffer Multi-part buffer
+ * @param[in] size Current size of the buffer
+ * @param[in] newSize New size of the buffer
+ * @param[in] offset Position of the first byte of valid data
+ * @param[in] length Number of bytes of valid data
+ * @return Error code
  **/
 
-bool_t tcpIsDuplicateSyn(Socket *socket, const IpPseudoHeader *pseudoHeader,
-   const TcpHeader *segment)
+error_t tcpGrowBuffer(NetBuffer *buffer, size_t size, size_t newSize,
+   size_t offset, size_t length)
 {
-   bool_t flag;
-   TcpSynQueueItem *queueItem;
+   error_t error;
+   size_t n;
 
-   //Initialize flag
-   flag = FALSE;
+   //Number of bytes that wrap around to the beginning of the buffer
+   if((offset + length) > size)
+   {
+      n = offset + length - size;
+   }
+   else
+   {
+      n = 0;
+   }
 
-   //Point to the very first item
-   queueItem = socket->synQueue;
+   //The wrapped data must fit in the newly allocated space
+   if(n > (newSize - size))
+      return ERROR_BUFFER_OVERFLOW;
 
-   //Loop through the SYN queue
-   while(queueItem != NULL)
+   //Allocate additional chunks
+   error = netBufferSetLength(buffer, newSize);
+
+   //Check status code
+   if(!error)
    {
-#if (IPV4_SUPPORT == ENABLED)
-      //IPv4 packet received?
-      if(queueItem->srcAddr.length == sizeof(Ipv4Addr) &&
-         queueItem->destAddr.length == sizeof(Ipv4Addr) &&
-         pseudoHeader->length == sizeof(Ipv4PseudoHeader))
-      {
-         //Check source and destination addresses
-         if(queueItem->srcAddr.ipv4Addr == pseudoHeader->ipv4Data.srcAddr &&
-            queueItem->destAddr.ipv4Addr == pseudoHeader->ipv4Data.destAddr)
-         {
-            //Check source port
-            if(queueItem->srcPort == segment->srcPort)
-            {
-               //Duplicate SYN
-               flag = TRUE;
-            }
-         }
-      }
-      else
-#endif
-#if (IPV6_SUPPORT == ENABLED)
-      //IPv6 packet received?
-      if(queueItem->srcAddr.length == sizeof(Ipv6Addr) &&
-         queueItem->destAddr.length == sizeof(Ipv6Addr) &&
-         pseudoHeader->length == sizeof(Ipv6PseudoHeader))
-      {
-         //Check source and destination addresses
-         if(ipv6CompAddr(&queueItem->srcAddr.ipv6Addr, &pseudoHeader->ipv6Data.srcAddr) &&
-            ipv6CompAddr(&queueItem->destAddr.ipv6Addr, &pseudoHeader->ipv6Data.destAddr))
-         {
-            //Check source port
-            if(queueItem->srcPort == segment->srcPort)
-            {
-               //Duplicate SYN
-               flag = TRUE;
-            }
-         }
-      }
-      else
-#endif
+      //Move the wrapped data
+      if(n > 0)
       {
-         //Just for sanity
+         error = netBufferCopy(buffer, size, buffer, 0, n);
       }
-
-      //Next item
-      queueItem = queueItem->next;
+   }
+   else
+   {
+      //Release the chunks that have been allocated
+      netBufferSetLength(buffer, size);
    }
 
-   //Return TRUE if the SYN segment is a duplicate
-   return flag;
+   //Return status code
+   return error;
 }
 
 
 /**
- * @brief Test whether the incoming acknowledgment is a duplicate
- * @param[in] socket Handle referencing the current socket
- * @param[in] segment Pointer to the TCP segment to check
- * @param[in] length Length of the segment data
- * @return TRUE if the ACK is duplicate, else FALSE
+ * @brief Check whether the memory pool can accommodate a larger buffer
+ * @param[in] size Current size of the buffer
+ * @param[in] newSize Requested size of the buffer
+ * @return TRUE if the buffer can be enlarged, else FALSE
  **/
 
-bool_t tcpIsDuplicateAck(Socket *socket, const TcpHeader *segment,
-   size_t length)
+bool_t tcpCheckBufferMemory(size_t size, size_t newSize)
+{
+#if (NET_MEM_POOL_SUPPORT == ENABLED)
+   uint_t n;
+   uint_t currentUsage;
+   uint_t poolSize;
+
+   //Get memory pool usage
+   memPoolGetStats(&currentUsage, NULL, &poolSize);
+
+   //Number of additional blocks
+   n = N(newSize) - N(size);
+
+   //A fraction of the pool is kept for incoming packets and other connections
+   if(((currentUsage + n) * 100) > (poolSize * (100 - TCP_AUTO_TUNING_POOL_RESERVE)))
+      return FALSE;
+#endif
+
+   //The buffer can be enlarged
+   return TRUE;
+}
+
+#endif
+
+
+/**
+ * @brief Compute retransmission timeout
+ * @param[in] socket Handle referencing the socket
+ * @return TRUE if the RTT measurement is complete, else FALSE
+ **/
+
+bool_t tcpComputeRto(Socket *socket)
 {
    bool_t flag;
+   systime_t r;
+   systime_t delta;
 
-   //An ACK is considered a duplicate when the following conditions are met
+   //Clear flag
    flag = FALSE;
 
-   //The receiver of the ACK has outstanding data
-   if(socket->retransmitQueue != NULL)
+   //TCP implementation takes one RTT measurement at a time
+   if(socket->rttBusy)
    {
-      //The incoming acknowledgment carries no data
-      if(length == 0)
+      //Ensure the incoming ACK number covers the expected sequence number
+      if(TCP_CMP_SEQ(socket->sndUna, socket->rttSeqNum) > 0)
       {
-         //The SYN and FIN bits are both off
-         if((segment->flags & (TCP_FLAG_SYN | TCP_FLAG_FIN)) == 0)
+         //Calculate round-time trip
+         r = osGetSystemTime() - socket->rttStartTime;
+
+         //First RTT measurement?
+         if(socket->srtt == 0 && socket->rttvar == 0)
          {
-            //The acknowledgment number is equal to the greatest acknowledgment
-            //received on the given connection
-            if(segment->ackNum == socket->sndUna)
-            {
-               //The advertised window in the incoming acknowledgment equals
-               //the advertised window in the last incoming acknowledgment
-               if(segment->window == socket->sndWnd)
-               {
-                  //Duplicate ACK
-                  flag = TRUE;
-               }
-            }
+            //Initialize RTO calculation algorithm
+            socket->srtt = r;
+            socket->rttvar = r / 2;
+         }
+         else
+         {
+            //Calculate the difference between the measured value and the
+            //current RTT estimator
+            delta = (r > socket->srtt) ? (r - socket->srtt) : (socket->srtt - r);
+
+            //Implement Van Jacobson's algorithm (as specified in RFC 6298 2.3)
+            socket->rttvar = (3 * socket->rttvar + delta) / 4;
+            socket->srtt = (7 * socket->srtt + r) / 8;
          }
+
+         //Calculate the next retransmission timeout
+         socket->rto = socket->srtt + 4 * socket->rttvar;
+
+         //Whenever RTO is computed, if it is less than 1 second, then the RTO
+         //should be rounded up to 1 second
+         socket->rto = MAX(socket->rto, TCP_MIN_RTO);
+
+         //A maximum value may be placed on RTO provided it is at least 60
+         //seconds
+         socket->rto = MIN(socket->rto, TCP_MAX_RTO);
+
+         //Debug message
+         TRACE_DEBUG("R=%" PRIu32 ", SRTT=%" PRIu32 ", RTTVAR=%" PRIu32 ", RTO=%" PRIu32 "\r\n",
+            r, socket->srtt, socket->rttvar, socket->rto);
+
+         //RTT measurement is complete
+         socket->rttBusy = FALSE;
+         //Set flag
+         flag = TRUE;
       }
    }
 
-   //Return TRUE if the acknowledgment is a duplicate
+   //Return TRUE if the RTT measurement is complete
    return flag;
 }
 
 
 /**
- * @brief Fast retransmit procedure
- * @param[in] socket Handle referencing the current socket
+ * @brief TCP segment retransmission
+ * @param[in] socket Handle referencing the socket
+ * @return Error code
  **/
 
-void tcpFastRetransmit(Socket *socket)
+error_t tcpRetransmitSegment(Socket *socket)
 {
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-   uint32_t flightSize;
+   error_t error;
+   size_t offset;
+   size_t length;
+   NetBuffer *buffer;
+   TcpQueueItem *queueItem;
+   TcpHeader *segment;
+   NetTxAncillary ancillary;
+
+   //Initialize error code
+   error = NO_ERROR;
+   //Total number of bytes that have been retransmitted
+   length = 0;
+
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+   //Check whether the PMTU probe is about to be retransmitted
+   tcpCheckPathMtuProbeLoss(socket);
+#endif
+
+   //Point to the retransmission queue
+   queueItem = socket->retransmitQueue;
+
+   //Any segment in the retransmission queue?
+   while(queueItem != NULL)
+   {
+      //Total number of bytes that have been retransmitted
+      length += queueItem->length;
+
+      //The amount of data that can be sent cannot exceed the MSS
+      if(length > socket->smss)
+      {
+         //We are done
+         error = NO_ERROR;
+         //Exit immediately
+         break;
+      }
+
+      //Allocate a memory buffer to hold the TCP segment
+      buffer = ipAllocBuffer(TCP_MAX_HEADER_LENGTH, &offset);
+      //Failed to allocate memory?
+      if(buffer == NULL)
+      {
+         //Report an error
+         error = ERROR_OUT_OF_MEMORY;
+         //Exit immediately
+         break;
+      }
 
-   //Amount of data that has been sent but not yet acknowledged
-   flightSize = socket->sndNxt - socket->sndUna;
-   //After receiving 3 duplicate ACKs, ssthresh must be adjusted
-   socket->ssthresh = MAX(flightSize / 2, 2 * socket->smss);
+      //Start of exception handling block
+      do
+      {
+         //Point to the beginning of the TCP segment
+         segment = netBufferAt(buffer, offset, 0);
 
-   //The value of recover is incremented to the value of the highest
-   //sequence number transmitted by the TCP so far
-   socket->recover = socket->sndNxt - 1;
+         //Copy TCP header
+         osMemcpy(segment, queueItem->header, TCP_MAX_HEADER_LENGTH);
 
-   //Debug message
-   TRACE_INFO("TCP fast retransmit...\r\n");
+         //Update ACK number
+         segment->ackNum = htonl(socket->rcvNxt);
+         //Update receive window
+         segment->window = htons(socket->rcvWnd);
+         //The checksum field is replaced with zeros
+         segment->checksum = 0;
 
-   //TCP performs a retransmission of what appears to be the missing segment,
-   //without waiting for the retransmission timer to expire
-   tcpRetransmitSegment(socket);
+         //Adjust the length of the multi-part buffer
+         netBufferSetLength(buffer, offset + segment->dataOffset * 4);
 
-   //cwnd must set to ssthresh plus 3*SMSS. This artificially inflates the
-   //congestion window by the number of segments (three) that have left the
-   //network and which the receiver has buffered
-   socket->cwnd = socket->ssthresh + TCP_FAST_RETRANSMIT_THRES * socket->smss;
+         //Copy data from send buffer
+         error = tcpReadTxBuffer(socket, ntohl(segment->seqNum), buffer,
+            queueItem->length);
+         //Any error to report?
+         if(error)
+            break;
 
-   //Enter the fast recovery procedure
-   socket->congestState = TCP_CONGEST_STATE_RECOVERY;
+#if (IPV4_SUPPORT == ENABLED)
+         //Destination address is an IPv4 address?
+         if(queueItem->pseudoHeader.length == sizeof(Ipv4PseudoHeader))
+         {
+            //Calculate TCP header checksum
+            segment->checksum = ipCalcUpperLayerChecksumEx(
+               &queueItem->pseudoHeader.ipv4Data, sizeof(Ipv4PseudoHeader),
+               buffer, offset, segment->dataOffset * 4 + queueItem->length);
+         }
+         else
 #endif
-}
-
-
-/**
- * @brief Fast recovery procedure
- * @param[in] socket Handle referencing the current socket
- * @param[in] segment Pointer to the incoming TCP segment
- * @param[in] n Number of bytes acknowledged by the incoming ACK
- **/
-
-void tcpFastRecovery(Socket *socket, const TcpHeader *segment, uint_t n)
-{
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-   //Check whether this ACK acknowledges all of the data up to and including
-   //recover
-   if(TCP_CMP_SEQ(segment->ackNum, socket->recover) > 0)
-   {
-      //This is a full acknowledgment
-      TRACE_INFO("TCP full acknowledgment\r\n");
+#if (IPV6_SUPPORT == ENABLED)
+         //Destination address is an IPv6 address?
+         if(queueItem->pseudoHeader.length == sizeof(Ipv6PseudoHeader))
+         {
+            //Calculate TCP header checksum
+            segment->checksum = ipCalcUpperLayerChecksumEx(
+               &queueItem->pseudoHeader.ipv6Data, sizeof(Ipv6PseudoHeader),
+               buffer, offset, segment->dataOffset * 4 + queueItem->length);
+         }
+         else
+#endif
+         //Destination address is not valid?
+         {
+            //This should never occur...
+            error = ERROR_INVALID_ADDRESS;
+            break;
+         }
 
-      //Set cwnd to ssthresh
-      socket->cwnd = socket->ssthresh;
-      //Exit the fast recovery procedure
-      socket->congestState = TCP_CONGEST_STATE_IDLE;
-   }
-   else
-   {
-      //If this ACK does not acknowledge all of the data up to and including
-      //recover, then this is a partial ACK
-      TRACE_INFO("TCP partial acknowledgment\r\n");
+         //Total number of segments retransmitted
+         MIB2_TCP_INC_COUNTER32(tcpRetransSegs, 1);
+         TCP_MIB_INC_COUNTER32(tcpRetransSegs, 1);
 
-      //Retransmit the first unacknowledged segment
-      tcpRetransmitSegment(socket);
+         //Dump TCP header contents for debugging purpose
+         tcpDumpHeader(segment, queueItem->length, socket->iss, socket->irs);
 
-      //Deflate the congestion window by the amount of new data acknowledged
-      //by the cumulative acknowledgment field
-      if(socket->cwnd > n)
-         socket->cwnd -= n;
+         //Additional options can be passed to the stack along with the packet
+         ancillary = NET_DEFAULT_TX_ANCILLARY;
+         //Set the TTL value to be used
+         ancillary.ttl = socket->ttl;
 
-      //If the partial ACK acknowledges at least one SMSS of new data, then
-      //add back SMSS bytes to the congestion window. This artificially
-      //inflates the congestion window in order to reflect the additional
-      //segment that has left the network
-      if(n >= socket->smss)
-         socket->cwnd += socket->smss;
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+         //Set the DF bit (refer to RFC 4821, section 5)
+         if(segment->dataOffset * 4 == sizeof(TcpHeader) ||
+            queueItem->length == 0)
+         {
+            ancillary.dontFrag = TRUE;
+         }
+#endif
 
-      //Do not exit the fast recovery procedure...
-      socket->congestState = TCP_CONGEST_STATE_RECOVERY;
-   }
+#if (ETH_VLAN_SUPPORT == ENABLED)
+         //Set VLAN PCP and DEI fields
+         ancillary.vlanPcp = socket->vlanPcp;
+         ancillary.vlanDei = socket->vlanDei;
 #endif
-}
 
+#if (ETH_VMAN_SUPPORT == ENABLED)
+         //Set VMAN PCP and DEI fields
+         ancillary.vmanPcp = socket->vmanPcp;
+         ancillary.vmanDei = socket->vmanDei;
+#endif
+         //Retransmit the lost segment without waiting for the retransmission
+         //timer to expire
+         error = ipSendDatagram(socket->interface, &queueItem->pseudoHeader,
+            buffer, offset, &ancillary);
 
-/**
- * @brief Fast loss recovery procedure
- * @param[in] socket Handle referencing the current socket
- * @param[in] segment Pointer to the incoming TCP segment
- **/
+         //End of exception handling block
+      } while(0);
 
-void tcpFastLossRecovery(Socket *socket, const TcpHeader *segment)
-{
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-   //Check whether this ACK acknowledges all of the data up to and
-   //including recover
-   if(TCP_CMP_SEQ(segment->ackNum, socket->recover) > 0)
-   {
-      //This is a full acknowledgment
-      TRACE_INFO("TCP full acknowledgment\r\n");
+      //Free previously allocated memory
+      netBufferFree(buffer);
 
-      //Exit the fast loss recovery procedure
-      socket->congestState = TCP_CONGEST_STATE_IDLE;
-   }
-   else
-   {
-      //If this ACK does not acknowledge all of the data up to and including
-      //recover, then this is a partial ACK
-      TRACE_INFO("TCP partial acknowledgment\r\n");
+      //Any error to report?
+      if(error)
+      {
+         //Exit immediately
+         break;
+      }
 
-      //Retransmit the first unacknowledged segment
-      tcpRetransmitSegment(socket);
+#if (TCP_PACING_SUPPORT == ENABLED)
+      //Retransmitted data are charged against the pacing budget, so that
+      //new data do not immediately follow in a burst
+      socket->pacingCredit -= queueItem->length;
+#endif
 
-      //Do not exit the fast loss recovery procedure...
-      socket->congestState = TCP_CONGEST_STATE_LOSS_RECOVERY;
+      //Point to the next segment in the queue
+      queueItem = queueItem->next;
    }
-#endif
+
+   //Return status code
+   return error;
 }
 
 
 /**
- * @brief Process the segment text
- * @param[in] socket Handle referencing the current socket
- * @param[in] segment Pointer to the TCP header
- * @param[in] buffer Multi-part buffer containing the incoming TCP segment
- * @param[in] offset Offset to the first data byte
- * @param[in] length Length of the segment data
+ * @brief Update the length field of a TCP pseudo header
+ * @param[in] pseudoHeader TCP pseudo header
+ * @param[in] length Length of the TCP segment (header and data)
  **/
 
-void tcpProcessSegmentData(Socket *socket, const TcpHeader *segment,
-   const NetBuffer *buffer, size_t offset, size_t length)
+void tcpSetPseudoHeaderLength(IpPseudoHeader *pseudoHeader, size_t length)
 {
-   uint32_t leftEdge;
-   uint32_t rightEdge;
-
-   //First sequence number occupied by the incoming segment
-   leftEdge = segment->seqNum;
-   //Sequence number immediately following the incoming segment
-   rightEdge = segment->seqNum + length;
-
-   //Check whether some data falls outside the receive window
-   if(TCP_CMP_SEQ(leftEdge, socket->rcvNxt) < 0)
-   {
-      //Position of the first byte to be read
-      offset += socket->rcvNxt - leftEdge;
-      //Ignore the data that falls outside the receive window
-      leftEdge = socket->rcvNxt;
-   }
-
-   if(TCP_CMP_SEQ(rightEdge, socket->rcvNxt + socket->rcvWnd) > 0)
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 pseudo header?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
    {
-      //Ignore the data that falls outside the receive window
-      rightEdge = socket->rcvNxt + socket->rcvWnd;
+      pseudoHeader->ipv4Data.length = htons(length);
    }
-
-   //Copy the incoming data to the receive buffer
-   tcpWriteRxBuffer(socket, leftEdge, buffer, offset, rightEdge - leftEdge);
-
-   //Update the list of non-contiguous blocks of data that have been received
-   //and queued
-   tcpUpdateSackBlocks(socket, &leftEdge, &rightEdge);
-
-   //Check whether the segment was received out of order
-   if(TCP_CMP_SEQ(leftEdge, socket->rcvNxt) > 0)
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 pseudo header?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
    {
-      //Out of order data segments should be acknowledged immediately, in order
-      //to accelerate loss recovery
-      tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
-         FALSE);
+      pseudoHeader->ipv6Data.length = htonl(length);
    }
    else
+#endif
+   //Invalid pseudo header?
    {
-      //Number of contiguous bytes that have been received
-      length = rightEdge - leftEdge;
-
-      //Next sequence number expected on incoming segments
-      socket->rcvNxt += length;
-      //Number of data available in the receive buffer
-      socket->rcvUser += length;
-      //Update the receive window
-      socket->rcvWnd -= length;
-
-      //Acknowledge the received data (delayed ACK not supported)
-      tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt, 0,
-         FALSE);
-
-      //Notify user task that data is available
-      tcpUpdateEvents(socket);
+      //Just for sanity
    }
 }
 
 
 /**
- * @brief Delete TCB structure
+ * @brief Nagle algorithm implementation
  * @param[in] socket Handle referencing the socket
+ * @param[in] flags Set of flags that influences the behavior of this function
+ * @return Error code
  **/
 
-void tcpDeleteControlBlock(Socket *socket)
+error_t tcpNagleAlgo(Socket *socket, uint_t flags)
 {
-   //Delete retransmission queue
-   tcpFlushRetransmitQueue(socket);
-
-   //Delete SYN queue
-   tcpFlushSynQueue(socket);
+   error_t error;
+   uint32_t n;
+   uint32_t u;
 
-   //Release transmit buffer
-   netBufferSetLength((NetBuffer *) &socket->txBuffer, 0);
+   //Initialize status code
+   error = NO_ERROR;
 
-   //Release receive buffer
-   netBufferSetLength((NetBuffer *) &socket->rxBuffer, 0);
-}
+#if (TCP_PACING_SUPPORT == ENABLED)
+   //Derive the pacing rate from the current window and SRTT
+   tcpUpdatePacingRate(socket);
 
+   //Segments held back by pacing are released with the flags they were
+   //queued with, whatever the event that triggered this call
+   if(socket->pacingPending)
+   {
+      flags |= socket->pacingFlags;
+   }
+#endif
 
-/**
- * @brief Remove acknowledged segments from retransmission queue
- * @param[in] socket Handle referencing the socket
- **/
+   //The amount of data that can be sent at any given time is limited by the
+   //receiver window and the congestion window
+   n = MIN(socket->sndWnd, socket->txBufferSize);
 
-void tcpUpdateRetransmitQueue(Socket *socket)
-{
-   size_t length;
-   TcpQueueItem *prevQueueItem;
-   TcpQueueItem *queueItem;
-   TcpHeader *header;
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   //Check the congestion window
+   n = MIN(n, socket->cwnd);
+#endif
 
-   //Point to the first item of the retransmission queue
-   prevQueueItem = NULL;
-   queueItem = socket->retransmitQueue;
+   //Retrieve the size of the usable window
+   u = n - (socket->sndNxt - socket->sndUna);
 
-   //Loop through retransmission queue
-   while(queueItem != NULL)
+   //The Nagle algorithm discourages sending tiny segments when the data to be
+   //sent increases in small increments
+   while(socket->sndUser > 0 && !error)
    {
-      //Point to the TCP header
-      header = (TcpHeader *) queueItem->header;
+      //The usable window size may become zero or negative, preventing packet
+      //transmission
+      if((int32_t) u <= 0)
+         break;
 
-      //Calculate the length of the TCP segment
-      if(header->flags & TCP_FLAG_SYN)
+      //Calculate the number of bytes to send at a time
+      n = MIN(u, socket->sndUser);
+      n = MIN(n, socket->smss);
+
+#if (TCP_PACING_SUPPORT == ENABLED)
+      //Spread the segments over the SRTT rather than sending the whole
+      //window back-to-back
+      if(!tcpCheckPacing(socket, flags))
+         break;
+#endif
+
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+      //Send a full-sized probe when the search for a larger PMTU is due
+      if(tcpCheckPathMtuProbe(socket, u))
       {
-         length = 1;
+         n = socket->pmtuProbeSize;
       }
-      else if(header->flags & TCP_FLAG_FIN)
+#endif
+
+      //Disable Nagle algorithm?
+      if((flags & SOCKET_FLAG_NO_DELAY) != 0)
       {
-         length = queueItem->length + 1;
+         //All packets will be send no matter what size they have
+         if(n > 0)
+         {
+            //Send TCP segment
+            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
+               socket->sndNxt, socket->rcvNxt, n, TRUE);
+         }
+         else
+         {
+            //We are done
+            break;
+         }
       }
-      else
+      else if((flags & SOCKET_FLAG_DELAY) != 0)
       {
-         length = queueItem->length;
+         //Transmit data if a maximum-sized segment can be sent
+         if(MIN(socket->sndUser, u) >= socket->smss)
+         {
+            //Send TCP segment
+            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
+               socket->sndNxt, socket->rcvNxt, n, TRUE);
+         }
+         else
+         {
+            //Prevent the sender from sending tiny segments
+            break;
+         }
       }
-
-      //If an acknowledgment is received for a segment before its timer
-      //expires, the segment is removed from the retransmission queue
-      if(TCP_CMP_SEQ(socket->sndUna, ntohl(header->seqNum) + length) >= 0)
+      else
       {
-         //First item of the queue?
-         if(prevQueueItem == NULL)
+         //Transmit data if a maximum-sized segment can be sent
+         if(MIN(socket->sndUser, u) >= socket->smss)
          {
-            //Remove the current item from the queue
-            socket->retransmitQueue = queueItem->next;
-            //The item can now be safely deleted
-            memPoolFree(queueItem);
-            //Point to the next item
-            queueItem = socket->retransmitQueue;
+            //Send TCP segment
+            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
+               socket->sndNxt, socket->rcvNxt, n, TRUE);
+         }
+         //Or if all queued data can be sent now
+         else if(socket->sndNxt == socket->sndUna && socket->sndUser <= u)
+         {
+            //Send TCP segment
+            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
+               socket->sndNxt, socket->rcvNxt, n, TRUE);
+         }
+         //Or if at least a fraction of the maximum window can be sent
+         else if(MIN(socket->sndUser, u) >= (socket->maxSndWnd / 2))
+         {
+            //Send TCP segment
+            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
+               socket->sndNxt, socket->rcvNxt, n, TRUE);
          }
          else
          {
-            //Remove the current item from the queue
-            prevQueueItem->next = queueItem->next;
-            //The item can now be safely deleted
-            memPoolFree(queueItem);
-            //Point to the next item
-            queueItem = prevQueueItem->next;
+            //Prevent the sender from sending tiny segments
+            break;
          }
+      }
 
-         //When an ACK is received that acknowledges new data, restart the
-         //retransmission timer so that it will expire after RTO seconds
-         netStartTimer(&socket->retransmitTimer, socket->rto);
-         //Reset retransmission counter
-         socket->retransmitCount = 0;
+      //Check status code
+      if(!error)
+      {
+         //Advance SND.NXT pointer
+         socket->sndNxt += n;
+         //Update the number of data buffered but not yet sent
+         socket->sndUser -= n;
+         //Update the size of the usable window
+         u -= n;
+
+#if (TCP_PACING_SUPPORT == ENABLED)
+         //Consume pacing credit
+         socket->pacingCredit -= n;
+#endif
       }
-      //No acknowledgment received for the current segment...
-      else
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+      else if(socket->pmtuProbeSize != 0 &&
+         socket->pmtuProbeSeqNum == socket->sndNxt)
       {
-         //Point to the next item
-         prevQueueItem = queueItem;
-         queueItem = queueItem->next;
+         //The probe could not be sent
+         socket->pmtuProbeSize = 0;
       }
+#endif
    }
 
-   //When all outstanding data has been acknowledged,
-   //turn off the retransmission timer
-   if(socket->retransmitQueue == NULL)
-      netStopTimer(&socket->retransmitTimer);
-}
-
-
-/**
- * @brief Flush retransmission queue
- * @param[in] socket Handle referencing the socket
- **/
-
-void tcpFlushRetransmitQueue(Socket *socket)
-{
-   //Point to the first item in the retransmission queue
-   TcpQueueItem *queueItem = socket->retransmitQueue;
-
-   //Loop through retransmission queue
-   while(queueItem != NULL)
+#if (TCP_PACING_SUPPORT == ENABLED)
+   //The held segments have been sent once no data is left in the send buffer
+   if(socket->sndUser == 0)
    {
-      //Keep track of the next item in the queue
-      TcpQueueItem *nextQueueItem = queueItem->next;
-      //Free previously allocated memory
-      memPoolFree(queueItem);
-      //Point to the next item
-      queueItem = nextQueueItem;
+      socket->pacingPending = FALSE;
    }
+#endif
 
-   //The retransmission queue is now flushed
-   socket->retransmitQueue = NULL;
+   //Check whether the transmitter can accept more data
+   tcpUpdateEvents(socket);
 
-   //Turn off the retransmission timer
-   netStopTimer(&socket->retransmitTimer);
+   //Return status code
+   return error;
 }
 
 
-/**
- * @brief Flush SYN queue
- * @param[in] socket Handle referencing the socket
- **/
-
-void tcpFlushSynQueue(Socket *socket)
-{
-   //Point to the first item in the SYN queue
-   TcpSynQueueItem *queueItem = socket->synQueue;
-
-   //Loop through SYN queue
-   while(queueItem != NULL)
-   {
-      //Keep track of the next item in the queue
-      TcpSynQueueItem *nextQueueItem = queueItem->next;
-      //Free previously allocated memory
-      memPoolFree(queueItem);
-      //Point to the next item
-      queueItem = nextQueueItem;
-   }
-
-   //SYN queue was successfully flushed
-   socket->synQueue = NULL;
-}
-
+#if (TCP_PACING_SUPPORT == ENABLED)
 
 /**
- * @brief Update the list of non-contiguous blocks that have been received
+ * @brief Update the pacing rate of a connection
+ *
+ * The pacing rate is derived from the amount of data that can be in flight
+ * and the smoothed round-trip time, so that a full window is spread over
+ * one SRTT
+ *
  * @param[in] socket Handle referencing the socket
- * @param[in,out] leftEdge First sequence number occupied by the incoming data
- * @param[in,out] rightEdge Sequence number immediately following the incoming data
  **/
 
-void tcpUpdateSackBlocks(Socket *socket, uint32_t *leftEdge, uint32_t *rightEdge)
+void tcpUpdatePacingRate(Socket *socket)
 {
-   uint_t i = 0;
+   uint32_t n;
+   uint_t gain;
+   uint64_t rate;
 
-   //Loop through the blocks
-   while(i < socket->sackBlockCount)
+   //No RTT measurement has been made yet?
+   if(socket->srtt == 0)
    {
-      //Find each block that overlaps the specified one
-      if(TCP_CMP_SEQ(*rightEdge, socket->sackBlock[i].leftEdge) >= 0 &&
-         TCP_CMP_SEQ(*leftEdge, socket->sackBlock[i].rightEdge) <= 0)
-      {
-         //Merge blocks to form a contiguous one
-         *leftEdge = MIN(*leftEdge, socket->sackBlock[i].leftEdge);
-         *rightEdge = MAX(*rightEdge, socket->sackBlock[i].rightEdge);
+      //Pacing is not applied until an RTT sample is available
+      socket->pacingRate = 0;
+      return;
+   }
 
-         //Delete current block
-         osMemmove(socket->sackBlock + i, socket->sackBlock + i + 1,
-            (TCP_MAX_SACK_BLOCKS - i - 1) * sizeof(TcpSackBlock));
+   //The amount of data that can be sent at any given time is limited by the
+   //receiver window and the congestion window
+   n = MIN(socket->sndWnd, socket->txBufferSize);
 
-         //Decrement the number of non-contiguous blocks
-         socket->sackBlockCount--;
-      }
-      else
-      {
-         //Point to the next block
-         i++;
-      }
-   }
+#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
+   //Check the congestion window
+   n = MIN(n, socket->cwnd);
 
-   //Check whether the incoming segment was received out of order
-   if(TCP_CMP_SEQ(*leftEdge, socket->rcvNxt) > 0)
-   {
-      //Make room for the new non-contiguous block
-      osMemmove(socket->sackBlock + 1, socket->sackBlock,
-         (TCP_MAX_SACK_BLOCKS - 1) * sizeof(TcpSackBlock));
+   //A higher gain during slow start allows the window to keep growing
+   gain = (socket->cwnd < socket->ssthresh) ? TCP_PACING_SS_GAIN :
+      TCP_PACING_CA_GAIN;
+#else
+   //The window does not grow
+   gain = TCP_PACING_CA_GAIN;
+#endif
 
-      //Insert the element in the list
-      socket->sackBlock[0].leftEdge = *leftEdge;
-      socket->sackBlock[0].rightEdge = *rightEdge;
+   //Send at least one segment per SRTT
+   n = MAX(n, socket->smss);
 
-      //Increment the number of non-contiguous blocks
-      if(socket->sackBlockCount < TCP_MAX_SACK_BLOCKS)
-      {
-         socket->sackBlockCount++;
-      }
-   }
+   //Compute the pacing rate, in bytes per second
+   rate = (uint64_t) n * gain * 10 / socket->srtt;
+   rate = MIN(rate, UINT32_MAX);
+
+   //Save the pacing rate
+   socket->pacingRate = (uint32_t) rate;
+
+   //Update statistics
+   socket->stats.pacingRate = socket->pacingRate;
+   socket->stats.maxPacingRate = MAX(socket->stats.maxPacingRate,
+      socket->pacingRate);
 }
 
 
 /**
- * @brief Update send window
+ * @brief Check whether a segment can be sent without violating the pacing rate
  * @param[in] socket Handle referencing the socket
- * @param[in] segment Pointer to the incoming TCP segment
+ * @param[in] flags Set of flags to be used when the held segments are released
+ * @return TRUE if the segment can be sent now, else FALSE
  **/
 
-void tcpUpdateSendWindow(Socket *socket, const TcpHeader *segment)
+bool_t tcpCheckPacing(Socket *socket, uint_t flags)
 {
-   //Case where neither the sequence nor the acknowledgment number is increased
-   if(segment->seqNum == socket->sndWl1 && segment->ackNum == socket->sndWl2)
-   {
-      //TCP may ignore a window update with a smaller window than previously
-      //offered if neither the sequence number nor the acknowledgment number
-      //is increased (refer to RFC 1122, section 4.2.2.16)
-      if(segment->window > socket->sndWnd)
-      {
-         //Update the send window and record the sequence number and the
-         //acknowledgment number used to update SND.WND
-         socket->sndWnd = segment->window;
-         socket->sndWl1 = segment->seqNum;
-         socket->sndWl2 = segment->ackNum;
+   systime_t time;
+   systime_t delta;
+   int32_t n;
+   int32_t maxBurst;
 
-         //Maximum send window it has seen so far on the connection
-         socket->maxSndWnd = MAX(socket->maxSndWnd, segment->window);
-      }
-   }
-   //Case where the sequence or the acknowledgment number is increased
-   else if(TCP_CMP_SEQ(segment->seqNum, socket->sndWl1) >= 0 &&
-      TCP_CMP_SEQ(segment->ackNum, socket->sndWl2) >= 0)
+   //Pacing is not applied until an RTT sample is available
+   if(socket->pacingRate == 0)
+      return TRUE;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Time elapsed since the last credit update
+   delta = time - socket->pacingTimestamp;
+   delta = MIN(delta, 1000);
+
+   //Number of bytes that can be sent during this interval
+   n = (int32_t) (((uint64_t) socket->pacingRate * delta) / 1000);
+
+   //The remainder is carried over to the next update when the interval is
+   //too short to earn a single byte
+   if(n > 0 || delta >= 1000)
    {
-      //Check whether the remote host advertises a zero window
-      if(segment->window == 0 && socket->sndWnd != 0)
-      {
-         //Start the persist timer
-         socket->wndProbeCount = 0;
-         socket->wndProbeInterval = TCP_DEFAULT_PROBE_INTERVAL;
-         netStartTimer(&socket->persistTimer, socket->wndProbeInterval);
-      }
+      socket->pacingCredit += n;
+      socket->pacingTimestamp = time;
+   }
 
-      //Update the send window and record the sequence number and the
-      //acknowledgment number used to update SND.WND
-      socket->sndWnd = segment->window;
-      socket->sndWl1 = segment->seqNum;
-      socket->sndWl2 = segment->ackNum;
+   //Limit the size of the bursts that may follow an idle period
+   maxBurst = (int32_t) (((uint64_t) socket->pacingRate *
+      TCP_PACING_TICK_INTERVAL) / 1000);
+   maxBurst = MAX(maxBurst, TCP_PACING_MAX_BURST * (int32_t) socket->smss);
 
-      //Maximum send window it has seen so far on the connection
-      socket->maxSndWnd = MAX(socket->maxSndWnd, segment->window);
+   //Saturate the credit
+   socket->pacingCredit = MIN(socket->pacingCredit, maxBurst);
+
+   //Any credit left?
+   if(socket->pacingCredit > 0)
+      return TRUE;
+
+   //The segment will be sent by the pacing timer
+   socket->pacingPending = TRUE;
+   socket->pacingFlags = flags;
+
+   //Number of times a segment has been held back by pacing
+   socket->stats.pacedSegs++;
+
+   //Make sure the TCP/IP stack wakes up in time to release the segment
+   if(!tcpPacingPending)
+   {
+      tcpPacingPending = TRUE;
+      osSetEvent(&netEvent);
    }
+
+   //The segment must be delayed
+   return FALSE;
 }
 
+#endif
+
+
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
 
 /**
- * @brief Update receive window so as to avoid Silly Window Syndrome
+ * @brief Get the largest MSS allowed by the PMTU of the connection
  * @param[in] socket Handle referencing the socket
+ * @return MSS value derived from the current PMTU estimate
  **/
 
-void tcpUpdateReceiveWindow(Socket *socket)
+size_t tcpGetPathMss(Socket *socket)
 {
-   uint16_t reduction;
+   size_t pathMtu;
+   size_t overhead;
 
-   //Space available but not yet advertised
-   reduction = socket->rxBufferSize - socket->rcvUser - socket->rcvWnd;
+   //The connection is not bound to any interface?
+   if(socket->interface == NULL)
+      return socket->smss;
 
-   //To avoid SWS, the receiver should not advertise small windows
-   if((socket->rcvWnd + reduction) >= MIN(socket->rmss, socket->rxBufferSize / 2))
+   //Retrieve the PMTU for the remote host
+   pathMtu = ipGetPathMtu(socket->interface, &socket->remoteIpAddr);
+
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 connection?
+   if(socket->remoteIpAddr.length == sizeof(Ipv6Addr))
    {
-      //Check whether a window update should be sent
-      if(socket->rcvWnd < MIN(socket->rmss, socket->rxBufferSize / 2))
-      {
-         //Debug message
-         TRACE_INFO("%s: TCP sending window update...\r\n",
-            formatSystemTime(osGetSystemTime(), NULL));
+      overhead = sizeof(Ipv6Header) + sizeof(TcpHeader);
+   }
+   else
+#endif
+   //IPv4 connection?
+   {
+      overhead = sizeof(Ipv4Header) + sizeof(TcpHeader);
+   }
 
-         //Update the receive window
-         socket->rcvWnd += reduction;
+   //Make sure the PMTU is consistent
+   if(pathMtu < (overhead + TCP_MIN_MSS))
+      return TCP_MIN_MSS;
 
-         //Send an ACK segment to advertise the new window size
-         tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt,
-            0, FALSE);
-      }
-      else
-      {
-         //The receive window can be updated
-         socket->rcvWnd += reduction;
-      }
-   }
+   //Return the corresponding MSS
+   return pathMtu - overhead;
 }
 
 
 /**
- * @brief Compute retransmission timeout
+ * @brief Initialize PMTU discovery once the connection is established
+ *
+ * The connection starts with the MSS negotiated with the peer, bounded by
+ * the PMTU estimate of the IP layer. Larger segments are not probed since
+ * the peer would not accept them
+ *
  * @param[in] socket Handle referencing the socket
- * @return TRUE if the RTT measurement is complete, else FALSE
  **/
 
-bool_t tcpComputeRto(Socket *socket)
+void tcpInitPathMtu(Socket *socket)
 {
-   bool_t flag;
-   systime_t r;
-   systime_t delta;
+   //The MSS cannot exceed the PMTU
+   socket->smss = MIN(socket->smss, tcpGetPathMss(socket));
 
-   //Clear flag
-   flag = FALSE;
+   //Upper bound of the search
+   socket->pmtuMaxMss = socket->smss;
+   socket->pmtuSearchHigh = socket->smss;
 
-   //TCP implementation takes one RTT measurement at a time
-   if(socket->rttBusy)
-   {
-      //Ensure the incoming ACK number covers the expected sequence number
-      if(TCP_CMP_SEQ(socket->sndUna, socket->rttSeqNum) > 0)
-      {
-         //Calculate round-time trip
-         r = osGetSystemTime() - socket->rttStartTime;
+   //No probe is outstanding
+   socket->pmtuProbeSize = 0;
+   socket->pmtuProbeSeqNum = 0;
+   socket->pmtuProbeTimestamp = osGetSystemTime() + TCP_PLPMTUD_PROBE_INTERVAL;
+}
 
-         //First RTT measurement?
-         if(socket->srtt == 0 && socket->rttvar == 0)
-         {
-            //Initialize RTO calculation algorithm
-            socket->srtt = r;
-            socket->rttvar = r / 2;
-         }
-         else
-         {
-            //Calculate the difference between the measured value and the
-            //current RTT estimator
-            delta = (r > socket->srtt) ? (r - socket->srtt) : (socket->srtt - r);
 
-            //Implement Van Jacobson's algorithm (as specified in RFC 6298 2.3)
-            socket->rttvar = (3 * socket->rttvar + delta) / 4;
-            socket->srtt = (7 * socket->srtt + r) / 8;
-         }
+/**
+ * @brief Check whether the next segment should be sent as a PMTU probe
+ * @param[in] socket Handle referencing the socket
+ * @param[in] u Size of the usable window
+ * @return TRUE if a probe of pmtuProbeSize bytes must be sent, else FALSE
+ **/
 
-         //Calculate the next retransmission timeout
-         socket->rto = socket->srtt + 4 * socket->rttvar;
+bool_t tcpCheckPathMtuProbe(Socket *socket, uint32_t u)
+{
+   size_t size;
+   systime_t time;
 
-         //Whenever RTO is computed, if it is less than 1 second, then the RTO
-         //should be rounded up to 1 second
-         socket->rto = MAX(socket->rto, TCP_MIN_RTO);
+   //Probes are only sent once the connection is established
+   if(socket->state != TCP_STATE_ESTABLISHED)
+      return FALSE;
 
-         //A maximum value may be placed on RTO provided it is at least 60
-         //seconds
-         socket->rto = MIN(socket->rto, TCP_MAX_RTO);
+   //Only one probe can be outstanding at a time
+   if(socket->pmtuProbeSize != 0)
+      return FALSE;
 
-         //Debug message
-         TRACE_DEBUG("R=%" PRIu32 ", SRTT=%" PRIu32 ", RTTVAR=%" PRIu32 ", RTO=%" PRIu32 "\r\n",
-            r, socket->srtt, socket->rttvar, socket->rto);
+   //Do not probe while recovering from a loss
+   if(socket->retransmitCount != 0)
+      return FALSE;
 
-         //RTT measurement is complete
-         socket->rttBusy = FALSE;
-         //Set flag
-         flag = TRUE;
+   //Get current time
+   time = osGetSystemTime();
+
+   //Wait for the probe timer to expire
+   if(timeCompare(time, socket->pmtuProbeTimestamp) < 0)
+      return FALSE;
+
+   //The search has converged?
+   if(socket->pmtuSearchHigh < (socket->smss + TCP_PLPMTUD_SEARCH_THRESHOLD))
+   {
+      //The PMTU may have increased since the last search (refer to RFC 4821,
+      //section 7.7)
+      socket->pmtuSearchHigh = MIN(socket->pmtuMaxMss, tcpGetPathMss(socket));
+
+      //Nothing to probe?
+      if(socket->pmtuSearchHigh < (socket->smss + TCP_PLPMTUD_SEARCH_THRESHOLD))
+      {
+         //Check again later
+         socket->pmtuProbeTimestamp = time + TCP_PLPMTUD_PROBE_INTERVAL;
+         return FALSE;
       }
    }
 
-   //Return TRUE if the RTT measurement is complete
-   return flag;
+   //Binary search between the current MSS and the largest candidate that
+   //has not failed
+   size = (socket->smss + socket->pmtuSearchHigh + 1) / 2;
+
+   //A probe must be made of application data that are available and fit in
+   //the usable window (refer to RFC 4821, section 7.4)
+   if(socket->sndUser < size || u < size)
+      return FALSE;
+
+   //Debug message
+   TRACE_INFO("Sending TCP PMTU probe (MSS = %" PRIuSIZE ")...\r\n", size);
+
+   //Save the probe parameters
+   socket->pmtuProbeSize = size;
+   socket->pmtuProbeSeqNum = socket->sndNxt;
+
+   //Number of PMTU probes sent
+   socket->stats.pmtuProbes++;
+
+   //The next segment is a probe
+   return TRUE;
 }
 
 
 /**
- * @brief TCP segment retransmission
+ * @brief Handle the loss of a PMTU probe
+ *
+ * This function is called before the retransmission queue is resent. A
+ * probe that has to be retransmitted is considered as lost and is split
+ * into segments of the current MSS
+ *
  * @param[in] socket Handle referencing the socket
- * @return Error code
  **/
 
-error_t tcpRetransmitSegment(Socket *socket)
+void tcpCheckPathMtuProbeLoss(Socket *socket)
 {
-   error_t error;
-   size_t offset;
-   size_t length;
-   NetBuffer *buffer;
    TcpQueueItem *queueItem;
-   TcpHeader *segment;
-   NetTxAncillary ancillary;
-
-   //Initialize error code
-   error = NO_ERROR;
-   //Total number of bytes that have been retransmitted
-   length = 0;
-
-   //Point to the retransmission queue
-   queueItem = socket->retransmitQueue;
+   TcpHeader *header;
 
-   //Any segment in the retransmission queue?
-   while(queueItem != NULL)
+   //Outstanding PMTU probe?
+   if(socket->pmtuProbeSize != 0)
    {
-      //Total number of bytes that have been retransmitted
-      length += queueItem->length;
-
-      //The amount of data that can be sent cannot exceed the MSS
-      if(length > socket->smss)
-      {
-         //We are done
-         error = NO_ERROR;
-         //Exit immediately
-         break;
-      }
-
-      //Allocate a memory buffer to hold the TCP segment
-      buffer = ipAllocBuffer(TCP_MAX_HEADER_LENGTH, &offset);
-      //Failed to allocate memory?
-      if(buffer == NULL)
-      {
-         //Report an error
-         error = ERROR_OUT_OF_MEMORY;
-         //Exit immediately
-         break;
-      }
+      //Point to the first item of the retransmission queue
+      queueItem = socket->retransmitQueue;
 
-      //Start of exception handling block
-      do
+      //Check whether the probe is being retransmitted
+      if(queueItem != NULL && !queueItem->sacked)
       {
-         //Point to the beginning of the TCP segment
-         segment = netBufferAt(buffer, offset, 0);
-
-         //Copy TCP header
-         osMemcpy(segment, queueItem->header, TCP_MAX_HEADER_LENGTH);
-
-         //Update ACK number
-         segment->ackNum = htonl(socket->rcvNxt);
-         //Update receive window
-         segment->window = htons(socket->rcvWnd);
-         //The checksum field is replaced with zeros
-         segment->checksum = 0;
-
-         //Adjust the length of the multi-part buffer
-         netBufferSetLength(buffer, offset + segment->dataOffset * 4);
-
-         //Copy data from send buffer
-         error = tcpReadTxBuffer(socket, ntohl(segment->seqNum), buffer,
-            queueItem->length);
-         //Any error to report?
-         if(error)
-            break;
+         //Point to the TCP header
+         header = (TcpHeader *) queueItem->header;
 
-#if (IPV4_SUPPORT == ENABLED)
-         //Destination address is an IPv4 address?
-         if(queueItem->pseudoHeader.length == sizeof(Ipv4PseudoHeader))
-         {
-            //Calculate TCP header checksum
-            segment->checksum = ipCalcUpperLayerChecksumEx(
-               &queueItem->pseudoHeader.ipv4Data, sizeof(Ipv4PseudoHeader),
-               buffer, offset, segment->dataOffset * 4 + queueItem->length);
-         }
-         else
-#endif
-#if (IPV6_SUPPORT == ENABLED)
-         //Destination address is an IPv6 address?
-         if(queueItem->pseudoHeader.length == sizeof(Ipv6PseudoHeader))
-         {
-            //Calculate TCP header checksum
-            segment->checksum = ipCalcUpperLayerChecksumEx(
-               &queueItem->pseudoHeader.ipv6Data, sizeof(Ipv6PseudoHeader),
-               buffer, offset, segment->dataOffset * 4 + queueItem->length);
-         }
-         else
-#endif
-         //Destination address is not valid?
-         {
-            //This should never occur...
-            error = ERROR_INVALID_ADDRESS;
-            break;
+         //Compare sequence numbers
+         if(ntohl(header->seqNum) == socket->pmtuProbeSeqNum)
+         {
+            //Debug message
+            TRACE_INFO("TCP PMTU probe lost (MSS = %" PRIuSIZE ")\r\n",
+               socket->pmtuProbeSize);
+
+            //Larger probe sizes are no longer considered
+            socket->pmtuSearchHigh = socket->pmtuProbeSize - 1;
+            socket->pmtuProbeSize = 0;
+            socket->pmtuProbeTimestamp = osGetSystemTime();
+
+            //Number of PMTU probes that have been lost
+            socket->stats.pmtuProbesFailed++;
+
+            //The data carried by the probe are resent using the current MSS
+            tcpSplitRetransmitQueue(socket);
          }
+      }
+   }
+}
 
-         //Total number of segments retransmitted
-         MIB2_TCP_INC_COUNTER32(tcpRetransSegs, 1);
-         TCP_MIB_INC_COUNTER32(tcpRetransSegs, 1);
 
-         //Dump TCP header contents for debugging purpose
-         tcpDumpHeader(segment, queueItem->length, socket->iss, socket->irs);
+/**
+ * @brief Detect PMTU black holes
+ *
+ * Repeated timeouts of full-sized segments may indicate that ICMP messages
+ * are filtered somewhere along the path. In that case, the MSS falls back to
+ * a conservative value and the search starts over
+ *
+ * @param[in] socket Handle referencing the socket
+ **/
 
-         //Additional options can be passed to the stack along with the packet
-         ancillary = NET_DEFAULT_TX_ANCILLARY;
-         //Set the TTL value to be used
-         ancillary.ttl = socket->ttl;
+void tcpCheckPathMtuBlackHole(Socket *socket)
+{
+   //Check the number of retransmissions
+   if(socket->retransmitCount == TCP_PLPMTUD_BLACK_HOLE_RETRIES &&
+      socket->smss > TCP_PLPMTUD_BASE_MSS)
+   {
+      //Debug message
+      TRACE_WARNING("TCP PMTU black hole detected (MSS = %" PRIu16 ")\r\n",
+         socket->smss);
 
-#if (ETH_VLAN_SUPPORT == ENABLED)
-         //Set VLAN PCP and DEI fields
-         ancillary.vlanPcp = socket->vlanPcp;
-         ancillary.vlanDei = socket->vlanDei;
-#endif
+      //Fall back to the base MSS
+      socket->smss = TCP_PLPMTUD_BASE_MSS;
+      socket->pmtuSearchHigh = TCP_PLPMTUD_BASE_MSS;
+      socket->pmtuProbeSize = 0;
+      socket->pmtuProbeTimestamp = osGetSystemTime();
 
-#if (ETH_VMAN_SUPPORT == ENABLED)
-         //Set VMAN PCP and DEI fields
-         ancillary.vmanPcp = socket->vmanPcp;
-         ancillary.vmanDei = socket->vmanDei;
-#endif
-         //Retransmit the lost segment without waiting for the retransmission
-         //timer to expire
-         error = ipSendDatagram(socket->interface, &queueItem->pseudoHeader,
-            buffer, offset, &ancillary);
+      //Number of times a PMTU black hole has been detected
+      socket->stats.pmtuBlackHoles++;
 
-         //End of exception handling block
-      } while(0);
+      //Outstanding segments are resent using the base MSS
+      tcpSplitRetransmitQueue(socket);
+   }
+}
 
-      //Free previously allocated memory
-      netBufferFree(buffer);
 
-      //Any error to report?
-      if(error)
+/**
+ * @brief Process a PMTU update reported by the IP layer
+ *
+ * The ICMP error quotes the header of the invoking segment. The update is
+ * applied to the connection matching its 4-tuple, and only if the quoted
+ * sequence number lies within SND.UNA and SND.NXT (refer to RFC 5927,
+ * section 4.1)
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] localIpAddr Source IP address of the invoking segment
+ * @param[in] remoteIpAddr Destination IP address of the invoking segment
+ * @param[in] segment Quoted TCP header (only the ports and the sequence
+ *   number are used)
+ * @param[in] pathMtu New PMTU value
+ **/
+
+void tcpUpdatePathMtu(NetInterface *interface, const IpAddr *localIpAddr,
+   const IpAddr *remoteIpAddr, const TcpHeader *segment, size_t pathMtu)
+{
+   uint_t i;
+   bool_t lost;
+   size_t mss;
+   size_t overhead;
+   uint32_t seqNum;
+   Socket *socket;
+
+   //Loop through opened sockets
+   for(i = 0; i < SOCKET_MAX_COUNT; i++)
+   {
+      //Point to the current socket
+      socket = &socketTable[i];
+
+      //TCP socket?
+      if(socket->type != SOCKET_TYPE_STREAM)
+         continue;
+
+      //Check current TCP state
+      if(socket->state == TCP_STATE_CLOSED || socket->state == TCP_STATE_LISTEN)
+         continue;
+
+      //The invoking segment was sent from the local end of the connection
+      if(socket->interface == interface &&
+         socket->localPort == ntohs(segment->srcPort) &&
+         socket->remotePort == ntohs(segment->destPort) &&
+         ipCompAddr(&socket->localIpAddr, localIpAddr) &&
+         ipCompAddr(&socket->remoteIpAddr, remoteIpAddr))
       {
-         //Exit immediately
          break;
       }
+   }
 
-      //Point to the next segment in the queue
-      queueItem = queueItem->next;
+   //No matching connection?
+   if(i >= SOCKET_MAX_COUNT)
+      return;
+
+   //Retrieve the sequence number of the invoking segment
+   seqNum = ntohl(segment->seqNum);
+
+   //The ICMP error must refer to data that have been sent but not yet
+   //acknowledged. Otherwise the message is discarded as a likely forgery
+   if(TCP_CMP_SEQ(seqNum, socket->sndUna) < 0 ||
+      TCP_CMP_SEQ(seqNum, socket->sndNxt) >= 0)
+   {
+      //Debug message
+      TRACE_WARNING("ICMP error with out-of-window sequence number ignored\r\n");
+      return;
    }
 
-   //Return status code
-   return error;
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 destination?
+   if(remoteIpAddr->length == sizeof(Ipv6Addr))
+   {
+      overhead = sizeof(Ipv6Header) + sizeof(TcpHeader);
+   }
+   else
+#endif
+   //IPv4 destination?
+   {
+      overhead = sizeof(Ipv4Header) + sizeof(TcpHeader);
+   }
+
+   //Compute the corresponding MSS
+   if(pathMtu >= (overhead + TCP_MIN_MSS))
+   {
+      mss = pathMtu - overhead;
+   }
+   else
+   {
+      mss = TCP_MIN_MSS;
+   }
+
+   //Clear flag
+   lost = FALSE;
+
+   //An outstanding probe larger than the new PMTU has been dropped
+   if(socket->pmtuProbeSize > mss)
+   {
+      socket->pmtuProbeSize = 0;
+      socket->stats.pmtuProbesFailed++;
+      lost = TRUE;
+   }
+
+   //Larger MSS values are no longer considered
+   socket->pmtuSearchHigh = MIN(socket->pmtuSearchHigh, mss);
+
+   //The MSS must be reduced?
+   if(socket->smss > mss)
+   {
+      //Debug message
+      TRACE_INFO("TCP MSS reduced to %" PRIuSIZE " bytes\r\n", mss);
+
+      //Update the MSS
+      socket->smss = mss;
+      lost = TRUE;
+   }
+
+   //Outstanding segments are resent immediately using the new MSS
+   //(refer to RFC 1191, section 6.5)
+   if(lost && socket->retransmitQueue != NULL)
+   {
+      tcpSplitRetransmitQueue(socket);
+      tcpRetransmitSegment(socket);
+   }
 }
 
 
 /**
- * @brief Nagle algorithm implementation
+ * @brief Split the segments of the retransmission queue that exceed the MSS
  * @param[in] socket Handle referencing the socket
- * @param[in] flags Set of flags that influences the behavior of this function
- * @return Error code
  **/
 
-error_t tcpNagleAlgo(Socket *socket, uint_t flags)
+void tcpSplitRetransmitQueue(Socket *socket)
 {
-   error_t error;
-   uint32_t n;
-   uint32_t u;
+   uint32_t seqNum;
+   TcpQueueItem *queueItem;
+   TcpQueueItem *newQueueItem;
+   TcpHeader *header;
 
-   //Initialize status code
-   error = NO_ERROR;
+   //Point to the first item of the retransmission queue
+   queueItem = socket->retransmitQueue;
 
-   //The amount of data that can be sent at any given time is limited by the
-   //receiver window and the congestion window
-   n = MIN(socket->sndWnd, socket->txBufferSize);
+   //Loop through retransmission queue
+   while(queueItem != NULL)
+   {
+      //Point to the TCP header
+      header = (TcpHeader *) queueItem->header;
 
-#if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
-   //Check the congestion window
-   n = MIN(n, socket->cwnd);
-#endif
+      //Segments that exceed the MSS must be split
+      if((header->flags & TCP_FLAG_SYN) == 0 &&
+         queueItem->length > socket->smss)
+      {
+         //Allocate a new item for the remaining data
+         newQueueItem = memPoolAlloc(sizeof(TcpQueueItem));
+         //Failed to allocate memory?
+         if(newQueueItem == NULL)
+            break;
 
-   //Retrieve the size of the usable window
-   u = n - (socket->sndNxt - socket->sndUna);
+         //The new item inherits the header of the original segment
+         osMemcpy(newQueueItem, queueItem, sizeof(TcpQueueItem));
+         newQueueItem->length = queueItem->length - socket->smss;
 
-   //The Nagle algorithm discourages sending tiny segments when the data to be
-   //sent increases in small increments
-   while(socket->sndUser > 0 && !error)
-   {
-      //The usable window size may become zero or negative, preventing packet
-      //transmission
-      if((int32_t) u <= 0)
-         break;
+         //Adjust the sequence number of the new segment
+         seqNum = ntohl(header->seqNum) + socket->smss;
+         header = (TcpHeader *) newQueueItem->header;
+         header->seqNum = htonl(seqNum);
 
-      //Calculate the number of bytes to send at a time
-      n = MIN(u, socket->sndUser);
-      n = MIN(n, socket->smss);
+         //Update the pseudo header
+         tcpSetPseudoHeaderLength(&newQueueItem->pseudoHeader,
+            header->dataOffset * 4 + newQueueItem->length);
 
-      //Disable Nagle algorithm?
-      if((flags & SOCKET_FLAG_NO_DELAY) != 0)
-      {
-         //All packets will be send no matter what size they have
-         if(n > 0)
-         {
-            //Send TCP segment
-            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
-               socket->sndNxt, socket->rcvNxt, n, TRUE);
-         }
-         else
-         {
-            //We are done
-            break;
-         }
-      }
-      else if((flags & SOCKET_FLAG_DELAY) != 0)
-      {
-         //Transmit data if a maximum-sized segment can be sent
-         if(MIN(socket->sndUser, u) >= socket->smss)
-         {
-            //Send TCP segment
-            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
-               socket->sndNxt, socket->rcvNxt, n, TRUE);
-         }
-         else
-         {
-            //Prevent the sender from sending tiny segments
-            break;
-         }
-      }
-      else
-      {
-         //Transmit data if a maximum-sized segment can be sent
-         if(MIN(socket->sndUser, u) >= socket->smss)
-         {
-            //Send TCP segment
-            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
-               socket->sndNxt, socket->rcvNxt, n, TRUE);
-         }
-         //Or if all queued data can be sent now
-         else if(socket->sndNxt == socket->sndUna && socket->sndUser <= u)
-         {
-            //Send TCP segment
-            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
-               socket->sndNxt, socket->rcvNxt, n, TRUE);
-         }
-         //Or if at least a fraction of the maximum window can be sent
-         else if(MIN(socket->sndUser, u) >= (socket->maxSndWnd / 2))
-         {
-            //Send TCP segment
-            error = tcpSendSegment(socket, TCP_FLAG_PSH | TCP_FLAG_ACK,
-               socket->sndNxt, socket->rcvNxt, n, TRUE);
-         }
-         else
-         {
-            //Prevent the sender from sending tiny segments
-            break;
-         }
-      }
+         //The FIN flag belongs to the last segment
+         header = (TcpHeader *) queueItem->header;
+         header->flags &= ~TCP_FLAG_FIN;
 
-      //Check status code
-      if(!error)
-      {
-         //Advance SND.NXT pointer
-         socket->sndNxt += n;
-         //Update the number of data buffered but not yet sent
-         socket->sndUser -= n;
-         //Update the size of the usable window
-         u -= n;
-      }
-   }
+         //Truncate the original segment
+         queueItem->length = socket->smss;
 
-   //Check whether the transmitter can accept more data
-   tcpUpdateEvents(socket);
+         //Update the pseudo header
+         tcpSetPseudoHeaderLength(&queueItem->pseudoHeader,
+            header->dataOffset * 4 + queueItem->length);
 
-   //Return status code
-   return error;
+         //Insert the new item into the queue
+         queueItem->next = newQueueItem;
+      }
+
+      //Point to the next item
+      queueItem = queueItem->next;
+   }
 }
 
+#endif
+
 
 /**
  * @brief Update TCP FSM current state
@@ -2051,11 +4374,25 @@ void tcpChangeState(Socket *socket, TcpState newState)
 
 void tcpUpdateEvents(Socket *socket)
 {
+   TcpState state;
+
    //Clear event flags
    socket->eventFlags = 0;
 
+   //Retrieve current TCP state
+   state = socket->state;
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+   //A server may send and receive data before the three-way handshake is
+   //complete when it has accepted a TFO cookie (refer to RFC 7413)
+   if(state == TCP_STATE_SYN_RECEIVED && socket->fastOpenAccepted)
+   {
+      state = TCP_STATE_ESTABLISHED;
+   }
+#endif
+
    //Check current TCP state
-   switch(socket->state)
+   switch(state)
    {
    //ESTABLISHED or FIN-WAIT-1 state?
    case TCP_STATE_ESTABLISHED:
@@ -2091,15 +4428,23 @@ void tcpUpdateEvents(Socket *socket)
    }
 
    //Handle TX specific events
-   if(socket->state == TCP_STATE_SYN_SENT ||
-      socket->state == TCP_STATE_SYN_RECEIVED)
+   if(state == TCP_STATE_SYN_SENT ||
+      state == TCP_STATE_SYN_RECEIVED)
    {
       //Disallow write operations until the connection is established
       socket->eventFlags |= SOCKET_EVENT_TX_DONE;
       socket->eventFlags |= SOCKET_EVENT_TX_ACKED;
+
+#if (TCP_FAST_OPEN_SUPPORT == ENABLED)
+      //The first write operation triggers the transmission of a deferred SYN
+      if(socket->fastOpenPending)
+      {
+         socket->eventFlags |= SOCKET_EVENT_TX_READY;
+      }
+#endif
    }
-   else if(socket->state == TCP_STATE_ESTABLISHED ||
-      socket->state == TCP_STATE_CLOSE_WAIT)
+   else if(state == TCP_STATE_ESTABLISHED ||
+      state == TCP_STATE_CLOSE_WAIT)
    {
       //Check whether the send buffer is full or not
       if((socket->sndUser + socket->sndNxt - socket->sndUna) < socket->txBufferSize)
@@ -2120,7 +4465,7 @@ void tcpUpdateEvents(Socket *socket)
          }
       }
    }
-   else if(socket->state != TCP_STATE_LISTEN)
+   else if(state != TCP_STATE_LISTEN)
    {
       //Unblock user task if the connection is being closed
       socket->eventFlags |= SOCKET_EVENT_TX_READY;
@@ -2129,9 +4474,9 @@ void tcpUpdateEvents(Socket *socket)
    }
 
    //Handle RX specific events
-   if(socket->state == TCP_STATE_ESTABLISHED ||
-      socket->state == TCP_STATE_FIN_WAIT_1 ||
-      socket->state == TCP_STATE_FIN_WAIT_2)
+   if(state == TCP_STATE_ESTABLISHED ||
+      state == TCP_STATE_FIN_WAIT_1 ||
+      state == TCP_STATE_FIN_WAIT_2)
    {
       //Data is available for reading?
       if(socket->rcvUser > 0)
@@ -2139,7 +4484,7 @@ void tcpUpdateEvents(Socket *socket)
          socket->eventFlags |= SOCKET_EVENT_RX_READY;
       }
    }
-   else if(socket->state == TCP_STATE_LISTEN)
+   else if(state == TCP_STATE_LISTEN)
    {
       //If the socket is currently in the listen state, it will be marked
       //as readable if an incoming connection request has been received
@@ -2149,8 +4494,8 @@ void tcpUpdateEvents(Socket *socket)
          socket->eventFlags |= SOCKET_EVENT_RX_READY;
       }
    }
-   else if(socket->state != TCP_STATE_SYN_SENT &&
-      socket->state != TCP_STATE_SYN_RECEIVED)
+   else if(state != TCP_STATE_SYN_SENT &&
+      state != TCP_STATE_SYN_RECEIVED)
    {
       //Readability can also indicate that a request to close
       //the socket has been received from the peer
@@ -2239,7 +4584,8 @@ void tcpWriteTxBuffer(Socket *socket, uint32_t seqNum,
    const uint8_t *data, size_t length)
 {
    //Offset of the first byte to write in the circular buffer
-   size_t offset = (seqNum - socket->iss - 1) % socket->txBufferSize;
+   size_t offset = (seqNum - socket->iss - 1 + socket->txBufferOffset) %
+      socket->txBufferSize;
 
    //Check whether the specified data crosses buffer boundaries
    if((offset + length) <= socket->txBufferSize)
@@ -2277,7 +4623,8 @@ error_t tcpReadTxBuffer(Socket *socket, uint32_t seqNum,
    error_t error;
 
    //Offset of the first byte to read in the circular buffer
-   size_t offset = (seqNum - socket->iss - 1) % socket->txBufferSize;
+   size_t offset = (seqNum - socket->iss - 1 + socket->txBufferOffset) %
+      socket->txBufferSize;
 
    //Check whether the specified data crosses buffer boundaries
    if((offset + length) <= socket->txBufferSize)
@@ -2319,7 +4666,8 @@ void tcpWriteRxBuffer(Socket *socket, uint32_t seqNum,
    const NetBuffer *data, size_t dataOffset, size_t length)
 {
    //Offset of the first byte to write in the circular buffer
-   size_t offset = (seqNum - socket->irs - 1) % socket->rxBufferSize;
+   size_t offset = (seqNum - socket->irs - 1 + socket->rxBufferOffset) %
+      socket->rxBufferSize;
 
    //Check whether the specified data crosses buffer boundaries
    if((offset + length) <= socket->rxBufferSize)
@@ -2354,7 +4702,8 @@ void tcpReadRxBuffer(Socket *socket, uint32_t seqNum, uint8_t *data,
    size_t length)
 {
    //Offset of the first byte to read in the circular buffer
-   size_t offset = (seqNum - socket->irs - 1) % socket->rxBufferSize;
+   size_t offset = (seqNum - socket->irs - 1 + socket->rxBufferOffset) %
+      socket->rxBufferSize;
 
    //Check whether the specified data crosses buffer boundaries
    if((offset + length) <= socket->rxBufferSize)
@@ -2377,6 +4726,68 @@ void tcpReadRxBuffer(Socket *socket, uint32_t seqNum, uint8_t *data,
 }
 
 
+/**
+ * @brief Get read-only views of the data held in the receive buffer
+ * @param[in] socket Handle referencing the socket
+ * @param[in] seqNum Sequence number of the first byte
+ * @param[in] length Number of bytes to map
+ * @param[out] ref Array of views describing contiguous blocks of data
+ * @param[in] maxRefs Maximum number of views
+ * @return Number of views that have been filled
+ **/
+
+uint_t tcpGetRxBufferRef(Socket *socket, uint32_t seqNum, size_t length,
+   TcpRxBufferRef *ref, uint_t maxRefs)
+{
+   uint_t i;
+   uint_t n;
+   size_t k;
+   size_t offset;
+   size_t position;
+   ChunkDesc *chunk;
+
+   //Offset of the first byte in the circular buffer
+   position = (seqNum - socket->irs - 1 + socket->rxBufferOffset) %
+      socket->rxBufferSize;
+
+   //Loop through the data
+   for(n = 0; n < maxRefs && length > 0; n++)
+   {
+      //Locate the chunk that holds the current byte
+      for(offset = position, i = 0; i < socket->rxBuffer.chunkCount; i++)
+      {
+         //Point to the chunk descriptor
+         chunk = &socket->rxBuffer.chunk[i];
+
+         //The byte resides in the current chunk?
+         if(offset < chunk->length)
+            break;
+
+         //Jump to the next chunk
+         offset -= chunk->length;
+      }
+
+      //Invalid offset?
+      if(i >= socket->rxBuffer.chunkCount)
+         break;
+
+      //Number of contiguous bytes in the current chunk
+      k = MIN(length, chunk->length - offset);
+
+      //Save the view
+      ref[n].data = (uint8_t *) chunk->address + offset;
+      ref[n].length = k;
+
+      //Wrap around to the beginning of the circular buffer if necessary
+      position = (position + k) % socket->rxBufferSize;
+      length -= k;
+   }
+
+   //Return the number of views
+   return n;
+}
+
+
 /**
  * @brief Dump TCP header for debugging purpose
  * @param[in] segment Pointer to the TCP header
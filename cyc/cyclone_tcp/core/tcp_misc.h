@@ -52,10 +52,20 @@ error_t tcpAddOption(TcpHeader *segment, uint8_t kind, const void *value,
    uint8_t length);
 
 const TcpOption *tcpGetOption(const TcpHeader *segment, uint8_t kind);
+uint16_t tcpScaleWindow(uint16_t window, uint8_t shift);
 
 uint32_t tcpGenerateInitialSeqNum(const IpAddr *localIpAddr,
    uint16_t localPort, const IpAddr *remoteIpAddr, uint16_t remotePort);
 
+uint32_t tcpComputeSynCookieHash(const IpPseudoHeader *pseudoHeader,
+   const TcpHeader *segment, uint32_t isn, uint32_t counter, uint8_t data);
+
+error_t tcpSendSynCookie(Socket *socket, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment);
+
+error_t tcpCheckSynCookie(Socket *socket, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment);
+
 error_t tcpCheckSeqNum(Socket *socket, const TcpHeader *segment, size_t length);
 error_t tcpCheckSyn(Socket *socket, const TcpHeader *segment, size_t length);
 error_t tcpCheckAck(Socket *socket, const TcpHeader *segment, size_t length);
@@ -73,6 +83,9 @@ void tcpFastLossRecovery(Socket *socket, const TcpHeader *segment);
 void tcpProcessSegmentData(Socket *socket, const TcpHeader *segment,
    const NetBuffer *buffer, size_t offset, size_t length);
 
+void tcpAcknowledgeData(Socket *socket, const TcpHeader *segment,
+   size_t length, bool_t gap);
+
 void tcpDeleteControlBlock(Socket *socket);
 
 void tcpUpdateRetransmitQueue(Socket *socket);
@@ -80,13 +93,60 @@ void tcpFlushRetransmitQueue(Socket *socket);
 
 void tcpFlushSynQueue(Socket *socket);
 
+Socket *tcpSelectListener(Socket *socket, const IpPseudoHeader *pseudoHeader,
+   const TcpHeader *segment);
+
+void tcpEnterTimeWait(Socket *socket);
+void tcpAddTimeWaitEntry(Socket *socket);
+
+TcpTimeWaitEntry *tcpFindTimeWaitEntry(const IpPseudoHeader *pseudoHeader,
+   const TcpHeader *segment);
+
+error_t tcpSendTimeWaitAck(TcpTimeWaitEntry *entry, NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const TcpHeader *segment);
+
+void tcpGenerateFastOpenCookie(const IpAddr *clientIpAddr, uint8_t *cookie);
+
+bool_t tcpCheckFastOpenCookie(const IpAddr *clientIpAddr,
+   const uint8_t *cookie, size_t length);
+
+TcpFastOpenCacheEntry *tcpFindFastOpenCookie(const IpAddr *serverIpAddr);
+
+void tcpSaveFastOpenCookie(const IpAddr *serverIpAddr, uint16_t mss,
+   const uint8_t *cookie, size_t length);
+
+error_t tcpSendFastOpenSyn(Socket *socket, const uint8_t *data, size_t length,
+   size_t *written);
+
 void tcpUpdateSackBlocks(Socket *socket, uint32_t *leftEdge, uint32_t *rightEdge);
 void tcpUpdateSendWindow(Socket *socket, const TcpHeader *segment);
 void tcpUpdateReceiveWindow(Socket *socket);
 
+void tcpAutoTuneTxBuffer(Socket *socket, size_t length);
+void tcpAutoTuneRxBuffer(Socket *socket, size_t length);
+
+error_t tcpGrowBuffer(NetBuffer *buffer, size_t size, size_t newSize,
+   size_t offset, size_t length);
+
+bool_t tcpCheckBufferMemory(size_t size, size_t newSize);
+
 bool_t tcpComputeRto(Socket *socket);
 error_t tcpRetransmitSegment(Socket *socket);
+void tcpSetPseudoHeaderLength(IpPseudoHeader *pseudoHeader, size_t length);
 error_t tcpNagleAlgo(Socket *socket, uint_t flags);
+void tcpUpdatePacingRate(Socket *socket);
+bool_t tcpCheckPacing(Socket *socket, uint_t flags);
+
+size_t tcpGetPathMss(Socket *socket);
+void tcpInitPathMtu(Socket *socket);
+bool_t tcpCheckPathMtuProbe(Socket *socket, uint32_t u);
+void tcpCheckPathMtuProbeLoss(Socket *socket);
+void tcpCheckPathMtuBlackHole(Socket *socket);
+
+void tcpUpdatePathMtu(NetInterface *interface, const IpAddr *localIpAddr,
+   const IpAddr *remoteIpAddr, const TcpHeader *segment, size_t pathMtu);
+
+void tcpSplitRetransmitQueue(Socket *socket);
 
 void tcpChangeState(Socket *socket, TcpState newState);
 
@@ -105,6 +165,9 @@ void tcpWriteRxBuffer(Socket *socket, uint32_t seqNum,
 void tcpReadRxBuffer(Socket *socket, uint32_t seqNum, uint8_t *data,
    size_t length);
 
+uint_t tcpGetRxBufferRef(Socket *socket, uint32_t seqNum, size_t length,
+   TcpRxBufferRef *ref, uint_t maxRefs);
+
 void tcpDumpHeader(const TcpHeader *segment, size_t length, uint32_t iss,
    uint32_t irs);
 
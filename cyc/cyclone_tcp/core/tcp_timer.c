@@ -49,7 +49,7 @@
  *
  * This routine must be periodically called by the TCP/IP stack to
  * handle retransmissions and TCP related timers (persist timer,
- * FIN-WAIT-2 timer and TIME-WAIT timer)
+ * delayed ACK timer, FIN-WAIT-2 timer and TIME-WAIT timer)
  *
  **/
 
@@ -78,6 +78,8 @@ void tcpTick(void)
             tcpCheckKeepAliveTimer(socket);
             //Check override timer
             tcpCheckOverrideTimer(socket);
+            //Check delayed ACK timer
+            tcpCheckDelayedAckTimer(socket);
             //Check FIN-WAIT-2 timer
             tcpCheckFinWait2Timer(socket);
             //Check 2MSL timer
@@ -85,6 +87,11 @@ void tcpTick(void)
          }
       }
    }
+
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+   //Release expired entries from the TIME-WAIT table
+   tcpCheckTimeWaitTable();
+#endif
 }
 
 
@@ -104,6 +111,11 @@ void tcpCheckRetransmitTimer(Socket *socket)
          //Retransmission timeout?
          if(netTimerExpired(&socket->retransmitTimer))
          {
+#if (TCP_PLPMTUD_SUPPORT == ENABLED)
+            //Repeated timeouts may be caused by a PMTU black hole
+            tcpCheckPathMtuBlackHole(socket);
+#endif
+
 #if (TCP_CONGEST_CONTROL_SUPPORT == ENABLED)
             //When a TCP sender detects segment loss using the retransmission
             //timer and the given segment has not yet been resent by way of
@@ -381,6 +393,39 @@ void tcpCheckOverrideTimer(Socket *socket)
 }
 
 
+/**
+ * @brief Check delayed ACK timer
+ *
+ * Data that have been received in sequence but not yet acknowledged must be
+ * acknowledged when the delayed ACK timer elapses
+ *
+ * @param[in] socket Handle referencing the socket
+ **/
+
+void tcpCheckDelayedAckTimer(Socket *socket)
+{
+#if (TCP_DELAYED_ACK_SUPPORT == ENABLED)
+   //Any data received but not yet acknowledged?
+   if(socket->rcvAckPending > 0)
+   {
+      //The timer is only checked every TCP_TICK_INTERVAL. The ACK is sent
+      //on the last tick before the deadline so that it is never delayed by
+      //more than TCP_DELAYED_ACK_TIMEOUT
+      if(netTimerRunning(&socket->delayedAckTimer) &&
+         netGetRemainingTime(&socket->delayedAckTimer) < TCP_TICK_INTERVAL)
+      {
+         //Number of ACKs sent upon expiry of the delayed ACK timer
+         socket->stats.delayedAcks++;
+
+         //Acknowledge the received data
+         tcpSendSegment(socket, TCP_FLAG_ACK, socket->sndNxt, socket->rcvNxt,
+            0, FALSE);
+      }
+   }
+#endif
+}
+
+
 /**
  * @brief Check FIN-WAIT-2 timer
  *
@@ -441,4 +486,88 @@ void tcpCheckTimeWaitTimer(Socket *socket)
    }
 }
 
+
+#if (TCP_COMPACT_TIME_WAIT_SUPPORT == ENABLED)
+
+/**
+ * @brief Check the 2MSL timer of the connections in the TIME-WAIT table
+ **/
+
+void tcpCheckTimeWaitTable(void)
+{
+   uint_t i;
+   systime_t time;
+   TcpTimeWaitEntry *entry;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Loop through the TIME-WAIT table
+   for(i = 0; i < TCP_TIME_WAIT_TABLE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &tcpTimeWaitTable[i];
+
+      //2MSL timer expired?
+      if(entry->used && timeCompare(time, entry->expireTime) >= 0)
+      {
+         //Debug message
+         TRACE_INFO("TCP 2MSL timer elapsed...\r\n");
+         //Release the entry
+         entry->used = FALSE;
+      }
+   }
+}
+
+#endif
+
+#if (TCP_PACING_SUPPORT == ENABLED)
+
+/**
+ * @brief TCP pacing timer handler
+ *
+ * This routine is called by the TCP/IP stack every TCP_PACING_TICK_INTERVAL
+ * while segments are held back by pacing
+ *
+ **/
+
+void tcpPacingTick(void)
+{
+   uint_t i;
+   Socket *socket;
+
+   //Clear flag
+   tcpPacingPending = FALSE;
+
+   //Loop through opened sockets
+   for(i = 0; i < SOCKET_MAX_COUNT; i++)
+   {
+      //Point to the current socket
+      socket = &socketTable[i];
+
+      //TCP socket?
+      if(socket->type == SOCKET_TYPE_STREAM)
+      {
+         //Any segment held back by pacing?
+         if(socket->pacingPending)
+         {
+            //Check current TCP state
+            if(socket->state != TCP_STATE_CLOSED)
+            {
+               //Send as much data as the pacing rate allows. Segments that
+               //still cannot be sent will set the flag again
+               tcpNagleAlgo(socket, socket->pacingFlags);
+            }
+            else
+            {
+               //The connection has been closed
+               socket->pacingPending = FALSE;
+            }
+         }
+      }
+   }
+}
+
+#endif
+
 #endif
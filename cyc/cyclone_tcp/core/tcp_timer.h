@@ -43,8 +43,11 @@ void tcpCheckRetransmitTimer(Socket *socket);
 void tcpCheckPersistTimer(Socket *socket);
 void tcpCheckKeepAliveTimer(Socket *socket);
 void tcpCheckOverrideTimer(Socket *socket);
+void tcpCheckDelayedAckTimer(Socket *socket);
 void tcpCheckFinWait2Timer(Socket *socket);
 void tcpCheckTimeWaitTimer(Socket *socket);
+void tcpCheckTimeWaitTable(void);
+void tcpPacingTick(void);
 
 //C++ guard
 #ifdef __cplusplus
@@ -196,178 +196,15 @@ error_t udpProcessDatagram(NetInterface *interface,
       }
    }
 
-   //Loop through opened sockets
-   for(i = 0; i < SOCKET_MAX_COUNT; i++)
-   {
-      //Point to the current socket
-      socket = &socketTable[i];
-
-      //UDP socket found?
-      if(socket->type != SOCKET_TYPE_DGRAM)
-         continue;
-
-      //Check whether the socket is bound to a particular interface
-      if(socket->interface != NULL && socket->interface != interface)
-         continue;
-
-      //Check destination port number
-      if(socket->localPort == 0 || socket->localPort != ntohs(header->destPort))
-         continue;
-
-      //Source port number filtering
-      if(socket->remotePort != 0 && socket->remotePort != ntohs(header->srcPort))
-         continue;
-
-#if (IPV4_SUPPORT == ENABLED)
-      //IPv4 packet received?
-      if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
-      {
-         //Check whether the socket is restricted to IPv6 communications only
-         if((socket->options & SOCKET_OPTION_IPV6_ONLY) != 0)
-            continue;
-
-         //Check whether the destination address is a unicast, broadcast or
-         //multicast address
-         if(ipv4IsBroadcastAddr(interface, pseudoHeader->ipv4Data.destAddr))
-         {
-            //Check whether broadcast datagrams are accepted or not
-            if((socket->options & SOCKET_OPTION_BROADCAST) == 0)
-               continue;
-         }
-         else if(ipv4IsMulticastAddr(pseudoHeader->ipv4Data.destAddr))
-         {
-            IpAddr srcAddr;
-            IpAddr destAddr;
-
-            //Get source IPv4 address
-            srcAddr.length = sizeof(Ipv4Addr);
-            srcAddr.ipv4Addr = pseudoHeader->ipv4Data.srcAddr;
-
-            //Get destination IPv4 address
-            destAddr.length = sizeof(Ipv4Addr);
-            destAddr.ipv4Addr = pseudoHeader->ipv4Data.destAddr;
-
-            //Multicast address filtering
-            if(!socketMulticastFilter(socket, &destAddr, &srcAddr))
-            {
-               continue;
-            }
-         }
-         else
-         {
-            //Destination IP address filtering
-            if(socket->localIpAddr.length != 0)
-            {
-               //An IPv4 address is expected
-               if(socket->localIpAddr.length != sizeof(Ipv4Addr))
-                  continue;
-
-               //Filter out non-matching addresses
-               if(socket->localIpAddr.ipv4Addr != IPV4_UNSPECIFIED_ADDR &&
-                  socket->localIpAddr.ipv4Addr != pseudoHeader->ipv4Data.destAddr)
-               {
-                  continue;
-               }
-            }
-         }
-
-         //Source IP address filtering
-         if(socket->remoteIpAddr.length != 0)
-         {
-            //An IPv4 address is expected
-            if(socket->remoteIpAddr.length != sizeof(Ipv4Addr))
-               continue;
-
-            //Filter out non-matching addresses
-            if(socket->remoteIpAddr.ipv4Addr != IPV4_UNSPECIFIED_ADDR &&
-               socket->remoteIpAddr.ipv4Addr != pseudoHeader->ipv4Data.srcAddr)
-            {
-               continue;
-            }
-         }
-      }
-      else
-#endif
-#if (IPV6_SUPPORT == ENABLED)
-      //IPv6 packet received?
-      if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
-      {
-         //Check whether the destination address is a unicast or multicast
-         //address
-         if(ipv6IsMulticastAddr(&pseudoHeader->ipv6Data.destAddr))
-         {
-            IpAddr srcAddr;
-            IpAddr destAddr;
-
-            //Get source IPv6 address
-            srcAddr.length = sizeof(Ipv6Addr);
-            srcAddr.ipv6Addr = pseudoHeader->ipv6Data.srcAddr;
-
-            //Get destination IPv6 address
-            destAddr.length = sizeof(Ipv6Addr);
-            destAddr.ipv6Addr = pseudoHeader->ipv6Data.destAddr;
-
-            //Multicast address filtering
-            if(!socketMulticastFilter(socket, &destAddr, &srcAddr))
-            {
-               continue;
-            }
-         }
-         else
-         {
-            //Destination IP address filtering
-            if(socket->localIpAddr.length != 0)
-            {
-               //An IPv6 address is expected
-               if(socket->localIpAddr.length != sizeof(Ipv6Addr))
-                  continue;
-
-               //Filter out non-matching addresses
-               if(!ipv6CompAddr(&socket->localIpAddr.ipv6Addr,
-                  &IPV6_UNSPECIFIED_ADDR) &&
-                  !ipv6CompAddr(&socket->localIpAddr.ipv6Addr,
-                  &pseudoHeader->ipv6Data.destAddr))
-               {
-                  continue;
-               }
-            }
-         }
-
-         //Source IP address filtering
-         if(socket->remoteIpAddr.length != 0)
-         {
-            //An IPv6 address is expected
-            if(socket->remoteIpAddr.length != sizeof(Ipv6Addr))
-               continue;
-
-            //Filter out non-matching addresses
-            if(!ipv6CompAddr(&socket->remoteIpAddr.ipv6Addr,
-               &IPV6_UNSPECIFIED_ADDR) &&
-               !ipv6CompAddr(&socket->remoteIpAddr.ipv6Addr,
-               &pseudoHeader->ipv6Data.srcAddr))
-            {
-               continue;
-            }
-         }
-      }
-      else
-#endif
-      //Invalid packet received?
-      {
-         //This should never occur...
-         continue;
-      }
-
-      //The current socket meets all the criteria
-      break;
-   }
+   //Search the socket table for a matching socket
+   socket = udpFindSocket(interface, pseudoHeader, header);
 
    //Point to the payload
    offset += sizeof(UdpHeader);
    length -= sizeof(UdpHeader);
 
    //No matching socket found?
-   if(i >= SOCKET_MAX_COUNT)
+   if(socket == NULL)
    {
       //Invoke user callback, if any
       error = udpInvokeRxCallback(interface, pseudoHeader, header, buffer,
@@ -506,6 +343,293 @@ error_t udpProcessDatagram(NetInterface *interface,
 }
 
 
+/**
+ * @brief Search for the socket a received UDP datagram should be delivered to
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader UDP pseudo header
+ * @param[in] header UDP header
+ * @return Pointer to the matching socket, if any
+ **/
+
+Socket *udpFindSocket(NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const UdpHeader *header)
+{
+   uint_t i;
+   Socket *socket;
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 multicast datagram?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader) &&
+      ipv4IsMulticastAddr(pseudoHeader->ipv4Data.destAddr))
+   {
+      //Only the subscribers of the multicast group are considered
+      return udpFindMulticastSocket(interface, pseudoHeader, header);
+   }
+#endif
+
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 multicast datagram?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader) &&
+      ipv6IsMulticastAddr(&pseudoHeader->ipv6Data.destAddr))
+   {
+      //Only the subscribers of the multicast group are considered
+      return udpFindMulticastSocket(interface, pseudoHeader, header);
+   }
+#endif
+
+   //Loop through opened sockets
+   for(i = 0; i < SOCKET_MAX_COUNT; i++)
+   {
+      //Point to the current socket
+      socket = &socketTable[i];
+
+      //UDP socket found?
+      if(socket->type != SOCKET_TYPE_DGRAM)
+         continue;
+
+      //Check whether the socket is bound to a particular interface
+      if(socket->interface != NULL && socket->interface != interface)
+         continue;
+
+      //Check destination port number
+      if(socket->localPort == 0 || socket->localPort != ntohs(header->destPort))
+         continue;
+
+      //Source port number filtering
+      if(socket->remotePort != 0 && socket->remotePort != ntohs(header->srcPort))
+         continue;
+
+#if (IPV4_SUPPORT == ENABLED)
+      //IPv4 packet received?
+      if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+      {
+         //Check whether the socket is restricted to IPv6 communications only
+         if((socket->options & SOCKET_OPTION_IPV6_ONLY) != 0)
+            continue;
+
+         //Check whether the destination address is a unicast or broadcast
+         //address
+         if(ipv4IsBroadcastAddr(interface, pseudoHeader->ipv4Data.destAddr))
+         {
+            //Check whether broadcast datagrams are accepted or not
+            if((socket->options & SOCKET_OPTION_BROADCAST) == 0)
+               continue;
+         }
+         else
+         {
+            //Destination IP address filtering
+            if(socket->localIpAddr.length != 0)
+            {
+               //An IPv4 address is expected
+               if(socket->localIpAddr.length != sizeof(Ipv4Addr))
+                  continue;
+
+               //Filter out non-matching addresses
+               if(socket->localIpAddr.ipv4Addr != IPV4_UNSPECIFIED_ADDR &&
+                  socket->localIpAddr.ipv4Addr != pseudoHeader->ipv4Data.destAddr)
+               {
+                  continue;
+               }
+            }
+         }
+
+         //Source IP address filtering
+         if(socket->remoteIpAddr.length != 0)
+         {
+            //An IPv4 address is expected
+            if(socket->remoteIpAddr.length != sizeof(Ipv4Addr))
+               continue;
+
+            //Filter out non-matching addresses
+            if(socket->remoteIpAddr.ipv4Addr != IPV4_UNSPECIFIED_ADDR &&
+               socket->remoteIpAddr.ipv4Addr != pseudoHeader->ipv4Data.srcAddr)
+            {
+               continue;
+            }
+         }
+      }
+      else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+      //IPv6 packet received?
+      if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+      {
+         //Destination IP address filtering
+         if(socket->localIpAddr.length != 0)
+         {
+            //An IPv6 address is expected
+            if(socket->localIpAddr.length != sizeof(Ipv6Addr))
+               continue;
+
+            //Filter out non-matching addresses
+            if(!ipv6CompAddr(&socket->localIpAddr.ipv6Addr,
+               &IPV6_UNSPECIFIED_ADDR) &&
+               !ipv6CompAddr(&socket->localIpAddr.ipv6Addr,
+               &pseudoHeader->ipv6Data.destAddr))
+            {
+               continue;
+            }
+         }
+
+         //Source IP address filtering
+         if(socket->remoteIpAddr.length != 0)
+         {
+            //An IPv6 address is expected
+            if(socket->remoteIpAddr.length != sizeof(Ipv6Addr))
+               continue;
+
+            //Filter out non-matching addresses
+            if(!ipv6CompAddr(&socket->remoteIpAddr.ipv6Addr,
+               &IPV6_UNSPECIFIED_ADDR) &&
+               !ipv6CompAddr(&socket->remoteIpAddr.ipv6Addr,
+               &pseudoHeader->ipv6Data.srcAddr))
+            {
+               continue;
+            }
+         }
+      }
+      else
+#endif
+      //Invalid packet received?
+      {
+         //This should never occur...
+         continue;
+      }
+
+      //The current socket meets all the criteria
+      return socket;
+   }
+
+   //No matching socket found
+   return NULL;
+}
+
+
+/**
+ * @brief Search the multicast group index for a socket matching a datagram
+ *
+ * Only the sockets that subscribed to the destination group are examined,
+ * so that the cost does not depend on the total number of opened sockets
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader UDP pseudo header
+ * @param[in] header UDP header
+ * @return Pointer to the matching socket, if any
+ **/
+
+Socket *udpFindMulticastSocket(NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const UdpHeader *header)
+{
+#if (SOCKET_MAX_MULTICAST_GROUPS > 0)
+   IpAddr srcAddr;
+   IpAddr destAddr;
+   Socket *socket;
+   Socket *match;
+   SocketMulticastGroup *group;
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 packet received?
+   if(pseudoHeader->length == sizeof(Ipv4PseudoHeader))
+   {
+      //Get source and destination IPv4 addresses
+      srcAddr.length = sizeof(Ipv4Addr);
+      srcAddr.ipv4Addr = pseudoHeader->ipv4Data.srcAddr;
+      destAddr.length = sizeof(Ipv4Addr);
+      destAddr.ipv4Addr = pseudoHeader->ipv4Data.destAddr;
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 packet received?
+   if(pseudoHeader->length == sizeof(Ipv6PseudoHeader))
+   {
+      //Get source and destination IPv6 addresses
+      srcAddr.length = sizeof(Ipv6Addr);
+      srcAddr.ipv6Addr = pseudoHeader->ipv6Data.srcAddr;
+      destAddr.length = sizeof(Ipv6Addr);
+      destAddr.ipv6Addr = pseudoHeader->ipv6Data.destAddr;
+   }
+   else
+#endif
+   //Invalid packet received?
+   {
+      //This should never occur...
+      return NULL;
+   }
+
+   //Initialize pointer
+   match = NULL;
+
+   //Loop through the subscribers hashed to the same bucket
+   for(group = socketMulticastIndex[socketGetMulticastHashIndex(&destAddr)];
+      group != NULL; group = group->next)
+   {
+      //Matching multicast address?
+      if(!ipCompAddr(&group->addr, &destAddr))
+         continue;
+
+      //Point to the subscribing socket
+      socket = group->socket;
+
+      //UDP socket found?
+      if(socket->type != SOCKET_TYPE_DGRAM)
+         continue;
+
+      //Check whether the socket is bound to a particular interface
+      if(socket->interface != NULL && socket->interface != interface)
+         continue;
+
+      //Check destination port number
+      if(socket->localPort == 0 || socket->localPort != ntohs(header->destPort))
+         continue;
+
+      //Source port number filtering
+      if(socket->remotePort != 0 && socket->remotePort != ntohs(header->srcPort))
+         continue;
+
+      //Check whether the socket is restricted to IPv6 communications only
+      if(destAddr.length == sizeof(Ipv4Addr) &&
+         (socket->options & SOCKET_OPTION_IPV6_ONLY) != 0)
+      {
+         continue;
+      }
+
+      //Source IP address filtering
+      if(socket->remoteIpAddr.length != 0)
+      {
+         //The address family must match
+         if(socket->remoteIpAddr.length != srcAddr.length)
+            continue;
+
+         //Filter out non-matching addresses
+         if(!ipIsUnspecifiedAddr(&socket->remoteIpAddr) &&
+            !ipCompAddr(&socket->remoteIpAddr, &srcAddr))
+         {
+            continue;
+         }
+      }
+
+      //Apply the source filter of the group
+      if(!socketMulticastSrcFilter(group, &srcAddr))
+         continue;
+
+      //When several sockets match, the datagram is delivered to the one
+      //with the lowest descriptor
+      if(match == NULL || socket->descriptor < match->descriptor)
+      {
+         match = socket;
+      }
+   }
+
+   //Return a pointer to the matching socket, if any
+   return match;
+#else
+   //Not implemented
+   return NULL;
+#endif
+}
+
+
 /**
  * @brief Send a UDP datagram
  * @param[in] socket Handle referencing the socket
@@ -520,7 +644,11 @@ error_t udpSendDatagram(Socket *socket, const SocketMsg *message, uint_t flags)
    size_t offset;
    NetBuffer *buffer;
    NetInterface *interface;
+   IpAddr srcIpAddr;
    NetTxAncillary ancillary;
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+   bool_t cacheable;
+#endif
 
    //Select the relevant network interface
    if(message->interface != NULL)
@@ -628,9 +756,62 @@ error_t udpSendDatagram(Socket *socket, const SocketMsg *message, uint_t flags)
       ancillary.timestampId = message->timestampId;
 #endif
 
+      //Source IP address (optional parameter)
+      srcIpAddr = message->srcIpAddr;
+
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+      //The route cache is bypassed when the caller chooses the next hop
+      cacheable = !ancillary.dontRoute;
+
+#if (ETH_SUPPORT == ENABLED)
+      //The destination MAC address may be specified by the caller
+      if(!macCompAddr(&ancillary.destMacAddr, &MAC_UNSPECIFIED_ADDR))
+      {
+         cacheable = FALSE;
+      }
+#endif
+
+      //Look up the route cache
+      if(cacheable && !socketGetRouteCache(socket, &interface, &srcIpAddr,
+         &message->destIpAddr, &ancillary))
+      {
+         //Source address selection is performed here so that the result can
+         //be saved in the route cache
+         if(srcIpAddr.length == 0)
+         {
+            //Select the source IP address and the relevant network interface
+            //to use when sending data to the specified destination host
+            error = ipSelectSourceAddr(&interface, &message->destIpAddr,
+               &srcIpAddr);
+
+            //Source address selection failed?
+            if(error)
+            {
+               //Let the UDP layer handle special cases such as broadcasts
+               srcIpAddr = message->srcIpAddr;
+               cacheable = FALSE;
+            }
+         }
+         else if(interface == NULL)
+         {
+            //Use default network interface
+            interface = netGetDefaultInterface();
+         }
+      }
+#endif
+
       //Send UDP datagram
-      error = udpSendBuffer(interface, &message->srcIpAddr, socket->localPort,
+      error = udpSendBuffer(interface, &srcIpAddr, socket->localPort,
          &message->destIpAddr, message->destPort, buffer, offset, &ancillary);
+
+#if (SOCKET_ROUTE_CACHE_SUPPORT == ENABLED)
+      //Save the route for subsequent datagrams
+      if(!error && cacheable)
+      {
+         socketUpdateRouteCache(socket, interface, &srcIpAddr,
+            &message->destIpAddr, &ancillary);
+      }
+#endif
    }
 
    //Free previously allocated memory
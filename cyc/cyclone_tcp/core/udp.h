@@ -127,6 +127,12 @@ error_t udpProcessDatagram(NetInterface *interface,
    const IpPseudoHeader *pseudoHeader, const NetBuffer *buffer, size_t offset,
    const NetRxAncillary *ancillary);
 
+Socket *udpFindSocket(NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const UdpHeader *header);
+
+Socket *udpFindMulticastSocket(NetInterface *interface,
+   const IpPseudoHeader *pseudoHeader, const UdpHeader *header);
+
 error_t udpSendDatagram(Socket *socket, const SocketMsg *message, uint_t flags);
 
 error_t udpSendBuffer(NetInterface *interface, const IpAddr *srcIpAddr,
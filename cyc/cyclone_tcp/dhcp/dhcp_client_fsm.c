@@ -411,6 +411,8 @@ void dhcpClientStateProbing(DhcpClientContext *context)
       {
          //The use of the IPv4 address is now unrestricted
          interface->ipv4Context.addrList[i].state = IPV4_ADDR_STATE_VALID;
+         //The routes cached by the sockets are no longer valid
+         netInvalidateRouteCache();
 
          //The client transitions to the ANNOUNCING state
          dhcpClientChangeState(context, DHCP_STATE_ANNOUNCING, 0);
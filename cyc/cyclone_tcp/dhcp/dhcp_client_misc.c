@@ -1116,6 +1116,9 @@ void dhcpClientParseAck(DhcpClientContext *context,
       interface->ipv4Context.addrList[i].addr = message->yiaddr;
       interface->ipv4Context.addrList[i].state = IPV4_ADDR_STATE_VALID;
 
+      //The routes cached by the sockets are no longer valid
+      netInvalidateRouteCache();
+
 #if (MDNS_RESPONDER_SUPPORT == ENABLED)
       //Restart mDNS probing process
       mdnsResponderStartProbing(interface->mdnsResponderContext);
@@ -1363,6 +1366,9 @@ void dhcpClientResetConfig(DhcpClientContext *context)
    //The default gateway is no longer valid
    interface->ipv4Context.addrList[i].defaultGateway = IPV4_UNSPECIFIED_ADDR;
 
+   //The routes cached by the sockets are no longer valid
+   netInvalidateRouteCache();
+
    //Automatic DNS server configuration?
    if(!context->settings.manualDnsConfig)
    {
@@ -720,16 +720,21 @@ void enc28j60SelectBank(NetInterface *interface, uint16_t address)
 
 void enc28j60WriteReg(NetInterface *interface, uint16_t address, uint8_t data)
 {
+   uint8_t buffer[2];
+
    //Make sure the corresponding bank is selected
    enc28j60SelectBank(interface, address);
 
+   //Write opcode and register address
+   buffer[0] = ENC28J60_CMD_WCR | (address & REG_ADDR_MASK);
+   //Write register value
+   buffer[1] = data;
+
    //Pull the CS pin low
    interface->spiDriver->assertCs();
 
-   //Write opcode and register address
-   interface->spiDriver->transfer(ENC28J60_CMD_WCR | (address & REG_ADDR_MASK));
-   //Write register value
-   interface->spiDriver->transfer(data);
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -745,31 +750,38 @@ void enc28j60WriteReg(NetInterface *interface, uint16_t address, uint8_t data)
 
 uint8_t enc28j60ReadReg(NetInterface *interface, uint16_t address)
 {
-   uint16_t data;
+   size_t n;
+   uint8_t buffer[3];
 
    //Make sure the corresponding bank is selected
    enc28j60SelectBank(interface, address);
 
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
-
    //Write opcode and register address
-   interface->spiDriver->transfer(ENC28J60_CMD_RCR | (address & REG_ADDR_MASK));
+   buffer[0] = ENC28J60_CMD_RCR | (address & REG_ADDR_MASK);
+   buffer[1] = 0x00;
+   buffer[2] = 0x00;
 
    //When reading MAC or MII registers, a dummy byte is first shifted out
    if((address & REG_TYPE_MASK) != ETH_REG_TYPE)
    {
-      interface->spiDriver->transfer(0x00);
+      n = 3;
    }
+   else
+   {
+      n = 2;
+   }
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
 
-   //Read register contents
-   data = interface->spiDriver->transfer(0x00);
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, buffer, n);
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
 
    //Return register contents
-   return data;
+   return buffer[n - 1];
 }
 
 
@@ -843,17 +855,20 @@ void enc28j60WriteBuffer(NetInterface *interface,
    const NetBuffer *buffer, size_t offset)
 {
    uint_t i;
-   size_t j;
    size_t n;
    uint8_t *p;
+   uint8_t header[2];
+
+   //Write opcode
+   header[0] = ENC28J60_CMD_WBM;
+   //Write per-packet control byte
+   header[1] = 0x00;
 
    //Pull the CS pin low
    interface->spiDriver->assertCs();
 
-   //Write opcode
-   interface->spiDriver->transfer(ENC28J60_CMD_WBM);
-   //Write per-packet control byte
-   interface->spiDriver->transfer(0x00);
+   //Send the command
+   nicSpiTransfer(interface, header, NULL, sizeof(header));
 
    //Loop through data chunks
    for(i = 0; i < buffer->chunkCount; i++)
@@ -867,10 +882,7 @@ void enc28j60WriteBuffer(NetInterface *interface,
          n = buffer->chunk[i].length - offset;
 
          //Copy data to SRAM buffer
-         for(j = 0; j < n; j++)
-         {
-            interface->spiDriver->transfer(p[j]);
-         }
+         nicSpiTransfer(interface, p, NULL, n);
 
          //Process the next block from the start
          offset = 0;
@@ -897,19 +909,19 @@ void enc28j60WriteBuffer(NetInterface *interface,
 void enc28j60ReadBuffer(NetInterface *interface,
    uint8_t *data, size_t length)
 {
-   size_t i;
+   uint8_t opcode;
+
+   //Write opcode
+   opcode = ENC28J60_CMD_RBM;
 
    //Pull the CS pin low
    interface->spiDriver->assertCs();
 
-   //Write opcode
-   interface->spiDriver->transfer(ENC28J60_CMD_RBM);
+   //Send the command
+   nicSpiTransfer(interface, &opcode, NULL, sizeof(opcode));
 
    //Copy data from SRAM buffer
-   for(i = 0; i < length; i++)
-   {
-      data[i] = interface->spiDriver->transfer(0x00);
-   }
+   nicSpiTransfer(interface, NULL, data, length);
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -925,13 +937,18 @@ void enc28j60ReadBuffer(NetInterface *interface,
 
 void enc28j60SetBit(NetInterface *interface, uint16_t address, uint16_t mask)
 {
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[2];
 
    //Write opcode and register address
-   interface->spiDriver->transfer(ENC28J60_CMD_BFS | (address & REG_ADDR_MASK));
+   buffer[0] = ENC28J60_CMD_BFS | (address & REG_ADDR_MASK);
    //Write bit mask
-   interface->spiDriver->transfer(mask);
+   buffer[1] = (uint8_t) mask;
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -947,13 +964,18 @@ void enc28j60SetBit(NetInterface *interface, uint16_t address, uint16_t mask)
 
 void enc28j60ClearBit(NetInterface *interface, uint16_t address, uint16_t mask)
 {
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[2];
 
    //Write opcode and register address
-   interface->spiDriver->transfer(ENC28J60_CMD_BFC | (address & REG_ADDR_MASK));
+   buffer[0] = ENC28J60_CMD_BFC | (address & REG_ADDR_MASK);
    //Write bit mask
-   interface->spiDriver->transfer(mask);
+   buffer[1] = (uint8_t) mask;
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -36,6 +36,19 @@
 #include "drivers/eth/lan8651_driver.h"
 #include "debug.h"
 
+//Check burst mode
+#if (LAN8651_BURST_SUPPORT == ENABLED)
+
+//Burst buffers (the second one is used to send frames while a received
+//frame is being processed)
+static uint8_t lan8651BurstBuffer[2][LAN8651_MAX_BURST_CHUNKS *
+   (LAN8651_CHUNK_PAYLOAD_SIZE + 4)];
+
+//Reassembly buffer
+static uint8_t lan8651RxBuffer[LAN8651_ETH_RX_BUFFER_SIZE];
+
+#endif
+
 
 /**
  * @brief LAN8651 driver
@@ -71,10 +84,17 @@ const NicDriver lan8651Driver =
 error_t lan8651Init(NetInterface *interface)
 {
    uint32_t value;
+   Lan8651Context *context;
+
+   //Point to the driver context
+   context = (Lan8651Context *) interface->nicContext;
 
    //Debug message
    TRACE_INFO("Initializing LAN8651 Ethernet controller...\r\n");
 
+   //Initialize driver context
+   osMemset(context, 0, sizeof(Lan8651Context));
+
    //Initialize SPI interface
    interface->spiDriver->init();
 
@@ -379,6 +399,22 @@ bool_t lan8651IrqHandler(NetInterface *interface)
 
 void lan8651EventHandler(NetInterface *interface)
 {
+#if (LAN8651_BURST_SUPPORT == ENABLED)
+   Lan8651Context *context;
+
+   //Point to the driver context
+   context = (Lan8651Context *) interface->nicContext;
+
+   //Process all the data chunks
+   do
+   {
+      //Read as many data chunks as reported by the last footer. The footers
+      //also give the number of chunks still available for reading
+      lan8651TransferChunks(interface, NULL, 0, 0);
+
+      //Any data chunk available to the host MCU for reading?
+   } while(context->rxChunks != 0);
+#else
    uint32_t status;
 
    //Process all the data chunks
@@ -392,6 +428,7 @@ void lan8651EventHandler(NetInterface *interface)
 
       //Any data chunk available to the host MCU for reading?
    } while((status & LAN8651_OA_BUFSTS_RCA) != 0);
+#endif
 }
 
 
@@ -408,9 +445,62 @@ void lan8651EventHandler(NetInterface *interface)
 error_t lan8651SendPacket(NetInterface *interface,
    const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
 {
+#if (LAN8651_BURST_SUPPORT == ENABLED)
+   size_t n;
+   size_t length;
+   uint32_t status;
+   Lan8651Context *context;
+
+   //Point to the driver context
+   context = (Lan8651Context *) interface->nicContext;
+
+   //Retrieve the length of the packet
+   length = netBufferGetLength(buffer) - offset;
+
+   //The footer of the last data chunk gives the number of transmit credits
+   n = context->txCredits;
+
+   //Read the buffer status register only when the cached value is not
+   //sufficient to send the whole frame
+   if(length > (n * LAN8651_CHUNK_PAYLOAD_SIZE))
+   {
+      //Read buffer status register
+      status = lan8651ReadReg(interface, LAN8651_OA_BUFSTS);
+      //Get the number of data chunks available in the transmit buffer
+      n = (status & LAN8651_OA_BUFSTS_TXC) >> 8;
+
+      //Save the number of transmit credits
+      context->txCredits = (uint8_t) MIN(n, UINT8_MAX);
+   }
+
+   //Check the number of transmit credits available
+   if(length <= (n * LAN8651_CHUNK_PAYLOAD_SIZE))
+   {
+      //Send the frame and read pending receive data chunks in the same
+      //full-duplex bursts
+      lan8651TransferChunks(interface, buffer, offset, length);
+
+      //Some data chunks are available for reading
+      if(context->rxChunks != 0)
+      {
+         interface->nicEvent = TRUE;
+         //Notify the TCP/IP stack of the event
+         osSetEvent(&netEvent);
+      }
+   }
+   else
+   {
+      //No sufficient credits available
+   }
+
+   //The transmitter can accept another packet
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+#else
    static uint8_t chunk[LAN8651_CHUNK_PAYLOAD_SIZE + 4];
    size_t i;
-   size_t j;
    size_t n;
    size_t length;
    uint32_t status;
@@ -483,10 +573,7 @@ error_t lan8651SendPacket(NetInterface *interface,
          interface->spiDriver->assertCs();
 
          //Perform data transfer
-         for(j = 0; j < (LAN8651_CHUNK_PAYLOAD_SIZE + 4); j++)
-         {
-            chunk[j] = interface->spiDriver->transfer(chunk[j]);
-         }
+         nicSpiTransfer(interface, chunk, chunk, LAN8651_CHUNK_PAYLOAD_SIZE + 4);
 
          //Terminate the operation by raising the CS pin
          interface->spiDriver->deassertCs();
@@ -515,6 +602,7 @@ error_t lan8651SendPacket(NetInterface *interface,
 
    //Successful processing
    return NO_ERROR;
+#endif
 }
 
 
@@ -529,7 +617,6 @@ error_t lan8651ReceivePacket(NetInterface *interface)
    static uint8_t buffer[LAN8651_ETH_RX_BUFFER_SIZE];
    static uint8_t chunk[LAN8651_CHUNK_PAYLOAD_SIZE + 4];
    error_t error;
-   size_t i;
    size_t n;
    size_t length;
    uint32_t header;
@@ -569,10 +656,7 @@ error_t lan8651ReceivePacket(NetInterface *interface)
       interface->spiDriver->assertCs();
 
       //Perform data transfer
-      for(i = 0; i < (LAN8651_CHUNK_PAYLOAD_SIZE + 4); i++)
-      {
-         chunk[i] = interface->spiDriver->transfer(chunk[i]);
-      }
+      nicSpiTransfer(interface, chunk, chunk, LAN8651_CHUNK_PAYLOAD_SIZE + 4);
 
       //Terminate the operation by raising the CS pin
       interface->spiDriver->deassertCs();
@@ -646,6 +730,302 @@ error_t lan8651ReceivePacket(NetInterface *interface)
 }
 
 
+/**
+ * @brief Exchange data chunks in full-duplex bursts
+ *
+ * Each burst carries as many transmit data chunks as needed to send the
+ * frame and as many receive data chunks as reported by the RCA field of
+ * the last footer, within a single CS-framed SPI transaction
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the frame to send (may be
+ *   NULL when there is no data to send)
+ * @param[in] offset Offset to the first data byte
+ * @param[in] length Length of the frame, in bytes
+ **/
+
+void lan8651TransferChunks(NetInterface *interface, const NetBuffer *buffer,
+   size_t offset, size_t length)
+{
+#if (LAN8651_BURST_SUPPORT == ENABLED)
+   uint_t j;
+   uint_t k;
+   uint_t m;
+   size_t i;
+   size_t n;
+   uint8_t *p;
+   uint8_t *burst;
+   bool_t rxEnable;
+   uint32_t header;
+   uint32_t footer[LAN8651_MAX_BURST_CHUNKS];
+   Lan8651Context *context;
+
+   //Point to the driver context
+   context = (Lan8651Context *) interface->nicContext;
+
+   //Frames sent while a received frame is being processed use a dedicated
+   //burst buffer
+   if(context->rxLock)
+   {
+      burst = lan8651BurstBuffer[1];
+   }
+   else
+   {
+      burst = lan8651BurstBuffer[0];
+   }
+
+   //Number of bytes sent so far
+   i = 0;
+
+   //A frame longer than the burst size spans several bursts
+   do
+   {
+      //Number of transmit data chunks in the current burst
+      m = (length - i + LAN8651_CHUNK_PAYLOAD_SIZE - 1) /
+         LAN8651_CHUNK_PAYLOAD_SIZE;
+
+      //Receive data are not accepted while processing a received frame, nor
+      //before the last burst of a frame (a frame sent from the receive path
+      //would otherwise be interleaved with the current one)
+      if(!context->rxLock && m <= LAN8651_MAX_BURST_CHUNKS)
+      {
+         rxEnable = TRUE;
+      }
+      else
+      {
+         rxEnable = FALSE;
+      }
+
+      //Total number of data chunks in the current burst
+      if(rxEnable)
+      {
+         k = MAX(m, context->rxChunks);
+      }
+      else
+      {
+         k = m;
+      }
+
+      //At least one chunk is required to retrieve the current footer
+      k = MAX(k, 1);
+      k = MIN(k, LAN8651_MAX_BURST_CHUNKS);
+
+      //Format data chunks
+      for(j = 0; j < k; j++)
+      {
+         //Point to the current data chunk
+         p = burst + j * (LAN8651_CHUNK_PAYLOAD_SIZE + 4);
+
+         //Any data left to send?
+         if(i < length)
+         {
+            //The default size of the data chunk payload is 64 bytes
+            n = MIN(length - i, LAN8651_CHUNK_PAYLOAD_SIZE);
+
+            //Set up a data transfer
+            header = LAN8651_TX_HEADER_DNC | LAN8651_TX_HEADER_DV;
+
+            //Start of packet?
+            if(i == 0)
+            {
+               header |= LAN8651_TX_HEADER_SV;
+            }
+
+            //End of packet?
+            if((i + n) == length)
+            {
+               //The EBO field points to the last byte of the Ethernet frame
+               header |= LAN8651_TX_HEADER_EV;
+               header |= ((n - 1) << 8) & LAN8651_TX_HEADER_EBO;
+            }
+
+            //Copy data chunk payload
+            netBufferRead(p + 4, buffer, offset + i, n);
+
+            //Pad frames shorter than the data chunk payload
+            if(n < LAN8651_CHUNK_PAYLOAD_SIZE)
+            {
+               osMemset(p + 4 + n, 0, LAN8651_CHUNK_PAYLOAD_SIZE - n);
+            }
+
+            //Advance data pointer
+            i += n;
+         }
+         else
+         {
+            //Receive-only data chunk
+            header = LAN8651_TX_HEADER_DNC;
+
+            //Clear data chunk payload
+            osMemset(p + 4, 0, LAN8651_CHUNK_PAYLOAD_SIZE);
+         }
+
+         //The NORX bit prevents the MAC-PHY from sending receive data
+         if(!rxEnable)
+         {
+            header |= LAN8651_TX_HEADER_NORX;
+         }
+
+         //The parity bit is calculated over the transmit data header
+         if(lan8651CalcParity(header) != 0)
+         {
+            header |= LAN8651_CTRL_HEADER_P;
+         }
+
+         //Transmit data chunks consist of a 4-byte header followed by the
+         //transmit data chunk payload
+         STORE32BE(header, p);
+      }
+
+      //Pull the CS pin low
+      interface->spiDriver->assertCs();
+
+      //Transfer all the data chunks at once
+      nicSpiTransfer(interface, burst, burst,
+         k * (LAN8651_CHUNK_PAYLOAD_SIZE + 4));
+
+      //Terminate the operation by raising the CS pin
+      interface->spiDriver->deassertCs();
+
+      //Receive data chunks consist of the receive data chunk payload followed
+      //by a 4-byte footer
+      for(j = 0; j < k; j++)
+      {
+         p = burst + j * (LAN8651_CHUNK_PAYLOAD_SIZE + 4);
+         footer[j] = LOAD32BE(p + LAN8651_CHUNK_PAYLOAD_SIZE);
+      }
+
+      //The last footer reflects the state of the MAC-PHY at the end of the
+      //burst
+      if(lan8651CalcParity(footer[k - 1]) == 0)
+      {
+         context->txCredits = (footer[k - 1] & LAN8651_RX_FOOTER_TXC) >> 1;
+         context->rxChunks = (footer[k - 1] & LAN8651_RX_FOOTER_RCA) >> 24;
+      }
+      else
+      {
+         //Force the buffer status register to be read before sending
+         context->txCredits = 0;
+         context->rxChunks = 0;
+      }
+
+      //Process receive data chunks
+      if(rxEnable)
+      {
+         for(j = 0; j < k; j++)
+         {
+            p = burst + j * (LAN8651_CHUNK_PAYLOAD_SIZE + 4);
+            lan8651ProcessRxChunk(interface, p, footer[j]);
+         }
+      }
+
+      //Loop until the whole frame has been sent
+   } while(i < length);
+#endif
+}
+
+
+/**
+ * @brief Process a receive data chunk
+ * @param[in] interface Underlying network interface
+ * @param[in] payload Receive data chunk payload
+ * @param[in] footer Receive data footer
+ **/
+
+void lan8651ProcessRxChunk(NetInterface *interface, const uint8_t *payload,
+   uint32_t footer)
+{
+#if (LAN8651_BURST_SUPPORT == ENABLED)
+   size_t n;
+   Lan8651Context *context;
+   NetRxAncillary ancillary;
+
+   //Point to the driver context
+   context = (Lan8651Context *) interface->nicContext;
+
+   //The parity bit is calculated over the receive data footer
+   if(lan8651CalcParity(footer) != 0)
+   {
+      //Discard the frame being reassembled
+      context->rxActive = FALSE;
+      return;
+   }
+
+   //When the DV bit is 0, the SPI host ignores the chunk payload
+   if((footer & LAN8651_RX_FOOTER_DV) == 0)
+      return;
+
+   //When the SV bit is 1, the beginning of an Ethernet frame is present in
+   //the current receive data chunk payload
+   if((footer & LAN8651_RX_FOOTER_SV) != 0)
+   {
+      //Start reassembling a new frame
+      context->rxLength = 0;
+      context->rxActive = TRUE;
+   }
+   else if(!context->rxActive)
+   {
+      //The beginning of the frame has been lost
+      return;
+   }
+   else
+   {
+      //Continuation of the current frame
+   }
+
+   //When EV is 1, the EBO field contains the byte offset into the
+   //receive data chunk payload that points to the last byte of the
+   //received Ethernet frame
+   if((footer & LAN8651_RX_FOOTER_EV) != 0)
+   {
+      n = ((footer & LAN8651_RX_FOOTER_EBO) >> 8) + 1;
+   }
+   else
+   {
+      n = LAN8651_CHUNK_PAYLOAD_SIZE;
+   }
+
+   //Check the length of the received packet
+   if((context->rxLength + n) > LAN8651_ETH_RX_BUFFER_SIZE)
+   {
+      //Discard the frame
+      context->rxActive = FALSE;
+      return;
+   }
+
+   //Copy data chunk payload
+   osMemcpy(lan8651RxBuffer + context->rxLength, payload, n);
+   //Adjust the length of the packet
+   context->rxLength += n;
+
+   //When the EV bit is 1, the end of an Ethernet frame is present in the
+   //current receive data chunk payload
+   if((footer & LAN8651_RX_FOOTER_EV) != 0)
+   {
+      //The reassembly is complete
+      context->rxActive = FALSE;
+
+      //The FD bit indicates that the frame must be dropped
+      if((footer & LAN8651_RX_FOOTER_FD) == 0)
+      {
+         //Frames sent while processing the packet must not use the burst
+         //buffer that holds the remaining receive data chunks
+         context->rxLock = TRUE;
+
+         //Additional options can be passed to the stack along with the packet
+         ancillary = NET_DEFAULT_RX_ANCILLARY;
+         //Pass the packet to the upper layer
+         nicProcessPacket(interface, lan8651RxBuffer, context->rxLength,
+            &ancillary);
+
+         //Release the lock
+         context->rxLock = FALSE;
+      }
+   }
+#endif
+}
+
+
 /**
  * @brief Configure MAC address filtering
  * @param[in] interface Underlying network interface
@@ -804,6 +1184,7 @@ void lan8651WriteReg(NetInterface *interface, uint8_t mms, uint16_t address,
    uint32_t data)
 {
    uint32_t header;
+   uint8_t buffer[12];
 
    //Set up a register write operation
    header = LAN8651_CTRL_HEADER_WNR | LAN8651_CTRL_HEADER_AID;
@@ -820,26 +1201,18 @@ void lan8651WriteReg(NetInterface *interface, uint8_t mms, uint16_t address,
       header |= LAN8651_CTRL_HEADER_P;
    }
 
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
-
    //Write control command header
-   interface->spiDriver->transfer((header >> 24) & 0xFF);
-   interface->spiDriver->transfer((header >> 16) & 0xFF);
-   interface->spiDriver->transfer((header >> 8) & 0xFF);
-   interface->spiDriver->transfer(header & 0xFF);
-
+   STORE32BE(header, buffer);
    //Write data
-   interface->spiDriver->transfer((data >> 24) & 0xFF);
-   interface->spiDriver->transfer((data >> 16) & 0xFF);
-   interface->spiDriver->transfer((data >> 8) & 0xFF);
-   interface->spiDriver->transfer(data & 0xFF);
-
+   STORE32BE(data, buffer + 4);
    //Send 32 bits of dummy data at the end of the control write command
-   interface->spiDriver->transfer(0x00);
-   interface->spiDriver->transfer(0x00);
-   interface->spiDriver->transfer(0x00);
-   interface->spiDriver->transfer(0x00);
+   STORE32BE(0, buffer + 8);
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -857,8 +1230,8 @@ void lan8651WriteReg(NetInterface *interface, uint8_t mms, uint16_t address,
 uint32_t lan8651ReadReg(NetInterface *interface, uint8_t mms,
    uint16_t address)
 {
-   uint32_t data;
    uint32_t header;
+   uint8_t buffer[12];
 
    //Set up a register read operation
    header = LAN8651_CTRL_HEADER_AID;
@@ -875,32 +1248,22 @@ uint32_t lan8651ReadReg(NetInterface *interface, uint8_t mms,
       header |= LAN8651_CTRL_HEADER_P;
    }
 
+   //Write control command header
+   STORE32BE(header, buffer);
+   //The echoed control header and the register value are clocked out next
+   osMemset(buffer + 4, 0, 8);
+
    //Pull the CS pin low
    interface->spiDriver->assertCs();
 
-   //Write control command header
-   interface->spiDriver->transfer((header >> 24) & 0xFF);
-   interface->spiDriver->transfer((header >> 16) & 0xFF);
-   interface->spiDriver->transfer((header >> 8) & 0xFF);
-   interface->spiDriver->transfer(header & 0xFF);
-
-   //Discard the echoed control header
-   interface->spiDriver->transfer(0x00);
-   interface->spiDriver->transfer(0x00);
-   interface->spiDriver->transfer(0x00);
-   interface->spiDriver->transfer(0x00);
-
-   //Read data
-   data = interface->spiDriver->transfer(0x00) << 24;
-   data |= interface->spiDriver->transfer(0x00) << 16;
-   data |= interface->spiDriver->transfer(0x00) << 8;
-   data |= interface->spiDriver->transfer(0x00);
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, buffer, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
 
-   //Return register value
-   return data;
+   //Discard the echoed control header and return register value
+   return LOAD32BE(buffer + 8);
 }
 
 
@@ -62,6 +62,20 @@
    #error LAN8651_ETH_RX_BUFFER_SIZE parameter is not valid
 #endif
 
+//Burst mode support
+#ifndef LAN8651_BURST_SUPPORT
+   #define LAN8651_BURST_SUPPORT DISABLED
+#elif (LAN8651_BURST_SUPPORT != ENABLED && LAN8651_BURST_SUPPORT != DISABLED)
+   #error LAN8651_BURST_SUPPORT parameter is not valid
+#endif
+
+//Maximum number of data chunks per SPI burst
+#ifndef LAN8651_MAX_BURST_CHUNKS
+   #define LAN8651_MAX_BURST_CHUNKS 24
+#elif (LAN8651_MAX_BURST_CHUNKS < 1 || LAN8651_MAX_BURST_CHUNKS > 31)
+   #error LAN8651_MAX_BURST_CHUNKS parameter is not valid
+#endif
+
 //Chunk payload size
 #define LAN8651_CHUNK_PAYLOAD_SIZE 64
 
@@ -748,6 +762,21 @@
 extern "C" {
 #endif
 
+
+/**
+ * @brief LAN8651 driver context
+ **/
+
+typedef struct
+{
+   uint8_t txCredits; ///<Number of transmit credits reported by the MAC-PHY
+   uint8_t rxChunks;  ///<Number of receive data chunks available
+   uint16_t rxLength; ///<Length of the frame being reassembled
+   bool_t rxActive;   ///<A frame is being reassembled
+   bool_t rxLock;     ///<A received frame is being processed
+} Lan8651Context;
+
+
 //LAN8651 driver
 extern const NicDriver lan8651Driver;
 
@@ -769,6 +798,12 @@ error_t lan8651SendPacket(NetInterface *interface,
 
 error_t lan8651ReceivePacket(NetInterface *interface);
 
+void lan8651TransferChunks(NetInterface *interface, const NetBuffer *buffer,
+   size_t offset, size_t length);
+
+void lan8651ProcessRxChunk(NetInterface *interface, const uint8_t *payload,
+   uint32_t footer);
+
 error_t lan8651UpdateMacAddrFilter(NetInterface *interface);
 
 void lan8651WriteReg(NetInterface *interface, uint8_t mms, uint16_t address,
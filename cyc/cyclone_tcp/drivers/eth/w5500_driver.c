@@ -526,19 +526,23 @@ error_t w5500UpdateMacAddrFilter(NetInterface *interface)
 void w5500WriteReg8(NetInterface *interface, uint8_t control,
    uint16_t address, uint8_t data)
 {
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[4];
 
    //Address phase
-   interface->spiDriver->transfer(MSB(address));
-   interface->spiDriver->transfer(LSB(address));
+   buffer[0] = MSB(address);
+   buffer[1] = LSB(address);
 
    //Control phase
-   interface->spiDriver->transfer(control | W5500_CTRL_RWB_WRITE |
-      W5500_CTRL_OM_FDM1);
+   buffer[2] = control | W5500_CTRL_RWB_WRITE | W5500_CTRL_OM_FDM1;
 
    //Data phase
-   interface->spiDriver->transfer(data);
+   buffer[3] = data;
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -556,27 +560,29 @@ void w5500WriteReg8(NetInterface *interface, uint8_t control,
 uint8_t w5500ReadReg8(NetInterface *interface, uint8_t control,
    uint16_t address)
 {
-   uint8_t data;
-
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[4];
 
    //Address phase
-   interface->spiDriver->transfer(MSB(address));
-   interface->spiDriver->transfer(LSB(address));
+   buffer[0] = MSB(address);
+   buffer[1] = LSB(address);
 
    //Control phase
-   interface->spiDriver->transfer(control | W5500_CTRL_RWB_READ |
-      W5500_CTRL_OM_FDM1);
+   buffer[2] = control | W5500_CTRL_RWB_READ | W5500_CTRL_OM_FDM1;
 
    //Data phase
-   data = interface->spiDriver->transfer(0x00);
+   buffer[3] = 0x00;
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, buffer, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
 
    //Return register value
-   return data;
+   return buffer[3];
 }
 
 
@@ -591,20 +597,24 @@ uint8_t w5500ReadReg8(NetInterface *interface, uint8_t control,
 void w5500WriteReg16(NetInterface *interface, uint8_t control,
    uint16_t address, uint16_t data)
 {
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[5];
 
    //Address phase
-   interface->spiDriver->transfer(MSB(address));
-   interface->spiDriver->transfer(LSB(address));
+   buffer[0] = MSB(address);
+   buffer[1] = LSB(address);
 
    //Control phase
-   interface->spiDriver->transfer(control | W5500_CTRL_RWB_WRITE |
-      W5500_CTRL_OM_FDM2);
+   buffer[2] = control | W5500_CTRL_RWB_WRITE | W5500_CTRL_OM_FDM2;
 
    //Data phase
-   interface->spiDriver->transfer(MSB(data));
-   interface->spiDriver->transfer(LSB(data));
+   buffer[3] = MSB(data);
+   buffer[4] = LSB(data);
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -622,28 +632,30 @@ void w5500WriteReg16(NetInterface *interface, uint8_t control,
 uint16_t w5500ReadReg16(NetInterface *interface, uint8_t control,
    uint16_t address)
 {
-   uint16_t data;
-
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[5];
 
    //Address phase
-   interface->spiDriver->transfer(MSB(address));
-   interface->spiDriver->transfer(LSB(address));
+   buffer[0] = MSB(address);
+   buffer[1] = LSB(address);
 
    //Control phase
-   interface->spiDriver->transfer(control | W5500_CTRL_RWB_READ |
-      W5500_CTRL_OM_FDM2);
+   buffer[2] = control | W5500_CTRL_RWB_READ | W5500_CTRL_OM_FDM2;
 
    //Data phase
-   data = interface->spiDriver->transfer(0x00) << 8;
-   data |= interface->spiDriver->transfer(0x00);
+   buffer[3] = 0x00;
+   buffer[4] = 0x00;
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Perform data transfer
+   nicSpiTransfer(interface, buffer, buffer, sizeof(buffer));
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
 
    //Return register value
-   return data;
+   return (buffer[3] << 8) | buffer[4];
 }
 
 
@@ -659,24 +671,23 @@ uint16_t w5500ReadReg16(NetInterface *interface, uint8_t control,
 void w5500WriteBuffer(NetInterface *interface, uint8_t control,
    uint16_t address, const uint8_t *data, size_t length)
 {
-   size_t i;
-
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[3];
 
    //Address phase
-   interface->spiDriver->transfer(MSB(address));
-   interface->spiDriver->transfer(LSB(address));
+   buffer[0] = MSB(address);
+   buffer[1] = LSB(address);
 
    //Control phase
-   interface->spiDriver->transfer(control | W5500_CTRL_RWB_WRITE |
-      W5500_CTRL_OM_VDM);
+   buffer[2] = control | W5500_CTRL_RWB_WRITE | W5500_CTRL_OM_VDM;
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Write address and control bytes
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Data phase
-   for(i = 0; i < length; i++)
-   {
-      interface->spiDriver->transfer(data[i]);
-   }
+   nicSpiTransfer(interface, data, NULL, length);
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -695,24 +706,23 @@ void w5500WriteBuffer(NetInterface *interface, uint8_t control,
 void w5500ReadBuffer(NetInterface *interface, uint8_t control,
    uint16_t address, uint8_t *data, size_t length)
 {
-   size_t i;
-
-   //Pull the CS pin low
-   interface->spiDriver->assertCs();
+   uint8_t buffer[3];
 
    //Address phase
-   interface->spiDriver->transfer(MSB(address));
-   interface->spiDriver->transfer(LSB(address));
+   buffer[0] = MSB(address);
+   buffer[1] = LSB(address);
 
    //Control phase
-   interface->spiDriver->transfer(control | W5500_CTRL_RWB_READ |
-      W5500_CTRL_OM_VDM);
+   buffer[2] = control | W5500_CTRL_RWB_READ | W5500_CTRL_OM_VDM;
+
+   //Pull the CS pin low
+   interface->spiDriver->assertCs();
+
+   //Write address and control bytes
+   nicSpiTransfer(interface, buffer, NULL, sizeof(buffer));
 
    //Data phase
-   for(i = 0; i < length; i++)
-   {
-      data[i] = interface->spiDriver->transfer(0x00);
-   }
+   nicSpiTransfer(interface, NULL, data, length);
 
    //Terminate the operation by raising the CS pin
    interface->spiDriver->deassertCs();
@@ -0,0 +1,556 @@
+/**
+ * @file spidev_driver.c
+ * @brief Linux spidev SPI driver
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * The driver queues every transfer issued between assertCs and deassertCs
+ * and submits the whole CS-framed access to the kernel with a single
+ * SPI_IOC_MESSAGE request. Single-byte transfers must return the received
+ * byte immediately, hence they flush the queue while keeping the CS pin
+ * asserted (cs_change flag set on the last transfer of the message)
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL NIC_TRACE_LEVEL
+
+//Dependencies
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/spi/spidev.h>
+#include "core/net.h"
+#include "drivers/spi/spidev_driver.h"
+#include "debug.h"
+
+//Maximum number of bytes per message (default bufsiz of the spidev module)
+#define SPIDEV_DRIVER_MAX_MESSAGE_SIZE 4096
+
+
+/**
+ * @brief spidev driver context
+ **/
+
+typedef struct
+{
+   const char_t *device;
+   int fd;
+   uint8_t mode;
+   uint32_t bitrate;
+   bool_t csHeld;
+   uint_t numTransfers;
+   size_t numBytes;
+   struct spi_ioc_transfer transfers[SPIDEV_DRIVER_MAX_TRANSFERS];
+   uint8_t txData;
+   uint8_t rxData;
+   SpidevMockHandler mockHandler;
+   SpidevStats stats;
+   systime_t startTime;
+} SpidevContext;
+
+
+//spidev driver context
+static SpidevContext spidevContext =
+{
+   SPIDEV_DRIVER_DEVICE,
+   -1
+};
+
+//Forward declaration of functions
+static void spidevQueueTransfer(const uint8_t *txBuffer, uint8_t *rxBuffer,
+   size_t length);
+
+static void spidevFlush(bool_t keepCs);
+
+static error_t spidevSubmit(struct spi_ioc_transfer *transfers, uint_t n);
+
+
+/**
+ * @brief spidev driver
+ **/
+
+const SpiDriver spidevDriver =
+{
+   spidevInit,
+   spidevSetMode,
+   spidevSetBitrate,
+   spidevAssertCs,
+   spidevDeassertCs,
+   spidevTransfer,
+   spidevTransferMultipleBytes
+};
+
+
+/**
+ * @brief Select the spidev device node
+ * @param[in] device Path to the device node (e.g. /dev/spidev1.0)
+ * @return Error code
+ **/
+
+error_t spidevSetDevice(const char_t *device)
+{
+   //Check parameters
+   if(device == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //The device node is opened by spidevInit
+   spidevContext.device = device;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief SPI initialization
+ * @return Error code
+ **/
+
+error_t spidevInit(void)
+{
+   error_t error;
+
+   //Debug message
+   TRACE_INFO("Initializing spidev driver (%s)...\r\n", spidevContext.device);
+
+   //Close the device node if it has already been opened
+   if(spidevContext.fd >= 0)
+   {
+      close(spidevContext.fd);
+      spidevContext.fd = -1;
+   }
+
+#if (SPIDEV_DRIVER_MOCK_SUPPORT == DISABLED)
+   //Open the device node
+   spidevContext.fd = open(spidevContext.device, O_RDWR);
+
+   //Failed to open device?
+   if(spidevContext.fd < 0)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to open %s!\r\n", spidevContext.device);
+      //Report an error
+      return ERROR_OPEN_FAILED;
+   }
+#endif
+
+   //Flush the transfer queue
+   spidevContext.csHeld = FALSE;
+   spidevContext.numTransfers = 0;
+   spidevContext.numBytes = 0;
+
+   //Configure SPI mode
+   error = spidevSetMode(SPIDEV_DRIVER_MODE);
+
+   //Check status code
+   if(!error)
+   {
+      //Configure SPI bitrate
+      error = spidevSetBitrate(SPIDEV_DRIVER_BITRATE);
+   }
+
+   //Clear statistics
+   spidevResetStats();
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Set SPI mode
+ * @param[in] mode SPI mode (0, 1, 2 or 3)
+ * @return Error code
+ **/
+
+error_t spidevSetMode(uint_t mode)
+{
+   //Check parameter
+   if(mode > 3)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save SPI mode
+   spidevContext.mode = (uint8_t) mode;
+
+#if (SPIDEV_DRIVER_MOCK_SUPPORT == DISABLED)
+   //Configure clock polarity and phase
+   if(ioctl(spidevContext.fd, SPI_IOC_WR_MODE, &spidevContext.mode) < 0)
+      return ERROR_FAILURE;
+#endif
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Set SPI bitrate
+ * @param[in] bitrate Bitrate value
+ * @return Error code
+ **/
+
+error_t spidevSetBitrate(uint_t bitrate)
+{
+   //Check parameter
+   if(bitrate == 0)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save SPI bitrate
+   spidevContext.bitrate = bitrate;
+
+#if (SPIDEV_DRIVER_MOCK_SUPPORT == DISABLED)
+   //Configure the maximum clock frequency
+   if(ioctl(spidevContext.fd, SPI_IOC_WR_MAX_SPEED_HZ,
+      &spidevContext.bitrate) < 0)
+   {
+      return ERROR_FAILURE;
+   }
+#endif
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Assert CS
+ **/
+
+void spidevAssertCs(void)
+{
+   //The CS pin is physically asserted when the first message is submitted
+   spidevContext.numTransfers = 0;
+   spidevContext.numBytes = 0;
+}
+
+
+/**
+ * @brief Deassert CS
+ **/
+
+void spidevDeassertCs(void)
+{
+   //Submit the whole transaction and release the CS pin
+   spidevFlush(FALSE);
+
+   //Update statistics
+   spidevContext.stats.transactions++;
+}
+
+
+/**
+ * @brief Transfer a single byte
+ * @param[in] data The data to be written
+ * @return The data received from the slave device
+ **/
+
+uint8_t spidevTransfer(uint8_t data)
+{
+   //Queue the byte behind the pending transfers
+   spidevContext.txData = data;
+   spidevQueueTransfer(&spidevContext.txData, &spidevContext.rxData, 1);
+
+   //The received byte must be returned to the caller, so the queue cannot
+   //be held any longer
+   spidevFlush(TRUE);
+
+   //Return the received byte
+   return spidevContext.rxData;
+}
+
+
+/**
+ * @brief Transfer multiple bytes
+ *
+ * The transfer is queued until the CS pin is deasserted. Both buffers must
+ * remain valid until then
+ *
+ * @param[in] txBuffer Data to be transmitted (may be NULL)
+ * @param[out] rxBuffer Buffer where to store the incoming data (may be NULL)
+ * @param[in] length Number of bytes to transfer
+ **/
+
+void spidevTransferMultipleBytes(const uint8_t *txBuffer, uint8_t *rxBuffer,
+   size_t length)
+{
+   size_t n;
+
+   //Large blocks are split to fit in the spidev bounce buffer
+   while(length > 0)
+   {
+      //Limit the number of bytes to queue at a time
+      n = MIN(length, SPIDEV_DRIVER_MAX_MESSAGE_SIZE);
+
+      //Queue the current block
+      spidevQueueTransfer(txBuffer, rxBuffer, n);
+
+      //Advance data pointers
+      if(txBuffer != NULL)
+      {
+         txBuffer += n;
+      }
+
+      if(rxBuffer != NULL)
+      {
+         rxBuffer += n;
+      }
+
+      //Remaining bytes to process
+      length -= n;
+   }
+}
+
+
+/**
+ * @brief Get driver statistics
+ * @param[out] stats Pointer to the structure that receives the statistics
+ **/
+
+void spidevGetStats(SpidevStats *stats)
+{
+   //Copy counters
+   *stats = spidevContext.stats;
+
+   //Time elapsed since the counters were cleared
+   stats->elapsedTime = osGetSystemTime() - spidevContext.startTime;
+
+   //Calculate the number of transactions per second
+   if(stats->elapsedTime > 0)
+   {
+      stats->transactionRate = (uint32_t) (((uint64_t) stats->transactions *
+         1000) / stats->elapsedTime);
+   }
+   else
+   {
+      stats->transactionRate = 0;
+   }
+}
+
+
+/**
+ * @brief Clear driver statistics
+ **/
+
+void spidevResetStats(void)
+{
+   //Clear counters
+   osMemset(&spidevContext.stats, 0, sizeof(SpidevStats));
+   //Restart measurement period
+   spidevContext.startTime = osGetSystemTime();
+}
+
+
+/**
+ * @brief Dump driver statistics
+ **/
+
+void spidevDumpStats(void)
+{
+   SpidevStats stats;
+
+   //Retrieve statistics
+   spidevGetStats(&stats);
+
+   //Debug message
+   TRACE_INFO("spidev statistics (%" PRIu32 " ms):\r\n",
+      (uint32_t) stats.elapsedTime);
+   TRACE_INFO("  Transactions = %" PRIu32 " (%" PRIu32 "/s)\r\n",
+      stats.transactions, stats.transactionRate);
+   TRACE_INFO("  Messages = %" PRIu32 "\r\n", stats.messages);
+   TRACE_INFO("  Transfers = %" PRIu32 "\r\n", stats.transfers);
+   TRACE_INFO("  Bytes = %" PRIu32 "\r\n", stats.bytes);
+   TRACE_INFO("  Errors = %" PRIu32 "\r\n", stats.errors);
+}
+
+
+/**
+ * @brief Register mock device callback
+ *
+ * When no callback is registered, the mock backend behaves as a loopback
+ * device (MOSI wired to MISO)
+ *
+ * @param[in] handler Mock device callback
+ **/
+
+void spidevRegisterMockHandler(SpidevMockHandler handler)
+{
+   //Save callback function
+   spidevContext.mockHandler = handler;
+}
+
+
+/**
+ * @brief Append a transfer to the current message
+ * @param[in] txBuffer Data to be transmitted (may be NULL)
+ * @param[out] rxBuffer Buffer where to store the incoming data (may be NULL)
+ * @param[in] length Number of bytes to transfer
+ **/
+
+static void spidevQueueTransfer(const uint8_t *txBuffer, uint8_t *rxBuffer,
+   size_t length)
+{
+   struct spi_ioc_transfer *transfer;
+
+   //Submit the pending transfers if the message cannot accommodate the
+   //new one (the CS pin is kept asserted)
+   if(spidevContext.numTransfers >= SPIDEV_DRIVER_MAX_TRANSFERS ||
+      (spidevContext.numBytes + length) > SPIDEV_DRIVER_MAX_MESSAGE_SIZE)
+   {
+      spidevFlush(TRUE);
+   }
+
+   //Point to the next free transfer descriptor
+   transfer = &spidevContext.transfers[spidevContext.numTransfers];
+   osMemset(transfer, 0, sizeof(struct spi_ioc_transfer));
+
+   //Null buffers are allowed. Zeros are shifted out when no transmit
+   //buffer is provided
+   transfer->tx_buf = (uintptr_t) txBuffer;
+   transfer->rx_buf = (uintptr_t) rxBuffer;
+   transfer->len = length;
+   transfer->speed_hz = spidevContext.bitrate;
+   transfer->bits_per_word = 8;
+
+   //Update the length of the message
+   spidevContext.numTransfers++;
+   spidevContext.numBytes += length;
+
+   //Update statistics
+   spidevContext.stats.transfers++;
+   spidevContext.stats.bytes += length;
+}
+
+
+/**
+ * @brief Submit the pending transfers
+ * @param[in] keepCs Keep the CS pin asserted at the end of the message
+ **/
+
+static void spidevFlush(bool_t keepCs)
+{
+   error_t error;
+   uint_t n;
+
+   //Retrieve the number of pending transfers
+   n = spidevContext.numTransfers;
+
+   //Empty queue?
+   if(n == 0)
+   {
+      //Nothing to do if the CS pin is not held by a previous message
+      if(keepCs || !spidevContext.csHeld)
+         return;
+
+      //A zero-length transfer is used to raise the CS pin
+      osMemset(&spidevContext.transfers[0], 0, sizeof(struct spi_ioc_transfer));
+      spidevContext.transfers[0].speed_hz = spidevContext.bitrate;
+      spidevContext.transfers[0].bits_per_word = 8;
+      n = 1;
+   }
+
+   //When set on the last transfer of a message, the cs_change flag leaves
+   //the CS pin asserted after the message completes
+   spidevContext.transfers[n - 1].cs_change = keepCs ? 1 : 0;
+
+   //Submit the message
+   error = spidevSubmit(spidevContext.transfers, n);
+
+   //Update statistics
+   spidevContext.stats.messages++;
+
+   //Check status code
+   if(error)
+   {
+      spidevContext.stats.errors++;
+   }
+
+   //The queue is now empty
+   spidevContext.numTransfers = 0;
+   spidevContext.numBytes = 0;
+   spidevContext.csHeld = keepCs;
+}
+
+
+/**
+ * @brief Execute a message on the SPI bus
+ * @param[in] transfers Array of transfers forming the message
+ * @param[in] n Number of transfers
+ * @return Error code
+ **/
+
+static error_t spidevSubmit(struct spi_ioc_transfer *transfers, uint_t n)
+{
+#if (SPIDEV_DRIVER_MOCK_SUPPORT == ENABLED)
+   uint_t i;
+   bool_t endOfFrame;
+   const uint8_t *txBuffer;
+   uint8_t *rxBuffer;
+
+   //Loop through the transfers
+   for(i = 0; i < n; i++)
+   {
+      //Point to the buffers
+      txBuffer = (const uint8_t *) (uintptr_t) transfers[i].tx_buf;
+      rxBuffer = (uint8_t *) (uintptr_t) transfers[i].rx_buf;
+
+      //The CS pin is raised after the last transfer unless cs_change is set
+      endOfFrame = (i == (n - 1) && !transfers[i].cs_change) ? TRUE : FALSE;
+
+      //Any registered device?
+      if(spidevContext.mockHandler != NULL)
+      {
+         //Let the mock device process the transfer
+         spidevContext.mockHandler(txBuffer, rxBuffer, transfers[i].len,
+            endOfFrame);
+      }
+      else if(rxBuffer != NULL)
+      {
+         //Loopback mode (MOSI wired to MISO)
+         if(txBuffer != NULL)
+         {
+            osMemmove(rxBuffer, txBuffer, transfers[i].len);
+         }
+         else
+         {
+            osMemset(rxBuffer, 0, transfers[i].len);
+         }
+      }
+   }
+
+   //Successful processing
+   return NO_ERROR;
+#else
+   int ret;
+
+   //Send the whole message with a single system call
+   ret = ioctl(spidevContext.fd, SPI_IOC_MESSAGE(n), transfers);
+
+   //Return status code
+   return (ret < 0) ? ERROR_FAILURE : NO_ERROR;
+#endif
+}
@@ -0,0 +1,131 @@
+/**
+ * @file spidev_driver.h
+ * @brief Linux spidev SPI driver
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+#ifndef _SPIDEV_DRIVER_H
+#define _SPIDEV_DRIVER_H
+
+//Dependencies
+#include "core/nic.h"
+
+//Default spidev device node
+#ifndef SPIDEV_DRIVER_DEVICE
+   #define SPIDEV_DRIVER_DEVICE "/dev/spidev0.0"
+#endif
+
+//Default SPI mode
+#ifndef SPIDEV_DRIVER_MODE
+   #define SPIDEV_DRIVER_MODE 0
+#elif (SPIDEV_DRIVER_MODE < 0 || SPIDEV_DRIVER_MODE > 3)
+   #error SPIDEV_DRIVER_MODE parameter is not valid
+#endif
+
+//Default SPI bitrate
+#ifndef SPIDEV_DRIVER_BITRATE
+   #define SPIDEV_DRIVER_BITRATE 10000000
+#elif (SPIDEV_DRIVER_BITRATE < 1)
+   #error SPIDEV_DRIVER_BITRATE parameter is not valid
+#endif
+
+//Maximum number of transfers that can be queued within a single message
+#ifndef SPIDEV_DRIVER_MAX_TRANSFERS
+   #define SPIDEV_DRIVER_MAX_TRANSFERS 16
+#elif (SPIDEV_DRIVER_MAX_TRANSFERS < 2)
+   #error SPIDEV_DRIVER_MAX_TRANSFERS parameter is not valid
+#endif
+
+//Mock backend (off-target testing without any spidev device)
+#ifndef SPIDEV_DRIVER_MOCK_SUPPORT
+   #define SPIDEV_DRIVER_MOCK_SUPPORT DISABLED
+#elif (SPIDEV_DRIVER_MOCK_SUPPORT != ENABLED && SPIDEV_DRIVER_MOCK_SUPPORT != DISABLED)
+   #error SPIDEV_DRIVER_MOCK_SUPPORT parameter is not valid
+#endif
+
+//C++ guard
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Mock device callback
+ *
+ * Invoked once per transfer. txBuffer is NULL when dummy bytes are clocked
+ * out and rxBuffer is NULL when the incoming data are discarded. The last
+ * parameter is set when the CS pin is raised at the end of the transfer
+ **/
+
+typedef void (*SpidevMockHandler)(const uint8_t *txBuffer, uint8_t *rxBuffer,
+   size_t length, bool_t endOfFrame);
+
+
+/**
+ * @brief spidev driver statistics
+ **/
+
+typedef struct
+{
+   uint32_t transactions;    ///<Number of CS-framed transactions
+   uint32_t messages;        ///<Number of SPI_IOC_MESSAGE requests
+   uint32_t transfers;       ///<Number of queued transfers
+   uint32_t bytes;           ///<Number of bytes exchanged on the bus
+   uint32_t errors;          ///<Number of failed requests
+   systime_t elapsedTime;    ///<Time elapsed since the last reset (ms)
+   uint32_t transactionRate; ///<Transactions per second
+} SpidevStats;
+
+
+//spidev driver
+extern const SpiDriver spidevDriver;
+
+//spidev related functions
+error_t spidevSetDevice(const char_t *device);
+
+error_t spidevInit(void);
+error_t spidevSetMode(uint_t mode);
+error_t spidevSetBitrate(uint_t bitrate);
+void spidevAssertCs(void);
+void spidevDeassertCs(void);
+uint8_t spidevTransfer(uint8_t data);
+
+void spidevTransferMultipleBytes(const uint8_t *txBuffer, uint8_t *rxBuffer,
+   size_t length);
+
+void spidevGetStats(SpidevStats *stats);
+void spidevResetStats(void);
+void spidevDumpStats(void);
+
+void spidevRegisterMockHandler(SpidevMockHandler handler);
+
+//C++ guard
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -94,6 +94,7 @@ void rndisInit(void)
    rndisContext.txState = FALSE;
    rndisContext.rxState = FALSE;
    rndisContext.packetFilter = 0;
+   rndisContext.maxTransferSize = 0;
    rndisContext.rxBufferLen = 0;
    rndisContext.encapsulatedRespLen = 0;
    rndisContext.CmdOpCode = 0;
@@ -175,6 +176,10 @@ error_t rndisProcessInitializeMsg(const RndisInitializeMsg *message, size_t leng
    //Debug message
    TRACE_DEBUG("RNDIS Initialize message received (%" PRIuSIZE " bytes)...\r\n", length);
 
+   //The host specifies the maximum size of a transfer it can accept. Several
+   //RNDIS Packet messages may be concatenated up to this limit
+   rndisContext.maxTransferSize = message->maxTransferSize;
+
    //Format the response to the Initialize message
    rndisFormatInitializeCmplt(message->requestId);
 
@@ -540,8 +545,12 @@ error_t rndisFormatInitializeCmplt(uint32_t requestId)
    message->minorVersion = RNDIS_MINOR_VERSION;
    message->deviceFlags = RNDIS_DF_CONNECTIONLESS;
    message->medium = RNDIS_MEDIUM_802_3;
-   message->maxPacketsPerTransfer = 1;
-   message->maxTransferSize = RNDIS_MAX_TRANSFER_SIZE;
+   message->maxPacketsPerTransfer = RNDIS_MAX_PACKETS_PER_TRANSFER;
+   //The host may concatenate several RNDIS Packet messages in a single
+   //DATA OUT transfer. The whole transfer must fit in one RX buffer, so
+   //the RX buffer size is advertised rather than RNDIS_MAX_TRANSFER_SIZE,
+   //which only sizes the control channel buffers
+   message->maxTransferSize = RNDIS_RX_BUFFER_SIZE;
    message->packetAlignmentFactor = 0;
    message->afListOffset = 0;
    message->afListSize = 0;
@@ -470,6 +470,7 @@ typedef struct
    bool_t txState;
    bool_t rxState;
    uint32_t packetFilter;
+   uint32_t maxTransferSize;
    uint8_t rxBuffer[RNDIS_MAX_TRANSFER_SIZE];
    size_t rxBufferLen;
    uint8_t encapsulatedResp[RNDIS_MAX_TRANSFER_SIZE];
@@ -53,6 +53,9 @@ uint_t rndisTxReadIndex;
 uint_t rndisRxWriteIndex;
 uint_t rndisRxReadIndex;
 
+//TX flush timer
+uint_t rndisTxFlushTimer;
+
 
 /**
  * @brief RNDIS driver
@@ -102,6 +105,7 @@ error_t rndisDriverInit(NetInterface *interface)
    rndisTxReadIndex = 0;
    rndisRxWriteIndex = 0;
    rndisRxReadIndex = 0;
+   rndisTxFlushTimer = 0;
 
    //The RNDIS driver is now ready to send
    osSetEvent(&interface->nicTxEvent);
@@ -120,14 +124,22 @@ error_t rndisDriverInit(NetInterface *interface)
  * @brief RNDIS driver timer handler
  *
  * This routine is periodically called by the TCP/IP stack to handle periodic
- * operations such as polling the link state
+ * operations such as polling the link state. nicTick masks the OTG_FS
+ * interrupt around the call, so the TX buffers can be accessed safely
  *
  * @param[in] interface Underlying network interface
  **/
 
 void rndisDriverTick(NetInterface *interface)
 {
-   //Not implemented
+#if (RNDIS_TX_FLUSH_DELAY > 0)
+   //Make sure no packet remains stuck if SOF interrupts are not enabled
+   if(!rndisContext.txState)
+   {
+      rndisDriverCloseTxBuffer();
+      rndisDriverStartTx();
+   }
+#endif
 }
 
 
@@ -216,6 +228,11 @@ void rndisDriverEventHandler(NetInterface *interface)
 
 /**
  * @brief Send a packet
+ *
+ * Consecutive packets are concatenated into the same USB transfer as long as
+ * the DATA IN endpoint is busy, the negotiated maximum transfer size is not
+ * exceeded and RNDIS_MAX_PACKETS_PER_TRANSFER is not reached
+ *
  * @param[in] interface Underlying network interface
  * @param[in] buffer Multi-part buffer containing the data to send
  * @param[in] offset Offset to the first data byte
@@ -227,14 +244,21 @@ void rndisDriverEventHandler(NetInterface *interface)
 error_t rndisDriverSendPacket(NetInterface *interface,
    const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
 {
+   size_t n;
    size_t length;
+   size_t maxTransferSize;
    RndisPacketMsg *message;
+   RndisTxBufferDesc *txBufferDesc;
 
    //Retrieve the length of the packet
    length = netBufferGetLength(buffer) - offset;
 
-   //Check the frame length
-   if((length + sizeof(RndisPacketMsg)) > RNDIS_TX_BUFFER_SIZE)
+   //Each RNDIS Packet message is padded to a 4-byte boundary
+   n = (sizeof(RndisPacketMsg) + length + 3) & ~3U;
+
+   //Check the frame length (one extra byte may be required to avoid sending
+   //a zero-length packet)
+   if((n + 1) > RNDIS_TX_BUFFER_SIZE)
    {
       //The transmitter can accept another packet
       osSetEvent(&interface->nicTxEvent);
@@ -242,16 +266,37 @@ error_t rndisDriverSendPacket(NetInterface *interface,
       return ERROR_INVALID_LENGTH;
    }
 
+   //Retrieve the maximum size of a transfer the host can accept
+   maxTransferSize = rndisDriverGetMaxTransferSize();
+
+   //Point to the buffer currently being filled
+   txBufferDesc = &rndisTxBuffer[rndisTxWriteIndex];
+
+   //Make sure the message fits in the current buffer
+   if(!txBufferDesc->ready && txBufferDesc->length > 0 &&
+      (txBufferDesc->length + n + 1) > maxTransferSize)
+   {
+      //Hand over the pending packets to the USB engine
+      rndisDriverCloseTxBuffer();
+      //Point to the next buffer
+      txBufferDesc = &rndisTxBuffer[rndisTxWriteIndex];
+   }
+
    //Make sure the current buffer is available for writing
-   if(rndisTxBuffer[rndisTxWriteIndex].ready)
+   if(txBufferDesc->ready)
+   {
+      //Start transmitting data if necessary
+      rndisDriverStartTx();
+      //Report an error
       return ERROR_FAILURE;
+   }
 
    //Point to the buffer where to format the RNDIS Packet message
-   message = (RndisPacketMsg *) rndisTxBuffer[rndisTxWriteIndex].data;
+   message = (RndisPacketMsg *) (txBufferDesc->data + txBufferDesc->length);
 
    //Format the RNDIS Packet message
    message->messageType = RNDIS_PACKET_MSG;
-   message->messageLength = sizeof(RndisPacketMsg) + length;
+   message->messageLength = n;
    message->dataOffset = sizeof(RndisPacketMsg) - 8;
    message->dataLength = length;
    message->oobDataOffset = 0;
@@ -265,48 +310,47 @@ error_t rndisDriverSendPacket(NetInterface *interface,
    //Copy user data to the transmit buffer
    netBufferRead(message->payload, buffer, offset, length);
 
+   //Clear padding bytes
+   osMemset(message->payload + length, 0, n - sizeof(RndisPacketMsg) - length);
+
    //Debug message
    TRACE_DEBUG("Sending RNDIS Packet message (%" PRIuSIZE " bytes)...\r\n",
       message->messageLength);
    //Dump RNDIS Packet message contents
    rndisDumpMsg((RndisMsg *) message, message->messageLength);
 
-   //Check whether the RNDIS Packet message ends with a USB packet whose
-   //length is exactly the wMaxPacketSize for the DATA IN endpoint
-   if((message->messageLength % RNDIS_DATA_IN_EP_MPS_FS) == 0)
+   //Append the message to the current buffer
+   txBufferDesc->lastMsgOffset = txBufferDesc->length;
+   txBufferDesc->length += n;
+   txBufferDesc->numPackets++;
+
+   //Check whether the buffer can hold another message
+   if(txBufferDesc->numPackets >= RNDIS_MAX_PACKETS_PER_TRANSFER ||
+      (txBufferDesc->length + sizeof(RndisPacketMsg) + 4 + 1) > maxTransferSize)
    {
-      //The device may send an additional one-byte zero packet
-      message->payload[length] = 0;
-      message->messageLength++;
+      //The buffer is full
+      rndisDriverCloseTxBuffer();
    }
-
-   //Set the number of bytes to send
-   rndisTxBuffer[rndisTxWriteIndex].length = message->messageLength;
-
-   //Give the ownership of the buffer to the USB engine
-   rndisTxBuffer[rndisTxWriteIndex].ready = TRUE;
-
-   //Debug message
-   TRACE_DEBUG("########## Sending DATA IN\r\n");
-
-   //Transmission is currently suspended?
-   if(!rndisContext.txState)
+   else if(!rndisContext.txState && RNDIS_TX_FLUSH_DELAY == 0)
    {
-      //Start transmitting data
-      USBD_LL_Transmit(&USBD_Device, RNDIS_DATA_IN_EP,
-         rndisTxBuffer[rndisTxReadIndex].data,
-         rndisTxBuffer[rndisTxReadIndex].length);
-
-      //Transmission is active
-      rndisContext.txState = TRUE;
+      //The DATA IN endpoint is idle, so there is no point in waiting
+      rndisDriverCloseTxBuffer();
+   }
+   else
+   {
+      //The pending packets will be sent as soon as the current transfer
+      //completes or the flush timer elapses
+      if(txBufferDesc->numPackets == 1)
+      {
+         rndisTxFlushTimer = 0;
+      }
    }
 
-   //Increment index and wrap around if necessary
-   if(++rndisTxWriteIndex >= RNDIS_TX_BUFFER_COUNT)
-      rndisTxWriteIndex = 0;
+   //Start transmitting data if necessary
+   rndisDriverStartTx();
 
-   //Check whether the next buffer is available for writing
-   if(!rndisTxBuffer[rndisTxWriteIndex].ready)
+   //Check whether the transmitter can accept another packet
+   if(rndisDriverTxReady())
    {
       //The transmitter can accept another packet
       osSetEvent(&interface->nicTxEvent);
@@ -319,6 +363,10 @@ error_t rndisDriverSendPacket(NetInterface *interface,
 
 /**
  * @brief Receive a packet
+ *
+ * A single USB transfer may carry several concatenated RNDIS Packet messages.
+ * The receive buffer is released once all the messages have been processed
+ *
  * @param[in] interface Underlying network interface
  * @param[out] buffer Buffer where to store the incoming data
  * @param[in] size Maximum number of bytes that can be received
@@ -332,27 +380,39 @@ error_t rndisDriverReceivePacket(NetInterface *interface,
    error_t error;
    size_t n;
    RndisPacketMsg *message;
+   RndisRxBufferDesc *rxBufferDesc;
+
+   //Point to the current buffer descriptor
+   rxBufferDesc = &rndisRxBuffer[rndisRxReadIndex];
 
    //Check whether the current buffer is available for reading
-   if(rndisRxBuffer[rndisRxReadIndex].ready)
+   if(rxBufferDesc->ready)
    {
-      //Retrieve the length of the RNDIS Packet message
-      n = rndisRxBuffer[rndisRxReadIndex].length;
+      //Number of bytes left in the buffer
+      n = rxBufferDesc->length - rxBufferDesc->offset;
 
       //Check the length of message
-      if(n >= sizeof(RndisPacketMsg))
+      if(rxBufferDesc->offset < rxBufferDesc->length &&
+         n >= sizeof(RndisPacketMsg))
       {
-         //Point to the RNDIS Packet message
-         message = (RndisPacketMsg *) rndisRxBuffer[rndisRxReadIndex].data;
+         //Point to the next RNDIS Packet message
+         message = (RndisPacketMsg *) (rxBufferDesc->data + rxBufferDesc->offset);
 
          //Make sure the message is valid
-         if((message->dataOffset + message->dataLength) <= n)
+         if(message->messageType == RNDIS_PACKET_MSG &&
+            message->messageLength >= sizeof(RndisPacketMsg) &&
+            message->messageLength <= n &&
+            (message->dataOffset + 8) <= message->messageLength &&
+            message->dataLength <= (message->messageLength - message->dataOffset - 8))
          {
             //Limit the number of data to read
             n = MIN(message->dataLength, size);
             //Copy data from the receive buffer
             osMemcpy(buffer, (uint8_t *) message + message->dataOffset + 8, n);
 
+            //Point to the next message
+            rxBufferDesc->offset += message->messageLength;
+
             //Total number of bytes that have been received
             *length = n;
             //Packet successfully received
@@ -360,37 +420,46 @@ error_t rndisDriverReceivePacket(NetInterface *interface,
          }
          else
          {
+            //Discard the remaining messages
+            rxBufferDesc->offset = rxBufferDesc->length;
             //Invalid message
             error = ERROR_INVALID_MESSAGE;
          }
       }
       else
       {
+         //Discard trailing bytes
+         rxBufferDesc->offset = rxBufferDesc->length;
          //Invalid message
          error = ERROR_INVALID_MESSAGE;
       }
 
-      //Reset the length field
-      rndisRxBuffer[rndisRxReadIndex].length = 0;
-      //Give the ownership of the buffer to the USB engine
-      rndisRxBuffer[rndisRxReadIndex].ready = FALSE;
-
-      //Increment index and wrap around if necessary
-      if(++rndisRxReadIndex >= RNDIS_RX_BUFFER_COUNT)
-         rndisRxReadIndex = 0;
-
-      //Reception is currently suspended?
-      if(!rndisContext.rxState)
+      //All the messages have been processed?
+      if((rxBufferDesc->offset + sizeof(RndisPacketMsg)) > rxBufferDesc->length)
       {
-         //Debug message
-         TRACE_DEBUG("### usbdRndisReceivePacket 111 ###\r\n");
+         //Reset the length field
+         rxBufferDesc->length = 0;
+         rxBufferDesc->offset = 0;
+         //Give the ownership of the buffer to the USB engine
+         rxBufferDesc->ready = FALSE;
+
+         //Increment index and wrap around if necessary
+         if(++rndisRxReadIndex >= RNDIS_RX_BUFFER_COUNT)
+            rndisRxReadIndex = 0;
+
+         //Reception is currently suspended?
+         if(!rndisContext.rxState)
+         {
+            //Debug message
+            TRACE_DEBUG("### usbdRndisReceivePacket 111 ###\r\n");
 
-         //Prepare DATA OUT endpoint for reception
-         USBD_LL_PrepareReceive(&USBD_Device, RNDIS_DATA_OUT_EP,
-            rndisContext.rxBuffer, RNDIS_DATA_OUT_EP_MPS_FS);
+            //Prepare DATA OUT endpoint for reception
+            USBD_LL_PrepareReceive(&USBD_Device, RNDIS_DATA_OUT_EP,
+               rndisContext.rxBuffer, RNDIS_DATA_OUT_EP_MPS_FS);
 
-         //Reception is active
-         rndisContext.rxState = TRUE;
+            //Reception is active
+            rndisContext.rxState = TRUE;
+         }
       }
    }
    else
@@ -415,3 +484,127 @@ error_t rndisDriverSetMulticastFilter(NetInterface *interface)
    //Successful processing
    return NO_ERROR;
 }
+
+
+/**
+ * @brief Retrieve the maximum size of a DATA IN transfer
+ * @return Maximum number of bytes the host can accept in a single transfer
+ **/
+
+size_t rndisDriverGetMaxTransferSize(void)
+{
+   size_t n;
+
+   //Get the value reported by the host in the Initialize message
+   n = rndisContext.maxTransferSize;
+
+   //The transfer size is limited by the size of the TX buffers
+   if(n == 0 || n > RNDIS_TX_BUFFER_SIZE)
+   {
+      n = RNDIS_TX_BUFFER_SIZE;
+   }
+
+   //Return the maximum transfer size
+   return n;
+}
+
+
+/**
+ * @brief Check whether the transmitter can accept another packet
+ * @return TRUE if a maximum-size frame can be queued, else FALSE
+ **/
+
+bool_t rndisDriverTxReady(void)
+{
+   uint_t i;
+   size_t n;
+   RndisTxBufferDesc *txBufferDesc;
+
+   //Point to the buffer currently being filled
+   txBufferDesc = &rndisTxBuffer[rndisTxWriteIndex];
+
+   //The buffer is owned by the USB engine?
+   if(txBufferDesc->ready)
+      return FALSE;
+
+   //Size of the largest RNDIS Packet message
+   n = sizeof(RndisPacketMsg) + ((ETH_MAX_FRAME_SIZE + 3) & ~3U) + 1;
+
+   //Check whether the current buffer can hold a maximum-size frame
+   if(txBufferDesc->length == 0 ||
+      (txBufferDesc->length + n) <= rndisDriverGetMaxTransferSize())
+   {
+      return TRUE;
+   }
+
+   //Index of the next buffer
+   i = (rndisTxWriteIndex + 1) % RNDIS_TX_BUFFER_COUNT;
+
+   //Otherwise the frame will be written to the next buffer
+   return (i != rndisTxWriteIndex && !rndisTxBuffer[i].ready) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Hand over the buffer currently being filled to the USB engine
+ **/
+
+void rndisDriverCloseTxBuffer(void)
+{
+   RndisPacketMsg *message;
+   RndisTxBufferDesc *txBufferDesc;
+
+   //Point to the buffer currently being filled
+   txBufferDesc = &rndisTxBuffer[rndisTxWriteIndex];
+
+   //Any pending packet?
+   if(!txBufferDesc->ready && txBufferDesc->length > 0)
+   {
+      //Check whether the transfer ends with a USB packet whose length is
+      //exactly the wMaxPacketSize for the DATA IN endpoint
+      if((txBufferDesc->length % RNDIS_DATA_IN_EP_MPS_FS) == 0)
+      {
+         //Point to the last RNDIS Packet message of the transfer
+         message = (RndisPacketMsg *) (txBufferDesc->data +
+            txBufferDesc->lastMsgOffset);
+
+         //The device may send an additional one-byte zero packet
+         txBufferDesc->data[txBufferDesc->length++] = 0;
+         message->messageLength++;
+      }
+
+      //Debug message
+      TRACE_DEBUG("RNDIS transfer ready (%u packets, %" PRIuSIZE " bytes)\r\n",
+         txBufferDesc->numPackets, txBufferDesc->length);
+
+      //Give the ownership of the buffer to the USB engine
+      txBufferDesc->ready = TRUE;
+
+      //Increment index and wrap around if necessary
+      if(++rndisTxWriteIndex >= RNDIS_TX_BUFFER_COUNT)
+         rndisTxWriteIndex = 0;
+   }
+}
+
+
+/**
+ * @brief Start transmitting the next buffer if the DATA IN endpoint is idle
+ **/
+
+void rndisDriverStartTx(void)
+{
+   //Transmission is currently suspended?
+   if(!rndisContext.txState && rndisTxBuffer[rndisTxReadIndex].ready)
+   {
+      //Debug message
+      TRACE_DEBUG("########## Sending DATA IN\r\n");
+
+      //Start transmitting data
+      USBD_LL_Transmit(&USBD_Device, RNDIS_DATA_IN_EP,
+         rndisTxBuffer[rndisTxReadIndex].data,
+         rndisTxBuffer[rndisTxReadIndex].length);
+
+      //Transmission is active
+      rndisContext.txState = TRUE;
+   }
+}
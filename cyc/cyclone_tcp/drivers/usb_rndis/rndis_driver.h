@@ -44,7 +44,7 @@
 //TX buffer size
 #ifndef RNDIS_TX_BUFFER_SIZE
    #define RNDIS_TX_BUFFER_SIZE 2048
-#elif (RNDIS_TX_BUFFER_SIZE != 2048)
+#elif (RNDIS_TX_BUFFER_SIZE < 2048 || (RNDIS_TX_BUFFER_SIZE % 4) != 0)
    #error RNDIS_TX_BUFFER_SIZE parameter is not valid
 #endif
 
@@ -58,10 +58,24 @@
 //RX buffer size
 #ifndef RNDIS_RX_BUFFER_SIZE
    #define RNDIS_RX_BUFFER_SIZE 2048
-#elif (RNDIS_RX_BUFFER_SIZE != 2048)
+#elif (RNDIS_RX_BUFFER_SIZE < 2048 || (RNDIS_RX_BUFFER_SIZE % 4) != 0)
    #error RNDIS_RX_BUFFER_SIZE parameter is not valid
 #endif
 
+//Maximum number of RNDIS Packet messages per USB transfer
+#ifndef RNDIS_MAX_PACKETS_PER_TRANSFER
+   #define RNDIS_MAX_PACKETS_PER_TRANSFER 8
+#elif (RNDIS_MAX_PACKETS_PER_TRANSFER < 1)
+   #error RNDIS_MAX_PACKETS_PER_TRANSFER parameter is not valid
+#endif
+
+//TX flush delay (in USB frames)
+#ifndef RNDIS_TX_FLUSH_DELAY
+   #define RNDIS_TX_FLUSH_DELAY 0
+#elif (RNDIS_TX_FLUSH_DELAY < 0)
+   #error RNDIS_TX_FLUSH_DELAY parameter is not valid
+#endif
+
 
 /**
  * @brief TX buffer descriptor
@@ -71,6 +85,8 @@ typedef struct
 {
    bool_t ready;
    size_t length;
+   uint_t numPackets;
+   size_t lastMsgOffset;
    uint8_t data[RNDIS_TX_BUFFER_SIZE];
 } RndisTxBufferDesc;
 
@@ -83,6 +99,7 @@ typedef struct
 {
    bool_t ready;
    size_t length;
+   size_t offset;
    uint8_t data[RNDIS_RX_BUFFER_SIZE];
 } RndisRxBufferDesc;
 
@@ -102,6 +119,9 @@ extern uint_t rndisTxReadIndex;
 extern uint_t rndisRxWriteIndex;
 extern uint_t rndisRxReadIndex;
 
+//TX flush timer
+extern uint_t rndisTxFlushTimer;
+
 //RNDIS driver related functions
 error_t rndisDriverInit(NetInterface *interface);
 
@@ -119,4 +139,9 @@ error_t rndisDriverReceivePacket(NetInterface *interface,
 
 error_t rndisDriverSetMulticastFilter(NetInterface *interface);
 
+size_t rndisDriverGetMaxTransferSize(void);
+bool_t rndisDriverTxReady(void);
+void rndisDriverCloseTxBuffer(void);
+void rndisDriverStartTx(void);
+
 #endif
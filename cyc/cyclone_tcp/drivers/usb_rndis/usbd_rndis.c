@@ -63,7 +63,7 @@ USBD_ClassTypeDef usbdRndisClass =
    usbdRndisEp0RxReady,
    usbdRndisDataIn,
    usbdRndisDataOut,
-   NULL,
+   usbdRndisSof,
    NULL,
    NULL,
    usbdRndisGetHighSpeedConfigDesc,
@@ -298,26 +298,27 @@ uint8_t usbdRndisDataIn(USBD_HandleTypeDef *pdev, uint8_t epnum)
       TRACE_DEBUG("########## USB DATA IN EP sent #############\r\n");
 
       //The current buffer has been transmitted and is now available for writing
+      rndisTxBuffer[rndisTxReadIndex].length = 0;
+      rndisTxBuffer[rndisTxReadIndex].numPackets = 0;
       rndisTxBuffer[rndisTxReadIndex].ready = FALSE;
 
       //Increment index and wrap around if necessary
       if(++rndisTxReadIndex >= RNDIS_TX_BUFFER_COUNT)
          rndisTxReadIndex = 0;
 
-      //Check whether the next buffer is ready
-      if(rndisTxBuffer[rndisTxReadIndex].ready)
-      {
-         //Start transmitting data
-         USBD_LL_Transmit(pdev, RNDIS_DATA_IN_EP,
-            rndisTxBuffer[rndisTxReadIndex].data,
-            rndisTxBuffer[rndisTxReadIndex].length);
-      }
-      else
+      //Suspend transmission
+      rndisContext.txState = FALSE;
+
+      //Packets that have been queued while the endpoint was busy are
+      //aggregated into a single transfer
+      if(!rndisTxBuffer[rndisTxReadIndex].ready)
       {
-         //Suspend transmission
-         rndisContext.txState = FALSE;
+         rndisDriverCloseTxBuffer();
       }
 
+      //Check whether the next buffer is ready
+      rndisDriverStartTx();
+
       //The transmitter can accept another packet
       osSetEventFromIsr(&rndisDriverInterface->nicTxEvent);
    }
@@ -349,7 +350,7 @@ uint8_t usbdRndisDataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
       TRACE_DEBUG("Data received on DATA OUT endpoint (%" PRIuSIZE " bytes)\r\n", length);
 
       //Make sure the total length is acceptable
-      if((rndisContext.rxBufferLen + length) <= RNDIS_MAX_TRANSFER_SIZE)
+      if((rndisContext.rxBufferLen + length) <= RNDIS_RX_BUFFER_SIZE)
       {
          //Point to the current buffer descriptor
          rxBufferDesc = &rndisRxBuffer[rndisRxWriteIndex];
@@ -370,8 +371,10 @@ uint8_t usbdRndisDataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
             //Dump RNDIS Packet message contents
             rndisDumpMsg((RndisMsg *) rxBufferDesc->data, rxBufferDesc->length);
 
-            //Store the length of the message
+            //Store the length of the transfer
             rxBufferDesc->length = rndisContext.rxBufferLen;
+            //The transfer may contain several RNDIS Packet messages
+            rxBufferDesc->offset = 0;
             //The current buffer is available for reading
             rxBufferDesc->ready = TRUE;
 
@@ -419,6 +422,40 @@ uint8_t usbdRndisDataOut(USBD_HandleTypeDef *pdev, uint8_t epnum)
 }
 
 
+/**
+ * @brief Start Of Frame callback
+ *
+ * The SOF interrupt is used as a 1ms flush timer when RNDIS_TX_FLUSH_DELAY
+ * is set. Note that the sof_enable option of the PCD must be set
+ *
+ * @param[in] pdev Pointer to a USBD_HandleTypeDef structure
+ * @return Status code
+ **/
+
+uint8_t usbdRndisSof(USBD_HandleTypeDef *pdev)
+{
+#if (RNDIS_TX_FLUSH_DELAY > 0)
+   //Any packet held back while the DATA IN endpoint is idle?
+   if(!rndisContext.txState && rndisTxBuffer[rndisTxWriteIndex].length > 0)
+   {
+      //Flush timer elapsed?
+      if(++rndisTxFlushTimer >= RNDIS_TX_FLUSH_DELAY)
+      {
+         //Send the pending packets
+         rndisDriverCloseTxBuffer();
+         rndisDriverStartTx();
+
+         //The transmitter can accept another packet
+         osSetEventFromIsr(&rndisDriverInterface->nicTxEvent);
+      }
+   }
+#endif
+
+   //Successful processing
+   return USBD_OK;
+}
+
+
 /**
  * @brief Retrieve configuration descriptor (high speed)
  * @param[out] length Length of the descriptor, in bytes
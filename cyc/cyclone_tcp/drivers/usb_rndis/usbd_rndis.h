@@ -62,6 +62,7 @@ uint8_t usbdRndisSetup(USBD_HandleTypeDef *pdev, USBD_SetupReqTypedef *req);
 uint8_t usbdRndisEp0RxReady(USBD_HandleTypeDef *pdev);
 uint8_t usbdRndisDataIn(USBD_HandleTypeDef *pdev, uint8_t epnum);
 uint8_t usbdRndisDataOut(USBD_HandleTypeDef *pdev, uint8_t epnum);
+uint8_t usbdRndisSof(USBD_HandleTypeDef *pdev);
 uint8_t *usbdRndisGetHighSpeedConfigDesc(uint16_t *length);
 uint8_t *usbdRndisGetFullSpeedConfigDesc(uint16_t *length);
 uint8_t *usbdRndisGetOtherSpeedConfigDesc(uint16_t *length);
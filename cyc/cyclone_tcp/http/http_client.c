@@ -198,6 +198,31 @@ error_t httpClientSetTimeout(HttpClientContext *context, systime_t timeout)
 }
 
 
+/**
+ * @brief Enable TCP Fast Open
+ *
+ * When enabled, the first bytes of the request are carried by the SYN
+ * segment if a TFO cookie has been received from the server beforehand
+ *
+ * @param[in] context Pointer to the HTTP client context
+ * @param[in] enabled Specifies whether TCP Fast Open is enabled
+ * @return Error code
+ **/
+
+error_t httpClientSetFastOpen(HttpClientContext *context, bool_t enabled)
+{
+   //Make sure the HTTP client context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save parameter
+   context->fastOpen = enabled;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Set authentication information
  * @param[in] context Pointer to the HTTP client context
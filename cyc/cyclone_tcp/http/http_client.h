@@ -268,6 +268,7 @@ struct _HttpClientContext
    HttpVersion version;                           ///<HTTP protocol version
    NetInterface *interface;                       ///<Underlying network interface
    systime_t timeout;                             ///<Timeout value
+   bool_t fastOpen;                               ///<TCP Fast Open
    systime_t timestamp;                           ///<Timestamp to manage timeout
    Socket *socket;                                ///<Underlying socket
 #if (HTTP_CLIENT_TLS_SUPPORT == ENABLED)
@@ -312,6 +313,7 @@ error_t httpClientRegisterRandCallback(HttpClientContext *context,
 
 error_t httpClientSetVersion(HttpClientContext *context, HttpVersion version);
 error_t httpClientSetTimeout(HttpClientContext *context, systime_t timeout);
+error_t httpClientSetFastOpen(HttpClientContext *context, bool_t enabled);
 
 error_t httpClientSetAuthInfo(HttpClientContext *context,
    const char_t *username, const char_t *password);
@@ -69,6 +69,16 @@ error_t httpClientOpenConnection(HttpClientContext *context)
    if(error)
       return error;
 
+   //TCP Fast Open requested?
+   if(context->fastOpen)
+   {
+      //Defer the SYN until the first bytes of the request are sent
+      error = socketEnableTcpFastOpen(context->socket, TRUE);
+      //Any error to report?
+      if(error)
+         return error;
+   }
+
 #if (HTTP_CLIENT_TLS_SUPPORT == ENABLED)
    //TLS-secured connection?
    if(context->tlsInitCallback != NULL)
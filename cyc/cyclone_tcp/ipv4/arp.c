@@ -63,7 +63,7 @@ error_t arpInit(NetInterface *interface)
    interface->enableArp = TRUE;
 
    //Initialize the ARP cache
-   osMemset(interface->arpCache, 0, sizeof(interface->arpCache));
+   arpInitCache(interface);
 
    //Successful initialization
    return NO_ERROR;
@@ -145,7 +145,7 @@ error_t arpAddStaticEntry(NetInterface *interface, Ipv4Addr ipAddr,
    else
    {
       //Create a new entry in the ARP cache
-      entry = arpCreateEntry(interface);
+      entry = arpCreateEntry(interface, ipAddr);
    }
 
    //ARP cache entry successfully created?
@@ -206,7 +206,7 @@ error_t arpRemoveStaticEntry(NetInterface *interface, Ipv4Addr ipAddr)
    if(entry != NULL && entry->state == ARP_STATE_PERMANENT)
    {
       //Delete ARP entry
-      arpChangeState(entry, ARP_STATE_NONE);
+      arpDeleteEntry(interface, entry);
       //Successful processing
       error = NO_ERROR;
    }
@@ -277,14 +277,11 @@ error_t arpResolve(NetInterface *interface, Ipv4Addr ipAddr, MacAddr *macAddr)
       if(interface->enableArp)
       {
          //If no entry exists, then create a new one
-         entry = arpCreateEntry(interface);
+         entry = arpCreateEntry(interface, ipAddr);
 
          //ARP cache entry successfully created?
          if(entry != NULL)
          {
-            //Record the IPv4 address whose MAC address is unknown
-            entry->ipAddr = ipAddr;
-
             //Reset retransmission counter
             entry->retransmitCount = 0;
             //No packet are pending in the transmit queue
@@ -459,11 +456,9 @@ void arpTick(NetInterface *interface)
             }
             else
             {
-               //Drop packets that are waiting for address resolution
-               arpFlushQueuedPackets(interface, entry);
-
-               //The entry should be deleted since address resolution has failed
-               arpChangeState(entry, ARP_STATE_NONE);
+               //The entry should be deleted since address resolution has
+               //failed (pending packets are dropped)
+               arpDeleteEntry(interface, entry);
             }
          }
       }
@@ -523,14 +518,14 @@ void arpTick(NetInterface *interface)
             {
                //The entry should be deleted since the host is not reachable
                //anymore
-               arpChangeState(entry, ARP_STATE_NONE);
+               arpDeleteEntry(interface, entry);
             }
          }
       }
       else
       {
          //Just for sanity
-         arpChangeState(entry, ARP_STATE_NONE);
+         arpDeleteEntry(interface, entry);
       }
    }
 }
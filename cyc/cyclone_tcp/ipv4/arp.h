@@ -48,6 +48,13 @@
    #error ARP_CACHE_SIZE parameter is not valid
 #endif
 
+//Number of buckets of the hash table used to search the ARP cache
+#ifndef ARP_HASH_TABLE_SIZE
+   #define ARP_HASH_TABLE_SIZE ARP_CACHE_SIZE
+#elif (ARP_HASH_TABLE_SIZE < 1)
+   #error ARP_HASH_TABLE_SIZE parameter is not valid
+#endif
+
 //Maximum number of packets waiting for address resolution to complete
 #ifndef ARP_MAX_PENDING_PACKETS
    #define ARP_MAX_PENDING_PACKETS 2
@@ -185,7 +192,7 @@ typedef struct
  * @brief ARP cache entry
  **/
 
-typedef struct
+typedef struct _ArpCacheEntry
 {
    ArpState state;                              ///<Reachability state
    Ipv4Addr ipAddr;                             ///<Unicast IPv4 address
@@ -195,6 +202,9 @@ typedef struct
    uint_t retransmitCount;                      ///<Retransmission counter
    ArpQueueItem queue[ARP_MAX_PENDING_PACKETS]; ///<Packets waiting for address resolution to complete
    uint_t queueSize;                            ///<Number of queued packets
+   struct _ArpCacheEntry *hashNext;             ///<Next entry in the same hash bucket
+   struct _ArpCacheEntry *lruPrev;              ///<Previous (more recently used) entry in the LRU list
+   struct _ArpCacheEntry *lruNext;              ///<Next (less recently used) entry in the LRU list
 } ArpCacheEntry;
 
 
@@ -46,6 +46,35 @@
 #if (IPV4_SUPPORT == ENABLED && ETH_SUPPORT == ENABLED)
 
 
+/**
+ * @brief Initialize the ARP cache
+ * @param[in] interface Underlying network interface
+ **/
+
+void arpInitCache(NetInterface *interface)
+{
+   uint_t i;
+
+   //Clear the ARP cache
+   osMemset(interface->arpCache, 0, sizeof(interface->arpCache));
+   osMemset(interface->arpHashTable, 0, sizeof(interface->arpHashTable));
+
+   //All the entries are initially free and linked together in the LRU list
+   for(i = 0; i < ARP_CACHE_SIZE; i++)
+   {
+      interface->arpCache[i].lruPrev = (i > 0) ?
+         &interface->arpCache[i - 1] : NULL;
+
+      interface->arpCache[i].lruNext = (i < (ARP_CACHE_SIZE - 1)) ?
+         &interface->arpCache[i + 1] : NULL;
+   }
+
+   //Head and tail of the LRU list
+   interface->arpLruHead = &interface->arpCache[0];
+   interface->arpLruTail = &interface->arpCache[ARP_CACHE_SIZE - 1];
+}
+
+
 /**
  * @brief Update ARP cache entry state
  * @param[in] entry Pointer to a ARP cache entry
@@ -62,86 +91,72 @@ void arpChangeState(ArpCacheEntry *entry, ArpState newState)
    entry->timestamp = osGetSystemTime();
    //Switch to the new state
    entry->state = newState;
+
+   //The MAC addresses cached by the sockets must be resolved again
+   netInvalidateRouteCache();
 }
 
 
 /**
  * @brief Create a new entry in the ARP cache
+ *
+ * A free entry is used when available. Otherwise the least recently used
+ * dynamic entry is removed whenever the table runs out of space
+ *
  * @param[in] interface Underlying network interface
+ * @param[in] ipAddr IPv4 address
  * @return Pointer to the newly created entry
  **/
 
-ArpCacheEntry *arpCreateEntry(NetInterface *interface)
+ArpCacheEntry *arpCreateEntry(NetInterface *interface, Ipv4Addr ipAddr)
 {
    uint_t i;
-   systime_t time;
    ArpCacheEntry *entry;
-   ArpCacheEntry *oldestEntry;
+   ArpCacheEntry *lruPrev;
+   ArpCacheEntry *lruNext;
 
-   //Get current time
-   time = osGetSystemTime();
-
-   //Keep track of the oldest entry
-   oldestEntry = NULL;
-
-   //Loop through ARP cache entries
-   for(i = 0; i < ARP_CACHE_SIZE; i++)
+   //Free entries are moved to the tail of the LRU list. Static ARP entries
+   //are never updated
+   for(entry = interface->arpLruTail; entry != NULL; entry = entry->lruPrev)
    {
-      //Point to the current entry
-      entry = &interface->arpCache[i];
-
-      //Check the state of the ARP entry
-      if(entry->state == ARP_STATE_NONE)
-      {
-         //Initialize ARP entry
-         osMemset(entry, 0, sizeof(ArpCacheEntry));
-
-         //Return a pointer to the ARP entry
-         return entry;
-      }
-      else if(entry->state == ARP_STATE_PERMANENT)
-      {
-         //Static ARP entries are never updated
-      }
-      else
-      {
-         //Keep track of the oldest entry in the table
-         if(oldestEntry == NULL)
-         {
-            oldestEntry = entry;
-         }
-         else if(entry->state == ARP_STATE_STALE &&
-            oldestEntry->state != ARP_STATE_STALE)
-         {
-            oldestEntry = entry;
-         }
-         else if(entry->state != ARP_STATE_STALE &&
-            oldestEntry->state == ARP_STATE_STALE)
-         {
-         }
-         else if((time - entry->timestamp) > (time - oldestEntry->timestamp))
-         {
-            oldestEntry = entry;
-         }
-         else
-         {
-         }
-      }
+      if(entry->state != ARP_STATE_PERMANENT)
+         break;
    }
 
    //Any entry available in the ARP cache?
-   if(oldestEntry != NULL)
+   if(entry != NULL)
    {
-      //Drop any pending packets
-      arpFlushQueuedPackets(interface, oldestEntry);
-      //The oldest entry is removed whenever the table runs out of space
-      arpChangeState(oldestEntry, ARP_STATE_NONE);
+      //Remove the least recently used entry, if necessary
+      if(entry->state != ARP_STATE_NONE)
+      {
+         arpDeleteEntry(interface, entry);
+      }
+
+      //Save the position of the entry in the LRU list
+      lruPrev = entry->lruPrev;
+      lruNext = entry->lruNext;
+
       //Initialize ARP entry
-      osMemset(oldestEntry, 0, sizeof(ArpCacheEntry));
+      osMemset(entry, 0, sizeof(ArpCacheEntry));
+
+      //Restore the position of the entry in the LRU list
+      entry->lruPrev = lruPrev;
+      entry->lruNext = lruNext;
+
+      //Record the IPv4 address
+      entry->ipAddr = ipAddr;
+
+      //Insert the entry in the hash table
+      i = arpGetHashIndex(ipAddr);
+      entry->hashNext = interface->arpHashTable[i];
+      interface->arpHashTable[i] = entry;
+
+      //The entry is now the most recently used one
+      arpUpdateLru(interface, entry, TRUE);
    }
 
    //Return a pointer to the ARP entry
-   return oldestEntry;
+   return entry;
 }
 
 
@@ -155,28 +170,66 @@ ArpCacheEntry *arpCreateEntry(NetInterface *interface)
 
 ArpCacheEntry *arpFindEntry(NetInterface *interface, Ipv4Addr ipAddr)
 {
-   uint_t i;
    ArpCacheEntry *entry;
 
-   //Loop through ARP cache entries
-   for(i = 0; i < ARP_CACHE_SIZE; i++)
+   //Only the entries that belong to the matching hash bucket are searched
+   entry = interface->arpHashTable[arpGetHashIndex(ipAddr)];
+
+   //Loop through the entries of the bucket
+   while(entry != NULL)
    {
-      //Point to the current entry
-      entry = &interface->arpCache[i];
+      //Current entry matches the specified address?
+      if(entry->ipAddr == ipAddr)
+      {
+         //The entry is now the most recently used one
+         arpUpdateLru(interface, entry, TRUE);
+         //Return a pointer to the ARP entry
+         return entry;
+      }
 
-      //Check whether the entry is currently in use
-      if(entry->state != ARP_STATE_NONE)
+      //Point to the next entry
+      entry = entry->hashNext;
+   }
+
+   //No matching entry in ARP cache
+   return NULL;
+}
+
+
+/**
+ * @brief Delete an entry from the ARP cache
+ * @param[in] interface Underlying network interface
+ * @param[in] entry Pointer to a ARP cache entry
+ **/
+
+void arpDeleteEntry(NetInterface *interface, ArpCacheEntry *entry)
+{
+   ArpCacheEntry **p;
+
+   //Entries that are in use are linked in the hash table
+   if(entry->state != ARP_STATE_NONE)
+   {
+      //Drop packets that are waiting for address resolution
+      arpFlushQueuedPackets(interface, entry);
+
+      //Remove the entry from its hash bucket
+      for(p = &interface->arpHashTable[arpGetHashIndex(entry->ipAddr)];
+         *p != NULL; p = &(*p)->hashNext)
       {
-         //Current entry matches the specified address?
-         if(entry->ipAddr == ipAddr)
+         if(*p == entry)
          {
-            return entry;
+            *p = entry->hashNext;
+            break;
          }
       }
+
+      //Free entries are reused first
+      entry->hashNext = NULL;
+      arpUpdateLru(interface, entry, FALSE);
    }
 
-   //No matching entry in ARP cache
-   return NULL;
+   //Delete ARP entry
+   arpChangeState(entry, ARP_STATE_NONE);
 }
 
 
@@ -203,11 +256,8 @@ void arpFlushCache(NetInterface *interface)
       }
       else
       {
-         //Drop packets that are waiting for address resolution
-         arpFlushQueuedPackets(interface, entry);
-
          //Delete ARP entry
-         arpChangeState(entry, ARP_STATE_NONE);
+         arpDeleteEntry(interface, entry);
       }
    }
 }
@@ -278,4 +328,78 @@ void arpFlushQueuedPackets(NetInterface *interface, ArpCacheEntry *entry)
    entry->queueSize = 0;
 }
 
+/**
+ * @brief Compute the hash bucket of a given IPv4 address
+ * @param[in] ipAddr IPv4 address
+ * @return Index of the hash bucket
+ **/
+
+uint_t arpGetHashIndex(Ipv4Addr ipAddr)
+{
+   uint32_t h;
+
+   //Hosts on the same subnet only differ by the last bytes of their
+   //addresses, so mix all the bits before reducing the hash value
+   h = ipAddr * 0x9E3779B1;
+   h ^= h >> 16;
+
+   //Return the index of the hash bucket
+   return h % ARP_HASH_TABLE_SIZE;
+}
+
+
+/**
+ * @brief Move an entry to the head or the tail of the LRU list
+ * @param[in] interface Underlying network interface
+ * @param[in] entry Pointer to a ARP cache entry
+ * @param[in] mostRecent Move the entry to the head (TRUE) or to the tail
+ *   (FALSE) of the LRU list
+ **/
+
+void arpUpdateLru(NetInterface *interface, ArpCacheEntry *entry,
+   bool_t mostRecent)
+{
+   //Check whether the entry is already in place
+   if(mostRecent && interface->arpLruHead == entry)
+      return;
+   if(!mostRecent && interface->arpLruTail == entry)
+      return;
+
+   //Unlink the entry from its predecessor
+   if(entry->lruPrev != NULL)
+   {
+      entry->lruPrev->lruNext = entry->lruNext;
+   }
+   else
+   {
+      interface->arpLruHead = entry->lruNext;
+   }
+
+   //Unlink the entry from its successor
+   if(entry->lruNext != NULL)
+   {
+      entry->lruNext->lruPrev = entry->lruPrev;
+   }
+   else
+   {
+      interface->arpLruTail = entry->lruPrev;
+   }
+
+   //Relink the entry at the requested end of the list
+   if(mostRecent)
+   {
+      entry->lruPrev = NULL;
+      entry->lruNext = interface->arpLruHead;
+      interface->arpLruHead->lruPrev = entry;
+      interface->arpLruHead = entry;
+   }
+   else
+   {
+      entry->lruNext = NULL;
+      entry->lruPrev = interface->arpLruTail;
+      interface->arpLruTail->lruNext = entry;
+      interface->arpLruTail = entry;
+   }
+}
+
 #endif
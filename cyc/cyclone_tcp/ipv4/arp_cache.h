@@ -41,16 +41,23 @@ extern "C" {
 #endif
 
 //ARP related functions
+void arpInitCache(NetInterface *interface);
 void arpChangeState(ArpCacheEntry *entry, ArpState newState);
 
-ArpCacheEntry *arpCreateEntry(NetInterface *interface);
+ArpCacheEntry *arpCreateEntry(NetInterface *interface, Ipv4Addr ipAddr);
 ArpCacheEntry *arpFindEntry(NetInterface *interface, Ipv4Addr ipAddr);
+void arpDeleteEntry(NetInterface *interface, ArpCacheEntry *entry);
 
 void arpFlushCache(NetInterface *interface);
 
 void arpSendQueuedPackets(NetInterface *interface, ArpCacheEntry *entry);
 void arpFlushQueuedPackets(NetInterface *interface, ArpCacheEntry *entry);
 
+uint_t arpGetHashIndex(Ipv4Addr ipAddr);
+
+void arpUpdateLru(NetInterface *interface, ArpCacheEntry *entry,
+   bool_t mostRecent);
+
 //C++ guard
 #ifdef __cplusplus
 }
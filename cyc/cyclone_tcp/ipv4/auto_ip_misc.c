@@ -165,6 +165,8 @@ void autoIpTick(AutoIpContext *context)
             {
                //The use of the IPv4 address is now unrestricted
                interface->ipv4Context.addrList[i].state = IPV4_ADDR_STATE_VALID;
+               //The routes cached by the sockets are no longer valid
+               netInvalidateRouteCache();
 
 #if (MDNS_RESPONDER_SUPPORT == ENABLED)
                //Restart mDNS probing process
@@ -388,6 +390,9 @@ void autoIpResetConfig(AutoIpContext *context)
    //The host must not send packets to any router for forwarding (refer to
    //RFC 3927, section 2.6.2)
    interface->ipv4Context.addrList[i].defaultGateway = IPV4_UNSPECIFIED_ADDR;
+
+   //The routes cached by the sockets are no longer valid
+   netInvalidateRouteCache();
 }
 
 
@@ -36,7 +36,9 @@
 #include "core/ip.h"
 #include "ipv4/ipv4.h"
 #include "ipv4/ipv4_misc.h"
+#include "ipv4/ipv4_pmtu.h"
 #include "ipv4/icmp.h"
+#include "core/tcp_misc.h"
 #include "mibs/mib2_module.h"
 #include "mibs/ip_mib_module.h"
 #include "debug.h"
@@ -172,6 +174,13 @@ void icmpProcessMessage(NetInterface *interface,
       icmpProcessEchoRequest(interface, requestPseudoHeader, buffer, offset);
       break;
 
+   //Destination Unreachable?
+   case ICMP_TYPE_DEST_UNREACHABLE:
+      //Process Destination Unreachable message
+      icmpProcessDestUnreachable(interface, requestPseudoHeader, buffer,
+         offset);
+      break;
+
    //Unknown type?
    default:
       //Debug message
@@ -324,6 +333,108 @@ void icmpProcessEchoRequest(NetInterface *interface,
 }
 
 
+/**
+ * @brief Destination Unreachable message processing
+ * @param[in] interface Underlying network interface
+ * @param[in] pseudoHeader IPv4 pseudo header
+ * @param[in] buffer Multi-part buffer containing the incoming message
+ * @param[in] offset Offset to the first byte of the message
+ **/
+
+void icmpProcessDestUnreachable(NetInterface *interface,
+   const Ipv4PseudoHeader *pseudoHeader, const NetBuffer *buffer,
+   size_t offset)
+{
+#if (IPV4_PMTU_SUPPORT == ENABLED || (TCP_SUPPORT == ENABLED && \
+   TCP_PLPMTUD_SUPPORT == ENABLED))
+   size_t length;
+   size_t pathMtu;
+   IcmpDestUnreachableMessage *message;
+   Ipv4Header *ipHeader;
+
+   //Retrieve the length of the Destination Unreachable message
+   length = netBufferGetLength(buffer) - offset;
+
+   //The message must quote the IPv4 header of the invoking packet
+   if(length < (sizeof(IcmpDestUnreachableMessage) + sizeof(Ipv4Header)))
+      return;
+
+   //Point to the Destination Unreachable message
+   message = netBufferAt(buffer, offset,
+      sizeof(IcmpDestUnreachableMessage) + sizeof(Ipv4Header));
+   //Sanity check
+   if(message == NULL)
+      return;
+
+   //Debug message
+   TRACE_INFO("ICMP Destination Unreachable message received (%" PRIuSIZE " bytes)...\r\n",
+      length);
+   //Dump message contents for debugging purpose
+   icmpDumpErrorMessage((IcmpErrorMessage *) message);
+
+   //Only Fragmentation Needed messages are of interest
+   if(message->code != ICMP_CODE_FRAG_NEEDED_AND_DF_SET)
+      return;
+
+   //Point to the header of the invoking packet
+   ipHeader = (Ipv4Header *) message->data;
+
+   //The invoking packet must have been sent by the host itself
+   if(ipHeader->version != IPV4_VERSION ||
+      ipHeader->srcAddr != pseudoHeader->destAddr)
+   {
+      return;
+   }
+
+   //RFC 1191 routers report the MTU of the next-hop network in the low-order
+   //16 bits of the unused field
+   pathMtu = ntohl(message->unused) & 0xFFFF;
+
+   //Older routers leave this field set to zero (refer to RFC 1191,
+   //section 5)
+   if(pathMtu == 0)
+   {
+      pathMtu = ipv4EstimatePathMtu(ntohs(ipHeader->totalLength));
+   }
+
+   //Debug message
+   TRACE_INFO("Path MTU to %s reduced to %" PRIuSIZE " bytes\r\n",
+      ipv4AddrToString(ipHeader->destAddr, NULL), pathMtu);
+
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+   //Update the PMTU cache
+   ipv4UpdatePathMtu(interface, ipHeader->destAddr, pathMtu);
+#endif
+
+#if (TCP_SUPPORT == ENABLED && TCP_PLPMTUD_SUPPORT == ENABLED)
+   //The invoking packet is a TCP segment?
+   if(ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      IpAddr srcAddr;
+      IpAddr destAddr;
+      TcpHeader *tcpHeader;
+
+      //The message quotes at least the first 64 bits of the TCP header, which
+      //hold the ports and the sequence number (refer to RFC 792)
+      tcpHeader = netBufferAt(buffer, offset +
+         sizeof(IcmpDestUnreachableMessage) + ipHeader->headerLength * 4, 8);
+
+      //Notify the TCP connection the segment belongs to
+      if(tcpHeader != NULL)
+      {
+         srcAddr.length = sizeof(Ipv4Addr);
+         srcAddr.ipv4Addr = ipHeader->srcAddr;
+         destAddr.length = sizeof(Ipv4Addr);
+         destAddr.ipv4Addr = ipHeader->destAddr;
+
+         tcpUpdatePathMtu(interface, &srcAddr, &destAddr, tcpHeader, pathMtu);
+      }
+   }
+#endif
+#endif
+}
+
+
 /**
  * @brief Send an ICMP Error message
  * @param[in] interface Underlying network interface
@@ -395,8 +506,6 @@ error_t icmpSendErrorMessage(NetInterface *interface, uint8_t type,
    //Check status code
    if(!error)
    {
-      NetTxAncillary ancillary;
-
       //Get the length of the resulting message
       length = netBufferGetLength(icmpMessage) - offset;
       //Message checksum calculation
@@ -409,6 +518,24 @@ error_t icmpSendErrorMessage(NetInterface *interface, uint8_t type,
       pseudoHeader.protocol = IPV4_PROTOCOL_ICMP;
       pseudoHeader.length = htons(length);
 
+      //The invoking packet was not addressed to the host (forwarded packet)?
+      if(ipv4CheckDestAddr(interface, ipHeader->destAddr))
+      {
+         Ipv4Addr srcIpAddr;
+
+         //Select the source address of the ICMP message
+         error = ipv4SelectSourceAddr(&interface, pseudoHeader.destAddr,
+            &srcIpAddr);
+         //Save the source address
+         pseudoHeader.srcAddr = srcIpAddr;
+      }
+   }
+
+   //Check status code
+   if(!error)
+   {
+      NetTxAncillary ancillary;
+
       //Update ICMP statistics
       icmpUpdateOutStats(type);
 
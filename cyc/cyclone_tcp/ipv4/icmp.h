@@ -207,6 +207,10 @@ void icmpProcessEchoRequest(NetInterface *interface,
    const Ipv4PseudoHeader *requestPseudoHeader, const NetBuffer *request,
    size_t requestOffset);
 
+void icmpProcessDestUnreachable(NetInterface *interface,
+   const Ipv4PseudoHeader *pseudoHeader, const NetBuffer *buffer,
+   size_t offset);
+
 error_t icmpSendErrorMessage(NetInterface *interface, uint8_t type,
    uint8_t code, uint8_t parameter, const NetBuffer *ipPacket,
    size_t ipPacketOffset);
@@ -49,6 +49,7 @@
 #include "ipv4/ipv4_multicast.h"
 #include "ipv4/ipv4_routing.h"
 #include "ipv4/ipv4_misc.h"
+#include "ipv4/ipv4_pmtu.h"
 #include "ipv4/icmp.h"
 #include "ipv4/auto_ip_misc.h"
 #include "igmp/igmp_host.h"
@@ -112,6 +113,7 @@ error_t ipv4Init(NetInterface *interface)
 #if (IPV4_FRAG_SUPPORT == ENABLED)
    //Initialize the reassembly queue
    osMemset(context->fragQueue, 0, sizeof(context->fragQueue));
+   context->fragMemUsage = 0;
 #endif
 
    //Successful initialization
@@ -205,6 +207,9 @@ error_t ipv4SetHostAddrEx(NetInterface *interface, uint_t index, Ipv4Addr addr)
       entry->state = IPV4_ADDR_STATE_INVALID;
    }
 
+   //The routes cached by the sockets are no longer valid
+   netInvalidateRouteCache();
+
 #if (MDNS_RESPONDER_SUPPORT == ENABLED)
    //Restart mDNS probing process
    mdnsResponderStartProbing(interface->mdnsResponderContext);
@@ -321,6 +326,8 @@ error_t ipv4SetSubnetMaskEx(NetInterface *interface, uint_t index,
    osAcquireMutex(&netMutex);
    //Set up subnet mask
    interface->ipv4Context.addrList[index].subnetMask = mask;
+   //The routes cached by the sockets are no longer valid
+   netInvalidateRouteCache();
    //Release exclusive access
    osReleaseMutex(&netMutex);
 
@@ -420,6 +427,8 @@ error_t ipv4SetDefaultGatewayEx(NetInterface *interface, uint_t index,
    osAcquireMutex(&netMutex);
    //Set up default gateway address
    interface->ipv4Context.addrList[index].defaultGateway = addr;
+   //The routes cached by the sockets are no longer valid
+   netInvalidateRouteCache();
    //Release exclusive access
    osReleaseMutex(&netMutex);
 
@@ -730,16 +739,33 @@ void ipv4ProcessPacket(NetInterface *interface, Ipv4Header *packet,
          //Invalid destination address?
          if(error)
          {
+            size_t n;
             NetBuffer1 buffer;
 
+#if (ETH_SUPPORT == ENABLED)
+            //The Ethernet header of the received frame precedes the packet,
+            //so that the router can forward the packet in place
+            if(nicGetPhysicalInterface(interface)->nicDriver != NULL &&
+               nicGetPhysicalInterface(interface)->nicDriver->type == NIC_TYPE_ETHERNET)
+            {
+               n = sizeof(EthHeader);
+            }
+            else
+#endif
+            {
+               n = 0;
+            }
+
             //Unfragmented datagrams fit in a single chunk
             buffer.chunkCount = 1;
             buffer.maxChunkCount = 1;
-            buffer.chunk[0].address = packet;
-            buffer.chunk[0].length = length;
+            buffer.chunk[0].address = (uint8_t *) packet - n;
+            buffer.chunk[0].length = (uint16_t) (n + MIN(length,
+               ntohs(packet->totalLength)));
+            buffer.chunk[0].size = 0;
 
             //Forward the packet according to the routing table
-            ipv4ForwardPacket(interface, (NetBuffer *) &buffer, 0);
+            ipv4ForwardPacket(interface, (NetBuffer *) &buffer, n);
          }
 #endif
       }
@@ -1015,6 +1041,7 @@ error_t ipv4SendDatagram(NetInterface *interface,
    uint16_t id;
 #if (IPV4_IPSEC_SUPPORT == DISABLED)
    size_t length;
+   size_t pathMtu;
 #endif
 
    //Total number of IP datagrams which local IP user-protocols supplied to IP
@@ -1044,11 +1071,19 @@ error_t ipv4SendDatagram(NetInterface *interface,
    //Retrieve the length of payload
    length = netBufferGetLength(buffer) - offset;
 
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+   //Retrieve the PMTU for the specified destination address
+   pathMtu = ipv4GetPathMtu(interface, pseudoHeader->destAddr);
+#else
+   //The PMTU value for the path is assumed to be the MTU of the first-hop link
+   pathMtu = interface->ipv4Context.linkMtu;
+#endif
+
    //Check the length of the payload
-   if((length + sizeof(Ipv4Header)) <= interface->ipv4Context.linkMtu)
+   if((length + sizeof(Ipv4Header)) <= pathMtu)
    {
-      //If the payload length is smaller than the network interface MTU
-      //then no fragmentation is needed
+      //If the payload length is smaller than the PMTU then no fragmentation
+      //is needed
       error = ipv4SendPacket(interface, pseudoHeader, id, 0, buffer,
          offset, ancillary);
    }
@@ -1060,10 +1095,10 @@ error_t ipv4SendDatagram(NetInterface *interface,
       //RFC791, section 2.3)
       if(!ancillary->dontFrag)
       {
-         //If the payload length exceeds the network interface MTU then the
-         //device must fragment the data
+         //If the payload length exceeds the PMTU then the device must
+         //fragment the data
          error = ipv4FragmentDatagram(interface, pseudoHeader, id, buffer,
-            offset, ancillary);
+            offset, pathMtu, ancillary);
       }
       else
 #endif
@@ -434,7 +434,8 @@ typedef struct
    Ipv4Addr dnsServerList[IPV4_DNS_SERVER_LIST_SIZE];           ///<DNS servers
    Ipv4FilterEntry multicastFilter[IPV4_MULTICAST_FILTER_SIZE]; ///<Multicast filter table
 #if (IPV4_FRAG_SUPPORT == ENABLED)
-   Ipv4FragDesc fragQueue[IPV4_MAX_FRAG_DATAGRAMS];             ///<IPv4 fragment reassembly queue
+   Ipv4FragDesc *fragQueue[IPV4_FRAG_HASH_TABLE_SIZE];          ///<IPv4 fragment reassembly queue
+   size_t fragMemUsage;                                         ///<Memory used by the reassembly queue
 #endif
 } Ipv4Context;
 
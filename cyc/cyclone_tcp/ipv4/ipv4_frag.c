@@ -64,6 +64,7 @@ systime_t ipv4FragTickCounter;
  * @param[in] id Fragment identification
  * @param[in] payload Multi-part buffer containing the payload
  * @param[in] payloadOffset Offset to the first payload byte
+ * @param[in] pathMtu PMTU value
  * @param[in] ancillary Additional options passed to the stack along with
  *   the packet
  * @return Error code
@@ -71,7 +72,7 @@ systime_t ipv4FragTickCounter;
 
 error_t ipv4FragmentDatagram(NetInterface *interface,
    const Ipv4PseudoHeader *pseudoHeader, uint16_t id, const NetBuffer *payload,
-   size_t payloadOffset, NetTxAncillary *ancillary)
+   size_t payloadOffset, size_t pathMtu, NetTxAncillary *ancillary)
 {
    error_t error;
    size_t offset;
@@ -96,7 +97,7 @@ error_t ipv4FragmentDatagram(NetInterface *interface,
       return ERROR_OUT_OF_MEMORY;
 
    //Determine the maximum payload size for fragmented packets
-   maxFragmentSize = interface->ipv4Context.linkMtu - sizeof(Ipv4Header);
+   maxFragmentSize = pathMtu - sizeof(Ipv4Header);
    //The size shall be a multiple of 8-byte blocks
    maxFragmentSize -= (maxFragmentSize % 8);
 
@@ -174,6 +175,11 @@ error_t ipv4FragmentDatagram(NetInterface *interface,
 
 /**
  * @brief IPv4 datagram reassembly algorithm
+ *
+ * Each fragment is kept in its own node until the datagram is complete. The
+ * reassembled datagram is then passed to the upper layer as a chain of data
+ * chunks that point to the fragment nodes
+ *
  * @param[in] interface Underlying network interface
  * @param[in] packet Pointer to the IPv4 fragmented packet
  * @param[in] length Packet length including header and payload
@@ -185,20 +191,23 @@ void ipv4ReassembleDatagram(NetInterface *interface, const Ipv4Header *packet,
    size_t length, NetRxAncillary *ancillary)
 {
    error_t error;
+   size_t headerLength;
    uint16_t offset;
    uint16_t dataFirst;
    uint16_t dataLast;
    Ipv4FragDesc *frag;
-   Ipv4HoleDesc *hole;
-   Ipv4HoleDesc *prevHole;
+   Ipv4FragNode *node;
+   Ipv4Header *datagram;
 
    //Number of IP fragments received which needed to be reassembled
    MIB2_IP_INC_COUNTER32(ipReasmReqds, 1);
    IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmReqds, 1);
    IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmReqds, 1);
 
+   //Calculate the length of the IP header including options
+   headerLength = packet->headerLength * 4;
    //Get the length of the payload
-   length -= packet->headerLength * 4;
+   length -= headerLength;
    //Convert the fragment offset from network byte order
    offset = ntohs(packet->fragmentOffset);
 
@@ -246,232 +255,139 @@ void ipv4ReassembleDatagram(NetInterface *interface, const Ipv4Header *packet,
       return;
    }
 
-   //The very first fragment requires special handling
-   if((offset & IPV4_OFFSET_MASK) == 0)
+   //Length of the IP header of the reconstructed datagram
+   if(frag->header != NULL)
    {
-      //Calculate the length of the IP header including options
-      frag->headerLength = packet->headerLength * 4;
+      headerLength = frag->header->last;
+   }
 
-      //Enforce the size of the reconstructed datagram
-      if((frag->headerLength + frag->dataLen) > IPV4_MAX_FRAG_DATAGRAM_SIZE)
+   //Enforce the size of the reconstructed datagram
+   if((headerLength + dataLast) > IPV4_MAX_FRAG_DATAGRAM_SIZE)
+   {
+      //Report an error
+      error = ERROR_INVALID_LENGTH;
+   }
+   else if((offset & IPV4_FLAG_MF) == 0)
+   {
+      //The last fragment determines the length of the payload. Any data
+      //beyond that point is inconsistent
+      for(node = frag->nodes; node != NULL && node->next != NULL;
+         node = node->next)
       {
-         //Number of failures detected by the IP reassembly algorithm
-         MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
       }
 
-      //Make sure the IP header entirely fits in the first chunk
-      if(frag->headerLength > frag->buffer.chunk[0].size)
+      //Check whether the length of the payload is consistent
+      if(frag->lastFrag && dataLast != frag->dataLen)
+      {
+         error = ERROR_INCONSISTENT_VALUE;
+      }
+      else if(node != NULL && node->last > dataLast)
       {
-         //Number of failures detected by the IP reassembly algorithm
-         MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         error = ERROR_INCONSISTENT_VALUE;
       }
+      else
+      {
+         //Actual length of the payload
+         frag->dataLen = dataLast;
+         frag->lastFrag = TRUE;
 
-      //Fix the length of the first chunk
-      frag->buffer.chunk[0].length = (uint16_t) frag->headerLength;
-      //Always take the IP header from the first fragment
-      netBufferWrite((NetBuffer *) &frag->buffer, 0, packet, frag->headerLength);
+         //Successful processing
+         error = NO_ERROR;
+      }
    }
-
-   //It may be necessary to increase the size of the buffer
-   if(dataLast > frag->dataLen)
+   else
    {
-      //Enforce the size of the reconstructed datagram
-      if((frag->headerLength + dataLast) > IPV4_MAX_FRAG_DATAGRAM_SIZE)
+      //Fragments cannot extend beyond the end of the payload
+      if(frag->lastFrag && dataLast > frag->dataLen)
       {
-         //Number of failures detected by the IP reassembly algorithm
-         MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         error = ERROR_INCONSISTENT_VALUE;
       }
-
-      //Adjust the size of the reconstructed datagram
-      error = netBufferSetLength((NetBuffer *) &frag->buffer,
-         frag->headerLength + dataLast + sizeof(Ipv4HoleDesc));
-
-      //Any error to report?
-      if(error)
+      else
       {
-         //Number of failures detected by the IP reassembly algorithm
-         MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         error = NO_ERROR;
       }
-
-      //Actual length of the payload
-      frag->dataLen = dataLast;
    }
 
-   //Select the first hole descriptor from the list
-   hole = ipv4FindHole(frag, frag->firstHole);
-   //Keep track of the previous hole in the list
-   prevHole = NULL;
-
-   //Iterate through the hole descriptors
-   while(hole != NULL)
+   //Check status code
+   if(!error)
    {
-      //Save lower and upper boundaries for later use
-      uint16_t holeFirst = hole->first;
-      uint16_t holeLast = hole->last;
-
-      //Check whether the newly arrived fragment interacts with this hole in
-      //some way
-      if(dataFirst < holeLast && dataLast > holeFirst)
+      //The very first fragment requires special handling
+      if(dataFirst == 0 && frag->header == NULL)
       {
-#if (IPV4_OVERLAPPING_FRAG_SUPPORT == DISABLED)
-         //Prevent overlapping fragment attacks (refer to RFC 8900, section 3.7)
-         if(dataFirst < holeFirst || dataLast > holeLast)
-         {
-            //Number of failures detected by the IP reassembly algorithm
-            MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
-            IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
-            IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
+         //Allocate a node to hold the IP header
+         frag->header = ipv4AllocFragMem(interface, frag,
+            sizeof(Ipv4FragNode) + headerLength);
 
-            //Drop the reconstructed datagram
-            netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-            //Exit immediately
-            return;
-         }
-#endif
-         //The current descriptor is no longer valid. We will destroy it, and in
-         //the next two steps, we will determine whether or not it is necessary
-         //to create any new hole descriptors
-         if(prevHole != NULL)
+         //Successful memory allocation?
+         if(frag->header != NULL)
          {
-            prevHole->next = hole->next;
+            //Always take the IP header from the first fragment
+            frag->header->next = NULL;
+            frag->header->first = 0;
+            frag->header->last = (uint16_t) headerLength;
+            frag->header->size = (uint16_t) IPV4_FRAG_NODE_SIZE(headerLength);
+            osMemcpy(frag->header->data, packet, headerLength);
          }
          else
          {
-            frag->firstHole = hole->next;
+            //Failed to allocate memory
+            error = ERROR_OUT_OF_MEMORY;
          }
+      }
+   }
 
-         //Is there still a hole at the beginning of the segment?
-         if(dataFirst > holeFirst)
-         {
-            //Create a new entry that describes this hole
-            hole = ipv4FindHole(frag, holeFirst);
-            hole->first = holeFirst;
-            hole->last = dataFirst;
-
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
+   //Check status code
+   if(!error)
+   {
+      //Add the data to the list of fragment nodes
+      error = ipv4InsertFragment(interface, frag, dataFirst, IPV4_DATA(packet),
+         length);
+   }
 
-            //Always keep track of the previous hole
-            prevHole = hole;
-         }
+   //Any error to report?
+   if(error)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
+      IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
+      IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
 
-         //Is there still a hole at the end of the segment?
-         if(dataLast < holeLast && (offset & IPV4_FLAG_MF) != 0)
-         {
-            //Create a new entry that describes this hole
-            hole = ipv4FindHole(frag, dataLast);
-            hole->first = dataLast;
-            hole->last = holeLast;
+      //Drop the partially reconstructed datagram
+      ipv4DeleteFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
+   //Dump the list of fragment nodes
+   ipv4DumpFragList(frag);
 
-            //Always keep track of the previous hole
-            prevHole = hole;
-         }
-      }
-      else
-      {
-         //The newly arrived fragment does not interact with the current hole
-         prevHole = hole;
-      }
+   //The reassembly process is complete when the first and the last fragments
+   //have been received and there is no hole between them
+   if(frag->header != NULL && frag->lastFrag &&
+      frag->receivedLen == frag->dataLen)
+   {
+      //Build the reassembled datagram without copying the data
+      ipv4ChainFragments(frag);
 
-      //Select the next hole descriptor from the list
-      hole = ipv4FindHole(frag, prevHole ? prevHole->next : frag->firstHole);
-   }
+      //Point to the IP header
+      datagram = (Ipv4Header *) frag->header->data;
 
-   //Copy data from the fragment to the reassembly buffer
-   netBufferWrite((NetBuffer *) &frag->buffer,
-      frag->headerLength + dataFirst, IPV4_DATA(packet), length);
+      //Fix IP header
+      datagram->totalLength = htons(frag->header->last + frag->dataLen);
+      datagram->fragmentOffset = 0;
+      datagram->headerChecksum = 0;
 
-   //Dump hole descriptor list
-   ipv4DumpHoleList(frag);
+      //Number of IP datagrams successfully reassembled
+      MIB2_IP_INC_COUNTER32(ipReasmOKs, 1);
+      IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmOKs, 1);
+      IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmOKs, 1);
 
-   //If the hole descriptor list is empty, the reassembly process is now
-   //complete
-   if(ipv4FindHole(frag, frag->firstHole) == NULL)
-   {
-      //Discard the extra hole descriptor that follows the reconstructed
-      //datagram
-      error = netBufferSetLength((NetBuffer *) &frag->buffer,
-         frag->headerLength + frag->dataLen);
-
-      //Check status code
-      if(error)
-      {
-         //Number of failures detected by the IP reassembly algorithm
-         MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-      }
-      else
-      {
-         //Point to the IP header
-         Ipv4Header *datagram = netBufferAt((NetBuffer *) &frag->buffer, 0, 0);
-
-         //Fix IP header
-         datagram->totalLength = htons(frag->headerLength + frag->dataLen);
-         datagram->fragmentOffset = 0;
-         datagram->headerChecksum = 0;
-
-         //Number of IP datagrams successfully reassembled
-         MIB2_IP_INC_COUNTER32(ipReasmOKs, 1);
-         IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmOKs, 1);
-         IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmOKs, 1);
-
-         //Pass the original IPv4 datagram to the higher protocol layer
-         ipv4ProcessDatagram(interface, (NetBuffer *) &frag->buffer, 0,
-            ancillary);
-      }
+      //Pass the original IPv4 datagram to the higher protocol layer
+      ipv4ProcessDatagram(interface, (NetBuffer *) &frag->buffer, 0,
+         ancillary);
 
       //Release previously allocated memory
-      netBufferSetLength((NetBuffer *) &frag->buffer, 0);
+      ipv4DeleteFragDesc(interface, frag);
    }
 }
 
@@ -487,60 +403,54 @@ void ipv4ReassembleDatagram(NetInterface *interface, const Ipv4Header *packet,
 
 void ipv4FragTick(NetInterface *interface)
 {
-   error_t error;
    uint_t i;
    systime_t time;
-   Ipv4HoleDesc *hole;
+   Ipv4FragDesc *frag;
+   Ipv4FragDesc *next;
 
    //Get current time
    time = osGetSystemTime();
 
    //Loop through the reassembly queue
-   for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
+   for(i = 0; i < IPV4_FRAG_HASH_TABLE_SIZE; i++)
    {
-      //Point to the current entry in the reassembly queue
-      Ipv4FragDesc *frag = &interface->ipv4Context.fragQueue[i];
-
-      //Make sure the entry is currently in use
-      if(frag->buffer.chunkCount > 0)
+      //Loop through the entries of the current hash bucket
+      for(frag = interface->ipv4Context.fragQueue[i]; frag != NULL; frag = next)
       {
+         //The entry may be deleted
+         next = frag->next;
+
          //If the timer runs out, the partially-reassembled datagram must be
          //discarded and ICMP Time Exceeded message sent to the source host
          if((time - frag->timestamp) >= IPV4_FRAG_TIME_TO_LIVE)
          {
             //Debug message
             TRACE_INFO("IPv4 fragment reassembly timeout...\r\n");
-            //Dump IP header contents for debugging purpose
-            ipv4DumpHeader(frag->buffer.chunk[0].address);
 
             //Number of failures detected by the IP reassembly algorithm
             MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
             IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
             IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
 
-            //Point to the first hole descriptor
-            hole = ipv4FindHole(frag, frag->firstHole);
-
             //Make sure the fragment zero has been received before sending an
             //ICMP message
-            if(hole != NULL && hole->first > 0)
+            if(frag->header != NULL)
             {
-               //Fix the size of the reconstructed datagram
-               error = netBufferSetLength((NetBuffer *) &frag->buffer,
-                  frag->headerLength + hole->first);
-
-               //Check status code
-               if(!error)
-               {
-                  //Send an ICMP Time Exceeded message
-                  icmpSendErrorMessage(interface, ICMP_TYPE_TIME_EXCEEDED,
-                     ICMP_CODE_REASSEMBLY_TIME_EXCEEDED, 0,
-                     (NetBuffer *) &frag->buffer, 0);
-               }
+               //Dump IP header contents for debugging purpose
+               ipv4DumpHeader((Ipv4Header *) frag->header->data);
+
+               //The message carries the leading data of the datagram, up to
+               //the first hole
+               ipv4ChainFragments(frag);
+
+               //Send an ICMP Time Exceeded message
+               icmpSendErrorMessage(interface, ICMP_TYPE_TIME_EXCEEDED,
+                  ICMP_CODE_REASSEMBLY_TIME_EXCEEDED, 0,
+                  (NetBuffer *) &frag->buffer, 0);
             }
 
             //Drop the partially reconstructed datagram
-            netBufferSetLength((NetBuffer *) &frag->buffer, 0);
+            ipv4DeleteFragDesc(interface, frag);
          }
       }
    }
@@ -557,158 +467,542 @@ void ipv4FragTick(NetInterface *interface)
 Ipv4FragDesc *ipv4SearchFragQueue(NetInterface *interface,
    const Ipv4Header *packet)
 {
-   error_t error;
    uint_t i;
-   Ipv4Header *datagram;
    Ipv4FragDesc *frag;
-   Ipv4HoleDesc *hole;
+
+   //Only the entries that belong to the matching hash bucket are searched
+   i = ipv4GetFragHashIndex(packet->srcAddr, packet->destAddr,
+      packet->identification, packet->protocol);
 
    //Search for a matching IP datagram being reassembled
-   for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
+   for(frag = interface->ipv4Context.fragQueue[i]; frag != NULL;
+      frag = frag->next)
    {
-      //Point to the current entry in the reassembly queue
-      frag = &interface->ipv4Context.fragQueue[i];
+      //Check source and destination addresses
+      if(frag->srcAddr != packet->srcAddr)
+         continue;
+      if(frag->destAddr != packet->destAddr)
+         continue;
+
+      //Compare identification and protocol fields
+      if(frag->identification != packet->identification)
+         continue;
+      if(frag->protocol != packet->protocol)
+         continue;
+
+      //A matching entry has been found in the reassembly queue
+      return frag;
+   }
+
+   //If the current packet does not match an existing entry in the reassembly
+   //queue, then create a new entry
+   frag = ipv4AllocFragMem(interface, NULL, sizeof(Ipv4FragDesc));
+
+   //Failed to allocate memory?
+   if(frag == NULL)
+      return NULL;
+
+   //Initialize the entry
+   osMemset(frag, 0, sizeof(Ipv4FragDesc));
+
+   //Amount of memory used by the entry
+   frag->memUsage = IPV4_FRAG_MEM_SIZE(sizeof(Ipv4FragDesc));
+   //Save current time
+   frag->timestamp = osGetSystemTime();
+
+   //Record the fields that identify the datagram
+   frag->srcAddr = packet->srcAddr;
+   frag->destAddr = packet->destAddr;
+   frag->identification = packet->identification;
+   frag->protocol = packet->protocol;
+
+   //Insert the entry in the hash table
+   frag->next = interface->ipv4Context.fragQueue[i];
+   interface->ipv4Context.fragQueue[i] = frag;
+
+   //Return the newly created fragment descriptor
+   return frag;
+}
+
+
+/**
+ * @brief Flush IPv4 reassembly queue
+ * @param[in] interface Underlying network interface
+ **/
+
+void ipv4FlushFragQueue(NetInterface *interface)
+{
+   uint_t i;
 
-      //Check whether the current entry is used?
-      if(frag->buffer.chunkCount > 0)
+   //Loop through the reassembly queue
+   for(i = 0; i < IPV4_FRAG_HASH_TABLE_SIZE; i++)
+   {
+      //Drop any partially reconstructed datagram
+      while(interface->ipv4Context.fragQueue[i] != NULL)
       {
-         //Point to the corresponding datagram
-         datagram = netBufferAt((NetBuffer *) &frag->buffer, 0, 0);
+         ipv4DeleteFragDesc(interface, interface->ipv4Context.fragQueue[i]);
+      }
+   }
+}
 
-         //Check source and destination addresses
-         if(datagram->srcAddr != packet->srcAddr)
-            continue;
-         if(datagram->destAddr != packet->destAddr)
-            continue;
 
-         //Compare identification and protocol fields
-         if(datagram->identification != packet->identification)
-            continue;
-         if(datagram->protocol != packet->protocol)
-            continue;
+/**
+ * @brief Add the data of a fragment to the list of fragment nodes
+ *
+ * Only the parts of the fragment that fill holes are recorded. Each node
+ * holds a contiguous range of data, and the list is sorted by offset
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv4 fragment descriptor
+ * @param[in] dataFirst Index of the first byte of the fragment
+ * @param[in] data Pointer to the fragment data
+ * @param[in] length Length of the fragment data
+ * @return Error code
+ **/
+
+error_t ipv4InsertFragment(NetInterface *interface, Ipv4FragDesc *frag,
+   uint16_t dataFirst, const uint8_t *data, size_t length)
+{
+   size_t newLen;
+   uint16_t pos;
+   uint16_t end;
+   uint16_t dataLast;
+   bool_t overlap;
+   Ipv4FragNode *node;
+   Ipv4FragNode *newNode;
+   Ipv4FragNode **p;
+
+   //Calculate the index immediately following the last byte
+   dataLast = dataFirst + (uint16_t) length;
+
+   //Determine how many bytes fill holes
+   newLen = 0;
+   overlap = FALSE;
+
+   //Walk through the holes covered by the fragment
+   for(pos = dataFirst, node = frag->nodes; pos < dataLast; )
+   {
+      //Skip the nodes that lie before the current position
+      if(node != NULL && node->last <= pos)
+      {
+         node = node->next;
+      }
+      else if(node != NULL && node->first <= pos)
+      {
+         //The fragment overlaps data that has already been received
+         overlap = TRUE;
+         pos = node->last;
+      }
+      else
+      {
+         //End of the hole
+         end = (node != NULL) ? MIN(node->first, dataLast) : dataLast;
 
-         //A matching entry has been found in the reassembly queue
-         return frag;
+         //Number of bytes that fill the hole
+         newLen += end - pos;
+         pos = end;
       }
    }
 
-   //If the current packet does not match an existing entry in the reassembly
-   //queue, then create a new entry
-   for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
+#if (IPV4_OVERLAPPING_FRAG_SUPPORT == DISABLED)
+   //Prevent overlapping fragment attacks (refer to RFC 8900, section 3.7).
+   //Exact duplicates are ignored
+   if(overlap && newLen > 0)
+      return ERROR_INVALID_PACKET;
+#else
+   //Overlapping data is accepted, but the data that has already been
+   //received takes precedence
+   (void) overlap;
+#endif
+
+   //Duplicate fragment?
+   if(newLen == 0)
+      return NO_ERROR;
+
+   //Walk through the holes again and fill them
+   for(pos = dataFirst, p = &frag->nodes; pos < dataLast; )
    {
-      //Point to the current entry in the reassembly queue
-      frag = &interface->ipv4Context.fragQueue[i];
+      //Point to the current node
+      node = *p;
 
-      //The current entry is free?
-      if(!frag->buffer.chunkCount)
+      //Skip the nodes that lie before the current position
+      if(node != NULL && node->last <= pos)
+      {
+         p = &node->next;
+      }
+      else if(node != NULL && node->first <= pos)
+      {
+         //Keep the data that has already been received
+         pos = node->last;
+         p = &node->next;
+      }
+      else
       {
-         //Number of chunks that comprise the reassembly buffer
-         frag->buffer.maxChunkCount = arraysize(frag->buffer.chunk);
+         //End of the hole (the node cannot hold more than a pool buffer)
+         end = (node != NULL) ? MIN(node->first, dataLast) : dataLast;
+         end = MIN(end, pos + IPV4_FRAG_NODE_DATA_SIZE);
 
-         //Allocate sufficient memory to hold the IPv4 header and
-         //the first hole descriptor
-         error = netBufferSetLength((NetBuffer *) &frag->buffer,
-            NET_MEM_POOL_BUFFER_SIZE + sizeof(Ipv4HoleDesc));
+         //Allocate a new node
+         newNode = ipv4AllocFragMem(interface, frag,
+            sizeof(Ipv4FragNode) + end - pos);
 
          //Failed to allocate memory?
-         if(error)
+         if(newNode == NULL)
+            return ERROR_OUT_OF_MEMORY;
+
+         //Copy the data from the fragment
+         newNode->first = pos;
+         newNode->last = end;
+         newNode->size = IPV4_FRAG_NODE_SIZE(end - pos);
+         osMemcpy(newNode->data, data + pos - dataFirst, end - pos);
+
+         //Insert the node in the list
+         newNode->next = node;
+         *p = newNode;
+         p = &newNode->next;
+
+         //Update the number of bytes received so far
+         frag->receivedLen += end - pos;
+         frag->nodeCount++;
+         pos = end;
+      }
+   }
+
+   //Merge the new data with the adjacent nodes
+   ipv4MergeFragNodes(interface, frag);
+
+   //Limit the number of data chunks that comprise the datagram
+   if(frag->nodeCount > IPV4_MAX_FRAG_CHUNKS)
+      return ERROR_OUT_OF_RESOURCES;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Merge contiguous fragment nodes
+ *
+ * Data are moved towards the beginning of each range of contiguous data, so
+ * that a node is filled before the next one is used. The number of chunks
+ * then depends on the size of the datagram rather than on the number of
+ * fragments, and the upper-layer header is never split across chunks
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv4 fragment descriptor
+ **/
+
+void ipv4MergeFragNodes(NetInterface *interface, Ipv4FragDesc *frag)
+{
+   size_t n;
+   size_t length;
+   Ipv4FragNode *node;
+   Ipv4FragNode *next;
+   Ipv4FragNode *newNode;
+   Ipv4FragNode **p;
+
+   //Loop through the fragment nodes
+   for(p = &frag->nodes; *p != NULL && (*p)->next != NULL; )
+   {
+      //Point to the current node and to the following one
+      node = *p;
+      next = node->next;
+
+      //Number of bytes held by the current node
+      length = node->last - node->first;
+
+      //Only contiguous data can be merged, and full nodes are left as is
+      if(next->first != node->last || length >= IPV4_FRAG_NODE_DATA_SIZE)
+      {
+         p = &node->next;
+         continue;
+      }
+
+      //Number of bytes to move from the following node
+      n = MIN(next->last - next->first, IPV4_FRAG_NODE_DATA_SIZE - length);
+
+      //The current node must be reallocated if it is too small
+      if((length + n) > node->size)
+      {
+         //Allocate a larger node
+         newNode = ipv4AllocFragMem(interface, frag,
+            sizeof(Ipv4FragNode) + length + n);
+
+         //Failed to allocate memory?
+         if(newNode == NULL)
          {
-            //Clean up side effects
-            netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-            //Exit immediately
-            return NULL;
+            p = &node->next;
+            continue;
          }
 
-         //Initial length of the reconstructed datagram
-         frag->headerLength = packet->headerLength * 4;
-         frag->dataLen = 0;
+         //Copy the contents of the current node
+         newNode->next = next;
+         newNode->first = node->first;
+         newNode->last = node->last;
+         newNode->size = IPV4_FRAG_NODE_SIZE(length + n);
+         osMemcpy(newNode->data, node->data, length);
+
+         //Replace the current node
+         *p = newNode;
+         ipv4FreeFragNode(interface, frag, node);
+         node = newNode;
+      }
+
+      //Move the data
+      osMemcpy(node->data + length, next->data, n);
+      node->last += n;
+
+      //The following node has been emptied?
+      if(node->last == next->last)
+      {
+         //Remove it from the list
+         node->next = next->next;
+         ipv4FreeFragNode(interface, frag, next);
+         frag->nodeCount--;
+      }
+      else
+      {
+         //The remaining data stay at the beginning of the node
+         osMemmove(next->data, next->data + n, next->last - node->last);
+         next->first = node->last;
+      }
+   }
+}
 
-         //Fix the length of the first chunk
-         frag->buffer.chunk[0].length = (uint16_t) frag->headerLength;
-         //Copy IPv4 header from the incoming fragment
-         netBufferWrite((NetBuffer *) &frag->buffer, 0, packet, frag->headerLength);
 
-         //Save current time
-         frag->timestamp = osGetSystemTime();
-         //Create a new entry in the hole descriptor list
-         frag->firstHole = 0;
+/**
+ * @brief Chain the fragment nodes to form the reassembled datagram
+ *
+ * The reassembly buffer refers to the IP header and to the data received
+ * from offset zero up to the first hole (the whole payload once the
+ * reassembly is complete)
+ *
+ * @param[in] frag IPv4 fragment descriptor
+ **/
 
-         //Point to first hole descriptor
-         hole = ipv4FindHole(frag, frag->firstHole);
-         //The entry describes the datagram as being completely missing
-         hole->first = 0;
-         hole->last = IPV4_INFINITY;
-         hole->next = IPV4_INFINITY;
+void ipv4ChainFragments(Ipv4FragDesc *frag)
+{
+   uint_t i;
+   uint16_t pos;
+   Ipv4FragNode *node;
 
-         //Dump hole descriptor list
-         ipv4DumpHoleList(frag);
+   //The first chunk holds the IP header
+   frag->buffer.chunk[0].address = frag->header->data;
+   frag->buffer.chunk[0].length = frag->header->last;
+   frag->buffer.chunk[0].size = 0;
 
-         //Return the matching fragment descriptor
-         return frag;
-      }
+   //Chain the nodes as long as the data is contiguous
+   for(i = 1, pos = 0, node = frag->nodes; node != NULL &&
+      node->first == pos && i < arraysize(frag->buffer.chunk); node = node->next)
+   {
+      //The memory is owned by the node
+      frag->buffer.chunk[i].address = node->data;
+      frag->buffer.chunk[i].length = node->last - node->first;
+      frag->buffer.chunk[i].size = 0;
+
+      //Next chunk
+      pos = node->last;
+      i++;
    }
 
-   //The reassembly queue is full
-   return NULL;
+   //Number of chunks that comprise the reassembled datagram
+   frag->buffer.chunkCount = i;
+   frag->buffer.maxChunkCount = i;
 }
 
 
 /**
- * @brief Flush IPv4 reassembly queue
+ * @brief Allocate memory for the reassembly queue
+ *
+ * The memory used by the reassembly queue is bounded. The oldest datagrams
+ * are discarded whenever the limit is reached
+ *
  * @param[in] interface Underlying network interface
+ * @param[in] frag Fragment descriptor the memory is allocated for (NULL when
+ *   allocating a new descriptor)
+ * @param[in] size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
  **/
 
-void ipv4FlushFragQueue(NetInterface *interface)
+void *ipv4AllocFragMem(NetInterface *interface, Ipv4FragDesc *frag,
+   size_t size)
 {
    uint_t i;
+   size_t n;
+   void *p;
+   Ipv4FragDesc *entry;
+   Ipv4FragDesc *oldestEntry;
 
-   //Loop through the reassembly queue
-   for(i = 0; i < IPV4_MAX_FRAG_DATAGRAMS; i++)
+   //When the memory pool is used, each allocation consumes a whole buffer
+   n = IPV4_FRAG_MEM_SIZE(size);
+
+   //Make room for the new allocation
+   while((interface->ipv4Context.fragMemUsage + n) > IPV4_FRAG_MAX_MEMORY)
    {
-      //Drop any partially reconstructed datagram
-      netBufferSetLength((NetBuffer *) &interface->ipv4Context.fragQueue[i].buffer, 0);
+      //Keep track of the oldest datagram
+      oldestEntry = NULL;
+
+      //Loop through the reassembly queue
+      for(i = 0; i < IPV4_FRAG_HASH_TABLE_SIZE; i++)
+      {
+         for(entry = interface->ipv4Context.fragQueue[i]; entry != NULL;
+            entry = entry->next)
+         {
+            //The datagram being reassembled is never discarded
+            if(entry != frag && (oldestEntry == NULL ||
+               timeCompare(entry->timestamp, oldestEntry->timestamp) < 0))
+            {
+               oldestEntry = entry;
+            }
+         }
+      }
+
+      //No datagram can be discarded?
+      if(oldestEntry == NULL)
+         return NULL;
+
+      //Number of failures detected by the IP reassembly algorithm
+      MIB2_IP_INC_COUNTER32(ipReasmFails, 1);
+      IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsReasmFails, 1);
+      IP_MIB_INC_COUNTER32(ipv4IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
+
+      //Drop the oldest partially reconstructed datagram
+      ipv4DeleteFragDesc(interface, oldestEntry);
+   }
+
+   //Allocate a memory block
+   p = memPoolAlloc(size);
+
+   //Successful memory allocation?
+   if(p != NULL)
+   {
+      //Update the amount of memory used by the reassembly queue
+      interface->ipv4Context.fragMemUsage += n;
+
+      //Update the amount of memory used by the datagram
+      if(frag != NULL)
+      {
+         frag->memUsage += n;
+      }
    }
+
+   //Return a pointer to the allocated memory
+   return p;
+}
+
+
+/**
+ * @brief Release a fragment node
+ * @param[in] interface Underlying network interface
+ * @param[in] frag Fragment descriptor the node belongs to
+ * @param[in] node Fragment node to be released
+ **/
+
+void ipv4FreeFragNode(NetInterface *interface, Ipv4FragDesc *frag,
+   Ipv4FragNode *node)
+{
+   size_t n;
+
+   //Amount of memory charged for the node
+   n = IPV4_FRAG_MEM_SIZE(sizeof(Ipv4FragNode) + node->size);
+
+   //Update the amount of memory used by the reassembly queue
+   interface->ipv4Context.fragMemUsage -= n;
+   frag->memUsage -= n;
+
+   //Release the node
+   memPoolFree(node);
 }
 
 
 /**
- * @brief Retrieve hole descriptor
+ * @brief Remove a datagram from the reassembly queue
+ * @param[in] interface Underlying network interface
  * @param[in] frag IPv4 fragment descriptor
- * @param[in] offset Offset of the hole
- * @return A pointer to the hole descriptor is returned if the specified
- *   offset is valid. Otherwise NULL is returned
  **/
 
-Ipv4HoleDesc *ipv4FindHole(Ipv4FragDesc *frag, uint16_t offset)
+void ipv4DeleteFragDesc(NetInterface *interface, Ipv4FragDesc *frag)
+{
+   Ipv4FragDesc **p;
+   Ipv4FragNode *node;
+
+   //Remove the entry from its hash bucket
+   for(p = &interface->ipv4Context.fragQueue[ipv4GetFragHashIndex(
+      frag->srcAddr, frag->destAddr, frag->identification, frag->protocol)];
+      *p != NULL; p = &(*p)->next)
+   {
+      if(*p == frag)
+      {
+         *p = frag->next;
+         break;
+      }
+   }
+
+   //Release the fragment nodes
+   while(frag->nodes != NULL)
+   {
+      node = frag->nodes;
+      frag->nodes = node->next;
+      memPoolFree(node);
+   }
+
+   //Release the IP header
+   if(frag->header != NULL)
+   {
+      memPoolFree(frag->header);
+   }
+
+   //Update the amount of memory used by the reassembly queue
+   interface->ipv4Context.fragMemUsage -= frag->memUsage;
+
+   //Release the descriptor
+   memPoolFree(frag);
+}
+
+
+/**
+ * @brief Compute the hash bucket of a datagram
+ * @param[in] srcAddr Source IPv4 address
+ * @param[in] destAddr Destination IPv4 address
+ * @param[in] identification Identification field
+ * @param[in] protocol Protocol field
+ * @return Index of the hash bucket
+ **/
+
+uint_t ipv4GetFragHashIndex(uint32_t srcAddr, uint32_t destAddr,
+   uint16_t identification, uint8_t protocol)
 {
-   //Return a pointer to the hole descriptor
-   return netBufferAt((NetBuffer *) &frag->buffer, frag->headerLength + offset, 0);
+   uint32_t h;
+
+   //Mix the fields that identify the datagram
+   h = srcAddr ^ destAddr ^ identification ^ ((uint32_t) protocol << 16);
+   h *= 0x9E3779B1;
+   h ^= h >> 16;
+
+   //Return the index of the hash bucket
+   return h % IPV4_FRAG_HASH_TABLE_SIZE;
 }
 
 
 /**
- * @brief Dump hole descriptor list
+ * @brief Dump the list of fragment nodes
  * @param[in] frag IPv4 fragment descriptor
  **/
 
-void ipv4DumpHoleList(Ipv4FragDesc *frag)
+void ipv4DumpFragList(Ipv4FragDesc *frag)
 {
 //Check debugging level
 #if (TRACE_LEVEL >= TRACE_LEVEL_DEBUG)
-   Ipv4HoleDesc *hole;
+   Ipv4FragNode *node;
 
    //Debug message
-   TRACE_DEBUG("Hole descriptor list:\r\n");
-   //Select the first hole descriptor from the list
-   hole = ipv4FindHole(frag, frag->firstHole);
+   TRACE_DEBUG("Fragment list:\r\n");
 
-   //Loop through the hole descriptor list
-   while(hole != NULL)
+   //Loop through the fragment nodes
+   for(node = frag->nodes; node != NULL; node = node->next)
    {
-      //Display current hole
-      TRACE_DEBUG("  %" PRIu16 " - %" PRIu16 "\r\n", hole->first, hole->last);
-      //Select the next hole descriptor from the list
-      hole = ipv4FindHole(frag, hole->next);
+      //Display current node
+      TRACE_DEBUG("  %" PRIu16 " - %" PRIu16 "\r\n", node->first, node->last);
    }
 #endif
 }
@@ -56,14 +56,6 @@
    #error IPV4_FRAG_TICK_INTERVAL parameter is not valid
 #endif
 
-//Maximum number of fragmented packets the host will accept
-//and hold in the reassembly queue simultaneously
-#ifndef IPV4_MAX_FRAG_DATAGRAMS
-   #define IPV4_MAX_FRAG_DATAGRAMS 4
-#elif (IPV4_MAX_FRAG_DATAGRAMS < 1)
-   #error IPV4_MAX_FRAG_DATAGRAMS parameter is not valid
-#endif
-
 //Maximum datagram size the host will accept when reassembling fragments
 #ifndef IPV4_MAX_FRAG_DATAGRAM_SIZE
    #define IPV4_MAX_FRAG_DATAGRAM_SIZE 8192
@@ -71,6 +63,27 @@
    #error IPV4_MAX_FRAG_DATAGRAM_SIZE parameter is not valid
 #endif
 
+//Maximum number of data chunks a reassembled datagram can consist of.
+//Contiguous data are merged, so the limit applies to the ranges of data
+//separated by holes
+#ifndef IPV4_MAX_FRAG_CHUNKS
+   #define IPV4_MAX_FRAG_CHUNKS 16
+#elif (IPV4_MAX_FRAG_CHUNKS < 1)
+   #error IPV4_MAX_FRAG_CHUNKS parameter is not valid
+#endif
+
+//Maximum amount of memory (in bytes) used by the reassembly queue
+#ifndef IPV4_FRAG_MAX_MEMORY
+   #define IPV4_FRAG_MAX_MEMORY (4 * IPV4_MAX_FRAG_DATAGRAM_SIZE)
+#endif
+
+//Size of the hash table used to search the reassembly queue
+#ifndef IPV4_FRAG_HASH_TABLE_SIZE
+   #define IPV4_FRAG_HASH_TABLE_SIZE 8
+#elif (IPV4_FRAG_HASH_TABLE_SIZE < 1)
+   #error IPV4_FRAG_HASH_TABLE_SIZE parameter is not valid
+#endif
+
 //Maximum time an IPv4 fragment can spend waiting to be reassembled
 #ifndef IPV4_FRAG_TIME_TO_LIVE
    #define IPV4_FRAG_TIME_TO_LIVE 15000
@@ -78,8 +91,30 @@
    #error IPV4_FRAG_TIME_TO_LIVE parameter is not valid
 #endif
 
-//Infinity is implemented by a very large integer
-#define IPV4_INFINITY 0xFFFF
+//Maximum amount of data a single fragment node can hold
+#define IPV4_FRAG_NODE_DATA_SIZE ((NET_MEM_POOL_BUFFER_SIZE - sizeof(Ipv4FragNode)) & ~7U)
+
+//Amount of memory charged to the reassembly queue for an allocation, and
+//amount of data a node allocated for a given length can hold
+#if (NET_MEM_POOL_SUPPORT == ENABLED)
+   #define IPV4_FRAG_MEM_SIZE(size) NET_MEM_POOL_BUFFER_SIZE
+   #define IPV4_FRAG_NODE_SIZE(length) IPV4_FRAG_NODE_DATA_SIZE
+#else
+   #define IPV4_FRAG_MEM_SIZE(size) (size)
+   #define IPV4_FRAG_NODE_SIZE(length) (length)
+#endif
+
+//The reassembly queue must be able to hold a datagram made of the maximum
+//number of chunks, along with its descriptor and its header
+#if (NET_MEM_POOL_SUPPORT == ENABLED)
+   #if (IPV4_FRAG_MAX_MEMORY < ((IPV4_MAX_FRAG_CHUNKS + 2) * NET_MEM_POOL_BUFFER_SIZE))
+      #error IPV4_FRAG_MAX_MEMORY parameter is not valid
+   #endif
+#else
+   #if (IPV4_FRAG_MAX_MEMORY < IPV4_MAX_FRAG_DATAGRAM_SIZE)
+      #error IPV4_FRAG_MAX_MEMORY parameter is not valid
+   #endif
+#endif
 
 //C++ guard
 #ifdef __cplusplus
@@ -87,32 +122,18 @@ extern "C" {
 #endif
 
 
-//CC-RX, CodeWarrior or Win32 compiler?
-#if defined(__CCRX__)
-   #pragma pack
-#elif defined(__CWCC__) || defined(_WIN32)
-   #pragma pack(push, 1)
-#endif
-
-
 /**
- * @brief Hole descriptor
+ * @brief Fragment node
  **/
 
-typedef __packed_struct
+typedef struct _Ipv4FragNode
 {
-   uint16_t first;
-   uint16_t last;
-   uint16_t next;
-} Ipv4HoleDesc;
-
-
-//CC-RX, CodeWarrior or Win32 compiler?
-#if defined(__CCRX__)
-   #pragma unpack
-#elif defined(__CWCC__) || defined(_WIN32)
-   #pragma pack(pop)
-#endif
+   struct _Ipv4FragNode *next; ///<Next node (sorted by offset)
+   uint16_t first;             ///<Index of the first byte
+   uint16_t last;              ///<Index immediately following the last byte
+   uint16_t size;              ///<Number of bytes the node can hold
+   uint8_t data[];             ///<Fragment data
+} Ipv4FragNode;
 
 
 /**
@@ -123,7 +144,7 @@ typedef struct
 {
    uint_t chunkCount;
    uint_t maxChunkCount;
-   ChunkDesc chunk[N(IPV4_MAX_FRAG_DATAGRAM_SIZE) + 1];
+   ChunkDesc chunk[IPV4_MAX_FRAG_CHUNKS + 1];
 } Ipv4ReassemblyBuffer;
 
 
@@ -131,13 +152,22 @@ typedef struct
  * @brief Fragmented packet descriptor
  **/
 
-typedef struct
+typedef struct _Ipv4FragDesc
 {
+   struct _Ipv4FragDesc *next;  ///<Next entry in the same hash bucket
    systime_t timestamp;         ///<Time at which the first fragment was received
-   size_t headerLength;         ///<Length of the header
-   size_t dataLen;              ///<Length of the payload
-   uint16_t firstHole;          ///<Index of the first hole
-   Ipv4ReassemblyBuffer buffer; ///<Buffer containing the reassembled datagram
+   uint32_t srcAddr;            ///<Source IPv4 address
+   uint32_t destAddr;           ///<Destination IPv4 address
+   uint16_t identification;     ///<Identification field
+   uint8_t protocol;            ///<Protocol field
+   bool_t lastFrag;             ///<The last fragment has been received
+   size_t dataLen;              ///<Length of the payload (valid once the last fragment has been received)
+   size_t receivedLen;          ///<Number of payload bytes received so far
+   uint_t nodeCount;            ///<Number of fragment nodes
+   size_t memUsage;             ///<Amount of memory used by the entry
+   Ipv4FragNode *header;        ///<IPv4 header taken from the first fragment
+   Ipv4FragNode *nodes;         ///<Fragment nodes sorted by offset
+   Ipv4ReassemblyBuffer buffer; ///<Reassembled datagram (chained view of the fragment nodes)
 } Ipv4FragDesc;
 
 
@@ -147,7 +177,7 @@ extern systime_t ipv4FragTickCounter;
 //IPv4 datagram fragmentation and reassembly
 error_t ipv4FragmentDatagram(NetInterface *interface,
    const Ipv4PseudoHeader *pseudoHeader, uint16_t id, const NetBuffer *payload,
-   size_t payloadOffset, NetTxAncillary *ancillary);
+   size_t payloadOffset, size_t pathMtu, NetTxAncillary *ancillary);
 
 void ipv4ReassembleDatagram(NetInterface *interface, const Ipv4Header *packet,
    size_t length, NetRxAncillary *ancillary);
@@ -159,8 +189,24 @@ Ipv4FragDesc *ipv4SearchFragQueue(NetInterface *interface,
 
 void ipv4FlushFragQueue(NetInterface *interface);
 
-Ipv4HoleDesc *ipv4FindHole(Ipv4FragDesc *frag, uint16_t offset);
-void ipv4DumpHoleList(Ipv4FragDesc *frag);
+error_t ipv4InsertFragment(NetInterface *interface, Ipv4FragDesc *frag,
+   uint16_t dataFirst, const uint8_t *data, size_t length);
+
+void ipv4MergeFragNodes(NetInterface *interface, Ipv4FragDesc *frag);
+void ipv4ChainFragments(Ipv4FragDesc *frag);
+
+void *ipv4AllocFragMem(NetInterface *interface, Ipv4FragDesc *frag,
+   size_t size);
+
+void ipv4FreeFragNode(NetInterface *interface, Ipv4FragDesc *frag,
+   Ipv4FragNode *node);
+
+void ipv4DeleteFragDesc(NetInterface *interface, Ipv4FragDesc *frag);
+
+uint_t ipv4GetFragHashIndex(uint32_t srcAddr, uint32_t destAddr,
+   uint16_t identification, uint8_t protocol);
+
+void ipv4DumpFragList(Ipv4FragDesc *frag);
 
 //C++ guard
 #ifdef __cplusplus
@@ -0,0 +1,228 @@
+/**
+ * @file ipv4_pmtu.c
+ * @brief Path MTU Discovery for IPv4
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL IPV4_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "ipv4/ipv4.h"
+#include "ipv4/ipv4_pmtu.h"
+#include "core/tcp.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (IPV4_SUPPORT == ENABLED && (IPV4_PMTU_SUPPORT == ENABLED || \
+   (TCP_SUPPORT == ENABLED && TCP_PLPMTUD_SUPPORT == ENABLED)))
+
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+
+//PMTU cache
+static Ipv4PmtuCacheEntry ipv4PmtuCache[IPV4_PMTU_CACHE_SIZE];
+
+#endif
+
+//Common MTU values found on the Internet (refer to RFC 1191, section 7)
+static const uint16_t ipv4MtuPlateauTable[] =
+{
+   32000,
+   17914,
+   8166,
+   4352,
+   2002,
+   1492,
+   1006,
+   508,
+   296,
+   IPV4_MINIMUM_MTU
+};
+
+
+#if (IPV4_PMTU_SUPPORT == ENABLED)
+
+/**
+ * @brief Retrieve the PMTU for the specified path
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IPv4 address
+ * @return PMTU value
+ **/
+
+size_t ipv4GetPathMtu(NetInterface *interface, Ipv4Addr destAddr)
+{
+   uint_t i;
+   size_t pathMtu;
+   systime_t time;
+   Ipv4PmtuCacheEntry *entry;
+
+   //If no entry exists in the PMTU cache, the PMTU value for the path is
+   //assumed to be the MTU of the first-hop link
+   pathMtu = interface->ipv4Context.linkMtu;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Loop through the PMTU cache
+   for(i = 0; i < IPV4_PMTU_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &ipv4PmtuCache[i];
+
+      //Check whether the entry is in use
+      if(entry->interface != NULL)
+      {
+         //A PMTU estimate that has not been decreased recently is discarded,
+         //so that an increase in the PMTU can be discovered (refer to
+         //RFC 1191, section 6.3)
+         if((time - entry->timestamp) >= IPV4_PMTU_TIMEOUT)
+         {
+            //Release the entry
+            entry->interface = NULL;
+         }
+         else if(entry->interface == interface && entry->destAddr == destAddr)
+         {
+            //Use the existing PMTU estimate
+            pathMtu = MIN(entry->pathMtu, pathMtu);
+         }
+         else
+         {
+            //Just for sanity
+         }
+      }
+   }
+
+   //Return the PMTU value
+   return pathMtu;
+}
+
+
+/**
+ * @brief Update the PMTU for the specified path
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Destination IPv4 address
+ * @param[in] tentativePathMtu Tentative PMTU value
+ **/
+
+void ipv4UpdatePathMtu(NetInterface *interface, Ipv4Addr destAddr,
+   size_t tentativePathMtu)
+{
+   uint_t i;
+   systime_t time;
+   Ipv4PmtuCacheEntry *entry;
+   Ipv4PmtuCacheEntry *oldestEntry;
+
+   //A host must never reduce its estimate of the PMTU below 68 octets (refer
+   //to RFC 1191, section 3)
+   tentativePathMtu = MAX(tentativePathMtu, IPV4_MINIMUM_MTU);
+
+   //The PMTU cannot exceed the MTU of the first-hop link
+   if(tentativePathMtu >= interface->ipv4Context.linkMtu)
+      return;
+
+   //Get current time
+   time = osGetSystemTime();
+
+   //Keep track of the oldest entry
+   oldestEntry = &ipv4PmtuCache[0];
+
+   //Loop through the PMTU cache
+   for(i = 0; i < IPV4_PMTU_CACHE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &ipv4PmtuCache[i];
+
+      //Matching entry?
+      if(entry->interface == interface && entry->destAddr == destAddr)
+      {
+         //If the tentative PMTU is less than the existing PMTU estimate, the
+         //tentative PMTU replaces the existing PMTU
+         if(tentativePathMtu < entry->pathMtu)
+         {
+            entry->pathMtu = tentativePathMtu;
+            entry->timestamp = time;
+         }
+
+         //We are done
+         return;
+      }
+
+      //Keep track of the oldest entry (unused entries are preferred)
+      if(oldestEntry->interface != NULL)
+      {
+         if(entry->interface == NULL ||
+            timeCompare(entry->timestamp, oldestEntry->timestamp) < 0)
+         {
+            oldestEntry = entry;
+         }
+      }
+   }
+
+   //Debug message
+   TRACE_INFO("PMTU to %s reduced to %" PRIuSIZE " bytes\r\n",
+      ipv4AddrToString(destAddr, NULL), tentativePathMtu);
+
+   //Create a new entry
+   oldestEntry->interface = interface;
+   oldestEntry->destAddr = destAddr;
+   oldestEntry->pathMtu = tentativePathMtu;
+   oldestEntry->timestamp = time;
+}
+
+#endif
+
+
+/**
+ * @brief Estimate the PMTU when the router does not report the next-hop MTU
+ *
+ * The estimate is the largest plateau value that is less than the total
+ * length of the datagram that elicited the ICMP message (refer to RFC 1191,
+ * section 5)
+ *
+ * @param[in] length Total length of the original datagram
+ * @return PMTU estimate
+ **/
+
+size_t ipv4EstimatePathMtu(size_t length)
+{
+   uint_t i;
+
+   //Search the plateau table
+   for(i = 0; i < arraysize(ipv4MtuPlateauTable); i++)
+   {
+      //Find the largest plateau value that is less than the datagram length
+      if(ipv4MtuPlateauTable[i] < length)
+         break;
+   }
+
+   //Return the PMTU estimate
+   return (i < arraysize(ipv4MtuPlateauTable)) ? ipv4MtuPlateauTable[i] :
+      IPV4_MINIMUM_MTU;
+}
+
+#endif
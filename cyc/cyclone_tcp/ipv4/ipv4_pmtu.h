@@ -0,0 +1,91 @@
+/**
+ * @file ipv4_pmtu.h
+ * @brief Path MTU Discovery for IPv4
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+#ifndef _IPV4_PMTU_H
+#define _IPV4_PMTU_H
+
+//Dependencies
+#include "core/net.h"
+#include "ipv4/ipv4.h"
+
+//Path MTU discovery support
+#ifndef IPV4_PMTU_SUPPORT
+   #define IPV4_PMTU_SUPPORT DISABLED
+#elif (IPV4_PMTU_SUPPORT != ENABLED && IPV4_PMTU_SUPPORT != DISABLED)
+   #error IPV4_PMTU_SUPPORT parameter is not valid
+#endif
+
+//Size of the PMTU cache
+#ifndef IPV4_PMTU_CACHE_SIZE
+   #define IPV4_PMTU_CACHE_SIZE 8
+#elif (IPV4_PMTU_CACHE_SIZE < 1)
+   #error IPV4_PMTU_CACHE_SIZE parameter is not valid
+#endif
+
+//Lifetime of a PMTU estimate
+#ifndef IPV4_PMTU_TIMEOUT
+   #define IPV4_PMTU_TIMEOUT 600000
+#elif (IPV4_PMTU_TIMEOUT < 1000)
+   #error IPV4_PMTU_TIMEOUT parameter is not valid
+#endif
+
+//C++ guard
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief PMTU cache entry
+ **/
+
+typedef struct
+{
+   NetInterface *interface; ///<Underlying network interface
+   Ipv4Addr destAddr;       ///<Destination IPv4 address
+   size_t pathMtu;          ///<Path MTU
+   systime_t timestamp;     ///<Time at which the PMTU was learned
+} Ipv4PmtuCacheEntry;
+
+
+//Path MTU discovery related functions
+size_t ipv4GetPathMtu(NetInterface *interface, Ipv4Addr destAddr);
+
+void ipv4UpdatePathMtu(NetInterface *interface, Ipv4Addr destAddr,
+   size_t tentativePathMtu);
+
+size_t ipv4EstimatePathMtu(size_t length);
+
+//C++ guard
+#ifdef __cplusplus
+}
+#endif
+
+#endif
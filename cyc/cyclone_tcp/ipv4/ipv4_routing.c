@@ -0,0 +1,1107 @@
+/**
+ * @file ipv4_routing.c
+ * @brief IPv4 routing
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Routes are looked up with a multibit trie. Each level of the trie consumes
+ * 8 bits of the destination address, so that a lookup never takes more than
+ * four memory accesses, regardless of the number of routes. Prefixes whose
+ * length is not a multiple of the stride are expanded over the corresponding
+ * range of slots, and shorter prefixes are pushed down to the leaves when a
+ * node is split
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL IPV4_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "core/ethernet.h"
+#include "core/ip.h"
+#include "ipv4/ipv4.h"
+#include "ipv4/ipv4_misc.h"
+#include "ipv4/ipv4_routing.h"
+#include "ipv4/icmp.h"
+#include "ipv4/arp.h"
+#include "mibs/mib2_module.h"
+#include "mibs/ip_mib_module.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (IPV4_SUPPORT == ENABLED && IPV4_ROUTING_SUPPORT == ENABLED)
+
+//IPv4 routing table
+static Ipv4RoutingTableEntry ipv4RoutingTable[IPV4_ROUTING_TABLE_SIZE];
+//Root node of the trie
+static Ipv4RoutingTrieNode ipv4RoutingTrieRoot;
+//Pool of trie nodes
+static Ipv4RoutingTrieNode ipv4RoutingTrie[IPV4_ROUTING_TRIE_SIZE];
+//Number of trie nodes in use
+static uint_t ipv4RoutingTrieCount;
+
+
+/**
+ * @brief Initialize IPv4 routing table
+ * @return Error code
+ **/
+
+error_t ipv4InitRouting(void)
+{
+   //Clear the routing table
+   osMemset(ipv4RoutingTable, 0, sizeof(ipv4RoutingTable));
+   //Clear the trie
+   ipv4RebuildRoutingTrie();
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Enable routing for the specified interface
+ * @param[in] interface Underlying network interface
+ * @param[in] enable When the flag is set to TRUE, routing is enabled on the
+ *   interface and the router can forward packets to or from the interface
+ * @return Error code
+ **/
+
+error_t ipv4EnableRouting(NetInterface *interface, bool_t enable)
+{
+   //Check parameters
+   if(interface == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //Enable or disable routing
+   interface->ipv4Context.isRouter = enable;
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Add a new entry in the IPv4 routing table
+ * @param[in] networkDest Network destination
+ * @param[in] networkMask Subnet mask for this route
+ * @param[in] interface Network interface where to forward the packet
+ * @param[in] nextHop IPv4 address of the next hop (IPV4_UNSPECIFIED_ADDR
+ *   for a directly connected network)
+ * @param[in] metric Metric value
+ * @return Error code
+ **/
+
+error_t ipv4AddRoute(Ipv4Addr networkDest, Ipv4Addr networkMask,
+   NetInterface *interface, Ipv4Addr nextHop, uint_t metric)
+{
+   error_t error;
+   uint_t i;
+   uint_t prefixLen;
+   Ipv4RoutingTableEntry *entry;
+   Ipv4RoutingTableEntry *firstFreeEntry;
+
+   //Check parameters
+   if(interface == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Retrieve the length of the prefix
+   prefixLen = ipv4GetPrefixLength(networkMask);
+
+   //The subnet mask must be made of contiguous bits
+   if(prefixLen < 32 && networkMask != htonl(~(0xFFFFFFFFU >> prefixLen)))
+      return ERROR_INVALID_PARAMETER;
+
+   //Discard the host part of the network destination
+   networkDest &= networkMask;
+
+   //Keep track of the first free entry
+   firstFreeEntry = NULL;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Loop through routing table entries
+   for(i = 0; i < IPV4_ROUTING_TABLE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &ipv4RoutingTable[i];
+
+      //Valid entry?
+      if(entry->valid)
+      {
+         //Check whether the current entry matches the specified destination
+         if(entry->networkDest == networkDest &&
+            entry->networkMask == networkMask)
+         {
+            break;
+         }
+      }
+      else
+      {
+         //Keep track of the first free entry
+         if(firstFreeEntry == NULL)
+            firstFreeEntry = entry;
+      }
+   }
+
+   //Existing route?
+   if(i < IPV4_ROUTING_TABLE_SIZE)
+   {
+      //The trie already refers to the entry, so that the route can be updated
+      //in place
+      entry->interface = interface;
+      entry->nextHop = nextHop;
+      entry->metric = metric;
+
+      //Successful processing
+      error = NO_ERROR;
+   }
+   else if(firstFreeEntry != NULL)
+   {
+      //Point to the free entry
+      entry = firstFreeEntry;
+
+      //Save route parameters
+      entry->networkDest = networkDest;
+      entry->networkMask = networkMask;
+      entry->interface = interface;
+      entry->nextHop = nextHop;
+      entry->metric = metric;
+      //The entry is now valid
+      entry->valid = TRUE;
+
+      //Insert the route in the trie
+      error = ipv4InsertRoute(entry - ipv4RoutingTable);
+
+      //The trie runs out of nodes?
+      if(error)
+      {
+         //The trie is left untouched, so that the entry can be deleted
+         entry->valid = FALSE;
+      }
+   }
+   else
+   {
+      //The routing table is full
+      error = ERROR_FAILURE;
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Remove an entry from the IPv4 routing table
+ * @param[in] networkDest Network destination
+ * @param[in] networkMask Subnet mask for this route
+ * @return Error code
+ **/
+
+error_t ipv4DeleteRoute(Ipv4Addr networkDest, Ipv4Addr networkMask)
+{
+   error_t error;
+   uint_t i;
+   Ipv4RoutingTableEntry *entry;
+
+   //Initialize status code
+   error = ERROR_NOT_FOUND;
+
+   //Discard the host part of the network destination
+   networkDest &= networkMask;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Loop through routing table entries
+   for(i = 0; i < IPV4_ROUTING_TABLE_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &ipv4RoutingTable[i];
+
+      //Valid entry?
+      if(entry->valid)
+      {
+         //Check whether the current entry matches the specified destination
+         if(entry->networkDest == networkDest &&
+            entry->networkMask == networkMask)
+         {
+            //Delete current entry
+            entry->valid = FALSE;
+            //The route was successfully deleted from the routing table
+            error = NO_ERROR;
+         }
+      }
+   }
+
+   //Any route deleted?
+   if(!error)
+   {
+      //Shorter prefixes must take over the slots owned by the deleted route
+      ipv4RebuildRoutingTrie();
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Delete all routes from the IPv4 routing table
+ * @return Error code
+ **/
+
+error_t ipv4DeleteAllRoutes(void)
+{
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+   //Clear the routing table
+   osMemset(ipv4RoutingTable, 0, sizeof(ipv4RoutingTable));
+   //Clear the trie
+   ipv4RebuildRoutingTrie();
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Forward an IPv4 packet
+ *
+ * When the packet is held in a single buffer that provides room for the
+ * link-layer header, it is forwarded in place: the TTL is decremented, the
+ * header checksum is updated incrementally and the buffer is handed to the
+ * outgoing interface without being copied. The original contents of the
+ * buffer are restored before the function returns
+ *
+ * @param[in] srcInterface Network interface on which the packet was received
+ * @param[in] ipPacket Multi-part buffer that holds the IPv4 packet to forward
+ * @param[in] ipPacketOffset Offset to the first byte of the IPv4 packet
+ * @return Error code
+ **/
+
+error_t ipv4ForwardPacket(NetInterface *srcInterface, NetBuffer *ipPacket,
+   size_t ipPacketOffset)
+{
+   error_t error;
+   bool_t inPlace;
+   uint8_t ttl;
+   uint16_t checksum;
+   uint32_t temp;
+   size_t length;
+   size_t headerLen;
+   size_t destOffset;
+   NetInterface *destInterface;
+   NetBuffer *destBuffer;
+   Ipv4Header *ipHeader;
+   Ipv4RoutingTableEntry *entry;
+   Ipv4Addr destIpAddr;
+#if (ETH_SUPPORT == ENABLED)
+   NetInterface *physicalInterface;
+#endif
+
+   //If routing is not enabled on the interface, then the router cannot
+   //forward packets from the interface
+   if(!srcInterface->ipv4Context.isRouter)
+      return ERROR_FAILURE;
+
+   //Calculate the length of the IPv4 packet
+   length = netBufferGetLength(ipPacket) - ipPacketOffset;
+
+   //Ensure the packet length is greater than 20 bytes
+   if(length < sizeof(Ipv4Header))
+      return ERROR_INVALID_LENGTH;
+
+   //Point to the IPv4 header
+   ipHeader = netBufferAt(ipPacket, ipPacketOffset, sizeof(Ipv4Header));
+   //Sanity check
+   if(ipHeader == NULL)
+      return ERROR_FAILURE;
+
+   //Retrieve the length of the header
+   headerLen = ipHeader->headerLength * 4;
+
+   //Check the length of the packet
+   if(headerLen < sizeof(Ipv4Header) || ntohs(ipHeader->totalLength) < headerLen ||
+      ntohs(ipHeader->totalLength) > length)
+   {
+      return ERROR_INVALID_HEADER;
+   }
+
+   //Discard the link-layer padding, if any
+   length = ntohs(ipHeader->totalLength);
+
+   //The header must be contiguous in memory
+   if(netBufferAt(ipPacket, ipPacketOffset, headerLen) == NULL)
+      return ERROR_FAILURE;
+
+   //A router must verify the IP header checksum before forwarding the packet
+   //(refer to RFC 1812, section 5.2.2)
+   if(ipCalcChecksum(ipHeader, headerLen) != 0x0000)
+   {
+      //Number of input datagrams discarded due to errors in their IP headers
+      MIB2_IP_INC_COUNTER32(ipInHdrErrors, 1);
+      IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsInHdrErrors, 1);
+
+      //Discard the packet
+      return ERROR_INVALID_HEADER;
+   }
+
+   //Multicast forwarding is not supported. Packets sent to a limited or
+   //directed broadcast address are not forwarded either
+   if(ipv4IsMulticastAddr(ipHeader->destAddr) ||
+      ipv4IsBroadcastAddr(srcInterface, ipHeader->destAddr))
+   {
+      return ERROR_INVALID_ADDRESS;
+   }
+
+   //A router must not forward a packet whose destination address is the
+   //unspecified address or a loopback address (refer to RFC 1812, section
+   //5.3.7)
+   if(ipHeader->destAddr == IPV4_UNSPECIFIED_ADDR ||
+      ipv4IsLocalHostAddr(ipHeader->destAddr))
+   {
+      return ERROR_INVALID_ADDRESS;
+   }
+
+   //Packets with a link-local source or destination address must not be
+   //forwarded (refer to RFC 3927, section 7)
+   if(ipv4IsLinkLocalAddr(ipHeader->srcAddr) ||
+      ipv4IsLinkLocalAddr(ipHeader->destAddr))
+   {
+      return ERROR_INVALID_ADDRESS;
+   }
+
+   //Search the trie for the longest matching prefix
+   entry = ipv4FindRoute(ipHeader->destAddr);
+
+   //Outgoing interface on which to forward the packet
+   if(entry != NULL && entry->interface->ipv4Context.isRouter &&
+      ipv4IsHostAddrValid(entry->interface))
+   {
+      destInterface = entry->interface;
+   }
+   else
+   {
+      destInterface = NULL;
+   }
+
+   //No route to the destination?
+   if(destInterface == NULL)
+   {
+      //Number of IP datagrams discarded because no route could be found
+      MIB2_IP_INC_COUNTER32(ipOutNoRoutes, 1);
+      IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsOutNoRoutes, 1);
+
+      //A Destination Unreachable message should be generated by a router
+      //in response to a packet that cannot be delivered
+      icmpSendErrorMessage(srcInterface, ICMP_TYPE_DEST_UNREACHABLE,
+         ICMP_CODE_NET_UNREACHABLE, 0, ipPacket, ipPacketOffset);
+
+      //Exit immediately
+      return ERROR_NO_ROUTE;
+   }
+
+   //Directed broadcasts are not forwarded onto the destination network
+   //(refer to RFC 2644)
+   if(ipv4IsBroadcastAddr(destInterface, ipHeader->destAddr))
+      return ERROR_INVALID_ADDRESS;
+
+   //Next hop
+   if(entry->nextHop != IPV4_UNSPECIFIED_ADDR)
+   {
+      destIpAddr = entry->nextHop;
+   }
+   else
+   {
+      destIpAddr = ipHeader->destAddr;
+   }
+
+   //Time-to-live exceeded in transit?
+   if(ipHeader->timeToLive <= 1)
+   {
+      //If the TTL is reduced to zero, the router must discard the packet and
+      //send an ICMP Time Exceeded message (refer to RFC 1812, section 5.3.1)
+      icmpSendErrorMessage(srcInterface, ICMP_TYPE_TIME_EXCEEDED,
+         ICMP_CODE_TTL_EXCEEDED, 0, ipPacket, ipPacketOffset);
+
+      //Exit immediately
+      return ERROR_FAILURE;
+   }
+
+   //The packet cannot be fragmented while it is larger than the MTU of the
+   //outgoing link?
+   if(length > destInterface->ipv4Context.linkMtu &&
+      (ntohs(ipHeader->fragmentOffset) & IPV4_FLAG_DF) != 0)
+   {
+      //The router must discard the packet and return an ICMP Destination
+      //Unreachable message with a code meaning "fragmentation needed and DF
+      //set" (refer to RFC 1191, section 4)
+      icmpSendErrorMessage(srcInterface, ICMP_TYPE_DEST_UNREACHABLE,
+         ICMP_CODE_FRAG_NEEDED_AND_DF_SET, 0, ipPacket, ipPacketOffset);
+
+      //Exit immediately
+      return ERROR_INVALID_LENGTH;
+   }
+
+   //Save the original TTL and checksum
+   ttl = ipHeader->timeToLive;
+   checksum = ipHeader->headerChecksum;
+
+   //Every time a router forwards a packet, it decrements the TTL field
+   ipHeader->timeToLive--;
+
+   //The TTL is the upper byte of a 16-bit word, so that the header checksum
+   //can be updated incrementally (refer to RFC 1624, section 3)
+   temp = (~ntohs(checksum) & 0xFFFF) + 0xFEFF;
+   temp = (temp & 0xFFFF) + (temp >> 16);
+   ipHeader->headerChecksum = htons(~temp & 0xFFFF);
+
+   //Debug message
+   TRACE_INFO("Forwarding IPv4 packet to %s (%" PRIuSIZE " bytes)...\r\n",
+      destInterface->name, length);
+   //Dump IP header contents for debugging purpose
+   ipv4DumpHeader(ipHeader);
+
+   //The packet does not fit in the MTU of the outgoing link?
+   if(length > destInterface->ipv4Context.linkMtu)
+   {
+      //Fragment the packet
+      error = ipv4ForwardFragments(destInterface, destIpAddr, ipPacket,
+         ipPacketOffset, destInterface->ipv4Context.linkMtu);
+   }
+   else
+   {
+      //Forward the packet in place whenever possible
+      inPlace = FALSE;
+
+#if (ETH_SUPPORT == ENABLED)
+      //Point to the physical interface
+      physicalInterface = nicGetPhysicalInterface(destInterface);
+
+      //The Ethernet header can be formatted in front of the packet, and the
+      //frame does not need to be extended?
+      if(ipPacket->chunkCount == 1 && ipPacketOffset >= sizeof(EthHeader) &&
+         netBufferGetLength(ipPacket) == (ipPacketOffset + length) &&
+         physicalInterface->nicDriver != NULL &&
+         physicalInterface->nicDriver->type == NIC_TYPE_ETHERNET &&
+         physicalInterface->nicDriver->autoCrcCalc &&
+         (physicalInterface->nicDriver->autoPadding ||
+         (sizeof(EthHeader) + length) >= (ETH_MIN_FRAME_SIZE - ETH_CRC_SIZE)))
+      {
+         inPlace = TRUE;
+
+#if (ETH_VLAN_SUPPORT == ENABLED)
+         //A VLAN tag would have to be inserted
+         if(nicGetVlanId(destInterface) != 0)
+            inPlace = FALSE;
+#endif
+#if (ETH_VMAN_SUPPORT == ENABLED)
+         //A VMAN tag would have to be inserted
+         if(nicGetVmanId(destInterface) != 0)
+            inPlace = FALSE;
+#endif
+#if (ETH_PORT_TAGGING_SUPPORT == ENABLED)
+         //A switch port tag would have to be inserted
+         if(physicalInterface->switchDriver != NULL &&
+            physicalInterface->switchDriver->tagFrame != NULL)
+         {
+            inPlace = FALSE;
+         }
+#endif
+      }
+#endif
+
+      //Forward the packet in place?
+      if(inPlace)
+      {
+         uint8_t linkHeader[sizeof(EthHeader)];
+
+         //Save the link-layer header of the received frame
+         netBufferRead(linkHeader, ipPacket, ipPacketOffset - sizeof(EthHeader),
+            sizeof(EthHeader));
+
+         //Send the packet without copying it
+         error = ipv4SendForwardedPacket(destInterface, destIpAddr, ipPacket,
+            ipPacketOffset);
+
+         //Restore the link-layer header
+         netBufferWrite(ipPacket, ipPacketOffset - sizeof(EthHeader),
+            linkHeader, sizeof(EthHeader));
+      }
+      else
+      {
+         //Allocate a buffer to hold the IPv4 packet
+         destBuffer = ethAllocBuffer(length, &destOffset);
+
+         //Successful memory allocation?
+         if(destBuffer != NULL)
+         {
+            //Copy the IPv4 packet
+            error = netBufferCopy(destBuffer, destOffset, ipPacket,
+               ipPacketOffset, length);
+
+            //Check status code
+            if(!error)
+            {
+               //Send the packet
+               error = ipv4SendForwardedPacket(destInterface, destIpAddr,
+                  destBuffer, destOffset);
+            }
+
+            //Free previously allocated memory
+            netBufferFree(destBuffer);
+         }
+         else
+         {
+            //Failed to allocate memory
+            error = ERROR_OUT_OF_MEMORY;
+         }
+      }
+   }
+
+   //Restore the original TTL and checksum
+   ipHeader->timeToLive = ttl;
+   ipHeader->headerChecksum = checksum;
+
+   //Check status code
+   if(!error)
+   {
+      //Number of datagrams forwarded to their final destination
+      MIB2_IP_INC_COUNTER32(ipForwDatagrams, 1);
+      IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsInForwDatagrams, 1);
+      IP_MIB_INC_COUNTER64(ipv4SystemStats.ipSystemStatsHCInForwDatagrams, 1);
+      IP_MIB_INC_COUNTER32(ipv4SystemStats.ipSystemStatsOutForwDatagrams, 1);
+      IP_MIB_INC_COUNTER64(ipv4SystemStats.ipSystemStatsHCOutForwDatagrams, 1);
+   }
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Send a forwarded IPv4 packet to the next hop
+ * @param[in] interface Outgoing network interface
+ * @param[in] nextHop IPv4 address of the next hop
+ * @param[in] buffer Multi-part buffer that holds the IPv4 packet
+ * @param[in] offset Offset to the first byte of the IPv4 packet
+ * @return Error code
+ **/
+
+error_t ipv4SendForwardedPacket(NetInterface *interface, Ipv4Addr nextHop,
+   NetBuffer *buffer, size_t offset)
+{
+   error_t error;
+   NetTxAncillary ancillary;
+#if (ETH_SUPPORT == ENABLED)
+   NetInterface *physicalInterface;
+#endif
+
+   //Additional options can be passed to the stack along with the packet
+   ancillary = NET_DEFAULT_TX_ANCILLARY;
+
+#if (ETH_SUPPORT == ENABLED)
+   //Point to the physical interface
+   physicalInterface = nicGetPhysicalInterface(interface);
+
+   //Ethernet interface?
+   if(physicalInterface->nicDriver != NULL &&
+      physicalInterface->nicDriver->type == NIC_TYPE_ETHERNET)
+   {
+      //Resolve the address of the next hop
+      error = arpResolve(interface, nextHop, &ancillary.destMacAddr);
+
+      //Successful address resolution?
+      if(!error)
+      {
+         //Send Ethernet frame
+         error = ethSendFrame(interface, &ancillary.destMacAddr, ETH_TYPE_IPV4,
+            buffer, offset, &ancillary);
+      }
+      //Address resolution in progress?
+      else if(error == ERROR_IN_PROGRESS)
+      {
+         //Enqueue packets waiting for address resolution (the packet is
+         //copied to the queue)
+         error = arpEnqueuePacket(interface, nextHop, buffer, offset,
+            &ancillary);
+      }
+      //Address resolution failed?
+      else
+      {
+         //Debug message
+         TRACE_WARNING("Cannot map IPv4 address to Ethernet address!\r\n");
+      }
+   }
+   else
+#endif
+#if (PPP_SUPPORT == ENABLED)
+   //PPP interface?
+   if(interface->nicDriver != NULL &&
+      interface->nicDriver->type == NIC_TYPE_PPP)
+   {
+      //Send PPP frame
+      error = pppSendFrame(interface, buffer, offset, PPP_PROTOCOL_IP);
+   }
+   else
+#endif
+   //IPv4 interface?
+   if(interface->nicDriver != NULL &&
+      interface->nicDriver->type == NIC_TYPE_IPV4)
+   {
+      //Send the packet over the specified link
+      error = nicSendPacket(interface, buffer, offset, &ancillary);
+   }
+   //Unknown interface type?
+   else
+   {
+      //Report an error
+      error = ERROR_INVALID_INTERFACE;
+   }
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Fragment a forwarded IPv4 packet
+ *
+ * The first fragment carries all the options of the original packet. The
+ * subsequent fragments only carry the options whose copied flag is set
+ * (refer to RFC 791, section 3.1)
+ *
+ * @param[in] interface Outgoing network interface
+ * @param[in] nextHop IPv4 address of the next hop
+ * @param[in] ipPacket Multi-part buffer that holds the IPv4 packet
+ * @param[in] ipPacketOffset Offset to the first byte of the IPv4 packet
+ * @param[in] mtu MTU of the outgoing link
+ * @return Error code
+ **/
+
+error_t ipv4ForwardFragments(NetInterface *interface, Ipv4Addr nextHop,
+   const NetBuffer *ipPacket, size_t ipPacketOffset, size_t mtu)
+{
+   error_t error;
+   uint16_t flags;
+   size_t n;
+   size_t offset;
+   size_t length;
+   size_t headerLen;
+   size_t optionLen;
+   size_t fragHeaderLen;
+   size_t destOffset;
+   NetBuffer *destBuffer;
+   Ipv4Header *ipHeader;
+   Ipv4Header *fragHeader;
+   uint8_t options[IPV4_MAX_HEADER_LENGTH - sizeof(Ipv4Header)];
+
+   //Point to the IPv4 header
+   ipHeader = netBufferAt(ipPacket, ipPacketOffset, sizeof(Ipv4Header));
+   //Sanity check
+   if(ipHeader == NULL)
+      return ERROR_FAILURE;
+
+   //Retrieve the length of the header and the length of the payload
+   headerLen = ipHeader->headerLength * 4;
+   length = ntohs(ipHeader->totalLength) - headerLen;
+
+   //The header must be contiguous in memory
+   if(netBufferAt(ipPacket, ipPacketOffset, headerLen) == NULL)
+      return ERROR_FAILURE;
+
+   //Options to be copied into the subsequent fragments
+   optionLen = ipv4GetCopiedOptions(ipHeader->options,
+      headerLen - sizeof(Ipv4Header), options);
+
+   //Fragment offset and MF flag of the original packet
+   flags = ntohs(ipHeader->fragmentOffset) & (IPV4_FLAG_MF | IPV4_OFFSET_MASK);
+
+   //Initialize status code
+   error = NO_ERROR;
+
+   //Split the payload into fragments
+   for(offset = 0; offset < length && !error; offset += n)
+   {
+      //Length of the header of the fragment
+      if(offset == 0)
+      {
+         fragHeaderLen = headerLen;
+      }
+      else
+      {
+         fragHeaderLen = sizeof(Ipv4Header) + optionLen;
+      }
+
+      //The payload of all fragments but the last one must be a multiple of
+      //8 bytes
+      n = MIN(length - offset, (mtu - fragHeaderLen) & ~7U);
+
+      //Sanity check
+      if(n == 0)
+         return ERROR_INVALID_LENGTH;
+
+      //Allocate a buffer to hold the fragment
+      destBuffer = ethAllocBuffer(fragHeaderLen + n, &destOffset);
+      //Failed to allocate memory?
+      if(destBuffer == NULL)
+         return ERROR_OUT_OF_MEMORY;
+
+      //Copy the header of the original packet (the options of the subsequent
+      //fragments are formatted separately)
+      error = netBufferCopy(destBuffer, destOffset, ipPacket, ipPacketOffset,
+         (offset == 0) ? headerLen : sizeof(Ipv4Header));
+
+      //Check status code
+      if(!error)
+      {
+         //Copy the payload of the fragment
+         error = netBufferCopy(destBuffer, destOffset + fragHeaderLen,
+            ipPacket, ipPacketOffset + headerLen + offset, n);
+      }
+
+      //Check status code
+      if(!error)
+      {
+         //Point to the header of the fragment
+         fragHeader = netBufferAt(destBuffer, destOffset, fragHeaderLen);
+
+         //The subsequent fragments carry the options that must be copied
+         if(offset != 0)
+         {
+            osMemcpy(fragHeader->options, options, optionLen);
+         }
+
+         //Format the header of the fragment
+         fragHeader->headerLength = fragHeaderLen / 4;
+         fragHeader->totalLength = htons(fragHeaderLen + n);
+         fragHeader->fragmentOffset = htons((flags & IPV4_OFFSET_MASK) +
+            (offset / 8));
+
+         //All fragments but the last one have the MF flag set
+         if((offset + n) < length || (flags & IPV4_FLAG_MF) != 0)
+         {
+            fragHeader->fragmentOffset |= HTONS(IPV4_FLAG_MF);
+         }
+
+         //Calculate the header checksum of the fragment
+         fragHeader->headerChecksum = 0;
+         fragHeader->headerChecksum = ipCalcChecksum(fragHeader, fragHeaderLen);
+
+         //Send the fragment
+         error = ipv4SendForwardedPacket(interface, nextHop, destBuffer,
+            destOffset);
+      }
+
+      //Free previously allocated memory
+      netBufferFree(destBuffer);
+   }
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Extract the options that must be copied into every fragment
+ * @param[in] options Options of the original packet
+ * @param[in] length Length of the options
+ * @param[out] buffer Buffer where to copy the options
+ * @return Length of the copied options, padded to a multiple of 4 bytes
+ **/
+
+size_t ipv4GetCopiedOptions(const uint8_t *options, size_t length,
+   uint8_t *buffer)
+{
+   size_t i;
+   size_t n;
+   size_t optionLen;
+
+   //Loop through the options
+   for(i = 0, n = 0; i < length; i += optionLen)
+   {
+      //End of option list?
+      if(options[i] == IPV4_OPTION_EEOL)
+         break;
+
+      //No operation?
+      if(options[i] == IPV4_OPTION_NOP)
+      {
+         //The NOP option is a single byte, and its copied flag is not set
+         optionLen = 1;
+      }
+      else
+      {
+         //Malformed option?
+         if((i + 1) >= length || options[i + 1] < sizeof(Ipv4Option) ||
+            (i + options[i + 1]) > length)
+         {
+            break;
+         }
+
+         //Retrieve the length of the option
+         optionLen = options[i + 1];
+
+         //Check whether the option must be copied
+         if((options[i] & IPV4_OPTION_COPIED_FLAG) != 0)
+         {
+            osMemcpy(buffer + n, options + i, optionLen);
+            n += optionLen;
+         }
+      }
+   }
+
+   //The header must be padded to a 32-bit boundary
+   while((n % 4) != 0)
+   {
+      buffer[n++] = IPV4_OPTION_EEOL;
+   }
+
+   //Return the length of the copied options
+   return n;
+}
+
+
+/**
+ * @brief Search the routing table for the longest matching prefix
+ * @param[in] destAddr Destination IPv4 address
+ * @return Pointer to the matching route, if any
+ **/
+
+Ipv4RoutingTableEntry *ipv4FindRoute(Ipv4Addr destAddr)
+{
+   uint_t i;
+   uint32_t addr;
+   Ipv4RoutingTrieNode *node;
+   Ipv4RoutingTrieSlot *slot;
+
+   //Convert the address to host byte order
+   addr = ntohl(destAddr);
+
+   //Start with the root node
+   node = &ipv4RoutingTrieRoot;
+
+   //Walk down the trie
+   for(i = 0; ; i++)
+   {
+      //Point to the slot that covers the address
+      slot = &node->slot[(addr >> (24 - i * IPV4_ROUTING_TRIE_STRIDE)) & 0xFF];
+
+      //Leaf reached?
+      if(!slot->child)
+         break;
+
+      //Jump to the child node
+      node = &ipv4RoutingTrie[slot->index];
+   }
+
+   //Return the matching route, if any
+   return (slot->index != 0) ? &ipv4RoutingTable[slot->index - 1] : NULL;
+}
+
+
+/**
+ * @brief Insert a route in the trie
+ * @param[in] index Index of the route in the routing table
+ * @return Error code
+ **/
+
+error_t ipv4InsertRoute(uint_t index)
+{
+   uint_t i;
+   uint_t n;
+   uint_t level;
+   uint_t depth;
+   uint_t first;
+   uint_t prefixLen;
+   uint32_t addr;
+   Ipv4RoutingTrieNode *node;
+   Ipv4RoutingTrieNode *child;
+   Ipv4RoutingTrieSlot *slot;
+
+   //Retrieve the prefix
+   addr = ntohl(ipv4RoutingTable[index].networkDest);
+   prefixLen = ipv4GetPrefixLength(ipv4RoutingTable[index].networkMask);
+
+   //Level of the trie at which the prefix ends
+   depth = (prefixLen > 0) ? (prefixLen - 1) / IPV4_ROUTING_TRIE_STRIDE : 0;
+
+   //Start with the root node
+   node = &ipv4RoutingTrieRoot;
+
+   //Count the nodes that must be allocated, so that the trie is left
+   //untouched when it runs out of nodes
+   for(n = 0, level = 0; level < depth; level++)
+   {
+      //Point to the slot that covers the prefix
+      slot = &node->slot[(addr >> (24 - level * IPV4_ROUTING_TRIE_STRIDE)) & 0xFF];
+
+      //The slot does not point to a child node yet?
+      if(!slot->child)
+      {
+         //A new node is needed for each of the remaining levels
+         n = depth - level;
+         break;
+      }
+
+      //Jump to the child node
+      node = &ipv4RoutingTrie[slot->index];
+   }
+
+   //The trie runs out of nodes?
+   if((ipv4RoutingTrieCount + n) > IPV4_ROUTING_TRIE_SIZE)
+      return ERROR_OUT_OF_RESOURCES;
+
+   //Start with the root node
+   node = &ipv4RoutingTrieRoot;
+
+   //Walk down the trie
+   for(level = 0; ; level++)
+   {
+      //The prefix ends at the current level?
+      if(prefixLen <= ((level + 1) * IPV4_ROUTING_TRIE_STRIDE))
+         break;
+
+      //Point to the slot that covers the prefix
+      slot = &node->slot[(addr >> (24 - level * IPV4_ROUTING_TRIE_STRIDE)) & 0xFF];
+
+      //The slot does not point to a child node yet?
+      if(!slot->child)
+      {
+         //Allocate a new node
+         child = &ipv4RoutingTrie[ipv4RoutingTrieCount];
+
+         //The route that owned the slot covers the whole child node
+         for(i = 0; i < IPV4_ROUTING_TRIE_SLOTS; i++)
+         {
+            child->slot[i] = *slot;
+         }
+
+         //Link the child node to the slot
+         slot->index = ipv4RoutingTrieCount++;
+         slot->prefixLen = 0;
+         slot->child = TRUE;
+      }
+
+      //Jump to the child node
+      node = &ipv4RoutingTrie[slot->index];
+   }
+
+   //Number of slots covered by the prefix at this level
+   n = 1U << ((level + 1) * IPV4_ROUTING_TRIE_STRIDE - prefixLen);
+   //Index of the first slot
+   first = (addr >> (24 - level * IPV4_ROUTING_TRIE_STRIDE)) & 0xFF & ~(n - 1);
+
+   //Expand the prefix
+   for(i = 0; i < n; i++)
+   {
+      ipv4FillTrieSlot(&node->slot[first + i], index + 1, prefixLen);
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Assign a route to a slot unless a longer prefix owns it
+ * @param[in] slot Pointer to the slot
+ * @param[in] index Index of the route plus one
+ * @param[in] prefixLen Length of the prefix
+ **/
+
+void ipv4FillTrieSlot(Ipv4RoutingTrieSlot *slot, uint_t index,
+   uint_t prefixLen)
+{
+   uint_t i;
+   Ipv4RoutingTrieNode *node;
+
+   //The slot points to a child node?
+   if(slot->child)
+   {
+      //Point to the child node
+      node = &ipv4RoutingTrie[slot->index];
+
+      //Longer prefixes may own some of the slots of the child node
+      for(i = 0; i < IPV4_ROUTING_TRIE_SLOTS; i++)
+      {
+         ipv4FillTrieSlot(&node->slot[i], index, prefixLen);
+      }
+   }
+   else if(slot->index == 0 || slot->prefixLen <= prefixLen)
+   {
+      //The route is the longest matching prefix for this slot
+      slot->index = index;
+      slot->prefixLen = prefixLen;
+   }
+   else
+   {
+      //A longer prefix owns the slot
+   }
+}
+
+
+/**
+ * @brief Rebuild the trie from the routing table
+ **/
+
+void ipv4RebuildRoutingTrie(void)
+{
+   uint_t i;
+
+   //Clear the trie
+   osMemset(&ipv4RoutingTrieRoot, 0, sizeof(ipv4RoutingTrieRoot));
+   ipv4RoutingTrieCount = 0;
+
+   //Loop through routing table entries
+   for(i = 0; i < IPV4_ROUTING_TABLE_SIZE; i++)
+   {
+      //Valid entry?
+      if(ipv4RoutingTable[i].valid)
+      {
+         //The number of nodes only depends on the set of prefixes. The trie
+         //held all these routes before, so that the insertion cannot fail
+         ipv4InsertRoute(i);
+      }
+   }
+}
+
+#endif
@@ -42,13 +42,34 @@
    #error IPV4_ROUTING_SUPPORT parameter is not valid
 #endif
 
-//Size of the IPv4 routing table
+//Size of the IPv4 routing table. The table is scanned linearly when routes
+//are added or deleted, whereas the lookup cost does not depend on its size
 #ifndef IPV4_ROUTING_TABLE_SIZE
    #define IPV4_ROUTING_TABLE_SIZE 8
-#elif (IPV4_ROUTING_TABLE_SIZE < 1)
+#elif (IPV4_ROUTING_TABLE_SIZE < 1 || IPV4_ROUTING_TABLE_SIZE > 65534)
    #error IPV4_ROUTING_TABLE_SIZE parameter is not valid
 #endif
 
+//Number of nodes of the longest-prefix-match trie (excluding the root node).
+//Each node takes 1 KB and covers one 8-bit level of a given prefix. Routes
+//sharing their upper bits share the same nodes: a /24 route needs up to 2
+//nodes, and a /32 route up to 3 nodes. For instance, thousands of /24 routes
+//spread over a few /16 blocks only need one node per /16 block, plus one
+//node per /8 block
+#ifndef IPV4_ROUTING_TRIE_SIZE
+   #define IPV4_ROUTING_TRIE_SIZE 8
+#elif (IPV4_ROUTING_TRIE_SIZE < 1 || IPV4_ROUTING_TRIE_SIZE > 65535)
+   #error IPV4_ROUTING_TRIE_SIZE parameter is not valid
+#endif
+
+//Number of address bits consumed at each level of the trie
+#define IPV4_ROUTING_TRIE_STRIDE 8
+//Number of slots per trie node
+#define IPV4_ROUTING_TRIE_SLOTS (1U << IPV4_ROUTING_TRIE_STRIDE)
+
+//Options with this flag set must be copied into all fragments
+#define IPV4_OPTION_COPIED_FLAG 0x80
+
 //C++ guard
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +91,31 @@ typedef struct
 } Ipv4RoutingTableEntry;
 
 
+/**
+ * @brief Slot of a trie node
+ *
+ * A slot either points to a child node or holds the longest prefix that
+ * covers the corresponding address range (leaf pushing)
+ **/
+
+typedef struct
+{
+   uint16_t index;    ///<Index of the child node, or index of the route plus one
+   uint8_t prefixLen; ///<Length of the prefix that owns the slot
+   uint8_t child;     ///<The slot points to a child node
+} Ipv4RoutingTrieSlot;
+
+
+/**
+ * @brief Trie node
+ **/
+
+typedef struct
+{
+   Ipv4RoutingTrieSlot slot[IPV4_ROUTING_TRIE_SLOTS];
+} Ipv4RoutingTrieNode;
+
+
 //IPv4 routing related functions
 error_t ipv4InitRouting(void);
 error_t ipv4EnableRouting(NetInterface *interface, bool_t enable);
@@ -80,9 +126,25 @@ error_t ipv4AddRoute(Ipv4Addr networkDest, Ipv4Addr networkMask,
 error_t ipv4DeleteRoute(Ipv4Addr networkDest, Ipv4Addr networkMask);
 error_t ipv4DeleteAllRoutes(void);
 
-error_t ipv4ForwardPacket(NetInterface *srcInterface, const NetBuffer *ipPacket,
+error_t ipv4ForwardPacket(NetInterface *srcInterface, NetBuffer *ipPacket,
    size_t ipPacketOffset);
 
+error_t ipv4SendForwardedPacket(NetInterface *interface, Ipv4Addr nextHop,
+   NetBuffer *buffer, size_t offset);
+
+error_t ipv4ForwardFragments(NetInterface *interface, Ipv4Addr nextHop,
+   const NetBuffer *ipPacket, size_t ipPacketOffset, size_t mtu);
+
+size_t ipv4GetCopiedOptions(const uint8_t *options, size_t length,
+   uint8_t *buffer);
+
+Ipv4RoutingTableEntry *ipv4FindRoute(Ipv4Addr destAddr);
+
+error_t ipv4InsertRoute(uint_t index);
+void ipv4FillTrieSlot(Ipv4RoutingTrieSlot *slot, uint_t index,
+   uint_t prefixLen);
+void ipv4RebuildRoutingTrie(void);
+
 //C++ guard
 #ifdef __cplusplus
 }
@@ -45,6 +45,7 @@
 #include "ipv6/ipv6_pmtu.h"
 #include "ipv6/ipv6_misc.h"
 #include "ipv6/icmpv6.h"
+#include "core/tcp_misc.h"
 #include "ipv6/ndp.h"
 #include "ipv6/ndp_router_adv_misc.h"
 #include "mld/mld_node_misc.h"
@@ -307,7 +308,8 @@ void icmpv6ProcessPacketTooBig(NetInterface *interface,
    size_t length;
    Icmpv6PacketTooBigMessage *icmpHeader;
 
-#if (IPV6_PMTU_SUPPORT == ENABLED)
+#if (IPV6_PMTU_SUPPORT == ENABLED || (TCP_SUPPORT == ENABLED && \
+   TCP_PLPMTUD_SUPPORT == ENABLED))
    uint32_t tentativePathMtu;
    Ipv6Header *ipHeader;
 #endif
@@ -331,7 +333,8 @@ void icmpv6ProcessPacketTooBig(NetInterface *interface,
    //Dump message contents for debugging purpose
    icmpv6DumpPacketTooBigMessage(icmpHeader);
 
-#if (IPV6_PMTU_SUPPORT == ENABLED)
+#if (IPV6_PMTU_SUPPORT == ENABLED || (TCP_SUPPORT == ENABLED && \
+   TCP_PLPMTUD_SUPPORT == ENABLED))
    //Move to the beginning of the original IPv6 packet
    offset += sizeof(Icmpv6PacketTooBigMessage);
    length -= sizeof(Icmpv6PacketTooBigMessage);
@@ -351,9 +354,39 @@ void icmpv6ProcessPacketTooBig(NetInterface *interface,
    //message as a tentative PMTU value
    tentativePathMtu = ntohl(icmpHeader->mtu);
 
+#if (IPV6_PMTU_SUPPORT == ENABLED)
    //Update the PMTU for the specified destination address
    ipv6UpdatePathMtu(interface, &ipHeader->destAddr, tentativePathMtu);
 #endif
+
+#if (TCP_SUPPORT == ENABLED && TCP_PLPMTUD_SUPPORT == ENABLED)
+   //The invoking packet is a TCP segment with no extension header?
+   if(ipHeader->nextHeader == IPV6_TCP_HEADER)
+   {
+      IpAddr srcAddr;
+      IpAddr destAddr;
+      TcpHeader *tcpHeader;
+
+      //Point to the quoted TCP header (ports and sequence number)
+      tcpHeader = netBufferAt(buffer, offset + sizeof(Ipv6Header), 8);
+
+      //Notify the TCP connection the segment belongs to
+      if(tcpHeader != NULL)
+      {
+         //The PMTU cannot be lower than the minimum link MTU
+         tentativePathMtu = MAX(tentativePathMtu, IPV6_DEFAULT_MTU);
+
+         srcAddr.length = sizeof(Ipv6Addr);
+         srcAddr.ipv6Addr = ipHeader->srcAddr;
+         destAddr.length = sizeof(Ipv6Addr);
+         destAddr.ipv6Addr = ipHeader->destAddr;
+
+         tcpUpdatePathMtu(interface, &srcAddr, &destAddr, tcpHeader,
+            tentativePathMtu);
+      }
+   }
+#endif
+#endif
 }
 
 
@@ -133,6 +133,7 @@ error_t ipv6Init(NetInterface *interface)
    context->identification = 0;
    //Initialize the reassembly queue
    osMemset(context->fragQueue, 0, sizeof(context->fragQueue));
+   context->fragMemUsage = 0;
 #endif
 
    //Successful initialization
@@ -1081,8 +1082,35 @@ void ipv6ProcessPacket(NetInterface *interface, NetBuffer *ipPacket,
       //Invalid destination address?
       if(error)
       {
-         //Forward the packet according to the routing table
-         ipv6ForwardPacket(interface, ipPacket, ipPacketOffset);
+#if (ETH_SUPPORT == ENABLED)
+         //The packet was received in a single Ethernet frame?
+         if(ipPacket->chunkCount == 1 && ipPacket->chunk[0].size == 0 &&
+            ipPacketOffset == 0 &&
+            nicGetPhysicalInterface(interface)->nicDriver != NULL &&
+            nicGetPhysicalInterface(interface)->nicDriver->type == NIC_TYPE_ETHERNET)
+         {
+            NetBuffer1 buffer;
+
+            //The Ethernet header of the received frame precedes the packet,
+            //so that the router can forward the packet in place
+            buffer.chunkCount = 1;
+            buffer.maxChunkCount = 1;
+            buffer.chunk[0].address = (uint8_t *) ipPacket->chunk[0].address -
+               sizeof(EthHeader);
+            buffer.chunk[0].length = (uint16_t) (sizeof(EthHeader) +
+               MIN(length, sizeof(Ipv6Header) + ntohs(ipHeader->payloadLen)));
+            buffer.chunk[0].size = 0;
+
+            //Forward the packet according to the routing table
+            ipv6ForwardPacket(interface, (NetBuffer *) &buffer,
+               sizeof(EthHeader));
+         }
+         else
+#endif
+         {
+            //Forward the packet according to the routing table
+            ipv6ForwardPacket(interface, ipPacket, ipPacketOffset);
+         }
       }
 #endif
    }
@@ -508,7 +508,8 @@ typedef struct
    Ipv6FilterEntry multicastFilter[IPV6_MULTICAST_FILTER_SIZE]; ///<Multicast filter table
 #if (IPV6_FRAG_SUPPORT == ENABLED)
    uint32_t identification;                                     ///<IPv6 fragment identification field
-   Ipv6FragDesc fragQueue[IPV6_MAX_FRAG_DATAGRAMS];             ///<IPv6 fragment reassembly queue
+   Ipv6FragDesc *fragQueue[IPV6_FRAG_HASH_TABLE_SIZE];          ///<IPv6 fragment reassembly queue
+   size_t fragMemUsage;                                         ///<Memory used by the reassembly queue
 #endif
 } Ipv6Context;
 
@@ -187,8 +187,7 @@ void ipv6ParseFragmentHeader(NetInterface *interface, const NetBuffer *ipPacket,
    uint16_t dataFirst;
    uint16_t dataLast;
    Ipv6FragDesc *frag;
-   Ipv6HoleDesc *hole;
-   Ipv6HoleDesc *prevHole;
+   Ipv6FragNode *node;
    Ipv6Header *ipHeader;
    Ipv6FragmentHeader *fragHeader;
 
@@ -277,263 +276,165 @@ void ipv6ParseFragmentHeader(NetInterface *interface, const NetBuffer *ipPacket,
       return;
    }
 
-   //The very first fragment requires special handling
-   if((offset & IPV6_OFFSET_MASK) == 0)
+   //Length of the unfragmentable part of the reconstructed datagram
+   if(frag->header != NULL)
    {
-      uint8_t *p;
+      n = frag->header->last;
+   }
+   else
+   {
+      n = fragHeaderOffset - ipPacketOffset;
+   }
 
-      //Calculate the length of the unfragmentable part
-      frag->unfragPartLength = fragHeaderOffset - ipPacketOffset;
+   //The size of the reconstructed datagram exceeds the maximum value?
+   if((n + dataLast) > IPV6_MAX_FRAG_DATAGRAM_SIZE)
+   {
+      //Retrieve the offset of the Fragment header within the packet
+      n = fragHeaderOffset - ipPacketOffset;
+      //Compute the exact offset of the Fragment Offset field
+      n += (uint8_t *) &fragHeader->fragmentOffset - (uint8_t *) fragHeader;
 
-      //The size of the reconstructed datagram exceeds the maximum value?
-      if((frag->unfragPartLength + frag->fragPartLength) > IPV6_MAX_FRAG_DATAGRAM_SIZE)
-      {
-         //Number of failures detected by the IP reassembly algorithm
-         IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
+      //The fragment must be discarded and an ICMP Parameter Problem
+      //message should be sent to the source of the fragment, pointing
+      //to the Fragment Offset field of the fragment packet
+      icmpv6SendErrorMessage(interface, ICMPV6_TYPE_PARAM_PROBLEM,
+         ICMPV6_CODE_INVALID_HEADER_FIELD, n, ipPacket, ipPacketOffset);
 
-         //Retrieve the offset of the Fragment header within the packet
-         n = fragHeaderOffset - ipPacketOffset;
-         //Compute the exact offset of the Fragment Offset field
-         n += (uint8_t *) &fragHeader->fragmentOffset - (uint8_t *) fragHeader;
-
-         //The fragment must be discarded and an ICMP Parameter Problem
-         //message should be sent to the source of the fragment, pointing
-         //to the Fragment Offset field of the fragment packet
-         icmpv6SendErrorMessage(interface, ICMPV6_TYPE_PARAM_PROBLEM,
-            ICMPV6_CODE_INVALID_HEADER_FIELD, n, ipPacket, ipPacketOffset);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+      //Report an error
+      error = ERROR_INVALID_LENGTH;
+   }
+   else if((offset & IPV6_FLAG_M) == 0)
+   {
+      //The last fragment determines the length of the fragmentable part. Any
+      //data beyond that point is inconsistent
+      for(node = frag->nodes; node != NULL && node->next != NULL;
+         node = node->next)
+      {
       }
 
-      //Make sure the unfragmentable part entirely fits in the first chunk
-      if(frag->unfragPartLength > frag->buffer.chunk[0].size)
+      //Check whether the length of the fragmentable part is consistent
+      if(frag->lastFrag && dataLast != frag->fragPartLength)
       {
-         //Number of failures detected by the IP reassembly algorithm
-         IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         error = ERROR_INCONSISTENT_VALUE;
       }
+      else if(node != NULL && node->last > dataLast)
+      {
+         error = ERROR_INCONSISTENT_VALUE;
+      }
+      else
+      {
+         //Actual length of the fragmentable part
+         frag->fragPartLength = dataLast;
+         frag->lastFrag = TRUE;
 
-      //Fix the length of the first chunk
-      frag->buffer.chunk[0].length = (uint16_t) frag->unfragPartLength;
-
-      //The unfragmentable part of the reassembled packet consists of all
-      //headers up to, but not including, the Fragment header of the first
-      //fragment packet
-      netBufferCopy((NetBuffer *) &frag->buffer, 0, ipPacket,
-         ipPacketOffset, frag->unfragPartLength);
-
-      //Point to the Next Header field of the last header
-      p = netBufferAt((NetBuffer *) &frag->buffer,
-         nextHeaderOffset - ipPacketOffset, 0);
-
-      //The Next Header field of the last header of the unfragmentable part is
-      //obtained from the Next Header field of the first fragment's Fragment
-      //header
-      *p = fragHeader->nextHeader;
+         //Successful processing
+         error = NO_ERROR;
+      }
    }
-
-   //It may be necessary to increase the size of the buffer
-   if(dataLast > frag->fragPartLength)
+   else
    {
-      //The size of the reconstructed datagram exceeds the maximum value?
-      if((frag->unfragPartLength + dataLast) > IPV6_MAX_FRAG_DATAGRAM_SIZE)
+      //Fragments cannot extend beyond the end of the fragmentable part
+      if(frag->lastFrag && dataLast > frag->fragPartLength)
       {
-         //Number of failures detected by the IP reassembly algorithm
-         IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-
-         //Retrieve the offset of the Fragment header within the packet
-         n = fragHeaderOffset - ipPacketOffset;
-         //Compute the exact offset of the Fragment Offset field
-         n += (uint8_t *) &fragHeader->fragmentOffset - (uint8_t *) fragHeader;
-
-         //The fragment must be discarded and an ICMP Parameter Problem
-         //message should be sent to the source of the fragment, pointing
-         //to the Fragment Offset field of the fragment packet
-         icmpv6SendErrorMessage(interface, ICMPV6_TYPE_PARAM_PROBLEM,
-            ICMPV6_CODE_INVALID_HEADER_FIELD, n, ipPacket, ipPacketOffset);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         error = ERROR_INCONSISTENT_VALUE;
       }
-
-      //Adjust the size of the reconstructed datagram
-      error = netBufferSetLength((NetBuffer *) &frag->buffer,
-         frag->unfragPartLength + dataLast + sizeof(Ipv6HoleDesc));
-
-      //Any error to report?
-      if(error)
+      else
       {
-         //Number of failures detected by the IP reassembly algorithm
-         IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-
-         //Drop the reconstructed datagram
-         netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-         //Exit immediately
-         return;
+         error = NO_ERROR;
       }
-
-      //Actual length of the fragmentable part
-      frag->fragPartLength = dataLast;
    }
 
-   //Select the first hole descriptor from the list
-   hole = ipv6FindHole(frag, frag->firstHole);
-   //Keep track of the previous hole in the list
-   prevHole = NULL;
-
-   //Iterate through the hole descriptors
-   while(hole != NULL)
+   //Check status code
+   if(!error)
    {
-      //Save lower and upper boundaries for later use
-      uint16_t holeFirst = hole->first;
-      uint16_t holeLast = hole->last;
-
-      //Check whether the newly arrived fragment interacts with this hole
-      //in some way
-      if(dataFirst < holeLast && dataLast > holeFirst)
+      //The very first fragment requires special handling
+      if(dataFirst == 0 && frag->header == NULL)
       {
-#if (IPV6_OVERLAPPING_FRAG_SUPPORT == DISABLED)
-         //When reassembling an IPv6 datagram, if one or more its constituent
-         //fragments is determined to be an overlapping fragment, the entire
-         //datagram must be silently discarded (refer to RFC 5722, section 4)
-         if(dataFirst < holeFirst || dataLast > holeLast)
-         {
-            //Number of failures detected by the IP reassembly algorithm
-            IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
-            IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
+         //Calculate the length of the unfragmentable part
+         n = fragHeaderOffset - ipPacketOffset;
 
-            //Drop the reconstructed datagram
-            netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-            //Exit immediately
-            return;
-         }
-#endif
-         //The current descriptor is no longer valid. We will destroy it, and in
-         //the next two steps, we will determine whether or not it is necessary
-         //to create any new hole descriptors
-         if(prevHole != NULL)
+         //Make sure the unfragmentable part entirely fits in a single node
+         if((sizeof(Ipv6FragNode) + n) <= NET_MEM_POOL_BUFFER_SIZE)
          {
-            prevHole->next = hole->next;
-         }
-         else
-         {
-            frag->firstHole = hole->next;
+            //Allocate a node to hold the unfragmentable part
+            frag->header = ipv6AllocFragMem(interface, frag,
+               sizeof(Ipv6FragNode) + n);
          }
 
-         //Is there still a hole at the beginning of the segment?
-         if(dataFirst > holeFirst)
+         //Successful memory allocation?
+         if(frag->header != NULL)
          {
-            //Create a new entry that describes this hole
-            hole = ipv6FindHole(frag, holeFirst);
-            hole->first = holeFirst;
-            hole->last = dataFirst;
-
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
-
-            //Always keep track of the previous hole
-            prevHole = hole;
+            //The unfragmentable part of the reassembled packet consists of all
+            //headers up to, but not including, the Fragment header of the first
+            //fragment packet
+            frag->header->next = NULL;
+            frag->header->first = 0;
+            frag->header->last = (uint16_t) n;
+            frag->header->size = (uint16_t) IPV6_FRAG_NODE_SIZE(n);
+            netBufferRead(frag->header->data, ipPacket, ipPacketOffset, n);
+
+            //The Next Header field of the last header of the unfragmentable
+            //part is obtained from the Next Header field of the first
+            //fragment's Fragment header
+            frag->header->data[nextHeaderOffset - ipPacketOffset] =
+               fragHeader->nextHeader;
          }
-
-         //Is there still a hole at the end of the segment?
-         if(dataLast < holeLast && (offset & IPV6_FLAG_M) != 0)
+         else
          {
-            //Create a new entry that describes this hole
-            hole = ipv6FindHole(frag, dataLast);
-            hole->first = dataLast;
-            hole->last = holeLast;
-
-            //Insert the newly created entry into the hole descriptor list
-            if(prevHole != NULL)
-            {
-               hole->next = prevHole->next;
-               prevHole->next = hole->first;
-            }
-            else
-            {
-               hole->next = frag->firstHole;
-               frag->firstHole = hole->first;
-            }
-
-            //Always keep track of the previous hole
-            prevHole = hole;
+            //Failed to allocate memory
+            error = ERROR_OUT_OF_MEMORY;
          }
       }
-      else
-      {
-         //The newly arrived fragment does not interact with the current hole
-         prevHole = hole;
-      }
+   }
 
-      //Select the next hole descriptor from the list
-      hole = ipv6FindHole(frag, prevHole ? prevHole->next : frag->firstHole);
+   //Check status code
+   if(!error)
+   {
+      //Add the data to the list of fragment nodes
+      error = ipv6InsertFragment(interface, frag, dataFirst, ipPacket,
+         fragHeaderOffset + sizeof(Ipv6FragmentHeader), length);
    }
 
-   //Copy data from the fragment to the reassembly buffer
-   netBufferCopy((NetBuffer *) &frag->buffer, frag->unfragPartLength + dataFirst,
-      ipPacket, fragHeaderOffset + sizeof(Ipv6FragmentHeader), length);
+   //Any error to report?
+   if(error)
+   {
+      //Number of failures detected by the IP reassembly algorithm
+      IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
+      IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
+
+      //Drop the partially reconstructed datagram
+      ipv6DeleteFragDesc(interface, frag);
+      //Exit immediately
+      return;
+   }
 
-   //Dump hole descriptor list
-   ipv6DumpHoleList(frag);
+   //Dump the list of fragment nodes
+   ipv6DumpFragList(frag);
 
-   //If the hole descriptor list is empty, the reassembly process is now
-   //complete
-   if(ipv6FindHole(frag, frag->firstHole) == NULL)
+   //The reassembly process is complete when the first and the last fragments
+   //have been received and there is no hole between them
+   if(frag->header != NULL && frag->lastFrag &&
+      frag->receivedLen == frag->fragPartLength)
    {
-      //Discard the extra hole descriptor that follows the reconstructed
-      //datagram
-      error = netBufferSetLength((NetBuffer *) &frag->buffer,
-         frag->unfragPartLength + frag->fragPartLength);
+      //Build the reassembled datagram without copying the data
+      ipv6ChainFragments(frag);
 
-      //Check status code
-      if(error)
-      {
-         //Number of failures detected by the IP reassembly algorithm
-         IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
-         IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
-      }
-      else
-      {
-         //Point to the IPv6 header
-         Ipv6Header *datagram = netBufferAt((NetBuffer *) &frag->buffer, 0, 0);
+      //Point to the IPv6 header
+      ipHeader = (Ipv6Header *) frag->header->data;
 
-         //Fix the Payload Length field
-         datagram->payloadLen = htons(frag->unfragPartLength +
-            frag->fragPartLength - sizeof(Ipv6Header));
+      //Fix the Payload Length field
+      ipHeader->payloadLen = htons(frag->header->last +
+         frag->fragPartLength - sizeof(Ipv6Header));
 
-         //Number of IP datagrams successfully reassembled
-         IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmOKs, 1);
-         IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmOKs, 1);
+      //Number of IP datagrams successfully reassembled
+      IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmOKs, 1);
+      IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmOKs, 1);
 
-         //Pass the original IPv6 datagram to the higher protocol layer
-         ipv6ProcessPacket(interface, (NetBuffer *) &frag->buffer, 0,
-            ancillary);
-      }
+      //Pass the original IPv6 datagram to the higher protocol layer
+      ipv6ProcessPacket(interface, (NetBuffer *) &frag->buffer, 0, ancillary);
 
       //Release previously allocated memory
-      netBufferSetLength((NetBuffer *) &frag->buffer, 0);
+      ipv6DeleteFragDesc(interface, frag);
    }
 }
 
@@ -549,59 +450,53 @@ void ipv6ParseFragmentHeader(NetInterface *interface, const NetBuffer *ipPacket,
 
 void ipv6FragTick(NetInterface *interface)
 {
-   error_t error;
    uint_t i;
    systime_t time;
-   Ipv6HoleDesc *hole;
+   Ipv6FragDesc *frag;
+   Ipv6FragDesc *next;
 
    //Get current time
    time = osGetSystemTime();
 
    //Loop through the reassembly queue
-   for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
+   for(i = 0; i < IPV6_FRAG_HASH_TABLE_SIZE; i++)
    {
-      //Point to the current entry in the reassembly queue
-      Ipv6FragDesc *frag = &interface->ipv6Context.fragQueue[i];
-
-      //Make sure the entry is currently in use
-      if(frag->buffer.chunkCount > 0)
+      //Loop through the entries of the current hash bucket
+      for(frag = interface->ipv6Context.fragQueue[i]; frag != NULL; frag = next)
       {
+         //The entry may be deleted
+         next = frag->next;
+
          //If the timer runs out, the partially-reassembled datagram must be
          //discarded and ICMPv6 Time Exceeded message sent to the source host
          if((time - frag->timestamp) >= IPV6_FRAG_TIME_TO_LIVE)
          {
             //Debug message
             TRACE_INFO("IPv6 fragment reassembly timeout...\r\n");
-            //Dump IP header contents for debugging purpose
-            ipv6DumpHeader(frag->buffer.chunk[0].address);
 
             //Number of failures detected by the IP reassembly algorithm
             IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
             IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
 
-            //Point to the first hole descriptor
-            hole = ipv6FindHole(frag, frag->firstHole);
-
             //Make sure the fragment zero has been received before sending an
             //ICMPv6 message
-            if(hole != NULL && hole->first > 0)
+            if(frag->header != NULL)
             {
-               //Fix the size of the reconstructed datagram
-               error = netBufferSetLength((NetBuffer *) &frag->buffer,
-                  frag->unfragPartLength + hole->first);
-
-               //Check status code
-               if(!error)
-               {
-                  //Send an ICMPv6 Time Exceeded message
-                  icmpv6SendErrorMessage(interface, ICMPV6_TYPE_TIME_EXCEEDED,
-                     ICMPV6_CODE_REASSEMBLY_TIME_EXCEEDED, 0,
-                     (NetBuffer *) &frag->buffer, 0);
-               }
+               //Dump IP header contents for debugging purpose
+               ipv6DumpHeader((Ipv6Header *) frag->header->data);
+
+               //The message carries the leading data of the datagram, up to
+               //the first hole
+               ipv6ChainFragments(frag);
+
+               //Send an ICMPv6 Time Exceeded message
+               icmpv6SendErrorMessage(interface, ICMPV6_TYPE_TIME_EXCEEDED,
+                  ICMPV6_CODE_REASSEMBLY_TIME_EXCEEDED, 0,
+                  (NetBuffer *) &frag->buffer, 0);
             }
 
             //Drop the partially reconstructed datagram
-            netBufferSetLength((NetBuffer *) &frag->buffer, 0);
+            ipv6DeleteFragDesc(interface, frag);
          }
       }
    }
@@ -619,158 +514,546 @@ void ipv6FragTick(NetInterface *interface)
 Ipv6FragDesc *ipv6SearchFragQueue(NetInterface *interface,
    const Ipv6Header *packet, const Ipv6FragmentHeader *header)
 {
-   error_t error;
    uint_t i;
-   Ipv6Header *datagram;
    Ipv6FragDesc *frag;
-   Ipv6HoleDesc *hole;
+
+   //Only the entries that belong to the matching hash bucket are searched
+   i = ipv6GetFragHashIndex(packet->srcAddr.b, packet->destAddr.b,
+      header->identification);
 
    //Search for a matching IP datagram being reassembled
-   for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
+   for(frag = interface->ipv6Context.fragQueue[i]; frag != NULL;
+      frag = frag->next)
    {
-      //Point to the current entry in the reassembly queue
-      frag = &interface->ipv6Context.fragQueue[i];
+      //Check source and destination addresses
+      if(osMemcmp(frag->srcAddr, packet->srcAddr.b, sizeof(frag->srcAddr)))
+         continue;
+      if(osMemcmp(frag->destAddr, packet->destAddr.b, sizeof(frag->destAddr)))
+         continue;
+
+      //Compare fragment identification fields
+      if(frag->identification != header->identification)
+         continue;
+
+      //A matching entry has been found in the reassembly queue
+      return frag;
+   }
+
+   //If the current packet does not match an existing entry in the reassembly
+   //queue, then create a new entry
+   frag = ipv6AllocFragMem(interface, NULL, sizeof(Ipv6FragDesc));
+
+   //Failed to allocate memory?
+   if(frag == NULL)
+      return NULL;
+
+   //Initialize the entry
+   osMemset(frag, 0, sizeof(Ipv6FragDesc));
 
-      //Check whether the current entry is used?
-      if(frag->buffer.chunkCount > 0)
+   //Amount of memory used by the entry
+   frag->memUsage = IPV6_FRAG_MEM_SIZE(sizeof(Ipv6FragDesc));
+   //Save current time
+   frag->timestamp = osGetSystemTime();
+
+   //Record the fields that identify the datagram
+   osMemcpy(frag->srcAddr, packet->srcAddr.b, sizeof(frag->srcAddr));
+   osMemcpy(frag->destAddr, packet->destAddr.b, sizeof(frag->destAddr));
+   frag->identification = header->identification;
+
+   //Insert the entry in the hash table
+   frag->next = interface->ipv6Context.fragQueue[i];
+   interface->ipv6Context.fragQueue[i] = frag;
+
+   //Return the newly created fragment descriptor
+   return frag;
+}
+
+
+/**
+ * @brief Flush IPv6 reassembly queue
+ * @param[in] interface Underlying network interface
+ **/
+
+void ipv6FlushFragQueue(NetInterface *interface)
+{
+   uint_t i;
+
+   //Loop through the reassembly queue
+   for(i = 0; i < IPV6_FRAG_HASH_TABLE_SIZE; i++)
+   {
+      //Drop any partially reconstructed datagram
+      while(interface->ipv6Context.fragQueue[i] != NULL)
       {
-         //Point to the corresponding datagram
-         datagram = netBufferAt((NetBuffer *) &frag->buffer, 0, 0);
+         ipv6DeleteFragDesc(interface, interface->ipv6Context.fragQueue[i]);
+      }
+   }
+}
 
-         //Check source and destination addresses
-         if(!ipv6CompAddr(&datagram->srcAddr, &packet->srcAddr))
-            continue;
-         if(!ipv6CompAddr(&datagram->destAddr, &packet->destAddr))
-            continue;
 
-         //Compare fragment identification fields
-         if(frag->identification != header->identification)
-            continue;
+/**
+ * @brief Add the data of a fragment to the list of fragment nodes
+ *
+ * Only the parts of the fragment that fill holes are recorded. Each node
+ * holds a contiguous range of data, and the list is sorted by offset
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv6 fragment descriptor
+ * @param[in] dataFirst Index of the first byte of the fragment
+ * @param[in] buffer Multi-part buffer containing the fragment data
+ * @param[in] offset Offset to the first byte of the fragment data
+ * @param[in] length Length of the fragment data
+ * @return Error code
+ **/
+
+error_t ipv6InsertFragment(NetInterface *interface, Ipv6FragDesc *frag,
+   uint16_t dataFirst, const NetBuffer *buffer, size_t offset, size_t length)
+{
+   size_t newLen;
+   uint16_t pos;
+   uint16_t end;
+   uint16_t dataLast;
+   bool_t overlap;
+   Ipv6FragNode *node;
+   Ipv6FragNode *newNode;
+   Ipv6FragNode **p;
+
+   //Calculate the index immediately following the last byte
+   dataLast = dataFirst + (uint16_t) length;
+
+   //Determine how many bytes fill holes
+   newLen = 0;
+   overlap = FALSE;
+
+   //Walk through the holes covered by the fragment
+   for(pos = dataFirst, node = frag->nodes; pos < dataLast; )
+   {
+      //Skip the nodes that lie before the current position
+      if(node != NULL && node->last <= pos)
+      {
+         node = node->next;
+      }
+      else if(node != NULL && node->first <= pos)
+      {
+         //The fragment overlaps data that has already been received
+         overlap = TRUE;
+         pos = node->last;
+      }
+      else
+      {
+         //End of the hole
+         end = (node != NULL) ? MIN(node->first, dataLast) : dataLast;
+
+         //Number of bytes that fill the hole
+         newLen += end - pos;
+         pos = end;
+      }
+   }
+
+#if (IPV6_OVERLAPPING_FRAG_SUPPORT == DISABLED)
+   //When reassembling an IPv6 datagram, if one or more its constituent
+   //fragments is determined to be an overlapping fragment, the entire
+   //datagram must be silently discarded (refer to RFC 5722, section 4).
+   //Exact duplicates are ignored
+   if(overlap && newLen > 0)
+      return ERROR_INVALID_PACKET;
+#else
+   //Overlapping data is accepted, but the data that has already been
+   //received takes precedence
+   (void) overlap;
+#endif
+
+   //Duplicate fragment?
+   if(newLen == 0)
+      return NO_ERROR;
+
+   //Walk through the holes again and fill them
+   for(pos = dataFirst, p = &frag->nodes; pos < dataLast; )
+   {
+      //Point to the current node
+      node = *p;
+
+      //Skip the nodes that lie before the current position
+      if(node != NULL && node->last <= pos)
+      {
+         p = &node->next;
+      }
+      else if(node != NULL && node->first <= pos)
+      {
+         //Keep the data that has already been received
+         pos = node->last;
+         p = &node->next;
+      }
+      else
+      {
+         //End of the hole (the node cannot hold more than a pool buffer)
+         end = (node != NULL) ? MIN(node->first, dataLast) : dataLast;
+         end = MIN(end, pos + IPV6_FRAG_NODE_DATA_SIZE);
+
+         //Allocate a new node
+         newNode = ipv6AllocFragMem(interface, frag,
+            sizeof(Ipv6FragNode) + end - pos);
 
-         //A matching entry has been found in the reassembly queue
-         return frag;
+         //Failed to allocate memory?
+         if(newNode == NULL)
+            return ERROR_OUT_OF_MEMORY;
+
+         //Copy the data from the fragment
+         newNode->first = pos;
+         newNode->last = end;
+         newNode->size = IPV6_FRAG_NODE_SIZE(end - pos);
+         netBufferRead(newNode->data, buffer, offset + pos - dataFirst,
+            end - pos);
+
+         //Insert the node in the list
+         newNode->next = node;
+         *p = newNode;
+         p = &newNode->next;
+
+         //Update the number of bytes received so far
+         frag->receivedLen += end - pos;
+         frag->nodeCount++;
+         pos = end;
       }
    }
 
-   //If the current packet does not match an existing entry
-   //in the reassembly queue, then create a new entry
-   for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
+   //Merge the new data with the adjacent nodes
+   ipv6MergeFragNodes(interface, frag);
+
+   //Limit the number of data chunks that comprise the datagram
+   if(frag->nodeCount > IPV6_MAX_FRAG_CHUNKS)
+      return ERROR_OUT_OF_RESOURCES;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Merge contiguous fragment nodes
+ *
+ * Data are moved towards the beginning of each range of contiguous data, so
+ * that a node is filled before the next one is used. The number of chunks
+ * then depends on the size of the datagram rather than on the number of
+ * fragments, and the upper-layer header is never split across chunks
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] frag IPv6 fragment descriptor
+ **/
+
+void ipv6MergeFragNodes(NetInterface *interface, Ipv6FragDesc *frag)
+{
+   size_t n;
+   size_t length;
+   Ipv6FragNode *node;
+   Ipv6FragNode *next;
+   Ipv6FragNode *newNode;
+   Ipv6FragNode **p;
+
+   //Loop through the fragment nodes
+   for(p = &frag->nodes; *p != NULL && (*p)->next != NULL; )
    {
-      //Point to the current entry in the reassembly queue
-      frag = &interface->ipv6Context.fragQueue[i];
+      //Point to the current node and to the following one
+      node = *p;
+      next = node->next;
 
-      //The current entry is free?
-      if(!frag->buffer.chunkCount)
+      //Number of bytes held by the current node
+      length = node->last - node->first;
+
+      //Only contiguous data can be merged, and full nodes are left as is
+      if(next->first != node->last || length >= IPV6_FRAG_NODE_DATA_SIZE)
       {
-         //Number of chunks that comprise the reassembly buffer
-         frag->buffer.maxChunkCount = arraysize(frag->buffer.chunk);
+         p = &node->next;
+         continue;
+      }
 
-         //Allocate sufficient memory to hold the IPv6 header and
-         //the first hole descriptor
-         error = netBufferSetLength((NetBuffer *) &frag->buffer,
-            NET_MEM_POOL_BUFFER_SIZE + sizeof(Ipv6HoleDesc));
+      //Number of bytes to move from the following node
+      n = MIN(next->last - next->first, IPV6_FRAG_NODE_DATA_SIZE - length);
+
+      //The current node must be reallocated if it is too small
+      if((length + n) > node->size)
+      {
+         //Allocate a larger node
+         newNode = ipv6AllocFragMem(interface, frag,
+            sizeof(Ipv6FragNode) + length + n);
 
          //Failed to allocate memory?
-         if(error)
+         if(newNode == NULL)
          {
-            //Clean up side effects
-            netBufferSetLength((NetBuffer *) &frag->buffer, 0);
-            //Exit immediately
-            return NULL;
+            p = &node->next;
+            continue;
          }
 
-         //Initial length of the reconstructed datagram
-         frag->unfragPartLength = sizeof(Ipv6Header);
-         frag->fragPartLength = 0;
-
-         //Fix the length of the first chunk
-         frag->buffer.chunk[0].length = (uint16_t) frag->unfragPartLength;
-         //Copy IPv6 header from the incoming fragment
-         netBufferWrite((NetBuffer *) &frag->buffer, 0, packet, frag->unfragPartLength);
-
-         //Save current time
-         frag->timestamp = osGetSystemTime();
-         //Record fragment identification field
-         frag->identification = header->identification;
-         //Create a new entry in the hole descriptor list
-         frag->firstHole = 0;
-
-         //Point to first hole descriptor
-         hole = ipv6FindHole(frag, frag->firstHole);
-         //The entry describes the datagram as being completely missing
-         hole->first = 0;
-         hole->last = IPV6_INFINITY;
-         hole->next = IPV6_INFINITY;
-
-         //Dump hole descriptor list
-         ipv6DumpHoleList(frag);
-
-         //Return the matching fragment descriptor
-         return frag;
+         //Copy the contents of the current node
+         newNode->next = next;
+         newNode->first = node->first;
+         newNode->last = node->last;
+         newNode->size = IPV6_FRAG_NODE_SIZE(length + n);
+         osMemcpy(newNode->data, node->data, length);
+
+         //Replace the current node
+         *p = newNode;
+         ipv6FreeFragNode(interface, frag, node);
+         node = newNode;
+      }
+
+      //Move the data
+      osMemcpy(node->data + length, next->data, n);
+      node->last += n;
+
+      //The following node has been emptied?
+      if(node->last == next->last)
+      {
+         //Remove it from the list
+         node->next = next->next;
+         ipv6FreeFragNode(interface, frag, next);
+         frag->nodeCount--;
+      }
+      else
+      {
+         //The remaining data stay at the beginning of the node
+         osMemmove(next->data, next->data + n, next->last - node->last);
+         next->first = node->last;
       }
    }
+}
+
 
-   //The reassembly queue is full
-   return NULL;
+/**
+ * @brief Chain the fragment nodes to form the reassembled datagram
+ *
+ * The reassembly buffer refers to the unfragmentable part and to the data
+ * received from offset zero up to the first hole (the whole fragmentable
+ * part once the reassembly is complete)
+ *
+ * @param[in] frag IPv6 fragment descriptor
+ **/
+
+void ipv6ChainFragments(Ipv6FragDesc *frag)
+{
+   uint_t i;
+   uint16_t pos;
+   Ipv6FragNode *node;
+
+   //The first chunk holds the unfragmentable part
+   frag->buffer.chunk[0].address = frag->header->data;
+   frag->buffer.chunk[0].length = frag->header->last;
+   frag->buffer.chunk[0].size = 0;
+
+   //Chain the nodes as long as the data is contiguous
+   for(i = 1, pos = 0, node = frag->nodes; node != NULL &&
+      node->first == pos && i < arraysize(frag->buffer.chunk); node = node->next)
+   {
+      //The memory is owned by the node
+      frag->buffer.chunk[i].address = node->data;
+      frag->buffer.chunk[i].length = node->last - node->first;
+      frag->buffer.chunk[i].size = 0;
+
+      //Next chunk
+      pos = node->last;
+      i++;
+   }
+
+   //Number of chunks that comprise the reassembled datagram
+   frag->buffer.chunkCount = i;
+   frag->buffer.maxChunkCount = i;
 }
 
 
 /**
- * @brief Flush IPv6 reassembly queue
+ * @brief Allocate memory for the reassembly queue
+ *
+ * The memory used by the reassembly queue is bounded. The oldest datagrams
+ * are discarded whenever the limit is reached
+ *
  * @param[in] interface Underlying network interface
+ * @param[in] frag Fragment descriptor the memory is allocated for (NULL when
+ *   allocating a new descriptor)
+ * @param[in] size Number of bytes to allocate
+ * @return Pointer to the allocated memory, or NULL on failure
  **/
 
-void ipv6FlushFragQueue(NetInterface *interface)
+void *ipv6AllocFragMem(NetInterface *interface, Ipv6FragDesc *frag,
+   size_t size)
 {
    uint_t i;
+   size_t n;
+   void *p;
+   Ipv6FragDesc *entry;
+   Ipv6FragDesc *oldestEntry;
 
-   //Loop through the reassembly queue
-   for(i = 0; i < IPV6_MAX_FRAG_DATAGRAMS; i++)
+   //When the memory pool is used, each allocation consumes a whole buffer
+   n = IPV6_FRAG_MEM_SIZE(size);
+
+   //Make room for the new allocation
+   while((interface->ipv6Context.fragMemUsage + n) > IPV6_FRAG_MAX_MEMORY)
    {
-      //Drop any partially reconstructed datagram
-      netBufferSetLength((NetBuffer *) &interface->ipv6Context.fragQueue[i].buffer, 0);
+      //Keep track of the oldest datagram
+      oldestEntry = NULL;
+
+      //Loop through the reassembly queue
+      for(i = 0; i < IPV6_FRAG_HASH_TABLE_SIZE; i++)
+      {
+         for(entry = interface->ipv6Context.fragQueue[i]; entry != NULL;
+            entry = entry->next)
+         {
+            //The datagram being reassembled is never discarded
+            if(entry != frag && (oldestEntry == NULL ||
+               timeCompare(entry->timestamp, oldestEntry->timestamp) < 0))
+            {
+               oldestEntry = entry;
+            }
+         }
+      }
+
+      //No datagram can be discarded?
+      if(oldestEntry == NULL)
+         return NULL;
+
+      //Number of failures detected by the IP reassembly algorithm
+      IP_MIB_INC_COUNTER32(ipv6SystemStats.ipSystemStatsReasmFails, 1);
+      IP_MIB_INC_COUNTER32(ipv6IfStatsTable[interface->index].ipIfStatsReasmFails, 1);
+
+      //Drop the oldest partially reconstructed datagram
+      ipv6DeleteFragDesc(interface, oldestEntry);
+   }
+
+   //Allocate a memory block
+   p = memPoolAlloc(size);
+
+   //Successful memory allocation?
+   if(p != NULL)
+   {
+      //Update the amount of memory used by the reassembly queue
+      interface->ipv6Context.fragMemUsage += n;
+
+      //Update the amount of memory used by the datagram
+      if(frag != NULL)
+      {
+         frag->memUsage += n;
+      }
    }
+
+   //Return a pointer to the allocated memory
+   return p;
 }
 
 
 /**
- * @brief Retrieve hole descriptor
+ * @brief Release a fragment node
+ * @param[in] interface Underlying network interface
+ * @param[in] frag Fragment descriptor the node belongs to
+ * @param[in] node Fragment node to be released
+ **/
+
+void ipv6FreeFragNode(NetInterface *interface, Ipv6FragDesc *frag,
+   Ipv6FragNode *node)
+{
+   size_t n;
+
+   //Amount of memory charged for the node
+   n = IPV6_FRAG_MEM_SIZE(sizeof(Ipv6FragNode) + node->size);
+
+   //Update the amount of memory used by the reassembly queue
+   interface->ipv6Context.fragMemUsage -= n;
+   frag->memUsage -= n;
+
+   //Release the node
+   memPoolFree(node);
+}
+
+
+/**
+ * @brief Remove a datagram from the reassembly queue
+ * @param[in] interface Underlying network interface
  * @param[in] frag IPv6 fragment descriptor
- * @param[in] offset Offset of the hole
- * @return A pointer to the hole descriptor is returned if the
- *   specified offset is valid. Otherwise NULL is returned
  **/
 
-Ipv6HoleDesc *ipv6FindHole(Ipv6FragDesc *frag, uint16_t offset)
+void ipv6DeleteFragDesc(NetInterface *interface, Ipv6FragDesc *frag)
 {
-   //Return a pointer to the hole descriptor
-   return netBufferAt((NetBuffer *) &frag->buffer, frag->unfragPartLength + offset, 0);
+   Ipv6FragDesc **p;
+   Ipv6FragNode *node;
+
+   //Remove the entry from its hash bucket
+   for(p = &interface->ipv6Context.fragQueue[ipv6GetFragHashIndex(
+      frag->srcAddr, frag->destAddr, frag->identification)];
+      *p != NULL; p = &(*p)->next)
+   {
+      if(*p == frag)
+      {
+         *p = frag->next;
+         break;
+      }
+   }
+
+   //Release the fragment nodes
+   while(frag->nodes != NULL)
+   {
+      node = frag->nodes;
+      frag->nodes = node->next;
+      memPoolFree(node);
+   }
+
+   //Release the unfragmentable part
+   if(frag->header != NULL)
+   {
+      memPoolFree(frag->header);
+   }
+
+   //Update the amount of memory used by the reassembly queue
+   interface->ipv6Context.fragMemUsage -= frag->memUsage;
+
+   //Release the descriptor
+   memPoolFree(frag);
+}
+
+
+/**
+ * @brief Compute the hash bucket of a datagram
+ * @param[in] srcAddr Source IPv6 address
+ * @param[in] destAddr Destination IPv6 address
+ * @param[in] identification Fragment identification field
+ * @return Index of the hash bucket
+ **/
+
+uint_t ipv6GetFragHashIndex(const uint8_t *srcAddr, const uint8_t *destAddr,
+   uint32_t identification)
+{
+   uint_t i;
+   uint32_t h;
+
+   //Mix the fields that identify the datagram
+   for(h = identification, i = 0; i < 16; i++)
+   {
+      h = (h * 33) ^ srcAddr[i] ^ ((uint32_t) destAddr[i] << 8);
+   }
+
+   h *= 0x9E3779B1;
+   h ^= h >> 16;
+
+   //Return the index of the hash bucket
+   return h % IPV6_FRAG_HASH_TABLE_SIZE;
 }
 
 
 /**
- * @brief Dump hole descriptor list
+ * @brief Dump the list of fragment nodes
  * @param[in] frag IPv6 fragment descriptor
  **/
 
-void ipv6DumpHoleList(Ipv6FragDesc *frag)
+void ipv6DumpFragList(Ipv6FragDesc *frag)
 {
 //Check debugging level
 #if (TRACE_LEVEL >= TRACE_LEVEL_DEBUG)
-   Ipv6HoleDesc *hole;
+   Ipv6FragNode *node;
 
    //Debug message
-   TRACE_DEBUG("Hole descriptor list:\r\n");
-   //Select the first hole descriptor from the list
-   hole = ipv6FindHole(frag, frag->firstHole);
+   TRACE_DEBUG("Fragment list:\r\n");
 
-   //Loop through the hole descriptor list
-   while(hole != NULL)
+   //Loop through the fragment nodes
+   for(node = frag->nodes; node != NULL; node = node->next)
    {
-      //Display current hole
-      TRACE_DEBUG("  %" PRIu16 " - %" PRIu16 "\r\n", hole->first, hole->last);
-      //Select the next hole descriptor from the list
-      hole = ipv6FindHole(frag, hole->next);
+      //Display current node
+      TRACE_DEBUG("  %" PRIu16 " - %" PRIu16 "\r\n", node->first, node->last);
    }
 #endif
 }
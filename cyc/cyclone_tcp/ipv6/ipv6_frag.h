@@ -56,14 +56,6 @@
    #error IPV6_FRAG_TICK_INTERVAL parameter is not valid
 #endif
 
-//Maximum number of fragmented packets the host will accept
-//and hold in the reassembly queue simultaneously
-#ifndef IPV6_MAX_FRAG_DATAGRAMS
-   #define IPV6_MAX_FRAG_DATAGRAMS 4
-#elif (IPV6_MAX_FRAG_DATAGRAMS < 1)
-   #error IPV6_MAX_FRAG_DATAGRAMS parameter is not valid
-#endif
-
 //Maximum datagram size the host will accept when reassembling fragments
 #ifndef IPV6_MAX_FRAG_DATAGRAM_SIZE
    #define IPV6_MAX_FRAG_DATAGRAM_SIZE 8192
@@ -71,6 +63,27 @@
    #error IPV6_MAX_FRAG_DATAGRAM_SIZE parameter is not valid
 #endif
 
+//Maximum number of data chunks a reassembled datagram can consist of.
+//Contiguous data are merged, so the limit applies to the ranges of data
+//separated by holes
+#ifndef IPV6_MAX_FRAG_CHUNKS
+   #define IPV6_MAX_FRAG_CHUNKS 16
+#elif (IPV6_MAX_FRAG_CHUNKS < 1)
+   #error IPV6_MAX_FRAG_CHUNKS parameter is not valid
+#endif
+
+//Maximum amount of memory (in bytes) used by the reassembly queue
+#ifndef IPV6_FRAG_MAX_MEMORY
+   #define IPV6_FRAG_MAX_MEMORY (4 * IPV6_MAX_FRAG_DATAGRAM_SIZE)
+#endif
+
+//Size of the hash table used to search the reassembly queue
+#ifndef IPV6_FRAG_HASH_TABLE_SIZE
+   #define IPV6_FRAG_HASH_TABLE_SIZE 8
+#elif (IPV6_FRAG_HASH_TABLE_SIZE < 1)
+   #error IPV6_FRAG_HASH_TABLE_SIZE parameter is not valid
+#endif
+
 //Maximum time an IPv6 fragment can spend waiting to be reassembled
 #ifndef IPV6_FRAG_TIME_TO_LIVE
    #define IPV6_FRAG_TIME_TO_LIVE 15000
@@ -78,8 +91,30 @@
    #error IPV6_FRAG_TIME_TO_LIVE parameter is not valid
 #endif
 
-//Infinity is implemented by a very large integer
-#define IPV6_INFINITY 0xFFFF
+//Maximum amount of data a single fragment node can hold
+#define IPV6_FRAG_NODE_DATA_SIZE ((NET_MEM_POOL_BUFFER_SIZE - sizeof(Ipv6FragNode)) & ~7U)
+
+//Amount of memory charged to the reassembly queue for an allocation, and
+//amount of data a node allocated for a given length can hold
+#if (NET_MEM_POOL_SUPPORT == ENABLED)
+   #define IPV6_FRAG_MEM_SIZE(size) NET_MEM_POOL_BUFFER_SIZE
+   #define IPV6_FRAG_NODE_SIZE(length) IPV6_FRAG_NODE_DATA_SIZE
+#else
+   #define IPV6_FRAG_MEM_SIZE(size) (size)
+   #define IPV6_FRAG_NODE_SIZE(length) (length)
+#endif
+
+//The reassembly queue must be able to hold a datagram made of the maximum
+//number of chunks, along with its descriptor and its header
+#if (NET_MEM_POOL_SUPPORT == ENABLED)
+   #if (IPV6_FRAG_MAX_MEMORY < ((IPV6_MAX_FRAG_CHUNKS + 2) * NET_MEM_POOL_BUFFER_SIZE))
+      #error IPV6_FRAG_MAX_MEMORY parameter is not valid
+   #endif
+#else
+   #if (IPV6_FRAG_MAX_MEMORY < IPV6_MAX_FRAG_DATAGRAM_SIZE)
+      #error IPV6_FRAG_MAX_MEMORY parameter is not valid
+   #endif
+#endif
 
 //C++ guard
 #ifdef __cplusplus
@@ -87,32 +122,18 @@ extern "C" {
 #endif
 
 
-//CC-RX, CodeWarrior or Win32 compiler?
-#if defined(__CCRX__)
-   #pragma pack
-#elif defined(__CWCC__) || defined(_WIN32)
-   #pragma pack(push, 1)
-#endif
-
-
 /**
- * @brief Hole descriptor
+ * @brief Fragment node
  **/
 
-typedef __packed_struct
+typedef struct _Ipv6FragNode
 {
-   uint16_t first;
-   uint16_t last;
-   uint16_t next;
-} Ipv6HoleDesc;
-
-
-//CC-RX, CodeWarrior or Win32 compiler?
-#if defined(__CCRX__)
-   #pragma unpack
-#elif defined(__CWCC__) || defined(_WIN32)
-   #pragma pack(pop)
-#endif
+   struct _Ipv6FragNode *next; ///<Next node (sorted by offset)
+   uint16_t first;             ///<Index of the first byte
+   uint16_t last;              ///<Index immediately following the last byte
+   uint16_t size;              ///<Number of bytes the node can hold
+   uint8_t data[];             ///<Fragment data
+} Ipv6FragNode;
 
 
 /**
@@ -123,7 +144,7 @@ typedef struct
 {
    uint_t chunkCount;
    uint_t maxChunkCount;
-   ChunkDesc chunk[N(IPV6_MAX_FRAG_DATAGRAM_SIZE) + 1];
+   ChunkDesc chunk[IPV6_MAX_FRAG_CHUNKS + 1];
 } Ipv6ReassemblyBuffer;
 
 
@@ -131,14 +152,21 @@ typedef struct
  * @brief Fragmented packet descriptor
  **/
 
-typedef struct
+typedef struct _Ipv6FragDesc
 {
+   struct _Ipv6FragDesc *next;  ///<Next entry in the same hash bucket
    systime_t timestamp;         ///<Time at which the first fragment was received
+   uint8_t srcAddr[16];         ///<Source IPv6 address
+   uint8_t destAddr[16];        ///<Destination IPv6 address
    uint32_t identification;     ///<Fragment identification field
-   size_t unfragPartLength;     ///<Length of the unfragmentable part
-   size_t fragPartLength;       ///<Length of the fragmentable part
-   uint16_t firstHole;          ///<Index of the first hole
-   Ipv6ReassemblyBuffer buffer; ///<Buffer containing the reassembled datagram
+   bool_t lastFrag;             ///<The last fragment has been received
+   size_t fragPartLength;       ///<Length of the fragmentable part (valid once the last fragment has been received)
+   size_t receivedLen;          ///<Number of bytes of the fragmentable part received so far
+   uint_t nodeCount;            ///<Number of fragment nodes
+   size_t memUsage;             ///<Amount of memory used by the entry
+   Ipv6FragNode *header;        ///<Unfragmentable part taken from the first fragment
+   Ipv6FragNode *nodes;         ///<Fragment nodes sorted by offset
+   Ipv6ReassemblyBuffer buffer; ///<Reassembled datagram (chained view of the fragment nodes)
 } Ipv6FragDesc;
 
 
@@ -161,8 +189,24 @@ Ipv6FragDesc *ipv6SearchFragQueue(NetInterface *interface,
 
 void ipv6FlushFragQueue(NetInterface *interface);
 
-Ipv6HoleDesc *ipv6FindHole(Ipv6FragDesc *frag, uint16_t offset);
-void ipv6DumpHoleList(Ipv6FragDesc *frag);
+error_t ipv6InsertFragment(NetInterface *interface, Ipv6FragDesc *frag,
+   uint16_t dataFirst, const NetBuffer *buffer, size_t offset, size_t length);
+
+void ipv6MergeFragNodes(NetInterface *interface, Ipv6FragDesc *frag);
+void ipv6ChainFragments(Ipv6FragDesc *frag);
+
+void *ipv6AllocFragMem(NetInterface *interface, Ipv6FragDesc *frag,
+   size_t size);
+
+void ipv6FreeFragNode(NetInterface *interface, Ipv6FragDesc *frag,
+   Ipv6FragNode *node);
+
+void ipv6DeleteFragDesc(NetInterface *interface, Ipv6FragDesc *frag);
+
+uint_t ipv6GetFragHashIndex(const uint8_t *srcAddr, const uint8_t *destAddr,
+   uint32_t identification);
+
+void ipv6DumpFragList(Ipv6FragDesc *frag);
 
 //C++ guard
 #ifdef __cplusplus
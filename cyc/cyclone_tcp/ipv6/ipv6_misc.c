@@ -200,6 +200,9 @@ error_t ipv6SetAddr(NetInterface *interface, uint_t index,
       entry->permanent = permanent;
    }
 
+   //The routes cached by the sockets are no longer valid
+   netInvalidateRouteCache();
+
 #if (MDNS_RESPONDER_SUPPORT == ENABLED)
    //Restart mDNS probing process
    mdnsResponderStartProbing(interface->mdnsResponderContext);
@@ -37,9 +37,11 @@
 #include "core/ip.h"
 #include "ipv6/ipv6.h"
 #include "ipv6/ipv6_misc.h"
+#include "ipv6/ipv6_multicast.h"
 #include "ipv6/ipv6_routing.h"
 #include "ipv6/icmpv6.h"
 #include "ipv6/ndp.h"
+#include "ipv6/ndp_cache.h"
 #include "debug.h"
 
 //Check TCP/IP stack configuration
@@ -47,6 +49,16 @@
 
 //IPv6 routing table
 static Ipv6RoutingTableEntry ipv6RoutingTable[IPV6_ROUTING_TABLE_SIZE];
+//Root node of the trie
+static Ipv6RoutingTrieNode ipv6RoutingTrieRoot;
+//Pool of trie nodes
+static Ipv6RoutingTrieNode ipv6RoutingTrie[IPV6_ROUTING_TRIE_SIZE];
+//Number of trie nodes in use
+static uint_t ipv6RoutingTrieCount;
+//Next-hop cache
+static Ipv6NextHopCacheEntry ipv6NextHopCache[IPV6_NEXT_HOP_CACHE_SIZE];
+//Generation of the routing table (any change invalidates the next-hop cache)
+static uint_t ipv6RoutingGeneration;
 
 
 /**
@@ -58,6 +70,12 @@ error_t ipv6InitRouting(void)
 {
    //Clear the routing table
    osMemset(ipv6RoutingTable, 0, sizeof(ipv6RoutingTable));
+   //Clear the trie
+   ipv6RebuildRoutingTrie();
+
+   //Clear the next-hop cache
+   osMemset(ipv6NextHopCache, 0, sizeof(ipv6NextHopCache));
+   ipv6RoutingGeneration = 1;
 
    //Successful initialization
    return NO_ERROR;
@@ -146,7 +164,9 @@ error_t ipv6AddRoute(const Ipv6Addr *prefix, uint_t prefixLen,
    //If the routing table does not contain the specified destination,
    //then a new entry should be created
    if(i >= IPV6_ROUTING_TABLE_SIZE)
+   {
       entry = firstFreeEntry;
+   }
 
    //Check whether the routing table runs out of space
    if(entry != NULL)
@@ -170,11 +190,33 @@ error_t ipv6AddRoute(const Ipv6Addr *prefix, uint_t prefixLen,
 
       //Metric value
       entry->metric = metric;
-      //The entry is now valid
-      entry->valid = TRUE;
 
-      //Successful processing
-      error = NO_ERROR;
+      //New route?
+      if(!entry->valid)
+      {
+         //The entry is now valid
+         entry->valid = TRUE;
+
+         //Insert the route in the trie
+         error = ipv6InsertRoute(entry - ipv6RoutingTable);
+
+         //The trie runs out of nodes?
+         if(error)
+         {
+            //Delete the entry
+            entry->valid = FALSE;
+            //Release the nodes that may have been allocated
+            ipv6RebuildRoutingTrie();
+         }
+      }
+      else
+      {
+         //The trie already refers to the entry
+         error = NO_ERROR;
+      }
+
+      //Invalidate the next-hop cache
+      ipv6RoutingGeneration++;
    }
    else
    {
@@ -233,6 +275,15 @@ error_t ipv6DeleteRoute(const Ipv6Addr *prefix, uint_t prefixLen)
       }
    }
 
+   //Any route deleted?
+   if(!error)
+   {
+      //Shorter prefixes must take over the slots owned by the deleted route
+      ipv6RebuildRoutingTrie();
+      //Invalidate the next-hop cache
+      ipv6RoutingGeneration++;
+   }
+
    //Release exclusive access
    osReleaseMutex(&netMutex);
 
@@ -252,6 +303,10 @@ error_t ipv6DeleteAllRoutes(void)
    osAcquireMutex(&netMutex);
    //Clear the routing table
    osMemset(ipv6RoutingTable, 0, sizeof(ipv6RoutingTable));
+   //Clear the trie
+   ipv6RebuildRoutingTrie();
+   //Invalidate the next-hop cache
+   ipv6RoutingGeneration++;
    //Release exclusive access
    osReleaseMutex(&netMutex);
 
@@ -272,16 +327,14 @@ error_t ipv6ForwardPacket(NetInterface *srcInterface, NetBuffer *ipPacket,
    size_t ipPacketOffset)
 {
    error_t error;
-   uint_t i;
-   uint_t metric;
-   uint_t prefixLen;
-   bool_t match;
+   bool_t inPlace;
+   uint8_t hopLimit;
    size_t length;
    size_t destOffset;
    NetInterface *destInterface;
    NetBuffer *destBuffer;
    Ipv6Header *ipHeader;
-   Ipv6RoutingTableEntry *entry;
+   Ipv6NextHopCacheEntry *cacheEntry;
    Ipv6Addr destIpAddr;
 #if (ETH_SUPPORT == ENABLED)
    NetInterface *physicalInterface;
@@ -305,12 +358,19 @@ error_t ipv6ForwardPacket(NetInterface *srcInterface, NetBuffer *ipPacket,
       return ERROR_INVALID_LENGTH;
 
    //Point to the IPv6 header
-   ipHeader = netBufferAt(ipPacket, ipPacketOffset, 0);
+   ipHeader = netBufferAt(ipPacket, ipPacketOffset, sizeof(Ipv6Header));
 
    //Sanity check
    if(ipHeader == NULL)
       return ERROR_FAILURE;
 
+   //Check the Payload Length field
+   if(ntohs(ipHeader->payloadLen) > (length - sizeof(Ipv6Header)))
+      return ERROR_INVALID_LENGTH;
+
+   //Discard the link-layer padding, if any
+   length = sizeof(Ipv6Header) + ntohs(ipHeader->payloadLen);
+
    //An IPv6 packet with a source address of unspecified must never be
    //forwarded by an IPv6 router (refer to RFC section 3513 2.5.2)
    if(ipv6CompAddr(&ipHeader->srcAddr, &IPV6_UNSPECIFIED_ADDR))
@@ -333,81 +393,26 @@ error_t ipv6ForwardPacket(NetInterface *srcInterface, NetBuffer *ipPacket,
       destInterface = srcInterface;
       //Next hop
       destIpAddr = ipHeader->destAddr;
+      //Link-local destinations are not cached
+      cacheEntry = NULL;
    }
    else
    {
-      //Lowest metric value
-      metric = UINT_MAX;
-      //Longest prefix length
-      prefixLen = 0;
-      //Outgoing network interface
-      destInterface = NULL;
-
-      //Route determination process
-      for(i = 0; i < IPV6_ROUTING_TABLE_SIZE; i++)
-      {
-         //Point to the current entry
-         entry = &ipv6RoutingTable[i];
-
-         //Valid entry?
-         if(entry->valid && entry->interface != NULL)
-         {
-            //Clear flag
-            match = FALSE;
+      //Search the next-hop cache, then the routing table
+      cacheEntry = ipv6GetNextHop(&ipHeader->destAddr);
 
-            //Do not forward any IP packets to an interface that has not
-            //been assigned a valid link-local address...
-            if(ipv6GetLinkLocalAddrState(entry->interface) == IPV6_ADDR_STATE_PREFERRED)
-            {
-               //If routing is enabled on the interface, then the router
-               //can forward packets to the interface
-               if(entry->interface->ipv6Context.isRouter)
-               {
-                  //Compare the destination address with the current entry for a match
-                  if(ipv6CompPrefix(&ipHeader->destAddr, &entry->prefix, entry->prefixLen))
-                  {
-                     //The longest matching route is the most specific route to the
-                     //destination IPv6 address...
-                     if(entry->prefixLen > prefixLen)
-                     {
-                        //Give the current route the higher precedence
-                        match = TRUE;
-                     }
-                     else if(entry->prefixLen == prefixLen)
-                     {
-                        //If multiple entries with the longest match are found, the
-                        //router uses the lowest metric to select the best route
-                        if(entry->metric < metric)
-                        {
-                           //Give the current route the higher precedence
-                           match = TRUE;
-                        }
-                     }
-                  }
-               }
-            }
-
-            //Matching entry?
-            if(match)
-            {
-               //Select the current route
-               metric = entry->metric;
-               prefixLen = entry->prefixLen;
-
-               //Outgoing interface on which to forward the packet
-               destInterface = entry->interface;
-
-               //Next hop
-               if(!ipv6CompAddr(&entry->nextHop, &IPV6_UNSPECIFIED_ADDR))
-               {
-                  destIpAddr = entry->nextHop;
-               }
-               else
-               {
-                  destIpAddr = ipHeader->destAddr;
-               }
-            }
-         }
+      //Any route to the destination?
+      if(cacheEntry != NULL)
+      {
+         //Outgoing interface on which to forward the packet
+         destInterface = cacheEntry->interface;
+         //Next hop
+         destIpAddr = cacheEntry->nextHop;
+      }
+      else
+      {
+         //No route to the destination
+         destInterface = NULL;
       }
    }
 
@@ -526,143 +531,490 @@ error_t ipv6ForwardPacket(NetInterface *srcInterface, NetBuffer *ipPacket,
          return error;
    }
 
-   //Allocate a buffer to hold the IPv6 packet
-   destBuffer = ethAllocBuffer(length, &destOffset);
+   //Save the original Hop Limit
+   hopLimit = ipHeader->hopLimit;
+   //Every time a router forwards a packet, it decrements the Hop Limit field
+   ipHeader->hopLimit--;
+
+   //Debug message
+   TRACE_INFO("Forwarding IPv6 packet to %s (%" PRIuSIZE " bytes)...\r\n",
+      destInterface->name, length);
+   //Dump IP header contents for debugging purpose
+   ipv6DumpHeader(ipHeader);
+
+   //Forward the packet in place whenever possible
+   inPlace = FALSE;
 
-   //Successful memory allocation?
-   if(destBuffer != NULL)
+#if (ETH_SUPPORT == ENABLED)
+   //Point to the physical interface
+   physicalInterface = nicGetPhysicalInterface(destInterface);
+
+   //The Ethernet header can be formatted in front of the packet, and the
+   //frame does not need to be extended?
+   if(ipPacket->chunkCount == 1 && ipPacketOffset >= sizeof(EthHeader) &&
+      netBufferGetLength(ipPacket) == (ipPacketOffset + length) &&
+      physicalInterface->nicDriver != NULL &&
+      physicalInterface->nicDriver->type == NIC_TYPE_ETHERNET &&
+      physicalInterface->nicDriver->autoCrcCalc &&
+      (physicalInterface->nicDriver->autoPadding ||
+      (sizeof(EthHeader) + length) >= (ETH_MIN_FRAME_SIZE - ETH_CRC_SIZE)))
    {
-      //Copy IPv6 header
-      error = netBufferCopy(destBuffer, destOffset, ipPacket, ipPacketOffset,
-         length);
+      inPlace = TRUE;
 
-      //Check status code
-      if(!error)
+#if (ETH_VLAN_SUPPORT == ENABLED)
+      //A VLAN tag would have to be inserted
+      if(nicGetVlanId(destInterface) != 0)
+         inPlace = FALSE;
+#endif
+#if (ETH_VMAN_SUPPORT == ENABLED)
+      //A VMAN tag would have to be inserted
+      if(nicGetVmanId(destInterface) != 0)
+         inPlace = FALSE;
+#endif
+#if (ETH_PORT_TAGGING_SUPPORT == ENABLED)
+      //A switch port tag would have to be inserted
+      if(physicalInterface->switchDriver != NULL &&
+         physicalInterface->switchDriver->tagFrame != NULL)
       {
-         //Point to the IPv6 header
-         ipHeader = netBufferAt(destBuffer, destOffset, 0);
-         //Every time a router forwards a packet, it decrements the Hop Limit field
-         ipHeader->hopLimit--;
+         inPlace = FALSE;
+      }
+#endif
+   }
+#endif
 
-#if (ETH_SUPPORT == ENABLED)
-         //Point to the physical interface
-         physicalInterface = nicGetPhysicalInterface(destInterface);
+   //Forward the packet in place?
+   if(inPlace)
+   {
+      uint8_t linkHeader[sizeof(EthHeader)];
 
-         //Ethernet interface?
-         if(physicalInterface->nicDriver != NULL &&
-            physicalInterface->nicDriver->type == NIC_TYPE_ETHERNET)
-         {
-            MacAddr destMacAddr;
-            NetTxAncillary ancillary;
+      //Save the link-layer header of the received frame
+      netBufferRead(linkHeader, ipPacket, ipPacketOffset - sizeof(EthHeader),
+         sizeof(EthHeader));
 
-            //Additional options can be passed to the stack along with the packet
-            ancillary = NET_DEFAULT_TX_ANCILLARY;
+      //Send the packet without copying it
+      error = ipv6SendForwardedPacket(srcInterface, destInterface, cacheEntry,
+         &destIpAddr, ipPacket, ipPacketOffset);
 
-            //Destination IPv6 address
-            if(ipv6CompAddr(&destIpAddr, &IPV6_UNSPECIFIED_ADDR))
-               destIpAddr = ipHeader->destAddr;
+      //Restore the link-layer header
+      netBufferWrite(ipPacket, ipPacketOffset - sizeof(EthHeader), linkHeader,
+         sizeof(EthHeader));
+   }
+   else
+   {
+      //Allocate a buffer to hold the IPv6 packet
+      destBuffer = ethAllocBuffer(length, &destOffset);
 
-            //Check whether the destination IPv6 address is a multicast address?
-            if(ipv6IsMulticastAddr(&destIpAddr))
-            {
-               //Map IPv6 multicast address to MAC-layer multicast address
-               error = ipv6MapMulticastAddrToMac(&destIpAddr, &destMacAddr);
-            }
-            else
-            {
-               //Resolve host address using Neighbor Discovery protocol
-               error = ndpResolve(destInterface, &destIpAddr, &destMacAddr);
-            }
+      //Successful memory allocation?
+      if(destBuffer != NULL)
+      {
+         //Copy the IPv6 packet
+         error = netBufferCopy(destBuffer, destOffset, ipPacket,
+            ipPacketOffset, length);
 
-            //Successful address resolution?
-            if(!error)
-            {
-               //Debug message
-               TRACE_INFO("Forwarding IPv6 packet to %s (%" PRIuSIZE " bytes)...\r\n",
-                  destInterface->name, length);
-               //Dump IP header contents for debugging purpose
-               ipv6DumpHeader(ipHeader);
-
-               //Send Ethernet frame
-               error = ethSendFrame(destInterface, NULL, &destMacAddr, ETH_TYPE_IPV6,
-                  destBuffer, destOffset, &ancillary);
-            }
-            //Address resolution in progress?
-            else if(error == ERROR_IN_PROGRESS)
-            {
-               //Debug message
-               TRACE_INFO("Enqueuing IPv6 packet (%" PRIuSIZE " bytes)...\r\n", length);
-               //Dump IP header contents for debugging purpose
-               ipv6DumpHeader(ipHeader);
-
-               //Enqueue packets waiting for address resolution
-               error = ndpEnqueuePacket(srcInterface, destInterface, &destIpAddr,
-                  destBuffer, destOffset, &ancillary);
-            }
-            //Address resolution failed?
-            else
-            {
-               //Debug message
-               TRACE_WARNING("Cannot map IPv6 address to Ethernet address!\r\n");
-            }
-         }
-         else
-#endif
-#if (PPP_SUPPORT == ENABLED)
-         //PPP interface?
-         if(destInterface->nicDriver != NULL &&
-            destInterface->nicDriver->type == NIC_TYPE_PPP)
+         //Check status code
+         if(!error)
          {
-            //Debug message
-            TRACE_INFO("Forwarding IPv6 packet to %s (%" PRIuSIZE " bytes)...\r\n",
-               destInterface->name, length);
-            //Dump IP header contents for debugging purpose
-            ipv6DumpHeader(ipHeader);
-
-            //Send PPP frame
-            error = pppSendFrame(destInterface, destBuffer, destOffset,
-               PPP_PROTOCOL_IPV6);
+            //Send the packet
+            error = ipv6SendForwardedPacket(srcInterface, destInterface,
+               cacheEntry, &destIpAddr, destBuffer, destOffset);
          }
-         else
+
+         //Free previously allocated memory
+         netBufferFree(destBuffer);
+      }
+      else
+      {
+         //Failed to allocate memory
+         error = ERROR_OUT_OF_MEMORY;
+      }
+   }
+
+   //Restore the original Hop Limit
+   ipHeader->hopLimit = hopLimit;
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Send a forwarded IPv6 packet to the next hop
+ * @param[in] srcInterface Network interface on which the packet was received
+ * @param[in] destInterface Outgoing network interface
+ * @param[in] cacheEntry Next-hop cache entry (optional parameter)
+ * @param[in] nextHop IPv6 address of the next hop
+ * @param[in] buffer Multi-part buffer that holds the IPv6 packet
+ * @param[in] offset Offset to the first byte of the IPv6 packet
+ * @return Error code
+ **/
+
+error_t ipv6SendForwardedPacket(NetInterface *srcInterface,
+   NetInterface *destInterface, Ipv6NextHopCacheEntry *cacheEntry,
+   const Ipv6Addr *nextHop, NetBuffer *buffer, size_t offset)
+{
+   error_t error;
+   NetTxAncillary ancillary;
+#if (ETH_SUPPORT == ENABLED)
+   NetInterface *physicalInterface;
+   NdpNeighborCacheEntry *neighbor;
 #endif
-         //6LoWPAN interface?
-         if(destInterface->nicDriver != NULL &&
-            destInterface->nicDriver->type == NIC_TYPE_6LOWPAN)
-         {
-            NetTxAncillary ancillary;
 
-            //Debug message
-            TRACE_INFO("Forwarding IPv6 packet to %s (%" PRIuSIZE " bytes)...\r\n",
-               destInterface->name, length);
-            //Dump IP header contents for debugging purpose
-            ipv6DumpHeader(ipHeader);
+   //Additional options can be passed to the stack along with the packet
+   ancillary = NET_DEFAULT_TX_ANCILLARY;
 
-            //Additional options can be passed to the stack along with the packet
-            ancillary = NET_DEFAULT_TX_ANCILLARY;
+#if (ETH_SUPPORT == ENABLED)
+   //Point to the physical interface
+   physicalInterface = nicGetPhysicalInterface(destInterface);
 
-            //Send the packet over the specified link
-            error = nicSendPacket(destInterface, destBuffer, destOffset,
-               &ancillary);
-         }
-         else
-         //Unknown interface type?
+   //Ethernet interface?
+   if(physicalInterface->nicDriver != NULL &&
+      physicalInterface->nicDriver->type == NIC_TYPE_ETHERNET)
+   {
+      //Neighbor cache entry of the next hop, as previously resolved
+      neighbor = (cacheEntry != NULL) ? cacheEntry->neighbor : NULL;
+
+      //Check whether the destination IPv6 address is a multicast address?
+      if(ipv6IsMulticastAddr(nextHop))
+      {
+         //Map IPv6 multicast address to MAC-layer multicast address
+         error = ipv6MapMulticastAddrToMac(nextHop, &ancillary.destMacAddr);
+      }
+      else if(neighbor != NULL && ipv6CompAddr(&neighbor->ipAddr, nextHop) &&
+         (neighbor->state == NDP_STATE_REACHABLE ||
+         neighbor->state == NDP_STATE_DELAY ||
+         neighbor->state == NDP_STATE_PROBE ||
+         neighbor->state == NDP_STATE_PERMANENT))
+      {
+         //The link-layer address of the next hop is known and does not need
+         //to be revalidated, so that the Neighbor cache is not searched
+         ancillary.destMacAddr = neighbor->macAddr;
+
+         //The entry is still in use, so that it must not be the first one to
+         //be evicted from the Neighbor cache
+         ndpUpdateNeighborLru(destInterface, neighbor, TRUE);
+         //Successful address resolution
+         error = NO_ERROR;
+      }
+      else
+      {
+         //Resolve host address using Neighbor Discovery protocol
+         error = ndpResolve(destInterface, nextHop, &ancillary.destMacAddr);
+
+         //Successful address resolution?
+         if(!error && cacheEntry != NULL)
          {
-            //Report an error
-            error = ERROR_INVALID_INTERFACE;
+            //Remember the Neighbor cache entry of the next hop
+            cacheEntry->neighbor = ndpFindNeighborCacheEntry(destInterface,
+               nextHop);
          }
       }
 
-      //Free previously allocated memory
-      netBufferFree(destBuffer);
+      //Successful address resolution?
+      if(!error)
+      {
+         //Send Ethernet frame
+         error = ethSendFrame(destInterface, &ancillary.destMacAddr,
+            ETH_TYPE_IPV6, buffer, offset, &ancillary);
+      }
+      //Address resolution in progress?
+      else if(error == ERROR_IN_PROGRESS)
+      {
+         //Enqueue packets waiting for address resolution (the packet is
+         //copied to the queue)
+         error = ndpEnqueuePacket(srcInterface, destInterface, nextHop, buffer,
+            offset, &ancillary);
+      }
+      //Address resolution failed?
+      else
+      {
+         //Debug message
+         TRACE_WARNING("Cannot map IPv6 address to Ethernet address!\r\n");
+      }
+   }
+   else
+#endif
+#if (PPP_SUPPORT == ENABLED)
+   //PPP interface?
+   if(destInterface->nicDriver != NULL &&
+      destInterface->nicDriver->type == NIC_TYPE_PPP)
+   {
+      //Send PPP frame
+      error = pppSendFrame(destInterface, buffer, offset, PPP_PROTOCOL_IPV6);
    }
    else
+#endif
+   //6LoWPAN interface?
+   if(destInterface->nicDriver != NULL &&
+      destInterface->nicDriver->type == NIC_TYPE_6LOWPAN)
    {
-      //Failed to allocate memory
-      error = ERROR_OUT_OF_MEMORY;
+      //Send the packet over the specified link
+      error = nicSendPacket(destInterface, buffer, offset, &ancillary);
+   }
+   else
+   //Unknown interface type?
+   {
+      //Report an error
+      error = ERROR_INVALID_INTERFACE;
    }
 
    //Return status code
    return error;
 }
 
+
+/**
+ * @brief Determine the next hop for a given destination
+ *
+ * The result of the route lookup is kept in a direct-mapped cache, together
+ * with the Neighbor cache entry of the next hop. Any change to the routing
+ * table invalidates the cache
+ *
+ * @param[in] destAddr Destination IPv6 address
+ * @return Pointer to the next-hop cache entry, or NULL if there is no usable
+ *   route to the destination
+ **/
+
+Ipv6NextHopCacheEntry *ipv6GetNextHop(const Ipv6Addr *destAddr)
+{
+   uint32_t h;
+   Ipv6NextHopCacheEntry *cacheEntry;
+   Ipv6RoutingTableEntry *entry;
+
+   //Hash the destination address
+   h = destAddr->dw[0] ^ destAddr->dw[1] ^ destAddr->dw[2] ^ destAddr->dw[3];
+   h ^= h >> 16;
+   h ^= h >> 8;
+
+   //Point to the corresponding cache entry
+   cacheEntry = &ipv6NextHopCache[h % IPV6_NEXT_HOP_CACHE_SIZE];
+
+   //Cache miss?
+   if(cacheEntry->generation != ipv6RoutingGeneration ||
+      !ipv6CompAddr(&cacheEntry->destAddr, destAddr))
+   {
+      //Search the trie for the longest matching prefix
+      entry = ipv6FindRoute(destAddr);
+      //No route to the destination?
+      if(entry == NULL)
+         return NULL;
+
+      //Save the destination address
+      cacheEntry->destAddr = *destAddr;
+      //Outgoing interface on which to forward the packet
+      cacheEntry->interface = entry->interface;
+
+      //Next hop
+      if(!ipv6CompAddr(&entry->nextHop, &IPV6_UNSPECIFIED_ADDR))
+      {
+         cacheEntry->nextHop = entry->nextHop;
+      }
+      else
+      {
+         cacheEntry->nextHop = *destAddr;
+      }
+
+      //The address of the next hop has not been resolved yet
+      cacheEntry->neighbor = NULL;
+      //The entry is now valid
+      cacheEntry->generation = ipv6RoutingGeneration;
+   }
+
+   //Do not forward any IP packets to an interface that has not been assigned
+   //a valid link-local address
+   if(ipv6GetLinkLocalAddrState(cacheEntry->interface) != IPV6_ADDR_STATE_PREFERRED)
+      return NULL;
+
+   //If routing is not enabled on the interface, then the router cannot
+   //forward packets to the interface
+   if(!cacheEntry->interface->ipv6Context.isRouter)
+      return NULL;
+
+   //Return the next-hop cache entry
+   return cacheEntry;
+}
+
+
+/**
+ * @brief Search the routing table for the longest matching prefix
+ * @param[in] destAddr Destination IPv6 address
+ * @return Pointer to the matching route, if any
+ **/
+
+Ipv6RoutingTableEntry *ipv6FindRoute(const Ipv6Addr *destAddr)
+{
+   uint_t i;
+   uint_t n;
+   Ipv6RoutingTrieNode *node;
+   Ipv6RoutingTrieSlot *slot;
+
+   //Start with the root node
+   node = &ipv6RoutingTrieRoot;
+
+   //Walk down the trie
+   for(i = 0; ; i++)
+   {
+      //Extract the current nibble of the address
+      n = (i & 1) ? (destAddr->b[i / 2] & 0x0F) : (destAddr->b[i / 2] >> 4);
+      //Point to the slot that covers the address
+      slot = &node->slot[n];
+
+      //Leaf reached?
+      if(!slot->child)
+         break;
+
+      //Jump to the child node
+      node = &ipv6RoutingTrie[slot->index];
+   }
+
+   //Return the matching route, if any
+   return (slot->index != 0) ? &ipv6RoutingTable[slot->index - 1] : NULL;
+}
+
+
+/**
+ * @brief Insert a route in the trie
+ * @param[in] index Index of the route in the routing table
+ * @return Error code
+ **/
+
+error_t ipv6InsertRoute(uint_t index)
+{
+   uint_t i;
+   uint_t n;
+   uint_t level;
+   uint_t first;
+   uint_t prefixLen;
+   const Ipv6Addr *prefix;
+   Ipv6RoutingTrieNode *node;
+   Ipv6RoutingTrieNode *child;
+   Ipv6RoutingTrieSlot *slot;
+
+   //Retrieve the prefix
+   prefix = &ipv6RoutingTable[index].prefix;
+   prefixLen = MIN(ipv6RoutingTable[index].prefixLen, 128);
+
+   //Start with the root node
+   node = &ipv6RoutingTrieRoot;
+
+   //Walk down the trie
+   for(level = 0; ; level++)
+   {
+      //Extract the current nibble of the prefix
+      n = (level & 1) ? (prefix->b[level / 2] & 0x0F) : (prefix->b[level / 2] >> 4);
+
+      //The prefix ends at the current level?
+      if(prefixLen <= ((level + 1) * IPV6_ROUTING_TRIE_STRIDE))
+         break;
+
+      //Point to the slot that covers the prefix
+      slot = &node->slot[n];
+
+      //The slot does not point to a child node yet?
+      if(!slot->child)
+      {
+         //The trie runs out of nodes?
+         if(ipv6RoutingTrieCount >= IPV6_ROUTING_TRIE_SIZE)
+            return ERROR_OUT_OF_RESOURCES;
+
+         //Allocate a new node
+         child = &ipv6RoutingTrie[ipv6RoutingTrieCount];
+
+         //The route that owned the slot covers the whole child node
+         for(i = 0; i < IPV6_ROUTING_TRIE_SLOTS; i++)
+         {
+            child->slot[i] = *slot;
+         }
+
+         //Link the child node to the slot
+         slot->index = ipv6RoutingTrieCount++;
+         slot->prefixLen = 0;
+         slot->child = TRUE;
+      }
+
+      //Jump to the child node
+      node = &ipv6RoutingTrie[slot->index];
+   }
+
+   //Number of slots covered by the prefix at this level
+   i = 1U << ((level + 1) * IPV6_ROUTING_TRIE_STRIDE - prefixLen);
+   //Index of the first slot
+   first = n & ~(i - 1);
+
+   //Expand the prefix
+   for(n = 0; n < i; n++)
+   {
+      ipv6FillTrieSlot(&node->slot[first + n], index + 1, prefixLen);
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Assign a route to a slot unless a longer prefix owns it
+ * @param[in] slot Pointer to the slot
+ * @param[in] index Index of the route plus one
+ * @param[in] prefixLen Length of the prefix
+ **/
+
+void ipv6FillTrieSlot(Ipv6RoutingTrieSlot *slot, uint_t index,
+   uint_t prefixLen)
+{
+   uint_t i;
+   Ipv6RoutingTrieNode *node;
+
+   //The slot points to a child node?
+   if(slot->child)
+   {
+      //Point to the child node
+      node = &ipv6RoutingTrie[slot->index];
+
+      //Longer prefixes may own some of the slots of the child node
+      for(i = 0; i < IPV6_ROUTING_TRIE_SLOTS; i++)
+      {
+         ipv6FillTrieSlot(&node->slot[i], index, prefixLen);
+      }
+   }
+   else if(slot->index == 0 || slot->prefixLen <= prefixLen)
+   {
+      //The route is the longest matching prefix for this slot
+      slot->index = index;
+      slot->prefixLen = prefixLen;
+   }
+   else
+   {
+      //A longer prefix owns the slot
+   }
+}
+
+
+/**
+ * @brief Rebuild the trie from the routing table
+ **/
+
+void ipv6RebuildRoutingTrie(void)
+{
+   uint_t i;
+
+   //Clear the trie
+   osMemset(&ipv6RoutingTrieRoot, 0, sizeof(ipv6RoutingTrieRoot));
+   ipv6RoutingTrieCount = 0;
+
+   //Loop through routing table entries
+   for(i = 0; i < IPV6_ROUTING_TABLE_SIZE; i++)
+   {
+      //Valid entry?
+      if(ipv6RoutingTable[i].valid)
+      {
+         //Insert the route in the trie
+         if(ipv6InsertRoute(i))
+         {
+            //The route cannot be added because the trie runs out of nodes
+            ipv6RoutingTable[i].valid = FALSE;
+         }
+      }
+   }
+}
+
 #endif
@@ -34,6 +34,7 @@
 //Dependencies
 #include "core/net.h"
 #include "ipv6/ipv6.h"
+#include "ipv6/ndp.h"
 
 //IPv6 routing support
 #ifndef IPV6_ROUTING_SUPPORT
@@ -45,10 +46,29 @@
 //Size of the IPv6 routing table
 #ifndef IPV6_ROUTING_TABLE_SIZE
    #define IPV6_ROUTING_TABLE_SIZE 8
-#elif (IPV6_ROUTING_TABLE_SIZE < 1)
+#elif (IPV6_ROUTING_TABLE_SIZE < 1 || IPV6_ROUTING_TABLE_SIZE > 65534)
    #error IPV6_ROUTING_TABLE_SIZE parameter is not valid
 #endif
 
+//Number of nodes of the prefix trie (excluding the root node)
+#ifndef IPV6_ROUTING_TRIE_SIZE
+   #define IPV6_ROUTING_TRIE_SIZE 64
+#elif (IPV6_ROUTING_TRIE_SIZE < 1 || IPV6_ROUTING_TRIE_SIZE > 65535)
+   #error IPV6_ROUTING_TRIE_SIZE parameter is not valid
+#endif
+
+//Size of the next-hop cache
+#ifndef IPV6_NEXT_HOP_CACHE_SIZE
+   #define IPV6_NEXT_HOP_CACHE_SIZE 16
+#elif (IPV6_NEXT_HOP_CACHE_SIZE < 1)
+   #error IPV6_NEXT_HOP_CACHE_SIZE parameter is not valid
+#endif
+
+//Number of address bits consumed at each level of the trie
+#define IPV6_ROUTING_TRIE_STRIDE 4
+//Number of slots per trie node
+#define IPV6_ROUTING_TRIE_SLOTS (1U << IPV6_ROUTING_TRIE_STRIDE)
+
 //C++ guard
 #ifdef __cplusplus
 extern "C" {
@@ -70,6 +90,45 @@ typedef struct
 } Ipv6RoutingTableEntry;
 
 
+/**
+ * @brief Slot of a trie node
+ *
+ * A slot either points to a child node or holds the longest prefix that
+ * covers the corresponding address range (leaf pushing)
+ **/
+
+typedef struct
+{
+   uint16_t index;    ///<Index of the child node, or index of the route plus one
+   uint8_t prefixLen; ///<Length of the prefix that owns the slot
+   uint8_t child;     ///<The slot points to a child node
+} Ipv6RoutingTrieSlot;
+
+
+/**
+ * @brief Trie node
+ **/
+
+typedef struct
+{
+   Ipv6RoutingTrieSlot slot[IPV6_ROUTING_TRIE_SLOTS];
+} Ipv6RoutingTrieNode;
+
+
+/**
+ * @brief Next-hop cache entry
+ **/
+
+typedef struct
+{
+   uint_t generation;               ///<Routing table generation the entry was built from
+   Ipv6Addr destAddr;               ///<Destination IPv6 address
+   NetInterface *interface;         ///<Outgoing network interface
+   Ipv6Addr nextHop;                ///<Next hop
+   NdpNeighborCacheEntry *neighbor; ///<Neighbor cache entry of the next hop
+} Ipv6NextHopCacheEntry;
+
+
 //IPv6 routing related functions
 error_t ipv6InitRouting(void);
 error_t ipv6EnableRouting(NetInterface *interface, bool_t enable);
@@ -83,6 +142,18 @@ error_t ipv6DeleteAllRoutes(void);
 error_t ipv6ForwardPacket(NetInterface *srcInterface, NetBuffer *ipPacket,
    size_t ipPacketOffset);
 
+error_t ipv6SendForwardedPacket(NetInterface *srcInterface,
+   NetInterface *destInterface, Ipv6NextHopCacheEntry *cacheEntry,
+   const Ipv6Addr *nextHop, NetBuffer *buffer, size_t offset);
+
+Ipv6NextHopCacheEntry *ipv6GetNextHop(const Ipv6Addr *destAddr);
+Ipv6RoutingTableEntry *ipv6FindRoute(const Ipv6Addr *destAddr);
+
+error_t ipv6InsertRoute(uint_t index);
+void ipv6FillTrieSlot(Ipv6RoutingTrieSlot *slot, uint_t index,
+   uint_t prefixLen);
+void ipv6RebuildRoutingTrie(void);
+
 //C++ guard
 #ifdef __cplusplus
 }
@@ -74,6 +74,8 @@ error_t ndpInit(NetInterface *interface)
 
    //Clear the NDP context
    osMemset(context, 0, sizeof(NdpContext));
+   //Initialize the Neighbor cache
+   ndpInitNeighborCache(interface);
 
    //Initialize interface specific variables
    context->reachableTime = NDP_REACHABLE_TIME;
@@ -169,7 +171,7 @@ error_t ndpAddStaticEntry(NetInterface *interface, const Ipv6Addr *ipAddr,
    else
    {
       //Create a new entry in the Neighbor cache
-      entry = ndpCreateNeighborCacheEntry(interface);
+      entry = ndpCreateNeighborCacheEntry(interface, ipAddr);
    }
 
    //Neighbor cache entry successfully created?
@@ -231,7 +233,7 @@ error_t ndpRemoveStaticEntry(NetInterface *interface, const Ipv6Addr *ipAddr)
    if(entry != NULL && entry->state == NDP_STATE_PERMANENT)
    {
       //Delete Neighbor cache entry
-      ndpChangeState(entry, NDP_STATE_NONE);
+      ndpDeleteNeighborCacheEntry(interface, entry);
       //Successful processing
       error = NO_ERROR;
    }
@@ -303,14 +305,11 @@ error_t ndpResolve(NetInterface *interface, const Ipv6Addr *ipAddr,
       if(interface->ndpContext.enable)
       {
          //If no entry exists, then create a new one
-         entry = ndpCreateNeighborCacheEntry(interface);
+         entry = ndpCreateNeighborCacheEntry(interface, ipAddr);
 
          //Neighbor cache entry successfully created?
          if(entry != NULL)
          {
-            //Record the IPv6 address whose MAC address is unknown
-            entry->ipAddr = *ipAddr;
-
             //Reset retransmission counter
             entry->retransmitCount = 0;
             //No packet are pending in the transmit queue
@@ -725,7 +724,8 @@ void ndpProcessRouterAdv(NetInterface *interface,
          if(interface->ndpContext.enable)
          {
             //Create a new entry for the router
-            entry = ndpCreateNeighborCacheEntry(interface);
+            entry = ndpCreateNeighborCacheEntry(interface,
+               &pseudoHeader->srcAddr);
 
             //Neighbor cache entry successfully created?
             if(entry != NULL)
@@ -1017,7 +1017,8 @@ void ndpProcessNeighborSol(NetInterface *interface,
          if(interface->ndpContext.enable)
          {
             //Create a new entry
-            neighborCacheEntry = ndpCreateNeighborCacheEntry(interface);
+            neighborCacheEntry = ndpCreateNeighborCacheEntry(interface,
+               &pseudoHeader->srcAddr);
 
             //Neighbor cache entry successfully created?
             if(neighborCacheEntry != NULL)
@@ -1468,6 +1469,9 @@ void ndpProcessRedirect(NetInterface *interface,
       }
    }
 
+   //The routes cached by the sockets may no longer be valid
+   netInvalidateRouteCache();
+
    //Search for the Target Link-Layer Address option
    option = ndpGetOption(message->options, length,
       NDP_OPT_TARGET_LINK_LAYER_ADDR);
@@ -1491,7 +1495,8 @@ void ndpProcessRedirect(NetInterface *interface,
          if(interface->ndpContext.enable)
          {
             //Create a new entry for the target
-            neighborCacheEntry = ndpCreateNeighborCacheEntry(interface);
+            neighborCacheEntry = ndpCreateNeighborCacheEntry(interface,
+               &message->targetAddr);
 
             //Neighbor cache entry successfully created?
             if(neighborCacheEntry != NULL)
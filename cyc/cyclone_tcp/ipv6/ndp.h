@@ -55,6 +55,13 @@
    #error NDP_NEIGHBOR_CACHE_SIZE parameter is not valid
 #endif
 
+//Number of buckets of the hash table used to search the Neighbor cache
+#ifndef NDP_NEIGHBOR_HASH_TABLE_SIZE
+   #define NDP_NEIGHBOR_HASH_TABLE_SIZE NDP_NEIGHBOR_CACHE_SIZE
+#elif (NDP_NEIGHBOR_HASH_TABLE_SIZE < 1)
+   #error NDP_NEIGHBOR_HASH_TABLE_SIZE parameter is not valid
+#endif
+
 //Destination cache size
 #ifndef NDP_DEST_CACHE_SIZE
    #define NDP_DEST_CACHE_SIZE 8
@@ -545,7 +552,7 @@ typedef struct
  * @brief Neighbor cache entry
  **/
 
-typedef struct
+typedef struct _NdpNeighborCacheEntry
 {
    NdpState state;                              ///<Reachability state
    Ipv6Addr ipAddr;                             ///<Unicast IPv6 address
@@ -556,6 +563,9 @@ typedef struct
    uint_t retransmitCount;                      ///<Retransmission counter
    NdpQueueItem queue[NDP_MAX_PENDING_PACKETS]; ///<Packets waiting for address resolution to complete
    uint_t queueSize;                            ///<Number of queued packets
+   struct _NdpNeighborCacheEntry *hashNext;     ///<Next entry in the same hash bucket
+   struct _NdpNeighborCacheEntry *lruPrev;      ///<Previous (more recently used) entry in the LRU list
+   struct _NdpNeighborCacheEntry *lruNext;      ///<Next (less recently used) entry in the LRU list
 } NdpNeighborCacheEntry;
 
 
@@ -591,6 +601,9 @@ typedef struct
    systime_t timeout;                                            ///<Timeout value
    bool_t enable;                                                ///<Enable address resolution using Neighbor Discovery protocol
    NdpNeighborCacheEntry neighborCache[NDP_NEIGHBOR_CACHE_SIZE]; ///<Neighbor cache
+   NdpNeighborCacheEntry *neighborHashTable[NDP_NEIGHBOR_HASH_TABLE_SIZE]; ///<Hash table used to search the Neighbor cache
+   NdpNeighborCacheEntry *neighborLruHead;                       ///<Most recently used Neighbor cache entry
+   NdpNeighborCacheEntry *neighborLruTail;                       ///<Least recently used Neighbor cache entry
    NdpDestCacheEntry destCache[NDP_DEST_CACHE_SIZE];             ///<Destination cache
 } NdpContext;
 
@@ -44,6 +44,39 @@
 #if (IPV6_SUPPORT == ENABLED && NDP_SUPPORT == ENABLED)
 
 
+/**
+ * @brief Initialize the Neighbor cache
+ * @param[in] interface Underlying network interface
+ **/
+
+void ndpInitNeighborCache(NetInterface *interface)
+{
+   uint_t i;
+   NdpContext *context;
+
+   //Point to the NDP context
+   context = &interface->ndpContext;
+
+   //Clear the Neighbor cache
+   osMemset(context->neighborCache, 0, sizeof(context->neighborCache));
+   osMemset(context->neighborHashTable, 0, sizeof(context->neighborHashTable));
+
+   //All the entries are initially free and linked together in the LRU list
+   for(i = 0; i < NDP_NEIGHBOR_CACHE_SIZE; i++)
+   {
+      context->neighborCache[i].lruPrev = (i > 0) ?
+         &context->neighborCache[i - 1] : NULL;
+
+      context->neighborCache[i].lruNext = (i < (NDP_NEIGHBOR_CACHE_SIZE - 1)) ?
+         &context->neighborCache[i + 1] : NULL;
+   }
+
+   //Head and tail of the LRU list
+   context->neighborLruHead = &context->neighborCache[0];
+   context->neighborLruTail = &context->neighborCache[NDP_NEIGHBOR_CACHE_SIZE - 1];
+}
+
+
 /**
  * @brief Update Neighbor cache entry state
  * @param[in] entry Pointer to a Neighbor cache entry
@@ -60,86 +93,77 @@ void ndpChangeState(NdpNeighborCacheEntry *entry, NdpState newState)
    entry->timestamp = osGetSystemTime();
    //Switch to the new state
    entry->state = newState;
+
+   //The MAC addresses cached by the sockets must be resolved again
+   netInvalidateRouteCache();
 }
 
 
 /**
  * @brief Create a new entry in the Neighbor cache
+ *
+ * A free entry is used when available. Otherwise the least recently used
+ * dynamic entry is removed whenever the table runs out of space
+ *
  * @param[in] interface Underlying network interface
+ * @param[in] ipAddr IPv6 address
  * @return Pointer to the newly created entry
  **/
 
-NdpNeighborCacheEntry *ndpCreateNeighborCacheEntry(NetInterface *interface)
+NdpNeighborCacheEntry *ndpCreateNeighborCacheEntry(NetInterface *interface,
+   const Ipv6Addr *ipAddr)
 {
    uint_t i;
-   systime_t time;
+   NdpContext *context;
    NdpNeighborCacheEntry *entry;
-   NdpNeighborCacheEntry *oldestEntry;
-
-   //Get current time
-   time = osGetSystemTime();
+   NdpNeighborCacheEntry *lruPrev;
+   NdpNeighborCacheEntry *lruNext;
 
-   //Keep track of the oldest entry
-   oldestEntry = NULL;
+   //Point to the NDP context
+   context = &interface->ndpContext;
 
-   //Loop through Neighbor cache entries
-   for(i = 0; i < NDP_NEIGHBOR_CACHE_SIZE; i++)
+   //Free entries are moved to the tail of the LRU list. Static Neighbor
+   //cache entries are never updated
+   for(entry = context->neighborLruTail; entry != NULL; entry = entry->lruPrev)
    {
-      //Point to the current entry
-      entry = &interface->ndpContext.neighborCache[i];
-
-      //Check the state of the Neighbor cache entry
-      if(entry->state == NDP_STATE_NONE)
-      {
-         //Initialize Neighbor cache entry
-         osMemset(entry, 0, sizeof(NdpNeighborCacheEntry));
-
-         //Return a pointer to the Neighbor cache entry
-         return entry;
-      }
-      else if(entry->state == NDP_STATE_PERMANENT)
-      {
-         //Static Neighbor cache entries are never updated
-      }
-      else
-      {
-         //Keep track of the oldest entry in the table
-         if(oldestEntry == NULL)
-         {
-            oldestEntry = entry;
-         }
-         else if(entry->state == NDP_STATE_STALE &&
-            oldestEntry->state != NDP_STATE_STALE)
-         {
-            oldestEntry = entry;
-         }
-         else if(entry->state != NDP_STATE_STALE &&
-            oldestEntry->state == NDP_STATE_STALE)
-         {
-         }
-         else if((time - entry->timestamp) > (time - oldestEntry->timestamp))
-         {
-            oldestEntry = entry;
-         }
-         else
-         {
-         }
-      }
+      if(entry->state != NDP_STATE_PERMANENT)
+         break;
    }
 
    //Any entry available in the Neighbor cache?
-   if(oldestEntry != NULL)
+   if(entry != NULL)
    {
-      //Drop any pending packets
-      ndpFlushQueuedPackets(interface, oldestEntry);
-      //The oldest entry is removed whenever the table runs out of space
-      ndpChangeState(oldestEntry, NDP_STATE_NONE);
+      //Remove the least recently used entry, if necessary
+      if(entry->state != NDP_STATE_NONE)
+      {
+         ndpDeleteNeighborCacheEntry(interface, entry);
+      }
+
+      //Save the position of the entry in the LRU list
+      lruPrev = entry->lruPrev;
+      lruNext = entry->lruNext;
+
       //Initialize Neighbor cache entry
-      osMemset(oldestEntry, 0, sizeof(NdpNeighborCacheEntry));
+      osMemset(entry, 0, sizeof(NdpNeighborCacheEntry));
+
+      //Restore the position of the entry in the LRU list
+      entry->lruPrev = lruPrev;
+      entry->lruNext = lruNext;
+
+      //Record the IPv6 address
+      entry->ipAddr = *ipAddr;
+
+      //Insert the entry in the hash table
+      i = ndpGetNeighborHashIndex(ipAddr);
+      entry->hashNext = context->neighborHashTable[i];
+      context->neighborHashTable[i] = entry;
+
+      //The entry is now the most recently used one
+      ndpUpdateNeighborLru(interface, entry, TRUE);
    }
 
    //Return a pointer to the Neighbor cache entry
-   return oldestEntry;
+   return entry;
 }
 
 
@@ -154,28 +178,67 @@ NdpNeighborCacheEntry *ndpCreateNeighborCacheEntry(NetInterface *interface)
 NdpNeighborCacheEntry *ndpFindNeighborCacheEntry(NetInterface *interface,
    const Ipv6Addr *ipAddr)
 {
-   uint_t i;
    NdpNeighborCacheEntry *entry;
 
-   //Loop through Neighbor cache entries
-   for(i = 0; i < NDP_NEIGHBOR_CACHE_SIZE; i++)
+   //Only the entries that belong to the matching hash bucket are searched
+   entry = interface->ndpContext.neighborHashTable[ndpGetNeighborHashIndex(ipAddr)];
+
+   //Loop through the entries of the bucket
+   while(entry != NULL)
    {
-      //Point to the current entry
-      entry = &interface->ndpContext.neighborCache[i];
+      //Current entry matches the specified address?
+      if(ipv6CompAddr(&entry->ipAddr, ipAddr))
+      {
+         //The entry is now the most recently used one
+         ndpUpdateNeighborLru(interface, entry, TRUE);
+         //Return a pointer to the Neighbor cache entry
+         return entry;
+      }
 
-      //Check whether the entry is currently in use
-      if(entry->state != NDP_STATE_NONE)
+      //Point to the next entry
+      entry = entry->hashNext;
+   }
+
+   //No matching entry in Neighbor cache
+   return NULL;
+}
+
+
+/**
+ * @brief Delete an entry from the Neighbor cache
+ * @param[in] interface Underlying network interface
+ * @param[in] entry Pointer to a Neighbor cache entry
+ **/
+
+void ndpDeleteNeighborCacheEntry(NetInterface *interface,
+   NdpNeighborCacheEntry *entry)
+{
+   NdpNeighborCacheEntry **p;
+
+   //Entries that are in use are linked in the hash table
+   if(entry->state != NDP_STATE_NONE)
+   {
+      //Drop packets that are waiting for address resolution
+      ndpFlushQueuedPackets(interface, entry);
+
+      //Remove the entry from its hash bucket
+      for(p = &interface->ndpContext.neighborHashTable[ndpGetNeighborHashIndex(&entry->ipAddr)];
+         *p != NULL; p = &(*p)->hashNext)
       {
-         //Current entry matches the specified address?
-         if(ipv6CompAddr(&entry->ipAddr, ipAddr))
+         if(*p == entry)
          {
-            return entry;
+            *p = entry->hashNext;
+            break;
          }
       }
+
+      //Free entries are reused first
+      entry->hashNext = NULL;
+      ndpUpdateNeighborLru(interface, entry, FALSE);
    }
 
-   //No matching entry in Neighbor cache
-   return NULL;
+   //Delete Neighbor cache entry
+   ndpChangeState(entry, NDP_STATE_NONE);
 }
 
 
@@ -225,11 +288,9 @@ void ndpUpdateNeighborCache(NetInterface *interface)
             }
             else
             {
-               //Drop packets that are waiting for address resolution
-               ndpFlushQueuedPackets(interface, entry);
-
-               //The entry should be deleted since address resolution has failed
-               ndpChangeState(entry, NDP_STATE_NONE);
+               //The entry should be deleted since address resolution has
+               //failed (pending packets are dropped)
+               ndpDeleteNeighborCacheEntry(interface, entry);
             }
          }
       }
@@ -289,7 +350,7 @@ void ndpUpdateNeighborCache(NetInterface *interface)
             {
                //The entry should be deleted since the host is not reachable
                //anymore
-               ndpChangeState(entry, NDP_STATE_NONE);
+               ndpDeleteNeighborCacheEntry(interface, entry);
 
                //If at some point communication ceases to proceed, as determined
                //by the Neighbor Unreachability Detection algorithm, next-hop
@@ -301,7 +362,7 @@ void ndpUpdateNeighborCache(NetInterface *interface)
       else
       {
          //Just for sanity
-         ndpChangeState(entry, NDP_STATE_NONE);
+         ndpDeleteNeighborCacheEntry(interface, entry);
       }
    }
 }
@@ -330,11 +391,8 @@ void ndpFlushNeighborCache(NetInterface *interface)
       }
       else
       {
-         //Drop packets that are waiting for address resolution
-         ndpFlushQueuedPackets(interface, entry);
-
          //Delete Neighbor cache entry
-         ndpChangeState(entry, NDP_STATE_NONE);
+         ndpDeleteNeighborCacheEntry(interface, entry);
       }
    }
 }
@@ -486,6 +544,8 @@ NdpDestCacheEntry *ndpCreateDestCacheEntry(NetInterface *interface)
 
    //The oldest entry is removed whenever the table runs out of space
    osMemset(oldestEntry, 0, sizeof(NdpDestCacheEntry));
+   //The routes cached by the sockets may no longer be valid
+   netInvalidateRouteCache();
 
    //Return a pointer to the Destination cache entry
    return oldestEntry;
@@ -534,6 +594,89 @@ void ndpFlushDestCache(NetInterface *interface)
    //Clear the Destination Cache
    osMemset(interface->ndpContext.destCache, 0,
       sizeof(interface->ndpContext.destCache));
+
+   //The routes cached by the sockets are no longer valid
+   netInvalidateRouteCache();
+}
+
+/**
+ * @brief Compute the hash bucket of a given IPv6 address
+ * @param[in] ipAddr IPv6 address
+ * @return Index of the hash bucket
+ **/
+
+uint_t ndpGetNeighborHashIndex(const Ipv6Addr *ipAddr)
+{
+   uint32_t h;
+
+   //Neighbors on the same link share the same prefix, so the interface
+   //identifier carries most of the entropy
+   h = ipAddr->dw[0] ^ ipAddr->dw[1] ^ ipAddr->dw[2] ^ ipAddr->dw[3];
+   h = h * 0x9E3779B1;
+   h ^= h >> 16;
+
+   //Return the index of the hash bucket
+   return h % NDP_NEIGHBOR_HASH_TABLE_SIZE;
+}
+
+
+/**
+ * @brief Move an entry to the head or the tail of the LRU list
+ * @param[in] interface Underlying network interface
+ * @param[in] entry Pointer to a Neighbor cache entry
+ * @param[in] mostRecent Move the entry to the head (TRUE) or to the tail
+ *   (FALSE) of the LRU list
+ **/
+
+void ndpUpdateNeighborLru(NetInterface *interface,
+   NdpNeighborCacheEntry *entry, bool_t mostRecent)
+{
+   NdpContext *context;
+
+   //Point to the NDP context
+   context = &interface->ndpContext;
+
+   //Check whether the entry is already in place
+   if(mostRecent && context->neighborLruHead == entry)
+      return;
+   if(!mostRecent && context->neighborLruTail == entry)
+      return;
+
+   //Unlink the entry from its predecessor
+   if(entry->lruPrev != NULL)
+   {
+      entry->lruPrev->lruNext = entry->lruNext;
+   }
+   else
+   {
+      context->neighborLruHead = entry->lruNext;
+   }
+
+   //Unlink the entry from its successor
+   if(entry->lruNext != NULL)
+   {
+      entry->lruNext->lruPrev = entry->lruPrev;
+   }
+   else
+   {
+      context->neighborLruTail = entry->lruPrev;
+   }
+
+   //Relink the entry at the requested end of the list
+   if(mostRecent)
+   {
+      entry->lruPrev = NULL;
+      entry->lruNext = context->neighborLruHead;
+      context->neighborLruHead->lruPrev = entry;
+      context->neighborLruHead = entry;
+   }
+   else
+   {
+      entry->lruNext = NULL;
+      entry->lruPrev = context->neighborLruTail;
+      context->neighborLruTail->lruNext = entry;
+      context->neighborLruTail = entry;
+   }
 }
 
 #endif
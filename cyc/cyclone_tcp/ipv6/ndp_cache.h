@@ -41,19 +41,29 @@ extern "C" {
 #endif
 
 //NDP related functions
+void ndpInitNeighborCache(NetInterface *interface);
 void ndpChangeState(NdpNeighborCacheEntry *entry, NdpState newState);
 
-NdpNeighborCacheEntry *ndpCreateNeighborCacheEntry(NetInterface *interface);
+NdpNeighborCacheEntry *ndpCreateNeighborCacheEntry(NetInterface *interface,
+   const Ipv6Addr *ipAddr);
 
 NdpNeighborCacheEntry *ndpFindNeighborCacheEntry(NetInterface *interface,
    const Ipv6Addr *ipAddr);
 
+void ndpDeleteNeighborCacheEntry(NetInterface *interface,
+   NdpNeighborCacheEntry *entry);
+
 void ndpUpdateNeighborCache(NetInterface *interface);
 void ndpFlushNeighborCache(NetInterface *interface);
 
 uint_t ndpSendQueuedPackets(NetInterface *interface, NdpNeighborCacheEntry *entry);
 void ndpFlushQueuedPackets(NetInterface *interface, NdpNeighborCacheEntry *entry);
 
+uint_t ndpGetNeighborHashIndex(const Ipv6Addr *ipAddr);
+
+void ndpUpdateNeighborLru(NetInterface *interface,
+   NdpNeighborCacheEntry *entry, bool_t mostRecent);
+
 NdpDestCacheEntry *ndpCreateDestCacheEntry(NetInterface *interface);
 
 NdpDestCacheEntry *ndpFindDestCacheEntry(NetInterface *interface,
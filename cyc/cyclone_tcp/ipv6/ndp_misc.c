@@ -231,6 +231,8 @@ void ndpUpdateAddrList(NetInterface *interface)
                //address in existing communications, but should not be used
                //to initiate new communications
                entry->state = IPV6_ADDR_STATE_DEPRECATED;
+               //Source address selection must be performed again
+               netInvalidateRouteCache();
             }
          }
       }
@@ -578,6 +580,9 @@ void ndpUpdateNextHop(NetInterface *interface, const Ipv6Addr *unreachableNextHo
       //Check whether the unreachable IPv6 address is used a first-hop router
       if(ipv6CompAddr(&entry->nextHop, unreachableNextHop))
       {
+         //The routes cached by the sockets are no longer valid
+         netInvalidateRouteCache();
+
          //Perform next-hop determination
          error = ndpSelectNextHop(interface, &entry->destAddr, &entry->nextHop,
             &entry->nextHop, FALSE);
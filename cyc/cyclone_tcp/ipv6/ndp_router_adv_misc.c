@@ -253,7 +253,8 @@ void ndpProcessRouterSol(NetInterface *interface,
          if(interface->ndpContext.enable)
          {
             //Create a new entry
-            entry = ndpCreateNeighborCacheEntry(interface);
+            entry = ndpCreateNeighborCacheEntry(interface,
+               &pseudoHeader->srcAddr);
 
             //Neighbor Cache entry successfully created?
             if(entry != NULL)
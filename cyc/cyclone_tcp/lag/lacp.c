@@ -0,0 +1,707 @@
+/**
+ * @file lacp.c
+ * @brief LACP (Link Aggregation Control Protocol)
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * LACP allows two systems to agree on which of the links connecting them
+ * can be aggregated. Each member port periodically exchanges LACPDUs with
+ * its partner. A port starts collecting and distributing frames once both
+ * ends agree that it belongs to the same aggregation (coupled control).
+ * Refer to IEEE 802.1AX for more details
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL ETH_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "core/ethernet.h"
+#include "lag/lag.h"
+#include "lag/lag_misc.h"
+#include "lag/lacp.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (ETH_SUPPORT == ENABLED && LAG_SUPPORT == ENABLED)
+
+//Slow protocols multicast address
+const MacAddr LACP_MULTICAST_ADDR = {{{0x01, 0x80, 0xC2, 0x00, 0x00, 0x02}}};
+
+
+/**
+ * @brief Initialize a member port
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Pointer to the member port
+ **/
+
+void lacpInitPort(LagContext *context, LagPort *port)
+{
+   //The port has not yet exchanged any LACPDU with its partner
+   lacpResetPort(context, port);
+
+   //Transmit a LACPDU as soon as the link is up
+   netStopTimer(&port->periodicTimer);
+   port->ntt = FALSE;
+}
+
+
+/**
+ * @brief Revert a member port to its default state
+ *
+ * The partner information is discarded and the port is detached from the
+ * aggregator. This happens when the link goes down or when no LACPDU has
+ * been received for a while
+ *
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Pointer to the member port
+ **/
+
+void lacpResetPort(LagContext *context, LagPort *port)
+{
+   //Discard partner information
+   osMemset(&port->partner, 0, sizeof(LagPortInfo));
+   netStopTimer(&port->currentWhileTimer);
+
+   //Active LACP, aggregatable link
+   port->actorState = LACP_STATE_ACTIVITY | LACP_STATE_AGGREGATION |
+      LACP_STATE_DEFAULTED;
+
+   //Ask the partner to send LACPDUs every second, if necessary
+   if(context->fastRate)
+   {
+      port->actorState |= LACP_STATE_TIMEOUT;
+   }
+
+   //Detach the port from the aggregator
+   port->selected = FALSE;
+   port->distributing = FALSE;
+}
+
+
+/**
+ * @brief LACP timer handler
+ *
+ * This routine must be periodically called by the aggregator driver
+ *
+ * @param[in] context Pointer to the link aggregation context
+ **/
+
+void lacpTick(LagContext *context)
+{
+   uint_t i;
+   LagPort *port;
+
+   //Loop through the member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Point to the current port
+      port = &context->ports[i];
+
+      //Link down?
+      if(!port->interface->linkState)
+      {
+         //Forget the partner as soon as the link goes down
+         if(port->selected || (port->actorState & LACP_STATE_DEFAULTED) == 0)
+         {
+            lacpResetPort(context, port);
+         }
+
+         //Restart LACPDU transmission when the link comes back
+         netStopTimer(&port->periodicTimer);
+         continue;
+      }
+
+      //No LACPDU received from the partner for a while?
+      if(netTimerRunning(&port->currentWhileTimer) &&
+         netTimerExpired(&port->currentWhileTimer))
+      {
+         //First expiry?
+         if((port->actorState & LACP_STATE_EXPIRED) == 0)
+         {
+            //Debug message
+            TRACE_INFO("LACP partner information expired on %s\r\n",
+               port->interface->name);
+
+            //The partner is no longer considered in sync and is asked to
+            //send LACPDUs every second
+            port->actorState |= LACP_STATE_EXPIRED | LACP_STATE_TIMEOUT;
+            port->partner.state &= ~LACP_STATE_SYNCHRONIZATION;
+            port->partner.state |= LACP_STATE_TIMEOUT;
+
+            //Wait a short time for the partner to reply
+            netStartTimer(&port->currentWhileTimer, LACP_SHORT_TIMEOUT_TIME);
+         }
+         else
+         {
+            //Debug message
+            TRACE_INFO("LACP partner lost on %s\r\n", port->interface->name);
+
+            //Fall back to the default partner information
+            lacpResetPort(context, port);
+         }
+
+         //Let the partner know about the change
+         port->ntt = TRUE;
+      }
+
+      //Periodic transmission
+      if(!netTimerRunning(&port->periodicTimer) ||
+         netTimerExpired(&port->periodicTimer))
+      {
+         //The transmission rate is requested by the partner
+         if((port->partner.state & LACP_STATE_TIMEOUT) != 0)
+         {
+            netStartTimer(&port->periodicTimer, LACP_FAST_PERIODIC_TIME);
+         }
+         else
+         {
+            netStartTimer(&port->periodicTimer, LACP_SLOW_PERIODIC_TIME);
+         }
+
+         //Transmit a LACPDU
+         port->ntt = TRUE;
+      }
+   }
+
+   //Update the ports attached to the aggregator
+   lacpUpdateAggregation(context);
+}
+
+
+/**
+ * @brief Process incoming slow protocols frame
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Member port on which the frame was received
+ * @param[in] data Pointer to the frame payload
+ * @param[in] length Length of the payload, in bytes
+ **/
+
+void lacpProcessPdu(LagContext *context, LagPort *port, const uint8_t *data,
+   size_t length)
+{
+   //LACPDUs and marker PDUs have a fixed length of 110 bytes
+   if(length < sizeof(LacpPdu))
+      return;
+
+   //Check subtype
+   if(data[0] == LACP_SUBTYPE_LACP)
+   {
+      //Process LACPDU
+      lacpProcessLacpPdu(context, port, (LacpPdu *) data);
+   }
+   else if(data[0] == LACP_SUBTYPE_MARKER)
+   {
+      //Process marker PDU
+      lacpProcessMarkerPdu(context, port, (LacpMarkerPdu *) data);
+   }
+   else
+   {
+      //Other slow protocols are not supported
+   }
+}
+
+
+/**
+ * @brief Process incoming LACPDU
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Member port on which the LACPDU was received
+ * @param[in] pdu Pointer to the LACPDU
+ **/
+
+void lacpProcessLacpPdu(LagContext *context, LagPort *port,
+   const LacpPdu *pdu)
+{
+   systime_t period;
+   uint8_t mask;
+
+   //Check the actor and partner information TLVs
+   if(pdu->actor.type != LACP_TLV_TYPE_ACTOR_INFO ||
+      pdu->actor.length != LACP_INFO_TLV_LEN ||
+      pdu->partner.type != LACP_TLV_TYPE_PARTNER_INFO ||
+      pdu->partner.length != LACP_INFO_TLV_LEN)
+   {
+      //Malformed LACPDU
+      return;
+   }
+
+   //Debug message
+   TRACE_DEBUG("LACPDU received on %s (partner state 0x%02" PRIX8 ")\r\n",
+      port->interface->name, pdu->actor.state);
+
+   //Record the information sent by the partner
+   port->partner.systemPriority = ntohs(pdu->actor.systemPriority);
+   port->partner.systemId = pdu->actor.system;
+   port->partner.key = ntohs(pdu->actor.key);
+   port->partner.portPriority = ntohs(pdu->actor.portPriority);
+   port->partner.portNumber = ntohs(pdu->actor.port);
+   port->partner.state = pdu->actor.state;
+
+   //Check whether the partner has recorded the identity of the actor
+   if(ntohs(pdu->partner.systemPriority) != context->systemPriority ||
+      !macCompAddr(&pdu->partner.system, &context->interface->macAddr) ||
+      ntohs(pdu->partner.key) != context->key ||
+      ntohs(pdu->partner.portPriority) != LAG_PORT_PRIORITY ||
+      ntohs(pdu->partner.port) != port->portNumber ||
+      (pdu->partner.state & LACP_STATE_AGGREGATION) !=
+      (port->actorState & LACP_STATE_AGGREGATION))
+   {
+      //The synchronization reported by the partner does not apply to the
+      //actor
+      port->partner.state &= ~LACP_STATE_SYNCHRONIZATION;
+      //Send updated information to the partner
+      port->ntt = TRUE;
+   }
+
+   //State bits the partner must have recorded correctly
+   mask = LACP_STATE_ACTIVITY | LACP_STATE_TIMEOUT | LACP_STATE_AGGREGATION |
+      LACP_STATE_SYNCHRONIZATION;
+
+   //Out-of-date actor state?
+   if((pdu->partner.state & mask) != (port->actorState & mask))
+   {
+      //Send updated information to the partner
+      port->ntt = TRUE;
+   }
+
+   //The partner information is now current
+   port->actorState &= ~(LACP_STATE_EXPIRED | LACP_STATE_DEFAULTED);
+
+   //Restore the timeout requested by the actor
+   if(context->fastRate)
+   {
+      port->actorState |= LACP_STATE_TIMEOUT;
+   }
+   else
+   {
+      port->actorState &= ~LACP_STATE_TIMEOUT;
+   }
+
+   //Restart the timer that detects the loss of the partner
+   if((port->actorState & LACP_STATE_TIMEOUT) != 0)
+   {
+      netStartTimer(&port->currentWhileTimer, LACP_SHORT_TIMEOUT_TIME);
+   }
+   else
+   {
+      netStartTimer(&port->currentWhileTimer, LACP_LONG_TIMEOUT_TIME);
+   }
+
+   //Transmission rate requested by the partner
+   if((port->partner.state & LACP_STATE_TIMEOUT) != 0)
+   {
+      period = LACP_FAST_PERIODIC_TIME;
+   }
+   else
+   {
+      period = LACP_SLOW_PERIODIC_TIME;
+   }
+
+   //Adjust the periodic timer when the partner changes its rate
+   if(port->periodicTimer.interval != period)
+   {
+      netStartTimer(&port->periodicTimer, period);
+   }
+
+   //Update the ports attached to the aggregator
+   lacpUpdateAggregation(context);
+}
+
+
+/**
+ * @brief Process incoming marker PDU
+ *
+ * The marker responder sends the information back to the requester so that
+ * it can flush a conversation before moving it to another link
+ *
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Member port on which the marker PDU was received
+ * @param[in] pdu Pointer to the marker PDU
+ **/
+
+void lacpProcessMarkerPdu(LagContext *context, LagPort *port,
+   const LacpMarkerPdu *pdu)
+{
+   error_t error;
+   size_t offset;
+   NetBuffer *buffer;
+   LacpMarkerPdu *response;
+   NetTxAncillary ancillary;
+
+   //Only marker information TLVs require a response
+   if(pdu->type != LACP_MARKER_TLV_TYPE_INFO ||
+      pdu->length != LACP_MARKER_INFO_TLV_LEN)
+   {
+      return;
+   }
+
+   //Allocate a memory buffer to hold the marker response
+   buffer = ethAllocBuffer(sizeof(LacpMarkerPdu), &offset);
+   //Failed to allocate buffer?
+   if(buffer == NULL)
+      return;
+
+   //Point to the marker response
+   response = netBufferAt(buffer, offset, 0);
+
+   //The response carries the same information as the request
+   osMemcpy(response, pdu, sizeof(LacpMarkerPdu));
+   response->type = LACP_MARKER_TLV_TYPE_RESPONSE;
+
+   //Debug message
+   TRACE_DEBUG("Sending marker response on %s...\r\n", port->interface->name);
+
+   //Additional options can be passed to the stack along with the packet
+   ancillary = NET_DEFAULT_TX_ANCILLARY;
+
+   //Send the marker response
+   error = ethSendFrame(port->interface, &LACP_MULTICAST_ADDR, ETH_TYPE_SLOW,
+      buffer, offset, &ancillary);
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_WARNING("Failed to send marker response!\r\n");
+   }
+
+   //Free previously allocated memory
+   netBufferFree(buffer);
+}
+
+
+/**
+ * @brief Select the partner system the aggregator is attached to
+ *
+ * All the ports connected to the same partner system with the same key are
+ * attached to the aggregator. The first eligible port determines the
+ * partner when the aggregator is not yet attached
+ *
+ * @param[in] context Pointer to the link aggregation context
+ **/
+
+void lacpSelectAggregator(LagContext *context)
+{
+   uint_t i;
+   bool_t found;
+   LagPort *port;
+
+   //The aggregator is currently attached to a partner system?
+   if(context->partnerValid)
+   {
+      //Initialize flag
+      found = FALSE;
+
+      //Check whether the partner is still reachable through a member port
+      for(i = 0; i < context->numPorts && !found; i++)
+      {
+         //Point to the current port
+         port = &context->ports[i];
+
+         //Matching partner?
+         if(lacpIsPortEligible(context, port) &&
+            lacpComparePartner(&port->partner, &context->partner))
+         {
+            found = TRUE;
+         }
+      }
+
+      //Detach the aggregator from a partner that is no longer reachable
+      if(!found)
+      {
+         context->partnerValid = FALSE;
+      }
+   }
+
+   //The aggregator is not attached to any partner system?
+   if(!context->partnerValid)
+   {
+      //Loop through the member ports
+      for(i = 0; i < context->numPorts; i++)
+      {
+         //Point to the current port
+         port = &context->ports[i];
+
+         //The first eligible port determines the partner system
+         if(lacpIsPortEligible(context, port))
+         {
+            context->partner = port->partner;
+            context->partnerValid = TRUE;
+            break;
+         }
+      }
+   }
+
+   //Loop through the member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Point to the current port
+      port = &context->ports[i];
+
+      //Attach the ports connected to the selected partner
+      if(context->partnerValid && lacpIsPortEligible(context, port) &&
+         lacpComparePartner(&port->partner, &context->partner))
+      {
+         port->selected = TRUE;
+      }
+      else
+      {
+         port->selected = FALSE;
+      }
+   }
+}
+
+
+/**
+ * @brief Check whether a member port can be attached to the aggregator
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Pointer to the member port
+ * @return TRUE if the port can be aggregated, else FALSE
+ **/
+
+bool_t lacpIsPortEligible(LagContext *context, LagPort *port)
+{
+   bool_t eligible;
+
+   //The link must be up and the partner must be known and willing to
+   //aggregate the link
+   if(context->running && port->interface->linkState &&
+      (port->actorState & LACP_STATE_DEFAULTED) == 0 &&
+      (port->partner.state & LACP_STATE_AGGREGATION) != 0 &&
+      port->partner.key != 0)
+   {
+      eligible = TRUE;
+   }
+   else
+   {
+      eligible = FALSE;
+   }
+
+   //Return TRUE if the port can be aggregated
+   return eligible;
+}
+
+
+/**
+ * @brief Check whether two ports are connected to the same partner system
+ * @param[in] partner1 Pointer to the first partner information
+ * @param[in] partner2 Pointer to the second partner information
+ * @return TRUE if the partner system and key match, else FALSE
+ **/
+
+bool_t lacpComparePartner(const LagPortInfo *partner1,
+   const LagPortInfo *partner2)
+{
+   bool_t res;
+
+   //Compare system identifiers and keys
+   if(partner1->systemPriority == partner2->systemPriority &&
+      macCompAddr(&partner1->systemId, &partner2->systemId) &&
+      partner1->key == partner2->key)
+   {
+      res = TRUE;
+   }
+   else
+   {
+      res = FALSE;
+   }
+
+   //Return comparison result
+   return res;
+}
+
+
+/**
+ * @brief Update the ports attached to the aggregator
+ *
+ * Port selection and the mux state are re-evaluated, pending LACPDUs are
+ * sent and the set of distributing ports is rebuilt
+ *
+ * @param[in] context Pointer to the link aggregation context
+ **/
+
+void lacpUpdateAggregation(LagContext *context)
+{
+   uint_t i;
+   LagPort *port;
+
+   //Select the ports attached to the aggregator
+   lacpSelectAggregator(context);
+
+   //Loop through the member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Point to the current port
+      port = &context->ports[i];
+
+      //Update the mux state of the port
+      lacpUpdateMux(context, port);
+
+      //Any LACPDU to transmit?
+      if(port->ntt && port->interface->linkState)
+      {
+         lacpSendPdu(context, port);
+      }
+   }
+
+   //Rebuild the set of distributing ports
+   lagUpdateActivePorts(context);
+}
+
+
+/**
+ * @brief Update the mux state of a member port (coupled control)
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Pointer to the member port
+ **/
+
+void lacpUpdateMux(LagContext *context, LagPort *port)
+{
+   uint8_t state;
+
+   //Current actor state
+   state = port->actorState;
+
+   //The actor is in sync as soon as the port is attached to the aggregator
+   if(port->selected)
+   {
+      state |= LACP_STATE_SYNCHRONIZATION;
+   }
+   else
+   {
+      state &= ~LACP_STATE_SYNCHRONIZATION;
+   }
+
+   //Collect and distribute once the partner is in sync as well
+   if(port->selected && (port->partner.state & LACP_STATE_SYNCHRONIZATION) != 0)
+   {
+      state |= LACP_STATE_COLLECTING | LACP_STATE_DISTRIBUTING;
+   }
+   else
+   {
+      state &= ~(LACP_STATE_COLLECTING | LACP_STATE_DISTRIBUTING);
+   }
+
+   //Any change to report to the partner?
+   if(state != port->actorState)
+   {
+      //Debug message
+      TRACE_INFO("LACP port %s: actor state 0x%02" PRIX8 "\r\n",
+         port->interface->name, state);
+
+      //Save the new state
+      port->actorState = state;
+      port->ntt = TRUE;
+   }
+
+   //Frames can be exchanged on the port when it is distributing
+   port->distributing = (state & LACP_STATE_DISTRIBUTING) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Send a LACPDU
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] port Member port on which to send the LACPDU
+ * @return Error code
+ **/
+
+error_t lacpSendPdu(LagContext *context, LagPort *port)
+{
+   error_t error;
+   size_t offset;
+   NetBuffer *buffer;
+   LacpPdu *pdu;
+   NetTxAncillary ancillary;
+
+   //The LACPDU is about to be sent
+   port->ntt = FALSE;
+
+   //Allocate a memory buffer to hold the LACPDU
+   buffer = ethAllocBuffer(sizeof(LacpPdu), &offset);
+   //Failed to allocate buffer?
+   if(buffer == NULL)
+      return ERROR_OUT_OF_MEMORY;
+
+   //Point to the LACPDU
+   pdu = netBufferAt(buffer, offset, 0);
+   //Reserved fields must be set to zero
+   osMemset(pdu, 0, sizeof(LacpPdu));
+
+   //Format LACPDU header
+   pdu->subtype = LACP_SUBTYPE_LACP;
+   pdu->version = LACP_VERSION;
+
+   //Actor information
+   pdu->actor.type = LACP_TLV_TYPE_ACTOR_INFO;
+   pdu->actor.length = LACP_INFO_TLV_LEN;
+   pdu->actor.systemPriority = htons(context->systemPriority);
+   pdu->actor.system = context->interface->macAddr;
+   pdu->actor.key = htons(context->key);
+   pdu->actor.portPriority = HTONS(LAG_PORT_PRIORITY);
+   pdu->actor.port = htons(port->portNumber);
+   pdu->actor.state = port->actorState;
+
+   //Partner information
+   pdu->partner.type = LACP_TLV_TYPE_PARTNER_INFO;
+   pdu->partner.length = LACP_INFO_TLV_LEN;
+   pdu->partner.systemPriority = htons(port->partner.systemPriority);
+   pdu->partner.system = port->partner.systemId;
+   pdu->partner.key = htons(port->partner.key);
+   pdu->partner.portPriority = htons(port->partner.portPriority);
+   pdu->partner.port = htons(port->partner.portNumber);
+   pdu->partner.state = port->partner.state;
+
+   //Collector information
+   pdu->collectorType = LACP_TLV_TYPE_COLLECTOR_INFO;
+   pdu->collectorLength = LACP_COLLECTOR_TLV_LEN;
+   pdu->collectorMaxDelay = HTONS(0);
+
+   //Terminator
+   pdu->terminatorType = LACP_TLV_TYPE_TERMINATOR;
+   pdu->terminatorLength = 0;
+
+   //Debug message
+   TRACE_DEBUG("Sending LACPDU on %s (actor state 0x%02" PRIX8 ")...\r\n",
+      port->interface->name, port->actorState);
+
+   //Additional options can be passed to the stack along with the packet
+   ancillary = NET_DEFAULT_TX_ANCILLARY;
+
+   //Send LACPDU
+   error = ethSendFrame(port->interface, &LACP_MULTICAST_ADDR, ETH_TYPE_SLOW,
+      buffer, offset, &ancillary);
+
+   //Free previously allocated memory
+   netBufferFree(buffer);
+
+   //Return status code
+   return error;
+}
+
+#endif
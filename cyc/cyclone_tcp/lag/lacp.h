@@ -0,0 +1,210 @@
+/**
+ * @file lacp.h
+ * @brief LACP (Link Aggregation Control Protocol)
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+#ifndef _LACP_H
+#define _LACP_H
+
+//Dependencies
+#include "core/net.h"
+#include "lag/lag.h"
+
+//Periodic transmission intervals
+#define LACP_FAST_PERIODIC_TIME 1000
+#define LACP_SLOW_PERIODIC_TIME 30000
+//Partner information timeouts
+#define LACP_SHORT_TIMEOUT_TIME 3000
+#define LACP_LONG_TIMEOUT_TIME 90000
+
+//LACP version
+#define LACP_VERSION 1
+//Slow protocols subtypes
+#define LACP_SUBTYPE_LACP 1
+#define LACP_SUBTYPE_MARKER 2
+
+//LACPDU TLV lengths
+#define LACP_INFO_TLV_LEN 20
+#define LACP_COLLECTOR_TLV_LEN 16
+#define LACP_MARKER_INFO_TLV_LEN 16
+
+//C++ guard
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief LACPDU TLV types
+ **/
+
+typedef enum
+{
+   LACP_TLV_TYPE_TERMINATOR = 0,
+   LACP_TLV_TYPE_ACTOR_INFO = 1,
+   LACP_TLV_TYPE_PARTNER_INFO = 2,
+   LACP_TLV_TYPE_COLLECTOR_INFO = 3
+} LacpTlvType;
+
+
+/**
+ * @brief Marker PDU TLV types
+ **/
+
+typedef enum
+{
+   LACP_MARKER_TLV_TYPE_INFO = 1,
+   LACP_MARKER_TLV_TYPE_RESPONSE = 2
+} LacpMarkerTlvType;
+
+
+/**
+ * @brief Port state flags
+ **/
+
+typedef enum
+{
+   LACP_STATE_ACTIVITY        = 0x01,
+   LACP_STATE_TIMEOUT         = 0x02,
+   LACP_STATE_AGGREGATION     = 0x04,
+   LACP_STATE_SYNCHRONIZATION = 0x08,
+   LACP_STATE_COLLECTING      = 0x10,
+   LACP_STATE_DISTRIBUTING    = 0x20,
+   LACP_STATE_DEFAULTED       = 0x40,
+   LACP_STATE_EXPIRED         = 0x80
+} LacpState;
+
+
+//CC-RX, CodeWarrior or Win32 compiler?
+#if defined(__CCRX__)
+   #pragma pack
+#elif defined(__CWCC__) || defined(_WIN32)
+   #pragma pack(push, 1)
+#endif
+
+
+/**
+ * @brief Actor/partner information TLV
+ **/
+
+typedef __packed_struct
+{
+   uint8_t type;            //0
+   uint8_t length;          //1
+   uint16_t systemPriority; //2-3
+   MacAddr system;          //4-9
+   uint16_t key;            //10-11
+   uint16_t portPriority;   //12-13
+   uint16_t port;           //14-15
+   uint8_t state;           //16
+   uint8_t reserved[3];     //17-19
+} LacpInfoTlv;
+
+
+/**
+ * @brief LACPDU
+ **/
+
+typedef __packed_struct
+{
+   uint8_t subtype;             //0
+   uint8_t version;             //1
+   LacpInfoTlv actor;           //2-21
+   LacpInfoTlv partner;         //22-41
+   uint8_t collectorType;       //42
+   uint8_t collectorLength;     //43
+   uint16_t collectorMaxDelay;  //44-45
+   uint8_t reserved1[12];       //46-57
+   uint8_t terminatorType;      //58
+   uint8_t terminatorLength;    //59
+   uint8_t reserved2[50];       //60-109
+} LacpPdu;
+
+
+/**
+ * @brief Marker PDU
+ **/
+
+typedef __packed_struct
+{
+   uint8_t subtype;            //0
+   uint8_t version;            //1
+   uint8_t type;               //2
+   uint8_t length;             //3
+   uint16_t requesterPort;     //4-5
+   MacAddr requesterSystem;    //6-11
+   uint32_t requesterTransId;  //12-15
+   uint8_t pad[2];             //16-17
+   uint8_t terminatorType;     //18
+   uint8_t terminatorLength;   //19
+   uint8_t reserved[90];       //20-109
+} LacpMarkerPdu;
+
+
+//CC-RX, CodeWarrior or Win32 compiler?
+#if defined(__CCRX__)
+   #pragma unpack
+#elif defined(__CWCC__) || defined(_WIN32)
+   #pragma pack(pop)
+#endif
+
+
+//Slow protocols multicast address
+extern const MacAddr LACP_MULTICAST_ADDR;
+
+//LACP related functions
+void lacpInitPort(LagContext *context, LagPort *port);
+void lacpResetPort(LagContext *context, LagPort *port);
+void lacpTick(LagContext *context);
+
+void lacpProcessPdu(LagContext *context, LagPort *port, const uint8_t *data,
+   size_t length);
+
+void lacpProcessLacpPdu(LagContext *context, LagPort *port,
+   const LacpPdu *pdu);
+
+void lacpProcessMarkerPdu(LagContext *context, LagPort *port,
+   const LacpMarkerPdu *pdu);
+
+void lacpSelectAggregator(LagContext *context);
+bool_t lacpIsPortEligible(LagContext *context, LagPort *port);
+
+bool_t lacpComparePartner(const LagPortInfo *partner1,
+   const LagPortInfo *partner2);
+
+void lacpUpdateAggregation(LagContext *context);
+void lacpUpdateMux(LagContext *context, LagPort *port);
+
+error_t lacpSendPdu(LagContext *context, LagPort *port);
+
+//C++ guard
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,559 @@
+/**
+ * @file lag.c
+ * @brief Link aggregation (IEEE 802.1AX)
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Several Ethernet interfaces are bundled into a single logical interface,
+ * the aggregator. Outgoing frames are distributed across the member links
+ * according to a flow hash, and frames received by any member are delivered
+ * to the aggregator. Members are either aggregated statically (balance-xor)
+ * or negotiated with the link partner using LACP
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL ETH_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "core/ethernet.h"
+#include "lag/lag.h"
+#include "lag/lag_misc.h"
+#include "lag/lacp.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (ETH_SUPPORT == ENABLED && LAG_SUPPORT == ENABLED)
+
+
+/**
+ * @brief Link aggregation driver
+ **/
+
+const NicDriver lagDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   lagDriverInit,
+   lagDriverTick,
+   lagDriverEnableIrq,
+   lagDriverDisableIrq,
+   lagDriverEventHandler,
+   lagDriverSendPacket,
+   lagDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Initialize settings with default values
+ * @param[out] settings Structure that contains link aggregation settings
+ **/
+
+void lagGetDefaultSettings(LagSettings *settings)
+{
+   //Aggregator interface
+   settings->interface = NULL;
+
+   //Link aggregation mode
+   settings->mode = LAG_MODE_LACP;
+   //Transmit hash policy
+   settings->hashPolicy = LAG_HASH_POLICY_LAYER2_3;
+
+   //Member interfaces
+   settings->numPorts = 0;
+   settings->ports = NULL;
+
+   //LACP parameters
+   settings->systemPriority = LAG_DEFAULT_SYSTEM_PRIORITY;
+   settings->key = LAG_DEFAULT_KEY;
+   settings->fastRate = FALSE;
+}
+
+
+/**
+ * @brief Link aggregation initialization
+ *
+ * The member interfaces must be configured before the aggregator is
+ * initialized. This function binds the aggregator interface to the link
+ * aggregation driver, so the aggregator must be configured afterwards
+ * (refer to netConfigInterface). The member NICs must pad frames and
+ * compute the CRC by themselves
+ *
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] settings Link aggregation specific settings
+ * @return Error code
+ **/
+
+error_t lagInit(LagContext *context, const LagSettings *settings)
+{
+   uint_t i;
+   NetInterface *port;
+
+   //Debug message
+   TRACE_INFO("Initializing link aggregation...\r\n");
+
+   //Ensure the parameters are valid
+   if(context == NULL || settings == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Invalid aggregator interface?
+   if(settings->interface == NULL)
+      return ERROR_INVALID_INTERFACE;
+
+   //Check the number of member interfaces
+   if(settings->numPorts < 1 || settings->numPorts > LAG_MAX_PORTS ||
+      settings->ports == NULL)
+   {
+      return ERROR_INVALID_PARAMETER;
+   }
+
+   //Loop through the member interfaces
+   for(i = 0; i < settings->numPorts; i++)
+   {
+      //Point to the current member
+      port = settings->ports[i];
+
+      //Members are distinct physical interfaces
+      if(port == NULL || port == settings->interface ||
+         port->nicDriver == NULL)
+      {
+         return ERROR_INVALID_INTERFACE;
+      }
+
+      //Only Ethernet controllers can be aggregated
+      if(port->nicDriver->type != NIC_TYPE_ETHERNET)
+         return ERROR_INVALID_INTERFACE;
+
+      //Frames are handed over to the member NICs as they are
+      if(!port->nicDriver->autoPadding || !port->nicDriver->autoCrcCalc)
+         return ERROR_INVALID_INTERFACE;
+   }
+
+   //Clear the link aggregation context
+   osMemset(context, 0, sizeof(LagContext));
+
+   //Initialize link aggregation context
+   context->interface = settings->interface;
+   context->mode = settings->mode;
+   context->hashPolicy = settings->hashPolicy;
+   context->systemPriority = settings->systemPriority;
+   context->key = settings->key;
+   context->fastRate = settings->fastRate;
+   context->numPorts = settings->numPorts;
+
+   //Initialize member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Port numbers start at 1
+      context->ports[i].interface = settings->ports[i];
+      context->ports[i].portNumber = i + 1;
+
+      //Initialize port state
+      lacpInitPort(context, &context->ports[i]);
+
+      //Attach the member interface to the aggregator
+      settings->ports[i]->lagContext = context;
+   }
+
+   //Attach the aggregator interface to the context
+   context->interface->lagContext = context;
+
+   //Select the link aggregation driver
+   return netSetDriver(context->interface, &lagDriver);
+}
+
+
+/**
+ * @brief Start link aggregation
+ * @param[in] context Pointer to the link aggregation context
+ * @return Error code
+ **/
+
+error_t lagStart(LagContext *context)
+{
+   uint_t i;
+   NetInterface *interface;
+
+   //Make sure the link aggregation context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_INFO("Starting link aggregation...\r\n");
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Loop through the member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Point to the member interface
+      interface = context->ports[i].interface;
+
+      //Members must accept the frames destined to the aggregator
+      if(!macCompAddr(&interface->macAddr, &context->interface->macAddr))
+      {
+         ethAcceptMacAddr(interface, &context->interface->macAddr);
+      }
+
+      //LACPDUs are sent to the slow protocols multicast address
+      if(context->mode == LAG_MODE_LACP)
+      {
+         ethAcceptMacAddr(interface, &LACP_MULTICAST_ADDR);
+      }
+   }
+
+   //The aggregator is now running
+   context->running = TRUE;
+
+   //Attach the member ports that are ready to the aggregator
+   if(context->mode == LAG_MODE_LACP)
+   {
+      lacpTick(context);
+   }
+   else
+   {
+      lagUpdatePorts(context);
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Stop link aggregation
+ * @param[in] context Pointer to the link aggregation context
+ * @return Error code
+ **/
+
+error_t lagStop(LagContext *context)
+{
+   uint_t i;
+   NetInterface *interface;
+
+   //Make sure the link aggregation context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Debug message
+   TRACE_INFO("Stopping link aggregation...\r\n");
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Check whether the aggregator is running
+   if(context->running)
+   {
+      //Loop through the member ports
+      for(i = 0; i < context->numPorts; i++)
+      {
+         //Point to the member interface
+         interface = context->ports[i].interface;
+
+         //Remove the MAC addresses added by lagStart
+         if(!macCompAddr(&interface->macAddr, &context->interface->macAddr))
+         {
+            ethDropMacAddr(interface, &context->interface->macAddr);
+         }
+
+         if(context->mode == LAG_MODE_LACP)
+         {
+            ethDropMacAddr(interface, &LACP_MULTICAST_ADDR);
+         }
+
+         //Detach the port from the aggregator
+         lacpInitPort(context, &context->ports[i]);
+      }
+
+      //The aggregator is no longer running
+      context->running = FALSE;
+
+      //The link of the aggregator goes down
+      lagUpdateActivePorts(context);
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Process a frame received by a member interface
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] interface Member interface on which the frame was received
+ * @param[in] frame Incoming Ethernet frame to process
+ * @param[in] length Total frame length
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ **/
+
+void lagProcessFrame(LagContext *context, NetInterface *interface,
+   uint8_t *frame, size_t length, NetRxAncillary *ancillary)
+{
+   LagPort *port;
+   EthHeader *header;
+
+   //Retrieve the member port
+   port = lagGetPort(context, interface);
+
+   //Discard frames received while the aggregator is not operational
+   if(port == NULL || !context->running || !context->interface->configured)
+      return;
+
+   //Point to the Ethernet header
+   header = (EthHeader *) frame;
+
+   //Slow protocols frame?
+   if(header->type == HTONS(ETH_TYPE_SLOW))
+   {
+      //LACPDUs are only processed when LACP is enabled
+      if(context->mode == LAG_MODE_LACP &&
+         macCompAddr(&header->destAddr, &LACP_MULTICAST_ADDR))
+      {
+         lacpProcessPdu(context, port, header->data,
+            length - sizeof(EthHeader));
+      }
+   }
+   else
+   {
+      //Frames received on a port that does not collect are discarded
+      if(port->distributing)
+      {
+         //Deliver the frame to the aggregator
+         ethProcessFrame(context->interface, frame, length, ancillary);
+      }
+   }
+}
+
+
+/**
+ * @brief Aggregator initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t lagDriverInit(NetInterface *interface)
+{
+   //The aggregator must be initialized by lagInit first
+   if(interface->lagContext == NULL)
+      return ERROR_INVALID_INTERFACE;
+
+   //The aggregator is always ready to send (frames are queued by the
+   //member interfaces)
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Aggregator timer handler
+ *
+ * This routine is periodically called by the TCP/IP stack to run LACP and
+ * track the link state of the member interfaces
+ *
+ * @param[in] interface Underlying network interface
+ **/
+
+void lagDriverTick(NetInterface *interface)
+{
+   LagContext *context;
+
+   //Point to the link aggregation context
+   context = interface->lagContext;
+
+   //Check whether the aggregator is running
+   if(context != NULL && context->running)
+   {
+      //Dynamic aggregation?
+      if(context->mode == LAG_MODE_LACP)
+      {
+         //Run LACP
+         lacpTick(context);
+      }
+      else
+      {
+         //Follow the link state of the members
+         lagUpdatePorts(context);
+      }
+   }
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void lagDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void lagDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Aggregator event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void lagDriverEventHandler(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The member link is selected by hashing the flow the frame belongs to
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t lagDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   error_t error;
+   uint32_t hash;
+   LagContext *context;
+   LagPort *port;
+
+   //Point to the link aggregation context
+   context = interface->lagContext;
+
+   //Check whether a member link is available
+   if(context != NULL && context->numActivePorts > 0)
+   {
+      //Compute the flow hash
+      hash = lagComputeFlowHash(context, buffer, offset);
+      //Select the member link
+      port = context->activePorts[hash % context->numActivePorts];
+
+      //Send the frame through the member interface
+      error = nicSendPacket(port->interface, buffer, offset, ancillary);
+   }
+   else
+   {
+      //No member link is up
+      error = ERROR_LINK_DOWN;
+   }
+
+   //The aggregator is ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ *
+ * Changes to the MAC filter table of the aggregator are replicated to the
+ * member interfaces
+ *
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t lagDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   uint_t i;
+   uint_t j;
+   LagContext *context;
+   MacFilterEntry *entry;
+
+   //Point to the link aggregation context
+   context = interface->lagContext;
+
+   //Make sure the aggregator has been initialized
+   if(context == NULL)
+      return NO_ERROR;
+
+   //Go through the MAC filter table
+   for(i = 0; i < MAC_ADDR_FILTER_SIZE; i++)
+   {
+      //Point to the current entry
+      entry = &interface->macAddrFilter[i];
+
+      //Loop through the member interfaces
+      for(j = 0; j < context->numPorts; j++)
+      {
+         //New entry?
+         if(entry->addFlag)
+         {
+            ethAcceptMacAddr(context->ports[j].interface, &entry->addr);
+         }
+         //Entry being removed?
+         else if(entry->deleteFlag)
+         {
+            ethDropMacAddr(context->ports[j].interface, &entry->addr);
+         }
+         else
+         {
+            //The members already track this entry
+         }
+      }
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+#endif
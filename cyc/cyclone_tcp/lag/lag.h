@@ -0,0 +1,202 @@
+/**
+ * @file lag.h
+ * @brief Link aggregation (IEEE 802.1AX)
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+#ifndef _LAG_H
+#define _LAG_H
+
+//Dependencies
+#include "core/net.h"
+
+//Link aggregation support
+#ifndef LAG_SUPPORT
+   #define LAG_SUPPORT DISABLED
+#elif (LAG_SUPPORT != ENABLED && LAG_SUPPORT != DISABLED)
+   #error LAG_SUPPORT parameter is not valid
+#endif
+
+//Maximum number of member interfaces per aggregator
+#ifndef LAG_MAX_PORTS
+   #define LAG_MAX_PORTS 4
+#elif (LAG_MAX_PORTS < 1 || LAG_MAX_PORTS > 255)
+   #error LAG_MAX_PORTS parameter is not valid
+#endif
+
+//Default system priority
+#ifndef LAG_DEFAULT_SYSTEM_PRIORITY
+   #define LAG_DEFAULT_SYSTEM_PRIORITY 32768
+#elif (LAG_DEFAULT_SYSTEM_PRIORITY < 0 || LAG_DEFAULT_SYSTEM_PRIORITY > 65535)
+   #error LAG_DEFAULT_SYSTEM_PRIORITY parameter is not valid
+#endif
+
+//Port priority advertised in LACPDUs
+#ifndef LAG_PORT_PRIORITY
+   #define LAG_PORT_PRIORITY 255
+#elif (LAG_PORT_PRIORITY < 0 || LAG_PORT_PRIORITY > 65535)
+   #error LAG_PORT_PRIORITY parameter is not valid
+#endif
+
+//Default aggregation key
+#ifndef LAG_DEFAULT_KEY
+   #define LAG_DEFAULT_KEY 1
+#elif (LAG_DEFAULT_KEY < 1 || LAG_DEFAULT_KEY > 65535)
+   #error LAG_DEFAULT_KEY parameter is not valid
+#endif
+
+//C++ guard
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/**
+ * @brief Link aggregation modes
+ **/
+
+typedef enum
+{
+   LAG_MODE_BALANCE_XOR = 0, ///<Static aggregation of all the links that are up
+   LAG_MODE_LACP        = 1  ///<Dynamic aggregation negotiated with LACP
+} LagMode;
+
+
+/**
+ * @brief Transmit hash policies
+ **/
+
+typedef enum
+{
+   LAG_HASH_POLICY_LAYER2   = 0, ///<MAC addresses
+   LAG_HASH_POLICY_LAYER2_3 = 1, ///<MAC and IP addresses
+   LAG_HASH_POLICY_LAYER3_4 = 2  ///<IP addresses and transport ports
+} LagHashPolicy;
+
+
+/**
+ * @brief LACP actor/partner information
+ **/
+
+typedef struct
+{
+   uint16_t systemPriority; ///<System priority
+   MacAddr systemId;        ///<System identifier
+   uint16_t key;            ///<Operational key
+   uint16_t portPriority;   ///<Port priority
+   uint16_t portNumber;     ///<Port number
+   uint8_t state;           ///<Port state
+} LagPortInfo;
+
+
+/**
+ * @brief Member port
+ **/
+
+typedef struct
+{
+   NetInterface *interface;    ///<Underlying network interface
+   uint16_t portNumber;        ///<Port number
+   uint8_t actorState;         ///<Actor state
+   LagPortInfo partner;        ///<Partner information, as received in the last LACPDU
+   bool_t selected;            ///<The port is attached to the aggregator
+   bool_t distributing;        ///<The port collects and distributes frames
+   bool_t ntt;                 ///<Need to transmit a LACPDU
+   NetTimer currentWhileTimer; ///<Expiry of the partner information
+   NetTimer periodicTimer;     ///<Periodic transmission of LACPDUs
+} LagPort;
+
+
+/**
+ * @brief Link aggregation settings
+ **/
+
+typedef struct
+{
+   NetInterface *interface;   ///<Aggregator interface
+   LagMode mode;              ///<Link aggregation mode
+   LagHashPolicy hashPolicy;  ///<Transmit hash policy
+   uint_t numPorts;           ///<Number of member interfaces
+   NetInterface **ports;      ///<Member interfaces
+   uint16_t systemPriority;   ///<LACP system priority
+   uint16_t key;              ///<LACP aggregation key
+   bool_t fastRate;           ///<Ask the partner to send LACPDUs every second
+} LagSettings;
+
+
+/**
+ * @brief Link aggregation context
+ **/
+
+typedef struct _LagContext
+{
+   bool_t running;                       ///<The aggregator is operational
+   NetInterface *interface;              ///<Aggregator interface
+   LagMode mode;                         ///<Link aggregation mode
+   LagHashPolicy hashPolicy;             ///<Transmit hash policy
+   uint16_t systemPriority;              ///<LACP system priority
+   uint16_t key;                         ///<LACP aggregation key
+   bool_t fastRate;                      ///<Ask the partner to send LACPDUs every second
+   uint_t numPorts;                      ///<Number of member interfaces
+   LagPort ports[LAG_MAX_PORTS];         ///<Member ports
+   uint_t numActivePorts;                ///<Number of distributing ports
+   LagPort *activePorts[LAG_MAX_PORTS];  ///<Distributing ports
+   bool_t partnerValid;                  ///<The aggregator is attached to a partner system
+   LagPortInfo partner;                  ///<Partner system the aggregator is attached to
+} LagContext;
+
+
+//Link aggregation driver
+extern const NicDriver lagDriver;
+
+//Link aggregation related functions
+void lagGetDefaultSettings(LagSettings *settings);
+error_t lagInit(LagContext *context, const LagSettings *settings);
+
+error_t lagStart(LagContext *context);
+error_t lagStop(LagContext *context);
+
+void lagProcessFrame(LagContext *context, NetInterface *interface,
+   uint8_t *frame, size_t length, NetRxAncillary *ancillary);
+
+error_t lagDriverInit(NetInterface *interface);
+void lagDriverTick(NetInterface *interface);
+void lagDriverEnableIrq(NetInterface *interface);
+void lagDriverDisableIrq(NetInterface *interface);
+void lagDriverEventHandler(NetInterface *interface);
+
+error_t lagDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t lagDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//C++ guard
+#ifdef __cplusplus
+}
+#endif
+
+#endif
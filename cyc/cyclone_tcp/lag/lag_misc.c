@@ -0,0 +1,328 @@
+/**
+ * @file lag_misc.c
+ * @brief Helper functions for link aggregation
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Switch to the appropriate trace level
+#define TRACE_LEVEL ETH_TRACE_LEVEL
+
+//Dependencies
+#include "core/net.h"
+#include "core/ethernet.h"
+#include "ipv4/ipv4.h"
+#include "ipv6/ipv6.h"
+#include "lag/lag.h"
+#include "lag/lag_misc.h"
+#include "debug.h"
+
+//Check TCP/IP stack configuration
+#if (ETH_SUPPORT == ENABLED && LAG_SUPPORT == ENABLED)
+
+
+/**
+ * @brief Retrieve the member port matching a given interface
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] interface Member interface
+ * @return Pointer to the matching port, if any
+ **/
+
+LagPort *lagGetPort(LagContext *context, NetInterface *interface)
+{
+   uint_t i;
+
+   //Loop through the member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Matching interface?
+      if(context->ports[i].interface == interface)
+      {
+         return &context->ports[i];
+      }
+   }
+
+   //The interface is not a member of the aggregator
+   return NULL;
+}
+
+
+/**
+ * @brief Update the state of the member ports (static aggregation)
+ *
+ * When LACP is not used, every member interface whose link is up collects
+ * and distributes frames
+ *
+ * @param[in] context Pointer to the link aggregation context
+ **/
+
+void lagUpdatePorts(LagContext *context)
+{
+   uint_t i;
+   LagPort *port;
+
+   //Loop through the member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Point to the current port
+      port = &context->ports[i];
+
+      //Follow the link state of the member interface
+      port->selected = context->running && port->interface->linkState;
+      port->distributing = port->selected;
+   }
+
+   //Rebuild the set of distributing ports
+   lagUpdateActivePorts(context);
+}
+
+
+/**
+ * @brief Rebuild the set of distributing ports
+ *
+ * The link state of the aggregator reflects the state of its members. The
+ * link is up as long as one member distributes frames, and the link speed
+ * is the sum of the speeds of the distributing members
+ *
+ * @param[in] context Pointer to the link aggregation context
+ **/
+
+void lagUpdateActivePorts(LagContext *context)
+{
+   uint_t i;
+   uint_t n;
+   uint32_t linkSpeed;
+   bool_t linkState;
+   LagPort *port;
+   NetInterface *interface;
+
+   //Point to the aggregator interface
+   interface = context->interface;
+
+   //Initialize variables
+   n = 0;
+   linkSpeed = 0;
+
+   //Loop through the member ports
+   for(i = 0; i < context->numPorts; i++)
+   {
+      //Point to the current port
+      port = &context->ports[i];
+
+      //Check whether the port distributes frames
+      if(port->distributing)
+      {
+         //Add the port to the set of distributing ports
+         context->activePorts[n++] = port;
+         //Aggregate the bandwidth of the members
+         linkSpeed += port->interface->linkSpeed;
+      }
+   }
+
+   //Save the number of distributing ports
+   context->numActivePorts = n;
+
+   //The aggregator is up as long as one member distributes frames
+   linkState = (n > 0) ? TRUE : FALSE;
+
+   //Any change to report?
+   if(interface->linkState != linkState || interface->linkSpeed != linkSpeed)
+   {
+      //Debug message
+      TRACE_INFO("Link aggregation %s: %u active port(s)\r\n",
+         interface->name, n);
+
+      //Update the link state of the aggregator
+      interface->linkState = linkState;
+      interface->linkSpeed = linkSpeed;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Compute the flow hash of an outgoing frame
+ *
+ * All the frames of a given conversation are mapped to the same member so
+ * that they are never reordered
+ *
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] buffer Multi-part buffer containing the frame
+ * @param[in] offset Offset to the Ethernet header
+ * @return Hash value
+ **/
+
+uint32_t lagComputeFlowHash(LagContext *context, const NetBuffer *buffer,
+   size_t offset)
+{
+   size_t n;
+   uint32_t hash;
+   uint16_t type;
+   uint8_t protocol;
+   uint8_t temp[40];
+   EthHeader *ethHeader;
+
+   //Initialize hash value
+   hash = 0;
+   //Unknown upper-layer protocol
+   protocol = 0;
+
+   //Read the Ethernet header
+   n = netBufferRead(temp, buffer, offset, sizeof(EthHeader));
+   //Malformed frame?
+   if(n < sizeof(EthHeader))
+      return hash;
+
+   //Point to the Ethernet header
+   ethHeader = (EthHeader *) temp;
+   //Retrieve the value of the EtherType field
+   type = ntohs(ethHeader->type);
+
+   //Hash the MAC addresses (the first 12 bytes of the header)
+   if(context->hashPolicy != LAG_HASH_POLICY_LAYER3_4)
+   {
+      hash = LOAD32BE(temp) ^ LOAD32BE(temp + 4) ^ LOAD32BE(temp + 8);
+   }
+
+   //Layer 2 policy?
+   if(context->hashPolicy == LAG_HASH_POLICY_LAYER2)
+      return hash ^ type;
+
+   //Point to the network layer header
+   offset += sizeof(EthHeader);
+
+   //Frames sent on a VLAN carry an 802.1Q tag in front of the payload
+   if(type == ETH_TYPE_VLAN)
+   {
+      //Read the VLAN tag
+      n = netBufferRead(temp, buffer, offset, sizeof(VlanTag));
+
+      //Valid VLAN tag?
+      if(n >= sizeof(VlanTag))
+      {
+         //The EtherType of the payload follows the tag
+         type = ntohs(((VlanTag *) temp)->type);
+         //Point to the network layer header
+         offset += sizeof(VlanTag);
+      }
+   }
+
+#if (IPV4_SUPPORT == ENABLED)
+   //IPv4 packet?
+   if(type == ETH_TYPE_IPV4)
+   {
+      Ipv4Header *ipv4Header;
+
+      //Read the IPv4 header
+      n = netBufferRead(temp, buffer, offset, sizeof(Ipv4Header));
+
+      //Valid IPv4 header?
+      if(n >= sizeof(Ipv4Header))
+      {
+         //Point to the IPv4 header
+         ipv4Header = (Ipv4Header *) temp;
+
+         //Hash the source and destination addresses
+         hash ^= ntohl(ipv4Header->srcAddr ^ ipv4Header->destAddr);
+
+         //Transport ports are only hashed for unfragmented packets, so
+         //that all the fragments of a datagram use the same member
+         if((ntohs(ipv4Header->fragmentOffset) & (IPV4_FLAG_MF |
+            IPV4_OFFSET_MASK)) == 0)
+         {
+            protocol = ipv4Header->protocol;
+         }
+
+         //Point to the transport layer header
+         offset += ipv4Header->headerLength * 4;
+      }
+   }
+   else
+#endif
+#if (IPV6_SUPPORT == ENABLED)
+   //IPv6 packet?
+   if(type == ETH_TYPE_IPV6)
+   {
+      Ipv6Header *ipv6Header;
+
+      //Read the IPv6 header
+      n = netBufferRead(temp, buffer, offset, sizeof(Ipv6Header));
+
+      //Valid IPv6 header?
+      if(n >= sizeof(Ipv6Header))
+      {
+         //Point to the IPv6 header
+         ipv6Header = (Ipv6Header *) temp;
+
+         //Hash the low-order 32 bits of the source and destination addresses
+         hash ^= ntohl(ipv6Header->srcAddr.dw[3] ^ ipv6Header->destAddr.dw[3]);
+
+         //Extension headers are not parsed. Fragmented packets carry a
+         //Fragment header, so their ports are never hashed
+         protocol = ipv6Header->nextHeader;
+
+         //Point to the transport layer header
+         offset += sizeof(Ipv6Header);
+      }
+   }
+   else
+#endif
+   //Unknown network protocol?
+   {
+      //Fall back to the EtherType
+      hash ^= type;
+   }
+
+   //Layer 3+4 policy?
+   if(context->hashPolicy == LAG_HASH_POLICY_LAYER3_4)
+   {
+      //TCP and UDP ports are located in the first 4 bytes of the header
+      //(IPv6 uses the same protocol numbers as IPv4)
+      if(protocol == IPV4_PROTOCOL_TCP || protocol == IPV4_PROTOCOL_UDP)
+      {
+         //Read the source and destination ports
+         n = netBufferRead(temp, buffer, offset, sizeof(uint32_t));
+
+         //Hash the ports
+         if(n >= sizeof(uint32_t))
+         {
+            hash ^= LOAD32BE(temp);
+         }
+      }
+   }
+
+   //Mix the bits so that the low-order bits depend on the whole hash
+   hash ^= hash >> 16;
+   hash ^= hash >> 8;
+
+   //Return hash value
+   return hash;
+}
+
+#endif
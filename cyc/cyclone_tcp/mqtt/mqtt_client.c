@@ -265,6 +265,31 @@ error_t mqttClientSetKeepAlive(MqttClientContext *context, uint16_t keepAlive)
 }
 
 
+/**
+ * @brief Enable TCP Fast Open
+ *
+ * When enabled, the CONNECT packet is carried by the SYN segment if a TFO
+ * cookie has been received from the server beforehand
+ *
+ * @param[in] context Pointer to the MQTT client context
+ * @param[in] enabled Specifies whether TCP Fast Open is enabled
+ * @return Error code
+ **/
+
+error_t mqttClientSetFastOpen(MqttClientContext *context, bool_t enabled)
+{
+   //Make sure the MQTT client context is valid
+   if(context == NULL)
+      return ERROR_INVALID_PARAMETER;
+
+   //Save parameter
+   context->settings.fastOpen = enabled;
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
 /**
  * @brief Set the domain name of the server (for virtual hosting)
  * @param[in] context Pointer to the MQTT client context
@@ -301,6 +301,7 @@ typedef struct
    MqttTransportProtocol transportProtocol;           ///<Transport protocol
    uint16_t keepAlive;                                ///<Keep-alive time interval
    systime_t timeout;                                 ///<Communication timeout
+   bool_t fastOpen;                                   ///<TCP Fast Open
 #if (MQTT_CLIENT_WS_SUPPORT == ENABLED)
    char_t host[MQTT_CLIENT_MAX_HOST_LEN + 1];         ///<Domain name of the server (for virtual hosting)
    char_t uri[MQTT_CLIENT_MAX_URI_LEN + 1];           ///<Resource name
@@ -367,6 +368,7 @@ error_t mqttClientRegisterPublishCallback(MqttClientContext *context,
 
 error_t mqttClientSetTimeout(MqttClientContext *context, systime_t timeout);
 error_t mqttClientSetKeepAlive(MqttClientContext *context, uint16_t keepAlive);
+error_t mqttClientSetFastOpen(MqttClientContext *context, bool_t enabled);
 
 error_t mqttClientSetHost(MqttClientContext *context, const char_t *host);
 error_t mqttClientSetUri(MqttClientContext *context, const char_t *uri);
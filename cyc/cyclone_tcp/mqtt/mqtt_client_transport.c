@@ -248,6 +248,13 @@ error_t mqttClientEstablishConnection(MqttClientContext *context,
       //Set timeout
       error = socketSetTimeout(context->socket, context->settings.timeout);
 
+      //Check status code
+      if(!error && context->settings.fastOpen)
+      {
+         //Defer the SYN until the CONNECT packet is sent
+         error = socketEnableTcpFastOpen(context->socket, TRUE);
+      }
+
       //Check status code
       if(!error)
       {
@@ -262,6 +269,13 @@ error_t mqttClientEstablishConnection(MqttClientContext *context,
       //Set timeout
       error = socketSetTimeout(context->socket, context->settings.timeout);
 
+      //Check status code
+      if(!error && context->settings.fastOpen)
+      {
+         //Defer the SYN until the CONNECT packet is sent
+         error = socketEnableTcpFastOpen(context->socket, TRUE);
+      }
+
       //Check status code
       if(!error)
       {
@@ -478,6 +478,11 @@ struct _PppContext
 
    uint8_t frame[PPP_MAX_FRAME_SIZE]; ///<Incoming PPP frame
 
+   uint32_t txAccm;                   ///<ACCM the TX escape map is built for
+   uint8_t txEscMap[256];             ///<Characters that must be escaped
+   uint32_t rxAccm;                   ///<ACCM the RX character map is built for
+   uint8_t rxCharMap[256];            ///<Character classes (receive side)
+
    uint8_t txBuffer[PPP_TX_BUFFER_SIZE]; ///<Transmit buffer
    uint_t txBufferLen;
    uint_t txWriteIndex;
@@ -521,6 +526,7 @@ error_t pppSendFrame(NetInterface *interface, NetBuffer *buffer, size_t offset,
 
 size_t pppParseFrameHeader(const uint8_t *frame, size_t length, uint16_t *protocol);
 
+uint16_t pppUpdateFcs(uint16_t fcs, const uint8_t *data, size_t length);
 uint16_t pppCalcFcs(const uint8_t *data, size_t length);
 uint16_t pppCalcFcsEx(const NetBuffer *buffer, size_t offset, size_t length);
 
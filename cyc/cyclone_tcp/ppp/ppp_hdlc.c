@@ -92,6 +92,10 @@ error_t pppHdlcDriverInit(NetInterface *interface)
    context->rxReadIndex = 0;
    context->rxFrameCount = 0;
 
+   //Build the lookup tables used by the HDLC encoder and decoder
+   pppHdlcDriverBuildTxMap(context, PPP_DEFAULT_ACCM);
+   pppHdlcDriverBuildRxMap(context, PPP_DEFAULT_ACCM);
+
    //Initialize UART
    interface->uartDriver->init();
 
@@ -187,8 +191,10 @@ error_t pppHdlcDriverSendPacket(NetInterface *interface,
 {
    uint_t i;
    size_t j;
+   size_t k;
    size_t n;
    uint8_t *p;
+   uint8_t esc[2];
    uint16_t protocol;
    uint32_t accm;
    PppContext *context;
@@ -214,6 +220,12 @@ error_t pppHdlcDriverSendPacket(NetInterface *interface,
       accm = PPP_DEFAULT_ACCM;
    }
 
+   //The escape map must match the ACCM in use
+   if(accm != context->txAccm)
+   {
+      pppHdlcDriverBuildTxMap(context, accm);
+   }
+
    //Send flag
    pppHdlcDriverWriteTxQueue(context, PPP_FLAG_CHAR);
 
@@ -229,31 +241,25 @@ error_t pppHdlcDriverSendPacket(NetInterface *interface,
          n = buffer->chunk[i].length - offset;
 
          //Copy data to TX queue
-         for(j = 0; j < n; j++)
+         for(j = 0; j < n; j = k)
          {
-            if(p[j] < PPP_MASK_CHAR)
+            //Search for the next character that must be escaped
+            for(k = j; k < n && !context->txEscMap[p[k]]; k++)
             {
-               //Check whether the character is flagged
-               if(accm & (1 << p[j]))
-               {
-                  pppHdlcDriverWriteTxQueue(context, PPP_ESC_CHAR);
-                  pppHdlcDriverWriteTxQueue(context, p[j] ^ PPP_MASK_CHAR);
-               }
-               else
-               {
-                  //Enqueue current character
-                  pppHdlcDriverWriteTxQueue(context, p[j]);
-               }
             }
-            else if(p[j] == PPP_ESC_CHAR || p[j] == PPP_FLAG_CHAR)
+
+            //Copy the run of characters that do not need to be escaped
+            if(k > j)
             {
-               pppHdlcDriverWriteTxQueue(context, PPP_ESC_CHAR);
-               pppHdlcDriverWriteTxQueue(context, p[j] ^ PPP_MASK_CHAR);
+               pppHdlcDriverWriteTxQueueBlock(context, p + j, k - j);
             }
-            else
+
+            //Escape the flagged character
+            if(k < n)
             {
-               //Enqueue current character
-               pppHdlcDriverWriteTxQueue(context, p[j]);
+               esc[0] = PPP_ESC_CHAR;
+               esc[1] = p[k++] ^ PPP_MASK_CHAR;
+               pppHdlcDriverWriteTxQueueBlock(context, esc, 2);
             }
          }
 
@@ -293,9 +299,16 @@ error_t pppHdlcDriverSendPacket(NetInterface *interface,
 
 error_t pppHdlcDriverReceivePacket(NetInterface *interface)
 {
+   uint_t i;
+   size_t j;
+   size_t k;
+   size_t m;
    size_t n;
+   size_t length;
    uint8_t c;
+   uint8_t *p;
    bool_t escFlag;
+   bool_t flagFound;
    uint32_t accm;
    PppContext *context;
 
@@ -304,53 +317,102 @@ error_t pppHdlcDriverReceivePacket(NetInterface *interface)
    //Retrieve ACCM
    accm = context->localConfig.accm;
 
+   //The character map must match the ACCM in use
+   if(accm != context->rxAccm)
+   {
+      pppHdlcDriverBuildRxMap(context, accm);
+   }
+
    //Length of the original PPP frame
    n = 0;
+   //Number of characters consumed from the RX queue
+   length = 0;
    //This flag tells whether the next character is escaped
    escFlag = FALSE;
+   //This flag is set when the closing 0x7E flag is found
+   flagFound = FALSE;
+
+   //Point to the first character to be read
+   i = context->rxReadIndex;
 
    //The receiver must reverse the octet stuffing procedure
-   while(n < PPP_MAX_FRAME_SIZE && context->rxBufferLen > 0)
+   while(!flagFound && n < PPP_MAX_FRAME_SIZE && length < context->rxBufferLen)
    {
-      //Read a single character
-      c = pppHdlcDriverReadRxQueue(context);
+      //Process the contiguous part of the circular buffer
+      p = context->rxBuffer + i;
+      m = MIN(context->rxBufferLen - length, PPP_RX_BUFFER_SIZE - i);
 
-      if(c < PPP_MASK_CHAR)
+      //Loop through the characters
+      for(k = 0; !flagFound && n < PPP_MAX_FRAME_SIZE && k < m; )
       {
-         //Check whether the character is flagged
-         if(accm & (1 << c))
+         //Search for the next special character
+         for(j = k; j < m && context->rxCharMap[p[j]] == PPP_HDLC_CHAR_DATA; j++)
+         {
+         }
+
+         //Any regular character?
+         if(j > k)
          {
-            //The extra characters must be removed from the incoming data stream
+            //Character following an escape character?
+            if(escFlag)
+            {
+               //The character is XOR'ed with 0x20
+               context->frame[n++] = p[k++] ^ PPP_MASK_CHAR;
+               escFlag = FALSE;
+            }
+
+            //Copy the run of regular characters
+            j = MIN(j - k, PPP_MAX_FRAME_SIZE - n);
+            osMemcpy(context->frame + n, p + k, j);
+
+            //Advance indexes
+            n += j;
+            k += j;
          }
          else
          {
-            //Copy current character
-            context->frame[n++] = c;
+            //Read current character
+            c = p[k++];
+
+            //Check character class
+            if(context->rxCharMap[c] == PPP_HDLC_CHAR_ESC)
+            {
+               //All occurrences of 0x7D indicate that the next character
+               //is escaped
+               escFlag = TRUE;
+            }
+            else if(context->rxCharMap[c] == PPP_HDLC_CHAR_FLAG)
+            {
+               //0x7E flag found
+               flagFound = TRUE;
+            }
+            else
+            {
+               //The extra characters must be removed from the incoming
+               //data stream
+            }
          }
       }
-      else if(c == PPP_ESC_CHAR)
-      {
-         //All occurrences of 0x7D indicate that the next character is escaped
-         escFlag = TRUE;
-      }
-      else if(c == PPP_FLAG_CHAR)
-      {
-         //0x7E flag found
-         break;
-      }
-      else if(escFlag)
-      {
-         //The character is XOR'ed with 0x20
-         context->frame[n++] = c ^ PPP_MASK_CHAR;
-         escFlag = FALSE;
-      }
-      else
-      {
-         //Copy current character
-         context->frame[n++] = c;
-      }
+
+      //Update the number of characters consumed from the RX queue
+      length += k;
+
+      //Increment index and wrap around if necessary
+      i += k;
+      if(i >= PPP_RX_BUFFER_SIZE)
+         i = 0;
    }
 
+   //Advance read index
+   context->rxReadIndex = i;
+
+   //Enter critical section
+   __disable_irq();
+   //Update the length of the queue
+   context->rxBufferLen -= length;
+   //Exit critical section
+   __enable_irq();
+
    //Check whether a valid PPP frame has been received
    if(n > 0)
    {
@@ -569,6 +631,69 @@ error_t pppHdlcDriverPurgeRxBuffer(PppContext *context)
 }
 
 
+/**
+ * @brief Build the escape map used by the HDLC encoder
+ * @param[in] context Pointer to the PPP context
+ * @param[in] accm Async control character map
+ **/
+
+void pppHdlcDriverBuildTxMap(PppContext *context, uint32_t accm)
+{
+   uint_t i;
+
+   //Control characters are escaped when they are flagged in the ACCM
+   for(i = 0; i < PPP_MASK_CHAR; i++)
+   {
+      context->txEscMap[i] = (accm & (1U << i)) ? TRUE : FALSE;
+   }
+
+   //Other characters are sent as is
+   for(i = PPP_MASK_CHAR; i < 256; i++)
+   {
+      context->txEscMap[i] = FALSE;
+   }
+
+   //The escape and flag characters must always be escaped
+   context->txEscMap[PPP_ESC_CHAR] = TRUE;
+   context->txEscMap[PPP_FLAG_CHAR] = TRUE;
+
+   //Save the ACCM value
+   context->txAccm = accm;
+}
+
+
+/**
+ * @brief Build the character map used by the HDLC decoder
+ * @param[in] context Pointer to the PPP context
+ * @param[in] accm Async control character map
+ **/
+
+void pppHdlcDriverBuildRxMap(PppContext *context, uint32_t accm)
+{
+   uint_t i;
+
+   //Control characters flagged in the ACCM are discarded
+   for(i = 0; i < PPP_MASK_CHAR; i++)
+   {
+      context->rxCharMap[i] = (accm & (1U << i)) ? PPP_HDLC_CHAR_DROP :
+         PPP_HDLC_CHAR_DATA;
+   }
+
+   //Other characters are regular data
+   for(i = PPP_MASK_CHAR; i < 256; i++)
+   {
+      context->rxCharMap[i] = PPP_HDLC_CHAR_DATA;
+   }
+
+   //Escape and flag characters
+   context->rxCharMap[PPP_ESC_CHAR] = PPP_HDLC_CHAR_ESC;
+   context->rxCharMap[PPP_FLAG_CHAR] = PPP_HDLC_CHAR_FLAG;
+
+   //Save the ACCM value
+   context->rxAccm = accm;
+}
+
+
 /**
  * @brief Write TX queue
  * @param[in] context Pointer to the PPP context
@@ -593,6 +718,40 @@ void pppHdlcDriverWriteTxQueue(PppContext *context, uint8_t c)
 }
 
 
+/**
+ * @brief Write a block of data to the TX queue
+ * @param[in] context Pointer to the PPP context
+ * @param[in] data Pointer to the data to be written
+ * @param[in] length Number of bytes to write
+ **/
+
+void pppHdlcDriverWriteTxQueueBlock(PppContext *context, const uint8_t *data,
+   size_t length)
+{
+   size_t n;
+
+   //Number of bytes that can be written before wrapping around
+   n = MIN(length, PPP_TX_BUFFER_SIZE - context->txWriteIndex);
+
+   //Enqueue the data
+   osMemcpy(context->txBuffer + context->txWriteIndex, data, n);
+   osMemcpy(context->txBuffer, data + n, length - n);
+
+   //Increment index and wrap around if necessary
+   context->txWriteIndex += length;
+
+   if(context->txWriteIndex >= PPP_TX_BUFFER_SIZE)
+      context->txWriteIndex -= PPP_TX_BUFFER_SIZE;
+
+   //Enter critical section
+   __disable_irq();
+   //Update the length of the queue
+   context->txBufferLen += length;
+   //Exit critical section
+   __enable_irq();
+}
+
+
 /**
  * @brief Read RX queue
  * @param[in] context Pointer to the PPP context
@@ -716,5 +875,75 @@ bool_t pppHdlcDriverWriteRxQueue(NetInterface *interface, uint8_t c)
    return flag;
 }
 
-#endif
+/**
+ * @brief Write a block of data to the RX queue
+ *
+ * This function is intended for UART drivers that receive data by DMA
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] data Pointer to the received data
+ * @param[in] length Number of bytes received
+ * @return TRUE if a context switch is required
+ **/
+
+bool_t pppHdlcDriverWriteRxQueueBlock(NetInterface *interface,
+   const uint8_t *data, size_t length)
+{
+   size_t n;
+   uint_t count;
+   bool_t flag;
+   const uint8_t *p;
+   PppContext *context;
+
+   //Point to the PPP context
+   context = interface->pppContext;
+   //This flag will be set if a higher priority task must be woken
+   flag = FALSE;
+
+   //Characters that do not fit in the RX queue are discarded
+   length = MIN(length, PPP_RX_BUFFER_SIZE - context->rxBufferLen);
+
+   //Number of bytes that can be written before wrapping around
+   n = MIN(length, PPP_RX_BUFFER_SIZE - context->rxWriteIndex);
+
+   //Enqueue the data
+   osMemcpy(context->rxBuffer + context->rxWriteIndex, data, n);
+   osMemcpy(context->rxBuffer, data + n, length - n);
+
+   //Increment index and wrap around if necessary
+   context->rxWriteIndex += length;
 
+   if(context->rxWriteIndex >= PPP_RX_BUFFER_SIZE)
+      context->rxWriteIndex -= PPP_RX_BUFFER_SIZE;
+
+   //Update the length of the queue
+   context->rxBufferLen += length;
+
+   //Count the 0x7E flags
+   for(count = 0, p = data; p < (data + length); p++, count++)
+   {
+      //Search for the next flag
+      p = osMemchr(p, PPP_FLAG_CHAR, data + length - p);
+
+      //No more flags?
+      if(p == NULL)
+         break;
+   }
+
+   //Complete HDLC frames received?
+   if(count > 0)
+   {
+      //Increment frame counter
+      context->rxFrameCount += count;
+
+      //A complete HDLC frame has been received
+      interface->nicEvent = TRUE;
+      //Notify the TCP/IP stack of the event
+      flag = osSetEventFromIsr(&netEvent);
+   }
+
+   //The return value tells whether a context switch is required
+   return flag;
+}
+
+#endif
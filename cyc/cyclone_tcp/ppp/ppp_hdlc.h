@@ -34,6 +34,12 @@
 //Dependencies
 #include "core/nic.h"
 
+//Character classes used by the HDLC decoder
+#define PPP_HDLC_CHAR_DATA 0
+#define PPP_HDLC_CHAR_DROP 1
+#define PPP_HDLC_CHAR_ESC  2
+#define PPP_HDLC_CHAR_FLAG 3
+
 //C++ guard
 #ifdef __cplusplus
 extern "C" {
@@ -66,12 +72,22 @@ error_t pppHdlcDriverReceiveAtCommand(NetInterface *interface, char_t *data,
 error_t pppHdlcDriverPurgeTxBuffer(PppContext *context);
 error_t pppHdlcDriverPurgeRxBuffer(PppContext *context);
 
+void pppHdlcDriverBuildTxMap(PppContext *context, uint32_t accm);
+void pppHdlcDriverBuildRxMap(PppContext *context, uint32_t accm);
+
 void pppHdlcDriverWriteTxQueue(PppContext *context, uint8_t c);
+
+void pppHdlcDriverWriteTxQueueBlock(PppContext *context, const uint8_t *data,
+   size_t length);
+
 uint8_t pppHdlcDriverReadRxQueue(PppContext *context);
 
 bool_t pppHdlcDriverReadTxQueue(NetInterface *interface, int_t *c);
 bool_t pppHdlcDriverWriteRxQueue(NetInterface *interface, uint8_t c);
 
+bool_t pppHdlcDriverWriteRxQueueBlock(NetInterface *interface,
+   const uint8_t *data, size_t length);
+
 //C++ guard
 #ifdef __cplusplus
 }
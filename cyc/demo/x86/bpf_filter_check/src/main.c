@@ -0,0 +1,1083 @@
+/**
+ * @file main.c
+ * @brief BPF packet filter check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Valid and invalid filter programs are submitted to the verifier. Programs
+ * that pass the verifier are run against packets split across several
+ * chunks, including out-of-bounds loads and divisions by zero. Finally, an
+ * EtherType and UDP port filter is attached to a raw Ethernet socket, and a
+ * payload filter to a raw IP socket, and frames are injected into a virtual
+ * Ethernet interface
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/bpf.h"
+#include "ipv4/arp.h"
+#include "ipv4/icmp.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_PORT 40000
+
+//Check configuration
+#define APP_FILTER_PORT 5000
+#define APP_RAW_PROTOCOL 253
+#define APP_ARP_FIXED_LEN 8
+
+
+/**
+ * @brief Packet split across several chunks
+ **/
+
+typedef struct
+{
+   uint_t chunkCount;
+   uint_t maxChunkCount;
+   ChunkDesc chunk[3];
+} SplitBuffer;
+
+
+/**
+ * @brief Verifier test case
+ **/
+
+typedef struct
+{
+   const char_t *name;
+   const BpfInsn *insns;
+   uint_t count;
+   bool_t valid;
+} VerifierTest;
+
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//IPv4 UDP datagrams sent to port 5000, as compiled by tcpdump for the
+//"ip and udp dst port 5000" expression
+static const BpfInsn udpPortFilter[] =
+{
+   BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+   BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_TYPE_IPV4, 0, 8),
+   BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 23),
+   BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, IPV4_PROTOCOL_UDP, 0, 6),
+   BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 20),
+   BPF_JUMP(BPF_JMP | BPF_JSET | BPF_K, 0x1FFF, 4, 0),
+   BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 14),
+   BPF_STMT(BPF_LD | BPF_H | BPF_IND, 16),
+   BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, APP_FILTER_PORT, 0, 1),
+   BPF_STMT(BPF_RET | BPF_K, 0x40000),
+   BPF_STMT(BPF_RET | BPF_K, 0)
+};
+
+//ARP frames, truncated to the fixed part of the ARP header
+static const BpfInsn arpSnapFilter[] =
+{
+   BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+   BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_TYPE_ARP, 0, 1),
+   BPF_STMT(BPF_RET | BPF_K, sizeof(EthHeader) + APP_ARP_FIXED_LEN),
+   BPF_STMT(BPF_RET | BPF_K, 0)
+};
+
+//Raw IP packets whose first payload byte is 0x42
+static const BpfInsn payloadFilter[] =
+{
+   BPF_STMT(BPF_LD | BPF_B | BPF_ABS, 0),
+   BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0x42, 0, 1),
+   BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+   BPF_STMT(BPF_RET | BPF_K, 0)
+};
+
+//Longest jump allowed
+static const BpfInsn lastJump[] =
+{
+   BPF_STMT(BPF_JMP | BPF_JA, 1),
+   BPF_STMT(BPF_RET | BPF_K, 0),
+   BPF_STMT(BPF_RET | BPF_K, 1)
+};
+
+//Unconditional jump beyond the end of the program
+static const BpfInsn jumpOutOfRange[] =
+{
+   BPF_STMT(BPF_JMP | BPF_JA, 2),
+   BPF_STMT(BPF_RET | BPF_K, 0),
+   BPF_STMT(BPF_RET | BPF_K, 1)
+};
+
+//Conditional jump beyond the end of the program (true branch)
+static const BpfInsn jtOutOfRange[] =
+{
+   BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, 0, 2, 0),
+   BPF_STMT(BPF_RET | BPF_K, 0),
+   BPF_STMT(BPF_RET | BPF_K, 1)
+};
+
+//Conditional jump beyond the end of the program (false branch)
+static const BpfInsn jfOutOfRange[] =
+{
+   BPF_JUMP(BPF_JMP | BPF_JGT | BPF_X, 0, 0, 255),
+   BPF_STMT(BPF_RET | BPF_K, 0)
+};
+
+//Division by a constant zero
+static const BpfInsn divByZero[] =
+{
+   BPF_STMT(BPF_LD | BPF_IMM, 10),
+   BPF_STMT(BPF_ALU | BPF_DIV | BPF_K, 0),
+   BPF_STMT(BPF_RET | BPF_A, 0)
+};
+
+//Modulo by a constant zero
+static const BpfInsn modByZero[] =
+{
+   BPF_STMT(BPF_LD | BPF_IMM, 10),
+   BPF_STMT(BPF_ALU | BPF_MOD | BPF_K, 0),
+   BPF_STMT(BPF_RET | BPF_A, 0)
+};
+
+//The program falls off the end
+static const BpfInsn missingRet[] =
+{
+   BPF_STMT(BPF_LD | BPF_H | BPF_ABS, 12),
+   BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, ETH_TYPE_IPV4, 0, 1),
+   BPF_STMT(BPF_RET | BPF_K, 0xFFFF),
+   BPF_STMT(BPF_LD | BPF_IMM, 0)
+};
+
+//Unknown opcode (reserved operand size)
+static const BpfInsn unknownOpcode[] =
+{
+   BPF_STMT(BPF_LD | 0x18 | BPF_ABS, 0),
+   BPF_STMT(BPF_RET | BPF_K, 0)
+};
+
+//Scratch memory index out of range
+static const BpfInsn memOutOfRange[] =
+{
+   BPF_STMT(BPF_ST, BPF_MEMWORDS),
+   BPF_STMT(BPF_RET | BPF_K, 0)
+};
+
+//Last scratch memory word
+static const BpfInsn lastMemWord[] =
+{
+   BPF_STMT(BPF_LD | BPF_IMM, 7),
+   BPF_STMT(BPF_ST, BPF_MEMWORDS - 1),
+   BPF_STMT(BPF_LDX | BPF_W | BPF_MEM, BPF_MEMWORDS - 1),
+   BPF_STMT(BPF_MISC | BPF_TXA, 0),
+   BPF_STMT(BPF_RET | BPF_A, 0)
+};
+
+//Shift by a constant as wide as the register
+static const BpfInsn shiftOutOfRange[] =
+{
+   BPF_STMT(BPF_ALU | BPF_LSH | BPF_K, 32),
+   BPF_STMT(BPF_RET | BPF_A, 0)
+};
+
+//Verifier test cases
+static const VerifierTest verifierTests[] =
+{
+   {"Verifier: EtherType and UDP port filter accepted", udpPortFilter,
+      arraysize(udpPortFilter), TRUE},
+   {"Verifier: jump to the last instruction accepted", lastJump,
+      arraysize(lastJump), TRUE},
+   {"Verifier: last scratch memory word accepted", lastMemWord,
+      arraysize(lastMemWord), TRUE},
+   {"Verifier: out-of-range jump rejected", jumpOutOfRange,
+      arraysize(jumpOutOfRange), FALSE},
+   {"Verifier: out-of-range true branch rejected", jtOutOfRange,
+      arraysize(jtOutOfRange), FALSE},
+   {"Verifier: out-of-range false branch rejected", jfOutOfRange,
+      arraysize(jfOutOfRange), FALSE},
+   {"Verifier: division by zero rejected", divByZero,
+      arraysize(divByZero), FALSE},
+   {"Verifier: modulo by zero rejected", modByZero,
+      arraysize(modByZero), FALSE},
+   {"Verifier: missing RET rejected", missingRet,
+      arraysize(missingRet), FALSE},
+   {"Verifier: unknown opcode rejected", unknownOpcode,
+      arraysize(unknownOpcode), FALSE},
+   {"Verifier: scratch memory index out of range rejected", memOutOfRange,
+      arraysize(memOutOfRange), FALSE},
+   {"Verifier: 32-bit shift rejected", shiftOutOfRange,
+      arraysize(shiftOutOfRange), FALSE},
+   {"Verifier: empty program rejected", udpPortFilter, 0, FALSE},
+};
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+uint_t protoUnreachableCount;
+uint_t splitMismatchCount;
+uint_t failureCount;
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The ICMP Destination Unreachable (protocol unreachable) messages sent by
+ * the stack are counted
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   IcmpHeader *icmpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   icmpHeader = (IcmpHeader *) ipHeader->options;
+
+   //ICMP Destination Unreachable message?
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header) + sizeof(IcmpHeader)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_ICMP &&
+      icmpHeader->type == ICMP_TYPE_DEST_UNREACHABLE &&
+      icmpHeader->code == ICMP_CODE_PROTOCOL_UNREACHABLE)
+   {
+      protoUnreachableCount++;
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Display the outcome of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Format an IPv4 packet sent by the peer
+ * @param[in] interface Underlying network interface
+ * @param[out] packet Buffer where to format the packet
+ * @param[in] headerLength Length of the IPv4 header, in 32-bit words
+ * @param[in] protocol Upper-layer protocol
+ * @param[in] fragmentOffset Fragment offset field, in host byte order
+ * @param[in] payload Upper-layer data
+ * @param[in] payloadLen Length of the upper-layer data, in bytes
+ * @return Length of the packet, in bytes
+ **/
+
+size_t formatIpv4Packet(NetInterface *interface, uint8_t *packet,
+   uint_t headerLength, uint8_t protocol, uint16_t fragmentOffset,
+   const void *payload, size_t payloadLen)
+{
+   size_t n;
+   Ipv4Header *ipHeader;
+
+   //Point to the IPv4 header
+   ipHeader = (Ipv4Header *) packet;
+   //Length of the IPv4 header, including options
+   n = headerLength * 4;
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = headerLength;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(n + payloadLen);
+   ipHeader->identification = HTONS(1);
+   ipHeader->fragmentOffset = htons(fragmentOffset);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = protocol;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+
+   //Pad the options with NOPs
+   osMemset(ipHeader->options, IPV4_OPTION_NOP, n - sizeof(Ipv4Header));
+
+   //Calculate header checksum
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, n);
+
+   //Copy the upper-layer data
+   osMemcpy(packet + n, payload, payloadLen);
+
+   //Return the length of the packet
+   return n + payloadLen;
+}
+
+
+/**
+ * @brief Format an IPv4 packet carrying a transport header
+ * @param[in] interface Underlying network interface
+ * @param[out] packet Buffer where to format the packet
+ * @param[in] headerLength Length of the IPv4 header, in 32-bit words
+ * @param[in] protocol Upper-layer protocol (UDP or TCP)
+ * @param[in] fragmentOffset Fragment offset field, in host byte order
+ * @param[in] destPort Destination port
+ * @return Length of the packet, in bytes
+ **/
+
+size_t formatTransportPacket(NetInterface *interface, uint8_t *packet,
+   uint_t headerLength, uint8_t protocol, uint16_t fragmentOffset,
+   uint16_t destPort)
+{
+   size_t n;
+   UdpHeader *udpHeader;
+   TcpHeader *tcpHeader;
+   uint8_t buffer[sizeof(TcpHeader) + 8];
+
+   //UDP or TCP?
+   if(protocol == IPV4_PROTOCOL_UDP)
+   {
+      //Format UDP header (the checksum is optional over IPv4)
+      udpHeader = (UdpHeader *) buffer;
+      udpHeader->srcPort = HTONS(APP_PEER_PORT);
+      udpHeader->destPort = htons(destPort);
+      udpHeader->length = HTONS(sizeof(UdpHeader) + 8);
+      udpHeader->checksum = 0;
+      n = sizeof(UdpHeader);
+   }
+   else
+   {
+      //Format TCP header
+      tcpHeader = (TcpHeader *) buffer;
+      osMemset(tcpHeader, 0, sizeof(TcpHeader));
+      tcpHeader->srcPort = HTONS(APP_PEER_PORT);
+      tcpHeader->destPort = htons(destPort);
+      tcpHeader->dataOffset = 5;
+      tcpHeader->flags = TCP_FLAG_ACK;
+      tcpHeader->window = HTONS(65535);
+      n = sizeof(TcpHeader);
+   }
+
+   //Append some data
+   osMemcpy(buffer + n, "bpfcheck", 8);
+
+   //Format IPv4 packet
+   return formatIpv4Packet(interface, packet, headerLength, protocol,
+      fragmentOffset, buffer, n + 8);
+}
+
+
+/**
+ * @brief Inject an Ethernet frame sent by the peer
+ * @param[in] interface Underlying network interface
+ * @param[in] type EtherType value
+ * @param[in] payload Frame payload
+ * @param[in] length Length of the payload, in bytes
+ **/
+
+void injectFrame(NetInterface *interface, uint16_t type, const void *payload,
+   size_t length)
+{
+   EthHeader *ethHeader;
+   NetRxAncillary ancillary;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Format Ethernet header
+   ethHeader = (EthHeader *) frame;
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = htons(type);
+
+   //Copy the payload
+   osMemcpy(ethHeader->data, payload, length);
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   osAcquireMutex(&netMutex);
+   nicProcessPacket(interface, frame, sizeof(EthHeader) + length, &ancillary);
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Retrieve the next packet queued on a raw socket
+ * @param[in] socket Raw socket
+ * @param[out] data Buffer where to store the packet (optional)
+ * @return Length of the packet, 0 if the receive queue is empty
+ **/
+
+size_t receivePacket(Socket *socket, uint8_t *data)
+{
+   error_t error;
+   size_t received;
+   uint8_t buffer[ETH_MAX_FRAME_SIZE];
+
+   //Non-blocking read
+   error = socketReceive(socket, buffer, sizeof(buffer), &received,
+      SOCKET_FLAG_DONT_WAIT);
+
+   //No packet queued?
+   if(error)
+      return 0;
+
+   //Copy the packet, if requested
+   if(data != NULL)
+   {
+      osMemcpy(data, buffer, received);
+   }
+
+   //Return the length of the packet
+   return received;
+}
+
+
+/**
+ * @brief Run a filter program against a packet
+ *
+ * The program is run twice, once over a contiguous buffer and once over a
+ * buffer split in three chunks, and both results must agree
+ *
+ * @param[in] insns Filter program
+ * @param[in] packet Packet to be filtered
+ * @param[in] length Length of the packet, in bytes
+ * @return Value returned by the filter program
+ **/
+
+uint32_t runProgram(const BpfInsn *insns, uint8_t *packet, size_t length)
+{
+   uint32_t n;
+   uint32_t m;
+   SplitBuffer buffer;
+
+   //Contiguous buffer
+   buffer.chunkCount = 1;
+   buffer.maxChunkCount = arraysize(buffer.chunk);
+   buffer.chunk[0].address = packet;
+   buffer.chunk[0].length = (uint16_t) length;
+   buffer.chunk[0].size = 0;
+
+   //Run the program
+   n = bpfRunProgram(insns, (NetBuffer *) &buffer, 0, length);
+
+   //The IPv4 source address and the UDP source port straddle the chunks
+   buffer.chunkCount = 3;
+   buffer.chunk[0].length = 14;
+   buffer.chunk[1].address = packet + 14;
+   buffer.chunk[1].length = 7;
+   buffer.chunk[1].size = 0;
+   buffer.chunk[2].address = packet + 21;
+   buffer.chunk[2].length = (uint16_t) (length - 21);
+   buffer.chunk[2].size = 0;
+
+   //Run the program again
+   m = bpfRunProgram(insns, (NetBuffer *) &buffer, 0, length);
+
+   //Keep track of inconsistent results
+   if(m != n)
+   {
+      splitMismatchCount++;
+   }
+
+   //Return the value returned by the filter program
+   return n;
+}
+
+
+/**
+ * @brief Programs rejected or accepted by the verifier
+ **/
+
+void checkVerifier(void)
+{
+   uint_t i;
+   error_t error;
+
+   //Loop through the test cases
+   for(i = 0; i < arraysize(verifierTests); i++)
+   {
+      //Validate the program
+      error = bpfCheckProgram(verifierTests[i].insns, verifierTests[i].count);
+
+      checkResult(verifierTests[i].name,
+         (error == NO_ERROR) == verifierTests[i].valid);
+   }
+}
+
+
+/**
+ * @brief Run-time behavior of the interpreter
+ * @param[in] interface Underlying network interface
+ **/
+
+void checkInterpreter(NetInterface *interface)
+{
+   size_t length;
+   uint8_t packet[64];
+   BpfInsn load[] =
+   {
+      BPF_STMT(BPF_LD | BPF_W | BPF_ABS, 0),
+      BPF_STMT(BPF_RET | BPF_A, 0)
+   };
+   BpfInsn indOverflow[] =
+   {
+      BPF_STMT(BPF_LDX | BPF_W | BPF_IMM, 0xFFFFFFFF),
+      BPF_STMT(BPF_LD | BPF_B | BPF_IND, 2),
+      BPF_STMT(BPF_RET | BPF_K, 1)
+   };
+   BpfInsn mshLoad[] =
+   {
+      BPF_STMT(BPF_LDX | BPF_B | BPF_MSH, 0),
+      BPF_STMT(BPF_RET | BPF_K, 1)
+   };
+   BpfInsn aluX[] =
+   {
+      BPF_STMT(BPF_LDX | BPF_W | BPF_IMM, 0),
+      BPF_STMT(BPF_LD | BPF_IMM, 10),
+      BPF_STMT(BPF_ALU | BPF_DIV | BPF_X, 0),
+      BPF_STMT(BPF_RET | BPF_A, 0)
+   };
+
+   //IPv4 UDP datagram sent to the filtered port
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT);
+
+   //Word load ending on the last byte of the packet
+   load[0].k = length - 4;
+
+   checkResult("Interpreter: word load at the end of the packet",
+      runProgram(load, packet, length) == LOAD32BE(packet + length - 4));
+
+   //Word load running one byte past the end of the packet
+   load[0].k = length - 3;
+
+   checkResult("Interpreter: out-of-bounds word load rejected",
+      runProgram(load, packet, length) == 0);
+
+   //Word load straddling two chunks (IPv4 source address)
+   load[0].k = 12;
+
+   checkResult("Interpreter: word load across chunks",
+      runProgram(load, packet, length) == LOAD32BE(packet + 12));
+
+   //Half-word load straddling two chunks (UDP source port)
+   load[0].code = BPF_LD | BPF_H | BPF_ABS;
+   load[0].k = 20;
+
+   checkResult("Interpreter: half-word load across chunks",
+      runProgram(load, packet, length) == APP_PEER_PORT);
+
+   checkResult("Interpreter: indirect load offset overflow rejected",
+      runProgram(indOverflow, packet, length) == 0);
+
+   //MSH load one byte past the end of the packet
+   mshLoad[0].k = length;
+
+   checkResult("Interpreter: out-of-bounds MSH load rejected",
+      runProgram(mshLoad, packet, length) == 0);
+
+   checkResult("Interpreter: division by X == 0 rejected",
+      runProgram(aluX, packet, length) == 0);
+
+   //Non-zero divisor
+   aluX[0].k = 3;
+
+   checkResult("Interpreter: division by X", runProgram(aluX, packet,
+      length) == 3);
+
+   //Modulo operation
+   aluX[2].code = BPF_ALU | BPF_MOD | BPF_X;
+
+   checkResult("Interpreter: modulo by X", runProgram(aluX, packet,
+      length) == 1);
+
+   //Null divisor
+   aluX[0].k = 0;
+
+   checkResult("Interpreter: modulo by X == 0 rejected",
+      runProgram(aluX, packet, length) == 0);
+
+   //Shift by a register as wide as the accumulator
+   aluX[0].k = 32;
+   aluX[1].k = 1;
+   aluX[2].code = BPF_ALU | BPF_LSH | BPF_X;
+
+   checkResult("Interpreter: 32-bit shift by X yields zero",
+      runProgram(aluX, packet, length) == 0);
+
+   //Same datagram, preceded by an Ethernet header
+   osMemmove(packet + sizeof(EthHeader), packet, length);
+   osMemset(packet, 0, sizeof(EthHeader));
+   STORE16BE(ETH_TYPE_IPV4, packet + 12);
+   length += sizeof(EthHeader);
+
+   checkResult("Interpreter: UDP port filter matches the frame",
+      runProgram(udpPortFilter, packet, length) == 0x40000);
+
+   checkResult("Interpreter: last scratch memory word",
+      runProgram(lastMemWord, packet, length) == 7);
+
+   checkResult("Interpreter: split and contiguous buffers agree",
+      splitMismatchCount == 0);
+}
+
+
+/**
+ * @brief Filters attached to a raw Ethernet socket
+ * @param[in] interface Underlying network interface
+ **/
+
+void checkRawEth(NetInterface *interface)
+{
+   error_t error;
+   size_t length;
+   size_t n;
+   Socket *socket;
+   ArpPacket arpPacket;
+   Ipv6Header *ipv6Header;
+   uint8_t packet[128];
+
+   //Open a raw socket that receives all EtherType values
+   socket = socketOpen(SOCKET_TYPE_RAW_ETH, SOCKET_ETH_PROTO_ALL);
+
+   //Attach the UDP port filter
+   error = socketAttachFilter(socket, udpPortFilter,
+      arraysize(udpPortFilter));
+
+   checkResult("Raw Ethernet: UDP port filter attached", error == NO_ERROR);
+
+   //UDP datagram sent to the filtered port
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw Ethernet: UDP datagram to port 5000 accepted",
+      receivePacket(socket, NULL) == (sizeof(EthHeader) + length));
+
+   //UDP datagram sent to another port
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT + 1);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw Ethernet: UDP datagram to port 5001 rejected",
+      receivePacket(socket, NULL) == 0);
+
+   //TCP segment sent to the filtered port
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_TCP, 0,
+      APP_FILTER_PORT);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw Ethernet: TCP segment to port 5000 rejected",
+      receivePacket(socket, NULL) == 0);
+
+   //Non-first fragment whose payload looks like a matching UDP header
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 1,
+      APP_FILTER_PORT);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw Ethernet: non-first fragment rejected",
+      receivePacket(socket, NULL) == 0);
+
+   //IPv4 header with options
+   length = formatTransportPacket(interface, packet, 6, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw Ethernet: IPv4 options skipped by the MSH load",
+      receivePacket(socket, NULL) == (sizeof(EthHeader) + length));
+
+   //Datagram truncated in the middle of the UDP header
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, sizeof(Ipv4Header) + 3);
+
+   checkResult("Raw Ethernet: truncated datagram rejected",
+      receivePacket(socket, NULL) == 0);
+
+   //IPv6 packet carrying a UDP datagram sent to the filtered port
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT);
+   osMemmove(packet + sizeof(Ipv6Header), packet + sizeof(Ipv4Header),
+      length - sizeof(Ipv4Header));
+   length += sizeof(Ipv6Header) - sizeof(Ipv4Header);
+
+   ipv6Header = (Ipv6Header *) packet;
+   osMemset(ipv6Header, 0, sizeof(Ipv6Header));
+   ipv6Header->version = IPV6_VERSION;
+   ipv6Header->payloadLen = htons(length - sizeof(Ipv6Header));
+   ipv6Header->nextHeader = IPV6_UDP_HEADER;
+   ipv6Header->hopLimit = 64;
+   injectFrame(interface, ETH_TYPE_IPV6, packet, length);
+
+   checkResult("Raw Ethernet: IPv6 packet rejected",
+      receivePacket(socket, NULL) == 0);
+
+   //ARP request for an address that is not ours
+   arpPacket.hrd = HTONS(ARP_HARDWARE_TYPE_ETH);
+   arpPacket.pro = HTONS(ARP_PROTOCOL_TYPE_IPV4);
+   arpPacket.hln = sizeof(MacAddr);
+   arpPacket.pln = sizeof(Ipv4Addr);
+   arpPacket.op = HTONS(ARP_OPCODE_ARP_REQUEST);
+   arpPacket.sha = peerMacAddr;
+   arpPacket.spa = peerIpAddr;
+   arpPacket.tha = MAC_UNSPECIFIED_ADDR;
+   arpPacket.tpa = IPV4_ADDR(192, 168, 0, 3);
+   injectFrame(interface, ETH_TYPE_ARP, &arpPacket, sizeof(ArpPacket));
+
+   checkResult("Raw Ethernet: ARP packet rejected",
+      receivePacket(socket, NULL) == 0);
+
+   //Replace the filter
+   error = socketAttachFilter(socket, arpSnapFilter,
+      arraysize(arpSnapFilter));
+   injectFrame(interface, ETH_TYPE_ARP, &arpPacket, sizeof(ArpPacket));
+   n = receivePacket(socket, NULL);
+
+   checkResult("Raw Ethernet: ARP packet truncated by the new filter",
+      error == NO_ERROR && n == (sizeof(EthHeader) + APP_ARP_FIXED_LEN));
+
+   //The previous filter no longer applies
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw Ethernet: previous filter replaced",
+      receivePacket(socket, NULL) == 0);
+
+   //An invalid program must not replace the current filter
+   error = socketAttachFilter(socket, missingRet, arraysize(missingRet));
+   injectFrame(interface, ETH_TYPE_ARP, &arpPacket, sizeof(ArpPacket));
+   n = receivePacket(socket, NULL);
+
+   checkResult("Raw Ethernet: invalid program refused, filter kept",
+      error != NO_ERROR && n == (sizeof(EthHeader) + APP_ARP_FIXED_LEN));
+
+   //Detach the filter
+   error = socketDetachFilter(socket);
+   length = formatTransportPacket(interface, packet, 5, IPV4_PROTOCOL_UDP, 0,
+      APP_FILTER_PORT + 1);
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+   n = receivePacket(socket, NULL);
+
+   checkResult("Raw Ethernet: all frames accepted once detached",
+      error == NO_ERROR && n == (sizeof(EthHeader) + length));
+
+   //Close the socket
+   socketClose(socket);
+}
+
+
+/**
+ * @brief Filters attached to a raw IP socket
+ * @param[in] interface Underlying network interface
+ **/
+
+void checkRawIp(NetInterface *interface)
+{
+   error_t error;
+   size_t length;
+   size_t n;
+   uint_t count;
+   Socket *socket;
+   uint8_t data[8];
+   uint8_t packet[64];
+
+   //Filters only apply to raw sockets
+   socket = socketOpen(SOCKET_TYPE_DGRAM, SOCKET_IP_PROTO_UDP);
+   error = socketAttachFilter(socket, payloadFilter,
+      arraysize(payloadFilter));
+   socketClose(socket);
+
+   checkResult("UDP socket: filter refused", error == ERROR_INVALID_SOCKET);
+
+   //Open a raw socket bound to an unassigned protocol number
+   socket = socketOpen(SOCKET_TYPE_RAW_IP, APP_RAW_PROTOCOL);
+
+   //Attach the payload filter
+   error = socketAttachFilter(socket, payloadFilter,
+      arraysize(payloadFilter));
+
+   checkResult("Raw IP: payload filter attached", error == NO_ERROR);
+
+   //Matching packet
+   osMemset(data, 0x42, sizeof(data));
+   length = formatIpv4Packet(interface, packet, 5, APP_RAW_PROTOCOL, 0, data,
+      sizeof(data));
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+   n = receivePacket(socket, packet);
+
+   checkResult("Raw IP: filter runs on the IP payload", n == sizeof(data) &&
+      packet[0] == 0x42);
+
+   //Packet rejected by the filter
+   count = protoUnreachableCount;
+   osMemset(data, 0x43, sizeof(data));
+   length = formatIpv4Packet(interface, packet, 5, APP_RAW_PROTOCOL, 0, data,
+      sizeof(data));
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw IP: filtered packet dropped without ICMP error",
+      receivePacket(socket, NULL) == 0 && protoUnreachableCount == count);
+
+   //Close the socket
+   socketClose(socket);
+
+   //The protocol is now unreachable
+   injectFrame(interface, ETH_TYPE_IPV4, packet, length);
+
+   checkResult("Raw IP: unbound protocol answered with ICMP error",
+      protoUnreachableCount == count + 1);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("***********************************\r\n");
+   TRACE_INFO("*** CycloneTCP BPF Filter Check ***\r\n");
+   TRACE_INFO("***********************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //Addresses of the simulated peer
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+
+   //The peer is reachable without address resolution
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Run the checks
+   checkVerifier();
+   checkInterpreter(interface);
+   checkRawEth(interface);
+   checkRawIp(interface);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
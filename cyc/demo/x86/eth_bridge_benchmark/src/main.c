@@ -0,0 +1,399 @@
+/**
+ * @file main.c
+ * @brief Software Ethernet bridge benchmark
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Two virtual Ethernet interfaces are bridged together. Frames are injected
+ * on the first port as if they had been received by the NIC and the number
+ * of frames relayed to the second port per second is reported
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/eth_bridge.h"
+#include "debug.h"
+
+//Bridge ports configuration
+#define APP_PORT1_NAME "eth0"
+#define APP_PORT1_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_PORT2_NAME "eth1"
+#define APP_PORT2_MAC_ADDR "00-AB-CD-EF-00-02"
+
+//Benchmark configuration
+#define APP_FDB_SIZE 64
+#define APP_FRAME_SIZE 64
+#define APP_FRAME_COUNT 1000000
+#define APP_SRC_STATION_ADDR "00-11-22-33-44-01"
+#define APP_DEST_STATION_ADDR "00-11-22-33-44-02"
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+EthBridgeSettings ethBridgeSettings;
+EthBridgeContext ethBridgeContext;
+EthBridgeFdbEntry ethBridgeFdb[APP_FDB_SIZE];
+NetInterface *ethBridgePorts[2];
+uint32_t txFrameCount[NET_INTERFACE_COUNT];
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   //Count the frames that leave the interface
+   txFrameCount[interface->index]++;
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format an Ethernet frame exchanged between two stations
+ * @param[out] frame Buffer where to format the frame
+ * @param[in] destAddr Destination MAC address
+ * @param[in] srcAddr Source MAC address
+ * @return Length of the frame
+ **/
+
+size_t formatFrame(uint8_t *frame, const MacAddr *destAddr,
+   const MacAddr *srcAddr)
+{
+   EthHeader *header;
+
+   //Point to the Ethernet header
+   header = (EthHeader *) frame;
+
+   //Format Ethernet header
+   macCopyAddr(&header->destAddr, destAddr);
+   macCopyAddr(&header->srcAddr, srcAddr);
+   header->type = HTONS(ETH_TYPE_IPV4);
+
+   //Dummy payload
+   osMemset(header->data, 0, APP_FRAME_SIZE - sizeof(EthHeader));
+
+   //Return the length of the frame
+   return APP_FRAME_SIZE;
+}
+
+
+/**
+ * @brief Configure a bridge port
+ * @param[in] interface Underlying network interface
+ * @param[in] name Interface name
+ * @param[in] macAddr MAC address
+ * @return Error code
+ **/
+
+error_t configPort(NetInterface *interface, const char_t *name,
+   const char_t *macAddr)
+{
+   MacAddr addr;
+
+   //Set interface name
+   netSetInterfaceName(interface, name);
+   //Select the relevant network adapter
+   netSetDriver(interface, &benchDriver);
+   //Set host MAC address
+   macStringToAddr(macAddr, &addr);
+   netSetMacAddr(interface, &addr);
+   //Frames destined to other stations must be received
+   netEnablePromiscuousMode(interface, TRUE);
+
+   //Initialize network interface
+   return netConfigInterface(interface);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   uint_t i;
+   size_t length;
+   systime_t startTime;
+   systime_t elapsedTime;
+   uint32_t forwarded;
+   MacAddr srcAddr;
+   MacAddr destAddr;
+   uint8_t frame[APP_FRAME_SIZE];
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Ethernet Bridge Benchmark ***\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the bridge ports
+   ethBridgePorts[0] = &netInterface[0];
+   ethBridgePorts[1] = &netInterface[1];
+
+   error = configPort(ethBridgePorts[0], APP_PORT1_NAME, APP_PORT1_MAC_ADDR);
+
+   if(!error)
+   {
+      error = configPort(ethBridgePorts[1], APP_PORT2_NAME,
+         APP_PORT2_MAC_ADDR);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure bridge ports!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Get default settings
+   ethBridgeGetDefaultSettings(&ethBridgeSettings);
+   //Bridge ports
+   ethBridgeSettings.numPorts = arraysize(ethBridgePorts);
+   ethBridgeSettings.ports = ethBridgePorts;
+   //Filtering database
+   ethBridgeSettings.numFdbEntries = arraysize(ethBridgeFdb);
+   ethBridgeSettings.fdbEntries = ethBridgeFdb;
+
+   //Bridge initialization
+   error = ethBridgeInit(&ethBridgeContext, &ethBridgeSettings);
+
+   //Check status code
+   if(!error)
+   {
+      //Start relaying frames
+      error = ethBridgeStart(&ethBridgeContext);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to start Ethernet bridge!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Wait for the virtual links to come up
+   while(!netInterface[0].linkState || !netInterface[1].linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Stations attached to the bridge
+   macStringToAddr(APP_SRC_STATION_ADDR, &srcAddr);
+   macStringToAddr(APP_DEST_STATION_ADDR, &destAddr);
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Let the bridge learn that the destination station sits behind port 2
+   length = formatFrame(frame, &srcAddr, &destAddr);
+   nicProcessPacket(&netInterface[1], frame, length,
+      (NetRxAncillary *) &NET_DEFAULT_RX_ANCILLARY);
+
+   //Frames exchanged between the two stations
+   length = formatFrame(frame, &destAddr, &srcAddr);
+   txFrameCount[1] = 0;
+
+   //Save current time
+   startTime = osGetSystemTime();
+
+   //Inject frames on port 1
+   for(i = 0; i < APP_FRAME_COUNT; i++)
+   {
+      nicProcessPacket(&netInterface[0], frame, length,
+         (NetRxAncillary *) &NET_DEFAULT_RX_ANCILLARY);
+   }
+
+   //Measure elapsed time
+   elapsedTime = osGetSystemTime() - startTime;
+   forwarded = txFrameCount[1];
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Avoid division by zero
+   elapsedTime = MAX(elapsedTime, 1);
+
+   //Display benchmark results
+   TRACE_PRINTF("Frames injected: %u\r\n", (uint_t) APP_FRAME_COUNT);
+   TRACE_PRINTF("Frames forwarded: %" PRIu32 "\r\n", forwarded);
+   TRACE_PRINTF("Elapsed time: %" PRIu32 " ms\r\n", (uint32_t) elapsedTime);
+   TRACE_PRINTF("Throughput: %" PRIu32 " frames/s\r\n",
+      (uint32_t) ((uint64_t) forwarded * 1000 / elapsedTime));
+
+   //Successful processing
+   return (forwarded == APP_FRAME_COUNT) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,657 @@
+/**
+ * @file main.c
+ * @brief Egress QoS check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Two virtual Ethernet interfaces are attached to a software bridge, and
+ * egress QoS is enabled on the second one. Frames carrying different DSCP
+ * values are injected on the first port while the transmitter of the second
+ * port is busy. The check verifies that the relayed frames are queued by
+ * the scheduler, that the strict priority class leaves the port first once
+ * the transmitter is ready, that the weighted classes share the link in
+ * proportion to their weights, and that the token-bucket shaper limits the
+ * rate of the best effort class
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/eth_bridge.h"
+#include "core/eth_qos.h"
+#include "debug.h"
+
+//Bridge ports configuration
+#define APP_PORT1_NAME "eth0"
+#define APP_PORT1_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_PORT2_NAME "eth1"
+#define APP_PORT2_MAC_ADDR "00-AB-CD-EF-00-02"
+
+//Stations attached to the bridge
+#define APP_SRC_STATION_ADDR "00-11-22-33-44-01"
+#define APP_DEST_STATION_ADDR "00-11-22-33-44-02"
+
+//Check configuration
+#define APP_FDB_SIZE 16
+#define APP_FRAME_SIZE 64
+#define APP_LARGE_FRAME_SIZE 1400
+#define APP_LARGE_FRAME_COUNT 12
+#define APP_SHAPED_FRAME_SIZE 500
+#define APP_SHAPED_FRAME_COUNT 40
+#define APP_SHAPER_RATE 50000
+#define APP_SHAPER_BURST 1000
+#define APP_LOG_SIZE 64
+#define APP_TIMEOUT 5000
+
+//DSCP values
+#define APP_DSCP_BE 0
+#define APP_DSCP_CS2 16
+#define APP_DSCP_EF 46
+#define APP_DSCP_CS7 56
+
+//Forward declaration of functions
+error_t wireDriverInit(NetInterface *interface);
+void wireDriverTick(NetInterface *interface);
+void wireDriverEnableIrq(NetInterface *interface);
+void wireDriverDisableIrq(NetInterface *interface);
+void wireDriverEventHandler(NetInterface *interface);
+
+error_t wireDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t wireDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+EthBridgeSettings ethBridgeSettings;
+EthBridgeContext ethBridgeContext;
+EthBridgeFdbEntry ethBridgeFdb[APP_FDB_SIZE];
+NetInterface *ethBridgePorts[2];
+EthQosSettings ethQosSettings;
+EthQosContext ethQosContext;
+bool_t txReady = TRUE;
+uint8_t txLog[APP_LOG_SIZE];
+uint_t txLogLength;
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver wireDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   wireDriverInit,
+   wireDriverTick,
+   wireDriverEnableIrq,
+   wireDriverDisableIrq,
+   wireDriverEventHandler,
+   wireDriverSendPacket,
+   wireDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t wireDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_100MBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The DSCP of the frames sent through the second port is logged. The
+ * transmitter of the second port stays busy after a frame has been sent
+ * while txReady is cleared
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t wireDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   uint8_t tos;
+
+   //Second port?
+   if(interface == &netInterface[1])
+   {
+      //Read the Type of Service field of the IPv4 header
+      if(netBufferRead(&tos, buffer, offset + sizeof(EthHeader) + 1, 1) == 1 &&
+         txLogLength < APP_LOG_SIZE)
+      {
+         //Log the DSCP of the frame
+         txLog[txLogLength++] = tos >> 2;
+      }
+
+      //The transmitter may stay busy
+      if(txReady)
+      {
+         osSetEvent(&interface->nicTxEvent);
+      }
+   }
+   else
+   {
+      //The transmitter is always ready to accept a new frame
+      osSetEvent(&interface->nicTxEvent);
+   }
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t wireDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Inject a frame on the first port
+ * @param[in] dscp DSCP value of the IPv4 packet
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(uint8_t dscp, size_t length)
+{
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   NetRxAncillary ancillary;
+   static uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Format Ethernet header
+   macStringToAddr(APP_DEST_STATION_ADDR, &ethHeader->destAddr);
+   macStringToAddr(APP_SRC_STATION_ADDR, &ethHeader->srcAddr);
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   osMemset(ethHeader->data, 0, length - sizeof(EthHeader));
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = dscp << 2;
+   ipHeader->totalLength = htons(length - sizeof(EthHeader));
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_UDP;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //The frame is relayed by the bridge
+   nicProcessPacket(&netInterface[0], frame, length, &ancillary);
+}
+
+
+/**
+ * @brief Wait for the scheduler to release all the queued frames
+ * @return TRUE if the queues were emptied before the timeout
+ **/
+
+bool_t waitForQueues(void)
+{
+   uint_t numPending;
+   systime_t startTime;
+
+   //Save current time
+   startTime = osGetSystemTime();
+
+   do
+   {
+      //Get the number of queued frames
+      osAcquireMutex(&netMutex);
+      numPending = ethQosContext.numPending;
+      osReleaseMutex(&netMutex);
+
+      //Timeout error?
+      if((osGetSystemTime() - startTime) >= APP_TIMEOUT)
+         return FALSE;
+
+      //The frames are released by the TCP/IP stack task
+      osDelayTask(5);
+
+      //Loop until the queues are empty
+   } while(numPending > 0);
+
+   //The queues are empty
+   return TRUE;
+}
+
+
+/**
+ * @brief Relay frames while the transmitter of the second port is busy
+ * @param[in] dscps DSCP value of each frame
+ * @param[in] count Number of frames
+ * @param[in] length Length of each frame
+ * @return TRUE if all the frames were queued and then sent
+ **/
+
+bool_t relayFrames(const uint8_t *dscps, uint_t count, size_t length)
+{
+   uint_t i;
+   uint_t numPending;
+   bool_t ok;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //The transmitter of the second port becomes busy
+   txReady = FALSE;
+   osWaitForEvent(&netInterface[1].nicTxEvent, 0);
+   txLogLength = 0;
+
+   //Inject the frames
+   for(i = 0; i < count; i++)
+   {
+      injectFrame(dscps[i], length);
+   }
+
+   //The relayed frames must be held by the scheduler
+   numPending = ethQosContext.numPending;
+
+   //The transmitter is ready again
+   txReady = TRUE;
+   osSetEvent(&netInterface[1].nicTxEvent);
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Let the scheduler release the frames
+   ok = waitForQueues();
+
+   //Display the transmission order
+   TRACE_PRINTF("Queued frames: %u\r\n", numPending);
+   TRACE_PRINTF("Transmission order (DSCP):");
+
+   for(i = 0; i < txLogLength; i++)
+   {
+      TRACE_PRINTF(" %u", txLog[i]);
+   }
+
+   TRACE_PRINTF("\r\n");
+
+   //All the frames must have been queued and sent
+   return ok && numPending == count && txLogLength == count;
+}
+
+
+/**
+ * @brief Check that the strict priority class is served first
+ * @return TRUE if the network control frames left the port first
+ **/
+
+bool_t checkPriority(void)
+{
+   bool_t ok;
+
+   //Frames injected on the first port, from the lowest to the highest
+   //priority
+   static const uint8_t dscps[] = {APP_DSCP_BE, APP_DSCP_BE, APP_DSCP_BE,
+      APP_DSCP_BE, APP_DSCP_CS2, APP_DSCP_CS2, APP_DSCP_EF, APP_DSCP_EF,
+      APP_DSCP_CS7, APP_DSCP_CS7};
+
+   //Relay the frames
+   ok = relayFrames(dscps, arraysize(dscps), APP_FRAME_SIZE);
+
+   //Network control frames are mapped to the strict priority class
+   return ok && txLog[0] == APP_DSCP_CS7 && txLog[1] == APP_DSCP_CS7;
+}
+
+
+/**
+ * @brief Check that the weighted classes share the link
+ * @return TRUE if the classes were served in proportion to their weights
+ **/
+
+bool_t checkSharing(void)
+{
+   uint_t i;
+   uint_t n;
+   bool_t ok;
+   uint8_t dscps[2 * APP_LARGE_FRAME_COUNT];
+
+   //Interleave expedited forwarding frames (weight 3) and CS2 frames
+   //(weight 2)
+   for(i = 0; i < APP_LARGE_FRAME_COUNT; i++)
+   {
+      dscps[2 * i] = APP_DSCP_EF;
+      dscps[2 * i + 1] = APP_DSCP_CS2;
+   }
+
+   //Relay the frames
+   ok = relayFrames(dscps, arraysize(dscps), APP_LARGE_FRAME_SIZE);
+
+   //A round sends 3 frames of the first class and 2 frames of the second
+   //one, so that the first class has been drained after 4 rounds
+   for(i = 0, n = 0; ok && i < (APP_LARGE_FRAME_COUNT * 5 / 3); i++)
+   {
+      if(txLog[i] == APP_DSCP_EF)
+      {
+         n++;
+      }
+   }
+
+   //Check the share of the first class
+   return ok && n == APP_LARGE_FRAME_COUNT;
+}
+
+
+/**
+ * @brief Check that the shaper limits the rate of the best effort class
+ * @return TRUE if the frames were sent at the configured rate
+ **/
+
+bool_t checkShaper(void)
+{
+   uint_t i;
+   bool_t ok;
+   systime_t startTime;
+   systime_t elapsedTime;
+   systime_t minTime;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Save current time
+   startTime = osGetSystemTime();
+   txLogLength = 0;
+
+   //Inject a burst of best effort frames
+   for(i = 0; i < APP_SHAPED_FRAME_COUNT; i++)
+   {
+      injectFrame(APP_DSCP_BE, APP_SHAPED_FRAME_SIZE);
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Let the scheduler release the frames
+   ok = waitForQueues();
+   //Measure elapsed time
+   elapsedTime = osGetSystemTime() - startTime;
+
+   //Only the initial content of the bucket can be sent without waiting
+   minTime = (APP_SHAPED_FRAME_COUNT * APP_SHAPED_FRAME_SIZE -
+      APP_SHAPER_BURST) * 1000 / APP_SHAPER_RATE;
+
+   //Display statistics
+   TRACE_PRINTF("Shaped frames sent: %u in %" PRIu32 " ms (%" PRIu32
+      " ms expected)\r\n", txLogLength, (uint32_t) elapsedTime,
+      (uint32_t) minTime);
+
+   //All the frames must have been sent, at no more than the configured rate
+   return ok && txLogLength == APP_SHAPED_FRAME_COUNT &&
+      elapsedTime >= (minTime * 9 / 10);
+}
+
+
+/**
+ * @brief Configure a bridge port
+ * @param[in] interface Underlying network interface
+ * @param[in] name Interface name
+ * @param[in] macAddr MAC address
+ * @return Error code
+ **/
+
+error_t configPort(NetInterface *interface, const char_t *name,
+   const char_t *macAddr)
+{
+   MacAddr addr;
+
+   //Set interface name
+   netSetInterfaceName(interface, name);
+   //Select the relevant network adapter
+   netSetDriver(interface, &wireDriver);
+   //Set host MAC address
+   macStringToAddr(macAddr, &addr);
+   netSetMacAddr(interface, &addr);
+   //Frames destined to other stations must be received
+   netEnablePromiscuousMode(interface, TRUE);
+
+   //Initialize network interface
+   return netConfigInterface(interface);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   bool_t priorityOk;
+   bool_t sharingOk;
+   bool_t shaperOk;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("***********************************\r\n");
+   TRACE_INFO("*** CycloneTCP Egress QoS Check ***\r\n");
+   TRACE_INFO("***********************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the bridge ports
+   ethBridgePorts[0] = &netInterface[0];
+   ethBridgePorts[1] = &netInterface[1];
+
+   error = configPort(ethBridgePorts[0], APP_PORT1_NAME, APP_PORT1_MAC_ADDR);
+
+   if(!error)
+   {
+      error = configPort(ethBridgePorts[1], APP_PORT2_NAME,
+         APP_PORT2_MAC_ADDR);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure bridge ports!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Get default settings
+   ethBridgeGetDefaultSettings(&ethBridgeSettings);
+   //Bridge ports
+   ethBridgeSettings.numPorts = arraysize(ethBridgePorts);
+   ethBridgeSettings.ports = ethBridgePorts;
+   //Filtering database
+   ethBridgeSettings.numFdbEntries = arraysize(ethBridgeFdb);
+   ethBridgeSettings.fdbEntries = ethBridgeFdb;
+
+   //Bridge initialization
+   error = ethBridgeInit(&ethBridgeContext, &ethBridgeSettings);
+
+   //Check status code
+   if(!error)
+   {
+      //Start relaying frames
+      error = ethBridgeStart(&ethBridgeContext);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to start Ethernet bridge!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Get default settings
+   ethQosGetDefaultSettings(&ethQosSettings);
+   //Egress port
+   ethQosSettings.interface = &netInterface[1];
+   //Shape the best effort class
+   ethQosSettings.classes[3].rate = APP_SHAPER_RATE;
+   ethQosSettings.classes[3].burst = APP_SHAPER_BURST;
+   //Room for the whole burst
+   ethQosSettings.classes[3].queueDepth = APP_SHAPED_FRAME_COUNT;
+
+   //Egress QoS initialization
+   error = ethQosInit(&ethQosContext, &ethQosSettings);
+
+   //Check status code
+   if(!error)
+   {
+      //Start the scheduler
+      error = ethQosStart(&ethQosContext);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to start egress QoS!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Wait for the virtual links to come up
+   while(!netInterface[0].linkState || !netInterface[1].linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Run the checks
+   priorityOk = checkPriority();
+   sharingOk = checkSharing();
+   shaperOk = checkShaper();
+
+   //Display results
+   TRACE_PRINTF("Priority: %s\r\n", priorityOk ? "passed" : "failed");
+   TRACE_PRINTF("Sharing: %s\r\n", sharingOk ? "passed" : "failed");
+   TRACE_PRINTF("Shaper: %s\r\n", shaperOk ? "passed" : "failed");
+
+   //Successful processing?
+   if(priorityOk && sharingOk && shaperOk)
+   {
+      return EXIT_SUCCESS;
+   }
+   else
+   {
+      return EXIT_FAILURE;
+   }
+}
@@ -0,0 +1,124 @@
+/**
+ * @file net_config.h
+ * @brief CycloneTCP configuration file
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This file is part of CycloneTCP Open.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+#ifndef _NET_CONFIG_H
+#define _NET_CONFIG_H
+
+//Trace level for TCP/IP stack debugging
+#define MEM_TRACE_LEVEL          TRACE_LEVEL_INFO
+#define NIC_TRACE_LEVEL          TRACE_LEVEL_INFO
+#define ETH_TRACE_LEVEL          TRACE_LEVEL_OFF
+#define LLDP_TRACE_LEVEL         TRACE_LEVEL_OFF
+#define ARP_TRACE_LEVEL          TRACE_LEVEL_OFF
+#define IP_TRACE_LEVEL           TRACE_LEVEL_OFF
+#define IPV4_TRACE_LEVEL         TRACE_LEVEL_OFF
+#define IPV6_TRACE_LEVEL         TRACE_LEVEL_OFF
+#define ICMP_TRACE_LEVEL         TRACE_LEVEL_OFF
+#define IGMP_TRACE_LEVEL         TRACE_LEVEL_OFF
+#define ICMPV6_TRACE_LEVEL       TRACE_LEVEL_OFF
+#define MLD_TRACE_LEVEL          TRACE_LEVEL_OFF
+#define NDP_TRACE_LEVEL          TRACE_LEVEL_OFF
+#define UDP_TRACE_LEVEL          TRACE_LEVEL_OFF
+#define TCP_TRACE_LEVEL          TRACE_LEVEL_OFF
+#define SOCKET_TRACE_LEVEL       TRACE_LEVEL_OFF
+#define RAW_SOCKET_TRACE_LEVEL   TRACE_LEVEL_OFF
+#define BSD_SOCKET_TRACE_LEVEL   TRACE_LEVEL_OFF
+#define WEB_SOCKET_TRACE_LEVEL   TRACE_LEVEL_OFF
+#define AUTO_IP_TRACE_LEVEL      TRACE_LEVEL_INFO
+#define SLAAC_TRACE_LEVEL        TRACE_LEVEL_INFO
+#define DHCP_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define DHCPV6_TRACE_LEVEL       TRACE_LEVEL_INFO
+#define DNS_TRACE_LEVEL          TRACE_LEVEL_INFO
+#define MDNS_TRACE_LEVEL         TRACE_LEVEL_OFF
+#define NBNS_TRACE_LEVEL         TRACE_LEVEL_OFF
+#define LLMNR_TRACE_LEVEL        TRACE_LEVEL_OFF
+#define ECHO_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define COAP_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define FTP_TRACE_LEVEL          TRACE_LEVEL_INFO
+#define HTTP_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define MQTT_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define MQTT_SN_TRACE_LEVEL      TRACE_LEVEL_INFO
+#define SMTP_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define SNMP_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define SNTP_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define NTP_TRACE_LEVEL          TRACE_LEVEL_INFO
+#define NTS_TRACE_LEVEL          TRACE_LEVEL_INFO
+#define TFTP_TRACE_LEVEL         TRACE_LEVEL_INFO
+#define MODBUS_TRACE_LEVEL       TRACE_LEVEL_INFO
+
+//Number of network adapters
+#define NET_INTERFACE_COUNT 2
+
+//Size of the MAC address filter
+#define MAC_ADDR_FILTER_SIZE 12
+
+//Software Ethernet bridge support
+#define ETH_BRIDGE_SUPPORT ENABLED
+
+//Egress QoS support
+#define ETH_QOS_SUPPORT ENABLED
+
+//IPv4 support
+#define IPV4_SUPPORT ENABLED
+//Size of the IPv4 multicast filter
+#define IPV4_MULTICAST_FILTER_SIZE 4
+
+//Size of ARP cache
+#define ARP_CACHE_SIZE 8
+//Maximum number of packets waiting for address resolution to complete
+#define ARP_MAX_PENDING_PACKETS 2
+
+//IPv6 support
+#define IPV6_SUPPORT DISABLED
+
+//TCP support
+#define TCP_SUPPORT ENABLED
+
+//UDP support
+#define UDP_SUPPORT ENABLED
+//Receive queue depth for connectionless sockets
+#define UDP_RX_QUEUE_SIZE 4
+
+//Raw socket support
+#define RAW_SOCKET_SUPPORT DISABLED
+
+//DNS client support
+#define DNS_CLIENT_SUPPORT DISABLED
+//NBNS client support
+#define NBNS_CLIENT_SUPPORT DISABLED
+//NBNS responder support
+#define NBNS_RESPONDER_SUPPORT DISABLED
+//DHCP client support
+#define DHCP_CLIENT_SUPPORT DISABLED
+
+//Number of sockets that can be opened simultaneously
+#define SOCKET_MAX_COUNT 4
+
+#endif
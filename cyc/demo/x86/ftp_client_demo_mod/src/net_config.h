@@ -86,9 +86,8 @@
 
 //IPv4 fragmentation support
 #define IPV4_FRAG_SUPPORT ENABLED
-//Maximum number of fragmented packets the host will accept
-//and hold in the reassembly queue simultaneously
-#define IPV4_MAX_FRAG_DATAGRAMS 4
+//Maximum amount of memory used by the reassembly queue
+#define IPV4_FRAG_MAX_MEMORY 32768
 //Maximum datagram size the host will accept when reassembling fragments
 #define IPV4_MAX_FRAG_DATAGRAM_SIZE 8192
 
@@ -107,9 +106,8 @@
 
 //IPv6 fragmentation support
 #define IPV6_FRAG_SUPPORT ENABLED
-//Maximum number of fragmented packets the host will accept
-//and hold in the reassembly queue simultaneously
-#define IPV6_MAX_FRAG_DATAGRAMS 4
+//Maximum amount of memory used by the reassembly queue
+#define IPV6_FRAG_MAX_MEMORY 32768
 //Maximum datagram size the host will accept when reassembling fragments
 #define IPV6_MAX_FRAG_DATAGRAM_SIZE 8192
 
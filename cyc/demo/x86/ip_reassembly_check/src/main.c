@@ -0,0 +1,1007 @@
+/**
+ * @file main.c
+ * @brief IPv4 and IPv6 fragment reassembly check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Fragmented UDP datagrams are injected into a virtual Ethernet interface
+ * in order, out of order, with duplicate and overlapping fragments, and
+ * split into more fragments than a datagram can have chunks. The payload
+ * received on a UDP socket is compared with the original data. The oldest
+ * datagram must be evicted when the reassembly queue reaches its memory
+ * limit, and incomplete datagrams must time out
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/udp.h"
+#include "core/tcp.h"
+#include "ipv4/arp_cache.h"
+#include "ipv4/ipv4_frag.h"
+#include "ipv4/icmp.h"
+#include "ipv6/ipv6_frag.h"
+#include "ipv6/ndp.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+#define APP_IPV6_LINK_LOCAL_ADDR "fe80::1"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_IPV6_ADDR "fe80::2"
+#define APP_PEER_PORT 40000
+
+//Check configuration
+#define APP_UDP_PORT 5000
+#define APP_TCP_PORT 5001
+#define APP_MAX_DATAGRAM_SIZE 8192
+
+/**
+ * @brief Description of a fragment
+ **/
+
+typedef struct
+{
+   size_t first;
+   size_t length;
+   size_t corrupt;
+} FragSpec;
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpv4Addr;
+Ipv6Addr peerIpv6Addr;
+uint_t timeExceededCount;
+bool_t synAckReceived;
+uint_t failureCount;
+FragSpec fragSpec[APP_MAX_DATAGRAM_SIZE / 8];
+uint8_t datagram[APP_MAX_DATAGRAM_SIZE];
+uint8_t buffer[APP_MAX_DATAGRAM_SIZE];
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The ICMP Time Exceeded messages and the TCP SYN-ACK segments sent by the
+ * stack are counted
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   IcmpHeader *icmpHeader;
+   TcpHeader *tcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //IPv4 packet?
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header) + sizeof(TcpHeader)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4))
+   {
+      //Point to the ICMP or TCP header
+      icmpHeader = (IcmpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //ICMP Time Exceeded message?
+      if(ipHeader->protocol == IPV4_PROTOCOL_ICMP &&
+         icmpHeader->type == ICMP_TYPE_TIME_EXCEEDED &&
+         icmpHeader->code == ICMP_CODE_REASSEMBLY_TIME_EXCEEDED)
+      {
+         timeExceededCount++;
+      }
+
+      //SYN-ACK segment?
+      if(ipHeader->protocol == IPV4_PROTOCOL_TCP &&
+         tcpHeader->flags == (TCP_FLAG_SYN | TCP_FLAG_ACK) &&
+         tcpHeader->destPort == HTONS(APP_PEER_PORT))
+      {
+         synAckReceived = TRUE;
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Process a frame as if it had been received by the NIC
+ * @param[in] interface Underlying network interface
+ * @param[in] frame Ethernet frame
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(NetInterface *interface, uint8_t *frame, size_t length)
+{
+   NetRxAncillary ancillary;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   osAcquireMutex(&netMutex);
+   nicProcessPacket(interface, frame, length, &ancillary);
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Format a UDP datagram
+ * @param[in] interface Underlying network interface
+ * @param[in] id Value the payload is derived from
+ * @param[in] length Length of the payload
+ * @param[in] ipv6 Compute the checksum for IPv6 (the checksum is optional
+ *   with IPv4)
+ * @return Length of the datagram
+ **/
+
+size_t formatUdpDatagram(NetInterface *interface, uint_t id, size_t length,
+   bool_t ipv6)
+{
+   size_t i;
+   UdpHeader *header;
+   Ipv6PseudoHeader pseudoHeader;
+
+   //Point to the UDP header
+   header = (UdpHeader *) datagram;
+
+   //Format UDP header
+   header->srcPort = HTONS(APP_PEER_PORT);
+   header->destPort = HTONS(APP_UDP_PORT);
+   header->length = htons(sizeof(UdpHeader) + length);
+   header->checksum = 0;
+
+   //Each byte of the payload is derived from its position
+   for(i = 0; i < length; i++)
+   {
+      header->data[i] = (uint8_t) (i * 7 + id);
+   }
+
+   //UDP checksum is mandatory with IPv6
+   if(ipv6)
+   {
+      pseudoHeader.srcAddr = peerIpv6Addr;
+      pseudoHeader.destAddr = interface->ipv6Context.addrList[0].addr;
+      pseudoHeader.length = htonl(sizeof(UdpHeader) + length);
+      pseudoHeader.reserved[0] = 0;
+      pseudoHeader.reserved[1] = 0;
+      pseudoHeader.reserved[2] = 0;
+      pseudoHeader.nextHeader = IPV6_UDP_HEADER;
+
+      header->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+         sizeof(Ipv6PseudoHeader), header, sizeof(UdpHeader) + length);
+   }
+
+   //Return the length of the datagram
+   return sizeof(UdpHeader) + length;
+}
+
+
+/**
+ * @brief Inject an IPv4 fragment
+ * @param[in] interface Underlying network interface
+ * @param[in] id Identification field
+ * @param[in] protocol Upper-layer protocol
+ * @param[in] spec Description of the fragment
+ * @param[in] length Length of the whole datagram
+ **/
+
+void injectIpv4Fragment(NetInterface *interface, uint16_t id,
+   uint8_t protocol, const FragSpec *spec, size_t length)
+{
+   size_t i;
+   uint16_t offset;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Fragment offset, in units of 8 bytes
+   offset = spec->first / 8;
+
+   //More fragments follow?
+   if((spec->first + spec->length) < length)
+   {
+      offset |= IPV4_FLAG_MF;
+   }
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + spec->length);
+   ipHeader->identification = htons(id);
+   ipHeader->fragmentOffset = htons(offset);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = protocol;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpv4Addr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Copy the data
+   osMemcpy(ipHeader->options, datagram + spec->first, spec->length);
+
+   //Alter the leading bytes, if requested
+   for(i = 0; i < spec->corrupt; i++)
+   {
+      ipHeader->options[i] ^= 0xFF;
+   }
+
+   //Process the frame
+   injectFrame(interface, frame, sizeof(EthHeader) + sizeof(Ipv4Header) +
+      spec->length);
+}
+
+
+/**
+ * @brief Inject an IPv6 fragment
+ * @param[in] interface Underlying network interface
+ * @param[in] id Identification field
+ * @param[in] spec Description of the fragment
+ * @param[in] length Length of the whole datagram
+ **/
+
+void injectIpv6Fragment(NetInterface *interface, uint32_t id,
+   const FragSpec *spec, size_t length)
+{
+   size_t i;
+   uint16_t offset;
+   EthHeader *ethHeader;
+   Ipv6Header *ipHeader;
+   Ipv6FragmentHeader *fragHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv6Header *) ethHeader->data;
+   fragHeader = (Ipv6FragmentHeader *) ipHeader->payload;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV6);
+
+   //Format IPv6 header
+   osMemset(ipHeader, 0, sizeof(Ipv6Header));
+   ipHeader->version = IPV6_VERSION;
+   ipHeader->payloadLen = htons(sizeof(Ipv6FragmentHeader) + spec->length);
+   ipHeader->nextHeader = IPV6_FRAGMENT_HEADER;
+   ipHeader->hopLimit = 64;
+   ipHeader->srcAddr = peerIpv6Addr;
+   ipHeader->destAddr = interface->ipv6Context.addrList[0].addr;
+
+   //Fragment offset and M flag
+   offset = spec->first;
+
+   //More fragments follow?
+   if((spec->first + spec->length) < length)
+   {
+      offset |= IPV6_FLAG_M;
+   }
+
+   //Format Fragment header
+   fragHeader->nextHeader = IPV6_UDP_HEADER;
+   fragHeader->reserved = 0;
+   fragHeader->fragmentOffset = htons(offset);
+   fragHeader->identification = htonl(id);
+
+   //Copy the data
+   osMemcpy((uint8_t *) (fragHeader + 1), datagram + spec->first,
+      spec->length);
+
+   //Alter the leading bytes, if requested
+   for(i = 0; i < spec->corrupt; i++)
+   {
+      ((uint8_t *) (fragHeader + 1))[i] ^= 0xFF;
+   }
+
+   //Process the frame
+   injectFrame(interface, frame, sizeof(EthHeader) + sizeof(Ipv6Header) +
+      sizeof(Ipv6FragmentHeader) + spec->length);
+}
+
+
+/**
+ * @brief Split a datagram into fragments of equal size
+ * @param[in] length Length of the datagram
+ * @param[in] size Size of the fragments (multiple of 8)
+ * @param[in] reverse Send the fragments in reverse order
+ * @return Number of fragments
+ **/
+
+uint_t splitDatagram(size_t length, size_t size, bool_t reverse)
+{
+   uint_t i;
+   uint_t n;
+   FragSpec spec;
+
+   //Generate the fragments in order
+   for(n = 0; (n * size) < length; n++)
+   {
+      fragSpec[n].first = n * size;
+      fragSpec[n].length = MIN(size, length - n * size);
+      fragSpec[n].corrupt = 0;
+   }
+
+   //Reverse the order of the fragments, if requested
+   for(i = 0; reverse && i < (n / 2); i++)
+   {
+      spec = fragSpec[i];
+      fragSpec[i] = fragSpec[n - 1 - i];
+      fragSpec[n - 1 - i] = spec;
+   }
+
+   //Return the number of fragments
+   return n;
+}
+
+
+/**
+ * @brief Inject the fragments of a UDP datagram and read the payload
+ * @param[in] interface Underlying network interface
+ * @param[in] socket UDP socket
+ * @param[in] ipv6 Use IPv6 (IPv4 otherwise)
+ * @param[in] id Identification field
+ * @param[in] length Length of the datagram
+ * @param[in] count Number of fragments
+ * @return Number of bytes received on the socket
+ **/
+
+size_t sendFragments(NetInterface *interface, Socket *socket, bool_t ipv6,
+   uint_t id, size_t length, uint_t count)
+{
+   error_t error;
+   uint_t i;
+   size_t n;
+
+   //Inject the fragments
+   for(i = 0; i < count; i++)
+   {
+      if(ipv6)
+      {
+         injectIpv6Fragment(interface, id, &fragSpec[i], length);
+      }
+      else
+      {
+         injectIpv4Fragment(interface, id, IPV4_PROTOCOL_UDP, &fragSpec[i],
+            length);
+      }
+   }
+
+   //Read the reassembled datagram, if any
+   error = socketReceive(socket, buffer, sizeof(buffer), &n, 0);
+
+   //Return the number of bytes received
+   return error ? 0 : n;
+}
+
+
+/**
+ * @brief Check the payload received on the socket
+ * @param[in] id Value the payload is derived from
+ * @param[in] length Length of the payload
+ * @return TRUE if the payload is intact, else FALSE
+ **/
+
+bool_t checkPayload(uint_t id, size_t length)
+{
+   size_t i;
+
+   //Compare each byte
+   for(i = 0; i < length; i++)
+   {
+      if(buffer[i] != (uint8_t) (i * 7 + id))
+         return FALSE;
+   }
+
+   //The payload is intact
+   return TRUE;
+}
+
+
+/**
+ * @brief Search the IPv4 reassembly queue
+ * @param[in] interface Underlying network interface
+ * @param[in] id Identification field (0 to count all the entries)
+ * @return Number of matching entries
+ **/
+
+uint_t countIpv4FragQueue(NetInterface *interface, uint16_t id)
+{
+   uint_t i;
+   uint_t n;
+   Ipv4FragDesc *frag;
+
+   osAcquireMutex(&netMutex);
+
+   //Loop through the hash buckets
+   for(n = 0, i = 0; i < IPV4_FRAG_HASH_TABLE_SIZE; i++)
+   {
+      for(frag = interface->ipv4Context.fragQueue[i]; frag != NULL;
+         frag = frag->next)
+      {
+         if(id == 0 || frag->identification == htons(id))
+            n++;
+      }
+   }
+
+   osReleaseMutex(&netMutex);
+
+   //Return the number of matching entries
+   return n;
+}
+
+
+
+
+/**
+ * @brief Reassembly of IPv4 datagrams
+ * @param[in] interface Underlying network interface
+ * @param[in] socket UDP socket
+ **/
+
+void checkIpv4Reassembly(NetInterface *interface, Socket *socket)
+{
+   uint_t n;
+   size_t length;
+   size_t received;
+
+   //In-order fragments
+   length = formatUdpDatagram(interface, 1, 4000, FALSE);
+   n = splitDatagram(length, 1480, FALSE);
+   received = sendFragments(interface, socket, FALSE, 1, length, n);
+
+   checkResult("IPv4: in-order fragments", received == 4000 &&
+      checkPayload(1, 4000));
+
+   //Out-of-order fragments
+   length = formatUdpDatagram(interface, 2, 4000, FALSE);
+   n = splitDatagram(length, 1480, TRUE);
+   received = sendFragments(interface, socket, FALSE, 2, length, n);
+
+   checkResult("IPv4: out-of-order fragments", received == 4000 &&
+      checkPayload(2, 4000));
+
+   //Duplicate fragments (the datagram must be delivered once)
+   length = formatUdpDatagram(interface, 3, 4000, FALSE);
+   splitDatagram(length, 1480, FALSE);
+   fragSpec[4] = fragSpec[2];
+   fragSpec[2] = fragSpec[0];
+   fragSpec[3] = fragSpec[1];
+   received = sendFragments(interface, socket, FALSE, 3, length, 5);
+
+   checkResult("IPv4: duplicate fragments", received == 4000 &&
+      checkPayload(3, 4000) &&
+      sendFragments(interface, socket, FALSE, 3, length, 0) == 0);
+
+   //The second fragment overlaps the first one. The overlapping bytes are
+   //altered and must not replace the data that has already been received
+   length = formatUdpDatagram(interface, 4, 4000, FALSE);
+   splitDatagram(length, 1480, FALSE);
+   fragSpec[3] = fragSpec[2];
+   fragSpec[2] = fragSpec[1];
+   fragSpec[1].first = 1000;
+   fragSpec[1].length = 1480;
+   fragSpec[1].corrupt = 480;
+   received = sendFragments(interface, socket, FALSE, 4, length, 4);
+
+   checkResult("IPv4: overlapping fragments", received == 4000 &&
+      checkPayload(4, 4000));
+
+   //More fragments than a datagram can have chunks, in order
+   length = formatUdpDatagram(interface, 5, 1000, FALSE);
+   n = splitDatagram(length, 8, FALSE);
+   received = sendFragments(interface, socket, FALSE, 5, length, n);
+
+   checkResult("IPv4: 126 fragments of 8 bytes, in order", received == 1000 &&
+      checkPayload(5, 1000));
+
+   //More fragments than a datagram can have chunks, in reverse order
+   length = formatUdpDatagram(interface, 6, 6000, FALSE);
+   n = splitDatagram(length, 8, TRUE);
+   received = sendFragments(interface, socket, FALSE, 6, length, n);
+
+   checkResult("IPv4: 751 fragments of 8 bytes, in reverse order",
+      received == 6000 && checkPayload(6, 6000));
+
+   //The reassembly queue must be empty
+   checkResult("IPv4: reassembly queue released",
+      countIpv4FragQueue(interface, 0) == 0 &&
+      interface->ipv4Context.fragMemUsage == 0);
+}
+
+
+/**
+ * @brief TCP header split across two fragments
+ *
+ * The TCP layer accesses the header of the reassembled datagram in place,
+ * so the whole header must be contiguous
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] listener Listening TCP socket
+ **/
+
+void checkIpv4SplitHeader(NetInterface *interface, Socket *listener)
+{
+   Socket *socket;
+   TcpHeader *header;
+   Ipv4PseudoHeader pseudoHeader;
+   FragSpec spec;
+
+   //Point to the TCP header
+   header = (TcpHeader *) datagram;
+
+   //Format SYN segment
+   osMemset(header, 0, sizeof(TcpHeader));
+   header->srcPort = HTONS(APP_PEER_PORT);
+   header->destPort = HTONS(APP_TCP_PORT);
+   header->seqNum = HTONL(1000);
+   header->dataOffset = 5;
+   header->flags = TCP_FLAG_SYN;
+   header->window = HTONS(8192);
+
+   //Format pseudo header
+   pseudoHeader.srcAddr = peerIpv4Addr;
+   pseudoHeader.destAddr = interface->ipv4Context.addrList[0].addr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = HTONS(sizeof(TcpHeader));
+
+   //Calculate TCP checksum
+   header->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), header, sizeof(TcpHeader));
+
+   //The first fragment carries the first 8 bytes of the header
+   spec.first = 0;
+   spec.length = 8;
+   spec.corrupt = 0;
+   injectIpv4Fragment(interface, 7, IPV4_PROTOCOL_TCP, &spec,
+      sizeof(TcpHeader));
+
+   //The second fragment carries the remaining 12 bytes
+   spec.first = 8;
+   spec.length = 12;
+   injectIpv4Fragment(interface, 7, IPV4_PROTOCOL_TCP, &spec,
+      sizeof(TcpHeader));
+
+   //The SYN-ACK is sent when the connection is accepted
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("IPv4: TCP header split across fragments",
+      socket != NULL && synAckReceived);
+
+   //Release the connection
+   if(socket != NULL)
+   {
+      socketClose(socket);
+   }
+}
+
+
+/**
+ * @brief Eviction of the oldest datagram and reassembly timeout
+ * @param[in] interface Underlying network interface
+ * @param[in] socket UDP socket
+ **/
+
+void checkIpv4MemoryLimit(NetInterface *interface, Socket *socket)
+{
+   uint_t i;
+   uint_t n;
+   size_t length;
+   size_t received;
+
+   //Each datagram consumes 3 pool buffers (descriptor, IP header and data),
+   //so that the queue can hold 6 partially reassembled datagrams
+   length = formatUdpDatagram(interface, 8, 4000, FALSE);
+   splitDatagram(length, 1480, FALSE);
+
+   //Send the first fragment of 7 datagrams
+   for(i = 0; i < 7; i++)
+   {
+      injectIpv4Fragment(interface, 100 + i, IPV4_PROTOCOL_UDP, &fragSpec[0],
+         length);
+
+      //The oldest datagram is identified by its timestamp
+      osDelayTask(2);
+   }
+
+   checkResult("IPv4: oldest datagram evicted at the memory limit",
+      countIpv4FragQueue(interface, 0) == 6 &&
+      countIpv4FragQueue(interface, 100) == 0 &&
+      interface->ipv4Context.fragMemUsage <= IPV4_FRAG_MAX_MEMORY);
+
+   //Complete the second datagram. The second fragment requires one more
+   //pool buffer, so the third datagram is evicted in turn
+   n = splitDatagram(length, 1480, FALSE);
+   received = sendFragments(interface, socket, FALSE, 101, length, n);
+
+   checkResult("IPv4: remaining datagram completed after eviction",
+      received == 4000 && checkPayload(8, 4000) &&
+      countIpv4FragQueue(interface, 102) == 0 &&
+      countIpv4FragQueue(interface, 0) == 4);
+
+   //Wait for the reassembly timeout to expire
+   osDelayTask(IPV4_FRAG_TIME_TO_LIVE + 3 * IPV4_FRAG_TICK_INTERVAL);
+
+   checkResult("IPv4: incomplete datagrams discarded on timeout",
+      countIpv4FragQueue(interface, 0) == 0 &&
+      interface->ipv4Context.fragMemUsage == 0);
+
+   checkResult("IPv4: ICMP Time Exceeded sent for each datagram",
+      timeExceededCount == 4);
+}
+
+
+/**
+ * @brief Reassembly of IPv6 datagrams
+ * @param[in] interface Underlying network interface
+ * @param[in] socket UDP socket
+ **/
+
+void checkIpv6Reassembly(NetInterface *interface, Socket *socket)
+{
+   uint_t n;
+   size_t length;
+   size_t received;
+
+   //In-order fragments
+   length = formatUdpDatagram(interface, 11, 4000, TRUE);
+   n = splitDatagram(length, 1448, FALSE);
+   received = sendFragments(interface, socket, TRUE, 11, length, n);
+
+   checkResult("IPv6: in-order fragments", received == 4000 &&
+      checkPayload(11, 4000));
+
+   //Out-of-order fragments
+   length = formatUdpDatagram(interface, 12, 4000, TRUE);
+   n = splitDatagram(length, 1448, TRUE);
+   received = sendFragments(interface, socket, TRUE, 12, length, n);
+
+   checkResult("IPv6: out-of-order fragments", received == 4000 &&
+      checkPayload(12, 4000));
+
+   //Duplicate fragments (the datagram must be delivered once)
+   length = formatUdpDatagram(interface, 13, 4000, TRUE);
+   splitDatagram(length, 1448, FALSE);
+   fragSpec[4] = fragSpec[2];
+   fragSpec[2] = fragSpec[0];
+   fragSpec[3] = fragSpec[1];
+   received = sendFragments(interface, socket, TRUE, 13, length, 5);
+
+   checkResult("IPv6: duplicate fragments", received == 4000 &&
+      checkPayload(13, 4000) &&
+      sendFragments(interface, socket, TRUE, 13, length, 0) == 0);
+
+   //More fragments than a datagram can have chunks, in reverse order
+   length = formatUdpDatagram(interface, 14, 3000, TRUE);
+   n = splitDatagram(length, 8, TRUE);
+   received = sendFragments(interface, socket, TRUE, 14, length, n);
+
+   checkResult("IPv6: 376 fragments of 8 bytes, in reverse order",
+      received == 3000 && checkPayload(14, 3000));
+
+   //The reassembly queue must be empty
+   checkResult("IPv6: reassembly queue released",
+      interface->ipv6Context.fragMemUsage == 0);
+
+   //Overlapping fragments cause the whole datagram to be discarded
+   //(refer to RFC 5722)
+   length = formatUdpDatagram(interface, 15, 4000, TRUE);
+   splitDatagram(length, 1448, FALSE);
+   fragSpec[3] = fragSpec[2];
+   fragSpec[2] = fragSpec[1];
+   fragSpec[1].first = 1000;
+   fragSpec[1].length = 1448;
+   received = sendFragments(interface, socket, TRUE, 15, length, 2);
+
+   checkResult("IPv6: overlapping fragment discards the datagram",
+      received == 0 && interface->ipv6Context.fragMemUsage == 0);
+
+   //The fragments that follow cannot complete the datagram
+   fragSpec[0] = fragSpec[2];
+   fragSpec[1] = fragSpec[3];
+   received = sendFragments(interface, socket, TRUE, 15, length, 2);
+
+   checkResult("IPv6: no delivery after an overlapping fragment",
+      received == 0);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   NetInterface *interface;
+   Socket *udpSocket;
+   Socket *tcpSocket;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   Ipv6Addr ipv6Addr;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Fragment Reassembly Check ***\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //Set IPv6 link-local address
+   ipv6StringToAddr(APP_IPV6_LINK_LOCAL_ADDR, &ipv6Addr);
+   ipv6SetLinkLocalAddr(interface, &ipv6Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpv4Addr);
+   ipv6StringToAddr(APP_PEER_IPV6_ADDR, &peerIpv6Addr);
+   arpAddStaticEntry(interface, peerIpv4Addr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a UDP socket
+   udpSocket = socketOpen(SOCKET_TYPE_DGRAM, SOCKET_IP_PROTO_UDP);
+   socketSetTimeout(udpSocket, 0);
+   socketBind(udpSocket, &IP_ADDR_ANY, APP_UDP_PORT);
+
+   //Open a listening socket
+   tcpSocket = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketSetTimeout(tcpSocket, 1000);
+   socketBind(tcpSocket, &IP_ADDR_ANY, APP_TCP_PORT);
+   socketListen(tcpSocket, 1);
+
+   //Run the checks
+   checkIpv4Reassembly(interface, udpSocket);
+   checkIpv4SplitHeader(interface, tcpSocket);
+   checkIpv4MemoryLimit(interface, udpSocket);
+   checkIpv6Reassembly(interface, udpSocket);
+
+   //Close sockets
+   socketClose(tcpSocket);
+   socketClose(udpSocket);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,635 @@
+/**
+ * @file main.c
+ * @brief IPv4 forwarding benchmark
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Two virtual Ethernet interfaces are connected by the IPv4 router. A large
+ * routing table is installed, then small packets are injected on the first
+ * interface as if they had been received by the NIC, and the number of
+ * packets forwarded to the second interface per second is reported. A packet
+ * larger than the MTU of the second interface is also forwarded, so as to
+ * check the fragments generated by the router
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "ipv4/ipv4_routing.h"
+#include "ipv4/arp_cache.h"
+#include "debug.h"
+
+//First interface configuration
+#define APP_IF1_NAME "eth0"
+#define APP_IF1_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IF1_IPV4_HOST_ADDR "192.168.1.1"
+
+//Second interface configuration
+#define APP_IF2_NAME "eth1"
+#define APP_IF2_MAC_ADDR "00-AB-CD-EF-00-02"
+#define APP_IF2_IPV4_HOST_ADDR "192.168.2.1"
+#define APP_IF2_MTU 576
+
+//Subnet mask of both interfaces
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Hosts attached to the router
+#define APP_SRC_HOST_MAC_ADDR "00-11-22-33-44-01"
+#define APP_SRC_HOST_IPV4_ADDR "192.168.1.2"
+#define APP_NEXT_HOP_MAC_ADDR "00-11-22-33-44-02"
+#define APP_NEXT_HOP_IPV4_ADDR "192.168.2.254"
+
+//Benchmark configuration
+#define APP_ROUTE_COUNT 1024
+#define APP_FLOW_COUNT 64
+#define APP_FRAME_SIZE 64
+#define APP_FRAME_COUNT 1000000
+#define APP_LARGE_PACKET_SIZE 1400
+#define APP_MAX_FRAGMENTS 8
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+uint32_t txFrameCount[NET_INTERFACE_COUNT];
+bool_t captureEnabled;
+uint_t captureCount;
+size_t capturedLengths[APP_MAX_FRAGMENTS];
+uint8_t capturedFrames[APP_MAX_FRAGMENTS][ETH_MAX_FRAME_SIZE];
+uint8_t frames[APP_FLOW_COUNT][APP_FRAME_SIZE];
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller with a reduced MTU
+ **/
+
+const NicDriver benchDriverSmallMtu =
+{
+   NIC_TYPE_ETHERNET,
+   APP_IF2_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   //Count the frames that leave the interface
+   txFrameCount[interface->index]++;
+
+   //Keep a copy of the frames sent on the second interface, if requested
+   if(captureEnabled && interface->index == 1 &&
+      captureCount < APP_MAX_FRAGMENTS)
+   {
+      capturedLengths[captureCount] = netBufferRead(
+         capturedFrames[captureCount], buffer, offset, ETH_MAX_FRAME_SIZE);
+
+      captureCount++;
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format a frame carrying an IPv4 packet sent by the source host
+ * @param[out] frame Buffer where to format the frame
+ * @param[in] destIpAddr Destination IPv4 address
+ * @param[in] options IPv4 options
+ * @param[in] optionLen Length of the options (multiple of 4)
+ * @param[in] length Total length of the IPv4 packet
+ * @return Length of the frame
+ **/
+
+size_t formatFrame(uint8_t *frame, Ipv4Addr destIpAddr,
+   const uint8_t *options, size_t optionLen, size_t length)
+{
+   size_t i;
+   size_t headerLen;
+   Ipv4Addr srcIpAddr;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+
+   //Source host address
+   ipv4StringToAddr(APP_SRC_HOST_IPV4_ADDR, &srcIpAddr);
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Length of the IPv4 header
+   headerLen = sizeof(Ipv4Header) + optionLen;
+
+   //Format Ethernet header
+   macStringToAddr(APP_IF1_MAC_ADDR, &ethHeader->destAddr);
+   macStringToAddr(APP_SRC_HOST_MAC_ADDR, &ethHeader->srcAddr);
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = headerLen / 4;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(length);
+   ipHeader->identification = HTONS(1234);
+   ipHeader->fragmentOffset = 0;
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_UDP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = srcIpAddr;
+   ipHeader->destAddr = destIpAddr;
+   osMemcpy(ipHeader->options, options, optionLen);
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, headerLen);
+
+   //Each byte of the payload is derived from its offset
+   for(i = headerLen; i < length; i++)
+   {
+      ethHeader->data[i] = (uint8_t) i;
+   }
+
+   //Return the length of the frame
+   return sizeof(EthHeader) + length;
+}
+
+
+/**
+ * @brief Configure a network interface
+ * @param[in] interface Underlying network interface
+ * @param[in] name Interface name
+ * @param[in] driver Virtual Ethernet controller
+ * @param[in] macAddr MAC address
+ * @param[in] ipAddr IPv4 host address
+ * @return Error code
+ **/
+
+error_t configInterface(NetInterface *interface, const char_t *name,
+   const NicDriver *driver, const char_t *macAddr, const char_t *ipAddr)
+{
+   error_t error;
+   MacAddr addr;
+   Ipv4Addr ipv4Addr;
+
+   //Set interface name
+   netSetInterfaceName(interface, name);
+   //Select the relevant network adapter
+   netSetDriver(interface, driver);
+   //Set host MAC address
+   macStringToAddr(macAddr, &addr);
+   netSetMacAddr(interface, &addr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(ipAddr, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //Packets can be forwarded to or from the interface
+   return ipv4EnableRouting(interface, TRUE);
+}
+
+
+/**
+ * @brief Install the routing table
+ * @param[in] interface Outgoing network interface
+ * @return Error code
+ **/
+
+error_t addRoutes(NetInterface *interface)
+{
+   error_t error;
+   uint_t i;
+   Ipv4Addr nextHop;
+
+   //Initialize status code
+   error = NO_ERROR;
+
+   //All the routes point to the same next hop
+   ipv4StringToAddr(APP_NEXT_HOP_IPV4_ADDR, &nextHop);
+
+   //The /24 routes span several /16 blocks
+   for(i = 0; i < APP_ROUTE_COUNT && !error; i++)
+   {
+      error = ipv4AddRoute(IPV4_ADDR(10, i >> 8, i & 0xFF, 0),
+         IPV4_ADDR(255, 255, 255, 0), interface, nextHop, 0);
+   }
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Check the fragments of a forwarded packet
+ * @param[in] options Options of the original packet
+ * @param[in] optionLen Length of the options
+ * @param[in] copiedOptions Options expected in the subsequent fragments
+ * @param[in] copiedOptionLen Length of the copied options
+ * @return TRUE if the fragments are consistent, else FALSE
+ **/
+
+bool_t checkFragments(const uint8_t *options, size_t optionLen,
+   const uint8_t *copiedOptions, size_t copiedOptionLen)
+{
+   uint_t i;
+   size_t j;
+   size_t n;
+   size_t offset;
+   size_t headerLen;
+   Ipv4Header *ipHeader;
+
+   //Offset of the next fragment
+   offset = 0;
+
+   //Loop through the fragments
+   for(i = 0; i < captureCount; i++)
+   {
+      //Point to the IPv4 header
+      ipHeader = (Ipv4Header *) (capturedFrames[i] + sizeof(EthHeader));
+      headerLen = ipHeader->headerLength * 4;
+
+      //Check the header checksum
+      if(ipCalcChecksum(ipHeader, headerLen) != 0x0000)
+         return FALSE;
+
+      //The first fragment carries all the options, the subsequent fragments
+      //only carry the options whose copied flag is set
+      if(i == 0)
+      {
+         if(headerLen != (sizeof(Ipv4Header) + optionLen) ||
+            osMemcmp(ipHeader->options, options, optionLen) != 0)
+         {
+            return FALSE;
+         }
+      }
+      else
+      {
+         if(headerLen != (sizeof(Ipv4Header) + copiedOptionLen) ||
+            osMemcmp(ipHeader->options, copiedOptions, copiedOptionLen) != 0)
+         {
+            return FALSE;
+         }
+      }
+
+      //Fragments must be contiguous
+      if((ntohs(ipHeader->fragmentOffset) & IPV4_OFFSET_MASK) * 8 != offset)
+         return FALSE;
+
+      //Length of the payload
+      n = ntohs(ipHeader->totalLength) - headerLen;
+
+      //Check the payload
+      for(j = 0; j < n; j++)
+      {
+         if(((uint8_t *) ipHeader)[headerLen + j] !=
+            (uint8_t) (sizeof(Ipv4Header) + optionLen + offset + j))
+         {
+            return FALSE;
+         }
+      }
+
+      //All fragments but the last one have the MF flag set
+      if(((ntohs(ipHeader->fragmentOffset) & IPV4_FLAG_MF) != 0) !=
+         (i < (captureCount - 1)))
+      {
+         return FALSE;
+      }
+
+      //Next fragment
+      offset += n;
+   }
+
+   //The whole payload must have been forwarded
+   return (offset == (APP_LARGE_PACKET_SIZE - sizeof(Ipv4Header) - optionLen));
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   uint_t i;
+   size_t length;
+   systime_t startTime;
+   systime_t elapsedTime;
+   uint32_t forwarded;
+   bool_t fragmentsOk;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetRxAncillary ancillary;
+   static uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Router alert (copied) followed by padding that is not copied
+   static const uint8_t options[8] = {IPV4_OPTION_RTRALT, 4, 0, 0,
+      IPV4_OPTION_NOP, IPV4_OPTION_NOP, IPV4_OPTION_NOP, IPV4_OPTION_EEOL};
+   static const uint8_t copiedOptions[4] = {IPV4_OPTION_RTRALT, 4, 0, 0};
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("*** CycloneTCP IPv4 Forwarding Benchmark ***\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the interfaces of the router
+   error = configInterface(&netInterface[0], APP_IF1_NAME, &benchDriver,
+      APP_IF1_MAC_ADDR, APP_IF1_IPV4_HOST_ADDR);
+
+   if(!error)
+   {
+      error = configInterface(&netInterface[1], APP_IF2_NAME,
+         &benchDriverSmallMtu, APP_IF2_MAC_ADDR, APP_IF2_IPV4_HOST_ADDR);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interfaces!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Wait for the virtual links to come up
+   while(!netInterface[0].linkState || !netInterface[1].linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //The next hop is reachable without address resolution
+   macStringToAddr(APP_NEXT_HOP_MAC_ADDR, &macAddr);
+   ipv4StringToAddr(APP_NEXT_HOP_IPV4_ADDR, &ipv4Addr);
+   arpAddStaticEntry(&netInterface[1], ipv4Addr, &macAddr);
+
+   //Install the routing table
+   error = addRoutes(&netInterface[1]);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to add routes!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //A host route in another /8 block needs more trie nodes than available
+   error = ipv4AddRoute(IPV4_ADDR(172, 16, 1, 1), IPV4_ADDR(255, 255, 255, 255),
+      &netInterface[1], ipv4Addr, 0);
+
+   TRACE_PRINTF("Routes installed: %u\r\n", (uint_t) APP_ROUTE_COUNT);
+   TRACE_PRINTF("Route beyond trie capacity rejected: %s\r\n",
+      (error == ERROR_OUT_OF_RESOURCES) ? "yes" : "no");
+
+   //Each flow targets a different route
+   for(i = 0; i < APP_FLOW_COUNT; i++)
+   {
+      formatFrame(frames[i], IPV4_ADDR(10, (i * 17) >> 8 & 0x03, (i * 17) & 0xFF,
+         1), NULL, 0, APP_FRAME_SIZE - sizeof(EthHeader));
+   }
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Reset statistics
+   txFrameCount[1] = 0;
+
+   //Save current time
+   startTime = osGetSystemTime();
+
+   //Inject frames on the first interface
+   for(i = 0; i < APP_FRAME_COUNT; i++)
+   {
+      //Additional options passed to the stack along with the frame
+      ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+      //Process the frame
+      nicProcessPacket(&netInterface[0], frames[i % APP_FLOW_COUNT],
+         APP_FRAME_SIZE, &ancillary);
+   }
+
+   //Measure elapsed time
+   elapsedTime = osGetSystemTime() - startTime;
+   forwarded = txFrameCount[1];
+
+   //Forward a packet that must be fragmented
+   length = formatFrame(frame, IPV4_ADDR(10, 0, 1, 1), options,
+      sizeof(options), APP_LARGE_PACKET_SIZE);
+
+   captureEnabled = TRUE;
+   captureCount = 0;
+
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+   nicProcessPacket(&netInterface[0], frame, length, &ancillary);
+
+   captureEnabled = FALSE;
+
+   //Check the resulting fragments
+   fragmentsOk = captureCount > 1 && checkFragments(options, sizeof(options),
+      copiedOptions, sizeof(copiedOptions));
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Avoid division by zero
+   elapsedTime = MAX(elapsedTime, 1);
+
+   //Display benchmark results
+   TRACE_PRINTF("Packets injected: %u\r\n", (uint_t) APP_FRAME_COUNT);
+   TRACE_PRINTF("Packets forwarded: %" PRIu32 "\r\n", forwarded);
+   TRACE_PRINTF("Elapsed time: %" PRIu32 " ms\r\n", (uint32_t) elapsedTime);
+   TRACE_PRINTF("Throughput: %" PRIu32 " packets/s\r\n",
+      (uint32_t) ((uint64_t) forwarded * 1000 / elapsedTime));
+   TRACE_PRINTF("Fragments of a %u-byte packet: %u (%s)\r\n",
+      (uint_t) APP_LARGE_PACKET_SIZE, captureCount, fragmentsOk ? "OK" : "invalid");
+
+   //Successful processing
+   return (forwarded == APP_FRAME_COUNT && fragmentsOk &&
+      error == ERROR_OUT_OF_RESOURCES) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,485 @@
+/**
+ * @file main.c
+ * @brief IPv6 forwarding benchmark
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Two virtual Ethernet interfaces are connected by the IPv6 router. Small
+ * packets are injected on the first interface as if they had been received
+ * by the NIC, and the number of packets forwarded to the second interface
+ * per second is reported. Once the next-hop cache is warm, the Neighbor
+ * cache is not searched anymore, so the benchmark also checks that the
+ * Neighbor cache entry of the next hop is still refreshed in the LRU list
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "ipv6/ipv6_routing.h"
+#include "ipv6/ndp.h"
+#include "debug.h"
+
+//First interface configuration
+#define APP_IF1_NAME "eth0"
+#define APP_IF1_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IF1_IPV6_LINK_LOCAL_ADDR "fe80::a"
+
+//Second interface configuration
+#define APP_IF2_NAME "eth1"
+#define APP_IF2_MAC_ADDR "00-AB-CD-EF-00-02"
+#define APP_IF2_IPV6_LINK_LOCAL_ADDR "fe80::b"
+
+//Hosts attached to the router
+#define APP_SRC_HOST_MAC_ADDR "00-11-22-33-44-01"
+#define APP_SRC_HOST_IPV6_ADDR "2001:db8:1::2"
+#define APP_NEXT_HOP_MAC_ADDR "00-11-22-33-44-02"
+#define APP_NEXT_HOP_IPV6_ADDR "fe80::2"
+
+//Benchmark configuration
+#define APP_ROUTE_COUNT 64
+#define APP_NEIGHBOR_COUNT 3
+#define APP_FLOW_COUNT 16
+#define APP_FRAME_SIZE 78
+#define APP_FRAME_COUNT 1000000
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+uint32_t txFrameCount[NET_INTERFACE_COUNT];
+uint8_t frames[APP_FLOW_COUNT][APP_FRAME_SIZE];
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   //Count the frames that leave the interface
+   txFrameCount[interface->index]++;
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format a frame carrying an IPv6 packet sent by the source host
+ * @param[out] frame Buffer where to format the frame
+ * @param[in] destIpAddr Destination IPv6 address
+ * @return Length of the frame
+ **/
+
+size_t formatFrame(uint8_t *frame, const Ipv6Addr *destIpAddr)
+{
+   EthHeader *ethHeader;
+   Ipv6Header *ipHeader;
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv6Header *) ethHeader->data;
+
+   //Format Ethernet header
+   macStringToAddr(APP_IF1_MAC_ADDR, &ethHeader->destAddr);
+   macStringToAddr(APP_SRC_HOST_MAC_ADDR, &ethHeader->srcAddr);
+   ethHeader->type = HTONS(ETH_TYPE_IPV6);
+
+   //Format IPv6 header
+   osMemset(ipHeader, 0, sizeof(Ipv6Header));
+   ipHeader->version = IPV6_VERSION;
+   ipHeader->payloadLen = htons(APP_FRAME_SIZE - sizeof(EthHeader) -
+      sizeof(Ipv6Header));
+   ipHeader->nextHeader = IPV6_UDP_HEADER;
+   ipHeader->hopLimit = 64;
+   ipv6StringToAddr(APP_SRC_HOST_IPV6_ADDR, &ipHeader->srcAddr);
+   ipHeader->destAddr = *destIpAddr;
+
+   //Dummy payload
+   osMemset(ipHeader->payload, 0, APP_FRAME_SIZE - sizeof(EthHeader) -
+      sizeof(Ipv6Header));
+
+   //Return the length of the frame
+   return APP_FRAME_SIZE;
+}
+
+
+/**
+ * @brief Configure a network interface
+ * @param[in] interface Underlying network interface
+ * @param[in] name Interface name
+ * @param[in] macAddr MAC address
+ * @param[in] ipAddr IPv6 link-local address
+ * @return Error code
+ **/
+
+error_t configInterface(NetInterface *interface, const char_t *name,
+   const char_t *macAddr, const char_t *ipAddr)
+{
+   error_t error;
+   MacAddr addr;
+   Ipv6Addr ipv6Addr;
+
+   //Set interface name
+   netSetInterfaceName(interface, name);
+   //Select the relevant network adapter
+   netSetDriver(interface, &benchDriver);
+   //Set host MAC address
+   macStringToAddr(macAddr, &addr);
+   netSetMacAddr(interface, &addr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //Set link-local address
+   ipv6StringToAddr(ipAddr, &ipv6Addr);
+   ipv6SetLinkLocalAddr(interface, &ipv6Addr);
+
+   //Packets can be forwarded to or from the interface
+   return ipv6EnableRouting(interface, TRUE);
+}
+
+
+/**
+ * @brief Build the destination address of a flow
+ * @param[in] index Index of the flow
+ * @param[out] ipAddr Destination IPv6 address
+ **/
+
+void getFlowAddr(uint_t index, Ipv6Addr *ipAddr)
+{
+   //Each flow targets a different /64 route
+   ipv6StringToAddr("2001:db8:100::1", ipAddr);
+   ipAddr->w[3] = htons(index * (APP_ROUTE_COUNT / APP_FLOW_COUNT));
+}
+
+
+/**
+ * @brief Forward a given number of frames
+ * @param[in] count Number of frames to inject
+ * @return Number of frames forwarded to the second interface
+ **/
+
+uint32_t forwardFrames(uint_t count)
+{
+   uint_t i;
+   NetRxAncillary ancillary;
+
+   //Reset statistics
+   txFrameCount[1] = 0;
+
+   //Inject frames on the first interface
+   for(i = 0; i < count; i++)
+   {
+      //Additional options passed to the stack along with the frame
+      ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+      //Process the frame
+      nicProcessPacket(&netInterface[0], frames[i % APP_FLOW_COUNT],
+         APP_FRAME_SIZE, &ancillary);
+   }
+
+   //Return the number of forwarded frames
+   return txFrameCount[1];
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   uint_t i;
+   systime_t startTime;
+   systime_t elapsedTime;
+   uint32_t forwarded;
+   bool_t lruOk;
+   MacAddr macAddr;
+   Ipv6Addr ipv6Addr;
+   Ipv6Addr nextHop;
+   NdpNeighborCacheEntry *entry;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("*** CycloneTCP IPv6 Forwarding Benchmark ***\r\n");
+   TRACE_INFO("********************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the interfaces of the router
+   error = configInterface(&netInterface[0], APP_IF1_NAME, APP_IF1_MAC_ADDR,
+      APP_IF1_IPV6_LINK_LOCAL_ADDR);
+
+   if(!error)
+   {
+      error = configInterface(&netInterface[1], APP_IF2_NAME,
+         APP_IF2_MAC_ADDR, APP_IF2_IPV6_LINK_LOCAL_ADDR);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interfaces!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Wait for the virtual links to come up and for the link-local addresses
+   //to become usable
+   while(ipv6GetLinkLocalAddrState(&netInterface[0]) != IPV6_ADDR_STATE_PREFERRED ||
+      ipv6GetLinkLocalAddrState(&netInterface[1]) != IPV6_ADDR_STATE_PREFERRED)
+   {
+      osDelayTask(10);
+   }
+
+   //The next hop is reachable without address resolution
+   macStringToAddr(APP_NEXT_HOP_MAC_ADDR, &macAddr);
+   ipv6StringToAddr(APP_NEXT_HOP_IPV6_ADDR, &nextHop);
+   ndpAddStaticEntry(&netInterface[1], &nextHop, &macAddr);
+
+   //Install the routing table
+   for(i = 0; i < APP_ROUTE_COUNT && !error; i++)
+   {
+      ipv6StringToAddr("2001:db8:100::", &ipv6Addr);
+      ipv6Addr.w[3] = htons(i);
+
+      error = ipv6AddRoute(&ipv6Addr, 64, &netInterface[1], &nextHop, 0);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to add routes!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Format the frames of each flow
+   for(i = 0; i < APP_FLOW_COUNT; i++)
+   {
+      getFlowAddr(i, &ipv6Addr);
+      formatFrame(frames[i], &ipv6Addr);
+   }
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Warm up the next-hop cache
+   forwardFrames(APP_FLOW_COUNT);
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Other neighbors become more recently used than the next hop
+   for(i = 0; i < APP_NEIGHBOR_COUNT; i++)
+   {
+      ipv6Addr = nextHop;
+      ipv6Addr.b[15] += i + 1;
+      ndpAddStaticEntry(&netInterface[1], &ipv6Addr, &macAddr);
+   }
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Save current time
+   startTime = osGetSystemTime();
+
+   //Forward frames using the next-hop cache
+   forwarded = forwardFrames(APP_FRAME_COUNT);
+
+   //Measure elapsed time
+   elapsedTime = osGetSystemTime() - startTime;
+
+   //The next hop must be the most recently used neighbor
+   entry = netInterface[1].ndpContext.neighborLruHead;
+   lruOk = (entry != NULL && ipv6CompAddr(&entry->ipAddr, &nextHop));
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Avoid division by zero
+   elapsedTime = MAX(elapsedTime, 1);
+
+   //Display benchmark results
+   TRACE_PRINTF("Routes installed: %u\r\n", (uint_t) APP_ROUTE_COUNT);
+   TRACE_PRINTF("Packets injected: %u\r\n", (uint_t) APP_FRAME_COUNT);
+   TRACE_PRINTF("Packets forwarded: %" PRIu32 "\r\n", forwarded);
+   TRACE_PRINTF("Elapsed time: %" PRIu32 " ms\r\n", (uint32_t) elapsedTime);
+   TRACE_PRINTF("Throughput: %" PRIu32 " packets/s\r\n",
+      (uint32_t) ((uint64_t) forwarded * 1000 / elapsedTime));
+   TRACE_PRINTF("Next hop refreshed in the Neighbor cache: %s\r\n",
+      lruOk ? "yes" : "no");
+
+   //Successful processing
+   return (forwarded == APP_FRAME_COUNT && lruOk) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,745 @@
+/**
+ * @file main.c
+ * @brief Link aggregation check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Two aggregators of two member ports each are connected back-to-back by
+ * virtual Ethernet links. The check waits for LACP to bring both members
+ * into the distributing state, then verifies that the layer 3+4 hash
+ * policy spreads the flows of a VLAN across the members, that all the
+ * fragments of a datagram are sent through the same member, and that the
+ * aggregators survive the loss and the recovery of a link, as well as a
+ * partner that stops sending LACPDUs
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "lag/lag.h"
+#include "debug.h"
+
+//Member ports configuration
+#define APP_PORT_COUNT 4
+#define APP_PORT_NAME "eth%u"
+#define APP_PORT_MAC_ADDR "00-AB-CD-EF-00-0%u"
+
+//Aggregators configuration
+#define APP_LAG1_NAME "bond0"
+#define APP_LAG1_MAC_ADDR "02-AB-CD-EF-01-00"
+#define APP_LAG2_NAME "bond1"
+#define APP_LAG2_MAC_ADDR "02-AB-CD-EF-02-00"
+
+//Check configuration
+#define APP_FLOW_COUNT 256
+#define APP_VLAN_ID 10
+#define APP_PAYLOAD_SIZE 64
+#define APP_QUEUE_SIZE 32
+#define APP_TIMEOUT 10000
+
+//Frame in flight on a virtual link
+typedef struct
+{
+   uint_t port;
+   size_t length;
+   uint8_t data[ETH_MAX_FRAME_SIZE];
+} WireFrame;
+
+//Forward declaration of functions
+error_t wireDriverInit(NetInterface *interface);
+void wireDriverTick(NetInterface *interface);
+void wireDriverEnableIrq(NetInterface *interface);
+void wireDriverDisableIrq(NetInterface *interface);
+void wireDriverEventHandler(NetInterface *interface);
+
+error_t wireDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t wireDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+LagContext lagContext[2];
+NetInterface *lagPorts[2][2];
+WireFrame wireQueue[APP_QUEUE_SIZE];
+uint_t wireQueueHead;
+uint_t wireQueueLength;
+bool_t wireUp[APP_PORT_COUNT] = {TRUE, TRUE, TRUE, TRUE};
+bool_t wireMute[APP_PORT_COUNT];
+const uint_t wirePeer[APP_PORT_COUNT] = {2, 3, 0, 1};
+uint32_t txFrameCount[NET_INTERFACE_COUNT];
+uint_t lastTxPort;
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver wireDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   wireDriverInit,
+   wireDriverTick,
+   wireDriverEnableIrq,
+   wireDriverDisableIrq,
+   wireDriverEventHandler,
+   wireDriverSendPacket,
+   wireDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t wireDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverTick(NetInterface *interface)
+{
+   //Link state change?
+   if(interface->linkState != wireUp[interface->index])
+   {
+      //Update link state
+      interface->linkState = wireUp[interface->index];
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void wireDriverEventHandler(NetInterface *interface)
+{
+   //Poll the link state
+   wireDriverTick(interface);
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * LACPDUs are queued so that they can be delivered to the peer port, unless
+ * the port is muted. Other frames are only counted
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t wireDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   WireFrame *frame;
+   EthHeader *ethHeader;
+
+   //Count the frames that leave the interface
+   txFrameCount[interface->index]++;
+   //Keep track of the member used by the last frame
+   lastTxPort = interface->index;
+
+   //Frames are lost when the link is down
+   if(wireUp[interface->index] && wireQueueLength < APP_QUEUE_SIZE)
+   {
+      //Point to the tail of the queue
+      frame = &wireQueue[(wireQueueHead + wireQueueLength) % APP_QUEUE_SIZE];
+
+      //Copy the frame
+      frame->length = netBufferRead(frame->data, buffer, offset,
+         ETH_MAX_FRAME_SIZE);
+
+      //Point to the Ethernet header
+      ethHeader = (EthHeader *) frame->data;
+
+      //Slow protocols frame?
+      if(frame->length >= sizeof(EthHeader) &&
+         ethHeader->type == HTONS(ETH_TYPE_SLOW) &&
+         !wireMute[interface->index])
+      {
+         //The frame is received by the peer port
+         frame->port = wirePeer[interface->index];
+         wireQueueLength++;
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t wireDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Deliver the frames in flight for a given amount of time
+ * @param[in] delay Amount of time, in milliseconds
+ **/
+
+void deliverFrames(systime_t delay)
+{
+   systime_t startTime;
+   WireFrame frame;
+   NetRxAncillary ancillary;
+
+   //Save current time
+   startTime = osGetSystemTime();
+
+   do
+   {
+      //Get exclusive access
+      osAcquireMutex(&netMutex);
+
+      //Process the frames in flight
+      while(wireQueueLength > 0)
+      {
+         //Remove the frame from the head of the queue
+         frame = wireQueue[wireQueueHead];
+         wireQueueHead = (wireQueueHead + 1) % APP_QUEUE_SIZE;
+         wireQueueLength--;
+
+         //Additional options passed to the stack along with the frame
+         ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+         //Pass the frame to the peer port
+         nicProcessPacket(&netInterface[frame.port], frame.data, frame.length,
+            &ancillary);
+      }
+
+      //Release exclusive access
+      osReleaseMutex(&netMutex);
+
+      //Let the TCP/IP stack run LACP
+      osDelayTask(10);
+
+      //Loop until the delay has elapsed
+   } while((osGetSystemTime() - startTime) < delay);
+}
+
+
+/**
+ * @brief Wait for both aggregators to distribute over a given number of ports
+ * @param[in] numPorts Expected number of distributing ports
+ * @return TRUE if the aggregators converged before the timeout
+ **/
+
+bool_t waitForAggregation(uint_t numPorts)
+{
+   systime_t startTime;
+
+   //Save current time
+   startTime = osGetSystemTime();
+
+   //Run LACP until the aggregators agree on the expected state
+   while(lagContext[0].numActivePorts != numPorts ||
+      lagContext[1].numActivePorts != numPorts ||
+      !netInterface[APP_PORT_COUNT].linkState ||
+      !netInterface[APP_PORT_COUNT + 1].linkState)
+   {
+      //Timeout error?
+      if((osGetSystemTime() - startTime) >= APP_TIMEOUT)
+         return FALSE;
+
+      //Deliver LACPDUs
+      deliverFrames(100);
+   }
+
+   //The aggregators have converged
+   return TRUE;
+}
+
+
+/**
+ * @brief Format a UDP datagram, or a fragment of it, sent by the first
+ *   aggregator
+ * @param[out] frame Buffer where to format the frame
+ * @param[in] tagged Insert an 802.1Q tag
+ * @param[in] flow Index of the flow
+ * @param[in] fragmentOffset Fragment offset and flags
+ * @return Length of the frame
+ **/
+
+size_t formatFrame(uint8_t *frame, bool_t tagged, uint_t flow,
+   uint16_t fragmentOffset)
+{
+   size_t length;
+   EthHeader *ethHeader;
+   VlanTag *vlanTag;
+   Ipv4Header *ipHeader;
+   UdpHeader *udpHeader;
+   Ipv4Addr ipAddr;
+
+   //Point to the Ethernet header
+   ethHeader = (EthHeader *) frame;
+   length = sizeof(EthHeader);
+
+   //Format Ethernet header
+   macStringToAddr(APP_LAG2_MAC_ADDR, &ethHeader->destAddr);
+   macStringToAddr(APP_LAG1_MAC_ADDR, &ethHeader->srcAddr);
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Frame sent on a VLAN?
+   if(tagged)
+   {
+      //Format VLAN tag
+      vlanTag = (VlanTag *) (frame + length);
+      vlanTag->tci = HTONS(APP_VLAN_ID);
+      vlanTag->type = ethHeader->type;
+      ethHeader->type = HTONS(ETH_TYPE_VLAN);
+      length += sizeof(VlanTag);
+   }
+
+   //Format IPv4 header
+   ipHeader = (Ipv4Header *) (frame + length);
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + APP_PAYLOAD_SIZE);
+   ipHeader->identification = htons(flow);
+   ipHeader->fragmentOffset = htons(fragmentOffset);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_UDP;
+   ipHeader->headerChecksum = 0;
+   ipv4StringToAddr("192.168.1.1", &ipAddr);
+   ipHeader->srcAddr = ipAddr;
+   ipv4StringToAddr("192.168.1.2", &ipAddr);
+   ipHeader->destAddr = ipAddr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+   length += sizeof(Ipv4Header);
+
+   //The payload of later fragments looks like arbitrary ports
+   osMemset(frame + length, (uint8_t) flow, APP_PAYLOAD_SIZE);
+
+   //The UDP header is located in the first fragment
+   if((fragmentOffset & IPV4_OFFSET_MASK) == 0)
+   {
+      //Format UDP header
+      udpHeader = (UdpHeader *) (frame + length);
+      udpHeader->srcPort = htons(1024 + flow);
+      udpHeader->destPort = HTONS(53);
+      udpHeader->length = HTONS(APP_PAYLOAD_SIZE);
+      udpHeader->checksum = 0;
+   }
+
+   //Return the length of the frame
+   return length + APP_PAYLOAD_SIZE;
+}
+
+
+/**
+ * @brief Send a frame through the first aggregator
+ * @param[in] frame Pointer to the frame
+ * @param[in] length Length of the frame
+ * @return Member port the frame was sent through
+ **/
+
+uint_t sendFrame(const uint8_t *frame, size_t length)
+{
+   NetBuffer *buffer;
+   NetTxAncillary ancillary;
+
+   //Allocate a buffer to hold the frame
+   buffer = netBufferAlloc(length);
+
+   //Successful memory allocation?
+   if(buffer != NULL)
+   {
+      //Copy the frame
+      netBufferWrite(buffer, 0, frame, length);
+
+      //Additional options passed to the driver along with the frame
+      ancillary = NET_DEFAULT_TX_ANCILLARY;
+
+      //Let the aggregator select a member port
+      nicSendPacket(&netInterface[APP_PORT_COUNT], buffer, 0, &ancillary);
+
+      //Free previously allocated memory
+      netBufferFree(buffer);
+   }
+
+   //Return the member port used by the frame
+   return lastTxPort;
+}
+
+
+/**
+ * @brief Check that the flows of a VLAN are spread across the members
+ * @return TRUE if both members carry a fair share of the flows
+ **/
+
+bool_t checkVlanDistribution(void)
+{
+   uint_t i;
+   size_t length;
+   uint32_t count[2];
+   static uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Save statistics
+   count[0] = txFrameCount[0];
+   count[1] = txFrameCount[1];
+
+   //Send one tagged frame per flow
+   for(i = 0; i < APP_FLOW_COUNT; i++)
+   {
+      length = formatFrame(frame, TRUE, i, 0);
+      sendFrame(frame, length);
+   }
+
+   //Number of frames sent through each member
+   count[0] = txFrameCount[0] - count[0];
+   count[1] = txFrameCount[1] - count[1];
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Display statistics
+   TRACE_PRINTF("VLAN flows per member: %" PRIu32 " / %" PRIu32 "\r\n",
+      count[0], count[1]);
+
+   //Each member must carry at least a quarter of the flows
+   return count[0] >= (APP_FLOW_COUNT / 4) && count[1] >= (APP_FLOW_COUNT / 4);
+}
+
+
+/**
+ * @brief Check that the fragments of a datagram use the same member
+ * @return TRUE if no datagram was split across the members
+ **/
+
+bool_t checkFragments(void)
+{
+   uint_t i;
+   uint_t port;
+   uint_t mismatches;
+   size_t length;
+   static uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Initialize counter
+   mismatches = 0;
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Send two fragments per datagram
+   for(i = 0; i < APP_FLOW_COUNT; i++)
+   {
+      //The first fragment carries the UDP header
+      length = formatFrame(frame, FALSE, i, IPV4_FLAG_MF);
+      port = sendFrame(frame, length);
+
+      //The last fragment only carries data
+      length = formatFrame(frame, FALSE, i, APP_PAYLOAD_SIZE / 8);
+
+      //Both fragments must be sent through the same member
+      if(sendFrame(frame, length) != port)
+      {
+         mismatches++;
+      }
+   }
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+
+   //Display statistics
+   TRACE_PRINTF("Datagrams split across members: %u\r\n", mismatches);
+
+   //Successful check?
+   return (mismatches == 0);
+}
+
+
+/**
+ * @brief Configure a member port
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t configPort(NetInterface *interface)
+{
+   MacAddr macAddr;
+   char_t buffer[24];
+
+   //Set interface name
+   osSprintf(buffer, APP_PORT_NAME, interface->index);
+   netSetInterfaceName(interface, buffer);
+   //Select the relevant network adapter
+   netSetDriver(interface, &wireDriver);
+
+   //Set host MAC address
+   osSprintf(buffer, APP_PORT_MAC_ADDR, interface->index + 1);
+   macStringToAddr(buffer, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   return netConfigInterface(interface);
+}
+
+
+/**
+ * @brief Configure an aggregator
+ * @param[in] context Pointer to the link aggregation context
+ * @param[in] interface Aggregator interface
+ * @param[in] ports Member interfaces
+ * @param[in] name Interface name
+ * @param[in] macAddr MAC address
+ * @return Error code
+ **/
+
+error_t configAggregator(LagContext *context, NetInterface *interface,
+   NetInterface **ports, const char_t *name, const char_t *macAddr)
+{
+   error_t error;
+   MacAddr addr;
+   LagSettings lagSettings;
+
+   //Get default settings
+   lagGetDefaultSettings(&lagSettings);
+   //Aggregator interface
+   lagSettings.interface = interface;
+   //Flows are identified by their addresses and ports
+   lagSettings.hashPolicy = LAG_HASH_POLICY_LAYER3_4;
+   //Member interfaces
+   lagSettings.numPorts = 2;
+   lagSettings.ports = ports;
+   //Exchange LACPDUs every second
+   lagSettings.fastRate = TRUE;
+
+   //Link aggregation initialization
+   error = lagInit(context, &lagSettings);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //Set interface name
+   netSetInterfaceName(interface, name);
+   //Set host MAC address
+   macStringToAddr(macAddr, &addr);
+   netSetMacAddr(interface, &addr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+      return error;
+
+   //Start link aggregation
+   return lagStart(context);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   uint_t i;
+   bool_t aggregationOk;
+   bool_t distributionOk;
+   bool_t fragmentsOk;
+   bool_t failoverOk;
+   bool_t recoveryOk;
+   bool_t expiryOk;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("*****************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Link Aggregation Check ***\r\n");
+   TRACE_INFO("*****************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the member ports
+   for(i = 0; i < APP_PORT_COUNT && !error; i++)
+   {
+      error = configPort(&netInterface[i]);
+   }
+
+   //The first aggregator bundles ports 0 and 1, the second one ports 2 and 3
+   lagPorts[0][0] = &netInterface[0];
+   lagPorts[0][1] = &netInterface[1];
+   lagPorts[1][0] = &netInterface[2];
+   lagPorts[1][1] = &netInterface[3];
+
+   //Configure the aggregators
+   if(!error)
+   {
+      error = configAggregator(&lagContext[0], &netInterface[APP_PORT_COUNT],
+         lagPorts[0], APP_LAG1_NAME, APP_LAG1_MAC_ADDR);
+   }
+
+   if(!error)
+   {
+      error = configAggregator(&lagContext[1],
+         &netInterface[APP_PORT_COUNT + 1], lagPorts[1], APP_LAG2_NAME,
+         APP_LAG2_MAC_ADDR);
+   }
+
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure link aggregation!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //LACP must bring both members into the distributing state
+   aggregationOk = waitForAggregation(2);
+
+   //Check the transmit hash policy
+   distributionOk = aggregationOk && checkVlanDistribution();
+   fragmentsOk = aggregationOk && checkFragments();
+
+   //Disconnect the second link
+   wireUp[1] = FALSE;
+   wireUp[3] = FALSE;
+
+   //The aggregators must keep running over the first link
+   failoverOk = waitForAggregation(1);
+
+   //Reconnect the second link
+   wireUp[1] = TRUE;
+   wireUp[3] = TRUE;
+
+   //The second link must be attached again
+   recoveryOk = waitForAggregation(2);
+
+   //The partners stop sending LACPDUs over the second link
+   wireMute[1] = TRUE;
+   wireMute[3] = TRUE;
+
+   //The partner information must expire while the link stays up
+   expiryOk = recoveryOk && waitForAggregation(1);
+
+   //Resume LACPDU transmission
+   wireMute[1] = FALSE;
+   wireMute[3] = FALSE;
+
+   //The second link must be attached again
+   expiryOk = expiryOk && waitForAggregation(2);
+
+   //Display results
+   TRACE_PRINTF("Aggregation: %s\r\n", aggregationOk ? "passed" : "failed");
+   TRACE_PRINTF("VLAN distribution: %s\r\n", distributionOk ? "passed" : "failed");
+   TRACE_PRINTF("Fragments: %s\r\n", fragmentsOk ? "passed" : "failed");
+   TRACE_PRINTF("Failover: %s\r\n", failoverOk ? "passed" : "failed");
+   TRACE_PRINTF("Recovery: %s\r\n", recoveryOk ? "passed" : "failed");
+   TRACE_PRINTF("Partner expiry: %s\r\n", expiryOk ? "passed" : "failed");
+
+   //Successful processing?
+   if(aggregationOk && distributionOk && fragmentsOk && failoverOk &&
+      recoveryOk && expiryOk)
+   {
+      return EXIT_SUCCESS;
+   }
+   else
+   {
+      return EXIT_FAILURE;
+   }
+}
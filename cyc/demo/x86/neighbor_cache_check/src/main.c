@@ -0,0 +1,1107 @@
+/**
+ * @file main.c
+ * @brief ARP cache and Neighbor cache check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * The ARP cache and the Neighbor cache are exercised through direct calls.
+ * The hash tables have fewer buckets than there are entries, so that several
+ * entries are chained in each bucket. After every operation, the order of
+ * the LRU list and the contents of the hash buckets are compared with a
+ * reference model of the cache
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "ipv4/arp.h"
+#include "ipv4/arp_cache.h"
+#include "ipv6/ndp.h"
+#include "ipv6/ndp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+
+//Check configuration
+#define APP_KEY_COUNT 24
+#define APP_STATIC_KEY 100
+#define APP_RANDOM_OPS 5000
+#define APP_RANDOM_SEED 1
+
+/**
+ * @brief Operations on a cache
+ **/
+
+typedef struct
+{
+   const char_t *name;
+   uint_t size;
+   void *(*create)(uint_t key);
+   void *(*find)(uint_t key);
+   void (*delete)(void *entry);
+   uint_t (*getHashIndex)(uint_t key);
+   bool_t (*matchModel)(void);
+   error_t (*addStaticEntry)(uint_t key);
+   error_t (*removeStaticEntry)(uint_t key);
+} CacheOps;
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+NetInterface *cacheInterface;
+uint_t modelKey[APP_KEY_COUNT];
+uint_t modelCount;
+uint_t failureCount;
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   //The frame is discarded
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Search the reference model for a given key
+ * @param[in] key Key identifying an address
+ * @return Position of the key (0 for the most recently used entry), or -1 if
+ *   the key is not in the model
+ **/
+
+int_t modelFind(uint_t key)
+{
+   uint_t i;
+
+   //Loop through the model
+   for(i = 0; i < modelCount; i++)
+   {
+      if(modelKey[i] == key)
+         return i;
+   }
+
+   //The key is not in the model
+   return -1;
+}
+
+
+/**
+ * @brief Remove a key from the reference model
+ * @param[in] key Key identifying an address
+ **/
+
+void modelRemove(uint_t key)
+{
+   int_t i;
+
+   //Search the model for the key
+   i = modelFind(key);
+
+   //Any matching key?
+   if(i >= 0)
+   {
+      //Shift the less recently used keys
+      osMemmove(modelKey + i, modelKey + i + 1,
+         (modelCount - i - 1) * sizeof(uint_t));
+
+      modelCount--;
+   }
+}
+
+
+/**
+ * @brief Mark a key as the most recently used one in the reference model
+ *
+ * The least recently used key is evicted when the model is full
+ *
+ * @param[in] key Key identifying an address
+ * @param[in] size Size of the cache
+ **/
+
+void modelTouch(uint_t key, uint_t size)
+{
+   //Remove the key if present
+   modelRemove(key);
+
+   //Evict the least recently used key, if necessary
+   if(modelCount >= size)
+   {
+      modelCount = size - 1;
+   }
+
+   //Insert the key at the head of the model
+   osMemmove(modelKey + 1, modelKey, modelCount * sizeof(uint_t));
+   modelKey[0] = key;
+   modelCount++;
+}
+
+
+/**
+ * @brief Get the IPv4 address associated with a key
+ * @param[in] key Key identifying an address
+ * @return IPv4 address
+ **/
+
+Ipv4Addr arpGetAddr(uint_t key)
+{
+   return IPV4_ADDR(192, 168, key / 250, key % 250 + 1);
+}
+
+
+/**
+ * @brief Create an entry in the ARP cache
+ * @param[in] key Key identifying an address
+ * @return Pointer to the entry
+ **/
+
+void *arpCreate(uint_t key)
+{
+   ArpCacheEntry *entry;
+
+   //Create a new entry
+   entry = arpCreateEntry(cacheInterface, arpGetAddr(key));
+
+   //The address is resolved
+   if(entry != NULL)
+   {
+      arpChangeState(entry, ARP_STATE_REACHABLE);
+   }
+
+   //Return a pointer to the entry
+   return entry;
+}
+
+
+/**
+ * @brief Search the ARP cache
+ * @param[in] key Key identifying an address
+ * @return Pointer to the matching entry, if any
+ **/
+
+void *arpFind(uint_t key)
+{
+   return arpFindEntry(cacheInterface, arpGetAddr(key));
+}
+
+
+/**
+ * @brief Delete an entry from the ARP cache
+ * @param[in] entry Pointer to the entry
+ **/
+
+void arpDelete(void *entry)
+{
+   arpDeleteEntry(cacheInterface, entry);
+}
+
+
+/**
+ * @brief Get the hash bucket of a given key in the ARP cache
+ * @param[in] key Key identifying an address
+ * @return Index of the hash bucket
+ **/
+
+uint_t arpGetBucket(uint_t key)
+{
+   return arpGetHashIndex(arpGetAddr(key));
+}
+
+
+/**
+ * @brief Compare the ARP cache with the reference model
+ * @return TRUE if the cache matches the model, else FALSE
+ **/
+
+bool_t arpMatchModel(void)
+{
+   uint_t i;
+   uint_t n;
+   bool_t linked[ARP_CACHE_SIZE];
+   ArpCacheEntry *entry;
+
+   //The entries in use are ordered from the most recently used one
+   entry = cacheInterface->arpLruHead;
+
+   for(i = 0; i < modelCount; i++, entry = entry->lruNext)
+   {
+      if(entry == NULL || entry->state == ARP_STATE_NONE ||
+         entry->ipAddr != arpGetAddr(modelKey[i]))
+      {
+         return FALSE;
+      }
+   }
+
+   //Free entries are at the tail of the LRU list
+   for(n = i; entry != NULL; n++, entry = entry->lruNext)
+   {
+      if(entry->state != ARP_STATE_NONE || n >= ARP_CACHE_SIZE)
+         return FALSE;
+   }
+
+   //The LRU list links all the entries
+   if(n != ARP_CACHE_SIZE)
+      return FALSE;
+
+   //Each entry in use is linked once, in the bucket of its address
+   osMemset(linked, 0, sizeof(linked));
+
+   for(n = 0, i = 0; i < ARP_HASH_TABLE_SIZE; i++)
+   {
+      for(entry = cacheInterface->arpHashTable[i]; entry != NULL;
+         entry = entry->hashNext, n++)
+      {
+         if(linked[entry - cacheInterface->arpCache] ||
+            entry->state == ARP_STATE_NONE ||
+            arpGetHashIndex(entry->ipAddr) != i)
+         {
+            return FALSE;
+         }
+
+         linked[entry - cacheInterface->arpCache] = TRUE;
+      }
+   }
+
+   //The hash table holds all the entries in use
+   return (n == modelCount);
+}
+
+
+/**
+ * @brief Add a static entry in the ARP cache
+ * @param[in] key Key identifying an address
+ * @return Error code
+ **/
+
+error_t arpAddStatic(uint_t key)
+{
+   error_t error;
+
+   //The function gets exclusive access by itself
+   osReleaseMutex(&netMutex);
+   error = arpAddStaticEntry(cacheInterface, arpGetAddr(key),
+      &MAC_UNSPECIFIED_ADDR);
+   osAcquireMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Remove a static entry from the ARP cache
+ * @param[in] key Key identifying an address
+ * @return Error code
+ **/
+
+error_t arpRemoveStatic(uint_t key)
+{
+   error_t error;
+
+   //The function gets exclusive access by itself
+   osReleaseMutex(&netMutex);
+   error = arpRemoveStaticEntry(cacheInterface, arpGetAddr(key));
+   osAcquireMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Get the IPv6 address associated with a key
+ * @param[in] key Key identifying an address
+ * @return IPv6 address
+ **/
+
+Ipv6Addr ndpGetAddr(uint_t key)
+{
+   Ipv6Addr ipAddr;
+
+   //Build a global address (2001:db8::/64 prefix)
+   ipAddr = IPV6_UNSPECIFIED_ADDR;
+   ipAddr.w[0] = HTONS(0x2001);
+   ipAddr.w[1] = HTONS(0x0DB8);
+   ipAddr.w[7] = htons(key + 1);
+
+   //Return the IPv6 address
+   return ipAddr;
+}
+
+
+/**
+ * @brief Create an entry in the Neighbor cache
+ * @param[in] key Key identifying an address
+ * @return Pointer to the entry
+ **/
+
+void *ndpCreate(uint_t key)
+{
+   Ipv6Addr ipAddr;
+   NdpNeighborCacheEntry *entry;
+
+   //Create a new entry
+   ipAddr = ndpGetAddr(key);
+   entry = ndpCreateNeighborCacheEntry(cacheInterface, &ipAddr);
+
+   //The address is resolved
+   if(entry != NULL)
+   {
+      ndpChangeState(entry, NDP_STATE_REACHABLE);
+   }
+
+   //Return a pointer to the entry
+   return entry;
+}
+
+
+/**
+ * @brief Search the Neighbor cache
+ * @param[in] key Key identifying an address
+ * @return Pointer to the matching entry, if any
+ **/
+
+void *ndpFind(uint_t key)
+{
+   Ipv6Addr ipAddr;
+
+   ipAddr = ndpGetAddr(key);
+   return ndpFindNeighborCacheEntry(cacheInterface, &ipAddr);
+}
+
+
+/**
+ * @brief Delete an entry from the Neighbor cache
+ * @param[in] entry Pointer to the entry
+ **/
+
+void ndpDelete(void *entry)
+{
+   ndpDeleteNeighborCacheEntry(cacheInterface, entry);
+}
+
+
+/**
+ * @brief Get the hash bucket of a given key in the Neighbor cache
+ * @param[in] key Key identifying an address
+ * @return Index of the hash bucket
+ **/
+
+uint_t ndpGetBucket(uint_t key)
+{
+   Ipv6Addr ipAddr;
+
+   ipAddr = ndpGetAddr(key);
+   return ndpGetNeighborHashIndex(&ipAddr);
+}
+
+
+/**
+ * @brief Compare the Neighbor cache with the reference model
+ * @return TRUE if the cache matches the model, else FALSE
+ **/
+
+bool_t ndpMatchModel(void)
+{
+   uint_t i;
+   uint_t n;
+   bool_t linked[NDP_NEIGHBOR_CACHE_SIZE];
+   Ipv6Addr ipAddr;
+   NdpContext *context;
+   NdpNeighborCacheEntry *entry;
+
+   //Point to the NDP context
+   context = &cacheInterface->ndpContext;
+
+   //The entries in use are ordered from the most recently used one
+   entry = context->neighborLruHead;
+
+   for(i = 0; i < modelCount; i++, entry = entry->lruNext)
+   {
+      ipAddr = ndpGetAddr(modelKey[i]);
+
+      if(entry == NULL || entry->state == NDP_STATE_NONE ||
+         !ipv6CompAddr(&entry->ipAddr, &ipAddr))
+      {
+         return FALSE;
+      }
+   }
+
+   //Free entries are at the tail of the LRU list
+   for(n = i; entry != NULL; n++, entry = entry->lruNext)
+   {
+      if(entry->state != NDP_STATE_NONE || n >= NDP_NEIGHBOR_CACHE_SIZE)
+         return FALSE;
+   }
+
+   //The LRU list links all the entries
+   if(n != NDP_NEIGHBOR_CACHE_SIZE)
+      return FALSE;
+
+   //Each entry in use is linked once, in the bucket of its address
+   osMemset(linked, 0, sizeof(linked));
+
+   for(n = 0, i = 0; i < NDP_NEIGHBOR_HASH_TABLE_SIZE; i++)
+   {
+      for(entry = context->neighborHashTable[i]; entry != NULL;
+         entry = entry->hashNext, n++)
+      {
+         if(linked[entry - context->neighborCache] ||
+            entry->state == NDP_STATE_NONE ||
+            ndpGetNeighborHashIndex(&entry->ipAddr) != i)
+         {
+            return FALSE;
+         }
+
+         linked[entry - context->neighborCache] = TRUE;
+      }
+   }
+
+   //The hash table holds all the entries in use
+   return (n == modelCount);
+}
+
+
+/**
+ * @brief Add a static entry in the Neighbor cache
+ * @param[in] key Key identifying an address
+ * @return Error code
+ **/
+
+error_t ndpAddStatic(uint_t key)
+{
+   error_t error;
+   Ipv6Addr ipAddr;
+
+   //The function gets exclusive access by itself
+   ipAddr = ndpGetAddr(key);
+   osReleaseMutex(&netMutex);
+   error = ndpAddStaticEntry(cacheInterface, &ipAddr, &MAC_UNSPECIFIED_ADDR);
+   osAcquireMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief Remove a static entry from the Neighbor cache
+ * @param[in] key Key identifying an address
+ * @return Error code
+ **/
+
+error_t ndpRemoveStatic(uint_t key)
+{
+   error_t error;
+   Ipv6Addr ipAddr;
+
+   //The function gets exclusive access by itself
+   ipAddr = ndpGetAddr(key);
+   osReleaseMutex(&netMutex);
+   error = ndpRemoveStaticEntry(cacheInterface, &ipAddr);
+   osAcquireMutex(&netMutex);
+
+   //Return status code
+   return error;
+}
+
+
+/**
+ * @brief ARP cache operations
+ **/
+
+const CacheOps arpCacheOps =
+{
+   "ARP cache",
+   ARP_CACHE_SIZE,
+   arpCreate,
+   arpFind,
+   arpDelete,
+   arpGetBucket,
+   arpMatchModel,
+   arpAddStatic,
+   arpRemoveStatic
+};
+
+
+/**
+ * @brief Neighbor cache operations
+ **/
+
+const CacheOps ndpCacheOps =
+{
+   "Neighbor cache",
+   NDP_NEIGHBOR_CACHE_SIZE,
+   ndpCreate,
+   ndpFind,
+   ndpDelete,
+   ndpGetBucket,
+   ndpMatchModel,
+   ndpAddStatic,
+   ndpRemoveStatic
+};
+
+
+/**
+ * @brief Delete all the entries of a cache
+ * @param[in] ops Cache operations
+ **/
+
+void flushCache(const CacheOps *ops)
+{
+   uint_t i;
+   void *entry;
+
+   //Loop through the keys
+   for(i = 0; i < APP_KEY_COUNT; i++)
+   {
+      //Delete the entry, if any
+      entry = ops->find(i);
+
+      if(entry != NULL)
+      {
+         ops->delete(entry);
+      }
+   }
+
+   //The model is now empty
+   modelCount = 0;
+}
+
+
+/**
+ * @brief Entries that share a hash bucket
+ * @param[in] ops Cache operations
+ **/
+
+void checkCollisions(const CacheOps *ops)
+{
+   uint_t i;
+   uint_t n;
+   uint_t key[3];
+   bool_t found;
+   char_t name[64];
+
+   //Select three keys that share a hash bucket
+   for(n = 0, i = 1; i < APP_KEY_COUNT && n < 3; i++)
+   {
+      if(ops->getHashIndex(i) == ops->getHashIndex(0))
+      {
+         key[n++] = i;
+      }
+   }
+
+   //Create the entries. Each new entry is inserted at the head of the
+   //bucket, so the bucket lists key[2], key[1] and key[0] in that order
+   for(i = 0; i < n; i++)
+   {
+      ops->create(key[i]);
+      modelTouch(key[i], ops->size);
+   }
+
+   //Each entry can be found
+   for(found = TRUE, i = 0; i < n; i++)
+   {
+      if(ops->find(key[i]) == NULL)
+         found = FALSE;
+
+      modelTouch(key[i], ops->size);
+   }
+
+   osSprintf(name, "%s: colliding entries found", ops->name);
+   checkResult(name, n == 3 && found && ops->matchModel());
+
+   //Delete the entry in the middle of the bucket
+   ops->delete(ops->find(key[1]));
+   modelRemove(key[1]);
+
+   found = ops->find(key[1]) == NULL && ops->matchModel();
+   found = found && ops->find(key[0]) != NULL && ops->find(key[2]) != NULL;
+   modelTouch(key[0], ops->size);
+   modelTouch(key[2], ops->size);
+
+   osSprintf(name, "%s: middle of a bucket deleted", ops->name);
+   checkResult(name, found && ops->matchModel());
+
+   //Delete the entry at the head of the bucket
+   ops->delete(ops->find(key[2]));
+   modelRemove(key[2]);
+
+   found = ops->find(key[2]) == NULL && ops->find(key[0]) != NULL;
+   modelTouch(key[0], ops->size);
+
+   osSprintf(name, "%s: head of a bucket deleted", ops->name);
+   checkResult(name, found && ops->matchModel());
+
+   //Recreate the deleted entries and delete the tail of the bucket
+   ops->create(key[1]);
+   modelTouch(key[1], ops->size);
+   ops->create(key[2]);
+   modelTouch(key[2], ops->size);
+   ops->delete(ops->find(key[0]));
+   modelRemove(key[0]);
+
+   found = ops->find(key[0]) == NULL && ops->find(key[1]) != NULL &&
+      ops->find(key[2]) != NULL;
+
+   modelTouch(key[1], ops->size);
+   modelTouch(key[2], ops->size);
+
+   osSprintf(name, "%s: tail of a bucket deleted", ops->name);
+   checkResult(name, found && ops->matchModel());
+
+   //Delete the remaining entries
+   flushCache(ops);
+}
+
+
+/**
+ * @brief The least recently used entry is evicted
+ * @param[in] ops Cache operations
+ **/
+
+void checkLruOrder(const CacheOps *ops)
+{
+   uint_t i;
+   bool_t evicted;
+   char_t name[64];
+
+   //Fill the cache
+   for(i = 0; i < ops->size; i++)
+   {
+      ops->create(i);
+      modelTouch(i, ops->size);
+   }
+
+   //Look up the oldest entry
+   ops->find(0);
+   modelTouch(0, ops->size);
+
+   //Create one more entry
+   ops->create(ops->size);
+   modelTouch(ops->size, ops->size);
+
+   //The second oldest entry must have been evicted
+   evicted = ops->matchModel() && modelFind(1) < 0 && modelFind(0) >= 0;
+   evicted = evicted && ops->find(1) == NULL;
+
+   osSprintf(name, "%s: least recently used entry evicted", ops->name);
+   checkResult(name, evicted);
+
+   //Look up two entries and create two more
+   for(i = 2; i < 4; i++)
+   {
+      ops->find(i);
+      modelTouch(i, ops->size);
+   }
+
+   for(i = ops->size + 1; i < ops->size + 3; i++)
+   {
+      ops->create(i);
+      modelTouch(i, ops->size);
+   }
+
+   //The entries that have not been used since the cache was filled are
+   //evicted first
+   evicted = ops->matchModel() && modelFind(4) < 0 && modelFind(5) < 0;
+
+   osSprintf(name, "%s: eviction follows the order of use", ops->name);
+   checkResult(name, evicted);
+
+   //Delete the remaining entries
+   flushCache(ops);
+}
+
+
+/**
+ * @brief Static entries are never evicted
+ * @param[in] ops Cache operations
+ **/
+
+void checkStaticEntry(const CacheOps *ops)
+{
+   uint_t i;
+   error_t error;
+   bool_t found;
+   char_t name[64];
+
+   //Add a static entry
+   error = ops->addStaticEntry(APP_STATIC_KEY);
+
+   //Create twice as many dynamic entries as the cache can hold
+   for(i = 0; i < 2 * ops->size; i++)
+   {
+      ops->create(i);
+   }
+
+   //The static entry must still be there
+   found = ops->find(APP_STATIC_KEY) != NULL;
+
+   osSprintf(name, "%s: static entry kept", ops->name);
+   checkResult(name, !error && found);
+
+   //Remove the static entry
+   error = ops->removeStaticEntry(APP_STATIC_KEY);
+   found = ops->find(APP_STATIC_KEY) != NULL;
+
+   osSprintf(name, "%s: static entry removed", ops->name);
+   checkResult(name, !error && !found);
+
+   //Delete the remaining entries
+   flushCache(ops);
+}
+
+
+/**
+ * @brief Random sequence of lookups, creations and deletions
+ * @param[in] ops Cache operations
+ **/
+
+void checkRandomOps(const CacheOps *ops)
+{
+   uint_t i;
+   uint_t key;
+   uint_t mismatches;
+   bool_t found;
+   void *entry;
+   char_t name[64];
+
+   //Use a reproducible sequence
+   srand(APP_RANDOM_SEED);
+
+   //Perform random operations
+   for(mismatches = 0, i = 0; i < APP_RANDOM_OPS; i++)
+   {
+      //Select an address
+      key = rand() % APP_KEY_COUNT;
+
+      //Search the cache for the address
+      entry = ops->find(key);
+      found = (modelFind(key) >= 0);
+
+      //The lookup must agree with the model
+      if((entry != NULL) != found)
+      {
+         mismatches++;
+      }
+
+      //A lookup moves the entry to the head of the LRU list
+      if(entry != NULL)
+      {
+         modelTouch(key, ops->size);
+      }
+
+      //Select an operation
+      switch(rand() % 3)
+      {
+      case 0:
+         //Create the entry if the address is not in the cache
+         if(entry == NULL)
+         {
+            ops->create(key);
+            modelTouch(key, ops->size);
+         }
+         break;
+      case 1:
+         //Delete the entry
+         if(entry != NULL)
+         {
+            ops->delete(entry);
+            modelRemove(key);
+         }
+         break;
+      default:
+         //Lookup only
+         break;
+      }
+
+      //Compare the cache with the model
+      if(!ops->matchModel())
+      {
+         mismatches++;
+      }
+   }
+
+   //Display the number of mismatches
+   TRACE_PRINTF("%s: %u mismatch(es) in %u operations\r\n", ops->name,
+      mismatches, APP_RANDOM_OPS);
+
+   osSprintf(name, "%s: random operations match the model", ops->name);
+   checkResult(name, mismatches == 0);
+
+   //Delete the remaining entries
+   flushCache(ops);
+}
+
+
+/**
+ * @brief Run all the checks on a cache
+ * @param[in] ops Cache operations
+ **/
+
+void checkCache(const CacheOps *ops)
+{
+   char_t name[64];
+
+   //Get exclusive access
+   osAcquireMutex(&netMutex);
+
+   //Start from an empty cache
+   flushCache(ops);
+
+   osSprintf(name, "%s: empty cache", ops->name);
+   checkResult(name, ops->matchModel());
+
+   //Run the checks
+   checkCollisions(ops);
+   checkLruOrder(ops);
+   checkStaticEntry(ops);
+   checkRandomOps(ops);
+
+   //Release exclusive access
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   NetInterface *interface;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("***********************************************\r\n");
+   TRACE_INFO("*** CycloneTCP ARP and Neighbor Cache Check ***\r\n");
+   TRACE_INFO("***********************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //The caches of this interface are checked
+   cacheInterface = interface;
+
+   //ARP cache
+   checkCache(&arpCacheOps);
+   //Neighbor cache
+   checkCache(&ndpCacheOps);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
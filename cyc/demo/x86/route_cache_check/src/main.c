@@ -0,0 +1,804 @@
+/**
+ * @file main.c
+ * @brief Per-socket route cache check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * UDP datagrams and TCP segments are sent to a remote host through a
+ * virtual Ethernet interface, and the destination MAC address of each frame
+ * is captured. The ARP and Neighbor cache entries are altered behind the
+ * back of the stack to tell whether the next hop comes from the route cache.
+ * Changing the default gateway, the subnet mask or a cache entry must drop
+ * the cached next hop
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/udp.h"
+#include "core/tcp.h"
+#include "ipv4/arp.h"
+#include "ipv4/arp_cache.h"
+#include "ipv6/ndp.h"
+#include "ipv6/ndp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+#define APP_IPV6_LINK_LOCAL_ADDR "fe80::1"
+
+//Routers
+#define APP_ROUTER1_IPV4_ADDR "192.168.0.254"
+#define APP_ROUTER1_MAC_ADDR "00-11-22-33-44-01"
+#define APP_ROUTER2_IPV4_ADDR "192.168.0.253"
+#define APP_ROUTER2_MAC_ADDR "00-11-22-33-44-02"
+
+//Remote host
+#define APP_REMOTE_IPV4_ADDR "192.168.1.1"
+#define APP_REMOTE_MAC_ADDR "00-11-22-33-44-03"
+#define APP_REMOTE_PORT 40000
+#define APP_REMOTE_ISN 1000
+
+//Neighbors
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_IPV6_ADDR "fe80::2"
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-04"
+
+//MAC address that is never used by the stack unless the route cache is
+//bypassed
+#define APP_ALTERED_MAC_ADDR "00-11-22-33-44-FF"
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr router1MacAddr;
+MacAddr router2MacAddr;
+MacAddr remoteMacAddr;
+MacAddr peerMacAddr;
+MacAddr alteredMacAddr;
+Ipv4Addr router1IpAddr;
+Ipv4Addr router2IpAddr;
+Ipv4Addr remoteIpAddr;
+Ipv4Addr peerIpv4Addr;
+Ipv6Addr peerIpv6Addr;
+uint32_t remoteSeqNum;
+uint32_t localSndMax;
+MacAddr lastDestMacAddr;
+uint_t frameCount;
+uint_t failureCount;
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The destination MAC address of the UDP datagrams and TCP segments sent by
+ * the stack is recorded
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   uint8_t protocol;
+   EthHeader *ethHeader;
+   Ipv4Header *ipv4Header;
+   Ipv6Header *ipv6Header;
+   TcpHeader *tcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipv4Header = (Ipv4Header *) ethHeader->data;
+   ipv6Header = (Ipv6Header *) ethHeader->data;
+
+   //Retrieve the upper-layer protocol
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4))
+   {
+      protocol = ipv4Header->protocol;
+   }
+   else if(n >= (sizeof(EthHeader) + sizeof(Ipv6Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV6))
+   {
+      protocol = ipv6Header->nextHeader;
+   }
+   else
+   {
+      protocol = 0;
+   }
+
+   //Only UDP datagrams and TCP segments are of interest
+   if(protocol == IPV4_PROTOCOL_UDP || protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Save the MAC address of the next hop
+      lastDestMacAddr = ethHeader->destAddr;
+      frameCount++;
+   }
+
+   //Track the sequence numbers of the connection
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header) + sizeof(TcpHeader)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data +
+         ipv4Header->headerLength * 4);
+
+      //Sequence number of the first byte following the segment
+      n = ntohl(tcpHeader->seqNum) + ntohs(ipv4Header->totalLength) -
+         ipv4Header->headerLength * 4 - tcpHeader->dataOffset * 4;
+
+      //The SYN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_SYN) != 0)
+      {
+         n++;
+      }
+
+      //Highest sequence number sent so far
+      localSndMax = (uint32_t) n;
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by the remote host
+ * @param[in] interface Underlying network interface
+ * @param[in] flags TCP flags
+ **/
+
+void injectSegment(NetInterface *interface, uint8_t flags)
+{
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+   NetRxAncillary ancillary;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //The segment is forwarded by the first router
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = router1MacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = HTONS(sizeof(Ipv4Header) + sizeof(TcpHeader));
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = remoteIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Format TCP header
+   osMemset(tcpHeader, 0, sizeof(TcpHeader));
+   tcpHeader->srcPort = HTONS(APP_REMOTE_PORT);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(remoteSeqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(localSndMax) : 0;
+   tcpHeader->dataOffset = 5;
+   tcpHeader->flags = flags;
+   tcpHeader->window = HTONS(65535);
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = HTONS(sizeof(TcpHeader));
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, sizeof(TcpHeader));
+
+   //The SYN flag occupies one sequence number
+   if((flags & TCP_FLAG_SYN) != 0)
+   {
+      remoteSeqNum++;
+   }
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   osAcquireMutex(&netMutex);
+   nicProcessPacket(interface, frame, sizeof(EthHeader) +
+      sizeof(Ipv4Header) + sizeof(TcpHeader), &ancillary);
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Send a UDP datagram and return the next hop
+ * @param[in] socket UDP socket
+ * @param[in] destIpAddr Destination IP address
+ * @return TRUE if the datagram was sent, else FALSE
+ **/
+
+bool_t sendDatagram(Socket *socket, const IpAddr *destIpAddr)
+{
+   error_t error;
+   uint_t count;
+
+   //Number of frames sent so far
+   count = frameCount;
+
+   //Send a datagram
+   error = socketSendTo(socket, destIpAddr, APP_REMOTE_PORT, "route", 5,
+      NULL, 0);
+
+   //Exactly one frame must have been sent
+   return (!error && frameCount == (count + 1)) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Send TCP data and acknowledge them
+ * @param[in] interface Underlying network interface
+ * @param[in] socket TCP socket
+ * @return TRUE if a segment was sent, else FALSE
+ **/
+
+bool_t sendSegment(NetInterface *interface, Socket *socket)
+{
+   error_t error;
+   uint_t count;
+
+   //Number of frames sent so far
+   count = frameCount;
+
+   //All the previous data have been acknowledged, so that the segment is
+   //sent immediately
+   error = socketSend(socket, "route", 5, NULL, 0);
+
+   //Acknowledge the data
+   injectSegment(interface, TCP_FLAG_ACK);
+
+   //Exactly one frame must have been sent
+   return (!error && frameCount == (count + 1)) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Change the MAC address of an ARP cache entry
+ *
+ * The entry is modified without notifying the stack, as if its contents had
+ * been left untouched
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] ipAddr IPv4 address
+ * @param[in] macAddr New MAC address
+ **/
+
+void alterArpEntry(NetInterface *interface, Ipv4Addr ipAddr,
+   const MacAddr *macAddr)
+{
+   ArpCacheEntry *entry;
+
+   osAcquireMutex(&netMutex);
+
+   //Search the ARP cache
+   entry = arpFindEntry(interface, ipAddr);
+
+   //Overwrite the MAC address
+   if(entry != NULL)
+   {
+      entry->macAddr = *macAddr;
+   }
+
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Change the MAC address of a Neighbor cache entry
+ *
+ * The entry is modified without notifying the stack, as if its contents had
+ * been left untouched
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] ipAddr IPv6 address
+ * @param[in] macAddr New MAC address
+ **/
+
+void alterNdpEntry(NetInterface *interface, const Ipv6Addr *ipAddr,
+   const MacAddr *macAddr)
+{
+   NdpNeighborCacheEntry *entry;
+
+   osAcquireMutex(&netMutex);
+
+   //Search the Neighbor cache
+   entry = ndpFindNeighborCacheEntry(interface, ipAddr);
+
+   //Overwrite the MAC address
+   if(entry != NULL)
+   {
+      entry->macAddr = *macAddr;
+   }
+
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Route cache for UDP over IPv4
+ * @param[in] interface Underlying network interface
+ * @param[in] socket UDP socket
+ **/
+
+void checkUdpIpv4(NetInterface *interface, Socket *socket)
+{
+   bool_t sent;
+   IpAddr remoteAddr;
+   IpAddr peerAddr;
+   Ipv4Addr mask;
+
+   //Destination addresses
+   remoteAddr.length = sizeof(Ipv4Addr);
+   remoteAddr.ipv4Addr = remoteIpAddr;
+   peerAddr.length = sizeof(Ipv4Addr);
+   peerAddr.ipv4Addr = peerIpv4Addr;
+
+   //The remote host is reached through the default gateway
+   sent = sendDatagram(socket, &remoteAddr);
+
+   checkResult("UDP: datagram routed through the default gateway", sent &&
+      macCompAddr(&lastDestMacAddr, &router1MacAddr) &&
+      socket->routeCache.interface == interface);
+
+   //The next hop is no longer resolved once it has been cached
+   alterArpEntry(interface, router1IpAddr, &alteredMacAddr);
+   sent = sendDatagram(socket, &remoteAddr);
+   alterArpEntry(interface, router1IpAddr, &router1MacAddr);
+
+   checkResult("UDP: next hop reused from the route cache", sent &&
+      macCompAddr(&lastDestMacAddr, &router1MacAddr));
+
+   //Switch to the second router
+   ipv4SetDefaultGateway(interface, router2IpAddr);
+   sent = sendDatagram(socket, &remoteAddr);
+
+   checkResult("UDP: gateway change drops the cached next hop", sent &&
+      macCompAddr(&lastDestMacAddr, &router2MacAddr) &&
+      macCompAddr(&socket->routeCache.destMacAddr, &router2MacAddr));
+
+   //The MAC address of the second router changes
+   arpRemoveStaticEntry(interface, router2IpAddr);
+   arpAddStaticEntry(interface, router2IpAddr, &alteredMacAddr);
+   sent = sendDatagram(socket, &remoteAddr);
+
+   checkResult("UDP: ARP entry change drops the cached next hop", sent &&
+      macCompAddr(&lastDestMacAddr, &alteredMacAddr));
+
+   //Restore the MAC address of the second router
+   arpRemoveStaticEntry(interface, router2IpAddr);
+   arpAddStaticEntry(interface, router2IpAddr, &router2MacAddr);
+   sent = sendDatagram(socket, &remoteAddr);
+
+   checkResult("UDP: ARP entry restored", sent &&
+      macCompAddr(&lastDestMacAddr, &router2MacAddr));
+
+   //Alternate between an on-link host and the remote host
+   sent = sendDatagram(socket, &peerAddr);
+   sent = sent && macCompAddr(&lastDestMacAddr, &peerMacAddr);
+   sent = sent && sendDatagram(socket, &remoteAddr);
+
+   checkResult("UDP: destination change misses the route cache", sent &&
+      macCompAddr(&lastDestMacAddr, &router2MacAddr));
+
+   //The remote host becomes on-link
+   ipv4StringToAddr("255.255.0.0", &mask);
+   ipv4SetSubnetMask(interface, mask);
+   sent = sendDatagram(socket, &remoteAddr);
+
+   checkResult("UDP: subnet mask change drops the cached route", sent &&
+      macCompAddr(&lastDestMacAddr, &remoteMacAddr));
+
+   //Restore the subnet mask
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &mask);
+   ipv4SetSubnetMask(interface, mask);
+   sent = sendDatagram(socket, &remoteAddr);
+
+   checkResult("UDP: subnet mask restored", sent &&
+      macCompAddr(&lastDestMacAddr, &router2MacAddr));
+}
+
+
+/**
+ * @brief Route cache for UDP over IPv6
+ * @param[in] interface Underlying network interface
+ * @param[in] socket UDP socket
+ **/
+
+void checkUdpIpv6(NetInterface *interface, Socket *socket)
+{
+   bool_t sent;
+   IpAddr peerAddr;
+
+   //Destination address
+   peerAddr.length = sizeof(Ipv6Addr);
+   peerAddr.ipv6Addr = peerIpv6Addr;
+
+   //The neighbor is reachable without address resolution
+   sent = sendDatagram(socket, &peerAddr);
+
+   checkResult("UDP/IPv6: datagram sent to the neighbor", sent &&
+      macCompAddr(&lastDestMacAddr, &peerMacAddr));
+
+   //The next hop is no longer resolved once it has been cached
+   alterNdpEntry(interface, &peerIpv6Addr, &alteredMacAddr);
+   sent = sendDatagram(socket, &peerAddr);
+   alterNdpEntry(interface, &peerIpv6Addr, &peerMacAddr);
+
+   checkResult("UDP/IPv6: next hop reused from the route cache", sent &&
+      macCompAddr(&lastDestMacAddr, &peerMacAddr));
+
+   //The MAC address of the neighbor changes
+   ndpRemoveStaticEntry(interface, &peerIpv6Addr);
+   ndpAddStaticEntry(interface, &peerIpv6Addr, &alteredMacAddr);
+   sent = sendDatagram(socket, &peerAddr);
+
+   checkResult("UDP/IPv6: Neighbor cache change drops the next hop", sent &&
+      macCompAddr(&lastDestMacAddr, &alteredMacAddr));
+}
+
+
+/**
+ * @brief Route cache for TCP
+ * @param[in] interface Underlying network interface
+ * @param[in] listener Listening TCP socket
+ **/
+
+void checkTcp(NetInterface *interface, Socket *listener)
+{
+   bool_t sent;
+   Socket *socket;
+
+   //The remote host is reached through the first router
+   ipv4SetDefaultGateway(interface, router1IpAddr);
+
+   //The remote host opens the connection
+   remoteSeqNum = APP_REMOTE_ISN;
+   injectSegment(interface, TCP_FLAG_SYN);
+
+   //The SYN-ACK is sent when the connection is accepted
+   socket = socketAccept(listener, NULL, NULL);
+
+   //Make sure the SYN-ACK has been sent
+   if(socket == NULL)
+   {
+      checkResult("TCP: connection established", FALSE);
+      return;
+   }
+
+   //Complete the three-way handshake
+   injectSegment(interface, TCP_FLAG_ACK);
+   sent = sendSegment(interface, socket);
+
+   checkResult("TCP: segment routed through the default gateway", sent &&
+      macCompAddr(&lastDestMacAddr, &router1MacAddr) &&
+      socket->routeCache.interface == interface);
+
+   //The next hop is no longer resolved once it has been cached
+   alterArpEntry(interface, router1IpAddr, &alteredMacAddr);
+   sent = sendSegment(interface, socket);
+   alterArpEntry(interface, router1IpAddr, &router1MacAddr);
+
+   checkResult("TCP: next hop reused from the route cache", sent &&
+      macCompAddr(&lastDestMacAddr, &router1MacAddr));
+
+   //Switch to the second router
+   ipv4SetDefaultGateway(interface, router2IpAddr);
+   sent = sendSegment(interface, socket);
+
+   checkResult("TCP: gateway change drops the cached next hop", sent &&
+      macCompAddr(&lastDestMacAddr, &router2MacAddr));
+
+   //Release the connection
+   socketClose(socket);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   Ipv6Addr ipv6Addr;
+   NetInterface *interface;
+   Socket *udpSocket;
+   Socket *listener;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Route Cache Check ***\r\n");
+   TRACE_INFO("************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address, subnet mask and default gateway
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+   ipv4StringToAddr(APP_ROUTER1_IPV4_ADDR, &router1IpAddr);
+   ipv4SetDefaultGateway(interface, router1IpAddr);
+
+   //Set IPv6 link-local address
+   ipv6StringToAddr(APP_IPV6_LINK_LOCAL_ADDR, &ipv6Addr);
+   ipv6SetLinkLocalAddr(interface, &ipv6Addr);
+
+   //Addresses of the simulated hosts
+   macStringToAddr(APP_ROUTER1_MAC_ADDR, &router1MacAddr);
+   macStringToAddr(APP_ROUTER2_MAC_ADDR, &router2MacAddr);
+   macStringToAddr(APP_REMOTE_MAC_ADDR, &remoteMacAddr);
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   macStringToAddr(APP_ALTERED_MAC_ADDR, &alteredMacAddr);
+   ipv4StringToAddr(APP_ROUTER2_IPV4_ADDR, &router2IpAddr);
+   ipv4StringToAddr(APP_REMOTE_IPV4_ADDR, &remoteIpAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpv4Addr);
+   ipv6StringToAddr(APP_PEER_IPV6_ADDR, &peerIpv6Addr);
+
+   //The simulated hosts are reachable without address resolution
+   arpAddStaticEntry(interface, router1IpAddr, &router1MacAddr);
+   arpAddStaticEntry(interface, router2IpAddr, &router2MacAddr);
+   arpAddStaticEntry(interface, remoteIpAddr, &remoteMacAddr);
+   arpAddStaticEntry(interface, peerIpv4Addr, &peerMacAddr);
+   ndpAddStaticEntry(interface, &peerIpv6Addr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a UDP socket
+   udpSocket = socketOpen(SOCKET_TYPE_DGRAM, SOCKET_IP_PROTO_UDP);
+
+   //Open a listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketSetTimeout(listener, 1000);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 1);
+
+   //Run the checks
+   checkUdpIpv4(interface, udpSocket);
+   checkUdpIpv6(interface, udpSocket);
+   checkTcp(interface, listener);
+
+   //Close sockets
+   socketClose(listener);
+   socketClose(udpSocket);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
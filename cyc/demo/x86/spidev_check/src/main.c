@@ -0,0 +1,526 @@
+/**
+ * @file main.c
+ * @brief spidev driver check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * The spidev driver is built with its mock backend, and a simulated device
+ * logs every transfer of each SPI_IOC_MESSAGE request. The check issues
+ * CS-framed accesses through nicSpiTransfer and verifies how they are
+ * batched into messages, where the CS pin is released, and the data read
+ * back. The same accesses are then replayed with byte transfers only, and
+ * must return the same data
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "drivers/spi/spidev_driver.h"
+#include "debug.h"
+
+//Check configuration
+#define APP_HEADER_SIZE 3
+#define APP_DATA_SIZE 8
+#define APP_SMALL_TRANSFER_COUNT 20
+#define APP_LARGE_BLOCK_SIZE 10000
+#define APP_LOG_SIZE 64
+
+//Transfer seen by the simulated device
+typedef struct
+{
+   size_t length;
+   bool_t tx;
+   bool_t rx;
+   bool_t endOfFrame;
+} MockTransfer;
+
+//Global variables
+MockTransfer mockLog[APP_LOG_SIZE];
+uint_t mockLogLength;
+uint_t mockPosition;
+uint8_t txBlock[APP_LARGE_BLOCK_SIZE];
+uint8_t rxBlock[APP_LARGE_BLOCK_SIZE];
+
+
+/**
+ * @brief spidev driver without block transfers
+ **/
+
+const SpiDriver spidevByteDriver =
+{
+   spidevInit,
+   spidevSetMode,
+   spidevSetBitrate,
+   spidevAssertCs,
+   spidevDeassertCs,
+   spidevTransfer,
+   NULL
+};
+
+
+/**
+ * @brief Simulated SPI device
+ *
+ * Each byte returned by the device is the byte sent XORed with the position
+ * of the byte within the CS-framed access. Dummy bytes are sent as zeros
+ *
+ * @param[in] txBuffer Data sent by the host (may be NULL)
+ * @param[out] rxBuffer Data returned to the host (may be NULL)
+ * @param[in] length Number of bytes to transfer
+ * @param[in] endOfFrame The CS pin is raised at the end of the transfer
+ **/
+
+void mockDevice(const uint8_t *txBuffer, uint8_t *rxBuffer, size_t length,
+   bool_t endOfFrame)
+{
+   size_t i;
+
+   //Log the transfer
+   if(mockLogLength < APP_LOG_SIZE)
+   {
+      mockLog[mockLogLength].length = length;
+      mockLog[mockLogLength].tx = (txBuffer != NULL) ? TRUE : FALSE;
+      mockLog[mockLogLength].rx = (rxBuffer != NULL) ? TRUE : FALSE;
+      mockLog[mockLogLength].endOfFrame = endOfFrame;
+      mockLogLength++;
+   }
+
+   //Process the bytes of the transfer
+   for(i = 0; i < length; i++, mockPosition++)
+   {
+      if(rxBuffer != NULL)
+      {
+         if(txBuffer != NULL)
+         {
+            rxBuffer[i] = txBuffer[i] ^ (uint8_t) mockPosition;
+         }
+         else
+         {
+            rxBuffer[i] = (uint8_t) mockPosition;
+         }
+      }
+   }
+
+   //Releasing the CS pin terminates the access
+   if(endOfFrame)
+   {
+      mockPosition = 0;
+   }
+}
+
+
+/**
+ * @brief Check a transfer logged by the simulated device
+ * @param[in] index Index of the transfer
+ * @param[in] length Expected length
+ * @param[in] endOfFrame Expected state of the CS pin after the transfer
+ * @return TRUE if the transfer matches, else FALSE
+ **/
+
+bool_t checkTransfer(uint_t index, size_t length, bool_t endOfFrame)
+{
+   return index < mockLogLength && mockLog[index].length == length &&
+      mockLog[index].endOfFrame == endOfFrame;
+}
+
+
+/**
+ * @brief Number of messages submitted since the last call
+ * @return Number of SPI_IOC_MESSAGE requests
+ **/
+
+uint32_t getMessageCount(void)
+{
+   SpidevStats stats;
+
+   //Retrieve statistics
+   spidevGetStats(&stats);
+   //Clear counters
+   spidevResetStats();
+
+   //Return the number of messages
+   return stats.messages;
+}
+
+
+/**
+ * @brief Register read: command header followed by a data phase
+ * @param[in] interface Underlying network interface
+ * @param[out] data Buffer where to store the register contents
+ * @return TRUE if the access was performed as expected, else FALSE
+ **/
+
+bool_t checkRegisterRead(NetInterface *interface, uint8_t *data)
+{
+   uint_t i;
+   uint32_t messages;
+   bool_t ok;
+   static const uint8_t header[APP_HEADER_SIZE] = {0x00, 0x10, 0x01};
+
+   //Clear log
+   mockLogLength = 0;
+
+   //Read the register
+   interface->spiDriver->assertCs();
+   nicSpiTransfer(interface, header, NULL, sizeof(header));
+   nicSpiTransfer(interface, NULL, data, APP_DATA_SIZE);
+   interface->spiDriver->deassertCs();
+
+   //Get the number of messages
+   messages = getMessageCount();
+
+   //The data phase follows the header within the same access
+   for(ok = TRUE, i = 0; i < APP_DATA_SIZE; i++)
+   {
+      if(data[i] != (APP_HEADER_SIZE + i))
+      {
+         ok = FALSE;
+      }
+   }
+
+   //Display statistics
+   TRACE_PRINTF("Register read: %" PRIu32 " message(s), %u transfer(s)\r\n",
+      messages, mockLogLength);
+
+   //Block transfers must be batched into a single message
+   if(interface->spiDriver->transferMultipleBytes != NULL)
+   {
+      ok = ok && messages == 1 && mockLogLength == 2 &&
+         checkTransfer(0, APP_HEADER_SIZE, FALSE) &&
+         mockLog[0].tx && !mockLog[0].rx &&
+         checkTransfer(1, APP_DATA_SIZE, TRUE) &&
+         !mockLog[1].tx && mockLog[1].rx;
+   }
+
+   //Return status
+   return ok;
+}
+
+
+/**
+ * @brief Single-byte transfer in the middle of an access
+ * @param[in] interface Underlying network interface
+ * @return TRUE if the access was performed as expected, else FALSE
+ **/
+
+bool_t checkSingleByte(NetInterface *interface)
+{
+   uint_t i;
+   uint8_t status;
+   uint32_t messages;
+   bool_t ok;
+   uint8_t data[APP_DATA_SIZE];
+   static const uint8_t header[APP_HEADER_SIZE] = {0x00, 0x20, 0x01};
+
+   //Clear log
+   mockLogLength = 0;
+
+   //The status byte is needed to proceed with the access
+   interface->spiDriver->assertCs();
+   nicSpiTransfer(interface, header, NULL, sizeof(header));
+   status = interface->spiDriver->transfer(0x50);
+   nicSpiTransfer(interface, NULL, data, APP_DATA_SIZE);
+   interface->spiDriver->deassertCs();
+
+   //Get the number of messages
+   messages = getMessageCount();
+
+   //The CS pin must be held between both messages
+   for(ok = TRUE, i = 0; i < APP_DATA_SIZE; i++)
+   {
+      if(data[i] != (APP_HEADER_SIZE + 1 + i))
+      {
+         ok = FALSE;
+      }
+   }
+
+   //Display statistics
+   TRACE_PRINTF("Single-byte transfer: %" PRIu32 " message(s), status 0x%02"
+      PRIX8 "\r\n", messages, status);
+
+   //The byte transfer flushes the queue without releasing the CS pin
+   return ok && status == (0x50 ^ APP_HEADER_SIZE) && messages == 2 && mockLogLength == 3 &&
+      checkTransfer(0, APP_HEADER_SIZE, FALSE) &&
+      checkTransfer(1, 1, FALSE) &&
+      checkTransfer(2, APP_DATA_SIZE, TRUE);
+}
+
+
+/**
+ * @brief More transfers than a message can hold
+ * @param[in] interface Underlying network interface
+ * @return TRUE if the access was performed as expected, else FALSE
+ **/
+
+bool_t checkTransferLimit(NetInterface *interface)
+{
+   uint_t i;
+   uint32_t messages;
+   bool_t ok;
+   uint8_t data[2 * APP_SMALL_TRANSFER_COUNT];
+
+   //Clear log
+   mockLogLength = 0;
+
+   //Read the data two bytes at a time
+   interface->spiDriver->assertCs();
+
+   for(i = 0; i < APP_SMALL_TRANSFER_COUNT; i++)
+   {
+      nicSpiTransfer(interface, NULL, data + 2 * i, 2);
+   }
+
+   interface->spiDriver->deassertCs();
+
+   //Get the number of messages
+   messages = getMessageCount();
+
+   //The CS pin must be held across the messages
+   for(ok = TRUE, i = 0; i < sizeof(data); i++)
+   {
+      if(data[i] != i)
+      {
+         ok = FALSE;
+      }
+   }
+
+   //Only the last transfer releases the CS pin
+   for(i = 0; i < mockLogLength; i++)
+   {
+      if(!checkTransfer(i, 2, i == (APP_SMALL_TRANSFER_COUNT - 1)))
+      {
+         ok = FALSE;
+      }
+   }
+
+   //Display statistics
+   TRACE_PRINTF("%u small transfers: %" PRIu32 " message(s)\r\n",
+      APP_SMALL_TRANSFER_COUNT, messages);
+
+   //The queue holds SPIDEV_DRIVER_MAX_TRANSFERS transfers
+   return ok && mockLogLength == APP_SMALL_TRANSFER_COUNT &&
+      messages == ((APP_SMALL_TRANSFER_COUNT + SPIDEV_DRIVER_MAX_TRANSFERS - 1) /
+      SPIDEV_DRIVER_MAX_TRANSFERS);
+}
+
+
+/**
+ * @brief Block larger than the spidev bounce buffer
+ * @param[in] interface Underlying network interface
+ * @return TRUE if the access was performed as expected, else FALSE
+ **/
+
+bool_t checkLargeBlock(NetInterface *interface)
+{
+   uint_t i;
+   uint32_t messages;
+   bool_t ok;
+
+   //Clear log
+   mockLogLength = 0;
+
+   //Format the data to be sent
+   for(i = 0; i < APP_LARGE_BLOCK_SIZE; i++)
+   {
+      txBlock[i] = (uint8_t) (i * 7);
+   }
+
+   //Full-duplex transfer
+   interface->spiDriver->assertCs();
+   nicSpiTransfer(interface, txBlock, rxBlock, APP_LARGE_BLOCK_SIZE);
+   interface->spiDriver->deassertCs();
+
+   //Get the number of messages
+   messages = getMessageCount();
+
+   //The CS pin must be held across the messages
+   for(ok = TRUE, i = 0; i < APP_LARGE_BLOCK_SIZE; i++)
+   {
+      if(rxBlock[i] != (txBlock[i] ^ (uint8_t) i))
+      {
+         ok = FALSE;
+      }
+   }
+
+   //Display statistics
+   TRACE_PRINTF("%u-byte block: %" PRIu32 " message(s), %u transfer(s)\r\n",
+      APP_LARGE_BLOCK_SIZE, messages, mockLogLength);
+
+   //Block transfers are split into 4096-byte messages
+   if(interface->spiDriver->transferMultipleBytes != NULL)
+   {
+      ok = ok && messages == 3 && mockLogLength == 3 &&
+         checkTransfer(0, 4096, FALSE) && checkTransfer(1, 4096, FALSE) &&
+         checkTransfer(2, APP_LARGE_BLOCK_SIZE - 8192, TRUE);
+   }
+
+   //Return status
+   return ok;
+}
+
+
+/**
+ * @brief Release of the CS pin after an empty queue
+ * @param[in] interface Underlying network interface
+ * @return TRUE if the access was performed as expected, else FALSE
+ **/
+
+bool_t checkCsRelease(NetInterface *interface)
+{
+   uint32_t messages;
+
+   //Clear log
+   mockLogLength = 0;
+
+   //Access made of a single byte transfer
+   interface->spiDriver->assertCs();
+   interface->spiDriver->transfer(0x11);
+   interface->spiDriver->deassertCs();
+
+   //Get the number of messages
+   messages = getMessageCount();
+
+   //Display statistics
+   TRACE_PRINTF("CS release: %" PRIu32 " message(s)\r\n", messages);
+
+   //A zero-length transfer raises the CS pin
+   return messages == 2 && mockLogLength == 2 && checkTransfer(0, 1, FALSE) &&
+      checkTransfer(1, 0, TRUE);
+}
+
+
+/**
+ * @brief Loopback mode
+ * @param[in] interface Underlying network interface
+ * @return TRUE if the received data match the sent data
+ **/
+
+bool_t checkLoopback(NetInterface *interface)
+{
+   uint_t i;
+   bool_t ok;
+
+   //No simulated device
+   spidevRegisterMockHandler(NULL);
+
+   //Full-duplex transfer
+   interface->spiDriver->assertCs();
+   nicSpiTransfer(interface, txBlock, rxBlock, APP_DATA_SIZE);
+   interface->spiDriver->deassertCs();
+
+   //MOSI is wired to MISO
+   for(ok = TRUE, i = 0; i < APP_DATA_SIZE; i++)
+   {
+      if(rxBlock[i] != txBlock[i])
+      {
+         ok = FALSE;
+      }
+   }
+
+   //Restore the simulated device
+   spidevRegisterMockHandler(mockDevice);
+   //Discard the statistics of the loopback transfer
+   spidevResetStats();
+
+   //Return status
+   return ok;
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   bool_t batchingOk;
+   bool_t byteTransfersOk;
+   bool_t loopbackOk;
+   uint8_t data[APP_DATA_SIZE];
+   uint8_t byteData[APP_DATA_SIZE];
+   NetInterface *interface;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("**************************************\r\n");
+   TRACE_INFO("*** CycloneTCP spidev Driver Check ***\r\n");
+   TRACE_INFO("**************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //Point to the network interface the SPI driver is attached to
+   interface = &netInterface[0];
+   interface->spiDriver = &spidevDriver;
+
+   //Initialize SPI driver
+   error = interface->spiDriver->init();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize spidev driver!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Attach the simulated device
+   spidevRegisterMockHandler(mockDevice);
+
+   //Check the accesses made with block transfers
+   TRACE_PRINTF("Block transfers:\r\n");
+   batchingOk = checkRegisterRead(interface, data);
+   batchingOk = checkSingleByte(interface) && batchingOk;
+   batchingOk = checkTransferLimit(interface) && batchingOk;
+   batchingOk = checkLargeBlock(interface) && batchingOk;
+   batchingOk = checkCsRelease(interface) && batchingOk;
+   loopbackOk = checkLoopback(interface);
+
+   //Replay the accesses with byte transfers only
+   interface->spiDriver = &spidevByteDriver;
+
+   TRACE_PRINTF("Byte transfers:\r\n");
+   byteTransfersOk = checkRegisterRead(interface, byteData);
+   byteTransfersOk = checkLargeBlock(interface) && byteTransfersOk;
+
+   //Both paths must read the same data
+   byteTransfersOk = byteTransfersOk &&
+      osMemcmp(data, byteData, APP_DATA_SIZE) == 0;
+
+   //Display results
+   TRACE_PRINTF("Batching: %s\r\n", batchingOk ? "passed" : "failed");
+   TRACE_PRINTF("Loopback: %s\r\n", loopbackOk ? "passed" : "failed");
+   TRACE_PRINTF("Byte transfers: %s\r\n", byteTransfersOk ? "passed" : "failed");
+
+   //Successful processing?
+   if(batchingOk && loopbackOk && byteTransfersOk)
+   {
+      return EXIT_SUCCESS;
+   }
+   else
+   {
+      return EXIT_FAILURE;
+   }
+}
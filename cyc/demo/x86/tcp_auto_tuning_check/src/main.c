@@ -0,0 +1,917 @@
+/**
+ * @file main.c
+ * @brief TCP buffer auto-tuning check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A TCP connection is established with a simulated peer sitting behind a
+ * virtual Ethernet interface. The send and receive buffers are enlarged
+ * while the data they hold wrap around the end of the circular buffer
+ * (including out-of-order data on the receive side), and every byte is
+ * checked afterwards. The send buffer must not grow once the memory pool
+ * reserve is reached, and must grow again when memory is released
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "core/tcp_misc.h"
+#include "ipv4/arp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_PORT 40000
+#define APP_PEER_ISN 1000
+#define APP_PEER_WINDOW 65535
+#define APP_PEER_SEGMENT_SIZE 500
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+#define APP_RTT 50
+#define APP_TIMEOUT 200
+#define APP_STREAM_SIZE 16384
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+uint32_t peerSeqNum;
+uint32_t peerAckNum;
+uint32_t localIss;
+uint32_t localSndMax;
+bool_t synAckReceived;
+uint_t failureCount;
+uint8_t txData[APP_STREAM_SIZE];
+uint8_t wireData[APP_STREAM_SIZE];
+uint8_t buffer[APP_STREAM_SIZE];
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The segments sent by the stack are parsed to track the sequence numbers
+ * of the connection on behalf of the simulated peer. The payload of each
+ * data segment is copied at its position in the stream
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   size_t length;
+   uint32_t seqNum;
+   uint32_t position;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Only TCP segments are of interest
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //Length of the segment data
+      length = ntohs(ipHeader->totalLength) - ipHeader->headerLength * 4 -
+         tcpHeader->dataOffset * 4;
+
+      //Sequence number of the first byte following the segment
+      seqNum = ntohl(tcpHeader->seqNum) + length;
+
+      //The SYN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_SYN) != 0)
+      {
+         seqNum++;
+         synAckReceived = TRUE;
+         localIss = ntohl(tcpHeader->seqNum);
+         localSndMax = seqNum;
+      }
+      else
+      {
+         //Position of the data in the stream
+         position = ntohl(tcpHeader->seqNum) - localIss - 1;
+
+         //Copy the payload
+         if(length > 0 && (position + length) <= APP_STREAM_SIZE)
+         {
+            osMemcpy(wireData + position, (uint8_t *) tcpHeader +
+               tcpHeader->dataOffset * 4, length);
+         }
+
+         //Keep track of the highest sequence number sent
+         if(TCP_CMP_SEQ(seqNum, localSndMax) > 0)
+         {
+            localSndMax = seqNum;
+         }
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Value of the data byte at the specified position in the stream
+ * @param[in] position Position in the stream
+ * @return Data byte
+ **/
+
+uint8_t pattern(size_t position)
+{
+   //The value does not repeat every 256 bytes
+   return (uint8_t) (position ^ (position >> 8) ^ 0x5A);
+}
+
+
+/**
+ * @brief Process a frame as if it had been received by the NIC
+ * @param[in] interface Underlying network interface
+ * @param[in] frame Ethernet frame
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(NetInterface *interface, uint8_t *frame, size_t length)
+{
+   NetRxAncillary ancillary;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   nicProcessPacket(interface, frame, length, &ancillary);
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] seqNum Sequence number
+ * @param[in] flags TCP flags
+ * @param[in] length Length of the segment data
+ **/
+
+void injectSegment(NetInterface *interface, uint32_t seqNum, uint8_t flags,
+   size_t length)
+{
+   size_t i;
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //Length of the TCP segment
+   n = sizeof(TcpHeader) + length;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Format TCP header
+   tcpHeader->srcPort = HTONS(APP_PEER_PORT);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(seqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(peerAckNum) : 0;
+   tcpHeader->reserved1 = 0;
+   tcpHeader->dataOffset = sizeof(TcpHeader) / 4;
+   tcpHeader->flags = flags;
+   tcpHeader->reserved2 = 0;
+   tcpHeader->window = HTONS(APP_PEER_WINDOW);
+   tcpHeader->checksum = 0;
+   tcpHeader->urgentPointer = 0;
+
+   //Each byte of the payload is derived from its position in the stream
+   for(i = 0; i < length; i++)
+   {
+      tcpHeader->options[i] = pattern(seqNum - APP_PEER_ISN - 1 + i);
+   }
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = htons(n);
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, n);
+
+   //Process the frame
+   injectFrame(interface, frame, sizeof(EthHeader) + sizeof(Ipv4Header) + n);
+}
+
+
+/**
+ * @brief Inject data sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] position Position of the data in the stream
+ * @param[in] length Number of bytes to inject
+ **/
+
+void injectData(NetInterface *interface, size_t position, size_t length)
+{
+   size_t n;
+
+   osAcquireMutex(&netMutex);
+
+   //Split the data into segments
+   while(length > 0)
+   {
+      n = MIN(length, APP_PEER_SEGMENT_SIZE);
+
+      injectSegment(interface, APP_PEER_ISN + 1 + position, TCP_FLAG_ACK, n);
+
+      position += n;
+      length -= n;
+   }
+
+   //Next sequence number to be sent by the peer
+   if(TCP_CMP_SEQ(APP_PEER_ISN + 1 + position, peerSeqNum) > 0)
+   {
+      peerSeqNum = APP_PEER_ISN + 1 + position;
+   }
+
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Acknowledge the data sent up to the specified sequence number
+ * @param[in] interface Underlying network interface
+ * @param[in] ackNum Acknowledgment number
+ **/
+
+void acknowledge(NetInterface *interface, uint32_t ackNum)
+{
+   osAcquireMutex(&netMutex);
+   peerAckNum = ackNum;
+   injectSegment(interface, peerSeqNum, TCP_FLAG_ACK, 0);
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Read data without blocking
+ * @param[in] socket Connected socket
+ * @param[out] data Buffer where to store the data
+ * @param[in] length Number of bytes to read
+ * @return Number of bytes that have been read
+ **/
+
+size_t receiveData(Socket *socket, uint8_t *data, size_t length)
+{
+   error_t error;
+   size_t n;
+   size_t total;
+
+   //Do not wait for more data
+   socketSetTimeout(socket, 0);
+
+   for(total = 0; total < length; total += n)
+   {
+      error = socketReceive(socket, data + total, length - total, &n, 0);
+
+      if(error)
+         break;
+   }
+
+   //Restore the timeout
+   socketSetTimeout(socket, APP_TIMEOUT);
+
+   //Return the number of bytes read
+   return total;
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Compare data with the expected stream contents
+ * @param[in] data Data to check
+ * @param[in] position Position of the data in the stream
+ * @param[in] length Number of bytes to check
+ * @return TRUE if the data match, else FALSE
+ **/
+
+bool_t matchPattern(const uint8_t *data, size_t position, size_t length)
+{
+   size_t i;
+
+   //Compare each byte
+   for(i = 0; i < length; i++)
+   {
+      if(data[i] != pattern(position + i))
+         return FALSE;
+   }
+
+   //The data match
+   return TRUE;
+}
+
+
+/**
+ * @brief Enlarge a circular buffer that holds wrapped data
+ **/
+
+void checkGrowBuffer(void)
+{
+   error_t error;
+   size_t n;
+   NetBuffer *netBuffer;
+
+   //The data start at offset 2000 and wrap after 1000 bytes
+   netBuffer = netBufferAlloc(3000);
+
+   for(n = 0; n < 1500; n++)
+   {
+      buffer[n] = pattern(n);
+   }
+
+   netBufferWrite(netBuffer, 2000, buffer, 1000);
+   netBufferWrite(netBuffer, 0, buffer + 1000, 500);
+
+   //Double the size of the buffer
+   error = tcpGrowBuffer(netBuffer, 3000, 6000, 2000, 1500);
+   n = netBufferRead(buffer, netBuffer, 2000, 1500);
+
+   checkResult("Wrapped data contiguous after growth", !error &&
+      netBufferGetLength(netBuffer) == 6000 && n == 1500 &&
+      matchPattern(buffer, 0, 1500));
+
+   netBufferFree(netBuffer);
+
+   //900 bytes wrap around but only 500 bytes are added
+   netBuffer = netBufferAlloc(3000);
+
+   for(n = 0; n < 2900; n++)
+   {
+      buffer[n] = pattern(n);
+   }
+
+   netBufferWrite(netBuffer, 1000, buffer, 2000);
+   netBufferWrite(netBuffer, 0, buffer + 2000, 900);
+
+   //The growth must be refused
+   error = tcpGrowBuffer(netBuffer, 3000, 3500, 1000, 2900);
+   n = netBufferRead(buffer, netBuffer, 1000, 2000);
+   n += netBufferRead(buffer + 2000, netBuffer, 0, 900);
+
+   checkResult("Growth smaller than the wrapped data refused",
+      error == ERROR_BUFFER_OVERFLOW && netBufferGetLength(netBuffer) == 3000 &&
+      n == 2900 && matchPattern(buffer, 0, 2900));
+
+   netBufferFree(netBuffer);
+}
+
+
+/**
+ * @brief Enlarge the receive buffer while it holds wrapped and out-of-order
+ *   data
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkRxGrowth(NetInterface *interface, Socket *socket)
+{
+   bool_t wrapped;
+   size_t n;
+   size_t size;
+   size_t offset;
+   uint32_t growths;
+
+   //Start a new measurement interval
+   injectData(interface, 0, 10);
+   osDelayTask(2 * APP_RTT);
+   n = receiveData(socket, buffer, 10);
+
+   //2000 bytes are read during the interval
+   injectData(interface, 10, 2000);
+   n += receiveData(socket, buffer + 10, 2000);
+
+   //The next 1500 bytes wrap around the end of the buffer, and 200 bytes are
+   //received out of order after a 100-byte gap
+   injectData(interface, 2010, 1500);
+   injectData(interface, 3610, 200);
+
+   osAcquireMutex(&netMutex);
+
+   //Save the current state of the buffer
+   size = socket->rxBufferSize;
+   growths = socket->stats.rxBufferGrowths;
+
+   //Position of the first byte to be read by the application
+   offset = (socket->rcvNxt - socket->rcvUser - socket->irs - 1 +
+      socket->rxBufferOffset) % size;
+
+   //The out-of-order data follow the in-order data
+   wrapped = (offset + 1800) > size && socket->sackBlockCount == 1;
+
+   osReleaseMutex(&netMutex);
+
+   checkResult("Receive buffer holds wrapped and out-of-order data",
+      n == 2010 && wrapped);
+
+   //The end of the measurement interval triggers the growth
+   osDelayTask(2 * APP_RTT);
+   n = receiveData(socket, buffer, 10);
+
+   TRACE_PRINTF("Receive buffer enlarged from %" PRIuSIZE " to %" PRIuSIZE
+      " bytes\r\n", size, socket->rxBufferSize);
+
+   checkResult("Receive buffer enlarged", n == 10 &&
+      socket->rxBufferSize == 2 * 2010 &&
+      socket->stats.rxBufferGrowths == growths + 1);
+
+   //Fill the gap
+   injectData(interface, 3510, 100);
+
+   //Read the remaining data
+   n = receiveData(socket, buffer, 1800);
+
+   checkResult("In-order and out-of-order data preserved",
+      n == 1790 && matchPattern(buffer, 2020, 1790));
+}
+
+
+/**
+ * @brief Enlarge the send buffer while it holds wrapped data
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkTxGrowth(NetInterface *interface, Socket *socket)
+{
+   error_t error;
+   bool_t wrapped;
+   size_t n;
+   size_t size;
+   size_t offset;
+   uint32_t growths;
+   NetBuffer *netBuffer;
+
+   //The first 2000 bytes are acknowledged
+   socketSend(socket, txData, 2000, NULL, SOCKET_FLAG_NO_DELAY);
+   acknowledge(interface, localSndMax);
+
+   //The next 2000 bytes wrap around the end of the buffer and are left
+   //unacknowledged
+   socketSend(socket, txData + 2000, 2000, NULL, SOCKET_FLAG_NO_DELAY);
+
+   osAcquireMutex(&netMutex);
+
+   //Save the current state of the buffer
+   size = socket->txBufferSize;
+   growths = socket->stats.txBufferGrowths;
+
+   //Position of the oldest unacknowledged byte
+   offset = (socket->sndUna - socket->iss - 1 + socket->txBufferOffset) % size;
+   wrapped = (offset + 2000) > size;
+
+   osReleaseMutex(&netMutex);
+
+   checkResult("Send buffer holds wrapped data", wrapped);
+
+   //The buffer is too small for the next 2000 bytes
+   error = socketSend(socket, txData + 4000, 2000, &n, SOCKET_FLAG_NO_DELAY);
+
+   TRACE_PRINTF("Send buffer enlarged from %" PRIuSIZE " to %" PRIuSIZE
+      " bytes\r\n", size, socket->txBufferSize);
+
+   checkResult("Send buffer enlarged", !error && n == 2000 &&
+      socket->txBufferSize == 2 * size &&
+      socket->stats.txBufferGrowths == growths + 1);
+
+   //Read back the unacknowledged data
+   osAcquireMutex(&netMutex);
+   netBuffer = netBufferAlloc(0);
+   error = tcpReadTxBuffer(socket, socket->sndUna, netBuffer, 4000);
+   n = netBufferRead(buffer, netBuffer, 0, 4000);
+   netBufferFree(netBuffer);
+   osReleaseMutex(&netMutex);
+
+   checkResult("Unacknowledged data preserved", !error && n == 4000 &&
+      osMemcmp(buffer, txData + 2000, 4000) == 0);
+
+   //Acknowledge the data
+   acknowledge(interface, localSndMax);
+
+   checkResult("Data sent after the growth intact",
+      localSndMax == localIss + 1 + 6000 &&
+      osMemcmp(wireData, txData, 6000) == 0);
+}
+
+
+/**
+ * @brief The send buffer does not grow beyond the memory pool reserve
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkTxMemoryLimit(NetInterface *interface, Socket *socket)
+{
+   error_t error;
+   uint_t i;
+   uint_t n;
+   uint_t currentUsage;
+   uint_t poolSize;
+   size_t size;
+   size_t written;
+   uint32_t growths;
+   void *block[NET_MEM_POOL_BUFFER_COUNT];
+
+   //Save the current state of the buffer
+   size = socket->txBufferSize;
+   growths = socket->stats.txBufferGrowths;
+
+   //Fill most of the send buffer with unacknowledged data
+   socketSend(socket, txData + 6000, size - 720, NULL, SOCKET_FLAG_NO_DELAY);
+
+   //Number of blocks needed to double the size of the buffer
+   n = N(2 * size) - N(size);
+
+   //Consume the memory pool up to the reserve
+   memPoolGetStats(&currentUsage, NULL, &poolSize);
+
+   for(i = 0; ((currentUsage + i + n) * 100) <= (poolSize *
+      (100 - TCP_AUTO_TUNING_POOL_RESERVE)); i++)
+   {
+      block[i] = memPoolAlloc(NET_MEM_POOL_BUFFER_SIZE);
+   }
+
+   TRACE_PRINTF("%u of %u pool blocks in use\r\n", currentUsage + i,
+      poolSize);
+
+   checkResult("Memory pool reserve reached", !tcpCheckBufferMemory(size,
+      2 * size));
+
+   //The buffer is too small for the next 2000 bytes
+   error = socketSend(socket, txData + 6000 + size - 720, 2000, &written,
+      SOCKET_FLAG_NO_DELAY);
+
+   checkResult("Send buffer not enlarged beyond the reserve",
+      error == ERROR_TIMEOUT && written == 720 &&
+      socket->txBufferSize == size &&
+      socket->stats.txBufferGrowths == growths);
+
+   //Release the memory
+   while(i > 0)
+   {
+      memPoolFree(block[--i]);
+   }
+
+   //The send buffer is full. Acknowledge 500 bytes so that the application
+   //can write again
+   acknowledge(interface, localIss + 1 + 6000 + 500);
+
+   //Write the remaining data
+   error = socketSend(socket, txData + 6000 + size, 2000 - 720, &written,
+      SOCKET_FLAG_NO_DELAY);
+
+   checkResult("Send buffer enlarged once memory is released",
+      !error && socket->txBufferSize == 2 * size &&
+      socket->stats.txBufferGrowths == growths + 1);
+
+   //Acknowledge the data
+   acknowledge(interface, localSndMax);
+
+   checkResult("Whole stream intact", localSndMax == localIss + 1 + 6000 +
+      size + 1280 && osMemcmp(wireData, txData, 6000 + size + 1280) == 0);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   size_t i;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+   Socket *socket;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("*******************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Buffer Auto-Tuning Check ***\r\n");
+   TRACE_INFO("*******************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Data written by the application
+   for(i = 0; i < APP_STREAM_SIZE; i++)
+   {
+      txData[i] = pattern(i);
+   }
+
+   //Direct calls
+   checkGrowBuffer();
+
+   //Open a listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 1);
+
+   //The simulated peer opens the connection
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, APP_PEER_ISN, TCP_FLAG_SYN, 0);
+   osReleaseMutex(&netMutex);
+
+   //The SYN-ACK is sent when the connection is accepted
+   socket = socketAccept(listener, NULL, NULL);
+
+   //Make sure the SYN-ACK has been sent
+   if(socket == NULL || !synAckReceived)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to accept the connection!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //The SYN-ACK is acknowledged after one RTT
+   osDelayTask(APP_RTT);
+
+   //Complete the three-way handshake
+   peerSeqNum = APP_PEER_ISN + 1;
+   acknowledge(interface, localSndMax);
+
+   //Writes fail after APP_TIMEOUT when the send buffer is full
+   socketSetTimeout(socket, APP_TIMEOUT);
+
+   //Receive buffer
+   checkRxGrowth(interface, socket);
+   //Send buffer
+   checkTxGrowth(interface, socket);
+   //Memory pool reserve
+   checkTxMemoryLimit(interface, socket);
+
+   //Close sockets
+   socketClose(socket);
+   socketClose(listener);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,820 @@
+/**
+ * @file main.c
+ * @brief TCP delayed acknowledgment check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A TCP connection is established with a simulated peer sitting behind a
+ * virtual Ethernet interface. The peer sends streams of full-sized segments,
+ * in order and out of order, and the pure ACKs returned by the stack are
+ * counted. An ACK must be generated for every second full-sized segment,
+ * within TCP_DELAYED_ACK_TIMEOUT of the first unacknowledged segment, and
+ * immediately when out-of-order data are received or a gap is filled
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "ipv4/arp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_PORT 40000
+#define APP_PEER_ISN 1000
+#define APP_PEER_WINDOW 65535
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+#define APP_SEGMENT_COUNT 10
+#define APP_SMALL_SEGMENT_SIZE 100
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+uint32_t peerSeqNum;
+uint32_t peerAckNum;
+uint32_t localSndMax;
+bool_t synAckReceived;
+uint_t ackCount;
+systime_t ackTime;
+uint_t failureCount;
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The segments sent by the stack are parsed to track the sequence numbers
+ * of the connection on behalf of the simulated peer, and to count the pure
+ * ACKs
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   size_t length;
+   uint32_t seqNum;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Only TCP segments are of interest
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //Length of the segment data
+      length = ntohs(ipHeader->totalLength) - ipHeader->headerLength * 4 -
+         tcpHeader->dataOffset * 4;
+
+      //Sequence number of the first byte following the segment
+      seqNum = ntohl(tcpHeader->seqNum) + length;
+
+      //The FIN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_FIN) != 0)
+      {
+         seqNum++;
+      }
+
+      //The SYN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_SYN) != 0)
+      {
+         seqNum++;
+         synAckReceived = TRUE;
+         localSndMax = seqNum;
+      }
+      else if(TCP_CMP_SEQ(seqNum, localSndMax) > 0)
+      {
+         localSndMax = seqNum;
+      }
+
+      //Pure ACK?
+      if(tcpHeader->flags == TCP_FLAG_ACK && length == 0)
+      {
+         ackCount++;
+         ackTime = osGetSystemTime();
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[out] frame Buffer where to format the Ethernet frame
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ * @return Length of the frame
+ **/
+
+size_t formatSegment(NetInterface *interface, uint8_t *frame, uint8_t flags,
+   uint_t numNops, size_t length)
+{
+   size_t i;
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //Length of the TCP segment
+   n = sizeof(TcpHeader) + numNops + length;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Format TCP header
+   tcpHeader->srcPort = HTONS(APP_PEER_PORT);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(peerSeqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(peerAckNum) : 0;
+   tcpHeader->reserved1 = 0;
+   tcpHeader->dataOffset = (sizeof(TcpHeader) + numNops) / 4;
+   tcpHeader->flags = flags;
+   tcpHeader->reserved2 = 0;
+   tcpHeader->window = HTONS(APP_PEER_WINDOW);
+   tcpHeader->checksum = 0;
+   tcpHeader->urgentPointer = 0;
+
+   //Options
+   osMemset(tcpHeader->options, TCP_OPTION_NOP, numNops);
+
+   //Each byte of the payload is derived from its sequence number
+   for(i = 0; i < length; i++)
+   {
+      tcpHeader->options[numNops + i] = (uint8_t) (peerSeqNum + i);
+   }
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = htons(n);
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, n);
+
+   //The SYN flag occupies one sequence number
+   peerSeqNum += length + ((flags & TCP_FLAG_SYN) ? 1 : 0);
+
+   //Return the length of the frame
+   return sizeof(EthHeader) + sizeof(Ipv4Header) + n;
+}
+
+
+/**
+ * @brief Process a frame as if it had been received by the NIC
+ * @param[in] interface Underlying network interface
+ * @param[in] frame Ethernet frame
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(NetInterface *interface, uint8_t *frame, size_t length)
+{
+   NetRxAncillary ancillary;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   nicProcessPacket(interface, frame, length, &ancillary);
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ **/
+
+void injectSegment(NetInterface *interface, uint8_t flags, uint_t numNops,
+   size_t length)
+{
+   size_t n;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Format the segment
+   n = formatSegment(interface, frame, flags, numNops, length);
+   //Process the frame
+   injectFrame(interface, frame, n);
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Inject a data segment at the specified sequence number
+ * @param[in] interface Underlying network interface
+ * @param[in] seqNum Sequence number of the first byte of data
+ * @param[in] flags TCP flags
+ * @param[in] length Length of the segment data
+ **/
+
+void injectData(NetInterface *interface, uint32_t seqNum, uint8_t flags,
+   size_t length)
+{
+   uint32_t nextSeqNum;
+
+   //Sequence number of the next segment in order
+   nextSeqNum = peerSeqNum;
+
+   //Inject the segment
+   peerSeqNum = seqNum;
+   injectSegment(interface, flags, 0, length);
+
+   //Restore the sequence number
+   if(TCP_CMP_SEQ(nextSeqNum, peerSeqNum) > 0)
+   {
+      peerSeqNum = nextSeqNum;
+   }
+}
+
+
+/**
+ * @brief Inject in-order full-sized segments
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ * @param[in] count Number of segments
+ * @return Number of pure ACKs sent in response
+ **/
+
+uint_t injectSegments(NetInterface *interface, Socket *socket, uint_t count)
+{
+   uint_t i;
+   uint_t n;
+
+   osAcquireMutex(&netMutex);
+
+   //Save the current number of ACKs
+   n = ackCount;
+
+   //Inject the segments
+   for(i = 0; i < count; i++)
+   {
+      injectSegment(interface, TCP_FLAG_ACK, 0, socket->rmss);
+   }
+
+   //Number of ACKs sent in response
+   n = ackCount - n;
+
+   osReleaseMutex(&netMutex);
+
+   //Return the number of ACKs
+   return n;
+}
+
+
+/**
+ * @brief Read the received data and let pending ACKs go out
+ * @param[in] socket Connected socket
+ **/
+
+void drainSocket(Socket *socket)
+{
+   error_t error;
+   size_t n;
+   uint8_t buffer[1024];
+
+   //Read the data that have been received so far
+   socketSetTimeout(socket, 0);
+
+   do
+   {
+      error = socketReceive(socket, buffer, sizeof(buffer), &n, 0);
+   } while(!error && n > 0);
+
+   socketSetTimeout(socket, INFINITE_DELAY);
+
+   //Wait for the delayed ACK and the window update to be sent
+   osDelayTask(2 * TCP_DELAYED_ACK_TIMEOUT);
+
+   //Reset the number of ACKs
+   osAcquireMutex(&netMutex);
+   ackCount = 0;
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief ACK every second full-sized segment
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkAckFrequency(NetInterface *interface, Socket *socket)
+{
+   uint_t n;
+   uint_t delayedAcks;
+
+   //Save the number of delayed ACKs
+   delayedAcks = socket->stats.delayedAcks;
+
+   //Inject a stream of full-sized segments
+   n = injectSegments(interface, socket, APP_SEGMENT_COUNT);
+
+   TRACE_PRINTF("%u ACK(s) sent for %u full-sized segments\r\n", n,
+      APP_SEGMENT_COUNT);
+
+   checkResult("One ACK for every second full-sized segment",
+      n == APP_SEGMENT_COUNT / 2);
+
+   //Read the data
+   drainSocket(socket);
+
+   checkResult("No delayed ACK left after an even number of segments",
+      socket->stats.delayedAcks == delayedAcks);
+}
+
+
+/**
+ * @brief A lone segment is acknowledged within TCP_DELAYED_ACK_TIMEOUT
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkAckDelay(NetInterface *interface, Socket *socket)
+{
+   uint_t i;
+   uint_t n;
+   bool_t immediate;
+   systime_t time;
+   systime_t delay;
+   systime_t maxDelay;
+
+   //Initialize variables
+   immediate = FALSE;
+   maxDelay = 0;
+
+   //Inject the segments at different phases of the TCP timer
+   for(i = 0; i < 10; i++)
+   {
+      //Shift the arrival time of the segment
+      osDelayTask(TCP_DELAYED_ACK_TIMEOUT + i * TCP_TICK_INTERVAL / 10);
+
+      osAcquireMutex(&netMutex);
+      n = ackCount;
+      injectSegment(interface, TCP_FLAG_ACK, 0, APP_SMALL_SEGMENT_SIZE);
+      time = osGetSystemTime();
+      immediate |= (ackCount != n) ? TRUE : FALSE;
+      osReleaseMutex(&netMutex);
+
+      //Wait for the delayed ACK
+      osDelayTask(2 * TCP_DELAYED_ACK_TIMEOUT);
+
+      //Delay between the arrival of the segment and its acknowledgment
+      osAcquireMutex(&netMutex);
+      delay = (ackCount != n) ? ackTime - time : INFINITE_DELAY;
+      osReleaseMutex(&netMutex);
+
+      //Keep track of the worst case
+      maxDelay = MAX(maxDelay, delay);
+   }
+
+   TRACE_PRINTF("Worst delayed ACK latency: %" PRIu32 " ms\r\n", maxDelay);
+
+   checkResult("Lone segment not acknowledged immediately", !immediate);
+   checkResult("Delayed ACK sent within TCP_DELAYED_ACK_TIMEOUT",
+      maxDelay <= TCP_DELAYED_ACK_TIMEOUT);
+
+   //Read the data
+   drainSocket(socket);
+}
+
+
+/**
+ * @brief Out-of-order segments and filled gaps are acknowledged immediately
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkOutOfOrder(NetInterface *interface, Socket *socket)
+{
+   uint_t n;
+   uint_t m;
+   uint32_t seqNum;
+
+   //First sequence number of the missing data
+   seqNum = peerSeqNum;
+
+   osAcquireMutex(&netMutex);
+
+   //The second segment arrives before the first one
+   n = ackCount;
+   injectData(interface, seqNum + socket->rmss, TCP_FLAG_ACK, socket->rmss);
+   n = ackCount - n;
+   //The first segment fills the gap
+   m = ackCount;
+   injectData(interface, seqNum, TCP_FLAG_ACK, socket->rmss);
+   m = ackCount - m;
+
+   osReleaseMutex(&netMutex);
+
+   checkResult("Out-of-order segment acknowledged immediately", n == 1);
+   checkResult("Segment filling the gap acknowledged immediately", m == 1);
+
+   //Once the gap has been filled, ACKs are delayed again
+   n = injectSegments(interface, socket, APP_SEGMENT_COUNT);
+   checkResult("One ACK for every second segment once the gap is filled",
+      n == APP_SEGMENT_COUNT / 2);
+
+   //Read the data
+   drainSocket(socket);
+
+   //First sequence number of the missing data
+   seqNum = peerSeqNum;
+
+   osAcquireMutex(&netMutex);
+
+   //The fourth segment arrives first
+   injectData(interface, seqNum + 3 * socket->rmss, TCP_FLAG_ACK,
+      socket->rmss);
+
+   //The first two segments leave the out-of-order data unreachable
+   n = ackCount;
+   injectData(interface, seqNum, TCP_FLAG_ACK, socket->rmss);
+   injectData(interface, seqNum + socket->rmss, TCP_FLAG_ACK, socket->rmss);
+   m = ackCount - n;
+   n = ackCount;
+   //The third segment joins the out-of-order data
+   injectData(interface, seqNum + 2 * socket->rmss, TCP_FLAG_ACK,
+      socket->rmss);
+   n = ackCount - n;
+
+   osReleaseMutex(&netMutex);
+
+   checkResult("In-order segments before the gap acknowledged in pairs",
+      m == 1);
+   checkResult("Segment joining queued data acknowledged immediately",
+      n == 1);
+
+   //Once the gap has been filled, ACKs are delayed again
+   n = injectSegments(interface, socket, APP_SEGMENT_COUNT);
+   checkResult("One ACK for every second segment afterwards",
+      n == APP_SEGMENT_COUNT / 2);
+
+   //Read the data
+   drainSocket(socket);
+}
+
+
+/**
+ * @brief Segments carrying the PSH flag are acknowledged immediately
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkPush(NetInterface *interface, Socket *socket)
+{
+   uint_t n;
+
+   osAcquireMutex(&netMutex);
+   n = ackCount;
+   injectSegment(interface, TCP_FLAG_ACK | TCP_FLAG_PSH, 0,
+      APP_SMALL_SEGMENT_SIZE);
+   n = ackCount - n;
+   osReleaseMutex(&netMutex);
+
+   checkResult("Segment with PSH flag acknowledged immediately", n == 1);
+
+   //Read the data
+   drainSocket(socket);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+   Socket *socket;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Delayed ACK Check ***\r\n");
+   TRACE_INFO("************************************\r\n");
+   TRACE_INFO("\r\n");
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 1);
+
+   //The simulated peer opens the connection
+   peerSeqNum = APP_PEER_ISN;
+
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, TCP_FLAG_SYN, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //The SYN-ACK is sent when the connection is accepted
+   socket = socketAccept(listener, NULL, NULL);
+
+   //Make sure the SYN-ACK has been sent
+   if(socket == NULL || !synAckReceived)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to accept the connection!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Complete the three-way handshake
+   osAcquireMutex(&netMutex);
+   peerAckNum = localSndMax;
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //Let the handshake settle
+   drainSocket(socket);
+
+   //ACK frequency
+   checkAckFrequency(interface, socket);
+   //Delayed ACK timeout
+   checkAckDelay(interface, socket);
+   //Out-of-order segments
+   checkOutOfOrder(interface, socket);
+   //PSH flag
+   checkPush(interface, socket);
+
+   //Close sockets
+   socketClose(socket);
+   socketClose(listener);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,511 @@
+/**
+ * @file main.c
+ * @brief TCP Fast Open check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A TFO client and a TFO server talk to each other over the loopback
+ * interface. The first connection requests a cookie, the second one sends
+ * its data in the SYN, which must be handed to the server by socketAccept,
+ * and the third one presents a corrupted cookie, whose data must be sent
+ * again once the connection is established
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "core/tcp_misc.h"
+#include "drivers/loopback/loopback_driver.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "lo"
+#define APP_IPV4_HOST_ADDR "127.0.0.1"
+#define APP_IPV4_SUBNET_MASK "255.0.0.0"
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+#define APP_TIMEOUT 2000
+
+//Forward declaration of functions
+error_t checkDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+//Global variables
+uint_t synCount;
+uint32_t synSeqNum;
+size_t synDataLen;
+uint32_t synAckAckNum;
+int_t synCookieLen;
+int_t synAckCookieLen;
+uint_t failureCount;
+
+
+/**
+ * @brief Loopback interface whose outgoing SYN segments are inspected
+ **/
+
+const NicDriver checkDriver =
+{
+   NIC_TYPE_LOOPBACK,
+   ETH_MTU,
+   loopbackDriverInit,
+   loopbackDriverTick,
+   loopbackDriverEnableIrq,
+   loopbackDriverDisableIrq,
+   loopbackDriverEventHandler,
+   checkDriverSendPacket,
+   loopbackDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   FALSE,
+   FALSE,
+   FALSE,
+   FALSE
+};
+
+
+/**
+ * @brief Send a packet
+ *
+ * The SYN and SYN ACK segments are parsed to retrieve the TFO option and
+ * the amount of data carried by the SYN. The packet is then looped back
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t checkDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   int_t cookieLen;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   const TcpOption *option;
+   uint8_t packet[ETH_MTU];
+
+   //Copy the packet
+   n = netBufferRead(packet, buffer, offset, sizeof(packet));
+
+   //Point to the IPv4 header
+   ipHeader = (Ipv4Header *) packet;
+
+   //Only TCP segments are of interest
+   if(n >= sizeof(Ipv4Header) && ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (packet + ipHeader->headerLength * 4);
+
+      //Get the TFO option (-1 if the option is absent)
+      option = tcpGetOption(tcpHeader, TCP_OPTION_FAST_OPEN_COOKIE);
+      cookieLen = (option != NULL) ? option->length - 2 : -1;
+
+      //SYN segment?
+      if(tcpHeader->flags == TCP_FLAG_SYN)
+      {
+         synCount++;
+         synSeqNum = ntohl(tcpHeader->seqNum);
+         synCookieLen = cookieLen;
+
+         //Length of the data carried by the SYN
+         synDataLen = ntohs(ipHeader->totalLength) -
+            ipHeader->headerLength * 4 - tcpHeader->dataOffset * 4;
+      }
+      //SYN ACK segment?
+      else if(tcpHeader->flags == (TCP_FLAG_SYN | TCP_FLAG_ACK))
+      {
+         synAckAckNum = ntohl(tcpHeader->ackNum);
+         synAckCookieLen = cookieLen;
+      }
+      else
+      {
+         //Other segments are not inspected
+      }
+   }
+
+   //Loop the packet back
+   return loopbackDriverSendPacket(interface, buffer, offset, ancillary);
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Open a TFO connection and send a message
+ * @param[in] message NULL-terminated string to be sent
+ * @return Handle referencing the client socket
+ **/
+
+Socket *connectAndSend(const char_t *message)
+{
+   error_t error;
+   size_t written;
+   IpAddr serverIpAddr;
+   Socket *socket;
+
+   //Reset the inspected fields
+   synCount = 0;
+   synSeqNum = 0;
+   synDataLen = 0;
+   synAckAckNum = 0;
+   synCookieLen = -1;
+   synAckCookieLen = -1;
+
+   //Open a TFO client socket
+   socket = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketEnableTcpFastOpen(socket, TRUE);
+   socketSetTimeout(socket, APP_TIMEOUT);
+
+   //The SYN is deferred until the first data are sent
+   ipStringToAddr(APP_IPV4_HOST_ADDR, &serverIpAddr);
+   error = socketConnect(socket, &serverIpAddr, APP_SERVER_PORT);
+
+   checkResult("Connection attempt deferred", !error && synCount == 0 &&
+      socket->state == TCP_STATE_SYN_SENT);
+
+   //Send the message
+   error = socketSend(socket, message, osStrlen(message), &written, 0);
+
+   checkResult("Message queued", !error && written == osStrlen(message));
+
+   //Return the client socket
+   return socket;
+}
+
+
+/**
+ * @brief Accept a connection and read a message
+ * @param[in] listener Listening socket
+ * @param[in] message Expected message
+ * @param[out] socket Handle referencing the server socket
+ * @param[out] rcvUser Number of bytes available right after the connection
+ *   has been accepted
+ * @return TRUE if the message has been received, else FALSE
+ **/
+
+bool_t acceptAndReceive(Socket *listener, const char_t *message,
+   Socket **socket, size_t *rcvUser)
+{
+   error_t error;
+   size_t n;
+   size_t length;
+   char_t buffer[64];
+
+   //Accept the connection
+   *socket = socketAccept(listener, NULL, NULL);
+   //Failed to accept the connection?
+   if(*socket == NULL)
+      return FALSE;
+
+   //Data already available?
+   osAcquireMutex(&netMutex);
+   *rcvUser = (*socket)->rcvUser;
+   osReleaseMutex(&netMutex);
+
+   //Read the message
+   socketSetTimeout(*socket, APP_TIMEOUT);
+
+   for(length = 0; length < osStrlen(message); length += n)
+   {
+      error = socketReceive(*socket, buffer + length, osStrlen(message) -
+         length, &n, 0);
+
+      if(error)
+         return FALSE;
+   }
+
+   //Compare the message
+   return (osMemcmp(buffer, message, length) == 0) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief The first connection requests a cookie
+ * @param[in] listener Listening socket
+ * @param[out] cookie Cookie returned by the server
+ **/
+
+void checkCookieRequest(Socket *listener, uint8_t *cookie)
+{
+   bool_t valid;
+   size_t rcvUser;
+   Socket *client;
+   Socket *server;
+   TcpFastOpenCacheEntry *entry;
+   IpAddr serverIpAddr;
+
+   //Send the message
+   client = connectAndSend("cookie request");
+
+   checkResult("SYN carries a cookie request and no data",
+      synCount == 1 && synCookieLen == 0 && synDataLen == 0);
+
+   //Receive the message
+   valid = acceptAndReceive(listener, "cookie request", &server, &rcvUser);
+
+   checkResult("SYN ACK carries a cookie",
+      synAckCookieLen == TCP_FAST_OPEN_COOKIE_SIZE);
+   checkResult("Data received once the connection is established",
+      valid && listener->stats.fastOpenAccepted == 0);
+
+   //The cookie is saved by the client
+   ipStringToAddr(APP_IPV4_HOST_ADDR, &serverIpAddr);
+   entry = tcpFindFastOpenCookie(&serverIpAddr);
+
+   checkResult("Cookie cached by the client", entry != NULL &&
+      entry->cookieLen == TCP_FAST_OPEN_COOKIE_SIZE);
+
+   //Save the cookie
+   if(entry != NULL)
+   {
+      osMemcpy(cookie, entry->cookie, TCP_FAST_OPEN_COOKIE_SIZE);
+   }
+
+   //Close sockets
+   socketClose(client);
+
+   if(server != NULL)
+   {
+      socketClose(server);
+   }
+}
+
+
+/**
+ * @brief The second connection sends its data in the SYN
+ * @param[in] listener Listening socket
+ **/
+
+void checkDataInSyn(Socket *listener)
+{
+   error_t error;
+   bool_t valid;
+   size_t n;
+   size_t rcvUser;
+   char_t buffer[8];
+   Socket *client;
+   Socket *server;
+
+   //Send the message
+   client = connectAndSend("data in SYN");
+
+   checkResult("SYN carries the cookie and the data",
+      synCount == 1 && synCookieLen == TCP_FAST_OPEN_COOKIE_SIZE &&
+      synDataLen == osStrlen("data in SYN"));
+
+   //Receive the message
+   valid = acceptAndReceive(listener, "data in SYN", &server, &rcvUser);
+
+   checkResult("SYN ACK acknowledges the data",
+      synAckAckNum == synSeqNum + 1 + osStrlen("data in SYN"));
+   checkResult("Data handed to the server by socketAccept",
+      valid && rcvUser == osStrlen("data in SYN") &&
+      listener->stats.fastOpenAccepted == 1);
+
+   //The server answers
+   if(server != NULL)
+   {
+      socketSend(server, "pong", 4, NULL, 0);
+   }
+
+   //The client reads the answer
+   error = socketReceive(client, buffer, 4, &n, 0);
+
+   checkResult("Server data received by the client",
+      !error && n == 4 && osMemcmp(buffer, "pong", 4) == 0);
+
+   checkResult("Connection established", client->state ==
+      TCP_STATE_ESTABLISHED && server != NULL &&
+      server->state == TCP_STATE_ESTABLISHED);
+
+   //Close sockets
+   socketClose(client);
+
+   if(server != NULL)
+   {
+      socketClose(server);
+   }
+}
+
+
+/**
+ * @brief The third connection presents a corrupted cookie
+ * @param[in] listener Listening socket
+ * @param[in] cookie Valid cookie
+ **/
+
+void checkInvalidCookie(Socket *listener, const uint8_t *cookie)
+{
+   bool_t valid;
+   size_t rcvUser;
+   Socket *client;
+   Socket *server;
+   TcpFastOpenCacheEntry *entry;
+   IpAddr serverIpAddr;
+
+   //Corrupt the cached cookie
+   ipStringToAddr(APP_IPV4_HOST_ADDR, &serverIpAddr);
+   entry = tcpFindFastOpenCookie(&serverIpAddr);
+
+   if(entry != NULL)
+   {
+      entry->cookie[0] ^= 0xFF;
+   }
+
+   //Send the message
+   client = connectAndSend("corrupted cookie");
+
+   checkResult("SYN carries the corrupted cookie and the data",
+      synCount == 1 && synCookieLen == TCP_FAST_OPEN_COOKIE_SIZE &&
+      synDataLen == osStrlen("corrupted cookie"));
+
+   //Receive the message
+   valid = acceptAndReceive(listener, "corrupted cookie", &server, &rcvUser);
+
+   checkResult("Data of the SYN rejected", synAckAckNum == synSeqNum + 1 &&
+      listener->stats.fastOpenAccepted == 1);
+   checkResult("Data sent again once the connection is established", valid);
+
+   //The server has returned a valid cookie
+   entry = tcpFindFastOpenCookie(&serverIpAddr);
+
+   checkResult("Valid cookie cached again", entry != NULL &&
+      osMemcmp(entry->cookie, cookie, TCP_FAST_OPEN_COOKIE_SIZE) == 0);
+
+   //Close sockets
+   socketClose(client);
+
+   if(server != NULL)
+   {
+      socketClose(server);
+   }
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+   uint8_t cookie[TCP_FAST_OPEN_COOKIE_SIZE];
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("*************************************\r\n");
+   TRACE_INFO("*** CycloneTCP TCP Fast Open Check ***\r\n");
+   TRACE_INFO("*************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the loopback interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &checkDriver);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //Wait for the link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a TFO listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketEnableTcpFastOpen(listener, TRUE);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 4);
+   socketSetTimeout(listener, APP_TIMEOUT);
+
+   //Cookie request
+   checkCookieRequest(listener, cookie);
+   //Data carried by the SYN
+   checkDataInSyn(listener);
+   //Corrupted cookie
+   checkInvalidCookie(listener, cookie);
+
+   //Close the listening socket
+   socketClose(listener);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,664 @@
+/**
+ * @file main.c
+ * @brief TCP header prediction benchmark
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A TCP connection is established with a simulated peer sitting behind a
+ * virtual Ethernet interface. In-order data segments and pure ACKs are then
+ * injected as if they had been received by the NIC, first without options
+ * (header prediction applies) and then with NOP options (generic processing).
+ * The time spent per segment is reported for each case, together with the
+ * per-path counters of the connection
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "ipv4/arp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_PORT 40000
+#define APP_PEER_ISN 1000
+#define APP_PEER_WINDOW 65535
+
+//Benchmark configuration
+#define APP_SERVER_PORT 5001
+#define APP_SEGMENT_SIZE 256
+#define APP_BATCH_SIZE 8
+#define APP_SEGMENT_COUNT 200000
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+uint32_t peerSeqNum;
+uint32_t peerAckNum;
+uint32_t localSndMax;
+bool_t synAckReceived;
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The segments sent by the stack are parsed to track the sequence numbers
+ * of the connection on behalf of the simulated peer
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   size_t length;
+   uint32_t seqNum;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Only TCP segments are of interest
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //Length of the segment data
+      length = ntohs(ipHeader->totalLength) - ipHeader->headerLength * 4 -
+         tcpHeader->dataOffset * 4;
+
+      //Sequence number of the first byte following the segment
+      seqNum = ntohl(tcpHeader->seqNum) + length;
+
+      //The SYN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_SYN) != 0)
+      {
+         seqNum++;
+         synAckReceived = TRUE;
+         localSndMax = seqNum;
+      }
+      else if(TCP_CMP_SEQ(seqNum, localSndMax) > 0)
+      {
+         localSndMax = seqNum;
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[out] frame Buffer where to format the Ethernet frame
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ * @return Length of the frame
+ **/
+
+size_t formatSegment(NetInterface *interface, uint8_t *frame, uint8_t flags,
+   uint_t numNops, size_t length)
+{
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //Length of the TCP segment
+   n = sizeof(TcpHeader) + numNops + length;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Format TCP header
+   tcpHeader->srcPort = HTONS(APP_PEER_PORT);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(peerSeqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(peerAckNum) : 0;
+   tcpHeader->reserved1 = 0;
+   tcpHeader->dataOffset = (sizeof(TcpHeader) + numNops) / 4;
+   tcpHeader->flags = flags;
+   tcpHeader->reserved2 = 0;
+   tcpHeader->window = HTONS(APP_PEER_WINDOW);
+   tcpHeader->checksum = 0;
+   tcpHeader->urgentPointer = 0;
+
+   //Options and payload
+   osMemset(tcpHeader->options, TCP_OPTION_NOP, numNops);
+   osMemset(tcpHeader->options + numNops, 0x55, length);
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = htons(n);
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, n);
+
+   //The SYN flag occupies one sequence number
+   peerSeqNum += length + ((flags & TCP_FLAG_SYN) ? 1 : 0);
+
+   //Return the length of the frame
+   return sizeof(EthHeader) + sizeof(Ipv4Header) + n;
+}
+
+
+/**
+ * @brief Process a frame as if it had been received by the NIC
+ * @param[in] interface Underlying network interface
+ * @param[in] frame Ethernet frame
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(NetInterface *interface, uint8_t *frame, size_t length)
+{
+   NetRxAncillary ancillary;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   nicProcessPacket(interface, frame, length, &ancillary);
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ **/
+
+void injectSegment(NetInterface *interface, uint8_t flags, uint_t numNops,
+   size_t length)
+{
+   size_t n;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Format the segment
+   n = formatSegment(interface, frame, flags, numNops, length);
+   //Process the frame
+   injectFrame(interface, frame, n);
+}
+
+
+/**
+ * @brief Inject in-order data segments and read them back
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ * @param[in] numNops Number of NOP options carried by each segment
+ * @param[out] count Number of injected segments
+ * @return Time spent processing the segments, in milliseconds
+ **/
+
+systime_t benchDataSegments(NetInterface *interface, Socket *socket,
+   uint_t numNops, uint_t *count)
+{
+   uint_t i;
+   uint_t j;
+   size_t n;
+   systime_t startTime;
+   systime_t elapsedTime;
+   static uint8_t frames[APP_BATCH_SIZE][ETH_MAX_FRAME_SIZE];
+   static size_t lengths[APP_BATCH_SIZE];
+   static uint8_t data[APP_BATCH_SIZE * APP_SEGMENT_SIZE];
+
+   //Total processing time
+   elapsedTime = 0;
+   *count = 0;
+
+   //Inject segments by batches that fit in the receive window
+   for(i = 0; i < APP_SEGMENT_COUNT; i += APP_BATCH_SIZE)
+   {
+      //Get exclusive access
+      osAcquireMutex(&netMutex);
+
+      //Format a batch of segments
+      for(j = 0; j < APP_BATCH_SIZE; j++)
+      {
+         lengths[j] = formatSegment(interface, frames[j],
+            TCP_FLAG_ACK | TCP_FLAG_PSH, numNops, APP_SEGMENT_SIZE);
+      }
+
+      //Save current time
+      startTime = osGetSystemTime();
+
+      //Only the processing of the segments is measured
+      for(j = 0; j < APP_BATCH_SIZE; j++)
+      {
+         injectFrame(interface, frames[j], lengths[j]);
+      }
+
+      //Measure elapsed time
+      elapsedTime += osGetSystemTime() - startTime;
+      *count += APP_BATCH_SIZE;
+
+      //Release exclusive access
+      osReleaseMutex(&netMutex);
+
+      //Drain the receive buffer
+      socketReceive(socket, data, sizeof(data), &n, SOCKET_FLAG_WAIT_ALL);
+   }
+
+   //Return processing time
+   return elapsedTime;
+}
+
+
+/**
+ * @brief Send data and inject the corresponding pure ACKs
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ * @param[in] numNops Number of NOP options carried by each ACK
+ * @param[out] count Number of injected ACKs
+ * @return Time spent processing the ACKs, in milliseconds
+ **/
+
+systime_t benchPureAcks(NetInterface *interface, Socket *socket,
+   uint_t numNops, uint_t *count)
+{
+   uint_t i;
+   uint_t j;
+   uint_t k;
+   systime_t startTime;
+   systime_t elapsedTime;
+   static uint8_t frames[2 * APP_BATCH_SIZE][ETH_MAX_FRAME_SIZE];
+   static size_t lengths[2 * APP_BATCH_SIZE];
+   static uint8_t data[APP_BATCH_SIZE * APP_SEGMENT_SIZE];
+
+   //Total processing time
+   elapsedTime = 0;
+   *count = 0;
+
+   //Each batch of data is acknowledged in APP_SEGMENT_SIZE increments
+   for(i = 0; i < APP_SEGMENT_COUNT; i += APP_BATCH_SIZE)
+   {
+      //Send data to the peer
+      socketSend(socket, data, sizeof(data), NULL, 0);
+
+      //Get exclusive access
+      osAcquireMutex(&netMutex);
+
+      //Format the ACKs for the data sent so far
+      for(k = 0; k < arraysize(frames) &&
+         TCP_CMP_SEQ(peerAckNum, localSndMax) < 0; k++)
+      {
+         peerAckNum += MIN(APP_SEGMENT_SIZE, localSndMax - peerAckNum);
+         lengths[k] = formatSegment(interface, frames[k], TCP_FLAG_ACK,
+            numNops, 0);
+      }
+
+      //Save current time
+      startTime = osGetSystemTime();
+
+      //Only the processing of the ACKs is measured
+      for(j = 0; j < k; j++)
+      {
+         injectFrame(interface, frames[j], lengths[j]);
+      }
+
+      //Measure elapsed time
+      elapsedTime += osGetSystemTime() - startTime;
+      *count += k;
+
+      //Release exclusive access
+      osReleaseMutex(&netMutex);
+   }
+
+   //Return processing time
+   return elapsedTime;
+}
+
+
+/**
+ * @brief Display the result of a benchmark phase
+ * @param[in] name Name of the phase
+ * @param[in] count Number of injected segments
+ * @param[in] elapsedTime Processing time, in milliseconds
+ **/
+
+void displayResult(const char_t *name, uint_t count, systime_t elapsedTime)
+{
+   //Avoid division by zero
+   elapsedTime = MAX(elapsedTime, 1);
+
+   //Display benchmark results
+   TRACE_PRINTF("%-28s %7u segments %6" PRIu32 " ms %9" PRIu32
+      " segments/s\r\n", name, count, (uint32_t) elapsedTime,
+      (uint32_t) ((uint64_t) count * 1000 / elapsedTime));
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+   Socket *socket;
+   TcpStats stats;
+   uint_t count[4];
+   systime_t elapsedTime[4];
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("**********************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Header Prediction Benchmark ***\r\n");
+   TRACE_INFO("**********************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 1);
+
+   //The simulated peer opens the connection
+   peerSeqNum = APP_PEER_ISN;
+
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, TCP_FLAG_SYN, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //The SYN-ACK is sent when the connection is accepted
+   socket = socketAccept(listener, NULL, NULL);
+
+   //Make sure the SYN-ACK has been sent
+   if(socket == NULL || !synAckReceived)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to accept the connection!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Complete the three-way handshake
+   osAcquireMutex(&netMutex);
+   peerAckNum = localSndMax;
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //Do not block forever if a segment is lost
+   socketSetTimeout(socket, 1000);
+
+   //In-order data segments
+   elapsedTime[0] = benchDataSegments(interface, socket, 0, &count[0]);
+   elapsedTime[1] = benchDataSegments(interface, socket, 4, &count[1]);
+
+   //In-order pure ACKs
+   elapsedTime[2] = benchPureAcks(interface, socket, 0, &count[2]);
+   elapsedTime[3] = benchPureAcks(interface, socket, 4, &count[3]);
+
+   //Display benchmark results
+   TRACE_PRINTF("%u bytes of data per segment\r\n", APP_SEGMENT_SIZE);
+   displayResult("Data, header prediction:", count[0], elapsedTime[0]);
+   displayResult("Data, generic processing:", count[1], elapsedTime[1]);
+   displayResult("ACKs, header prediction:", count[2], elapsedTime[2]);
+   displayResult("ACKs, generic processing:", count[3], elapsedTime[3]);
+
+   //Retrieve per-path counters
+   osAcquireMutex(&netMutex);
+   stats = socket->stats;
+   osReleaseMutex(&netMutex);
+
+   TRACE_PRINTF("fastPathData: %" PRIu32 ", fastPathAcks: %" PRIu32
+      ", slowPathSegs: %" PRIu32 "\r\n", stats.fastPathData,
+      stats.fastPathAcks, stats.slowPathSegs);
+
+   //Close sockets
+   socketClose(socket);
+   socketClose(listener);
+
+   //Each phase must have taken the expected path
+   return (stats.fastPathData == count[0] && stats.fastPathAcks == count[2] &&
+      stats.slowPathSegs >= (count[1] + count[3])) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
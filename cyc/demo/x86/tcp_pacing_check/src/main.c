@@ -0,0 +1,728 @@
+/**
+ * @file main.c
+ * @brief TCP pacing check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A TCP connection is established with a simulated peer sitting behind a
+ * virtual Ethernet interface. The handshake is acknowledged after APP_RTT
+ * so that the SRTT, and hence the pacing rate, is known. A full send buffer
+ * is then written and the departure time of every data segment is recorded.
+ * After the initial burst, the segments must be spaced according to the
+ * pacing rate. A second run acknowledges part of the window while segments
+ * are held back, and the tail of the buffer must still be sent without
+ * waiting for the remaining data to be acknowledged
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "ipv4/arp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_PORT 40000
+#define APP_PEER_ISN 1000
+#define APP_PEER_WINDOW 65535
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+#define APP_RTT 400
+#define APP_MAX_SEGMENTS 32
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+uint32_t peerSeqNum;
+uint32_t peerAckNum;
+uint32_t localSndMax;
+bool_t synAckReceived;
+uint_t segCount;
+systime_t segTime[APP_MAX_SEGMENTS];
+size_t segLength[APP_MAX_SEGMENTS];
+uint_t failureCount;
+uint8_t txBuffer[TCP_DEFAULT_TX_BUFFER_SIZE];
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The segments sent by the stack are parsed to track the sequence numbers
+ * of the connection on behalf of the simulated peer, and the departure time
+ * of every new data segment is recorded
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   size_t length;
+   uint32_t seqNum;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Only TCP segments are of interest
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //Length of the segment data
+      length = ntohs(ipHeader->totalLength) - ipHeader->headerLength * 4 -
+         tcpHeader->dataOffset * 4;
+
+      //Sequence number of the first byte following the segment
+      seqNum = ntohl(tcpHeader->seqNum) + length;
+
+      //The FIN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_FIN) != 0)
+      {
+         seqNum++;
+      }
+
+      //The SYN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_SYN) != 0)
+      {
+         seqNum++;
+         synAckReceived = TRUE;
+         localSndMax = seqNum;
+      }
+      else if(TCP_CMP_SEQ(seqNum, localSndMax) > 0)
+      {
+         //Record the departure time of new data
+         if(length > 0 && segCount < APP_MAX_SEGMENTS)
+         {
+            segTime[segCount] = osGetSystemTime();
+            segLength[segCount] = length;
+            segCount++;
+         }
+
+         localSndMax = seqNum;
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[out] frame Buffer where to format the Ethernet frame
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ * @return Length of the frame
+ **/
+
+size_t formatSegment(NetInterface *interface, uint8_t *frame, uint8_t flags,
+   uint_t numNops, size_t length)
+{
+   size_t i;
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //Length of the TCP segment
+   n = sizeof(TcpHeader) + numNops + length;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Format TCP header
+   tcpHeader->srcPort = HTONS(APP_PEER_PORT);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(peerSeqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(peerAckNum) : 0;
+   tcpHeader->reserved1 = 0;
+   tcpHeader->dataOffset = (sizeof(TcpHeader) + numNops) / 4;
+   tcpHeader->flags = flags;
+   tcpHeader->reserved2 = 0;
+   tcpHeader->window = HTONS(APP_PEER_WINDOW);
+   tcpHeader->checksum = 0;
+   tcpHeader->urgentPointer = 0;
+
+   //Options
+   osMemset(tcpHeader->options, TCP_OPTION_NOP, numNops);
+
+   //Each byte of the payload is derived from its sequence number
+   for(i = 0; i < length; i++)
+   {
+      tcpHeader->options[numNops + i] = (uint8_t) (peerSeqNum + i);
+   }
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = htons(n);
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, n);
+
+   //The SYN flag occupies one sequence number
+   peerSeqNum += length + ((flags & TCP_FLAG_SYN) ? 1 : 0);
+
+   //Return the length of the frame
+   return sizeof(EthHeader) + sizeof(Ipv4Header) + n;
+}
+
+
+/**
+ * @brief Process a frame as if it had been received by the NIC
+ * @param[in] interface Underlying network interface
+ * @param[in] frame Ethernet frame
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(NetInterface *interface, uint8_t *frame, size_t length)
+{
+   NetRxAncillary ancillary;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   nicProcessPacket(interface, frame, length, &ancillary);
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ **/
+
+void injectSegment(NetInterface *interface, uint8_t flags, uint_t numNops,
+   size_t length)
+{
+   size_t n;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Format the segment
+   n = formatSegment(interface, frame, flags, numNops, length);
+   //Process the frame
+   injectFrame(interface, frame, n);
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Write a full send buffer
+ * @param[in] socket Connected socket
+ * @return Sequence number of the first byte written
+ **/
+
+uint32_t sendBuffer(Socket *socket)
+{
+   uint32_t seqNum;
+
+   //Reset the departure times
+   osAcquireMutex(&netMutex);
+   segCount = 0;
+   seqNum = localSndMax;
+   osReleaseMutex(&netMutex);
+
+   //The whole buffer is written at once and must be pushed
+   socketSend(socket, txBuffer, sizeof(txBuffer), NULL, SOCKET_FLAG_NO_DELAY);
+
+   //Return the sequence number of the first byte
+   return seqNum;
+}
+
+
+/**
+ * @brief Acknowledge all the data sent so far
+ * @param[in] interface Underlying network interface
+ **/
+
+void acknowledgeAll(NetInterface *interface)
+{
+   osAcquireMutex(&netMutex);
+   peerAckNum = localSndMax;
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //Let the stack process the ACK
+   osDelayTask(50);
+}
+
+
+/**
+ * @brief Segments are spaced according to the pacing rate
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkSpacing(NetInterface *interface, Socket *socket)
+{
+   uint_t i;
+   uint32_t rate;
+   uint32_t expectedRate;
+   size_t burst;
+   size_t length;
+   systime_t expected;
+   systime_t elapsed;
+   int32_t delta;
+   int32_t minDelta;
+   int32_t maxDelta;
+
+   //Write a full send buffer
+   sendBuffer(socket);
+
+   //Retrieve the pacing rate
+   osAcquireMutex(&netMutex);
+   rate = socket->pacingRate;
+   expectedRate = (uint32_t) ((uint64_t) MIN(APP_PEER_WINDOW,
+      socket->txBufferSize) * TCP_PACING_CA_GAIN * 10 / socket->srtt);
+   burst = TCP_PACING_MAX_BURST * socket->smss;
+   osReleaseMutex(&netMutex);
+
+   TRACE_PRINTF("SRTT = %" PRIu32 " ms, pacing rate = %" PRIu32 " bytes/s\r\n",
+      socket->srtt, rate);
+
+   checkResult("Pacing rate derived from the window and SRTT",
+      rate != 0 && rate == expectedRate);
+
+   //Wait for the whole buffer to be sent
+   osDelayTask(2 * sizeof(txBuffer) * 1000 / MAX(rate, 1));
+
+   osAcquireMutex(&netMutex);
+
+   //Initialize variables
+   length = 0;
+   minDelta = 0;
+   maxDelta = 0;
+
+   //Compare the departure time of each segment with the time at which the
+   //pacing credit allows it to be sent
+   for(i = 0; i < segCount; i++)
+   {
+      //The first segments are sent back-to-back
+      if(length >= burst)
+      {
+         expected = (systime_t) (((uint64_t) (length - burst) * 1000 +
+            rate - 1) / rate);
+         elapsed = segTime[i] - segTime[0];
+
+         delta = (int32_t) (elapsed - expected);
+         minDelta = MIN(minDelta, delta);
+         maxDelta = MAX(maxDelta, delta);
+      }
+
+      //Number of bytes sent so far
+      length += segLength[i];
+   }
+
+   TRACE_PRINTF("%u segment(s) sent in %" PRIu32 " ms (%d/+%d ms from the "
+      "pacing schedule)\r\n", segCount, (segCount > 0) ?
+      segTime[segCount - 1] - segTime[0] : 0, minDelta, maxDelta);
+
+   osReleaseMutex(&netMutex);
+
+   checkResult("Whole buffer sent", length == sizeof(txBuffer));
+   checkResult("Initial burst limited to TCP_PACING_MAX_BURST segments",
+      segCount > TCP_PACING_MAX_BURST &&
+      segTime[TCP_PACING_MAX_BURST] != segTime[0]);
+   checkResult("No segment sent ahead of the pacing rate", minDelta >= -1);
+   checkResult("No segment delayed by more than two pacing ticks",
+      maxDelta <= 2 * TCP_PACING_TICK_INTERVAL);
+
+   //Acknowledge the data
+   acknowledgeAll(interface);
+}
+
+
+/**
+ * @brief Held segments keep their flags when an ACK is received
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkHeldFlags(NetInterface *interface, Socket *socket)
+{
+   uint32_t seqNum;
+   uint32_t pacedSegs;
+   systime_t gap;
+   systime_t interval;
+
+   //Save the number of paced segments
+   pacedSegs = socket->stats.pacedSegs;
+
+   //Write a full send buffer
+   seqNum = sendBuffer(socket);
+
+   //Wait until some segments are held back
+   osDelayTask(100);
+
+   //Acknowledge the first segment only. The ACK triggers the Nagle algorithm
+   //without the SOCKET_FLAG_NO_DELAY flag the data were written with
+   osAcquireMutex(&netMutex);
+   peerAckNum = seqNum + segLength[0];
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //Wait for the remaining segments to be released by the pacing timer
+   osDelayTask(2 * sizeof(txBuffer) * 1000 / MAX(socket->pacingRate, 1));
+
+   osAcquireMutex(&netMutex);
+
+   //Time between the last two segments
+   gap = (segCount > 1) ? segTime[segCount - 1] - segTime[segCount - 2] :
+      INFINITE_DELAY;
+
+   //Time needed to earn the credit for the last full-sized segment
+   interval = (segCount > 1) ? (systime_t) ((uint64_t) segLength[segCount - 2] *
+      1000 / MAX(socket->pacingRate, 1)) : 0;
+
+   TRACE_PRINTF("Tail sent %" PRIu32 " ms after the previous segment "
+      "(pacing interval = %" PRIu32 " ms)\r\n", gap, interval);
+
+   checkResult("Segments held back by pacing",
+      socket->stats.pacedSegs != pacedSegs);
+   checkResult("Whole buffer sent", localSndMax == seqNum + sizeof(txBuffer));
+   checkResult("Tail released by the pacing timer",
+      gap <= interval + 2 * TCP_PACING_TICK_INTERVAL);
+   checkResult("Nothing left held back", !socket->pacingPending &&
+      socket->sndUser == 0);
+
+   osReleaseMutex(&netMutex);
+
+   //Acknowledge the data
+   acknowledgeAll(interface);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+   Socket *socket;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("********************************\r\n");
+   TRACE_INFO("*** CycloneTCP Pacing Check ***\r\n");
+   TRACE_INFO("********************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 1);
+
+   //The simulated peer opens the connection
+   peerSeqNum = APP_PEER_ISN;
+
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, TCP_FLAG_SYN, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //The SYN-ACK is sent when the connection is accepted
+   socket = socketAccept(listener, NULL, NULL);
+
+   //Make sure the SYN-ACK has been sent
+   if(socket == NULL || !synAckReceived)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to accept the connection!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //The SYN-ACK is acknowledged after one RTT
+   osDelayTask(APP_RTT);
+
+   //Complete the three-way handshake
+   osAcquireMutex(&netMutex);
+   peerAckNum = localSndMax;
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //Segment spacing
+   checkSpacing(interface, socket);
+   //Flags of the held segments
+   checkHeldFlags(interface, socket);
+
+   //Close sockets
+   socketClose(socket);
+   socketClose(listener);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
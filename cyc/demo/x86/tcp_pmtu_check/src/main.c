@@ -0,0 +1,737 @@
+/**
+ * @file main.c
+ * @brief TCP PMTU update check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A simulated peer sitting behind a virtual Ethernet interface opens two
+ * TCP connections, and data are left unacknowledged on the first one.
+ * ICMP Fragmentation Needed messages are then injected. Messages quoting
+ * another 4-tuple or a sequence number outside SND.UNA..SND.NXT must be
+ * ignored, while a valid message must reduce the MSS of the connection it
+ * refers to, and of that connection only
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "ipv4/arp_cache.h"
+#include "ipv4/icmp.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_PORT 40000
+#define APP_PEER_ISN 1000
+#define APP_PEER_WINDOW 65535
+#define APP_PEER_MSS 1400
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+#define APP_DATA_SIZE 2800
+#define APP_PATH_MTU 1200
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+/**
+ * @brief Connection of the simulated peer
+ **/
+
+typedef struct
+{
+   uint16_t port;
+   uint32_t seqNum;
+   uint32_t ackNum;
+   uint32_t localSndMax;
+   bool_t synAckReceived;
+   size_t maxSegLength;
+   Socket *socket;
+} PeerConnection;
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+PeerConnection peerConnection[2];
+uint_t failureCount;
+uint8_t txBuffer[APP_DATA_SIZE];
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The segments sent by the stack are parsed to track the sequence numbers
+ * of each connection on behalf of the simulated peer, along with the size
+ * of the largest data segment
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   uint_t i;
+   size_t n;
+   size_t length;
+   uint32_t seqNum;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   PeerConnection *connection;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Only TCP segments are of interest
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //Loop through the connections of the simulated peer
+      for(i = 0; i < arraysize(peerConnection); i++)
+      {
+         //Point to the current connection
+         connection = &peerConnection[i];
+
+         //Matching connection?
+         if(ntohs(tcpHeader->destPort) != connection->port)
+            continue;
+
+         //Length of the segment data
+         length = ntohs(ipHeader->totalLength) - ipHeader->headerLength * 4 -
+            tcpHeader->dataOffset * 4;
+
+         //Keep track of the largest data segment
+         connection->maxSegLength = MAX(connection->maxSegLength, length);
+
+         //Sequence number of the first byte following the segment
+         seqNum = ntohl(tcpHeader->seqNum) + length;
+
+         //The SYN flag occupies one sequence number
+         if((tcpHeader->flags & TCP_FLAG_SYN) != 0)
+         {
+            seqNum++;
+            connection->synAckReceived = TRUE;
+            connection->localSndMax = seqNum;
+         }
+         else if(TCP_CMP_SEQ(seqNum, connection->localSndMax) > 0)
+         {
+            connection->localSndMax = seqNum;
+         }
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Process a frame as if it had been received by the NIC
+ * @param[in] interface Underlying network interface
+ * @param[in] frame Ethernet frame
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(NetInterface *interface, uint8_t *frame, size_t length)
+{
+   NetRxAncillary ancillary;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   nicProcessPacket(interface, frame, length, &ancillary);
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] connection Connection of the simulated peer
+ * @param[in] flags TCP flags
+ **/
+
+void injectSegment(NetInterface *interface, PeerConnection *connection,
+   uint8_t flags)
+{
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //Format TCP header
+   tcpHeader->srcPort = htons(connection->port);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(connection->seqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(connection->ackNum) : 0;
+   tcpHeader->reserved1 = 0;
+   tcpHeader->dataOffset = sizeof(TcpHeader) / 4;
+   tcpHeader->flags = flags;
+   tcpHeader->reserved2 = 0;
+   tcpHeader->window = HTONS(APP_PEER_WINDOW);
+   tcpHeader->checksum = 0;
+   tcpHeader->urgentPointer = 0;
+
+   //The SYN advertises the MSS of the peer
+   if((flags & TCP_FLAG_SYN) != 0)
+   {
+      tcpHeader->options[0] = TCP_OPTION_MAX_SEGMENT_SIZE;
+      tcpHeader->options[1] = 4;
+      STORE16BE(APP_PEER_MSS, tcpHeader->options + 2);
+      tcpHeader->dataOffset++;
+   }
+
+   //Length of the TCP segment
+   n = tcpHeader->dataOffset * 4;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = htons(n);
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, n);
+
+   //The SYN flag occupies one sequence number
+   connection->seqNum += (flags & TCP_FLAG_SYN) ? 1 : 0;
+
+   //Process the frame
+   injectFrame(interface, frame, sizeof(EthHeader) + sizeof(Ipv4Header) + n);
+}
+
+
+/**
+ * @brief Inject an ICMP Fragmentation Needed message
+ *
+ * The message is sent by a router on the path to the peer and quotes the
+ * first 8 bytes of the TCP header of the invoking segment
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] srcPort Source port of the invoking segment
+ * @param[in] destPort Destination port of the invoking segment
+ * @param[in] seqNum Sequence number of the invoking segment
+ * @param[in] pathMtu MTU of the next-hop network
+ **/
+
+void injectFragNeeded(NetInterface *interface, uint16_t srcPort,
+   uint16_t destPort, uint32_t seqNum, size_t pathMtu)
+{
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   IcmpDestUnreachableMessage *message;
+   Ipv4Header *quotedIpHeader;
+   TcpHeader *quotedTcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   message = (IcmpDestUnreachableMessage *) ipHeader->options;
+   quotedIpHeader = (Ipv4Header *) message->data;
+   quotedTcpHeader = (TcpHeader *) quotedIpHeader->options;
+
+   //Length of the ICMP message
+   n = sizeof(IcmpDestUnreachableMessage) + sizeof(Ipv4Header) + 8;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = 0;
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_ICMP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Quote the IPv4 header of the invoking packet
+   quotedIpHeader->version = IPV4_VERSION;
+   quotedIpHeader->headerLength = 5;
+   quotedIpHeader->typeOfService = 0;
+   quotedIpHeader->totalLength = HTONS(ETH_MTU);
+   quotedIpHeader->identification = 0;
+   quotedIpHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   quotedIpHeader->timeToLive = 64;
+   quotedIpHeader->protocol = IPV4_PROTOCOL_TCP;
+   quotedIpHeader->headerChecksum = 0;
+   quotedIpHeader->srcAddr = interface->ipv4Context.addrList[0].addr;
+   quotedIpHeader->destAddr = peerIpAddr;
+
+   //Quote the ports and the sequence number of the invoking segment
+   quotedTcpHeader->srcPort = htons(srcPort);
+   quotedTcpHeader->destPort = htons(destPort);
+   quotedTcpHeader->seqNum = htonl(seqNum);
+
+   //Format ICMP message
+   message->type = ICMP_TYPE_DEST_UNREACHABLE;
+   message->code = ICMP_CODE_FRAG_NEEDED_AND_DF_SET;
+   message->checksum = 0;
+   message->unused = htonl(pathMtu);
+   message->checksum = ipCalcChecksum(message, n);
+
+   //Process the frame
+   injectFrame(interface, frame, sizeof(EthHeader) + sizeof(Ipv4Header) + n);
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Open a connection from the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] listener Listening socket
+ * @param[in] connection Connection of the simulated peer
+ * @param[in] port Port number of the peer
+ * @return Error code
+ **/
+
+error_t openConnection(NetInterface *interface, Socket *listener,
+   PeerConnection *connection, uint16_t port)
+{
+   //Initialize the connection of the simulated peer
+   connection->port = port;
+   connection->seqNum = APP_PEER_ISN;
+
+   //Send a SYN
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, connection, TCP_FLAG_SYN);
+   osReleaseMutex(&netMutex);
+
+   //The SYN-ACK is sent when the connection is accepted
+   connection->socket = socketAccept(listener, NULL, NULL);
+
+   //Make sure the SYN-ACK has been sent
+   if(connection->socket == NULL || !connection->synAckReceived)
+      return ERROR_FAILURE;
+
+   //Complete the three-way handshake
+   osAcquireMutex(&netMutex);
+   connection->ackNum = connection->localSndMax;
+   injectSegment(interface, connection, TCP_FLAG_ACK);
+   osReleaseMutex(&netMutex);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Forged messages are ignored
+ * @param[in] interface Underlying network interface
+ **/
+
+void checkForgedMessages(NetInterface *interface)
+{
+   Socket *socket;
+
+   //Point to the connection the data are sent on
+   socket = peerConnection[0].socket;
+
+   osAcquireMutex(&netMutex);
+
+   //Quote a port that does not belong to any connection
+   injectFragNeeded(interface, APP_SERVER_PORT, APP_PEER_PORT + 2,
+      socket->sndUna, APP_PATH_MTU);
+
+   checkResult("Unknown 4-tuple ignored", socket->smss == APP_PEER_MSS &&
+      peerConnection[1].socket->smss == APP_PEER_MSS);
+
+   //Quote data that have already been acknowledged
+   injectFragNeeded(interface, APP_SERVER_PORT, peerConnection[0].port,
+      socket->sndUna - 1, APP_PATH_MTU);
+
+   checkResult("Sequence number below SND.UNA ignored",
+      socket->smss == APP_PEER_MSS);
+
+   //Quote data that have not been sent yet
+   injectFragNeeded(interface, APP_SERVER_PORT, peerConnection[0].port,
+      socket->sndNxt, APP_PATH_MTU);
+
+   checkResult("Sequence number at or above SND.NXT ignored",
+      socket->smss == APP_PEER_MSS);
+
+   //Quote a segment that has been sent on the idle connection
+   injectFragNeeded(interface, APP_SERVER_PORT, peerConnection[1].port,
+      peerConnection[1].socket->sndUna, APP_PATH_MTU);
+
+   checkResult("No unacknowledged data on the quoted connection",
+      peerConnection[1].socket->smss == APP_PEER_MSS);
+
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief A valid message reduces the MSS of the connection it refers to
+ * @param[in] interface Underlying network interface
+ **/
+
+void checkValidMessage(NetInterface *interface)
+{
+   size_t mss;
+   Socket *socket;
+
+   //Point to the connection the data are sent on
+   socket = peerConnection[0].socket;
+
+   //Expected MSS
+   mss = APP_PATH_MTU - sizeof(Ipv4Header) - sizeof(TcpHeader);
+
+   osAcquireMutex(&netMutex);
+
+   //Only the segments sent from now on are of interest
+   peerConnection[0].maxSegLength = 0;
+
+   //Quote the second segment in flight
+   injectFragNeeded(interface, APP_SERVER_PORT, peerConnection[0].port,
+      socket->sndUna + APP_PEER_MSS, APP_PATH_MTU);
+
+   TRACE_PRINTF("MSS = %u bytes, retransmitted segment = %" PRIuSIZE
+      " bytes\r\n", socket->smss, peerConnection[0].maxSegLength);
+
+   checkResult("MSS reduced to the reported PMTU", socket->smss == mss);
+   checkResult("Outstanding data resent with the new MSS",
+      peerConnection[0].maxSegLength > 0 &&
+      peerConnection[0].maxSegLength <= mss);
+   checkResult("Other connection to the same host left untouched",
+      peerConnection[1].socket->smss == APP_PEER_MSS);
+
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   uint_t i;
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("************************************\r\n");
+   TRACE_INFO("*** CycloneTCP PMTU Update Check ***\r\n");
+   TRACE_INFO("************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 2);
+
+   //The simulated peer opens two connections
+   for(i = 0; i < arraysize(peerConnection); i++)
+   {
+      //Open a new connection
+      error = openConnection(interface, listener, &peerConnection[i],
+         APP_PEER_PORT + i);
+
+      //Any error to report?
+      if(error)
+      {
+         //Debug message
+         TRACE_ERROR("Failed to accept the connection!\r\n");
+         return EXIT_FAILURE;
+      }
+   }
+
+   //Full-sized segments are left unacknowledged on the first connection
+   socketSend(peerConnection[0].socket, txBuffer, sizeof(txBuffer), NULL,
+      SOCKET_FLAG_NO_DELAY);
+
+   checkResult("Data in flight with the MSS of the peer",
+      peerConnection[0].socket->smss == APP_PEER_MSS &&
+      peerConnection[0].maxSegLength == APP_PEER_MSS);
+
+   //Forged messages
+   checkForgedMessages(interface);
+   //Valid message
+   checkValidMessage(interface);
+
+   //Close sockets
+   for(i = 0; i < arraysize(peerConnection); i++)
+   {
+      socketClose(peerConnection[i].socket);
+   }
+
+   socketClose(listener);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,760 @@
+/**
+ * @file main.c
+ * @brief SYN cookie check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Simulated clients sitting behind a virtual Ethernet interface flood a
+ * listening socket with SYN segments. Once the SYN queue is full, the SYN
+ * ACKs carry SYN cookies. The final ACKs echoing valid cookies must yield
+ * established connections whose MSS, SACK and window scale match the SYN,
+ * while forged, replayed and stale cookies must be rejected
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "core/tcp_misc.h"
+#include "ipv4/arp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated clients
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_ISN 1000
+#define APP_PEER_MSS 1220
+#define APP_PEER_WND_SHIFT 7
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+#define APP_FLOOD_SIZE 8
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+uint16_t peerPort;
+uint32_t peerSeqNum;
+uint32_t peerAckNum;
+uint16_t peerWindow;
+uint_t synAckCount;
+uint16_t synAckPort;
+uint32_t synAckSeqNum;
+int_t synAckWndShift;
+uint_t rstCount;
+uint_t failureCount;
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The SYN ACK segments sent by the stack are parsed to retrieve the initial
+ * sequence number and the window scale option, and the RST segments are
+ * counted
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   const TcpOption *option;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Only TCP segments are of interest
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //SYN ACK segment?
+      if(tcpHeader->flags == (TCP_FLAG_SYN | TCP_FLAG_ACK))
+      {
+         synAckCount++;
+         synAckPort = ntohs(tcpHeader->destPort);
+         synAckSeqNum = ntohl(tcpHeader->seqNum);
+
+         //Get the Window Scale option
+         option = tcpGetOption(tcpHeader, TCP_OPTION_WINDOW_SCALE_FACTOR);
+
+         //Save the shift count (-1 if the option is absent)
+         if(option != NULL && option->length == 3)
+         {
+            synAckWndShift = option->value[0];
+         }
+         else
+         {
+            synAckWndShift = -1;
+         }
+      }
+
+      //RST segment?
+      if((tcpHeader->flags & TCP_FLAG_RST) != 0)
+      {
+         rstCount++;
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by a simulated client
+ * @param[in] interface Underlying network interface
+ * @param[in] flags TCP flags
+ * @param[in] seqNum Sequence number
+ * @param[in] ackNum Acknowledgment number
+ * @param[in] wndShift Shift count of the Window Scale option carried by a
+ *   SYN (-1 if the option is absent)
+ **/
+
+void injectSegment(NetInterface *interface, uint8_t flags, uint32_t seqNum,
+   uint32_t ackNum, int_t wndShift)
+{
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+   NetRxAncillary ancillary;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //Format TCP header
+   tcpHeader->srcPort = htons(peerPort);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(seqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(ackNum) : 0;
+   tcpHeader->reserved1 = 0;
+   tcpHeader->dataOffset = sizeof(TcpHeader) / 4;
+   tcpHeader->flags = flags;
+   tcpHeader->reserved2 = 0;
+   tcpHeader->window = htons(peerWindow);
+   tcpHeader->checksum = 0;
+   tcpHeader->urgentPointer = 0;
+
+   //SYN segment?
+   if((flags & TCP_FLAG_SYN) != 0)
+   {
+      uint16_t mss;
+      uint8_t shift;
+
+      //Maximum Segment Size option
+      mss = HTONS(APP_PEER_MSS);
+      tcpAddOption(tcpHeader, TCP_OPTION_MAX_SEGMENT_SIZE, &mss, sizeof(mss));
+
+      //Window Scale option
+      if(wndShift >= 0)
+      {
+         shift = (uint8_t) wndShift;
+         tcpAddOption(tcpHeader, TCP_OPTION_WINDOW_SCALE_FACTOR, &shift,
+            sizeof(shift));
+      }
+
+      //SACK Permitted option
+      tcpAddOption(tcpHeader, TCP_OPTION_SACK_PERMITTED, NULL, 0);
+   }
+
+   //Length of the TCP segment
+   n = tcpHeader->dataOffset * 4;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = htons(n);
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, n);
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame as if it had been received by the NIC
+   osAcquireMutex(&netMutex);
+   nicProcessPacket(interface, frame, sizeof(EthHeader) + sizeof(Ipv4Header) +
+      n, &ancillary);
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Send a SYN from a given client and retrieve the SYN ACK
+ * @param[in] interface Underlying network interface
+ * @param[in] port Port number of the client
+ * @param[in] wndShift Shift count of the Window Scale option (-1 if the
+ *   option is absent)
+ * @param[out] cookie Initial sequence number of the SYN ACK sent in response
+ * @return TRUE if a SYN ACK has been sent immediately, else FALSE
+ **/
+
+bool_t sendSyn(NetInterface *interface, uint16_t port, int_t wndShift,
+   uint32_t *cookie)
+{
+   uint_t n;
+
+   //Save the number of SYN ACKs
+   n = synAckCount;
+
+   //Inject the SYN
+   peerPort = port;
+   peerWindow = UINT16_MAX;
+   injectSegment(interface, TCP_FLAG_SYN, APP_PEER_ISN, 0, wndShift);
+
+   //Initial sequence number chosen by the server
+   *cookie = synAckSeqNum;
+
+   //Check whether the SYN has been answered with a SYN cookie
+   return (synAckCount != n && synAckPort == port) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Send the final ACK of a handshake
+ * @param[in] interface Underlying network interface
+ * @param[in] port Port number of the client
+ * @param[in] cookie Initial sequence number of the server
+ * @param[in] window Window advertised by the client (before scaling)
+ **/
+
+void sendAck(NetInterface *interface, uint16_t port, uint32_t cookie,
+   uint16_t window)
+{
+   //Inject the ACK
+   peerPort = port;
+   peerWindow = window;
+   injectSegment(interface, TCP_FLAG_ACK, APP_PEER_ISN + 1, cookie + 1, -1);
+}
+
+
+/**
+ * @brief Regular handshakes negotiate the window scale option
+ * @param[in] interface Underlying network interface
+ * @param[in] listener Listening socket
+ **/
+
+void checkRegularHandshake(NetInterface *interface, Socket *listener)
+{
+   uint32_t iss;
+   Socket *socket;
+
+   //The client offers the window scale option
+   sendSyn(interface, 40000, APP_PEER_WND_SHIFT, &iss);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Connection request queued", socket != NULL);
+
+   if(socket != NULL)
+   {
+      checkResult("SYN ACK carries the window scale option",
+         synAckPort == 40000 && synAckWndShift == 0);
+
+      //Complete the handshake
+      sendAck(interface, 40000, synAckSeqNum, 100);
+
+      checkResult("Window of the final ACK scaled",
+         socket->state == TCP_STATE_ESTABLISHED &&
+         socket->sndWnd == (100 << APP_PEER_WND_SHIFT));
+
+      socketClose(socket);
+   }
+
+   //The client does not offer the window scale option
+   sendSyn(interface, 40001, -1, &iss);
+   socket = socketAccept(listener, NULL, NULL);
+
+   if(socket != NULL)
+   {
+      checkResult("SYN ACK without the window scale option",
+         synAckPort == 40001 && synAckWndShift < 0);
+
+      //Complete the handshake
+      sendAck(interface, 40001, synAckSeqNum, 100);
+
+      checkResult("Window of the final ACK not scaled",
+         socket->state == TCP_STATE_ESTABLISHED && socket->sndWnd == 100);
+
+      socketClose(socket);
+   }
+}
+
+
+/**
+ * @brief SYN flood answered with SYN cookies
+ * @param[in] interface Underlying network interface
+ * @param[in] listener Listening socket
+ **/
+
+void checkSynFlood(NetInterface *interface, Socket *listener)
+{
+   uint_t i;
+   uint_t n;
+   bool_t valid;
+   uint32_t cookie;
+   uint32_t cookies[APP_FLOOD_SIZE];
+   Socket *socket;
+
+   //The first request fills the SYN queue
+   valid = !sendSyn(interface, 41000, APP_PEER_WND_SHIFT, &cookie);
+   checkResult("First SYN queued", valid);
+
+   //Save the number of cookies
+   n = listener->stats.synCookiesSent;
+
+   //Flood the listening socket
+   for(valid = TRUE, i = 0; i < APP_FLOOD_SIZE; i++)
+   {
+      valid &= sendSyn(interface, 41001 + i, APP_PEER_WND_SHIFT, &cookies[i]);
+      valid &= (synAckWndShift == 0) ? TRUE : FALSE;
+   }
+
+   checkResult("SYN flood answered with SYN cookies", valid &&
+      listener->stats.synCookiesSent - n == APP_FLOOD_SIZE);
+
+   //Complete one of the handshakes
+   sendAck(interface, 41001, cookies[0], 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Valid cookie yields a connection", socket != NULL &&
+      listener->stats.synCookiesValid == 1);
+
+   if(socket != NULL)
+   {
+      checkResult("Connection established", socket->state ==
+         TCP_STATE_ESTABLISHED && socket->remotePort == 41001);
+      checkResult("MSS and SACK Permitted decoded from the cookie",
+         socket->smss == APP_PEER_MSS && socket->sackPermitted);
+      checkResult("Window scale decoded from the cookie",
+         socket->wndScaleEnabled && socket->sndWndShift == APP_PEER_WND_SHIFT);
+      checkResult("Window of the final ACK scaled",
+         socket->sndWnd == (100 << APP_PEER_WND_SHIFT));
+
+      //Window update
+      peerWindow = 200;
+      injectSegment(interface, TCP_FLAG_ACK, APP_PEER_ISN + 1, cookies[0] + 1,
+         -1);
+
+      checkResult("Window updates scaled",
+         socket->sndWnd == (200 << APP_PEER_WND_SHIFT));
+
+      //The send window is bounded by the SND.WND variable
+      peerWindow = 1000;
+      injectSegment(interface, TCP_FLAG_ACK, APP_PEER_ISN + 1, cookies[0] + 1,
+         -1);
+
+      checkResult("Scaled window clamped", socket->sndWnd == UINT16_MAX);
+
+      socketClose(socket);
+   }
+
+   //Fill the SYN queue again
+   sendSyn(interface, 41000, APP_PEER_WND_SHIFT, &cookie);
+
+   //A client that does not offer the window scale option
+   valid = sendSyn(interface, 41100, -1, &cookie);
+
+   checkResult("SYN ACK cookie without the window scale option",
+      valid && synAckWndShift < 0);
+
+   sendAck(interface, 41100, cookie, 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Valid cookie yields a connection", socket != NULL);
+
+   if(socket != NULL)
+   {
+      checkResult("Window not scaled", !socket->wndScaleEnabled &&
+         socket->sndWnd == 100);
+
+      socketClose(socket);
+   }
+
+   //Forged cookie
+   n = rstCount;
+   sendAck(interface, 41002, cookies[1] ^ 0x00000001, 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Forged cookie rejected with a RST", socket == NULL &&
+      rstCount == n + 1 && listener->stats.synCookiesFailed == 1);
+
+   //The window scale is authenticated by the cookie
+   sendAck(interface, 41003, cookies[2] ^ 0x00400000, 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Cookie with a modified window scale rejected",
+      socket == NULL && listener->stats.synCookiesFailed == 2);
+
+   //The cookie is bound to the 4-tuple
+   sendAck(interface, 41099, cookies[3], 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Cookie replayed from another port rejected",
+      socket == NULL && listener->stats.synCookiesFailed == 3);
+
+   //The genuine client is still welcome
+   sendAck(interface, 41004, cookies[3], 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Genuine client accepted", socket != NULL);
+
+   if(socket != NULL)
+   {
+      socketClose(socket);
+   }
+}
+
+
+/**
+ * @brief Cookies expire after two periods
+ * @param[in] interface Underlying network interface
+ * @param[in] listener Listening socket
+ **/
+
+void checkStaleCookie(NetInterface *interface, Socket *listener)
+{
+   uint32_t cookie1;
+   uint32_t cookie2;
+   Socket *socket;
+
+   //Fill the SYN queue
+   sendSyn(interface, 42000, APP_PEER_WND_SHIFT, &cookie1);
+
+   //Start shortly after the beginning of a period
+   while((osGetSystemTime() % TCP_SYN_COOKIE_PERIOD) < 100 ||
+      (osGetSystemTime() % TCP_SYN_COOKIE_PERIOD) > 200)
+   {
+      osDelayTask(10);
+   }
+
+   //Collect two cookies
+   sendSyn(interface, 42001, APP_PEER_WND_SHIFT, &cookie1);
+   sendSyn(interface, 42002, APP_PEER_WND_SHIFT, &cookie2);
+
+   //A cookie remains valid during the next period
+   osDelayTask(TCP_SYN_COOKIE_PERIOD);
+   sendAck(interface, 42001, cookie1, 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Cookie from the previous period accepted", socket != NULL);
+
+   if(socket != NULL)
+   {
+      socketClose(socket);
+   }
+
+   //Older cookies are rejected
+   osDelayTask(TCP_SYN_COOKIE_PERIOD);
+   sendAck(interface, 42002, cookie2, 100);
+   socket = socketAccept(listener, NULL, NULL);
+
+   checkResult("Cookie older than two periods rejected", socket == NULL &&
+      listener->stats.synCookiesFailed == 4);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("***********************************\r\n");
+   TRACE_INFO("*** CycloneTCP SYN Cookie Check ***\r\n");
+   TRACE_INFO("***********************************\r\n");
+   TRACE_INFO("\r\n");
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a listening socket with room for a single pending connection
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 1);
+
+   //Do not wait for connection requests
+   socketSetTimeout(listener, 0);
+
+   //Window scale negotiation
+   checkRegularHandshake(interface, listener);
+   //SYN flood
+   checkSynFlood(interface, listener);
+   //Cookie expiry
+   checkStaleCookie(interface, listener);
+
+   //Close the listening socket
+   socketClose(listener);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,742 @@
+/**
+ * @file main.c
+ * @brief Zero-copy TCP receive check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * A TCP connection is established with a simulated peer sitting behind a
+ * virtual Ethernet interface. Data are read in place with socketReceiveRef
+ * while the receive buffer is due to be enlarged by auto-tuning, and while
+ * a FIN moves the connection to the TIME-WAIT state. The views must remain
+ * valid until they are released
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/tcp.h"
+#include "ipv4/arp_cache.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+
+//Simulated peer
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_IPV4_ADDR "192.168.0.2"
+#define APP_PEER_PORT 40000
+#define APP_PEER_ISN 1000
+#define APP_PEER_WINDOW 65535
+
+//Check configuration
+#define APP_SERVER_PORT 5001
+#define APP_SEGMENT_SIZE 1000
+#define APP_RTT 200
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Global variables
+MacAddr peerMacAddr;
+Ipv4Addr peerIpAddr;
+uint32_t peerSeqNum;
+uint32_t peerAckNum;
+uint32_t localSndMax;
+bool_t synAckReceived;
+uint_t failureCount;
+
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ *
+ * The segments sent by the stack are parsed to track the sequence numbers
+ * of the connection on behalf of the simulated peer
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   size_t n;
+   size_t length;
+   uint32_t seqNum;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Copy the frame
+   n = netBufferRead(frame, buffer, offset, sizeof(frame));
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+
+   //Only TCP segments are of interest
+   if(n >= (sizeof(EthHeader) + sizeof(Ipv4Header)) &&
+      ethHeader->type == HTONS(ETH_TYPE_IPV4) &&
+      ipHeader->protocol == IPV4_PROTOCOL_TCP)
+   {
+      //Point to the TCP header
+      tcpHeader = (TcpHeader *) (ethHeader->data + ipHeader->headerLength * 4);
+
+      //Length of the segment data
+      length = ntohs(ipHeader->totalLength) - ipHeader->headerLength * 4 -
+         tcpHeader->dataOffset * 4;
+
+      //Sequence number of the first byte following the segment
+      seqNum = ntohl(tcpHeader->seqNum) + length;
+
+      //The FIN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_FIN) != 0)
+      {
+         seqNum++;
+      }
+
+      //The SYN flag occupies one sequence number
+      if((tcpHeader->flags & TCP_FLAG_SYN) != 0)
+      {
+         seqNum++;
+         synAckReceived = TRUE;
+         localSndMax = seqNum;
+      }
+      else if(TCP_CMP_SEQ(seqNum, localSndMax) > 0)
+      {
+         localSndMax = seqNum;
+      }
+   }
+
+   //The transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Format a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[out] frame Buffer where to format the Ethernet frame
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ * @return Length of the frame
+ **/
+
+size_t formatSegment(NetInterface *interface, uint8_t *frame, uint8_t flags,
+   uint_t numNops, size_t length)
+{
+   size_t i;
+   size_t n;
+   EthHeader *ethHeader;
+   Ipv4Header *ipHeader;
+   TcpHeader *tcpHeader;
+   Ipv4PseudoHeader pseudoHeader;
+
+   //Point to the headers
+   ethHeader = (EthHeader *) frame;
+   ipHeader = (Ipv4Header *) ethHeader->data;
+   tcpHeader = (TcpHeader *) ipHeader->options;
+
+   //Length of the TCP segment
+   n = sizeof(TcpHeader) + numNops + length;
+
+   //Format Ethernet header
+   ethHeader->destAddr = interface->macAddr;
+   ethHeader->srcAddr = peerMacAddr;
+   ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+   //Format IPv4 header
+   ipHeader->version = IPV4_VERSION;
+   ipHeader->headerLength = 5;
+   ipHeader->typeOfService = 0;
+   ipHeader->totalLength = htons(sizeof(Ipv4Header) + n);
+   ipHeader->identification = 0;
+   ipHeader->fragmentOffset = HTONS(IPV4_FLAG_DF);
+   ipHeader->timeToLive = 64;
+   ipHeader->protocol = IPV4_PROTOCOL_TCP;
+   ipHeader->headerChecksum = 0;
+   ipHeader->srcAddr = peerIpAddr;
+   ipHeader->destAddr = interface->ipv4Context.addrList[0].addr;
+   ipHeader->headerChecksum = ipCalcChecksum(ipHeader, sizeof(Ipv4Header));
+
+   //Format TCP header
+   tcpHeader->srcPort = HTONS(APP_PEER_PORT);
+   tcpHeader->destPort = HTONS(APP_SERVER_PORT);
+   tcpHeader->seqNum = htonl(peerSeqNum);
+   tcpHeader->ackNum = (flags & TCP_FLAG_ACK) ? htonl(peerAckNum) : 0;
+   tcpHeader->reserved1 = 0;
+   tcpHeader->dataOffset = (sizeof(TcpHeader) + numNops) / 4;
+   tcpHeader->flags = flags;
+   tcpHeader->reserved2 = 0;
+   tcpHeader->window = HTONS(APP_PEER_WINDOW);
+   tcpHeader->checksum = 0;
+   tcpHeader->urgentPointer = 0;
+
+   //Options
+   osMemset(tcpHeader->options, TCP_OPTION_NOP, numNops);
+
+   //Each byte of the payload is derived from its sequence number
+   for(i = 0; i < length; i++)
+   {
+      tcpHeader->options[numNops + i] = (uint8_t) (peerSeqNum + i);
+   }
+
+   //Calculate TCP checksum
+   pseudoHeader.srcAddr = ipHeader->srcAddr;
+   pseudoHeader.destAddr = ipHeader->destAddr;
+   pseudoHeader.reserved = 0;
+   pseudoHeader.protocol = IPV4_PROTOCOL_TCP;
+   pseudoHeader.length = htons(n);
+
+   tcpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+      sizeof(Ipv4PseudoHeader), tcpHeader, n);
+
+   //The SYN flag occupies one sequence number
+   peerSeqNum += length + ((flags & TCP_FLAG_SYN) ? 1 : 0);
+
+   //Return the length of the frame
+   return sizeof(EthHeader) + sizeof(Ipv4Header) + n;
+}
+
+
+/**
+ * @brief Process a frame as if it had been received by the NIC
+ * @param[in] interface Underlying network interface
+ * @param[in] frame Ethernet frame
+ * @param[in] length Length of the frame
+ **/
+
+void injectFrame(NetInterface *interface, uint8_t *frame, size_t length)
+{
+   NetRxAncillary ancillary;
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   nicProcessPacket(interface, frame, length, &ancillary);
+}
+
+
+/**
+ * @brief Inject a TCP segment sent by the simulated peer
+ * @param[in] interface Underlying network interface
+ * @param[in] flags TCP flags
+ * @param[in] numNops Number of NOP options (multiple of 4)
+ * @param[in] length Length of the segment data
+ **/
+
+void injectSegment(NetInterface *interface, uint8_t flags, uint_t numNops,
+   size_t length)
+{
+   size_t n;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Format the segment
+   n = formatSegment(interface, frame, flags, numNops, length);
+   //Process the frame
+   injectFrame(interface, frame, n);
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Check the contents of the views
+ * @param[in] ref Array of views
+ * @param[in] numRefs Number of views
+ * @param[in] seqNum Sequence number of the first byte described by the views
+ * @return TRUE if the views hold the data sent by the peer, else FALSE
+ **/
+
+bool_t checkViews(const TcpRxBufferRef *ref, uint_t numRefs, uint32_t seqNum)
+{
+   uint_t i;
+   size_t j;
+   const uint8_t *p;
+
+   //Loop through the views
+   for(i = 0; i < numRefs; i++)
+   {
+      //Point to the data
+      p = ref[i].data;
+
+      //Each byte is derived from its sequence number
+      for(j = 0; j < ref[i].length; j++)
+      {
+         if(p[j] != (uint8_t) seqNum++)
+            return FALSE;
+      }
+   }
+
+   //The views are consistent
+   return TRUE;
+}
+
+
+/**
+ * @brief Inject a data segment and map it in place
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ * @param[out] ref Array of views describing the data
+ * @param[out] numRefs Number of views that have been filled
+ * @param[out] seqNum Sequence number of the first byte of data
+ * @return Number of bytes described by the views
+ **/
+
+size_t receiveSegment(NetInterface *interface, Socket *socket,
+   TcpRxBufferRef *ref, uint_t *numRefs, uint32_t *seqNum)
+{
+   error_t error;
+   size_t length;
+
+   //Sequence number of the first byte of data
+   *seqNum = peerSeqNum;
+
+   //Inject the segment
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, TCP_FLAG_ACK | TCP_FLAG_PSH, 0, APP_SEGMENT_SIZE);
+   osReleaseMutex(&netMutex);
+
+   //Access the data in place
+   error = socketReceiveRef(socket, ref, 2, numRefs, &length, 0);
+
+   //Any error to report?
+   if(error)
+   {
+      *numRefs = 0;
+      length = 0;
+   }
+
+   //Return the number of bytes that have been mapped
+   return length;
+}
+
+
+/**
+ * @brief Hold views while the receive buffer is due to be enlarged
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkAutoTuning(NetInterface *interface, Socket *socket)
+{
+   uint_t i;
+   uint_t numRefs;
+   size_t length;
+   size_t rxBufferSize;
+   uint32_t seqNum;
+   uint32_t growths;
+   uint8_t data;
+   TcpRxBufferRef ref[2];
+
+   //Send one byte and acknowledge it after one RTT, so that the connection
+   //gets an RTT estimate
+   data = 0;
+   socketSend(socket, &data, sizeof(data), NULL, 0);
+   osDelayTask(APP_RTT);
+
+   osAcquireMutex(&netMutex);
+   peerAckNum = localSndMax;
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //Start a measurement interval
+   length = receiveSegment(interface, socket, ref, &numRefs, &seqNum);
+   socketReleaseRef(socket, length);
+
+   //Read enough data during the interval to justify a larger buffer
+   for(i = 0; i < 3; i++)
+   {
+      length = receiveSegment(interface, socket, ref, &numRefs, &seqNum);
+      socketReleaseRef(socket, length);
+   }
+
+   //Map one more segment and hold the views until the interval has elapsed
+   length = receiveSegment(interface, socket, ref, &numRefs, &seqNum);
+   checkResult("Segment mapped in place", length == APP_SEGMENT_SIZE);
+   osDelayTask(2 * APP_RTT);
+
+   //Save the current size of the buffer
+   osAcquireMutex(&netMutex);
+   rxBufferSize = socket->rxBufferSize;
+   osReleaseMutex(&netMutex);
+
+   //Releasing part of the data triggers auto-tuning
+   socketReleaseRef(socket, 1);
+
+   osAcquireMutex(&netMutex);
+   growths = socket->stats.rxBufferGrowths;
+   osReleaseMutex(&netMutex);
+
+   checkResult("Receive buffer not enlarged while views are held",
+      growths == 0 && socket->rxBufferSize == rxBufferSize);
+   checkResult("Views unchanged after auto-tuning",
+      checkViews(ref, numRefs, seqNum));
+
+   //Release the remaining data
+   socketReleaseRef(socket, length - 1);
+
+   osAcquireMutex(&netMutex);
+   growths = socket->stats.rxBufferGrowths;
+   osReleaseMutex(&netMutex);
+
+   checkResult("Receive buffer enlarged once the views are released",
+      growths == 1 && socket->rxBufferSize > rxBufferSize);
+}
+
+
+/**
+ * @brief Hold views while the connection enters the TIME-WAIT state
+ * @param[in] interface Underlying network interface
+ * @param[in] socket Connected socket
+ **/
+
+void checkTimeWait(NetInterface *interface, Socket *socket)
+{
+   error_t error;
+   uint_t numRefs;
+   uint_t chunkCount;
+   size_t length;
+   uint32_t seqNum;
+   TcpState state;
+   TcpRxBufferRef ref[2];
+
+   //Map a segment and hold the views
+   length = receiveSegment(interface, socket, ref, &numRefs, &seqNum);
+   checkResult("Segment mapped in place", length == APP_SEGMENT_SIZE);
+
+   //A second segment is received but not mapped yet
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, TCP_FLAG_ACK | TCP_FLAG_PSH, 0, APP_SEGMENT_SIZE);
+   osReleaseMutex(&netMutex);
+
+   //Send a FIN without waiting for its acknowledgment
+   socketSetTimeout(socket, 0);
+   socketShutdown(socket, SOCKET_SD_SEND);
+   socketSetTimeout(socket, INFINITE_DELAY);
+
+   //The peer acknowledges the FIN (FIN-WAIT-2 state) and then closes its
+   //side of the connection
+   osAcquireMutex(&netMutex);
+   peerAckNum = localSndMax;
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   injectSegment(interface, TCP_FLAG_FIN | TCP_FLAG_ACK, 0, 0);
+   state = socket->state;
+   chunkCount = socket->rxBuffer.chunkCount;
+   osReleaseMutex(&netMutex);
+
+   checkResult("FIN processed", state == TCP_STATE_TIME_WAIT ||
+      state == TCP_STATE_CLOSED);
+   checkResult("Receive buffer kept while views are held", chunkCount > 0);
+   checkResult("Views unchanged after the FIN", checkViews(ref, numRefs,
+      seqNum));
+
+   //Release the first segment
+   socketReleaseRef(socket, length);
+
+   osAcquireMutex(&netMutex);
+   chunkCount = socket->rxBuffer.chunkCount;
+   osReleaseMutex(&netMutex);
+
+   checkResult("Receive buffer kept while unread data remain", chunkCount > 0);
+
+   //Map the second segment
+   error = socketReceiveRef(socket, ref, 2, &numRefs, &length, 0);
+
+   checkResult("Unread data mapped after the FIN", !error &&
+      length == APP_SEGMENT_SIZE && checkViews(ref, numRefs,
+      seqNum + APP_SEGMENT_SIZE));
+
+   //Release the data
+   socketReleaseRef(socket, length);
+
+   osAcquireMutex(&netMutex);
+   chunkCount = socket->rxBuffer.chunkCount;
+   osReleaseMutex(&netMutex);
+
+   checkResult("Receive buffer freed once all the data are consumed",
+      chunkCount == 0);
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Status code
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   NetInterface *interface;
+   Socket *listener;
+   Socket *socket;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("*************************************\r\n");
+   TRACE_INFO("*** CycloneTCP Zero-Copy RX Check ***\r\n");
+   TRACE_INFO("*************************************\r\n");
+   TRACE_INFO("\r\n");
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //The peer is reachable without address resolution
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+   ipv4StringToAddr(APP_PEER_IPV4_ADDR, &peerIpAddr);
+   arpAddStaticEntry(interface, peerIpAddr, &peerMacAddr);
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Open a listening socket
+   listener = socketOpen(SOCKET_TYPE_STREAM, SOCKET_IP_PROTO_TCP);
+   socketBind(listener, &IP_ADDR_ANY, APP_SERVER_PORT);
+   socketListen(listener, 1);
+
+   //The simulated peer opens the connection
+   peerSeqNum = APP_PEER_ISN;
+
+   osAcquireMutex(&netMutex);
+   injectSegment(interface, TCP_FLAG_SYN, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //The SYN-ACK is sent when the connection is accepted
+   socket = socketAccept(listener, NULL, NULL);
+
+   //Make sure the SYN-ACK has been sent
+   if(socket == NULL || !synAckReceived)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to accept the connection!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Complete the three-way handshake
+   osAcquireMutex(&netMutex);
+   peerAckNum = localSndMax;
+   injectSegment(interface, TCP_FLAG_ACK, 0, 0);
+   osReleaseMutex(&netMutex);
+
+   //Receive buffer auto-tuning
+   checkAutoTuning(interface, socket);
+   //Closing handshake
+   checkTimeWait(interface, socket);
+
+   //Close sockets
+   socketClose(socket);
+   socketClose(listener);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
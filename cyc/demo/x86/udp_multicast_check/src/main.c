@@ -0,0 +1,977 @@
+/**
+ * @file main.c
+ * @brief UDP multicast delivery check
+ *
+ * @section License
+ *
+ * SPDX-License-Identifier: GPL-2.0-or-later
+ *
+ * Copyright (C) 2010-2024 Oryx Embedded SARL. All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation; either version 2
+ * of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+ *
+ * @section Description
+ *
+ * Several UDP sockets join and leave IPv4 and IPv6 multicast groups, with
+ * source filters. Multicast datagrams are injected into a virtual Ethernet
+ * interface to check which socket receives them. A long sequence of random
+ * operations then compares the socket selected through the multicast group
+ * index with the socket selected by a scan of the whole socket table, as
+ * done before the index was introduced
+ *
+ * @author Oryx Embedded SARL (www.oryx-embedded.com)
+ * @version 2.4.4
+ **/
+
+//Dependencies
+#include <stdlib.h>
+#include "core/net.h"
+#include "core/udp.h"
+#include "core/socket_misc.h"
+#include "ipv4/ipv4_multicast.h"
+#include "ipv6/ipv6_multicast.h"
+#include "debug.h"
+
+//Interface configuration
+#define APP_IF_NAME "eth0"
+#define APP_MAC_ADDR "00-AB-CD-EF-00-01"
+#define APP_IPV4_HOST_ADDR "192.168.0.1"
+#define APP_IPV4_SUBNET_MASK "255.255.255.0"
+#define APP_IPV6_LINK_LOCAL_ADDR "fe80::1"
+
+//Simulated peers
+#define APP_PEER_MAC_ADDR "00-11-22-33-44-01"
+#define APP_PEER_PORT 40000
+
+//Check configuration
+#define APP_PORT1 5000
+#define APP_PORT2 5001
+#define APP_RANDOM_SEED 1
+#define APP_RANDOM_STEPS 5000
+#define APP_LOOKUPS_PER_STEP 8
+
+//Forward declaration of functions
+error_t benchDriverInit(NetInterface *interface);
+void benchDriverTick(NetInterface *interface);
+void benchDriverEnableIrq(NetInterface *interface);
+void benchDriverDisableIrq(NetInterface *interface);
+void benchDriverEventHandler(NetInterface *interface);
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary);
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface);
+
+//Multicast groups
+static const char_t *const groupList[] =
+{
+   "239.1.1.1",
+   "239.1.1.2",
+   "239.1.1.3",
+   "239.2.1.1",
+   "224.0.1.200",
+   "ff05::1:1",
+   "ff05::1:2",
+   "ff02::1:3"
+};
+
+//Source addresses
+static const char_t *const sourceList[] =
+{
+   "192.168.0.2",
+   "192.168.0.3",
+   "192.168.0.4",
+   "fe80::2",
+   "fe80::3",
+   "fe80::4"
+};
+
+//Global variables
+MacAddr peerMacAddr;
+IpAddr groupAddr[arraysize(groupList)];
+IpAddr sourceAddr[arraysize(sourceList)];
+uint_t failureCount;
+
+/**
+ * @brief Virtual Ethernet controller
+ **/
+
+const NicDriver benchDriver =
+{
+   NIC_TYPE_ETHERNET,
+   ETH_MTU,
+   benchDriverInit,
+   benchDriverTick,
+   benchDriverEnableIrq,
+   benchDriverDisableIrq,
+   benchDriverEventHandler,
+   benchDriverSendPacket,
+   benchDriverUpdateMacAddrFilter,
+   NULL,
+   NULL,
+   NULL,
+   TRUE,
+   TRUE,
+   TRUE,
+   TRUE
+};
+
+
+/**
+ * @brief Virtual Ethernet controller initialization
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverInit(NetInterface *interface)
+{
+   //Force the TCP/IP stack to poll the link state at startup
+   interface->nicEvent = TRUE;
+   osSetEvent(&netEvent);
+
+   //The virtual controller is now ready to send
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful initialization
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Virtual Ethernet controller timer handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverTick(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Enable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEnableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Disable interrupts
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverDisableIrq(NetInterface *interface)
+{
+   //Not implemented
+}
+
+
+/**
+ * @brief Virtual Ethernet controller event handler
+ * @param[in] interface Underlying network interface
+ **/
+
+void benchDriverEventHandler(NetInterface *interface)
+{
+   //Link up event is pending?
+   if(!interface->linkState)
+   {
+      //The virtual link is always up
+      interface->linkState = TRUE;
+      interface->linkSpeed = NIC_LINK_SPEED_1GBPS;
+      interface->duplexMode = NIC_FULL_DUPLEX_MODE;
+
+      //Process link state change event
+      nicNotifyLinkChange(interface);
+   }
+}
+
+
+/**
+ * @brief Send a packet
+ * @param[in] interface Underlying network interface
+ * @param[in] buffer Multi-part buffer containing the data to send
+ * @param[in] offset Offset to the first data byte
+ * @param[in] ancillary Additional options passed to the stack along with
+ *   the packet
+ * @return Error code
+ **/
+
+error_t benchDriverSendPacket(NetInterface *interface,
+   const NetBuffer *buffer, size_t offset, NetTxAncillary *ancillary)
+{
+   //The IGMP and MLD reports sent by the stack are discarded. The
+   //transmitter is always ready to accept a new frame
+   osSetEvent(&interface->nicTxEvent);
+
+   //Successful processing
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Configure MAC address filtering
+ * @param[in] interface Underlying network interface
+ * @return Error code
+ **/
+
+error_t benchDriverUpdateMacAddrFilter(NetInterface *interface)
+{
+   //Not implemented
+   return NO_ERROR;
+}
+
+
+/**
+ * @brief Report the result of a check
+ * @param[in] name Description of the check
+ * @param[in] result TRUE if the check passed, else FALSE
+ **/
+
+void checkResult(const char_t *name, bool_t result)
+{
+   //Display the outcome of the check
+   TRACE_PRINTF("%-56s %s\r\n", name, result ? "PASS" : "FAIL");
+
+   //Keep track of failed checks
+   if(!result)
+   {
+      failureCount++;
+   }
+}
+
+
+/**
+ * @brief Inject a multicast UDP datagram
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Multicast group address
+ * @param[in] srcAddr Source IP address
+ * @param[in] destPort Destination port
+ **/
+
+void injectDatagram(NetInterface *interface, const IpAddr *destAddr,
+   const IpAddr *srcAddr, uint16_t destPort)
+{
+   size_t length;
+   EthHeader *ethHeader;
+   Ipv4Header *ipv4Header;
+   Ipv6Header *ipv6Header;
+   UdpHeader *udpHeader;
+   Ipv6PseudoHeader pseudoHeader;
+   NetRxAncillary ancillary;
+   uint8_t frame[ETH_MAX_FRAME_SIZE];
+
+   //Point to the Ethernet header
+   ethHeader = (EthHeader *) frame;
+   ethHeader->srcAddr = peerMacAddr;
+
+   //IPv4 multicast group?
+   if(destAddr->length == sizeof(Ipv4Addr))
+   {
+      //Point to the IPv4 header
+      ipv4Header = (Ipv4Header *) ethHeader->data;
+      udpHeader = (UdpHeader *) ipv4Header->options;
+
+      //Format Ethernet header
+      ipv4MapMulticastAddrToMac(destAddr->ipv4Addr, &ethHeader->destAddr);
+      ethHeader->type = HTONS(ETH_TYPE_IPV4);
+
+      //Format IPv4 header
+      ipv4Header->version = IPV4_VERSION;
+      ipv4Header->headerLength = 5;
+      ipv4Header->typeOfService = 0;
+      ipv4Header->totalLength = HTONS(sizeof(Ipv4Header) + sizeof(UdpHeader));
+      ipv4Header->identification = 0;
+      ipv4Header->fragmentOffset = 0;
+      ipv4Header->timeToLive = 1;
+      ipv4Header->protocol = IPV4_PROTOCOL_UDP;
+      ipv4Header->headerChecksum = 0;
+      ipv4Header->srcAddr = srcAddr->ipv4Addr;
+      ipv4Header->destAddr = destAddr->ipv4Addr;
+      ipv4Header->headerChecksum = ipCalcChecksum(ipv4Header,
+         sizeof(Ipv4Header));
+
+      //Format UDP header (the checksum is optional)
+      udpHeader->srcPort = HTONS(APP_PEER_PORT);
+      udpHeader->destPort = htons(destPort);
+      udpHeader->length = HTONS(sizeof(UdpHeader));
+      udpHeader->checksum = 0;
+
+      //Length of the frame
+      length = sizeof(EthHeader) + sizeof(Ipv4Header) + sizeof(UdpHeader);
+   }
+   else
+   {
+      //Point to the IPv6 header
+      ipv6Header = (Ipv6Header *) ethHeader->data;
+      udpHeader = (UdpHeader *) ipv6Header->payload;
+
+      //Format Ethernet header
+      ipv6MapMulticastAddrToMac(&destAddr->ipv6Addr, &ethHeader->destAddr);
+      ethHeader->type = HTONS(ETH_TYPE_IPV6);
+
+      //Format IPv6 header
+      osMemset(ipv6Header, 0, sizeof(Ipv6Header));
+      ipv6Header->version = IPV6_VERSION;
+      ipv6Header->payloadLen = HTONS(sizeof(UdpHeader));
+      ipv6Header->nextHeader = IPV6_UDP_HEADER;
+      ipv6Header->hopLimit = 1;
+      ipv6Header->srcAddr = srcAddr->ipv6Addr;
+      ipv6Header->destAddr = destAddr->ipv6Addr;
+
+      //Format UDP header
+      udpHeader->srcPort = HTONS(APP_PEER_PORT);
+      udpHeader->destPort = htons(destPort);
+      udpHeader->length = HTONS(sizeof(UdpHeader));
+      udpHeader->checksum = 0;
+
+      //The UDP checksum is mandatory with IPv6
+      pseudoHeader.srcAddr = srcAddr->ipv6Addr;
+      pseudoHeader.destAddr = destAddr->ipv6Addr;
+      pseudoHeader.length = HTONL(sizeof(UdpHeader));
+      pseudoHeader.reserved[0] = 0;
+      pseudoHeader.reserved[1] = 0;
+      pseudoHeader.reserved[2] = 0;
+      pseudoHeader.nextHeader = IPV6_UDP_HEADER;
+
+      udpHeader->checksum = ipCalcUpperLayerChecksum(&pseudoHeader,
+         sizeof(Ipv6PseudoHeader), udpHeader, sizeof(UdpHeader));
+
+      //Length of the frame
+      length = sizeof(EthHeader) + sizeof(Ipv6Header) + sizeof(UdpHeader);
+   }
+
+   //Additional options passed to the stack along with the frame
+   ancillary = NET_DEFAULT_RX_ANCILLARY;
+
+   //Process the frame
+   osAcquireMutex(&netMutex);
+   nicProcessPacket(interface, frame, length, &ancillary);
+   osReleaseMutex(&netMutex);
+}
+
+
+/**
+ * @brief Drain the receive queue of a socket
+ * @param[in] socket Handle to a socket
+ * @return Number of datagrams that were waiting in the receive queue
+ **/
+
+uint_t receiveAll(Socket *socket)
+{
+   uint_t n;
+   size_t length;
+   uint8_t data[16];
+
+   //Drain the receive queue
+   for(n = 0; socketReceive(socket, data, sizeof(data), &length, 0) ==
+      NO_ERROR; n++)
+   {
+   }
+
+   //Return the number of datagrams
+   return n;
+}
+
+
+/**
+ * @brief Select the socket a datagram is delivered to by scanning the
+ *   whole socket table
+ *
+ * This is the selection performed before the multicast group index was
+ * introduced. The source filters are evaluated independently of the stack
+ *
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Multicast group address
+ * @param[in] srcAddr Source IP address
+ * @param[in] destPort Destination port
+ * @return Pointer to the matching socket, if any
+ **/
+
+Socket *linearFindSocket(NetInterface *interface, const IpAddr *destAddr,
+   const IpAddr *srcAddr, uint16_t destPort)
+{
+   uint_t i;
+   uint_t j;
+   uint_t k;
+   bool_t acceptable;
+   bool_t listed;
+   Socket *socket;
+   SocketMulticastGroup *group;
+
+   //Loop through opened sockets
+   for(i = 0; i < SOCKET_MAX_COUNT; i++)
+   {
+      //Point to the current socket
+      socket = &socketTable[i];
+
+      //UDP socket found?
+      if(socket->type != SOCKET_TYPE_DGRAM)
+         continue;
+
+      //Check whether the socket is bound to a particular interface
+      if(socket->interface != NULL && socket->interface != interface)
+         continue;
+
+      //Check destination port number
+      if(socket->localPort == 0 || socket->localPort != destPort)
+         continue;
+
+      //Source port number filtering
+      if(socket->remotePort != 0 && socket->remotePort != APP_PEER_PORT)
+         continue;
+
+      //Check whether the socket is restricted to IPv6 communications only
+      if(destAddr->length == sizeof(Ipv4Addr) &&
+         (socket->options & SOCKET_OPTION_IPV6_ONLY) != 0)
+      {
+         continue;
+      }
+
+      //Multicast address filtering
+      for(acceptable = FALSE, j = 0; j < SOCKET_MAX_MULTICAST_GROUPS; j++)
+      {
+         //Point to the current multicast group
+         group = &socket->multicastGroups[j];
+
+         //Matching multicast address?
+         if(ipCompAddr(&group->addr, destAddr))
+         {
+            //Search the source list
+            for(listed = FALSE, k = 0; k < group->numSources; k++)
+            {
+               if(ipCompAddr(&group->sources[k], srcAddr))
+                  listed = TRUE;
+            }
+
+            //INCLUDE mode accepts the listed sources only, whereas EXCLUDE
+            //mode accepts the sources that are not listed
+            if(group->filterMode == IP_FILTER_MODE_INCLUDE)
+            {
+               acceptable = acceptable || listed;
+            }
+            else
+            {
+               acceptable = acceptable || !listed;
+            }
+         }
+      }
+
+      //Multicast address filtering
+      if(!acceptable)
+         continue;
+
+      //Source IP address filtering
+      if(socket->remoteIpAddr.length != 0)
+      {
+         //The address family must match
+         if(socket->remoteIpAddr.length != srcAddr->length)
+            continue;
+
+         //Filter out non-matching addresses
+         if(!ipIsUnspecifiedAddr(&socket->remoteIpAddr) &&
+            !ipCompAddr(&socket->remoteIpAddr, srcAddr))
+         {
+            continue;
+         }
+      }
+
+      //The current socket meets all the criteria
+      return socket;
+   }
+
+   //No matching socket found
+   return NULL;
+}
+
+
+/**
+ * @brief Select the socket a datagram is delivered to, as the stack does
+ * @param[in] interface Underlying network interface
+ * @param[in] destAddr Multicast group address
+ * @param[in] srcAddr Source IP address
+ * @param[in] destPort Destination port
+ * @return Pointer to the matching socket, if any
+ **/
+
+Socket *indexFindSocket(NetInterface *interface, const IpAddr *destAddr,
+   const IpAddr *srcAddr, uint16_t destPort)
+{
+   IpPseudoHeader pseudoHeader;
+   UdpHeader header;
+
+   //Format pseudo header
+   osMemset(&pseudoHeader, 0, sizeof(IpPseudoHeader));
+
+   if(destAddr->length == sizeof(Ipv4Addr))
+   {
+      pseudoHeader.length = sizeof(Ipv4PseudoHeader);
+      pseudoHeader.ipv4Data.srcAddr = srcAddr->ipv4Addr;
+      pseudoHeader.ipv4Data.destAddr = destAddr->ipv4Addr;
+   }
+   else
+   {
+      pseudoHeader.length = sizeof(Ipv6PseudoHeader);
+      pseudoHeader.ipv6Data.srcAddr = srcAddr->ipv6Addr;
+      pseudoHeader.ipv6Data.destAddr = destAddr->ipv6Addr;
+   }
+
+   //Format UDP header
+   header.srcPort = HTONS(APP_PEER_PORT);
+   header.destPort = htons(destPort);
+
+   //Search the socket table
+   return udpFindSocket(interface, &pseudoHeader, &header);
+}
+
+
+/**
+ * @brief Check the consistency of the multicast group index
+ *
+ * Each group joined by a socket must be linked exactly once, in the bucket
+ * its address hashes to, and the index must not refer to any other entry
+ *
+ * @return TRUE if the index is consistent, else FALSE
+ **/
+
+bool_t checkIndex(void)
+{
+   uint_t i;
+   uint_t j;
+   uint_t n;
+   uint_t count;
+   Socket *socket;
+   SocketMulticastGroup *group;
+   SocketMulticastGroup *entry;
+
+   //Loop through the groups joined by the sockets
+   for(count = 0, i = 0; i < SOCKET_MAX_COUNT; i++)
+   {
+      //Point to the current socket
+      socket = &socketTable[i];
+
+      for(j = 0; j < SOCKET_MAX_MULTICAST_GROUPS; j++)
+      {
+         //Point to the current group
+         group = &socket->multicastGroups[j];
+
+         //Unused entry?
+         if(group->addr.length == 0)
+            continue;
+
+         //Closed sockets cannot be subscribed to any group
+         if(socket->type == SOCKET_TYPE_UNUSED || group->socket != socket)
+            return FALSE;
+
+         //Search the bucket the group address hashes to
+         for(n = 0, entry = socketMulticastIndex[socketGetMulticastHashIndex(
+            &group->addr)]; entry != NULL; entry = entry->next)
+         {
+            if(entry == group)
+               n++;
+         }
+
+         //The entry must be linked exactly once
+         if(n != 1)
+            return FALSE;
+
+         //Number of subscriptions
+         count++;
+      }
+   }
+
+   //Count the entries of the index
+   for(n = 0, i = 0; i < SOCKET_MULTICAST_HASH_TABLE_SIZE; i++)
+   {
+      for(entry = socketMulticastIndex[i]; entry != NULL && n <= count;
+         entry = entry->next)
+      {
+         n++;
+      }
+   }
+
+   //The index must not refer to deleted entries
+   return (n == count) ? TRUE : FALSE;
+}
+
+
+/**
+ * @brief Delivery of injected datagrams
+ * @param[in] interface Underlying network interface
+ **/
+
+void checkDelivery(NetInterface *interface)
+{
+   uint_t n1;
+   uint_t n2;
+   Socket *socket1;
+   Socket *socket2;
+
+   //Two sockets share the same port
+   socket1 = socketOpen(SOCKET_TYPE_DGRAM, SOCKET_IP_PROTO_UDP);
+   socket2 = socketOpen(SOCKET_TYPE_DGRAM, SOCKET_IP_PROTO_UDP);
+   socketSetTimeout(socket1, 0);
+   socketSetTimeout(socket2, 0);
+   socketBind(socket1, &IP_ADDR_ANY, APP_PORT1);
+   socketBind(socket2, &IP_ADDR_ANY, APP_PORT1);
+
+   //Both sockets join the same IPv4 group
+   socketJoinMulticastGroup(socket1, &groupAddr[0]);
+   socketJoinMulticastGroup(socket2, &groupAddr[0]);
+   injectDatagram(interface, &groupAddr[0], &sourceAddr[0], APP_PORT1);
+   n1 = receiveAll(socket1);
+   n2 = receiveAll(socket2);
+
+   checkResult("Shared group delivered to the lowest descriptor",
+      n1 == 1 && n2 == 0 && checkIndex());
+
+   //Datagrams sent to another port or another group are not delivered
+   injectDatagram(interface, &groupAddr[0], &sourceAddr[0], APP_PORT2);
+   injectDatagram(interface, &groupAddr[1], &sourceAddr[0], APP_PORT1);
+   n1 = receiveAll(socket1);
+   n2 = receiveAll(socket2);
+
+   checkResult("Other port or group not delivered", n1 == 0 && n2 == 0);
+
+   //The first socket leaves the group
+   socketLeaveMulticastGroup(socket1, &groupAddr[0]);
+   injectDatagram(interface, &groupAddr[0], &sourceAddr[0], APP_PORT1);
+   n1 = receiveAll(socket1);
+   n2 = receiveAll(socket2);
+
+   checkResult("Leave hands the group over to the other socket",
+      n1 == 0 && n2 == 1 && checkIndex());
+
+   //INCLUDE mode filter
+   socketSetMulticastSourceFilter(socket2, &groupAddr[0],
+      IP_FILTER_MODE_INCLUDE, &sourceAddr[1], 1);
+   injectDatagram(interface, &groupAddr[0], &sourceAddr[0], APP_PORT1);
+   n1 = receiveAll(socket2);
+   injectDatagram(interface, &groupAddr[0], &sourceAddr[1], APP_PORT1);
+   n2 = receiveAll(socket2);
+
+   checkResult("INCLUDE source filter", n1 == 0 && n2 == 1);
+
+   //EXCLUDE mode filter
+   socketSetMulticastSourceFilter(socket2, &groupAddr[0],
+      IP_FILTER_MODE_EXCLUDE, &sourceAddr[1], 1);
+   injectDatagram(interface, &groupAddr[0], &sourceAddr[0], APP_PORT1);
+   n1 = receiveAll(socket2);
+   injectDatagram(interface, &groupAddr[0], &sourceAddr[1], APP_PORT1);
+   n2 = receiveAll(socket2);
+
+   checkResult("EXCLUDE source filter", n1 == 1 && n2 == 0);
+
+   //Both sockets join an IPv6 group
+   socketJoinMulticastGroup(socket1, &groupAddr[5]);
+   socketJoinMulticastGroup(socket2, &groupAddr[5]);
+   injectDatagram(interface, &groupAddr[5], &sourceAddr[3], APP_PORT1);
+   n1 = receiveAll(socket1);
+   n2 = receiveAll(socket2);
+
+   checkResult("IPv6 group delivered to the lowest descriptor",
+      n1 == 1 && n2 == 0 && checkIndex());
+
+   //Closing the first socket removes its subscriptions
+   socketClose(socket1);
+   injectDatagram(interface, &groupAddr[5], &sourceAddr[3], APP_PORT1);
+   n2 = receiveAll(socket2);
+
+   checkResult("Close hands the group over to the other socket",
+      n2 == 1 && checkIndex());
+
+   //Closing the second socket empties the index
+   socketClose(socket2);
+
+   checkResult("Close unlinks all the subscriptions", checkIndex() &&
+      indexFindSocket(interface, &groupAddr[0], &sourceAddr[0],
+      APP_PORT1) == NULL);
+}
+
+
+/**
+ * @brief Random sequence of operations
+ * @param[in] interface Underlying network interface
+ **/
+
+void checkRandom(NetInterface *interface)
+{
+   uint_t i;
+   uint_t j;
+   uint_t k;
+   uint_t n;
+   uint_t step;
+   uint_t lookups;
+   uint_t delivered;
+   uint_t mismatches;
+   bool_t consistent;
+   uint16_t port;
+   Socket *socket;
+   Socket *sockets[SOCKET_MAX_COUNT];
+   IpAddr sources[SOCKET_MAX_MULTICAST_SOURCES];
+   const IpAddr *group;
+   const IpAddr *source;
+
+   //Initialize the pseudo-random sequence
+   srand(APP_RANDOM_SEED);
+   osMemset(sockets, 0, sizeof(sockets));
+
+   //Initialize counters
+   lookups = 0;
+   delivered = 0;
+   mismatches = 0;
+   consistent = TRUE;
+
+   //Run the sequence
+   for(step = 0; step < APP_RANDOM_STEPS; step++)
+   {
+      //Select a socket and a group
+      i = rand() % SOCKET_MAX_COUNT;
+      group = &groupAddr[rand() % arraysize(groupList)];
+      socket = sockets[i];
+
+      //Select an operation
+      switch(rand() % 8)
+      {
+      //Open the socket
+      case 0:
+         if(socket == NULL)
+         {
+            sockets[i] = socketOpen(SOCKET_TYPE_DGRAM, SOCKET_IP_PROTO_UDP);
+            port = (rand() % 2) ? APP_PORT1 : APP_PORT2;
+            socketBind(sockets[i], &IP_ADDR_ANY, port);
+         }
+         break;
+
+      //Close the socket
+      case 1:
+         if(socket != NULL && (rand() % 4) == 0)
+         {
+            socketClose(socket);
+            sockets[i] = NULL;
+         }
+         break;
+
+      //Join a group
+      case 2:
+      case 3:
+         if(socket != NULL)
+         {
+            socketJoinMulticastGroup(socket, group);
+         }
+         break;
+
+      //Leave a group
+      case 4:
+         if(socket != NULL)
+         {
+            socketLeaveMulticastGroup(socket, group);
+         }
+         break;
+
+      //Set the source filter of a group
+      case 5:
+         if(socket != NULL)
+         {
+            //Pick sources of the same address family
+            n = rand() % (SOCKET_MAX_MULTICAST_SOURCES + 1);
+            k = (group->length == sizeof(Ipv4Addr)) ? 0 : 3;
+
+            for(j = 0; j < n; j++)
+            {
+               sources[j] = sourceAddr[k + (rand() % 3)];
+            }
+
+            //Replace the source list
+            socketSetMulticastSourceFilter(socket, group, (rand() % 2) ?
+               IP_FILTER_MODE_INCLUDE : IP_FILTER_MODE_EXCLUDE, sources, n);
+         }
+         break;
+
+      //Restrict the socket to IPv6
+      case 6:
+         if(socket != NULL)
+         {
+            osAcquireMutex(&netMutex);
+            socket->options ^= SOCKET_OPTION_IPV6_ONLY;
+            osReleaseMutex(&netMutex);
+         }
+         break;
+
+      //Accept datagrams from a single source
+      default:
+         if(socket != NULL)
+         {
+            osAcquireMutex(&netMutex);
+
+            if((rand() % 2) == 0)
+            {
+               socket->remoteIpAddr = sourceAddr[rand() % 6];
+               socket->remotePort = (rand() % 2) ? APP_PEER_PORT : 1;
+            }
+            else
+            {
+               socket->remoteIpAddr = IP_ADDR_UNSPECIFIED;
+               socket->remotePort = 0;
+            }
+
+            osReleaseMutex(&netMutex);
+         }
+         break;
+      }
+
+      osAcquireMutex(&netMutex);
+
+      //Check the multicast group index
+      consistent = consistent && checkIndex();
+
+      //Compare the socket selected by both methods
+      for(j = 0; j < APP_LOOKUPS_PER_STEP; j++)
+      {
+         //Random datagram
+         group = &groupAddr[rand() % arraysize(groupList)];
+         k = (group->length == sizeof(Ipv4Addr)) ? 0 : 3;
+         source = &sourceAddr[k + (rand() % 3)];
+         port = (rand() % 2) ? APP_PORT1 : APP_PORT2;
+
+         //Search the socket table
+         socket = indexFindSocket(interface, group, source, port);
+
+         //Compare with the scan of the whole socket table
+         if(socket != linearFindSocket(interface, group, source, port))
+         {
+            mismatches++;
+         }
+
+         //Update counters
+         lookups++;
+         delivered += (socket != NULL) ? 1 : 0;
+      }
+
+      osReleaseMutex(&netMutex);
+   }
+
+   //Close the remaining sockets
+   for(i = 0; i < SOCKET_MAX_COUNT; i++)
+   {
+      if(sockets[i] != NULL)
+      {
+         socketClose(sockets[i]);
+      }
+   }
+
+   //Display statistics
+   TRACE_PRINTF("%u lookups, %u delivered, %u mismatches\r\n", lookups,
+      delivered, mismatches);
+
+   checkResult("Random operations: index consistent", consistent &&
+      checkIndex());
+
+   checkResult("Random operations: same socket as the table scan",
+      mismatches == 0 && delivered > (lookups / 10));
+}
+
+
+/**
+ * @brief Main entry point
+ * @return Unused value
+ **/
+
+int_t main(void)
+{
+   error_t error;
+   uint_t i;
+   MacAddr macAddr;
+   Ipv4Addr ipv4Addr;
+   Ipv6Addr ipv6Addr;
+   NetInterface *interface;
+
+   //Start-up message
+   TRACE_INFO("\r\n");
+   TRACE_INFO("**************************************\r\n");
+   TRACE_INFO("*** CycloneTCP UDP Multicast Check ***\r\n");
+   TRACE_INFO("**************************************\r\n");
+   TRACE_INFO("\r\n");
+
+   //TCP/IP stack initialization
+   error = netInit();
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to initialize TCP/IP stack!\r\n");
+      return EXIT_FAILURE;
+   }
+
+   //Configure the virtual interface
+   interface = &netInterface[0];
+   netSetInterfaceName(interface, APP_IF_NAME);
+   netSetDriver(interface, &benchDriver);
+   macStringToAddr(APP_MAC_ADDR, &macAddr);
+   netSetMacAddr(interface, &macAddr);
+
+   //Initialize network interface
+   error = netConfigInterface(interface);
+   //Any error to report?
+   if(error)
+   {
+      //Debug message
+      TRACE_ERROR("Failed to configure interface %s!\r\n", interface->name);
+      return EXIT_FAILURE;
+   }
+
+   //Set IPv4 host address and subnet mask
+   ipv4StringToAddr(APP_IPV4_HOST_ADDR, &ipv4Addr);
+   ipv4SetHostAddr(interface, ipv4Addr);
+   ipv4StringToAddr(APP_IPV4_SUBNET_MASK, &ipv4Addr);
+   ipv4SetSubnetMask(interface, ipv4Addr);
+
+   //Set IPv6 link-local address
+   ipv6StringToAddr(APP_IPV6_LINK_LOCAL_ADDR, &ipv6Addr);
+   ipv6SetLinkLocalAddr(interface, &ipv6Addr);
+
+   //Addresses of the simulated peers
+   macStringToAddr(APP_PEER_MAC_ADDR, &peerMacAddr);
+
+   for(i = 0; i < arraysize(groupList); i++)
+   {
+      ipStringToAddr(groupList[i], &groupAddr[i]);
+   }
+
+   for(i = 0; i < arraysize(sourceList); i++)
+   {
+      ipStringToAddr(sourceList[i], &sourceAddr[i]);
+   }
+
+   //Wait for the virtual link to come up
+   while(!interface->linkState)
+   {
+      osDelayTask(10);
+   }
+
+   //Run the checks
+   checkDelivery(interface);
+   checkRandom(interface);
+
+   //Display the number of failed checks
+   TRACE_PRINTF("%u check(s) failed\r\n", failureCount);
+
+   //Return status code
+   return (failureCount == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
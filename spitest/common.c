@@ -14,6 +14,7 @@
 #include <sys/stat.h>
 #include <linux/types.h>
 #include <linux/spi/spidev.h>
+#include <time.h>
 
 #define ARRAY_SIZE(a) (sizeof(a) / sizeof((a)[0]))
 
@@ -116,3 +117,179 @@ verbose = 0;
 */
 }
 
+/*
+ * CRC-32 (IEEE 802.3, reflected, table driven)
+ */
+uint32_t crc32(uint32_t crc, const void *data, size_t len)
+{
+	static uint32_t table[256];
+	const uint8_t *p = data;
+	uint32_t c;
+	int i, j;
+
+	if (table[1] == 0) {
+		for (i = 0; i < 256; i++) {
+			c = i;
+			for (j = 0; j < 8; j++)
+				c = (c & 1) ? (c >> 1) ^ 0xEDB88320 : c >> 1;
+			table[i] = c;
+		}
+	}
+
+	crc = ~crc;
+	while (len--)
+		crc = table[(crc ^ *p++) & 0xFF] ^ (crc >> 8);
+
+	return ~crc;
+}
+
+void frame_seal(frame *f, size_t size)
+{
+	f->crc = crc32(0, &f->fh, sizeof(f->fh));
+	f->crc = crc32(f->crc, f->payload, size);
+}
+
+int frame_check(const frame *f, size_t size)
+{
+	uint32_t crc;
+
+	if (f->fh.S.sync_code != FRAME_SYNC_CODE)
+		return FRAME_STATUS_BAD_SYNC;
+
+	crc = crc32(0, &f->fh, sizeof(f->fh));
+	crc = crc32(crc, f->payload, size);
+	if (crc != f->crc)
+		return FRAME_STATUS_BAD_CRC;
+
+	return FRAME_STATUS_OK;
+}
+
+/*
+ * Slave side: build the reply to a received frame (status + echoed payload)
+ */
+void frame_reply(const frame *in, size_t size, frame *reply)
+{
+	reply->fh.S.sync_code = FRAME_SYNC_CODE;
+	reply->fh.status = frame_check(in, size);
+	if (reply->fh.status == FRAME_STATUS_OK) {
+		reply->fh.H = in->fh.H;
+		reply->fh.seq = in->fh.seq;
+		memcpy(reply->payload, in->payload, size);
+	} else {
+		reply->fh.H.opcode = FRAME_OPCODE_IDLE;
+		reply->fh.H.length = 0;
+		reply->fh.seq = 0;
+		memset(reply->payload, 0, size);
+	}
+}
+
+/*
+ * In-process stand-in for a slave running s1 -f: replies to the previous
+ * frame while the current one is being received
+ */
+static void standin_transfer(const frame *tx, frame *rx, size_t size)
+{
+	static frame reply;
+
+	if (reply.fh.S.sync_code != FRAME_SYNC_CODE) {
+		reply.fh.S.sync_code = FRAME_SYNC_CODE;
+		reply.fh.H.opcode = FRAME_OPCODE_IDLE;
+		reply.fh.status = FRAME_STATUS_NONE;
+	}
+	reply.fh.credits = 2;
+	frame_seal(&reply, size);
+
+	rx->fh = reply.fh;
+	rx->crc = reply.crc;
+	memcpy(rx->payload, reply.payload, size);
+
+	frame_reply(tx, size, &reply);
+}
+
+/*
+ * Send header, payload and CRC as one SPI_IOC_MESSAGE (single CS frame,
+ * single system call). The payload is not copied.
+ */
+int transfer_frame(int fd, frame *tx, frame *rx, size_t size)
+{
+	struct spi_ioc_transfer tr[3];
+	int i;
+
+	if (fd == FRAME_STANDIN_FD) {
+		standin_transfer(tx, rx, size);
+		return 0;
+	}
+
+	memset(tr, 0, sizeof(tr));
+	tr[0].tx_buf = (unsigned long)&tx->fh;
+	tr[0].rx_buf = (unsigned long)&rx->fh;
+	tr[0].len = sizeof(tx->fh);
+	tr[1].tx_buf = (unsigned long)tx->payload;
+	tr[1].rx_buf = (unsigned long)rx->payload;
+	tr[1].len = size;
+	tr[2].tx_buf = (unsigned long)&tx->crc;
+	tr[2].rx_buf = (unsigned long)&rx->crc;
+	tr[2].len = sizeof(tx->crc);
+
+	for (i = 0; i < 3; i++) {
+		tr[i].speed_hz = speed;
+		tr[i].bits_per_word = bits;
+	}
+
+	/* a zero length payload is simply skipped */
+	if (size == 0) {
+		tr[1] = tr[2];
+		return ioctl(fd, SPI_IOC_MESSAGE(2), tr) < 1 ? -1 : 0;
+	}
+
+	return ioctl(fd, SPI_IOC_MESSAGE(3), tr) < 1 ? -1 : 0;
+}
+
+uint64_t now_us(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+/*
+ * Optional ready line (sysfs GPIO value file, e.g.
+ * /sys/class/gpio/gpio42/value). The slave drives it high once its next
+ * transfer is about to be queued, the master waits for it before clocking.
+ */
+int ready_open(const char *path, int is_slave)
+{
+	int fd;
+
+	if (path == NULL)
+		return -1;
+
+	fd = open(path, is_slave ? O_WRONLY : O_RDONLY);
+	if (fd < 0)
+		pabort("can't open ready line");
+
+	return fd;
+}
+
+void ready_set(int fd, int value)
+{
+	if (fd < 0)
+		return;
+
+	if (write(fd, value ? "1" : "0", 1) != 1)
+		pabort("can't drive ready line");
+}
+
+void ready_wait(int fd)
+{
+	char c = '0';
+
+	if (fd < 0)
+		return;
+
+	while (c != '1') {
+		if (pread(fd, &c, 1, 0) != 1)
+			pabort("can't read ready line");
+	}
+}
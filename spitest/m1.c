@@ -30,6 +30,15 @@ static uint16_t delay;
 static int verbose;
 static int isMaster = 0;
 
+/* framed streaming mode */
+static int framed;
+static int bench;
+static int standin;
+static size_t payload_size = 1000;
+static int frames = 1000;
+static const char *ready_path;
+static unsigned int gap_us = 50;
+
 /*
 uint8_t default_tx[] = {
 	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
@@ -44,12 +53,236 @@ uint8_t default_tx[2048];
 
 uint8_t default_rx[ARRAY_SIZE(default_tx)] = {0, };
 
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-DfbLRlsngrv]\n", prog);
+	puts("  -D --device   device to use (default /dev/spidev0.0)\n"
+	     "  -f --framed   framed streaming mode (one SPI message per frame)\n"
+	     "  -b --bench    framed mode, report throughput/latency/error rate\n"
+	     "  -L --loop     hardware loopback (SPI_LOOP, MOSI wired to MISO)\n"
+	     "  -R --spi-ready slave pulls low to pause (SPI_READY)\n"
+	     "  -l --standin  no device, in-process loopback slave\n"
+	     "  -s --size     payload size (default 1000)\n"
+	     "  -n --frames   number of frames (default 1000)\n"
+	     "  -g --gap      usec to wait when the slave reports no credit (default 50)\n"
+	     "  -r --ready    ready line value file (e.g. /sys/class/gpio/gpio42/value)\n"
+	     "  -v --verbose  Verbose (dump last frame)\n");
+	exit(1);
+}
+
+static void parse_opts(int argc, char *argv[])
+{
+	while (1) {
+		static const struct option lopts[] = {
+			{ "device",    1, 0, 'D' },
+			{ "framed",    0, 0, 'f' },
+			{ "bench",     0, 0, 'b' },
+			{ "loop",      0, 0, 'L' },
+			{ "spi-ready", 0, 0, 'R' },
+			{ "standin",   0, 0, 'l' },
+			{ "size",      1, 0, 's' },
+			{ "frames",    1, 0, 'n' },
+			{ "gap",       1, 0, 'g' },
+			{ "ready",     1, 0, 'r' },
+			{ "verbose",   0, 0, 'v' },
+			{ NULL, 0, 0, 0 },
+		};
+		int c;
+
+		c = getopt_long(argc, argv, "D:fbLRls:n:g:r:v", lopts, NULL);
+
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'D':
+			device = optarg;
+			break;
+		case 'f':
+			framed = 1;
+			break;
+		case 'b':
+			framed = 1;
+			bench = 1;
+			break;
+		case 'L':
+			mode |= SPI_LOOP;
+			break;
+		case 'R':
+			mode |= SPI_READY;
+			break;
+		case 'l':
+			framed = 1;
+			standin = 1;
+			break;
+		case 's':
+			payload_size = atoi(optarg);
+			break;
+		case 'n':
+			frames = atoi(optarg);
+			break;
+		case 'g':
+			gap_us = atoi(optarg);
+			break;
+		case 'r':
+			ready_path = optarg;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			print_usage(argv[0]);
+			break;
+		}
+	}
+	if (payload_size > FRAME_MAX_PAYLOAD)
+		payload_size = FRAME_MAX_PAYLOAD;
+}
+
+/*
+ * Framed streaming: sync, header, payload and CRC go out in one
+ * SPI_IOC_MESSAGE per frame, no fixed sleeps. The reply clocked in during
+ * frame N is the slave's answer to frame N-1 (or frame N itself when MOSI is
+ * looped back to MISO).
+ */
+static int run_framed(int fd)
+{
+	static frame tx, rx;
+	int ready_fd = ready_open(ready_path, 0);
+	uint64_t t0, t1, start, elapsed;
+	uint64_t lat, lat_min = UINT64_MAX, lat_max = 0, lat_sum = 0;
+	unsigned int checked = 0, errors = 0, idle = 0, misordered = 0;
+	unsigned int reported = 0;
+	int credits = 1;
+	int expect = 0, last, seq;
+	size_t j;
+	int i, st;
+
+	start = now_us();
+
+	for (i = 0; i < frames; i++) {
+		tx.fh.S.sync_code = FRAME_SYNC_CODE;
+		tx.fh.H.opcode = FRAME_OPCODE_DATA;
+		tx.fh.H.length = payload_size;
+		tx.fh.seq = i;
+		tx.fh.credits = 0;
+		tx.fh.status = FRAME_STATUS_NONE;
+		for (j = 0; j < payload_size; j++)
+			tx.payload[j] = (uint8_t)(i + j);
+		frame_seal(&tx, payload_size);
+
+		/* handshake: ready line if wired, else back off on no credit */
+		if (ready_fd >= 0)
+			ready_wait(ready_fd);
+		else if (credits == 0)
+			usleep(gap_us);
+
+		t0 = now_us();
+		if (transfer_frame(fd, &tx, &rx, payload_size) < 0)
+			pabort("can't send spi message");
+		t1 = now_us();
+
+		lat = t1 - t0;
+		lat_sum += lat;
+		if (lat < lat_min)
+			lat_min = lat;
+		if (lat > lat_max)
+			lat_max = lat;
+
+		/* the first reply carries nothing from a real slave */
+		if (i == 0 && !(mode & SPI_LOOP))
+			continue;
+
+		checked++;
+		st = frame_check(&rx, payload_size);
+		if (st != FRAME_STATUS_OK) {
+			errors++;
+			credits = 0;
+		} else if (rx.fh.status == FRAME_STATUS_BAD_SYNC ||
+			   rx.fh.status == FRAME_STATUS_BAD_CRC) {
+			/* the slave received a corrupted frame */
+			errors++;
+			reported++;
+			credits = rx.fh.credits;
+		} else {
+			if (rx.fh.H.opcode == FRAME_OPCODE_IDLE) {
+				idle++;
+			} else {
+				/* a reply answers an earlier frame than the one in
+				 * flight, unless MOSI is looped back to MISO */
+				last = (mode & SPI_LOOP) ? i : i - 1;
+				seq = i - (uint16_t)(i - rx.fh.seq);
+
+				if (seq < expect || seq > last) {
+					/* duplicated or stale reply */
+					errors++;
+					misordered++;
+				} else {
+					/* frames skipped by the slave, not counting the
+					 * ones it already reported as corrupted */
+					if (seq - expect > (int)reported)
+						errors += seq - expect - reported;
+					reported = 0;
+					expect = seq + 1;
+
+					/* the echoed payload must match what was sent */
+					for (j = 0; j < payload_size; j++) {
+						if (rx.payload[j] != (uint8_t)(seq + j))
+							break;
+					}
+					if (j < payload_size) {
+						errors++;
+						misordered++;
+					}
+				}
+			}
+			credits = (mode & SPI_LOOP) ? 1 : rx.fh.credits;
+		}
+	}
+
+	elapsed = now_us() - start;
+	if (elapsed == 0)
+		elapsed = 1;
+
+	if (verbose)
+		hex_dump(rx.payload, payload_size < 32 ? payload_size : 32, 32, "RX");
+
+	printf("frames: %d x %zu bytes payload, %u checked, %u errors, %u idle replies\n",
+	       frames, payload_size, checked, errors, idle);
+	printf("replies out of sequence or with a wrong payload: %u\n",
+	       misordered);
+
+	if (bench) {
+		double secs = elapsed / 1e6;
+		double wire = (double)frames *
+			(sizeof(frame_hdr) + payload_size + sizeof(uint32_t));
+
+		printf("elapsed: %.3f s, %.1f frames/s\n", secs, frames / secs);
+		printf("throughput: %.3f MB/s payload, %.3f MB/s on the wire\n",
+		       frames * (double)payload_size / secs / 1e6, wire / secs / 1e6);
+		printf("latency: min %llu us, avg %llu us, max %llu us\n",
+		       (unsigned long long)lat_min,
+		       (unsigned long long)(lat_sum / (frames ? frames : 1)),
+		       (unsigned long long)lat_max);
+		printf("frame error rate: %.6f\n",
+		       checked ? (double)errors / checked : 0.0);
+	}
+
+	if (ready_fd >= 0)
+		close(ready_fd);
+
+	return errors ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
 	int ret = 0;
 	int fd;
 
-//	parse_opts(argc, argv);
+	parse_opts(argc, argv);
+
+	if (standin)
+		return run_framed(FRAME_STANDIN_FD);
 
 	fd = open(device, O_RDWR);
 	if (fd < 0)
@@ -92,6 +325,12 @@ int main(int argc, char *argv[])
 	printf("bits per word: %d\n", bits);
 	printf("max speed: %d Hz (%d KHz)\n", speed, speed/1000);
 
+	if (framed) {
+		ret = run_framed(fd);
+		close(fd);
+		return ret;
+	}
+
 
 	//transfer(fd, default_tx, default_rx, sizeof(default_tx), isMaster);
     //=========================================================================
@@ -13,6 +13,7 @@
 #include <sys/stat.h>
 #include <linux/types.h>
 #include <linux/spi/spidev.h>
+#include <pthread.h>
 
 #include "spi1.h"
 
@@ -29,6 +30,12 @@ static uint32_t speed = 10000000;
 static uint16_t delay;
 static int verbose;
 static int isSlave = 1;
+
+/* framed streaming mode */
+static int framed;
+static size_t payload_size = 1000;
+static int frames = 1000;
+static const char *ready_path;
 /*
 uint8_t default_tx[] = {
 	0xFF, 0xFF, 0xFF, 0xFF, 0xFF, 0xFF,
@@ -43,12 +50,184 @@ uint8_t default_tx[2048];
 
 uint8_t default_rx[ARRAY_SIZE(default_tx)] = {0, };
 
+static void print_usage(const char *prog)
+{
+	printf("Usage: %s [-Dfsnrv]\n", prog);
+	puts("  -D --device   device to use (default /dev/spidev1.0)\n"
+	     "  -f --framed   framed streaming mode (double-buffered receive loop)\n"
+	     "  -s --size     payload size (default 1000, must match the master)\n"
+	     "  -n --frames   number of frames, 0 = forever (default 1000)\n"
+	     "  -r --ready    ready line value file (e.g. /sys/class/gpio/gpio42/value)\n"
+	     "  -v --verbose  Verbose (print statistics)\n");
+	exit(1);
+}
+
+static void parse_opts(int argc, char *argv[])
+{
+	while (1) {
+		static const struct option lopts[] = {
+			{ "device",  1, 0, 'D' },
+			{ "framed",  0, 0, 'f' },
+			{ "size",    1, 0, 's' },
+			{ "frames",  1, 0, 'n' },
+			{ "ready",   1, 0, 'r' },
+			{ "verbose", 0, 0, 'v' },
+			{ NULL, 0, 0, 0 },
+		};
+		int c;
+
+		c = getopt_long(argc, argv, "D:fs:n:r:v", lopts, NULL);
+
+		if (c == -1)
+			break;
+
+		switch (c) {
+		case 'D':
+			device = optarg;
+			break;
+		case 'f':
+			framed = 1;
+			break;
+		case 's':
+			payload_size = atoi(optarg);
+			break;
+		case 'n':
+			frames = atoi(optarg);
+			break;
+		case 'r':
+			ready_path = optarg;
+			break;
+		case 'v':
+			verbose = 1;
+			break;
+		default:
+			print_usage(argv[0]);
+			break;
+		}
+	}
+	if (payload_size > FRAME_MAX_PAYLOAD)
+		payload_size = FRAME_MAX_PAYLOAD;
+}
+
+/*
+ * Framed streaming, double buffered: the receive thread keeps a transfer
+ * queued in one buffer while the main thread checks the other one and builds
+ * the reply. The number of free buffers is sent back as credits so the
+ * master only backs off when both buffers are busy.
+ */
+static frame rx_buf[2];
+static int rx_full[2];
+static frame reply;
+static int reply_ready;
+static int rx_done;
+static pthread_mutex_t lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
+
+static void *rx_thread(void *arg)
+{
+	static frame tx;
+	int fd = *(int *)arg;
+	int ready_fd = ready_open(ready_path, 1);
+	int k = 0;
+	int n;
+
+	for (n = 0; frames == 0 || n < frames; n++) {
+		pthread_mutex_lock(&lock);
+		while (rx_full[k])
+			pthread_cond_wait(&cond, &lock);
+
+		if (reply_ready) {
+			tx = reply;
+			reply_ready = 0;
+		} else {
+			/* reply not processed yet, send an idle frame */
+			memset(&tx.fh, 0, sizeof(tx.fh));
+			tx.fh.S.sync_code = FRAME_SYNC_CODE;
+			tx.fh.H.opcode = FRAME_OPCODE_IDLE;
+			tx.fh.status = FRAME_STATUS_NONE;
+		}
+		/* rx_buf[k] is taken by this transfer, only the other one can
+		 * still be free */
+		tx.fh.credits = !rx_full[k ^ 1];
+		pthread_mutex_unlock(&lock);
+
+		frame_seal(&tx, payload_size);
+
+		ready_set(ready_fd, 1);
+		if (transfer_frame(fd, &tx, &rx_buf[k], payload_size) < 0)
+			pabort("can't send spi message");
+		ready_set(ready_fd, 0);
+
+		pthread_mutex_lock(&lock);
+		rx_full[k] = 1;
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&lock);
+
+		k ^= 1;
+	}
+
+	pthread_mutex_lock(&lock);
+	rx_done = 1;
+	pthread_cond_broadcast(&cond);
+	pthread_mutex_unlock(&lock);
+
+	if (ready_fd >= 0)
+		close(ready_fd);
+
+	return NULL;
+}
+
+static int run_framed(int fd)
+{
+	static frame out;
+	pthread_t tid;
+	unsigned int ok = 0, bad = 0;
+	int k = 0;
+
+	if (pthread_create(&tid, NULL, rx_thread, &fd) != 0)
+		pabort("can't create receive thread");
+
+	while (1) {
+		pthread_mutex_lock(&lock);
+		while (!rx_full[k] && !rx_done)
+			pthread_cond_wait(&cond, &lock);
+		if (!rx_full[k]) {
+			pthread_mutex_unlock(&lock);
+			break;
+		}
+		pthread_mutex_unlock(&lock);
+
+		/* check the frame and build the reply outside the lock */
+		frame_reply(&rx_buf[k], payload_size, &out);
+		if (out.fh.status == FRAME_STATUS_OK)
+			ok++;
+		else
+			bad++;
+
+		pthread_mutex_lock(&lock);
+		reply = out;
+		reply_ready = 1;
+		rx_full[k] = 0;
+		pthread_cond_broadcast(&cond);
+		pthread_mutex_unlock(&lock);
+
+		k ^= 1;
+	}
+
+	pthread_join(tid, NULL);
+
+	if (verbose)
+		printf("frames: %u ok, %u bad\n", ok, bad);
+
+	return bad ? 1 : 0;
+}
+
 int main(int argc, char *argv[])
 {
 	int ret = 0;
 	int fd;
 
-	//parse_opts(argc, argv);
+	parse_opts(argc, argv);
 
 	fd = open(device, O_RDWR);
 	if (fd < 0)
@@ -91,6 +270,12 @@ int main(int argc, char *argv[])
 	printf("bits per word: %d\n", bits);
 	printf("max speed: %d Hz (%d KHz)\n", speed, speed/1000);
 
+	if (framed) {
+		ret = run_framed(fd);
+		close(fd);
+		return ret;
+	}
+
 	//transfer(fd, default_tx, default_rx, sizeof(default_tx), isSlave);
     //=========================================================================
     int i;
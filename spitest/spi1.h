@@ -18,11 +18,57 @@ typedef struct {
     uint16_t length;
 } hdr;
 
+/*
+ * Framed streaming mode
+ *
+ * A frame is sent as a single SPI_IOC_MESSAGE: frame_hdr, a fixed size
+ * payload (both ends use the same -s value) and a CRC-32 over both. While the
+ * master clocks frame N out, the slave clocks out its reply to frame N-1
+ * (status + echoed payload) and the number of free receive buffers (credits).
+ */
+#define FRAME_SYNC_CODE        0x11223344
+#define FRAME_OPCODE_IDLE      0x0000
+#define FRAME_OPCODE_DATA      0x0042
+#define FRAME_MAX_PAYLOAD      2048
+
+#define FRAME_STATUS_NONE      0    /* nothing received yet / loopback */
+#define FRAME_STATUS_OK        1
+#define FRAME_STATUS_BAD_SYNC  2
+#define FRAME_STATUS_BAD_CRC   3
+
+typedef struct {
+    sync_word S;
+    hdr H;
+    uint16_t seq;
+    uint8_t credits;
+    uint8_t status;
+} frame_hdr;
+
+typedef struct {
+    frame_hdr fh;
+    uint32_t crc;
+    uint8_t payload[FRAME_MAX_PAYLOAD];
+} frame;
+
+/* Pass as fd to transfer_frame() to use the in-process loopback slave */
+#define FRAME_STANDIN_FD       (-2)
+
 
 
 void pabort(const char *s);
 void hex_dump(const void *src, size_t length, size_t line_size, char *prefix);
 void transfer(int fd, uint8_t const *tx, uint8_t const *rx, size_t len, int is_slave);
 
+uint32_t crc32(uint32_t crc, const void *data, size_t len);
+void frame_seal(frame *f, size_t size);
+int frame_check(const frame *f, size_t size);
+void frame_reply(const frame *in, size_t size, frame *reply);
+int transfer_frame(int fd, frame *tx, frame *rx, size_t size);
+uint64_t now_us(void);
+
+int ready_open(const char *path, int is_slave);
+void ready_set(int fd, int value);
+void ready_wait(int fd);
+
 
 #endif // SPI1_H